@@ -36,6 +36,9 @@ std::ostream &operator<<(std::ostream &os, MetaServerOpType optype) {
     case MetaServerOpType::ListDentry:
         os << "ListDentry";
         break;
+    case MetaServerOpType::ListDentryPlus:
+        os << "ListDentryPlus";
+        break;
     case MetaServerOpType::CreateDentry:
         os << "CreateDentry";
         break;
@@ -72,6 +75,15 @@ std::ostream &operator<<(std::ostream &os, MetaServerOpType optype) {
     case MetaServerOpType::UpdateVolumeExtent:
         os << "UpdateVolumeExtent";
         break;
+    case MetaServerOpType::CreateNode:
+        os << "CreateNode";
+        break;
+    case MetaServerOpType::AllocInodeId:
+        os << "AllocInodeId";
+        break;
+    case MetaServerOpType::BatchUpdateInode:
+        os << "BatchUpdateInode";
+        break;
     default:
         os << "Unknow opType";
     }
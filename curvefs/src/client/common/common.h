@@ -47,6 +47,7 @@ enum DiskCacheType {
 enum class MetaServerOpType {
     GetDentry,
     ListDentry,
+    ListDentryPlus,
     CreateDentry,
     DeleteDentry,
     PrepareRenameTx,
@@ -61,6 +62,9 @@ enum class MetaServerOpType {
     UpdateVolumeExtent,
     CreateManageInode,
     UpdateDeallocatableBlockGroup,
+    CreateNode,
+    AllocInodeId,
+    BatchUpdateInode,
 };
 
 std::ostream &operator<<(std::ostream &os, MetaServerOpType optype);
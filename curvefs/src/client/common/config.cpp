@@ -24,6 +24,7 @@
 
 #include <gflags/gflags.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -205,6 +206,18 @@ void InitDiskCacheOption(Configuration *conf,
                               &diskCacheOption->avgReadFileBytes);
     conf->GetValueFatalIfFail("diskCache.avgReadFileIops",
                               &diskCacheOption->avgReadFileIops);
+    conf->GetValueFatalIfFail("diskCache.uploadMinConcurrency",
+                              &diskCacheOption->uploadMinConcurrency);
+    conf->GetValueFatalIfFail("diskCache.uploadMaxConcurrency",
+                              &diskCacheOption->uploadMaxConcurrency);
+    conf->GetValueFatalIfFail("diskCache.uploadLatencyTolerancePercent",
+                              &diskCacheOption->uploadLatencyTolerancePercent);
+    conf->GetValueFatalIfFail("diskCache.uploadMaxRetryIntervalMs",
+                              &diskCacheOption->uploadMaxRetryIntervalMs);
+    conf->GetValueFatalIfFail("diskCache.uploadStopTimeoutMs",
+                              &diskCacheOption->uploadStopTimeoutMs);
+    conf->GetValueFatalIfFail("diskCache.avgUploadBytes",
+                              &diskCacheOption->avgUploadBytes);
 }
 
 void InitS3Option(Configuration *conf, S3Option *s3Opt) {
@@ -264,6 +277,14 @@ void InitVolumeOption(Configuration *conf, VolumeOption *volumeOpt) {
             "volume.bitmapAllocator.smallAllocProportion",
             &volumeOpt->allocatorOption.bitmapAllocatorOption
                  .smallAllocProportion);
+        LOG_IF(WARNING,
+               !conf->GetUInt32Value(
+                   "volume.bitmapAllocator.allocGroups",
+                   &volumeOpt->allocatorOption.bitmapAllocatorOption
+                        .allocGroups))
+            << "Not found `volume.bitmapAllocator.allocGroups` in conf, "
+               "default to "
+            << volumeOpt->allocatorOption.bitmapAllocatorOption.allocGroups;
     } else {
         CHECK(false) << "only support bitmap allocator";
     }
@@ -273,6 +294,10 @@ void InitExtentManagerOption(Configuration *conf,
                              ExtentManagerOption *extentManagerOpt) {
     conf->GetValueFatalIfFail("extentManager.preAllocSize",
                               &extentManagerOpt->preAllocSize);
+    LOG_IF(WARNING, !conf->GetUInt64Value("extentManager.maxPreAllocSize",
+                                           &extentManagerOpt->maxPreAllocSize))
+        << "Not found `extentManager.maxPreAllocSize` in conf, default to "
+        << extentManagerOpt->maxPreAllocSize;
 }
 
 void InitLeaseOpt(Configuration *conf, LeaseOpt *leaseOpt) {
@@ -289,6 +314,38 @@ void InitRefreshDataOpt(Configuration *conf,
                               &opt->refreshDataIntervalSec);
 }
 
+void InitCachePeerOption(Configuration *conf, CachePeerOption *opt) {
+    LOG_IF(WARNING, !conf->GetBoolValue("fuseClient.cachePeer.enable",
+                                        &opt->enable))
+        << "Not found `fuseClient.cachePeer.enable` in conf, "
+        << "use default value `" << std::boolalpha << opt->enable << '`';
+    if (!opt->enable) {
+        return;
+    }
+
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.port", &opt->port);
+    LOG_IF(INFO, !conf->GetStringValue("fuseClient.cachePeer.peers",
+                                       &opt->peers))
+        << "Not found `fuseClient.cachePeer.peers` in conf, "
+        << "use mountpoints of filesystem as peers";
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.refreshIntervalSec",
+                              &opt->refreshIntervalSec);
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.rpcTimeoutMs",
+                              &opt->rpcTimeoutMs);
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.virtualNodes",
+                              &opt->virtualNodes);
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.peerFailureLimit",
+                              &opt->peerFailureLimit);
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.peerRetryIntervalMs",
+                              &opt->peerRetryIntervalMs);
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.memoryCacheCapacity",
+                              &opt->memoryCacheCapacity);
+    conf->GetValueFatalIfFail("fuseClient.cachePeer.authKey", &opt->authKey);
+    LOG_IF(FATAL, opt->authKey.empty())
+        << "`fuseClient.cachePeer.authKey` must be set to enable cache peer";
+    opt->refreshIntervalSec = std::max<uint32_t>(opt->refreshIntervalSec, 1);
+}
+
 void InitKVClientManagerOpt(Configuration *conf,
                                KVClientManagerOpt *config) {
     conf->GetValueFatalIfFail("fuseClient.supportKVcache",
@@ -297,6 +354,32 @@ void InitKVClientManagerOpt(Configuration *conf,
                               &config->setThreadPooln);
     conf->GetValueFatalIfFail("fuseClient.getThreadPool",
                               &config->getThreadPooln);
+    LOG_IF(WARNING,
+           !conf->GetUInt64Value("fuseClient.kvcache.nearCacheCapacityBytes",
+                                 &config->nearCacheCapacityBytes))
+        << "Not found `fuseClient.kvcache.nearCacheCapacityBytes` in conf, "
+        << "use default value `" << config->nearCacheCapacityBytes << '`';
+
+    auto *memcacheOpt = &config->memcacheClientOpt;
+    LOG_IF(WARNING, !conf->GetUInt32Value("fuseClient.kvcache.virtualNodes",
+                                          &memcacheOpt->virtualNodes))
+        << "Not found `fuseClient.kvcache.virtualNodes` in conf, "
+        << "use default value `" << memcacheOpt->virtualNodes << '`';
+    LOG_IF(WARNING,
+           !conf->GetUInt32Value("fuseClient.kvcache.serverFailureLimit",
+                                 &memcacheOpt->serverFailureLimit))
+        << "Not found `fuseClient.kvcache.serverFailureLimit` in conf, "
+        << "use default value `" << memcacheOpt->serverFailureLimit << '`';
+    LOG_IF(WARNING,
+           !conf->GetUInt32Value("fuseClient.kvcache.serverRetryIntervalMs",
+                                 &memcacheOpt->serverRetryIntervalMs))
+        << "Not found `fuseClient.kvcache.serverRetryIntervalMs` in conf, "
+        << "use default value `" << memcacheOpt->serverRetryIntervalMs
+        << '`';
+    memcacheOpt->virtualNodes =
+        std::max<uint32_t>(memcacheOpt->virtualNodes, 1);
+    memcacheOpt->serverFailureLimit =
+        std::max<uint32_t>(memcacheOpt->serverFailureLimit, 1);
 }
 
 void InitFileSystemOption(Configuration* c, FileSystemOption* option) {
@@ -340,11 +423,65 @@ void InitFileSystemOption(Configuration* c, FileSystemOption* option) {
     {  // rpc option
         auto o = &option->rpcOption;
         c->GetValueFatalIfFail("fs.rpc.listDentryLimit", &o->listDentryLimit);
+        LOG_IF(WARNING, !c->GetBoolValue("fs.rpc.compoundCreate",
+                                         &o->compoundCreate))
+            << "Not found `fs.rpc.compoundCreate` in conf, use default value `"
+            << std::boolalpha << o->compoundCreate << '`';
+        LOG_IF(WARNING, !c->GetBoolValue("fs.rpc.listDentryPlus",
+                                         &o->listDentryPlus))
+            << "Not found `fs.rpc.listDentryPlus` in conf, use default value `"
+            << std::boolalpha << o->listDentryPlus << '`';
+        LOG_IF(WARNING, !c->GetBoolValue("fs.rpc.listDentryPlusStreaming",
+                                         &o->listDentryPlusStreaming))
+            << "Not found `fs.rpc.listDentryPlusStreaming` in conf, "
+            << "use default value `" << std::boolalpha
+            << o->listDentryPlusStreaming << '`';
     }
     {  // defer sync option
         auto o = &option->deferSyncOption;
         c->GetValueFatalIfFail("fs.deferSync.delay", &o->delay);
         c->GetValueFatalIfFail("fs.deferSync.deferDirMtime", &o->deferDirMtime);
+        LOG_IF(WARNING, !c->GetUInt32Value("fs.deferSync.batchSize",
+                                           &o->batchSize))
+            << "Not found `fs.deferSync.batchSize` in conf, "
+            << "use default value `" << o->batchSize << '`';
+        LOG_IF(WARNING, !c->GetUInt32Value("fs.deferSync.maxPending",
+                                           &o->maxPending))
+            << "Not found `fs.deferSync.maxPending` in conf, "
+            << "use default value `" << o->maxPending << '`';
+    }
+    {  // local create option
+        auto o = &option->localCreateOption;
+        LOG_IF(WARNING, !c->GetBoolValue("fs.localCreate.enable", &o->enable))
+            << "Not found `fs.localCreate.enable` in conf, use default value `"
+            << std::boolalpha << o->enable << '`';
+        LOG_IF(WARNING, !c->GetUInt32Value("fs.localCreate.idLeaseSize",
+                                           &o->idLeaseSize))
+            << "Not found `fs.localCreate.idLeaseSize` in conf, "
+            << "use default value `" << o->idLeaseSize << '`';
+        LOG_IF(WARNING, !c->GetUInt32Value("fs.localCreate.maxPending",
+                                           &o->maxPending))
+            << "Not found `fs.localCreate.maxPending` in conf, "
+            << "use default value `" << o->maxPending << '`';
+        if (o->enable && !option->rpcOption.compoundCreate) {
+            LOG(WARNING) << "`fs.localCreate.enable` requires "
+                         << "`fs.rpc.compoundCreate`, disable it";
+            o->enable = false;
+        }
+    }
+    {  // dir lease option
+        auto o = &option->dirLeaseOption;
+        LOG_IF(WARNING, !c->GetBoolValue("fs.dirLease.enable", &o->enable))
+            << "Not found `fs.dirLease.enable` in conf, use default value `"
+            << std::boolalpha << o->enable << '`';
+        LOG_IF(WARNING, !c->GetUInt32Value("fs.dirLease.listenStartPort",
+                                           &o->listenStartPort))
+            << "Not found `fs.dirLease.listenStartPort` in conf, "
+            << "use default value `" << o->listenStartPort << '`';
+        LOG_IF(WARNING, !c->GetUInt64Value("fs.dirLease.lruSize",
+                                           &o->lruSize))
+            << "Not found `fs.dirLease.lruSize` in conf, "
+            << "use default value `" << o->lruSize << '`';
     }
 }
 
@@ -369,6 +506,7 @@ void InitFuseClientOption(Configuration *conf, FuseClientOption *clientOption) {
     InitRefreshDataOpt(conf, &clientOption->refreshDataOption);
     InitKVClientManagerOpt(conf, &clientOption->kvClientManagerOpt);
     InitFileSystemOption(conf, &clientOption->fileSystemOption);
+    InitCachePeerOption(conf, &clientOption->cachePeerOption);
 
     conf->GetValueFatalIfFail("fuseClient.listDentryLimit",
                               &clientOption->listDentryLimit);
@@ -73,9 +73,22 @@ struct LeaseOpt {
     uint32_t leaseTimeUs = 20000000;
 };
 
+struct MemcacheClientOpt {
+    // points of each server on the consistent hash ring
+    uint32_t virtualNodes = 100;
+    // a server is ejected from the ring after continuous failures
+    uint32_t serverFailureLimit = 3;
+    // an ejected server is tried again after this interval
+    uint32_t serverRetryIntervalMs = 5000;
+};
+
 struct KVClientManagerOpt {
     int setThreadPooln = 4;
     int getThreadPooln = 4;
+    // bytes of blocks cached in memory in front of the remote cache,
+    // 0 means disabled
+    uint64_t nearCacheCapacityBytes = 0;
+    MemcacheClientOpt memcacheClientOpt;
 };
 
 struct DiskCacheOption {
@@ -114,6 +127,19 @@ struct DiskCacheOption {
     uint64_t avgFlushIops;
     // the read throttle iops of disk cache
     uint64_t avgReadFileIops;
+    // the min concurrent uploads of write cache
+    uint32_t uploadMinConcurrency = 4;
+    // the max concurrent uploads of write cache
+    uint32_t uploadMaxConcurrency = 128;
+    // shrink upload concurrency if latency exceeds min latency by this percent
+    uint32_t uploadLatencyTolerancePercent = 200;
+    // the max interval between retries of a failed upload
+    uint64_t uploadMaxRetryIntervalMs = 10000;
+    // give up the failed uploads if they are not done in so long when
+    // stopping, their files are uploaded at next mount
+    uint64_t uploadStopTimeoutMs = 60000;
+    // the upload throttle bps of write cache
+    uint64_t avgUploadBytes = 0;
 };
 
 struct S3ClientAdaptorOption {
@@ -148,6 +174,7 @@ struct BlockGroupOption {
 struct BitmapAllocatorOption {
     uint64_t sizePerBit;
     double smallAllocProportion;
+    uint32_t allocGroups = 1;
 };
 
 struct VolumeAllocatorOption {
@@ -168,6 +195,7 @@ struct VolumeOption {
 
 struct ExtentManagerOption {
     uint64_t preAllocSize;
+    uint64_t maxPreAllocSize = 0;
 };
 
 struct RefreshDataOption {
@@ -175,6 +203,25 @@ struct RefreshDataOption {
     uint32_t refreshDataIntervalSec = 30;
 };
 
+struct CachePeerOption {
+    // fetch s3 objects from other clients before going to s3
+    bool enable = false;
+    // port of the cache peer service, the same on all clients
+    uint32_t port = 9300;
+    // comma separated "host:port" of peers (e.g. clients on the same
+    // rack), empty means all mountpoints of the filesystem in mds
+    std::string peers;
+    uint32_t refreshIntervalSec = 30;
+    uint32_t rpcTimeoutMs = 1000;
+    uint32_t virtualNodes = 100;
+    uint32_t peerFailureLimit = 3;
+    uint32_t peerRetryIntervalMs = 10000;
+    // number of objects kept in memory to serve peers
+    uint32_t memoryCacheCapacity = 64;
+    // key shared by the clients of the filesystem to authenticate peers
+    std::string authKey;
+};
+
 // { filesystem option
 struct KernelCacheOption {
     uint32_t entryTimeoutSec;
@@ -205,11 +252,43 @@ struct OpenFilesOption {
 
 struct RPCOption {
     uint32_t listDentryLimit;
+    // create inode, dentry and update parent in one request
+    bool compoundCreate = false;
+    // list dentries with attributes of inodes in the same partition
+    bool listDentryPlus = false;
+    // receive all dentries of a directory by stream in one request
+    bool listDentryPlusStreaming = false;
 };
 
 struct DeferSyncOption {
     uint32_t delay;
     bool deferDirMtime;
+    // max number of inodes updated in one metaserver request,
+    // 0 updates each inode by itself, old metaservers reject the batches
+    uint32_t batchSize = 0;
+    // flush before |delay| if so many inodes are waiting
+    uint32_t maxPending = 4096;
+};
+
+struct LocalCreateOption {
+    // create regular files with inode ids leased from metaserver, and
+    // persist them until they are synced or their directory is accessed
+    bool enable = false;
+    // number of inode ids leased from a partition at a time, also used
+    // by compound create
+    uint32_t idLeaseSize = 1024;
+    // locally created files are persisted if too many are pending
+    uint32_t maxPending = 4096;
+};
+
+struct DirLeaseOption {
+    // cache lookup results of directories leased from metaserver until
+    // the lease expires or metaserver notifies changes of the directory
+    bool enable = false;
+    // the server receiving notifications listens on the first free port
+    uint32_t listenStartPort = 9200;
+    // max number of cached entries
+    uint64_t lruSize = 1000000;
 };
 
 struct FileSystemOption {
@@ -224,6 +303,8 @@ struct FileSystemOption {
     AttrWatcherOption attrWatcherOption;
     RPCOption rpcOption;
     DeferSyncOption deferSyncOption;
+    LocalCreateOption localCreateOption;
+    DirLeaseOption dirLeaseOption;
 };
 // }
 
@@ -240,6 +321,7 @@ struct FuseClientOption {
     RefreshDataOption refreshDataOption;
     KVClientManagerOpt kvClientManagerOpt;
     FileSystemOption fileSystemOption;
+    CachePeerOption cachePeerOption;
 
     uint32_t listDentryLimit;
     uint32_t listDentryThreads;
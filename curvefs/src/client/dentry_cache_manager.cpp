@@ -63,6 +63,24 @@ CURVEFS_ERROR DentryCacheManagerImpl::GetDentry(uint64_t parent,
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR DentryCacheManagerImpl::GetDentryWithLease(
+    uint64_t parent, const std::string &name, const std::string &holder,
+    Dentry *out, uint32_t *leaseMs) {
+    std::string key = GetDentryCacheKey(parent, name);
+    NameLockGuard lock(nameLock_, key);
+
+    MetaStatusCode ret = metaClient_->GetDentryWithLease(fsId_, parent, name,
+                                                         holder, out, leaseMs);
+    if (ret != MetaStatusCode::OK) {
+        LOG_IF(ERROR, ret != MetaStatusCode::NOT_FOUND)
+            << "metaClient_ GetDentryWithLease failed, MetaStatusCode = "
+            << ret << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
+            << ", parent = " << parent << ", name = " << name;
+        return ToFSError(ret);
+    }
+    return CURVEFS_ERROR::OK;
+}
+
 CURVEFS_ERROR DentryCacheManagerImpl::CreateDentry(const Dentry &dentry) {
     std::string key = GetDentryCacheKey(dentry.parentinodeid(), dentry.name());
     NameLockGuard lock(nameLock_, key);
@@ -156,5 +174,41 @@ CURVEFS_ERROR DentryCacheManagerImpl::ListDentry(uint64_t parent,
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR DentryCacheManagerImpl::ListDentryPlus(
+    uint64_t parent, std::list<DentryPlus> *entries, uint32_t limit,
+    bool streaming) {
+    entries->clear();
+    std::string last = "";
+    while (true) {
+        std::list<DentryPlus> part;
+        MetaStatusCode ret = metaClient_->ListDentryPlus(
+            fsId_, parent, last, limit, streaming, &part);
+        VLOG(6) << "ListDentryPlus fsId = " << fsId_ << ", parent = " << parent
+                << ", last = " << last << ", count = " << limit
+                << ", streaming = " << streaming << ", ret = " << ret
+                << ", part.size() = " << part.size();
+        if (ret != MetaStatusCode::OK) {
+            LOG(ERROR) << "metaClient_ ListDentryPlus failed"
+                       << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
+                       << ", parent = " << parent << ", last = " << last
+                       << ", count = " << limit
+                       << ", streaming = " << streaming;
+            return ToFSError(ret);
+        }
+
+        // in streaming mode all the entries are returned at once
+        bool done = streaming || limit == 0 || part.size() < limit;
+        if (!part.empty()) {
+            last = part.back().dentry().name();
+            entries->splice(entries->end(), part);
+        }
+        if (done) {
+            break;
+        }
+    }
+
+    return CURVEFS_ERROR::OK;
+}
+
 }  // namespace client
 }  // namespace curvefs
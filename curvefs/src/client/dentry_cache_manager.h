@@ -38,6 +38,7 @@
 #include "curvefs/src/client/filesystem/error.h"
 
 using ::curvefs::metaserver::Dentry;
+using ::curvefs::metaserver::DentryPlus;
 
 namespace curvefs {
 namespace client {
@@ -60,6 +61,11 @@ class DentryCacheManager {
     virtual CURVEFS_ERROR GetDentry(uint64_t parent,
         const std::string &name, Dentry *out) = 0;
 
+    // get dentry and lease directory |parent| to |holder|
+    virtual CURVEFS_ERROR GetDentryWithLease(uint64_t parent,
+        const std::string &name, const std::string &holder,
+        Dentry *out, uint32_t *leaseMs) = 0;
+
     virtual CURVEFS_ERROR CreateDentry(const Dentry &dentry) = 0;
 
     virtual CURVEFS_ERROR DeleteDentry(uint64_t parent,
@@ -70,6 +76,11 @@ class DentryCacheManager {
         std::list<Dentry> *dentryList, uint32_t limit,
         bool onlyDir = false, uint32_t nlink = 0) = 0;
 
+    // list dentries with attributes of inodes in the same partition
+    virtual CURVEFS_ERROR ListDentryPlus(uint64_t parent,
+        std::list<DentryPlus> *entries, uint32_t limit,
+        bool streaming = false) = 0;
+
  protected:
     uint32_t fsId_;
 };
@@ -86,6 +97,10 @@ class DentryCacheManagerImpl : public DentryCacheManager {
     CURVEFS_ERROR GetDentry(uint64_t parent,
         const std::string &name, Dentry *out) override;
 
+    CURVEFS_ERROR GetDentryWithLease(uint64_t parent,
+        const std::string &name, const std::string &holder,
+        Dentry *out, uint32_t *leaseMs) override;
+
     CURVEFS_ERROR CreateDentry(const Dentry &dentry) override;
 
     CURVEFS_ERROR DeleteDentry(uint64_t parent,
@@ -96,6 +111,10 @@ class DentryCacheManagerImpl : public DentryCacheManager {
         std::list<Dentry> *dentryList, uint32_t limit,
         bool dirOnly = false, uint32_t nlink = 0) override;
 
+    CURVEFS_ERROR ListDentryPlus(uint64_t parent,
+        std::list<DentryPlus> *entries, uint32_t limit,
+        bool streaming = false) override;
+
     std::string GetDentryCacheKey(uint64_t parent, const std::string &name) {
         return std::to_string(parent) + kDentryKeyDelimiter + name;
     }
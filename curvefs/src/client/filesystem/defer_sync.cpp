@@ -20,8 +20,10 @@
  * Author: Jingli Chen (Wine93)
  */
 
-#include <vector>
+#include <chrono>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "curvefs/src/client/filesystem/defer_sync.h"
 #include "curvefs/src/client/filesystem/utils.h"
@@ -30,12 +32,13 @@ namespace curvefs {
 namespace client {
 namespace filesystem {
 
+using ::curvefs::client::rpcclient::InodeUpdate;
+
 DeferSync::DeferSync(DeferSyncOption option)
     : option_(option),
       mutex_(),
       running_(false),
       thread_(),
-      sleeper_(),
       inodes_() {
 }
 
@@ -49,24 +52,46 @@ void DeferSync::Start() {
 void DeferSync::Stop() {
     if (running_.exchange(false)) {
         LOG(INFO) << "Stop defer sync thread...";
-        sleeper_.interrupt();
+        {
+            LockGuard lk(mutex_);
+            cond_.notify_one();
+        }
         thread_.join();
         LOG(INFO) << "Defer sync thread stopped";
     }
 }
 
+void DeferSync::SetMetaClient(std::shared_ptr<MetaServerClient> metaClient) {
+    metaClient_ = std::move(metaClient);
+}
+
 void DeferSync::SyncTask() {
     std::vector<std::shared_ptr<InodeWrapper>> inodes;
     for ( ;; ) {
-        bool running = sleeper_.wait_for(std::chrono::seconds(option_.delay));
-
+        bool running;
         {
-            LockGuard lk(mutex_);
-            inodes.swap(inodes_);
+            // dirty inodes are flushed in |delay| seconds, or earlier if
+            // too many inodes are waiting
+            std::unique_lock<Mutex> lk(mutex_);
+            cond_.wait_for(lk, std::chrono::seconds(option_.delay), [&]() {
+                return !running_.load() ||
+                       inodes_.size() >= option_.maxPending;
+            });
+            running = running_.load();
+            for (auto& item : inodes_) {
+                inodes.emplace_back(std::move(item.second));
+            }
+            inodes_.clear();
         }
+        metric_.queueDepth << -static_cast<int64_t>(inodes.size());
+
+        Flush(inodes);
+        // persisting the files created locally failed for transient
+        // errors, retry them next time
         for (const auto& inode : inodes) {
-            UniqueLock lk(inode->GetUniqueLock());
-            inode->Async(nullptr, true);
+            if (inode->IsCreatePending()) {
+                Push(inode);
+            }
         }
         inodes.clear();
 
@@ -76,9 +101,42 @@ void DeferSync::SyncTask() {
     }
 }
 
+void DeferSync::Flush(
+    const std::vector<std::shared_ptr<InodeWrapper>>& inodes) {
+    if (metaClient_ == nullptr || option_.batchSize == 0) {
+        for (const auto& inode : inodes) {
+            UniqueLock lk(inode->GetUniqueLock());
+            inode->Async(nullptr, true);
+        }
+        return;
+    }
+
+    std::vector<InodeUpdate> updates;
+    for (const auto& inode : inodes) {
+        UniqueLock lk(inode->GetUniqueLock());
+        inode->AsyncInBatch(&updates, true);
+    }
+    if (updates.empty()) {
+        return;
+    }
+
+    metric_.batchedInodes << updates.size();
+    uint32_t fsId = inodes.front()->GetFsId();
+    metaClient_->BatchUpdateInodeWithOutNlinkAsync(
+        fsId, std::move(updates), option_.batchSize);
+}
+
 void DeferSync::Push(const std::shared_ptr<InodeWrapper>& inode) {
     LockGuard lk(mutex_);
-    inodes_.emplace_back(inode);
+    if (!inodes_.emplace(inode->GetInodeId(), inode).second) {
+        metric_.coalescedInodes << 1;
+        return;
+    }
+
+    metric_.queueDepth << 1;
+    if (inodes_.size() >= option_.maxPending) {
+        cond_.notify_one();
+    }
 }
 
 }  // namespace filesystem
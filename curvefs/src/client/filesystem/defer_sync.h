@@ -24,23 +24,31 @@
 #define CURVEFS_SRC_CLIENT_FILESYSTEM_DEFER_SYNC_H_
 
 #include <atomic>
-#include <vector>
+#include <condition_variable>
 #include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-#include "src/common/interruptible_sleeper.h"
 #include "curvefs/src/client/common/config.h"
 #include "curvefs/src/client/filesystem/meta.h"
+#include "curvefs/src/client/metric/client_metric.h"
+#include "curvefs/src/client/rpcclient/metaserver_client.h"
 
 namespace curvefs {
 namespace client {
 namespace filesystem {
 
 using ::curvefs::client::common::DeferSyncOption;
+using ::curvefs::client::metric::DeferSyncMetric;
+using ::curvefs::client::rpcclient::MetaServerClient;
 
 using ::curve::common::Mutex;
 using ::curve::common::LockGuard;
-using ::curve::common::InterruptibleSleeper;
 
+// Flush dirty inodes in background. An inode pushed many times before
+// it's flushed is flushed only once, and the updates of inodes are sent
+// in batches if the meta client is set.
 class DeferSync {
  public:
     explicit DeferSync(DeferSyncOption option);
@@ -49,18 +57,26 @@ class DeferSync {
 
     void Stop();
 
+    // send updates of inodes in batches with |metaClient|
+    void SetMetaClient(std::shared_ptr<MetaServerClient> metaClient);
+
     void Push(const std::shared_ptr<InodeWrapper>& inode);
 
  private:
     void SyncTask();
 
+    void Flush(const std::vector<std::shared_ptr<InodeWrapper>>& inodes);
+
  private:
     DeferSyncOption option_;
     Mutex mutex_;
+    std::condition_variable cond_;
     std::atomic<bool> running_;
     std::thread thread_;
-    InterruptibleSleeper sleeper_;
-    std::vector<std::shared_ptr<InodeWrapper>> inodes_;
+    // inodes waiting to be flushed
+    std::unordered_map<Ino, std::shared_ptr<InodeWrapper>> inodes_;
+    std::shared_ptr<MetaServerClient> metaClient_;
+    DeferSyncMetric metric_;
 };
 
 }  // namespace filesystem
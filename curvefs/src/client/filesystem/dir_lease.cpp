@@ -0,0 +1,132 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-05-04
+ */
+
+#include "curvefs/src/client/filesystem/dir_lease.h"
+
+#include <brpc/closure_guard.h>
+#include <glog/logging.h>
+
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "src/common/timeutility.h"
+
+namespace curvefs {
+namespace client {
+namespace filesystem {
+
+using ::curve::common::TimeUtility;
+
+DirLeases::DirLeases(DirLeaseOption option)
+    : option_(option), epoch_(0), nextLeaseId_(1), minLeaseId_(1) {
+    dirs_ = std::make_shared<LRUCache<Ino, uint64_t>>(option.lruSize);
+    entries_ = std::make_shared<LRUCache<std::string, CacheEntry>>(
+        option.lruSize);
+    if (option_.enable) {
+        LOG(INFO) << "Using directory lease cache"
+                  << ", capacity = " << option.lruSize;
+    }
+}
+
+std::string DirLeases::CacheKey(Ino parent, const std::string& name) {
+    return absl::StrFormat("%d:%s", parent, name);
+}
+
+uint64_t DirLeases::Epoch() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return epoch_;
+}
+
+bool DirLeases::Get(Ino parent, const std::string& name, Ino* ino) {
+    if (!option_.enable) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    uint64_t leaseId = 0;
+    CacheEntry entry;
+    if (!dirs_->Get(parent, &leaseId) || leaseId < minLeaseId_ ||
+        !entries_->Get(CacheKey(parent, name), &entry) ||
+        entry.leaseId != leaseId ||
+        entry.expireMs <= TimeUtility::GetTimeofDayMs()) {
+        return false;
+    }
+    *ino = entry.ino;
+    return true;
+}
+
+void DirLeases::Put(Ino parent, const std::string& name, Ino ino,
+                    uint32_t leaseMs, uint64_t startMs, uint64_t epoch) {
+    if (!option_.enable || leaseMs == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (epoch != epoch_) {
+        VLOG(6) << "Directory changed while looking up, parent = " << parent
+                << ", name = " << name;
+        return;
+    }
+
+    uint64_t leaseId = 0;
+    if (!dirs_->Get(parent, &leaseId) || leaseId < minLeaseId_) {
+        leaseId = nextLeaseId_++;
+        dirs_->Put(parent, leaseId);
+    }
+    // each entry expires with the lease granted with it, the lease may be
+    // lost without notification if metaserver failed to notify us
+    entries_->Put(CacheKey(parent, name),
+                  CacheEntry{leaseId, startMs + leaseMs, ino});
+}
+
+void DirLeases::Invalidate(Ino parent) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    epoch_++;
+    dirs_->Remove(parent);
+}
+
+void DirLeases::Invalidate(Ino parent, const std::string& name) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    epoch_++;
+    entries_->Remove(CacheKey(parent, name));
+}
+
+void DirLeases::InvalidateAll() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    epoch_++;
+    minLeaseId_ = nextLeaseId_;
+}
+
+void DirLeaseServiceImpl::InvalidateDir(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::InvalidateDirRequest* request,
+    ::curvefs::metaserver::InvalidateDirResponse* response,
+    ::google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    VLOG(6) << "Invalidate directories: " << request->ShortDebugString();
+    for (auto parent : request->parentinodeids()) {
+        leases_->Invalidate(parent);
+    }
+}
+
+}  // namespace filesystem
+}  // namespace client
+}  // namespace curvefs
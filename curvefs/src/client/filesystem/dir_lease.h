@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-05-04
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_FILESYSTEM_DIR_LEASE_H_
+#define CURVEFS_SRC_CLIENT_FILESYSTEM_DIR_LEASE_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "curvefs/proto/metaserver.pb.h"
+#include "curvefs/src/client/common/config.h"
+#include "curvefs/src/client/filesystem/meta.h"
+#include "src/common/lru_cache.h"
+
+namespace curvefs {
+namespace client {
+namespace filesystem {
+
+using ::curve::common::LRUCache;
+using ::curvefs::client::common::DirLeaseOption;
+
+// cache for lookup results of directories leased from metaserver, both
+// positive and negative results are cached until the lease expires or
+// metaserver notifies that the directory changed.
+class DirLeases {
+ public:
+    explicit DirLeases(DirLeaseOption option);
+
+    bool Enabled() const { return option_.enable; }
+
+    // address of the server receiving notifications
+    void SetHolder(const std::string& holder) { holder_ = holder; }
+
+    const std::string& Holder() const { return holder_; }
+
+    // the result of a lookup is cached only if the epoch doesn't change
+    // during the lookup, i.e. no notification arrives
+    uint64_t Epoch();
+
+    // |ino| is 0 if the entry doesn't exist
+    bool Get(Ino parent, const std::string& name, Ino* ino);
+
+    // |startMs| is the time before the lookup request is sent
+    void Put(Ino parent, const std::string& name, Ino ino,
+             uint32_t leaseMs, uint64_t startMs, uint64_t epoch);
+
+    // the directory is changed by others
+    void Invalidate(Ino parent);
+
+    // the entry is changed by this client
+    void Invalidate(Ino parent, const std::string& name);
+
+    void InvalidateAll();
+
+ private:
+    struct CacheEntry {
+        uint64_t leaseId;
+        uint64_t expireMs;
+        Ino ino;
+    };
+
+    std::string CacheKey(Ino parent, const std::string& name);
+
+ private:
+    DirLeaseOption option_;
+    std::string holder_;
+
+    std::mutex mtx_;
+    uint64_t epoch_;
+    uint64_t nextLeaseId_;
+    // leases with smaller id are invalidated
+    uint64_t minLeaseId_;
+    // directory -> id of its lease, entries cached under other leases
+    // of the directory are invalid
+    std::shared_ptr<LRUCache<Ino, uint64_t>> dirs_;
+    std::shared_ptr<LRUCache<std::string, CacheEntry>> entries_;
+};
+
+// receive notifications of directory changes from metaserver
+class DirLeaseServiceImpl : public ::curvefs::metaserver::DirLeaseService {
+ public:
+    explicit DirLeaseServiceImpl(std::shared_ptr<DirLeases> leases)
+        : leases_(std::move(leases)) {}
+
+    void InvalidateDir(
+        ::google::protobuf::RpcController* controller,
+        const ::curvefs::metaserver::InvalidateDirRequest* request,
+        ::curvefs::metaserver::InvalidateDirResponse* response,
+        ::google::protobuf::Closure* done) override;
+
+ private:
+    std::shared_ptr<DirLeases> leases_;
+};
+
+}  // namespace filesystem
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_FILESYSTEM_DIR_LEASE_H_
@@ -24,15 +24,19 @@
 
 #include "curvefs/src/client/filesystem/filesystem.h"
 #include "curvefs/src/client/filesystem/utils.h"
+#include "src/common/timeutility.h"
 
 namespace curvefs {
 namespace client {
 namespace filesystem {
 
+using ::curve::common::TimeUtility;
+
 FileSystem::FileSystem(FileSystemOption option, ExternalMember member)
     : option_(option), member(member) {
     deferSync_ = std::make_shared<DeferSync>(option.deferSyncOption);
     negative_ = std::make_shared<LookupCache>(option.lookupCacheOption);
+    dirLeases_ = std::make_shared<DirLeases>(option.dirLeaseOption);
     dirCache_ = std::make_shared<DirCache>(option.dirCacheOption);
     openFiles_ = std::make_shared<OpenFiles>(option_.openFilesOption,
                                              deferSync_);
@@ -233,6 +237,15 @@ FileSystemMember FileSystem::BorrowMember() {
     return FileSystemMember(deferSync_, openFiles_, attrWatcher_);
 }
 
+std::shared_ptr<DirLeases> FileSystem::GetDirLeases() {
+    return dirLeases_;
+}
+
+void FileSystem::InvalidateEntry(Ino parent, const std::string& name) {
+    negative_->Delete(parent, name);
+    dirLeases_->Invalidate(parent, name);
+}
+
 // fuse request*
 CURVEFS_ERROR FileSystem::Lookup(Request req,
                                  Ino parent,
@@ -247,6 +260,10 @@ CURVEFS_ERROR FileSystem::Lookup(Request req,
         return CURVEFS_ERROR::NOTEXIST;
     }
 
+    if (dirLeases_->Enabled()) {
+        return LeasedLookup(parent, name, entryOut);
+    }
+
     auto rc = rpc_->Lookup(parent, name, entryOut);
     if (rc == CURVEFS_ERROR::OK) {
         negative_->Delete(parent, name);
@@ -256,6 +273,36 @@ CURVEFS_ERROR FileSystem::Lookup(Request req,
     return rc;
 }
 
+CURVEFS_ERROR FileSystem::LeasedLookup(Ino parent,
+                                       const std::string& name,
+                                       EntryOut* entryOut) {
+    Ino ino = 0;
+    if (dirLeases_->Get(parent, name, &ino)) {
+        if (ino == 0) {
+            return CURVEFS_ERROR::NOTEXIST;
+        }
+        auto rc = rpc_->GetAttr(ino, &entryOut->attr);
+        if (rc != CURVEFS_ERROR::NOTEXIST) {
+            return rc;
+        }
+        // the inode is deleted, the notification may be lost
+        dirLeases_->Invalidate(parent, name);
+    }
+
+    uint64_t epoch = dirLeases_->Epoch();
+    uint64_t startMs = TimeUtility::GetTimeofDayMs();
+    uint32_t leaseMs = 0;
+    auto rc = rpc_->LookupWithLease(parent, name, dirLeases_->Holder(),
+                                    entryOut, &leaseMs);
+    if (rc == CURVEFS_ERROR::OK) {
+        dirLeases_->Put(parent, name, entryOut->attr.inodeid(), leaseMs,
+                        startMs, epoch);
+    } else if (rc == CURVEFS_ERROR::NOTEXIST) {
+        dirLeases_->Put(parent, name, 0, leaseMs, startMs, epoch);
+    }
+    return rc;
+}
+
 CURVEFS_ERROR FileSystem::GetAttr(Request req, Ino ino, AttrOut* attrOut) {
     InodeAttr attr;
     auto rc = rpc_->GetAttr(ino, &attr);
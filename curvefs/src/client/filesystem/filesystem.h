@@ -33,6 +33,7 @@
 #include "curvefs/src/client/filesystem/package.h"
 #include "curvefs/src/client/filesystem/meta.h"
 #include "curvefs/src/client/filesystem/lookup_cache.h"
+#include "curvefs/src/client/filesystem/dir_lease.h"
 #include "curvefs/src/client/filesystem/dir_cache.h"
 #include "curvefs/src/client/filesystem/openfile.h"
 #include "curvefs/src/client/filesystem/attr_watcher.h"
@@ -132,6 +133,11 @@ class FileSystem {
     // utility: others
     FileSystemMember BorrowMember();
 
+    std::shared_ptr<DirLeases> GetDirLeases();
+
+    // the entry is changed by this client, e.g. created locally or renamed
+    void InvalidateEntry(Ino parent, const std::string& name);
+
  private:
     FRIEND_TEST(FileSystemTest, Attr2Stat);
     FRIEND_TEST(FileSystemTest, Entry2Param);
@@ -148,11 +154,17 @@ class FileSystem {
 
     void SetAttrTimeout(AttrOut* attrOut);
 
+    // lookup with the cache of leased directories
+    CURVEFS_ERROR LeasedLookup(Ino parent,
+                               const std::string& name,
+                               EntryOut* entryOut);
+
  private:
     FileSystemOption option_;
     ExternalMember member;
     std::shared_ptr<DeferSync> deferSync_;
     std::shared_ptr<LookupCache> negative_;
+    std::shared_ptr<DirLeases> dirLeases_;
     std::shared_ptr<DirCache> dirCache_;
     std::shared_ptr<OpenFiles> openFiles_;
     std::shared_ptr<AttrWatcher> attrWatcher_;
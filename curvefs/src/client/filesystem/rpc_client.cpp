@@ -52,7 +52,10 @@ CURVEFS_ERROR RPCClient::Lookup(Ino parent,
                                 const std::string& name,
                                 EntryOut* entryOut) {
     Dentry dentry;
-    CURVEFS_ERROR rc = dentryManager_->GetDentry(parent, name, &dentry);
+    CURVEFS_ERROR rc = CURVEFS_ERROR::OK;
+    if (!inodeManager_->GetPendingDentry(parent, name, &dentry)) {
+        rc = dentryManager_->GetDentry(parent, name, &dentry);
+    }
     if (rc != CURVEFS_ERROR::OK) {
         if (rc != CURVEFS_ERROR::NOTEXIST) {
             LOG(ERROR) << "rpc(lookup::GetDentry) failed, retCode = " << rc
@@ -60,9 +63,34 @@ CURVEFS_ERROR RPCClient::Lookup(Ino parent,
         }
         return rc;
     }
+    return LookupAttr(dentry.inodeid(), entryOut);
+}
+
+CURVEFS_ERROR RPCClient::LookupWithLease(Ino parent,
+                                         const std::string& name,
+                                         const std::string& holder,
+                                         EntryOut* entryOut,
+                                         uint32_t* leaseMs) {
+    Dentry dentry;
+    CURVEFS_ERROR rc = CURVEFS_ERROR::OK;
+    *leaseMs = 0;
+    if (!inodeManager_->GetPendingDentry(parent, name, &dentry)) {
+        rc = dentryManager_->GetDentryWithLease(parent, name, holder, &dentry,
+                                                leaseMs);
+    }
+    if (rc != CURVEFS_ERROR::OK) {
+        if (rc != CURVEFS_ERROR::NOTEXIST) {
+            LOG(ERROR) << "rpc(lookup::GetDentryWithLease) failed"
+                       << ", retCode = " << rc << ", parent = " << parent
+                       << ", name = " << name;
+        }
+        return rc;
+    }
+    return LookupAttr(dentry.inodeid(), entryOut);
+}
 
-    Ino ino = dentry.inodeid();
-    rc = inodeManager_->GetInodeAttr(ino, &entryOut->attr);
+CURVEFS_ERROR RPCClient::LookupAttr(Ino ino, EntryOut* entryOut) {
+    CURVEFS_ERROR rc = inodeManager_->GetInodeAttr(ino, &entryOut->attr);
     if (rc != CURVEFS_ERROR::OK) {
         LOG(ERROR) << "rpc(lookup::GetInodeAttr) failed, retCode = " << rc
                    << ", ino = " << ino;
@@ -74,8 +102,19 @@ CURVEFS_ERROR RPCClient::ReadDir(Ino ino,
                                  std::shared_ptr<DirEntryList>* entries) {
     uint32_t limit = option_.listDentryLimit;
 
+    CURVEFS_ERROR rc = inodeManager_->FlushPendingCreates(ino);
+    if (rc != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "rpc(readdir::FlushPendingCreates) failed"
+                   << ", retCode = " << rc << ", ino = " << ino;
+        return rc;
+    }
+
+    if (option_.listDentryPlus) {
+        return ReadDirPlus(ino, entries);
+    }
+
     std::list<Dentry> dentries;
-    CURVEFS_ERROR rc = dentryManager_->ListDentry(ino, &dentries, limit);
+    rc = dentryManager_->ListDentry(ino, &dentries, limit);
     if (rc != CURVEFS_ERROR::OK) {
         LOG(ERROR) << "rpc(readdir::ListDentry) failed, retCode = " << rc
                    << ", ino = " << ino;
@@ -114,6 +153,55 @@ CURVEFS_ERROR RPCClient::ReadDir(Ino ino,
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR RPCClient::ReadDirPlus(Ino ino,
+                                     std::shared_ptr<DirEntryList>* entries) {
+    std::list<DentryPlus> dentries;
+    CURVEFS_ERROR rc = dentryManager_->ListDentryPlus(
+        ino, &dentries, option_.listDentryLimit,
+        option_.listDentryPlusStreaming);
+    if (rc != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "rpc(readdir::ListDentryPlus) failed, retCode = " << rc
+                   << ", ino = " << ino;
+        return rc;
+    }
+
+    // attributes of inodes in other partitions
+    std::set<uint64_t> inos;
+    std::map<uint64_t, InodeAttr> attrs;
+    for (const auto& entry : dentries) {
+        if (!entry.has_attr()) {
+            inos.emplace(entry.dentry().inodeid());
+        }
+    }
+    rc = inodeManager_->BatchGetInodeAttrAsync(ino, &inos, &attrs);
+    if (rc != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "rpc(readdir::BatchGetInodeAttrAsync) failed"
+                   << ", retCode = " << rc << ", ino = " << ino;
+        return rc;
+    }
+
+    DirEntry dirEntry;
+    for (auto& entry : dentries) {
+        Ino ino = entry.dentry().inodeid();
+        if (entry.has_attr()) {
+            dirEntry.attr = std::move(*entry.mutable_attr());
+        } else {
+            auto iter = attrs.find(ino);
+            if (iter == attrs.end()) {
+                LOG(WARNING) << "rpc(readdir::BatchGetInodeAttrAsync) "
+                             << "missing attribute, ino = " << ino;
+                continue;
+            }
+            dirEntry.attr = iter->second;
+        }
+
+        dirEntry.ino = ino;
+        dirEntry.name = std::move(*entry.mutable_dentry()->mutable_name());
+        (*entries)->Add(dirEntry);
+    }
+    return CURVEFS_ERROR::OK;
+}
+
 CURVEFS_ERROR RPCClient::Open(Ino ino, std::shared_ptr<InodeWrapper>* inode) {
     CURVEFS_ERROR rc = inodeManager_->GetInode(ino, *inode);
     if (rc != CURVEFS_ERROR::OK) {
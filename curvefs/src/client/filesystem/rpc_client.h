@@ -48,10 +48,23 @@ class RPCClient {
                          const std::string& name,
                          EntryOut* entryOut);
 
+    // lookup and lease the directory to |holder|, |leaseMs| is 0 if
+    // the result isn't leased, e.g. it's created locally
+    CURVEFS_ERROR LookupWithLease(Ino parent,
+                                  const std::string& name,
+                                  const std::string& holder,
+                                  EntryOut* entryOut,
+                                  uint32_t* leaseMs);
+
     CURVEFS_ERROR ReadDir(Ino ino, std::shared_ptr<DirEntryList>* entries);
 
     CURVEFS_ERROR Open(Ino ino, std::shared_ptr<InodeWrapper>* inode);
 
+ private:
+    CURVEFS_ERROR ReadDirPlus(Ino ino, std::shared_ptr<DirEntryList>* entries);
+
+    CURVEFS_ERROR LookupAttr(Ino ino, EntryOut* entryOut);
+
  private:
     RPCOption option_;
     std::shared_ptr<InodeCacheManager> inodeManager_;
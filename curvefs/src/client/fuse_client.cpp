@@ -46,6 +46,7 @@
 #include "src/common/dummyserver.h"
 #include "src/client/client_common.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 
 #define PORT_LIMIT 65535
 
@@ -164,6 +165,13 @@ CURVEFS_ERROR FuseClient::Init(const FuseClientOption &option) {
         fs_ = std::make_shared<FileSystem>(option_.fileSystemOption, member);
     }
 
+    if (option.fileSystemOption.dirLeaseOption.enable) {
+        CURVEFS_ERROR rc = InitDirLease(localIp);
+        if (rc != CURVEFS_ERROR::OK) {
+            return rc;
+        }
+    }
+
     MetaStatusCode ret2 =
         metaClient_->Init(option.excutorOpt, option.excutorInternalOpt,
                           metaCache, channelManager);
@@ -173,9 +181,9 @@ CURVEFS_ERROR FuseClient::Init(const FuseClientOption &option) {
 
     {  // init inode manager
         auto member = fs_->BorrowMember();
-        CURVEFS_ERROR rc = inodeManager_->Init(option.refreshDataOption,
-                                               member.openFiles,
-                                               member.deferSync);
+        CURVEFS_ERROR rc = inodeManager_->Init(
+            option.refreshDataOption, member.openFiles, member.deferSync,
+            option.fileSystemOption.localCreateOption);
         if (rc != CURVEFS_ERROR::OK) {
             return rc;
         }
@@ -191,11 +199,44 @@ CURVEFS_ERROR FuseClient::Init(const FuseClientOption &option) {
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR FuseClient::InitDirLease(const std::string& localIp) {
+    auto dirLeases = fs_->GetDirLeases();
+    dirLeaseService_ = absl::make_unique<DirLeaseServiceImpl>(dirLeases);
+    dirLeaseServer_ = absl::make_unique<brpc::Server>();
+    if (dirLeaseServer_->AddService(dirLeaseService_.get(),
+                                    brpc::SERVER_DOESNT_OWN_SERVICE) != 0) {
+        LOG(ERROR) << "Add directory lease service failed";
+        return CURVEFS_ERROR::INTERNAL;
+    }
+
+    const auto& option = option_.fileSystemOption.dirLeaseOption;
+    brpc::PortRange range(option.listenStartPort, PORT_LIMIT);
+    if (dirLeaseServer_->Start(localIp.c_str(), range, nullptr) != 0) {
+        LOG(ERROR) << "Start directory lease server failed";
+        return CURVEFS_ERROR::INTERNAL;
+    }
+
+    std::string holder = absl::StrCat(
+        localIp, ":", dirLeaseServer_->listen_address().port);
+    dirLeases->SetHolder(holder);
+    // renames committed by others change the txid of partitions, the
+    // dentries cached before may be stale
+    leaseExecutor_->SetTxIdChangedCallback(
+        [dirLeases]() { dirLeases->InvalidateAll(); });
+    LOG(INFO) << "Directory lease server started, holder = " << holder;
+    return CURVEFS_ERROR::OK;
+}
+
 void FuseClient::UnInit() {
     if (warmupManager_ != nullptr) {
         warmupManager_->UnInit();
     }
 
+    if (dirLeaseServer_ != nullptr) {
+        dirLeaseServer_->Stop(0);
+        dirLeaseServer_->Join();
+    }
+
     delete mdsBase_;
     mdsBase_ = nullptr;
 
@@ -378,6 +419,51 @@ CURVEFS_ERROR FuseClient::UpdateParentMCTimeAndNlink(
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR FuseClient::CreateNodeSeparately(
+    const InodeParam& param, Dentry* dentry,
+    std::shared_ptr<InodeWrapper>& inodeWrapper) {
+    CURVEFS_ERROR ret = inodeManager_->CreateInode(param, inodeWrapper);
+    if (ret != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "inodeManager CreateInode fail, ret = " << ret
+                   << ", parent = " << param.parent
+                   << ", name = " << dentry->name()
+                   << ", mode = " << param.mode;
+        return ret;
+    }
+
+    VLOG(6) << "inodeManager CreateInode success"
+            << ", parent = " << param.parent << ", name = " << dentry->name()
+            << ", mode = " << param.mode
+            << ", inode id = " << inodeWrapper->GetInodeId();
+
+    dentry->set_inodeid(inodeWrapper->GetInodeId());
+    ret = dentryManager_->CreateDentry(*dentry);
+    if (ret != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "dentryManager_ CreateDentry fail, ret = " << ret
+                   << ", parent = " << param.parent
+                   << ", name = " << dentry->name()
+                   << ", mode = " << param.mode;
+
+        CURVEFS_ERROR ret2 =
+            inodeManager_->DeleteInode(inodeWrapper->GetInodeId());
+        if (ret2 != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "Also delete inode failed, ret = " << ret2
+                       << ", inodeid = " << inodeWrapper->GetInodeId();
+        }
+        return ret;
+    }
+
+    ret = UpdateParentMCTimeAndNlink(param.parent, param.type,
+                                     NlinkChange::kAddOne);
+    if (ret != CURVEFS_ERROR::OK) {
+        LOG(ERROR) << "UpdateParentMCTimeAndNlink failed"
+                   << ", parent: " << param.parent
+                   << ", name: " << dentry->name()
+                   << ", type: " << param.type;
+    }
+    return ret;
+}
+
 CURVEFS_ERROR FuseClient::MakeNode(
     fuse_req_t req,
     fuse_ino_t parent,
@@ -418,56 +504,36 @@ CURVEFS_ERROR FuseClient::MakeNode(
     param.rdev = rdev;
     param.parent = parent;
 
-    CURVEFS_ERROR ret = inodeManager_->CreateInode(param, inodeWrapper);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "inodeManager CreateInode fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name
-                   << ", mode = " << mode;
-        return ret;
-    }
-
-    VLOG(6) << "inodeManager CreateInode success"
-            << ", parent = " << parent << ", name = " << name
-            << ", mode = " << mode
-            << ", inode id = " << inodeWrapper->GetInodeId();
-
     Dentry dentry;
     dentry.set_fsid(fsInfo_->fsid());
-    dentry.set_inodeid(inodeWrapper->GetInodeId());
     dentry.set_parentinodeid(parent);
     dentry.set_name(name);
-    dentry.set_type(inodeWrapper->GetType());
+    dentry.set_type(type);
     if (type == FsFileType::TYPE_FILE || type == FsFileType::TYPE_S3) {
         dentry.set_flag(DentryFlag::TYPE_FILE_FLAG);
     }
 
-    ret = dentryManager_->CreateDentry(dentry);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "dentryManager_ CreateDentry fail, ret = " << ret
-                   << ", parent = " << parent << ", name = " << name
-                   << ", mode = " << mode;
-
-        CURVEFS_ERROR ret2 =
-            inodeManager_->DeleteInode(inodeWrapper->GetInodeId());
-        if (ret2 != CURVEFS_ERROR::OK) {
-            LOG(ERROR) << "Also delete inode failed, ret = " << ret2
-                       << ", inodeid = " << inodeWrapper->GetInodeId();
+    CURVEFS_ERROR ret;
+    if (option_.fileSystemOption.rpcOption.compoundCreate) {
+        ret = inodeManager_->CreateNode(param, dentry, inodeWrapper);
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "inodeManager CreateNode fail, ret = " << ret
+                       << ", parent = " << parent << ", name = " << name
+                       << ", mode = " << mode;
+            return ret;
+        }
+    } else {
+        ret = CreateNodeSeparately(param, &dentry, inodeWrapper);
+        if (ret != CURVEFS_ERROR::OK) {
+            return ret;
         }
-        return ret;
-    }
-
-    ret = UpdateParentMCTimeAndNlink(parent, type, NlinkChange::kAddOne);
-    if (ret != CURVEFS_ERROR::OK) {
-        LOG(ERROR) << "UpdateParentMCTimeAndNlink failed"
-                   << ", parent: " << parent
-                   << ", name: " << name
-                   << ", type: " << type;
-        return ret;
     }
 
-    VLOG(6) << "dentryManager_ CreateDentry success"
+    VLOG(6) << "MakeNode success"
             << ", parent = " << parent << ", name = " << name
-            << ", mode = " << mode;
+            << ", mode = " << mode
+            << ", inode id = " << inodeWrapper->GetInodeId();
+    fs_->InvalidateEntry(parent, name);
 
     if (enableSumInDir_.load()) {
         // update parent summary info
@@ -524,6 +590,7 @@ CURVEFS_ERROR FuseClient::DeleteNode(uint64_t ino, fuse_ino_t parent,
                    << ", parent = " << parent << ", name = " << name;
         return ret;
     }
+    fs_->InvalidateEntry(parent, name);
 
     ret = UpdateParentMCTimeAndNlink(parent, type, NlinkChange::kSubOne);
     if (ret != CURVEFS_ERROR::OK) {
@@ -789,8 +856,15 @@ CURVEFS_ERROR FuseClient::RemoveNode(fuse_req_t req, fuse_ino_t parent,
         return CURVEFS_ERROR::NOPERMISSION;
     }
 
+    // the removed directory may have children created locally
+    CURVEFS_ERROR ret = inodeManager_->FlushPendingCreates(
+        FsFileType::TYPE_DIRECTORY == type ? 0 : parent);
+    if (ret != CURVEFS_ERROR::OK) {
+        return ret;
+    }
+
     Dentry dentry;
-    CURVEFS_ERROR ret = dentryManager_->GetDentry(parent, name, &dentry);
+    ret = dentryManager_->GetDentry(parent, name, &dentry);
     if (ret != CURVEFS_ERROR::OK) {
         LOG(WARNING) << "dentryManager_ GetDentry fail, ret = " << ret
                      << ", parent = " << parent << ", name = " << name;
@@ -919,6 +993,16 @@ CURVEFS_ERROR FuseClient::FuseOpRename(fuse_req_t req, fuse_ino_t parent,
         return CURVEFS_ERROR::NAMETOOLONG;
     }
 
+    // only the dentries of both parents are changed, files created locally
+    // in other directories needn't be persisted
+    CURVEFS_ERROR ret = inodeManager_->FlushPendingCreates(parent);
+    if (ret == CURVEFS_ERROR::OK && newparent != parent) {
+        ret = inodeManager_->FlushPendingCreates(newparent);
+    }
+    if (ret != CURVEFS_ERROR::OK) {
+        return ret;
+    }
+
     auto renameOp =
         RenameOperator(fsInfo_->fsid(), fsInfo_->fsname(),
                        parent, name, newparent, newname,
@@ -945,6 +1029,8 @@ CURVEFS_ERROR FuseClient::FuseOpRename(fuse_req_t req, fuse_ino_t parent,
     }
     renameOp.UpdateInodeCtime();
     renameOp.UpdateCache();
+    fs_->InvalidateEntry(parent, name);
+    fs_->InvalidateEntry(newparent, newname);
 
     if (enableSumInDir_.load()) {
         xattrManager_->UpdateParentXattrAfterRename(
@@ -1202,8 +1288,13 @@ CURVEFS_ERROR FuseClient::FuseOpSymlink(fuse_req_t req,
     param.symlink = link;
     param.parent = parent;
 
+    CURVEFS_ERROR ret = inodeManager_->FlushPendingCreates(parent);
+    if (ret != CURVEFS_ERROR::OK) {
+        return ret;
+    }
+
     std::shared_ptr<InodeWrapper> inodeWrapper;
-    CURVEFS_ERROR ret = inodeManager_->CreateInode(param, inodeWrapper);
+    ret = inodeManager_->CreateInode(param, inodeWrapper);
     if (ret != CURVEFS_ERROR::OK) {
         LOG(ERROR) << "inodeManager CreateInode fail, ret = " << ret
                    << ", parent = " << parent << ", name = " << name
@@ -1230,6 +1321,7 @@ CURVEFS_ERROR FuseClient::FuseOpSymlink(fuse_req_t req,
         }
         return ret;
     }
+    fs_->InvalidateEntry(parent, name);
 
     ret = UpdateParentMCTimeAndNlink(parent, FsFileType::TYPE_SYM_LINK,
         NlinkChange::kAddOne);
@@ -1270,8 +1362,12 @@ CURVEFS_ERROR FuseClient::FuseOpLink(fuse_req_t req,
     if (strlen(newname) > option_.fileSystemOption.maxNameLength) {
         return CURVEFS_ERROR::NAMETOOLONG;
     }
+    CURVEFS_ERROR ret = inodeManager_->FlushPendingCreates(newparent);
+    if (ret != CURVEFS_ERROR::OK) {
+        return ret;
+    }
     std::shared_ptr<InodeWrapper> inodeWrapper;
-    CURVEFS_ERROR ret = inodeManager_->GetInode(ino, inodeWrapper);
+    ret = inodeManager_->GetInode(ino, inodeWrapper);
     if (ret != CURVEFS_ERROR::OK) {
         LOG(ERROR) << "inodeManager get inode fail, ret = " << ret
                    << ", inodeid = " << ino;
@@ -1302,6 +1398,7 @@ CURVEFS_ERROR FuseClient::FuseOpLink(fuse_req_t req,
         }
         return ret;
     }
+    fs_->InvalidateEntry(newparent, newname);
 
     ret = UpdateParentMCTimeAndNlink(newparent, type, NlinkChange::kAddOne);
     if (ret != CURVEFS_ERROR::OK) {
@@ -1358,6 +1455,9 @@ CURVEFS_ERROR FuseClient::FuseOpRelease(fuse_req_t req,
 }
 
 void FuseClient::FlushAll() {
+    CURVEFS_ERROR ret = inodeManager_->FlushPendingCreates(0);
+    LOG_IF(ERROR, ret != CURVEFS_ERROR::OK)
+        << "Flush files created locally failed, ret = " << ret;
     FlushData();
 }
 
@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <bthread/unstable.h>
+#include <brpc/server.h>
 
 #include <map>
 #include <memory>
@@ -58,6 +59,7 @@
 #include "src/common/throttle.h"
 #include "curvefs/src/client/filesystem/meta.h"
 #include "curvefs/src/client/filesystem/filesystem.h"
+#include "curvefs/src/client/filesystem/dir_lease.h"
 
 #define DirectIOAlignment 512
 
@@ -87,6 +89,7 @@ using ::curvefs::client::filesystem::FileSystem;
 using ::curvefs::client::filesystem::EntryOut;
 using ::curvefs::client::filesystem::AttrOut;
 using ::curvefs::client::filesystem::FileOut;
+using ::curvefs::client::filesystem::DirLeaseServiceImpl;
 
 using curvefs::common::is_aligned;
 
@@ -396,6 +399,11 @@ class FuseClient {
     CURVEFS_ERROR UpdateParentMCTimeAndNlink(
         fuse_ino_t parent, FsFileType type,  NlinkChange nlink);
 
+    // create inode, dentry and update parent by separate requests
+    CURVEFS_ERROR CreateNodeSeparately(
+        const InodeParam& param, Dentry* dentry,
+        std::shared_ptr<InodeWrapper>& inodeWrapper);  // NOLINT
+
     std::string GenerateNewRecycleName(fuse_ino_t ino,
             fuse_ino_t parent, const char* name) {
         std::string newName(name);
@@ -446,7 +454,13 @@ class FuseClient {
 
     std::shared_ptr<FileSystem> fs_;
 
+    // receive notifications of leased directories from metaserver
+    std::unique_ptr<brpc::Server> dirLeaseServer_;
+    std::unique_ptr<DirLeaseServiceImpl> dirLeaseService_;
+
  private:
+    CURVEFS_ERROR InitDirLease(const std::string& localIp);
+
     MDSBaseClient* mdsBase_;
 
     Atomic<bool> isStop_;
@@ -21,11 +21,16 @@
  */
 
 
+#include <brpc/server.h>
+
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "curvefs/src/client/fuse_s3_client.h"
 #include "curvefs/src/client/kvclient/memcache_client.h"
+#include "src/common/string_util.h"
 
 namespace curvefs {
 namespace client {
@@ -115,7 +120,8 @@ bool FuseS3Client::InitKVCache(const KVClientManagerOpt &opt) {
     }
 
     // init kvcache client
-    auto memcacheClient = std::make_shared<MemCachedClient>();
+    auto memcacheClient =
+        std::make_shared<MemCachedClient>(opt.memcacheClientOpt);
     if (!memcacheClient->Init(kvcachecluster)) {
         LOG(ERROR) << "FLAGS_supportKVcache = " << FLAGS_supportKVcache
                    << ", but init memcache client fail";
@@ -136,7 +142,74 @@ bool FuseS3Client::InitKVCache(const KVClientManagerOpt &opt) {
     return true;
 }
 
+bool FuseS3Client::InitCachePeer(const CachePeerOption &opt) {
+    cachePeerService_ = absl::make_unique<CachePeerServiceImpl>(
+        s3Adaptor_->GetS3Client(), s3Adaptor_->GetDiskCacheManager(), opt,
+        fsInfo_->fsid(), s3Adaptor_->GetBlockSize(),
+        s3Adaptor_->GetObjectPrefix());
+    cachePeerServer_ = absl::make_unique<brpc::Server>();
+    if (cachePeerServer_->AddService(cachePeerService_.get(),
+                                     brpc::SERVER_DOESNT_OWN_SERVICE) != 0) {
+        LOG(ERROR) << "Add cache peer service failed";
+        return false;
+    }
+    // only listen on the address peers reach this client by
+    butil::ip_t ip;
+    if (butil::hostname2ip(mountpoint_.hostname().c_str(), &ip) != 0) {
+        LOG(ERROR) << "Resolve " << mountpoint_.hostname() << " failed";
+        return false;
+    }
+    butil::EndPoint listenAddr(ip, opt.port);
+    if (cachePeerServer_->Start(listenAddr, nullptr) != 0) {
+        LOG(ERROR) << "Start cache peer server on "
+                   << butil::endpoint2str(listenAddr).c_str() << " failed";
+        return false;
+    }
+
+    std::string self =
+        mountpoint_.hostname() + ":" + std::to_string(opt.port);
+    cachePeerClient_ = std::make_shared<CachePeerClient>(
+        opt, self, [this, opt](std::vector<std::string> *peers) {
+            return ListCachePeers(opt, peers);
+        });
+    if (!cachePeerClient_->Init()) {
+        return false;
+    }
+    s3Adaptor_->SetCachePeerClient(cachePeerClient_);
+    return true;
+}
+
+bool FuseS3Client::ListCachePeers(const CachePeerOption &opt,
+                                  std::vector<std::string> *peers) {
+    if (!opt.peers.empty()) {
+        curve::common::SplitString(opt.peers, ",", peers);
+        return true;
+    }
+
+    // every mountpoint serves on the same port
+    FsInfo fsInfo;
+    FSStatusCode ret = mdsClient_->GetFsInfo(fsInfo_->fsid(), &fsInfo);
+    if (ret != FSStatusCode::OK) {
+        LOG(WARNING) << "Get fsinfo failed, fsId = " << fsInfo_->fsid()
+                     << ", ret = " << FSStatusCode_Name(ret);
+        return false;
+    }
+    for (const auto &mountpoint : fsInfo.mountpoints()) {
+        peers->push_back(mountpoint.hostname() + ":" +
+                         std::to_string(opt.port));
+    }
+    return true;
+}
+
 void FuseS3Client::UnInit() {
+    if (cachePeerClient_ != nullptr) {
+        s3Adaptor_->SetCachePeerClient(nullptr);
+        cachePeerClient_->Stop();
+    }
+    if (cachePeerServer_ != nullptr) {
+        cachePeerServer_->Stop(0);
+        cachePeerServer_->Join();
+    }
     FuseClient::UnInit();
     s3Adaptor_->Stop();
     curve::common::S3Adapter::Shutdown();
@@ -148,6 +221,11 @@ CURVEFS_ERROR FuseS3Client::FuseOpInit(void *userdata,
     if (init_) {
         s3Adaptor_->SetFsId(fsInfo_->fsid());
         s3Adaptor_->InitMetrics(fsInfo_->fsname());
+        // the mountpoint is known after mounted
+        if (option_.cachePeerOption.enable &&
+            !InitCachePeer(option_.cachePeerOption)) {
+            return CURVEFS_ERROR::INTERNAL;
+        }
     }
     return ret;
 }
@@ -24,6 +24,8 @@
 #ifndef CURVEFS_SRC_CLIENT_FUSE_S3_CLIENT_H_
 #define CURVEFS_SRC_CLIENT_FUSE_S3_CLIENT_H_
 
+#include <brpc/server.h>
+
 #include <memory>
 #include <string>
 #include <list>
@@ -31,6 +33,8 @@
 #include <utility>
 
 #include "curvefs/src/client/fuse_client.h"
+#include "curvefs/src/client/s3/cache_peer_client.h"
+#include "curvefs/src/client/s3/cache_peer_service.h"
 #include "curvefs/src/client/s3/client_s3_cache_manager.h"
 #include "curvefs/src/client/warmup/warmup_manager.h"
 #include "curvefs/src/volume/common.h"
@@ -123,6 +127,13 @@ class FuseS3Client : public FuseClient {
  private:
     bool InitKVCache(const KVClientManagerOpt &opt);
 
+    // share s3 objects with the other clients of the filesystem
+    bool InitCachePeer(const CachePeerOption &opt);
+
+    // list "host:port" of cache peers, from config or mountpoints in mds
+    bool ListCachePeers(const CachePeerOption &opt,
+                        std::vector<std::string> *peers);
+
     void FlushData() override;
 
  private:
@@ -130,6 +141,10 @@ class FuseS3Client : public FuseClient {
     std::shared_ptr<S3ClientAdaptor> s3Adaptor_;
     std::shared_ptr<KVClientManager> kvClientManager_;
 
+    std::unique_ptr<brpc::Server> cachePeerServer_;
+    std::unique_ptr<CachePeerServiceImpl> cachePeerService_;
+    std::shared_ptr<CachePeerClient> cachePeerClient_;
+
     static constexpr auto MIN_WRITE_CACHE_SIZE = 8 * kMiB;
 };
 
@@ -116,6 +116,8 @@ CURVEFS_ERROR FuseVolumeClient::FuseOpInit(void *userdata,
         volOpts_.allocatorOption.bitmapAllocatorOption.sizePerBit;
     option.allocatorOption.bitmapAllocatorOption.smallAllocProportion =
         volOpts_.allocatorOption.bitmapAllocatorOption.smallAllocProportion;
+    option.allocatorOption.bitmapAllocatorOption.allocGroups =
+        volOpts_.allocatorOption.bitmapAllocatorOption.allocGroups;
     option.threshold = volOpts_.threshold;
     option.releaseInterSec = volOpts_.releaseInterSec;
 
@@ -129,6 +131,8 @@ CURVEFS_ERROR FuseVolumeClient::FuseOpInit(void *userdata,
     ExtentCacheOption extentOpt;
     extentOpt.blockSize = vol.blocksize();
     extentOpt.sliceSize = vol.slicesize();
+    extentOpt.preAllocSize = option_.extentManagerOpt.preAllocSize;
+    extentOpt.maxPreAllocSize = option_.extentManagerOpt.maxPreAllocSize;
 
     ExtentCache::SetOption(extentOpt);
 
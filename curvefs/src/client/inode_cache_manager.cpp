@@ -27,7 +27,9 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/client/filesystem/error.h"
 #include "curvefs/src/client/inode_wrapper.h"
@@ -70,6 +72,10 @@ using curvefs::client::common::FLAGS_enableCto;
 CURVEFS_ERROR
 InodeCacheManagerImpl::GetInode(uint64_t inodeId,
                                 std::shared_ptr<InodeWrapper> &out) {
+    if (GetPendingInode(inodeId, &out)) {
+        return CURVEFS_ERROR::OK;
+    }
+
     NameLockGuard lock(nameLock_, std::to_string(inodeId));
     bool yes = openFiles_->IsOpened(inodeId, &out);
     if (yes) {
@@ -93,6 +99,12 @@ InodeCacheManagerImpl::GetInode(uint64_t inodeId,
 
 CURVEFS_ERROR InodeCacheManagerImpl::GetInodeAttr(uint64_t inodeId,
                                                   InodeAttr *out) {
+    std::shared_ptr<InodeWrapper> inode;
+    if (GetPendingInode(inodeId, &inode)) {
+        inode->GetInodeAttr(out);
+        return CURVEFS_ERROR::OK;
+    }
+
     NameLockGuard lock(nameLock_, std::to_string(inodeId));
     std::set<uint64_t> inodeIds;
     std::list<InodeAttr> attrs;
@@ -220,6 +232,236 @@ CURVEFS_ERROR InodeCacheManagerImpl::CreateManageInode(
     return CURVEFS_ERROR::OK;
 }
 
+CURVEFS_ERROR InodeCacheManagerImpl::CreateNode(
+    const InodeParam &param, const Dentry &dentry,
+    std::shared_ptr<InodeWrapper> &out) {
+    Dentry pending;
+    if (GetPendingDentry(dentry.parentinodeid(), dentry.name(), &pending)) {
+        return CURVEFS_ERROR::EXISTS;
+    }
+
+    // the new inode always uses an inode id leased by client, so a retried
+    // request returns the inode created by the former one
+    uint64_t inodeId = 0;
+    bool leased =
+        idAllocator_->Allocate(param.fsId, dentry.parentinodeid(), &inodeId);
+    if (leased && localCreateOption_.enable &&
+        (param.type == FsFileType::TYPE_FILE ||
+         param.type == FsFileType::TYPE_S3)) {
+        return CreateNodeLocally(param, dentry, inodeId, out);
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    Inode inode;
+    MetaStatusCode ret = MetaStatusCode::PARTITION_ALLOC_ID_FAIL;
+    if (leased) {
+        Dentry newDentry = dentry;
+        newDentry.set_inodeid(inodeId);
+        ret = metaClient_->CreateNode(newDentry, &param, now, &inode);
+    }
+    if (ret == MetaStatusCode::PARTITION_ALLOC_ID_FAIL) {
+        // no inode id can be leased from the partition of the parent,
+        // create the inode in another partition, then the dentry refers
+        // to it
+        VLOG(3) << "partition of parent " << dentry.parentinodeid()
+                << " has no free inode id, create inode separately";
+        ret = metaClient_->CreateInode(param, &inode);
+        if (ret == MetaStatusCode::OK) {
+            Dentry newDentry = dentry;
+            newDentry.set_inodeid(inode.inodeid());
+            ret = metaClient_->CreateNode(newDentry, nullptr, now, nullptr);
+            if (ret != MetaStatusCode::OK) {
+                MetaStatusCode ret2 =
+                    metaClient_->DeleteInode(inode.fsid(), inode.inodeid());
+                LOG_IF(ERROR, ret2 != MetaStatusCode::OK)
+                    << "Also delete inode failed, ret = "
+                    << MetaStatusCode_Name(ret2)
+                    << ", inodeId = " << inode.inodeid();
+            }
+        }
+    }
+
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "metaClient_ CreateNode failed, MetaStatusCode = " << ret
+                   << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
+                   << ", parent = " << dentry.parentinodeid()
+                   << ", name = " << dentry.name();
+        return ToFSError(ret);
+    }
+
+    UpdateParentAfterCreate(dentry.parentinodeid(), param.type, now);
+    out = std::make_shared<InodeWrapper>(std::move(inode), metaClient_,
+        s3ChunkInfoMetric_, option_.maxDataSize,
+        option_.refreshDataIntervalSec);
+    return CURVEFS_ERROR::OK;
+}
+
+CURVEFS_ERROR InodeCacheManagerImpl::CreateNodeLocally(
+    const InodeParam &param, const Dentry &dentry, uint64_t inodeId,
+    std::shared_ptr<InodeWrapper> &out) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    // same as the inode generated by metaserver
+    Inode inode;
+    inode.set_inodeid(inodeId);
+    inode.set_fsid(param.fsId);
+    inode.set_length(param.length);
+    inode.set_uid(param.uid);
+    inode.set_gid(param.gid);
+    inode.set_mode(param.mode);
+    inode.set_type(param.type);
+    inode.set_rdev(param.rdev);
+    inode.add_parent(dentry.parentinodeid());
+    inode.set_atime(now.tv_sec);
+    inode.set_atime_ns(now.tv_nsec);
+    inode.set_mtime(now.tv_sec);
+    inode.set_mtime_ns(now.tv_nsec);
+    inode.set_ctime(now.tv_sec);
+    inode.set_ctime_ns(now.tv_nsec);
+    inode.set_nlink(1);
+
+    Dentry newDentry = dentry;
+    newDentry.set_inodeid(inodeId);
+    auto wrapper = std::make_shared<InodeWrapper>(std::move(inode),
+        metaClient_, s3ChunkInfoMetric_, option_.maxDataSize,
+        option_.refreshDataIntervalSec);
+    wrapper->SetPendingCreate(newDentry, param, now);
+
+    bool pending = false;
+    {
+        curve::common::LockGuard lk(pendingMtx_);
+        auto key = std::make_pair(dentry.parentinodeid(), dentry.name());
+        if (pendingDentries_.count(key) != 0) {
+            return CURVEFS_ERROR::EXISTS;
+        }
+
+        if (pendingInodes_.size() < localCreateOption_.maxPending ||
+            ErasePersistedLocked() < localCreateOption_.maxPending) {
+            pendingDentries_[key] = inodeId;
+            pendingInodes_[inodeId] = PendingNode{newDentry, wrapper};
+            pending = true;
+        }
+    }
+
+    if (pending) {
+        VLOG(6) << "Create node locally, parent = " << dentry.parentinodeid()
+                << ", name = " << dentry.name() << ", inodeid = " << inodeId;
+        // persisted by defer sync if nothing else syncs it before
+        ShipToFlush(wrapper);
+    } else {
+        // too many files are pending, persist it now
+        CURVEFS_ERROR rc = wrapper->PersistCreate();
+        if (rc != CURVEFS_ERROR::OK) {
+            return rc;
+        }
+    }
+
+    UpdateParentAfterCreate(dentry.parentinodeid(), param.type, now);
+    out = std::move(wrapper);
+    return CURVEFS_ERROR::OK;
+}
+
+void InodeCacheManagerImpl::UpdateParentAfterCreate(
+    uint64_t parentId, FsFileType type, const struct timespec &now) {
+    std::shared_ptr<InodeWrapper> parent;
+    if (openFiles_->IsOpened(parentId, &parent)) {
+        curve::common::UniqueLock lk = parent->GetUniqueLock();
+        parent->ApplyPersistedTimestampLocked(now, kModifyTime | kChangeTime);
+        if (type == FsFileType::TYPE_DIRECTORY) {
+            parent->UpdateNlinkLocked(NlinkChange::kAddOne);
+        }
+    }
+}
+
+bool InodeCacheManagerImpl::GetPendingDentry(uint64_t parentId,
+                                             const std::string &name,
+                                             Dentry *dentry) {
+    curve::common::LockGuard lk(pendingMtx_);
+    auto iter = pendingDentries_.find(std::make_pair(parentId, name));
+    if (iter == pendingDentries_.end()) {
+        return false;
+    }
+
+    auto &node = pendingInodes_[iter->second];
+    if (!node.inode->IsCreatePending()) {
+        pendingInodes_.erase(iter->second);
+        pendingDentries_.erase(iter);
+        return false;
+    }
+    *dentry = node.dentry;
+    return true;
+}
+
+bool InodeCacheManagerImpl::GetPendingInode(
+    uint64_t inodeId, std::shared_ptr<InodeWrapper> *out) {
+    curve::common::LockGuard lk(pendingMtx_);
+    auto iter = pendingInodes_.find(inodeId);
+    if (iter == pendingInodes_.end()) {
+        return false;
+    }
+
+    if (!iter->second.inode->IsCreatePending()) {
+        pendingDentries_.erase(std::make_pair(
+            iter->second.dentry.parentinodeid(), iter->second.dentry.name()));
+        pendingInodes_.erase(iter);
+        return false;
+    }
+    *out = iter->second.inode;
+    return true;
+}
+
+size_t InodeCacheManagerImpl::ErasePersistedLocked() {
+    for (auto iter = pendingInodes_.begin(); iter != pendingInodes_.end();) {
+        if (iter->second.inode->IsCreatePending()) {
+            ++iter;
+            continue;
+        }
+        pendingDentries_.erase(std::make_pair(
+            iter->second.dentry.parentinodeid(), iter->second.dentry.name()));
+        iter = pendingInodes_.erase(iter);
+    }
+    return pendingInodes_.size();
+}
+
+CURVEFS_ERROR InodeCacheManagerImpl::FlushPendingCreates(uint64_t parentId) {
+    std::vector<std::shared_ptr<InodeWrapper>> inodes;
+    {
+        curve::common::LockGuard lk(pendingMtx_);
+        if (parentId == 0) {
+            for (const auto &item : pendingInodes_) {
+                inodes.emplace_back(item.second.inode);
+            }
+        } else {
+            auto iter =
+                pendingDentries_.lower_bound(std::make_pair(parentId, ""));
+            for (; iter != pendingDentries_.end() &&
+                   iter->first.first == parentId;
+                 ++iter) {
+                inodes.emplace_back(pendingInodes_[iter->second].inode);
+            }
+        }
+    }
+
+    CURVEFS_ERROR rc = CURVEFS_ERROR::OK;
+    for (const auto &inode : inodes) {
+        CURVEFS_ERROR ret = inode->PersistCreate();
+        if (ret != CURVEFS_ERROR::OK) {
+            LOG(ERROR) << "Persist file created locally failed, inodeid = "
+                       << inode->GetInodeId() << ", retCode = " << ret;
+            rc = ret;
+        }
+    }
+
+    if (!inodes.empty()) {
+        curve::common::LockGuard lk(pendingMtx_);
+        ErasePersistedLocked();
+    }
+    return rc;
+}
+
 CURVEFS_ERROR InodeCacheManagerImpl::DeleteInode(uint64_t inodeId) {
     NameLockGuard lock(nameLock_, std::to_string(inodeId));
     MetaStatusCode ret = metaClient_->DeleteInode(fsId_, inodeId);
@@ -30,9 +30,11 @@
 #include <map>
 #include <set>
 #include <list>
+#include <string>
 #include <vector>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "curvefs/src/client/rpcclient/task_excutor.h"
 #include "src/common/lru_cache.h"
 
@@ -46,9 +48,11 @@
 #include "curvefs/src/client/common/config.h"
 #include "curvefs/src/client/filesystem/openfile.h"
 #include "curvefs/src/client/filesystem/defer_sync.h"
+#include "curvefs/src/client/inode_id_allocator.h"
 
 using ::curve::common::LRUCache;
 using ::curve::common::CacheMetrics;
+using ::curvefs::metaserver::Dentry;
 using ::curvefs::metaserver::InodeAttr;
 using ::curvefs::metaserver::XAttr;
 using ::curve::common::Atomic;
@@ -66,6 +70,7 @@ using rpcclient::BatchGetInodeAttrDone;
 using curve::common::CountDownEvent;
 using metric::S3ChunkInfoMetric;
 using common::RefreshDataOption;
+using common::LocalCreateOption;
 using ::curvefs::client::filesystem::OpenFiles;
 using ::curvefs::client::filesystem::DeferSync;
 
@@ -81,7 +86,8 @@ class InodeCacheManager {
 
     virtual CURVEFS_ERROR Init(RefreshDataOption option,
                                std::shared_ptr<OpenFiles> openFiles,
-                               std::shared_ptr<DeferSync> deferSync) = 0;
+                               std::shared_ptr<DeferSync> deferSync,
+                               LocalCreateOption localCreateOption) = 0;
 
     virtual CURVEFS_ERROR
     GetInode(uint64_t inodeId,
@@ -107,6 +113,23 @@ class InodeCacheManager {
     virtual CURVEFS_ERROR CreateManageInode(const InodeParam &param,
         std::shared_ptr<InodeWrapper> &out) = 0;   // NOLINT
 
+    // Create inode and |dentry| and update the parent, in one request if
+    // the partition of the parent has free inode id. The parent is also
+    // updated in cache if it's opened.
+    // Regular files are created locally if local create is enabled.
+    virtual CURVEFS_ERROR CreateNode(const InodeParam &param,
+                                     const Dentry &dentry,
+                                     std::shared_ptr<InodeWrapper> &out) = 0;   // NOLINT
+
+    // Get dentry of a file created locally and not persisted yet
+    virtual bool GetPendingDentry(uint64_t parentId, const std::string &name,
+                                  Dentry *dentry) = 0;
+
+    // Persist files created locally under |parentId|, or all of them if
+    // |parentId| is 0. It must be called before listing or modifying the
+    // directory on metaserver.
+    virtual CURVEFS_ERROR FlushPendingCreates(uint64_t parentId) = 0;
+
     virtual CURVEFS_ERROR DeleteInode(uint64_t inodeId) = 0;
 
     virtual void ShipToFlush(
@@ -128,11 +151,18 @@ class InodeCacheManagerImpl : public InodeCacheManager,
 
     CURVEFS_ERROR Init(RefreshDataOption option,
                        std::shared_ptr<OpenFiles> openFiles,
-                       std::shared_ptr<DeferSync> deferSync) override {
+                       std::shared_ptr<DeferSync> deferSync,
+                       LocalCreateOption localCreateOption) override {
         option_ = option;
         s3ChunkInfoMetric_ = std::make_shared<S3ChunkInfoMetric>();
         openFiles_ =  openFiles;
         deferSync_ = deferSync;
+        if (deferSync_ != nullptr) {
+            deferSync_->SetMetaClient(metaClient_);
+        }
+        localCreateOption_ = localCreateOption;
+        idAllocator_ = absl::make_unique<InodeIdAllocator>(
+            metaClient_, localCreateOption_.idLeaseSize);
         return CURVEFS_ERROR::OK;
     }
 
@@ -157,6 +187,14 @@ class InodeCacheManagerImpl : public InodeCacheManager,
     CURVEFS_ERROR CreateManageInode(const InodeParam &param,
         std::shared_ptr<InodeWrapper> &out) override;
 
+    CURVEFS_ERROR CreateNode(const InodeParam &param, const Dentry &dentry,
+                             std::shared_ptr<InodeWrapper> &out) override;
+
+    bool GetPendingDentry(uint64_t parentId, const std::string &name,
+                          Dentry *dentry) override;
+
+    CURVEFS_ERROR FlushPendingCreates(uint64_t parentId) override;
+
     CURVEFS_ERROR DeleteInode(uint64_t inodeId) override;
 
     void ShipToFlush(
@@ -166,6 +204,21 @@ class InodeCacheManagerImpl : public InodeCacheManager,
     CURVEFS_ERROR RefreshData(std::shared_ptr<InodeWrapper> &inode,  // NOLINT
                               bool streaming = true);
 
+    CURVEFS_ERROR CreateNodeLocally(const InodeParam &param,
+                                    const Dentry &dentry,
+                                    uint64_t inodeId,
+                                    std::shared_ptr<InodeWrapper> &out);  // NOLINT
+
+    bool GetPendingInode(uint64_t inodeId,
+                         std::shared_ptr<InodeWrapper> *out);
+
+    // remove entries of persisted files, return number of pending files
+    size_t ErasePersistedLocked();
+
+    // update the parent in cache after a child is created at |now|
+    void UpdateParentAfterCreate(uint64_t parentId, FsFileType type,
+                                 const struct timespec &now);
+
  private:
     std::shared_ptr<MetaServerClient> metaClient_;
     std::shared_ptr<S3ChunkInfoMetric> s3ChunkInfoMetric_;
@@ -179,6 +232,21 @@ class InodeCacheManagerImpl : public InodeCacheManager,
     curve::common::GenericNameLock<Mutex> asyncNameLock_;
 
     RefreshDataOption option_;
+
+    LocalCreateOption localCreateOption_;
+    std::unique_ptr<InodeIdAllocator> idAllocator_;
+
+    struct PendingNode {
+        Dentry dentry;
+        std::shared_ptr<InodeWrapper> inode;
+    };
+
+    // files created locally and not persisted yet, entries of persisted
+    // files are removed lazily
+    curve::common::Mutex pendingMtx_;
+    std::unordered_map<uint64_t, PendingNode> pendingInodes_;
+    // (parent, name) -> inode id
+    std::map<std::pair<uint64_t, std::string>, uint64_t> pendingDentries_;
 };
 
 class BatchGetInodeAttrAsyncDone : public BatchGetInodeAttrDone {
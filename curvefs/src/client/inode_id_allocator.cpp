@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-18
+ */
+
+#include "curvefs/src/client/inode_id_allocator.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace curvefs {
+namespace client {
+
+using ::curvefs::metaserver::MetaStatusCode_Name;
+
+InodeIdAllocator::InodeIdAllocator(
+    std::shared_ptr<MetaServerClient> metaClient, uint32_t leaseSize)
+    : metaClient_(std::move(metaClient)),
+      leaseSize_(std::max<uint32_t>(leaseSize, 1)) {}
+
+bool InodeIdAllocator::Allocate(uint32_t fsId, uint64_t parentId,
+                                uint64_t* inodeId) {
+    curve::common::UniqueLock lk(mtx_);
+    Partition* part = FindPartition(parentId);
+    // wait for the range being leased instead of leasing another one
+    while (part != nullptr && part->leasing && part->current.count == 0 &&
+           part->next.count == 0) {
+        cond_.wait(lk);
+    }
+
+    InodeIdLease lease;
+    if (part != nullptr && TakeId(part, inodeId)) {
+        if (part->leasing || part->next.count > 0 ||
+            part->current.count > leaseSize_ / 2) {
+            return true;
+        }
+
+        // half of the range is used, lease the next one
+        part->leasing = true;
+        lk.unlock();
+        bool ok = LeaseIds(fsId, parentId, &lease);
+        lk.lock();
+        part->leasing = false;
+        if (ok) {
+            SaveLease(lease);
+        }
+        cond_.notify_all();
+        return true;
+    }
+
+    // the partition has no lease yet or all its ids are used
+    if (part != nullptr) {
+        part->leasing = true;
+    }
+    lk.unlock();
+    bool ok = LeaseIds(fsId, parentId, &lease);
+    lk.lock();
+    if (part != nullptr) {
+        part->leasing = false;
+        cond_.notify_all();
+    }
+    if (!ok) {
+        return false;
+    }
+    *inodeId = lease.start++;
+    lease.count--;
+    SaveLease(lease);
+    return true;
+}
+
+InodeIdAllocator::Partition* InodeIdAllocator::FindPartition(
+    uint64_t parentId) {
+    auto iter = partitions_.lower_bound(parentId);
+    if (iter == partitions_.end() || iter->second.start > parentId) {
+        return nullptr;
+    }
+    return &iter->second;
+}
+
+bool InodeIdAllocator::TakeId(Partition* part, uint64_t* inodeId) {
+    if (part->current.count == 0) {
+        std::swap(part->current, part->next);
+    }
+    if (part->current.count == 0) {
+        return false;
+    }
+    *inodeId = part->current.start++;
+    part->current.count--;
+    return true;
+}
+
+void InodeIdAllocator::SaveLease(const InodeIdLease& lease) {
+    Partition& part = partitions_[lease.partitionEnd];
+    part.start = lease.partitionStart;
+    if (part.current.count == 0) {
+        part.current = lease;
+    } else if (part.next.count == 0) {
+        part.next = lease;
+    }
+    // otherwise both ranges are in use, ids of the lease are wasted
+}
+
+bool InodeIdAllocator::LeaseIds(uint32_t fsId, uint64_t parentId,
+                                InodeIdLease* lease) {
+    MetaStatusCode ret =
+        metaClient_->AllocInodeId(fsId, parentId, leaseSize_, lease);
+    if (ret != MetaStatusCode::OK) {
+        LOG_IF(WARNING, ret != MetaStatusCode::PARTITION_ALLOC_ID_FAIL)
+            << "Lease inode id failed, parent = " << parentId
+            << ", MetaStatusCode = " << ret
+            << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret);
+        return false;
+    } else if (lease->count == 0 || lease->partitionStart > parentId ||
+               lease->partitionEnd < parentId) {
+        LOG(ERROR) << "Lease inode id return invalid lease, parent = "
+                   << parentId << ", start = " << lease->start
+                   << ", count = " << lease->count
+                   << ", partition = [" << lease->partitionStart << ", "
+                   << lease->partitionEnd << "]";
+        return false;
+    }
+
+    VLOG(6) << "Lease inode id success, parent = " << parentId
+            << ", start = " << lease->start << ", count = " << lease->count;
+    return true;
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,96 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-18
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_INODE_ID_ALLOCATOR_H_
+#define CURVEFS_SRC_CLIENT_INODE_ID_ALLOCATOR_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "curvefs/src/client/rpcclient/metaserver_client.h"
+#include "src/common/concurrent/concurrent.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curvefs::client::rpcclient::InodeIdLease;
+using ::curvefs::client::rpcclient::MetaServerClient;
+
+/**
+ * Allocate inode ids on client from ranges leased from metaservers.
+ *
+ * Ids are leased from the partition of the parent, so the new inode and
+ * its dentry belong to the same partition and can be persisted together.
+ * Leased ids which are never used are wasted, it's fine because the
+ * partition is only a range of ids.
+ *
+ * Ranges are double buffered: when half of the current range is used, the
+ * next one is leased, so requests rarely wait for the lease rpc. The lock
+ * isn't held during the rpc, requests keep taking ids meanwhile.
+ */
+class InodeIdAllocator {
+ public:
+    InodeIdAllocator(std::shared_ptr<MetaServerClient> metaClient,
+                     uint32_t leaseSize);
+
+    /**
+     * @brief allocate an inode id in the partition of |parentId|
+     * @return false if the partition has no free inode id or the lease
+     *         request failed
+     */
+    bool Allocate(uint32_t fsId, uint64_t parentId, uint64_t* inodeId);
+
+ private:
+    struct Partition {
+        uint64_t start = 0;
+        // ids are taken from |current|, |next| is used when it runs out
+        InodeIdLease current;
+        InodeIdLease next;
+        // a lease rpc of the partition is in flight
+        bool leasing = false;
+    };
+
+    Partition* FindPartition(uint64_t parentId);
+
+    static bool TakeId(Partition* part, uint64_t* inodeId);
+
+    // save the lease of a partition, must hold |mtx_|
+    void SaveLease(const InodeIdLease& lease);
+
+    // lease ids from metaserver, without holding |mtx_|
+    bool LeaseIds(uint32_t fsId, uint64_t parentId, InodeIdLease* lease);
+
+ private:
+    std::shared_ptr<MetaServerClient> metaClient_;
+    uint32_t leaseSize_;
+
+    curve::common::Mutex mtx_;
+    // notified when a lease rpc finishes
+    curve::common::ConditionVariable cond_;
+    // partitions keyed by the end of partition range
+    std::map<uint64_t, Partition> partitions_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_INODE_ID_ALLOCATOR_H_
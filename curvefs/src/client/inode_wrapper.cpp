@@ -58,6 +58,26 @@ do {                                        \
     }                                       \
 } while (0)
 
+#define PERSIST_CREATE                      \
+do {                                        \
+    CURVEFS_ERROR ret = PersistCreate();    \
+    if (ret != CURVEFS_ERROR::OK) {         \
+        return ret;                         \
+    }                                       \
+} while (0)
+
+#define PERSIST_CREATE_ASYNC(DONE)                         \
+do {                                                       \
+    MetaStatusCode ret = DoPersistCreate();                \
+    if (ret != MetaStatusCode::OK) {                       \
+        if ((DONE) != nullptr) {                           \
+            (DONE)->SetMetaStatusCode(ret);                \
+            (DONE)->Run();                                 \
+        }                                                  \
+        return;                                            \
+    }                                                      \
+} while (0)
+
 std::ostream &operator<<(std::ostream &os, const struct stat &attr) {
     os << "{ st_ino = " << attr.st_ino << ", st_mode = " << attr.st_mode
        << ", st_nlink = " << attr.st_nlink << ", st_uid = " << attr.st_uid
@@ -182,6 +202,7 @@ void InodeWrapper::GetInodeAttr(InodeAttr *attr) {
 }
 
 CURVEFS_ERROR InodeWrapper::SyncAttr(bool internal) {
+    PERSIST_CREATE;
     curve::common::UniqueLock lock = GetSyncingInodeUniqueLock();
     if (dirty_) {
         MetaStatusCode ret = metaClient_->UpdateInodeAttrWithOutNlink(
@@ -222,6 +243,7 @@ CURVEFS_ERROR InodeWrapper::SyncS3ChunkInfo(bool internal) {
 
 void InodeWrapper::AsyncFlushAttr(MetaServerClientDone* done,
                                   bool /*internal*/) {
+    PERSIST_CREATE_ASYNC(done);
     if (dirty_) {
         LockSyncingInode();
         metaClient_->UpdateInodeWithOutNlinkAsync(
@@ -239,6 +261,11 @@ void InodeWrapper::AsyncFlushAttr(MetaServerClientDone* done,
 
 void InodeWrapper::FlushS3ChunkInfoAsync() {
     if (!s3ChunkInfoAdd_.empty()) {
+        // keep the chunk info, it will be synced later if the create is
+        // still pending, or dropped if the create failed
+        if (DoPersistCreate() != MetaStatusCode::OK) {
+            return;
+        }
         LockSyncingS3ChunkInfo();
          auto *done = new GetOrModifyS3ChunkInfoAsyncDone(shared_from_this());
         metaClient_->GetOrModifyS3ChunkInfoAsync(
@@ -309,6 +336,7 @@ CURVEFS_ERROR InodeWrapper::RefreshS3ChunkInfo() {
 
 CURVEFS_ERROR InodeWrapper::Link(uint64_t parent) {
     curve::common::UniqueLock lg(mtx_);
+    PERSIST_CREATE;
     REFRESH_NLINK;
     uint32_t old = inode_.nlink();
     inode_.set_nlink(old + 1);
@@ -340,6 +368,7 @@ CURVEFS_ERROR InodeWrapper::Link(uint64_t parent) {
 
 CURVEFS_ERROR InodeWrapper::UnLink(uint64_t parent) {
     curve::common::UniqueLock lg(mtx_);
+    PERSIST_CREATE;
     REFRESH_NLINK;
     uint32_t old = inode_.nlink();
     VLOG(1) << "Unlink inode = " << inode_.DebugString();
@@ -412,6 +441,7 @@ CURVEFS_ERROR InodeWrapper::UnLink(uint64_t parent) {
 CURVEFS_ERROR InodeWrapper::UpdateParent(
     uint64_t oldParent, uint64_t newParent) {
     curve::common::UniqueLock lg(mtx_);
+    PERSIST_CREATE;
     auto parents = inode_.mutable_parent();
     for (auto iter = parents->begin(); iter != parents->end(); iter++) {
         if (*iter == oldParent) {
@@ -437,6 +467,7 @@ CURVEFS_ERROR InodeWrapper::UpdateParent(
 }
 
 CURVEFS_ERROR InodeWrapper::Sync(bool internal) {
+    PERSIST_CREATE;
     CURVEFS_ERROR ret = CURVEFS_ERROR::OK;
     switch (inode_.type()) {
         case FsFileType::TYPE_S3:
@@ -460,6 +491,7 @@ CURVEFS_ERROR InodeWrapper::Sync(bool internal) {
 
 void InodeWrapper::Async(MetaServerClientDone *done, bool internal) {
     VLOG(9) << "async inode: " << inode_.ShortDebugString();
+    PERSIST_CREATE_ASYNC(done);
 
     switch (inode_.type()) {
         case FsFileType::TYPE_S3:
@@ -509,6 +541,7 @@ void InodeWrapper::AsyncFlushAttrAndExtents(MetaServerClientDone *done,
 }
 
 CURVEFS_ERROR InodeWrapper::SyncS3(bool internal) {
+    PERSIST_CREATE;
     curve::common::UniqueLock lock = GetSyncingInodeUniqueLock();
     curve::common::UniqueLock lockS3chunkInfo =
         GetSyncingS3ChunkInfoUniqueLock();
@@ -568,6 +601,7 @@ class UpdateInodeAsyncS3Done : public MetaServerClientDone {
 
 void InodeWrapper::AsyncS3(MetaServerClientDone *done, bool internal) {
     (void)internal;
+    PERSIST_CREATE_ASYNC(done);
     if (dirty_ || !s3ChunkInfoAdd_.empty()) {
         LockSyncingInode();
         LockSyncingS3ChunkInfo();
@@ -590,6 +624,113 @@ void InodeWrapper::AsyncS3(MetaServerClientDone *done, bool internal) {
     }
 }
 
+void InodeWrapper::AsyncInBatch(std::vector<InodeUpdate> *updates,
+                                bool internal) {
+    // the inode is pushed back to defer sync if the create is still pending,
+    // and the updates are sent after it's persisted
+    if (DoPersistCreate() != MetaStatusCode::OK) {
+        return;
+    }
+
+    if (inode_.type() == FsFileType::TYPE_FILE &&
+        extentCache_.HasDirtyExtents()) {
+        return AsyncFlushAttrAndExtents(nullptr, internal);
+    }
+
+    InodeUpdate update;
+    update.inodeId = inode_.inodeid();
+    if (inode_.type() == FsFileType::TYPE_S3) {
+        if (!dirty_ && s3ChunkInfoAdd_.empty()) {
+            return;
+        }
+        LockSyncingInode();
+        LockSyncingS3ChunkInfo();
+        if (!s3ChunkInfoAdd_.empty()) {
+            update.indices.s3ChunkInfoMap = std::move(s3ChunkInfoAdd_);
+        }
+        ClearS3ChunkInfoAdd();
+        update.done = new UpdateInodeAsyncS3Done(shared_from_this(), nullptr);
+    } else {
+        if (!dirty_) {
+            return;
+        }
+        LockSyncingInode();
+        update.done = new UpdateInodeAsyncDone(shared_from_this(), nullptr);
+    }
+
+    VLOG(9) << "async inode in batch: " << inode_.inodeid()
+            << ", dirty attr: " << dirtyAttr_.ShortDebugString();
+    update.attr = std::move(dirtyAttr_);
+    dirtyAttr_.Clear();
+    updates->emplace_back(std::move(update));
+}
+
+void InodeWrapper::SetPendingCreate(const Dentry &dentry,
+                                    const InodeParam &param,
+                                    const struct timespec &time) {
+    curve::common::LockGuard lk(createMtx_);
+    pendingCreate_.reset(new PendingCreate{dentry, param, time});
+    createPending_.store(true, std::memory_order_release);
+}
+
+CURVEFS_ERROR InodeWrapper::PersistCreate() {
+    MetaStatusCode ret = DoPersistCreate();
+    if (IsCreateFailed()) {
+        return CURVEFS_ERROR::IO_ERROR;
+    }
+    return ToFSError(ret);
+}
+
+MetaStatusCode InodeWrapper::DoPersistCreate() {
+    if (!createPending_.load(std::memory_order_acquire)) {
+        // nothing of the inode can be synced if it's not created
+        return IsCreateFailed() ? MetaStatusCode::NOT_FOUND
+                                : MetaStatusCode::OK;
+    }
+
+    curve::common::LockGuard lk(createMtx_);
+    if (pendingCreate_ == nullptr) {
+        return MetaStatusCode::OK;
+    }
+
+    Inode inode;
+    const Dentry &dentry = pendingCreate_->dentry;
+    MetaStatusCode ret = metaClient_->CreateNode(
+        dentry, &pendingCreate_->param, pendingCreate_->time, &inode);
+    if (ret == MetaStatusCode::DENTRY_EXIST) {
+        // it's persisted by an earlier attempt whose response was lost if
+        // the dentry refers to the inode
+        Dentry exist;
+        if (metaClient_->GetDentry(dentry.fsid(), dentry.parentinodeid(),
+                                   dentry.name(), &exist) ==
+                MetaStatusCode::OK &&
+            exist.inodeid() == dentry.inodeid()) {
+            ret = MetaStatusCode::OK;
+        }
+    }
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "metaClient_ CreateNode failed, MetaStatusCode = " << ret
+                   << ", MetaStatusCode_Name = " << MetaStatusCode_Name(ret)
+                   << ", dentry = " << dentry.ShortDebugString();
+        // retrying can't succeed, other errors are retried by the next sync
+        if (ret == MetaStatusCode::DENTRY_EXIST ||
+            ret == MetaStatusCode::INODE_EXIST ||
+            ret == MetaStatusCode::PARAM_ERROR) {
+            MarkInodeError();
+            createFailed_.store(true, std::memory_order_release);
+            pendingCreate_.reset();
+            createPending_.store(false, std::memory_order_release);
+        }
+        return ret;
+    }
+
+    VLOG(6) << "Persist inode created locally success, inodeid = "
+            << inode_.inodeid();
+    pendingCreate_.reset();
+    createPending_.store(false, std::memory_order_release);
+    return MetaStatusCode::OK;
+}
+
 CURVEFS_ERROR InodeWrapper::RefreshVolumeExtent() {
     VolumeExtentSliceList extents;
     auto st = metaClient_->GetVolumeExtent(inode_.fsid(), inode_.inodeid(),
@@ -670,5 +811,37 @@ void InodeWrapper::UpdateTimestampLocked(const timespec& now, int flags) {
     }
 }
 
+void InodeWrapper::ApplyPersistedTimestampLocked(const timespec& time,
+                                                 int flags) {
+    // pending timestamps are overwritten too, otherwise they would roll
+    // back the persisted ones once flushed
+    if (flags & kAccessTime) {
+        inode_.set_atime(time.tv_sec);
+        inode_.set_atime_ns(time.tv_nsec);
+        if (dirtyAttr_.has_atime()) {
+            dirtyAttr_.set_atime(time.tv_sec);
+            dirtyAttr_.set_atime_ns(time.tv_nsec);
+        }
+    }
+
+    if (flags & kChangeTime) {
+        inode_.set_ctime(time.tv_sec);
+        inode_.set_ctime_ns(time.tv_nsec);
+        if (dirtyAttr_.has_ctime()) {
+            dirtyAttr_.set_ctime(time.tv_sec);
+            dirtyAttr_.set_ctime_ns(time.tv_nsec);
+        }
+    }
+
+    if (flags & kModifyTime) {
+        inode_.set_mtime(time.tv_sec);
+        inode_.set_mtime_ns(time.tv_nsec);
+        if (dirtyAttr_.has_mtime()) {
+            dirtyAttr_.set_mtime(time.tv_sec);
+            dirtyAttr_.set_mtime_ns(time.tv_nsec);
+        }
+    }
+}
+
 }  // namespace client
 }  // namespace curvefs
@@ -26,11 +26,13 @@
 
 #include <sys/stat.h>
 #include <gtest/gtest_prod.h>
+#include <atomic>
 #include <climits>
 #include <cstdint>
 #include <utility>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "curvefs/src/common/define.h"
 #include "curvefs/proto/metaserver.pb.h"
@@ -61,9 +63,11 @@ enum class InodeStatus {
     kError = -1,
 };
 
+using rpcclient::InodeParam;
 using rpcclient::MetaServerClient;
 using rpcclient::MetaServerClientImpl;
 using rpcclient::MetaServerClientDone;
+using rpcclient::InodeUpdate;
 using metric::S3ChunkInfoMetric;
 using common::NlinkChange;
 using curve::common::TimeUtility;
@@ -91,6 +95,8 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
           metaClient_(std::move(metaClient)),
           s3ChunkInfoMetric_(std::move(s3ChunkInfoMetric)),
           dirty_(false),
+          createPending_(false),
+          createFailed_(false),
           time_(TimeUtility::GetTimeofDaySec()) {
         UpdateS3ChunkInfoMetric(CalS3ChunkInfoSize());
         g_alive_inode_count << 1;
@@ -181,6 +187,10 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
     void UpdateTimestampLocked(int flags);
     void UpdateTimestampLocked(const timespec& now, int flags);
 
+    // Apply timestamp which is already persisted by metaserver,
+    // so the inode doesn't become dirty.
+    void ApplyPersistedTimestampLocked(const timespec& time, int flags);
+
     // Merge incoming extended attributes.
     //
     // Existing attributes will be overwritten, new attributes well be inserted.
@@ -231,6 +241,13 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
 
     void AsyncS3(MetaServerClientDone *done, bool internal = false);
 
+    // Like Async(), but the update of attributes and s3 chunk infos is
+    // appended to |updates| to be sent with other inodes in a batch,
+    // volume extents are still flushed by the inode itself.
+    // REQUIRES: |mtx_| is held
+    void AsyncInBatch(std::vector<InodeUpdate> *updates,
+                      bool internal = false);
+
     CURVEFS_ERROR SyncAttr(bool internal = false);
 
     void AsyncFlushAttr(MetaServerClientDone *done, bool internal);
@@ -239,6 +256,25 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
 
     CURVEFS_ERROR RefreshS3ChunkInfo();
 
+    // The inode is created on client with a leased inode id, and it's
+    // persisted with |dentry| before anything of it is synced.
+    void SetPendingCreate(const Dentry &dentry, const InodeParam &param,
+                          const struct timespec &time);
+
+    bool IsCreatePending() const {
+        return createPending_.load(std::memory_order_acquire);
+    }
+
+    // The inode created locally can't be persisted, e.g. the name is taken
+    // by another client meanwhile, and the data written to it is lost.
+    bool IsCreateFailed() const {
+        return createFailed_.load(std::memory_order_acquire);
+    }
+
+    // Persist the inode and its dentry if it's created locally,
+    // IO_ERROR is returned if it can't be persisted
+    CURVEFS_ERROR PersistCreate();
+
     CURVEFS_ERROR Open();
 
     bool IsOpen();
@@ -390,6 +426,8 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
     CURVEFS_ERROR FlushVolumeExtent();
     void FlushVolumeExtentAsync();
 
+    MetaStatusCode DoPersistCreate();
+
  private:
     FRIEND_TEST(TestInodeWrapper, TestUpdateInodeAttrIncrementally);
 
@@ -419,6 +457,18 @@ class InodeWrapper : public std::enable_shared_from_this<InodeWrapper> {
     mutable ::curve::common::Mutex syncingVolumeExtentsMtx_;
     ExtentCache extentCache_;
 
+    struct PendingCreate {
+        Dentry dentry;
+        InodeParam param;
+        struct timespec time;
+    };
+
+    // inode created locally and not persisted yet
+    std::atomic<bool> createPending_;
+    std::atomic<bool> createFailed_;
+    std::unique_ptr<PendingCreate> pendingCreate_;
+    ::curve::common::Mutex createMtx_;
+
     // timestamp when put in cache
     uint64_t time_;
 };
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-26
+ */
+
+#include "curvefs/src/client/kvclient/consistent_hash_ring.h"
+
+#include <butil/third_party/murmurhash3/murmurhash3.h>
+#include <butil/time.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace curvefs {
+namespace client {
+
+ConsistentHashRing::ConsistentHashRing(uint32_t virtualNodes,
+                                       uint32_t failureLimit,
+                                       uint32_t retryIntervalMs)
+    : virtualNodes_(std::max<uint32_t>(virtualNodes, 1)),
+      failureLimit_(std::max<uint32_t>(failureLimit, 1)),
+      retryIntervalMs_(retryIntervalMs) {}
+
+uint32_t ConsistentHashRing::Hash(const std::string& key) {
+    uint32_t hash = 0;
+    butil::MurmurHash3_x86_32(key.data(), static_cast<int>(key.size()), 0,
+                              &hash);
+    return hash;
+}
+
+uint32_t ConsistentHashRing::AddServer(const std::string& name) {
+    uint32_t index = static_cast<uint32_t>(servers_.size());
+    servers_.emplace_back(new ServerState());
+    servers_.back()->name = name;
+
+    for (uint32_t i = 0; i < virtualNodes_; i++) {
+        ring_.emplace_back(Hash(name + "#" + std::to_string(i)), index);
+    }
+    std::sort(ring_.begin(), ring_.end());
+    return index;
+}
+
+bool ConsistentHashRing::Lookup(const std::string& key,
+                                uint32_t* server) const {
+    if (ring_.empty()) {
+        return false;
+    }
+
+    auto hash = Hash(key);
+    auto iter = std::upper_bound(
+        ring_.begin(), ring_.end(), hash,
+        [](uint32_t h, const std::pair<uint32_t, uint32_t>& node) {
+            return h < node.first;
+        });
+    size_t pos = iter - ring_.begin();
+
+    // skip the ejected servers clockwise
+    for (size_t i = 0; i < ring_.size(); i++) {
+        const auto& node = ring_[(pos + i) % ring_.size()];
+        if (IsHealthy(node.second)) {
+            *server = node.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConsistentHashRing::IsHealthy(uint32_t server) const {
+    const auto& state = servers_[server];
+    if (state->failures.load(std::memory_order_relaxed) < failureLimit_) {
+        return true;
+    }
+    return butil::monotonic_time_ms() >=
+           static_cast<int64_t>(
+               state->ejectUntilMs.load(std::memory_order_relaxed));
+}
+
+void ConsistentHashRing::OnSuccess(uint32_t server) {
+    auto& state = servers_[server];
+    if (state->failures.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    auto failures = state->failures.exchange(0);
+    LOG_IF(INFO, failures >= failureLimit_)
+        << "Cache server " << state->name << " is back to the ring";
+}
+
+void ConsistentHashRing::OnFailure(uint32_t server) {
+    auto& state = servers_[server];
+    auto failures = state->failures.fetch_add(1) + 1;
+    if (failures >= failureLimit_) {
+        state->ejectUntilMs.store(butil::monotonic_time_ms() +
+                                  retryIntervalMs_);
+        LOG_IF(WARNING, failures == failureLimit_)
+            << "Cache server " << state->name << " is ejected from the ring"
+            << " after " << failures << " continuous failures";
+    }
+}
+
+}  // namespace client
+}  // namespace curvefs
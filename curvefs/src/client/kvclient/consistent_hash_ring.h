@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-26
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_KVCLIENT_CONSISTENT_HASH_RING_H_
+#define CURVEFS_SRC_CLIENT_KVCLIENT_CONSISTENT_HASH_RING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace curvefs {
+namespace client {
+
+/**
+ * Consistent hash ring which maps keys to cache servers.
+ *
+ * Every server is placed on the ring with several virtual nodes, a key
+ * belongs to the first server clockwise from its hash. The hash only
+ * depends on the server names, so all clients of a cluster agree on the
+ * owner of a key.
+ *
+ * A server is ejected after `failureLimit` continuous failures, its keys
+ * fall to the next healthy server on the ring. After `retryIntervalMs`
+ * the server is tried again, a success brings it back while a failure
+ * ejects it for another interval.
+ *
+ * Servers must be added before the ring is used, lookups and health
+ * updates are thread safe.
+ */
+class ConsistentHashRing {
+ public:
+    ConsistentHashRing(uint32_t virtualNodes, uint32_t failureLimit,
+                       uint32_t retryIntervalMs);
+
+    /**
+     * @brief add a server to the ring
+     * @return index of the server
+     */
+    uint32_t AddServer(const std::string& name);
+
+    /**
+     * @brief find the healthy server which the key belongs to
+     * @return false if there is no healthy server
+     */
+    bool Lookup(const std::string& key, uint32_t* server) const;
+
+    void OnSuccess(uint32_t server);
+
+    void OnFailure(uint32_t server);
+
+    bool IsHealthy(uint32_t server) const;
+
+    uint32_t ServerCount() const {
+        return static_cast<uint32_t>(servers_.size());
+    }
+
+ private:
+    struct ServerState {
+        std::string name;
+        std::atomic<uint32_t> failures{0};
+        // the server is ejected until this time
+        std::atomic<uint64_t> ejectUntilMs{0};
+    };
+
+    static uint32_t Hash(const std::string& key);
+
+ private:
+    uint32_t virtualNodes_;
+    uint32_t failureLimit_;
+    uint32_t retryIntervalMs_;
+    // (hash, server) sorted by hash
+    std::vector<std::pair<uint32_t, uint32_t>> ring_;
+    std::vector<std::unique_ptr<ServerState>> servers_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_KVCLIENT_CONSISTENT_HASH_RING_H_
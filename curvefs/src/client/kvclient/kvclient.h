@@ -22,7 +22,9 @@
 #ifndef CURVEFS_SRC_CLIENT_KVCLIENT_KVCLIENT_H_
 #define CURVEFS_SRC_CLIENT_KVCLIENT_KVCLIENT_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace curvefs {
 
@@ -51,6 +53,20 @@ class KVClient {
 
     virtual bool Get(const std::string &key, char *value, uint64_t offset,
                      uint64_t length, std::string *errorlog) = 0;
+
+    /**
+     * @brief get the whole values of several keys in one round trip.
+     * @param: values: values[i] is the value of keys[i],
+     *         nullptr if the key is not found or failed.
+     * @return: false if batched get is not supported by the client,
+     *          the caller should get the keys one by one.
+     */
+    virtual bool MultiGet(const std::vector<std::string> &keys,
+                          std::vector<std::shared_ptr<std::string>> *values) {
+        (void)keys;
+        (void)values;
+        return false;
+    }
 };
 
 }  // namespace client
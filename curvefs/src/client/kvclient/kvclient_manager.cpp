@@ -21,11 +21,16 @@
  */
 
 #include "curvefs/src/client/kvclient/kvclient_manager.h"
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <vector>
 #include "src/client/client_metric.h"
 #include "src/common/concurrent/count_down_event.h"
 
 using curve::client::LatencyGuard;
+using curve::common::CacheMetrics;
 using curve::common::CountDownEvent;
 using curvefs::client::metric::KVClientMetric;
 
@@ -39,9 +44,59 @@ namespace client {
         kvClientMetric_.kvClient##TYPE.eps.count << 1;                        \
     }                                                                          \
 
+bool NearCache::Get(const std::string &key,
+                    std::shared_ptr<std::string> *value) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+        metrics_->OnCacheMiss();
+        return false;
+    }
+
+    metrics_->OnCacheHit();
+    items_.splice(items_.begin(), items_, iter->second);
+    *value = iter->second->second;
+    return true;
+}
+
+void NearCache::Put(const std::string &key,
+                    const std::shared_ptr<std::string> &value) {
+    uint64_t size = key.size() + value->size();
+    if (size > capacityBytes_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+        Remove(iter->second);
+    }
+    while (bytes_ + size > capacityBytes_) {
+        Remove(std::prev(items_.end()));
+    }
+
+    items_.emplace_front(key, value);
+    index_[key] = items_.begin();
+    bytes_ += size;
+    metrics_->UpdateAddToCacheCount();
+    metrics_->UpdateAddToCacheBytes(size);
+}
+
+void NearCache::Remove(std::list<Item>::iterator iter) {
+    uint64_t size = iter->first.size() + iter->second->size();
+    bytes_ -= size;
+    metrics_->UpdateRemoveFromCacheCount();
+    metrics_->UpdateRemoveFromCacheBytes(size);
+    index_.erase(iter->first);
+    items_.erase(iter);
+}
+
 bool KVClientManager::Init(const KVClientManagerOpt &config,
                            const std::shared_ptr<KVClient> &kvclient) {
     client_ = kvclient;
+    if (config.nearCacheCapacityBytes > 0) {
+        nearCache_.reset(new NearCache(config.nearCacheCapacityBytes));
+    }
     return threadPool_.Start(config.setThreadPooln) == 0;
 }
 
@@ -67,14 +122,84 @@ void KVClientManager::Get(std::shared_ptr<GetKVCacheTask> task) {
     threadPool_.Enqueue([task, this]() {
         LatencyGuard guard(&kvClientMetric_.kvClientGet.latency);
 
-        std::string error_log;
-        task->res = client_->Get(task->key, task->value, task->offset,
-                                task->length, &error_log);
+        GetInternal({task.get()});
         ONRETURN(Get, task->res);
 
         task->done(task);
     });
 }
 
+void KVClientManager::MultiGet(std::shared_ptr<MultiGetKVCacheTask> task) {
+    threadPool_.Enqueue([task, this]() {
+        LatencyGuard guard(&kvClientMetric_.kvClientMultiGet.latency);
+
+        std::vector<GetKVCacheTask *> tasks;
+        tasks.reserve(task->tasks.size());
+        for (const auto &t : task->tasks) {
+            tasks.push_back(t.get());
+        }
+        GetInternal(tasks);
+        for (const auto &t : task->tasks) {
+            ONRETURN(Get, t->res);
+        }
+        kvClientMetric_.kvClientMultiGet.qps.count << 1;
+
+        task->done(task);
+    });
+}
+
+bool KVClientManager::GetFromNearCache(GetKVCacheTask *task) {
+    std::shared_ptr<std::string> value;
+    if (!nearCache_ || !nearCache_->Get(task->key, &value) ||
+        value->size() < task->offset + task->length) {
+        return false;
+    }
+    memcpy(task->value, value->data() + task->offset, task->length);
+    return true;
+}
+
+void KVClientManager::GetInternal(const std::vector<GetKVCacheTask *> &tasks) {
+    std::vector<GetKVCacheTask *> misses;
+    std::vector<std::string> keys;
+    for (auto *task : tasks) {
+        task->res = GetFromNearCache(task);
+        if (!task->res) {
+            misses.push_back(task);
+            keys.push_back(task->key);
+        }
+    }
+    if (misses.empty()) {
+        return;
+    }
+
+    // a single key is got by range unless the whole value is wanted
+    // by the near cache
+    std::string error_log;
+    std::vector<std::shared_ptr<std::string>> values;
+    if ((misses.size() == 1 && !nearCache_) ||
+        !client_->MultiGet(keys, &values)) {
+        for (auto *task : misses) {
+            task->res = client_->Get(task->key, task->value, task->offset,
+                                     task->length, &error_log);
+        }
+        return;
+    }
+
+    values.resize(misses.size());
+    for (size_t i = 0; i < misses.size(); i++) {
+        auto *task = misses[i];
+        const auto &value = values[i];
+        if (value == nullptr ||
+            value->size() < task->offset + task->length) {
+            continue;
+        }
+        memcpy(task->value, value->data() + task->offset, task->length);
+        task->res = true;
+        if (nearCache_) {
+            nearCache_->Put(task->key, value);
+        }
+    }
+}
+
 }  // namespace client
 }  // namespace curvefs
@@ -25,16 +25,21 @@
 
 #include <bthread/condition_variable.h>
 
+#include <list>
+#include <mutex>
 #include <thread>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "curvefs/src/client/kvclient/kvclient.h"
 #include "curvefs/src/client/common/config.h"
 #include "curvefs/src/client/metric/client_metric.h"
 #include "src/common/concurrent/task_thread_pool.h"
+#include "src/common/lru_cache.h"
 #include "src/common/s3_adapter.h"
 
 using curvefs::client::metric::KVClientMetric;
@@ -45,6 +50,8 @@ namespace client {
 class KVClientManager;
 class SetKVCacheTask;
 class GetKVCacheTask;
+class MultiGetKVCacheTask;
+using curve::common::CacheMetrics;
 using curve::common::TaskThreadPool;
 using curvefs::client::common::KVClientManagerOpt;
 
@@ -52,6 +59,8 @@ typedef std::function<void(const std::shared_ptr<SetKVCacheTask> &)>
     SetKVCacheDone;
 typedef std::function<void(const std::shared_ptr<GetKVCacheTask> &)>
     GetKVCacheDone;
+typedef std::function<void(const std::shared_ptr<MultiGetKVCacheTask> &)>
+    MultiGetKVCacheDone;
 
 struct SetKVCacheTask {
     std::string key;
@@ -78,6 +87,44 @@ struct GetKVCacheTask {
     }
 };
 
+// get several keys in one batch, e.g. all blocks of a read
+struct MultiGetKVCacheTask {
+    std::vector<std::shared_ptr<GetKVCacheTask>> tasks;
+    MultiGetKVCacheDone done;
+    MultiGetKVCacheTask() {
+        done = [](const std::shared_ptr<MultiGetKVCacheTask> &) {};
+    }
+};
+
+// LRU cache of whole values bounded by bytes of keys and values.
+// the keys are names of immutable objects, so the values never become stale
+class NearCache {
+ public:
+    explicit NearCache(uint64_t capacityBytes)
+        : capacityBytes_(capacityBytes), bytes_(0),
+          metrics_(std::make_shared<CacheMetrics>("kvclient_near_cache")) {}
+
+    bool Get(const std::string &key, std::shared_ptr<std::string> *value);
+
+    // values larger than the capacity are not cached
+    void Put(const std::string &key,
+             const std::shared_ptr<std::string> &value);
+
+ private:
+    using Item = std::pair<std::string, std::shared_ptr<std::string>>;
+
+    void Remove(std::list<Item>::iterator iter);
+
+ private:
+    const uint64_t capacityBytes_;
+    uint64_t bytes_;
+    std::mutex mtx_;
+    // most recently used first
+    std::list<Item> items_;
+    std::unordered_map<std::string, std::list<Item>::iterator> index_;
+    std::shared_ptr<CacheMetrics> metrics_;
+};
+
 class KVClientManager {
  public:
     KVClientManager() = default;
@@ -95,15 +142,29 @@ class KVClientManager {
 
     void Get(std::shared_ptr<GetKVCacheTask> task);
 
+    /**
+     * Get all keys of the task in one round trip to each server,
+     * res of every sub task tells whether it is found.
+     */
+    void MultiGet(std::shared_ptr<MultiGetKVCacheTask> task);
+
     KVClientMetric *GetClientMetricForTesting() { return &kvClientMetric_; }
 
  private:
     void Uninit();
 
+    // get tasks from the near cache first, then from the kv cluster
+    void GetInternal(const std::vector<GetKVCacheTask *> &tasks);
+
+    bool GetFromNearCache(GetKVCacheTask *task);
+
  private:
     TaskThreadPool<bthread::Mutex, bthread::ConditionVariable> threadPool_;
     std::shared_ptr<KVClient> client_;
     KVClientMetric kvClientMetric_;
+
+    // recently read values, nullptr if disabled
+    std::unique_ptr<NearCache> nearCache_;
 };
 
 }  // namespace client
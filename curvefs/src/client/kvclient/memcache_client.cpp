@@ -22,10 +22,237 @@
 
 #include "curvefs/src/client/kvclient/memcache_client.h"
 
+#include <atomic>
+
+#include "absl/strings/string_view.h"
+
 namespace curvefs {
 namespace client {
 
-thread_local memcached_st* tcli = nullptr;
+thread_local ThreadLocalMemcached tcli;
+
+namespace {
+std::atomic<uint64_t> nextClientId{1};
+}  // namespace
+
+void ThreadLocalMemcached::Reset(uint64_t id, size_t count) {
+    for (auto *cli : clients) {
+        if (cli != nullptr) {
+            memcached_free(cli);
+        }
+    }
+    clients.assign(count, nullptr);
+    owner = id;
+}
+
+MemCachedClient::MemCachedClient(const MemcacheClientOpt &option)
+    : id_(nextClientId.fetch_add(1)), option_(option) {}
+
+bool MemCachedClient::Init(const MemcacheClusterInfo &kvcachecluster) {
+    for (int i = 0; i < kvcachecluster.servers_size(); i++) {
+        if (!AddServer(kvcachecluster.servers(i).ip(),
+                       kvcachecluster.servers(i).port())) {
+            return false;
+        }
+    }
+    return PushServer();
+}
+
+void MemCachedClient::UnInit() {
+    for (auto *cli : clients_) {
+        memcached_free(cli);
+    }
+    clients_.clear();
+    ring_.reset();
+}
+
+bool MemCachedClient::AddServer(const std::string &hostname,
+                                const uint32_t port) {
+    if (hostname.empty()) {
+        LOG(ERROR) << "client add " << hostname << " " << port << " error";
+        return false;
+    }
+    servers_.emplace_back(hostname, port);
+    return true;
+}
+
+bool MemCachedClient::PushServer() {
+    UnInit();
+    std::unique_ptr<ConsistentHashRing> ring(new ConsistentHashRing(
+        option_.virtualNodes, option_.serverFailureLimit,
+        option_.serverRetryIntervalMs));
+    for (const auto &server : servers_) {
+        memcached_st *cli = memcached(nullptr, 0);
+        memcached_return_t res =
+            memcached_server_add(cli, server.first.c_str(), server.second);
+        if (MEMCACHED_SUCCESS != res) {
+            LOG(ERROR) << "client push " << server.first << " "
+                       << server.second << " error = " << ResError(res);
+            memcached_free(cli);
+            UnInit();
+            return false;
+        }
+        memcached_behavior_set(cli, MEMCACHED_BEHAVIOR_RETRY_TIMEOUT, 5);
+        clients_.push_back(cli);
+        ring->AddServer(server.first + ":" + std::to_string(server.second));
+    }
+    ring_ = std::move(ring);
+    return true;
+}
+
+memcached_st *MemCachedClient::GetClient(uint32_t server) {
+    // multi thread use a memcached_st* client is unsafe.
+    // should clone it or use memcached_st_pool.
+    if (tcli.owner != id_ || tcli.clients.size() != clients_.size()) {
+        tcli.Reset(id_, clients_.size());
+    }
+    if (nullptr == tcli.clients[server]) {
+        tcli.clients[server] = memcached_clone(nullptr, clients_[server]);
+    }
+    return tcli.clients[server];
+}
+
+void MemCachedClient::OnResult(uint32_t server, memcached_return_t res) {
+    if (!memcached_fatal(res)) {
+        ring_->OnSuccess(server);
+        return;
+    }
+    ring_->OnFailure(server);
+    // the connection may be broken, clone a new client next time
+    memcached_free(tcli.clients[server]);
+    tcli.clients[server] = nullptr;
+}
+
+bool MemCachedClient::Set(const std::string &key, const char *value,
+                          const uint64_t value_len, std::string *errorlog) {
+    uint32_t server = 0;
+    if (!ring_ || !ring_->Lookup(key, &server)) {
+        *errorlog = "no available server";
+        LOG(ERROR) << "Set key = " << key << " error = " << *errorlog;
+        return false;
+    }
+
+    auto res = memcached_set(GetClient(server), key.c_str(), key.length(),
+                             value, value_len, 0, 0);
+    OnResult(server, res);
+    if (MEMCACHED_SUCCESS == res) {
+        VLOG(9) << "Set key = " << key << " OK";
+        return true;
+    }
+    *errorlog = ResError(res);
+    LOG(ERROR) << "Set key = " << key << " error = " << *errorlog;
+    return false;
+}
+
+bool MemCachedClient::Get(const std::string &key, char *value,
+                          uint64_t offset, uint64_t length,
+                          std::string *errorlog) {
+    uint32_t server = 0;
+    if (!ring_ || !ring_->Lookup(key, &server)) {
+        *errorlog = "no available server";
+        return false;
+    }
+
+    uint32_t flags = 0;
+    size_t value_length = 0;
+    memcached_return_t ue;
+    char *res = memcached_get(GetClient(server), key.c_str(), key.length(),
+                              &value_length, &flags, &ue);
+    OnResult(server, ue);
+    if (MEMCACHED_SUCCESS == ue && res != nullptr && value &&
+        value_length >= offset + length) {
+        VLOG(9) << "Get key = " << key << " OK";
+        memcpy(value, res + offset, length);
+        free(res);
+        return true;
+    }
+    free(res);
+
+    *errorlog = ResError(ue);
+    if (ue != MEMCACHED_NOTFOUND) {
+        LOG(ERROR) << "Get key = " << key << " error = " << *errorlog
+                   << ", get_value_len = " << value_length
+                   << ", expect_value_len = " << offset + length;
+    }
+    return false;
+}
+
+bool MemCachedClient::MultiGet(
+    const std::vector<std::string> &keys,
+    std::vector<std::shared_ptr<std::string>> *values) {
+    values->assign(keys.size(), nullptr);
+    if (!ring_) {
+        return true;
+    }
+
+    std::vector<std::vector<size_t>> groups(clients_.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        uint32_t server = 0;
+        if (ring_->Lookup(keys[i], &server)) {
+            groups[server].push_back(i);
+        }
+    }
+
+    // send all requests first, then read the responses
+    std::vector<bool> sent(clients_.size(), false);
+    for (uint32_t server = 0; server < groups.size(); server++) {
+        const auto &indexes = groups[server];
+        if (indexes.empty()) {
+            continue;
+        }
+        std::vector<const char *> ptrs;
+        std::vector<size_t> lens;
+        ptrs.reserve(indexes.size());
+        lens.reserve(indexes.size());
+        for (auto index : indexes) {
+            ptrs.push_back(keys[index].c_str());
+            lens.push_back(keys[index].length());
+        }
+        auto res = memcached_mget(GetClient(server), ptrs.data(), lens.data(),
+                                  indexes.size());
+        if (MEMCACHED_SUCCESS != res) {
+            LOG(ERROR) << "MultiGet " << indexes.size() << " keys from "
+                       << "server " << server << " error = " << ResError(res);
+            OnResult(server, res);
+            continue;
+        }
+        sent[server] = true;
+    }
+
+    for (uint32_t server = 0; server < groups.size(); server++) {
+        if (sent[server]) {
+            FetchResults(server, keys, groups[server], values);
+        }
+    }
+    return true;
+}
+
+void MemCachedClient::FetchResults(
+    uint32_t server, const std::vector<std::string> &keys,
+    const std::vector<size_t> &indexes,
+    std::vector<std::shared_ptr<std::string>> *values) {
+    memcached_st *cli = GetClient(server);
+    memcached_return_t res = MEMCACHED_SUCCESS;
+    memcached_result_st *result = nullptr;
+    while ((result = memcached_fetch_result(cli, nullptr, &res)) != nullptr) {
+        absl::string_view key(memcached_result_key_value(result),
+                              memcached_result_key_length(result));
+        auto value = std::make_shared<std::string>(
+            memcached_result_value(result), memcached_result_length(result));
+        for (auto index : indexes) {
+            if (keys[index] == key) {
+                (*values)[index] = value;
+            }
+        }
+        memcached_result_free(result);
+    }
+
+    // MEMCACHED_END means all responses are read
+    OnResult(server, res);
+    LOG_IF(ERROR, memcached_fatal(res))
+        << "MultiGet fetch from server " << server
+        << " error = " << ResError(res);
+}
 
 }  // namespace client
 }  // namespace curvefs
@@ -27,9 +27,15 @@
 #include <libmemcached-1.0/memcached.h>
 #include <libmemcached-1.0/types/return.h>
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "curvefs/src/client/kvclient/consistent_hash_ring.h"
 #include "curvefs/src/client/kvclient/kvclient.h"
+#include "curvefs/src/client/common/config.h"
 #include "curvefs/proto/topology.pb.h"
 
 namespace curvefs {
@@ -37,12 +43,24 @@ namespace curvefs {
 namespace client {
 
 using curvefs::mds::topology::MemcacheClusterInfo;
+using curvefs::client::common::MemcacheClientOpt;
 
 /**
  * only the threadpool will operate the kvclient,
- * for threadsafe and fast, we can make every thread has a client.
+ * for threadsafe and fast, we can make every thread has a client
+ * for every server.
  */
-extern thread_local memcached_st *tcli;
+struct ThreadLocalMemcached {
+    // id of the MemCachedClient which the clients cloned from
+    uint64_t owner = 0;
+    std::vector<memcached_st *> clients;
+
+    void Reset(uint64_t id, size_t count);
+
+    ~ThreadLocalMemcached() { Reset(0, 0); }
+};
+
+extern thread_local ThreadLocalMemcached tcli;
 
 /**
  * MemCachedClient is a client to memcached cluster. You'd better
@@ -56,9 +74,6 @@ extern thread_local memcached_st *tcli;
  * if (!ue) {...}
  * ue = client->PushServer();
  * if (!ue) {...}
- * uint64_t data;
- * client->SetClientAttr(MEMCACHED_BEHAVIOR_NO_BLOCK, data);
- * client->SetClientAttr(MEMCACHED_BEHAVIOR_TCP_NODELAY, data);
  * KVClientManager manager;
  * config.kvclient = std::move(client_);
  * config.threadPooln = n;
@@ -73,88 +88,34 @@ extern thread_local memcached_st *tcli;
  * if (!ue) {...}
  * then ...
  * manager.Unint();
+ *
+ * Keys are distributed over servers by a consistent hash ring, see
+ * ConsistentHashRing. Every server has its own memcached_st, so a failed
+ * server can be ejected without affecting the others.
  */
 
 class MemCachedClient : public KVClient {
  public:
-    MemCachedClient() : server_(nullptr) {
-        client_ = memcached_create(nullptr);
-    }
-    explicit MemCachedClient(memcached_st *cli) : client_(cli) {}
+    explicit MemCachedClient(
+        const MemcacheClientOpt &option = MemcacheClientOpt());
     ~MemCachedClient() { UnInit(); }
 
-    bool Init(const MemcacheClusterInfo &kvcachecluster) {
-        client_ = memcached(nullptr, 0);
+    bool Init(const MemcacheClusterInfo &kvcachecluster);
 
-        for (int i = 0; i < kvcachecluster.servers_size(); i++) {
-            if (!AddServer(kvcachecluster.servers(i).ip(),
-                           kvcachecluster.servers(i).port())) {
-                return false;
-            }
-        }
-        memcached_behavior_set(client_, MEMCACHED_BEHAVIOR_DISTRIBUTION,
-                               MEMCACHED_DISTRIBUTION_CONSISTENT);
-        memcached_behavior_set(client_, MEMCACHED_BEHAVIOR_RETRY_TIMEOUT, 5);
-
-        return PushServer();
-    }
-
-    void UnInit() override {
-        if (client_) {
-            memcached_free(client_);
-            client_ = nullptr;
-        }
-    }
+    void UnInit() override;
 
     bool Set(const std::string &key, const char *value,
-             const uint64_t value_len, std::string *errorlog) override {
-        if (nullptr == tcli) {
-            tcli = memcached_clone(nullptr, client_);
-        }
-        auto res = memcached_set(tcli, key.c_str(), key.length(), value,
-                                 value_len, 0, 0);
-        if (MEMCACHED_SUCCESS == res) {
-            VLOG(9) << "Set key = " << key << " OK";
-            return true;
-        }
-        *errorlog = ResError(res);
-        memcached_free(tcli);
-        tcli = nullptr;
-        LOG(ERROR) << "Set key = " << key << " error = " << *errorlog;
-        return false;
-    }
+             const uint64_t value_len, std::string *errorlog) override;
 
     bool Get(const std::string &key, char *value, uint64_t offset,
-             uint64_t length, std::string *errorlog) override {
-        if (nullptr == tcli) {
-            // multi thread use a memcached_st* client is unsafe.
-            // should clone it or use memcached_st_pool.
-            tcli = memcached_clone(nullptr, client_);
-        }
-        uint32_t flags = 0;
-        size_t value_length = 0;
-        memcached_return_t ue;
-        char *res = memcached_get(tcli, key.c_str(), key.length(),
-                                  &value_length, &flags, &ue);
-        if (MEMCACHED_SUCCESS == ue && res != nullptr && value &&
-            value_length >= length) {
-            VLOG(9) << "Get key = " << key << " OK";
-            memcpy(value, res + offset, length);
-            free(res);
-            return true;
-        }
-
-        *errorlog = ResError(ue);
-        if (ue != MEMCACHED_NOTFOUND) {
-          LOG(ERROR) << "Get key = " << key << " error = " << *errorlog
-                     << ", get_value_len = " << value_length
-                     << ", expect_value_len = " << length;
-          memcached_free(tcli);
-          tcli = nullptr;
-        }
-
-        return false;
-    }
+             uint64_t length, std::string *errorlog) override;
+
+    /**
+     * keys are grouped by server, requests are sent to all servers
+     * before any response is read, so the round trips overlap.
+     */
+    bool MultiGet(const std::vector<std::string> &keys,
+                  std::vector<std::shared_ptr<std::string>> *values) override;
 
     // transform the res to a error string
     const std::string ResError(const memcached_return_t res) {
@@ -165,40 +126,37 @@ class MemCachedClient : public KVClient {
      * @brief: add a remote memcache server to client,
      * this means just add, you must use push after all server add.
      */
-    bool AddServer(const std::string &hostname, const uint32_t port) {
-        memcached_return_t res;
-        server_ =
-            memcached_server_list_append(server_, hostname.c_str(), port, &res);
-        if (MEMCACHED_SUCCESS == res) {
-            return true;
-        }
-        LOG(ERROR) << "client add " << hostname << " " << port << " error";
-        return false;
-    }
+    bool AddServer(const std::string &hostname, const uint32_t port);
 
     /**
      * @brief: push the server list to the client
      */
-    bool PushServer() {
-        memcached_return_t res = memcached_server_push(client_, server_);
-        if (MEMCACHED_SUCCESS == res) {
-            return true;
-        }
-        memcached_server_list_free(server_);
-        server_ = nullptr;
-        return false;
-    }
+    bool PushServer();
 
     /**
      * @return: return this client number of remote servers
      */
-    int ServerCount() {
-        return static_cast<int>(memcached_server_count(client_));
-    }
+    int ServerCount() { return static_cast<int>(clients_.size()); }
+
+ private:
+    // get the client of this thread to the server
+    memcached_st *GetClient(uint32_t server);
+
+    // update the health of server by the result of request
+    void OnResult(uint32_t server, memcached_return_t res);
+
+    // fetch the responses of a multi get from server
+    void FetchResults(uint32_t server, const std::vector<std::string> &keys,
+                      const std::vector<size_t> &indexes,
+                      std::vector<std::shared_ptr<std::string>> *values);
 
  private:
-    memcached_server_st *server_;
-    memcached_st *client_;
+    const uint64_t id_;
+    MemcacheClientOpt option_;
+    std::vector<std::pair<std::string, uint32_t>> servers_;
+    // one client per server, only used to be cloned by threads
+    std::vector<memcached_st *> clients_;
+    std::unique_ptr<ConsistentHashRing> ring_;
 };
 
 }  //  namespace client
@@ -91,6 +91,9 @@ bool LeaseExecutor::RefreshLease() {
                   [&](const PartitionTxId &item) {
                       metaCache_->SetTxId(item.partitionid(), item.txid());
                   });
+    if (!latestTxIdList.empty() && txIdChangedCallback_) {
+        txIdChangedCallback_();
+    }
     return true;
 }
 
@@ -26,6 +26,8 @@
 #include <memory>
 #include <string>
 #include <atomic>
+#include <functional>
+#include <utility>
 
 #include "curvefs/src/client/rpcclient/metacache.h"
 #include "curvefs/src/client/rpcclient/mds_client.h"
@@ -69,6 +71,11 @@ class LeaseExecutor : public LeaseExecutorBase {
        mountpoint_ = mp;
     }
 
+    // called after the txid of some partitions changed by others
+    void SetTxIdChangedCallback(std::function<void()> callback) {
+       txIdChangedCallback_ = std::move(callback);
+    }
+
  private:
     LeaseOpt opt_;
     std::shared_ptr<MetaCache> metaCache_;
@@ -77,6 +84,7 @@ class LeaseExecutor : public LeaseExecutorBase {
     std::string fsName_;
     Mountpoint mountpoint_;
     std::atomic<bool>* enableSumInDir_;
+    std::function<void()> txIdChangedCallback_;
 };
 
 }  // namespace client
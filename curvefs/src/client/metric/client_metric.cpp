@@ -34,8 +34,11 @@ const std::string FSMetric::prefix = "curvefs_client";  // NOLINT
 const std::string S3Metric::prefix = "curvefs_s3";  // NOLINT
 const std::string DiskCacheMetric::prefix = "curvefs_disk_cache";  // NOLINT
 const std::string KVClientMetric::prefix = "curvefs_kvclient";  // NOLINT
+const std::string CachePeerClientMetric::prefix = "curvefs_cache_peer_client";  // NOLINT
+const std::string CachePeerServiceMetric::prefix = "curvefs_cache_peer_service";  // NOLINT
 const std::string S3ChunkInfoMetric::prefix = "inode_s3_chunk_info";  // NOLINT
 const std::string WarmupManagerS3Metric::prefix = "curvefs_warmup";  // NOLINT
+const std::string DeferSyncMetric::prefix = "curvefs_defer_sync";  // NOLINT
 
 }  // namespace metric
 }  // namespace client
@@ -74,6 +74,7 @@ struct MetaServerClientMetric {
     // dentry
     InterfaceMetric getDentry;
     InterfaceMetric listDentry;
+    InterfaceMetric listDentryPlus;
     InterfaceMetric createDentry;
     InterfaceMetric deleteDentry;
 
@@ -83,8 +84,11 @@ struct MetaServerClientMetric {
     InterfaceMetric batchGetXattr;
     InterfaceMetric createInode;
     InterfaceMetric updateInode;
+    InterfaceMetric batchUpdateInode;
     InterfaceMetric deleteInode;
     InterfaceMetric appendS3ChunkInfo;
+    InterfaceMetric createNode;
+    InterfaceMetric allocInodeId;
 
     // tnx
     InterfaceMetric prepareRenameTx;
@@ -96,14 +100,18 @@ struct MetaServerClientMetric {
 
     MetaServerClientMetric()
         : getDentry(prefix, "getDentry"), listDentry(prefix, "listDentry"),
+          listDentryPlus(prefix, "listDentryPlus"),
           createDentry(prefix, "createDentry"),
           deleteDentry(prefix, "deleteDentry"), getInode(prefix, "getInode"),
           batchGetInodeAttr(prefix, "batchGetInodeAttr"),
           batchGetXattr(prefix, "batchGetXattr"),
           createInode(prefix, "createInode"),
           updateInode(prefix, "updateInode"),
+          batchUpdateInode(prefix, "batchUpdateInode"),
           deleteInode(prefix, "deleteInode"),
           appendS3ChunkInfo(prefix, "appendS3ChunkInfo"),
+          createNode(prefix, "createNode"),
+          allocInodeId(prefix, "allocInodeId"),
           prepareRenameTx(prefix, "prepareRenameTx"),
           updateVolumeExtent(prefix, "updateVolumeExtent"),
           getVolumeExtent(prefix, "getVolumeExtent"),
@@ -260,21 +268,50 @@ struct DiskCacheMetric {
     std::string fsName;
     InterfaceMetric writeS3;
     bvar::Status<uint64_t> diskUsedBytes;
+    // inflight uploads and its adaptive limit
+    bvar::Adder<int64_t> uploadInflight;
+    bvar::Status<uint32_t> uploadConcurrency;
+    bvar::Adder<uint64_t> uploadRetry;
 
     explicit DiskCacheMetric(const std::string &name = "")
         : fsName(!name.empty() ? name
                                : prefix + curve::common::ToHexString(this)),
           writeS3(prefix, fsName + "_write_s3"),
-          diskUsedBytes(prefix, fsName + "_diskcache_usedbytes", 0) {}
+          diskUsedBytes(prefix, fsName + "_diskcache_usedbytes", 0),
+          uploadInflight(prefix, fsName + "_diskcache_upload_inflight"),
+          uploadConcurrency(prefix, fsName + "_diskcache_upload_concurrency",
+                            0),
+          uploadRetry(prefix, fsName + "_diskcache_upload_retry") {}
 };
 
 struct KVClientMetric {
     static const std::string prefix;
     InterfaceMetric kvClientGet;
     InterfaceMetric kvClientSet;
+    InterfaceMetric kvClientMultiGet;
 
     KVClientMetric()
-        : kvClientGet(prefix, "get"), kvClientSet(prefix, "set") {}
+        : kvClientGet(prefix, "get"), kvClientSet(prefix, "set"),
+          kvClientMultiGet(prefix, "multi_get") {}
+};
+
+struct CachePeerClientMetric {
+    static const std::string prefix;
+    // blocks fetched from peers
+    InterfaceMetric fetch;
+
+    CachePeerClientMetric() : fetch(prefix, "fetch") {}
+};
+
+struct CachePeerServiceMetric {
+    static const std::string prefix;
+    // blocks served to peers
+    InterfaceMetric serve;
+    // objects loaded from s3 for peers
+    InterfaceMetric loadS3;
+
+    CachePeerServiceMetric()
+        : serve(prefix, "serve"), loadS3(prefix, "load_s3") {}
 };
 
 struct S3ChunkInfoMetric {
@@ -296,6 +333,19 @@ struct WarmupManagerS3Metric {
           warmupS3CacheSize(prefix, "s3_cache_size") {}
 };
 
+struct DeferSyncMetric {
+    static const std::string prefix;
+
+    bvar::Adder<int64_t> queueDepth;
+    bvar::Adder<uint64_t> coalescedInodes;
+    bvar::Adder<uint64_t> batchedInodes;
+
+    DeferSyncMetric()
+        : queueDepth(prefix, "queue_depth"),
+          coalescedInodes(prefix, "coalesced_inodes"),
+          batchedInodes(prefix, "batched_inodes") {}
+};
+
 }  // namespace metric
 }  // namespace client
 }  // namespace curvefs
@@ -44,6 +44,10 @@ using curvefs::metaserver::CreateInodeRequest;
 using curvefs::metaserver::CreateInodeResponse;
 using curvefs::metaserver::CreateManageInodeRequest;
 using curvefs::metaserver::CreateManageInodeResponse;
+using curvefs::metaserver::CreateNodeRequest;
+using curvefs::metaserver::CreateNodeResponse;
+using curvefs::metaserver::AllocInodeIdRequest;
+using curvefs::metaserver::AllocInodeIdResponse;
 using curvefs::metaserver::DeleteDentryRequest;
 using curvefs::metaserver::DeleteDentryResponse;
 using curvefs::metaserver::DeleteInodeRequest;
@@ -57,6 +61,9 @@ using curvefs::metaserver::GetInodeResponse;
 using curvefs::metaserver::Inode;
 using curvefs::metaserver::ListDentryRequest;
 using curvefs::metaserver::ListDentryResponse;
+using curvefs::metaserver::ListDentryPlusRequest;
+using curvefs::metaserver::ListDentryPlusResponse;
+using curvefs::metaserver::DentryPlus;
 using curvefs::metaserver::PrepareRenameTxRequest;
 using curvefs::metaserver::PrepareRenameTxResponse;
 using curvefs::metaserver::UpdateInodeRequest;
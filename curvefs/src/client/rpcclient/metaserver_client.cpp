@@ -46,6 +46,8 @@ using curvefs::metaserver::BatchGetInodeAttrRequest;
 using curvefs::metaserver::BatchGetInodeAttrResponse;
 using curvefs::metaserver::BatchGetXAttrRequest;
 using curvefs::metaserver::BatchGetXAttrResponse;
+using curvefs::metaserver::BatchUpdateInodeRequest;
+using curvefs::metaserver::BatchUpdateInodeResponse;
 using curvefs::metaserver::GetOrModifyS3ChunkInfoRequest;
 using curvefs::metaserver::GetOrModifyS3ChunkInfoResponse;
 
@@ -59,6 +61,7 @@ using DeleteDentryExcutor = TaskExecutor;
 using PrepareRenameTxExcutor = TaskExecutor;
 using DeleteInodeExcutor = TaskExecutor;
 using UpdateInodeExcutor = TaskExecutor;
+using BatchUpdateInodeExcutor = TaskExecutor;
 using GetInodeExcutor = TaskExecutor;
 using BatchGetInodeAttrExcutor = TaskExecutor;
 using BatchGetXAttrExcutor = TaskExecutor;
@@ -123,6 +126,12 @@ void MetaServerClientImpl::SetTxId(uint32_t partitionId, uint64_t txId) {
 MetaStatusCode MetaServerClientImpl::GetDentry(uint32_t fsId, uint64_t inodeid,
                                                const std::string &name,
                                                Dentry *out) {
+    return GetDentryWithLease(fsId, inodeid, name, "", out, nullptr);
+}
+
+MetaStatusCode MetaServerClientImpl::GetDentryWithLease(
+    uint32_t fsId, uint64_t inodeid, const std::string &name,
+    const std::string &holder, Dentry *out, uint32_t *leaseMs) {
     auto task = RPCTask {
         (void)taskExecutorDone;
         metric_.getDentry.qps.count << 1;
@@ -136,6 +145,9 @@ MetaStatusCode MetaServerClientImpl::GetDentry(uint32_t fsId, uint64_t inodeid,
         request.set_parentinodeid(inodeid);
         request.set_name(name);
         request.set_txid(txId);
+        if (!holder.empty()) {
+            request.set_leaseholder(holder);
+        }
 
         curvefs::metaserver::MetaServerService_Stub stub(channel);
         stub.GetDentry(cntl, &request, &response, nullptr);
@@ -149,6 +161,9 @@ MetaStatusCode MetaServerClientImpl::GetDentry(uint32_t fsId, uint64_t inodeid,
             return -cntl->ErrorCode();
         }
         MetaStatusCode ret = response.statuscode();
+        if (leaseMs != nullptr) {
+            *leaseMs = response.leasems();
+        }
 
         if (ret != MetaStatusCode::OK) {
             LOG_IF(WARNING, ret != MetaStatusCode::NOT_FOUND)
@@ -237,6 +252,124 @@ MetaStatusCode MetaServerClientImpl::ListDentry(uint32_t fsId, uint64_t inodeid,
     return ConvertToMetaStatusCode(excutor.DoRPCTask());
 }
 
+namespace {
+
+struct ParseDentryPlusCallBack {
+    explicit ParseDentryPlusCallBack(std::list<DentryPlus> *list)
+        : entries(list) {}
+
+    bool operator()(butil::IOBuf *data) const {
+        DentryPlus entry;
+        if (!brpc::ParsePbFromIOBuf(&entry, *data)) {
+            LOG(ERROR) << "Failed to parse dentry from stream";
+            return false;
+        }
+
+        entries->push_back(std::move(entry));
+        return true;
+    }
+
+    std::list<DentryPlus> *entries;
+};
+
+}  // namespace
+
+MetaStatusCode MetaServerClientImpl::ListDentryPlus(
+    uint32_t fsId, uint64_t inodeid, const std::string &last, uint32_t count,
+    bool streaming, std::list<DentryPlus> *entries) {
+    auto task = RPCTask {
+        (void)taskExecutorDone;
+        metric_.listDentryPlus.qps.count << 1;
+        LatencyUpdater updater(&metric_.listDentryPlus.latency);
+        ListDentryPlusRequest request;
+        ListDentryPlusResponse response;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(fsId);
+        request.set_dirinodeid(inodeid);
+        request.set_txid(txId);
+        request.set_last(last);
+        request.set_count(count);
+        request.set_streaming(streaming);
+
+        // entries received by last try
+        entries->clear();
+
+        // for streaming
+        std::shared_ptr<StreamConnection> connection;
+        auto closeConn = absl::MakeCleanup([this, &connection]() {
+            if (connection != nullptr) {
+                streamClient_.Close(connection);
+            }
+        });
+
+        if (streaming) {
+            StreamOptions opts(opt_.rpcStreamIdleTimeoutMS);
+            connection = streamClient_.Connect(
+                cntl, ParseDentryPlusCallBack{entries}, opts);
+            if (connection == nullptr) {
+                LOG(ERROR) << "Stream connect failed in client-side"
+                           << ", inodeid = " << inodeid
+                           << ", poolid = " << poolID
+                           << ", copysetid = " << copysetID
+                           << ", remote side = " << cntl->remote_side();
+                return MetaStatusCode::RPC_STREAM_ERROR;
+            }
+        }
+
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.ListDentryPlus(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metric_.listDentryPlus.eps.count << 1;
+            LOG(WARNING) << "ListDentryPlus Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            metric_.listDentryPlus.eps.count << 1;
+            LOG(WARNING) << "ListDentryPlus: fsId = " << fsId
+                         << ", inodeid = " << inodeid << ", last = " << last
+                         << ", count = " << count
+                         << ", streaming = " << streaming
+                         << ", errcode = " << ret
+                         << ", errmsg = " << MetaStatusCode_Name(ret);
+            return ret;
+        }
+
+        if (!streaming) {
+            for (auto &entry : *response.mutable_entries()) {
+                entries->push_back(std::move(entry));
+            }
+        } else {
+            auto status = connection->WaitAllDataReceived();
+            if (status != StreamStatus::STREAM_OK) {
+                LOG(ERROR) << "Receive stream data failed"
+                           << ", inodeid = " << inodeid
+                           << ", status = " << status;
+                return MetaStatusCode::RPC_STREAM_ERROR;
+            }
+        }
+
+        VLOG(6) << "ListDentryPlus done, inodeid = " << inodeid
+                << ", last = " << last << ", streaming = " << streaming
+                << ", entries = " << entries->size();
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::ListDentryPlus, task, fsId, inodeid, streaming,
+        opt_.enableRenameParallel);
+    ListDentryExcutor excutor(opt_, metaCache_, channelManager_,
+                              std::move(taskCtx));
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
 MetaStatusCode MetaServerClientImpl::CreateDentry(const Dentry &dentry) {
     auto task = RPCTask {
         (void)taskExecutorDone;
@@ -912,6 +1045,156 @@ void MetaServerClientImpl::UpdateInodeWithOutNlinkAsync(
     UpdateInodeAsync(request, done);
 }
 
+namespace {
+
+// run done of each update with its status in the batch
+class BatchUpdateInodeDone : public MetaServerClientDone {
+ public:
+    explicit BatchUpdateInodeDone(std::vector<MetaServerClientDone *> &&dones)
+        : dones_(std::move(dones)) {}
+
+    void SetStatuses(const google::protobuf::RepeatedField<int> &statuses) {
+        statuses_.assign(statuses.begin(), statuses.end());
+    }
+
+    void Run() override {
+        std::unique_ptr<BatchUpdateInodeDone> selfGuard(this);
+        MetaStatusCode ret = GetStatusCode();
+        for (size_t i = 0; i < dones_.size(); i++) {
+            MetaStatusCode status = ret;
+            if (ret == MetaStatusCode::OK) {
+                status = i < statuses_.size()
+                             ? static_cast<MetaStatusCode>(statuses_[i])
+                             : MetaStatusCode::UNKNOWN_ERROR;
+            }
+            if (dones_[i] != nullptr) {
+                dones_[i]->SetMetaStatusCode(status);
+                dones_[i]->Run();
+            }
+        }
+    }
+
+ private:
+    std::vector<MetaServerClientDone *> dones_;
+    std::vector<int> statuses_;
+};
+
+}  // namespace
+
+class BatchUpdateInodeRpcDone : public MetaServerClientRpcDoneBase {
+ public:
+    using MetaServerClientRpcDoneBase::MetaServerClientRpcDoneBase;
+
+    void Run() override;
+    BatchUpdateInodeResponse response;
+};
+
+void BatchUpdateInodeRpcDone::Run() {
+    std::unique_ptr<BatchUpdateInodeRpcDone> self_guard(this);
+    brpc::ClosureGuard done_guard(done_);
+    auto taskCtx = done_->GetTaskExcutor()->GetTaskCxt();
+    auto &cntl = taskCtx->cntl_;
+    if (cntl.Failed()) {
+        metric_->batchUpdateInode.eps.count << 1;
+        LOG(WARNING) << "BatchUpdateInode Failed, errorcode = "
+                     << cntl.ErrorCode()
+                     << ", error content: " << cntl.ErrorText()
+                     << ", log id: " << cntl.log_id();
+        done_->SetRetCode(-cntl.ErrorCode());
+        return;
+    }
+
+    MetaStatusCode ret = response.statuscode();
+    if (ret != MetaStatusCode::OK) {
+        LOG(WARNING) << "BatchUpdateInode: inodeid = " << taskCtx->inodeID
+                     << ", errcode = " << ret
+                     << ", errmsg = " << MetaStatusCode_Name(ret);
+    }
+
+    VLOG(6) << "BatchUpdateInode done, "
+            << "response: " << response.ShortDebugString();
+    done_->SetRetCode(ret);
+    dynamic_cast<BatchUpdateInodeDone *>(done_->GetDone())
+        ->SetStatuses(response.statuses());
+}
+
+void MetaServerClientImpl::BatchUpdateInodeAsync(
+    const BatchUpdateInodeRequest &request,
+    std::vector<MetaServerClientDone *> &&dones) {
+    auto task = AsyncRPCTask {
+        (void)txId;
+        metric_.batchUpdateInode.qps.count << 1;
+
+        BatchUpdateInodeRequest req = request;
+        req.set_poolid(poolID);
+        req.set_copysetid(copysetID);
+        req.set_partitionid(partitionID);
+        for (auto &update : *req.mutable_updates()) {
+            update.set_poolid(poolID);
+            update.set_copysetid(copysetID);
+            update.set_partitionid(partitionID);
+        }
+
+        auto *rpcDone = new BatchUpdateInodeRpcDone(taskExecutorDone,
+                                                    &metric_);
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.BatchUpdateInode(cntl, &req, &rpcDone->response, rpcDone);
+        return MetaStatusCode::OK;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::BatchUpdateInode, task, request.fsid(),
+        request.updates(0).inodeid());
+    auto excutor = std::make_shared<BatchUpdateInodeExcutor>(
+        opt_, metaCache_, channelManager_, std::move(taskCtx));
+    TaskExecutorDone *taskDone = new TaskExecutorDone(
+        excutor, new BatchUpdateInodeDone(std::move(dones)));
+    excutor->DoAsyncRPCTask(taskDone);
+}
+
+void MetaServerClientImpl::BatchUpdateInodeWithOutNlinkAsync(
+    uint32_t fsId, std::vector<InodeUpdate> &&updates, uint32_t batchSize) {
+    // partition id -> updates of inodes in the partition
+    std::unordered_map<uint32_t, std::vector<InodeUpdate *>> groups;
+    for (auto &update : updates) {
+        uint32_t partitionId = 0;
+        if (batchSize > 1 && metaCache_->GetPartitionIdByInodeId(
+                                 fsId, update.inodeId, &partitionId)) {
+            groups[partitionId].emplace_back(&update);
+            continue;
+        }
+        UpdateInodeWithOutNlinkAsync(fsId, update.inodeId, update.attr,
+                                     update.done, std::move(update.indices));
+    }
+
+    for (auto &group : groups) {
+        const auto &members = group.second;
+        for (size_t start = 0; start < members.size(); start += batchSize) {
+            size_t end = std::min<size_t>(members.size(), start + batchSize);
+            if (end - start == 1) {
+                auto *update = members[start];
+                UpdateInodeWithOutNlinkAsync(fsId, update->inodeId,
+                                             update->attr, update->done,
+                                             std::move(update->indices));
+                continue;
+            }
+
+            BatchUpdateInodeRequest request;
+            request.set_fsid(fsId);
+            std::vector<MetaServerClientDone *> dones;
+            for (size_t i = start; i < end; i++) {
+                auto *update = members[i];
+                auto *item = request.add_updates();
+                FillInodeAttr(fsId, update->inodeId, update->attr,
+                              /*nlink=*/false, item);
+                FillDataIndices(std::move(update->indices), item);
+                dones.emplace_back(update->done);
+            }
+            BatchUpdateInodeAsync(request, std::move(dones));
+        }
+    }
+}
+
 bool MetaServerClientImpl::ParseS3MetaStreamBuffer(butil::IOBuf *buffer,
                                                    uint64_t *chunkIndex,
                                                    S3ChunkInfoList *list) {
@@ -1190,6 +1473,151 @@ MetaStatusCode MetaServerClientImpl::CreateInode(const InodeParam &param,
     return ConvertToMetaStatusCode(excutor.DoRPCTask());
 }
 
+MetaStatusCode MetaServerClientImpl::CreateNode(const Dentry &dentry,
+                                                const InodeParam *param,
+                                                const struct timespec &now,
+                                                Inode *out) {
+    auto task = RPCTask {
+        (void)taskExecutorDone;
+        metric_.createNode.qps.count << 1;
+        LatencyUpdater updater(&metric_.createNode.latency);
+        CreateNodeResponse response;
+        CreateNodeRequest request;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(dentry.fsid());
+        Dentry *d = request.mutable_dentry();
+        d->set_fsid(dentry.fsid());
+        d->set_inodeid(dentry.inodeid());
+        d->set_parentinodeid(dentry.parentinodeid());
+        d->set_name(dentry.name());
+        d->set_txid(txId);
+        d->set_type(dentry.type());
+        if (dentry.has_flag()) {
+            d->set_flag(dentry.flag());
+        }
+        if (param != nullptr) {
+            auto *newInode = request.mutable_newinode();
+            newInode->set_length(param->length);
+            newInode->set_uid(param->uid);
+            newInode->set_gid(param->gid);
+            newInode->set_mode(param->mode);
+            newInode->set_type(param->type);
+            newInode->set_rdev(param->rdev);
+            if (param->type == FsFileType::TYPE_SYM_LINK) {
+                newInode->set_symlink(param->symlink);
+            }
+        }
+        request.mutable_create()->set_sec(now.tv_sec);
+        request.mutable_create()->set_nsec(now.tv_nsec);
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.CreateNode(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metric_.createNode.eps.count << 1;
+            LOG(WARNING) << "CreateNode Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            LOG_IF(WARNING, ret != MetaStatusCode::PARTITION_ALLOC_ID_FAIL)
+                << "CreateNode: request: " << request.ShortDebugString()
+                << ", errcode = " << ret
+                << ", errmsg = " << MetaStatusCode_Name(ret)
+                << ", remote side = "
+                << butil::endpoint2str(cntl->remote_side()).c_str();
+        } else if (param != nullptr) {
+            if (!response.has_inode()) {
+                LOG(WARNING) << "CreateNode: request: "
+                             << request.ShortDebugString()
+                             << " ok, but inode not set in response:"
+                             << response.ShortDebugString();
+                return -1;
+            }
+            *out = response.inode();
+        }
+
+        VLOG(6) << "CreateNode done, request: " << request.ShortDebugString()
+                << ", response: " << response.ShortDebugString();
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::CreateNode, task, dentry.fsid(),
+        dentry.parentinodeid(), false, opt_.enableRenameParallel);
+    CreateNodeExcutor excutor(opt_, metaCache_, channelManager_,
+                              std::move(taskCtx));
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
+MetaStatusCode MetaServerClientImpl::AllocInodeId(uint32_t fsId,
+                                                  uint64_t parentId,
+                                                  uint32_t count,
+                                                  InodeIdLease *lease) {
+    auto task = RPCTask {
+        (void)txId;
+        (void)taskExecutorDone;
+        metric_.allocInodeId.qps.count << 1;
+        LatencyUpdater updater(&metric_.allocInodeId.latency);
+        AllocInodeIdResponse response;
+        AllocInodeIdRequest request;
+        request.set_poolid(poolID);
+        request.set_copysetid(copysetID);
+        request.set_partitionid(partitionID);
+        request.set_fsid(fsId);
+        request.set_count(count);
+        curvefs::metaserver::MetaServerService_Stub stub(channel);
+        stub.AllocInodeId(cntl, &request, &response, nullptr);
+
+        if (cntl->Failed()) {
+            metric_.allocInodeId.eps.count << 1;
+            LOG(WARNING) << "AllocInodeId Failed, errorcode = "
+                         << cntl->ErrorCode()
+                         << ", error content:" << cntl->ErrorText()
+                         << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        MetaStatusCode ret = response.statuscode();
+        if (ret != MetaStatusCode::OK) {
+            LOG_IF(WARNING, ret != MetaStatusCode::PARTITION_ALLOC_ID_FAIL)
+                << "AllocInodeId: request: " << request.ShortDebugString()
+                << ", errcode = " << ret
+                << ", errmsg = " << MetaStatusCode_Name(ret)
+                << ", remote side = "
+                << butil::endpoint2str(cntl->remote_side()).c_str();
+        } else if (response.has_idstart() && response.has_idcount() &&
+                   response.has_partitionstart() &&
+                   response.has_partitionend()) {
+            lease->start = response.idstart();
+            lease->count = response.idcount();
+            lease->partitionStart = response.partitionstart();
+            lease->partitionEnd = response.partitionend();
+        } else {
+            LOG(WARNING) << "AllocInodeId: request: "
+                         << request.ShortDebugString()
+                         << " ok, but lease not set in response:"
+                         << response.ShortDebugString();
+            return -1;
+        }
+
+        VLOG(6) << "AllocInodeId done, request: " << request.ShortDebugString()
+                << ", response: " << response.ShortDebugString();
+        return ret;
+    };
+
+    auto taskCtx = std::make_shared<TaskContext>(
+        MetaServerOpType::AllocInodeId, task, fsId, parentId);
+    CreateNodeExcutor excutor(opt_, metaCache_, channelManager_,
+                              std::move(taskCtx));
+    return ConvertToMetaStatusCode(excutor.DoRPCTask());
+}
+
 MetaStatusCode MetaServerClientImpl::CreateManageInode(const InodeParam &param,
                                                        Inode *out) {
     auto task = RPCTask {
@@ -70,6 +70,24 @@ struct DataIndices {
     absl::optional<VolumeExtentSliceList> volumeExtents;
 };
 
+// update of an inode which is sent with others in a batch
+struct InodeUpdate {
+    uint64_t inodeId;
+    InodeAttr attr;
+    DataIndices indices;
+    MetaServerClientDone* done;
+};
+
+// inode ids leased from a partition
+struct InodeIdLease {
+    // ids [start, start + count) are available
+    uint64_t start = 0;
+    uint32_t count = 0;
+    // inode id range of the partition
+    uint64_t partitionStart = 0;
+    uint64_t partitionEnd = 0;
+};
+
 class MetaServerClient {
  public:
     virtual ~MetaServerClient() = default;
@@ -87,11 +105,27 @@ class MetaServerClient {
     virtual MetaStatusCode GetDentry(uint32_t fsId, uint64_t inodeid,
                                      const std::string &name, Dentry *out) = 0;
 
+    // get dentry and lease directory |inodeid| to |holder|, |leaseMs| is
+    // set even if the dentry is not found
+    virtual MetaStatusCode GetDentryWithLease(uint32_t fsId, uint64_t inodeid,
+                                              const std::string &name,
+                                              const std::string &holder,
+                                              Dentry *out,
+                                              uint32_t *leaseMs) = 0;
+
     virtual MetaStatusCode ListDentry(uint32_t fsId, uint64_t inodeid,
                                       const std::string &last, uint32_t count,
                                       bool onlyDir,
                                       std::list<Dentry> *dentryList) = 0;
 
+    // list dentries with attributes of inodes in the same partition,
+    // in streaming mode all dentries after |last| are returned and
+    // |count| is the number of dentries listed by metaserver at a time
+    virtual MetaStatusCode ListDentryPlus(uint32_t fsId, uint64_t inodeid,
+                                          const std::string &last,
+                                          uint32_t count, bool streaming,
+                                          std::list<DentryPlus> *entries) = 0;
+
     virtual MetaStatusCode CreateDentry(const Dentry &dentry) = 0;
 
     virtual MetaStatusCode DeleteDentry(uint32_t fsId, uint64_t inodeid,
@@ -137,6 +171,14 @@ class MetaServerClient {
         MetaServerClientDone* done,
         DataIndices&& indices = {}) = 0;
 
+    // update inodes without nlink, updates of inodes in the same partition
+    // are sent in requests of at most |batchSize| updates, and |done| of
+    // each update is run with its own status
+    virtual void BatchUpdateInodeWithOutNlinkAsync(
+        uint32_t fsId,
+        std::vector<InodeUpdate>&& updates,
+        uint32_t batchSize) = 0;
+
     virtual MetaStatusCode GetOrModifyS3ChunkInfo(
         uint32_t fsId, uint64_t inodeId,
         const google::protobuf::Map<
@@ -157,6 +199,22 @@ class MetaServerClient {
     virtual MetaStatusCode CreateManageInode(const InodeParam &param,
                                              Inode *out) = 0;
 
+    // Create |dentry| and update mtime, ctime and nlink of its parent in one
+    // request. If |param| is not nullptr, the inode is created together in
+    // the partition of the parent, otherwise |dentry| refers to an existing
+    // inode. PARTITION_ALLOC_ID_FAIL is returned if the partition of the
+    // parent has no free inode id.
+    virtual MetaStatusCode CreateNode(const Dentry &dentry,
+                                      const InodeParam *param,
+                                      const struct timespec &now,
+                                      Inode *out) = 0;
+
+    // Lease at most |count| inode ids from the partition of |parentId|,
+    // the ids can be used by CreateNode() later.
+    virtual MetaStatusCode AllocInodeId(uint32_t fsId, uint64_t parentId,
+                                        uint32_t count,
+                                        InodeIdLease *lease) = 0;
+
     virtual MetaStatusCode DeleteInode(uint32_t fsId, uint64_t inodeid) = 0;
 
     virtual bool SplitRequestInodes(uint32_t fsId,
@@ -195,11 +253,21 @@ class MetaServerClientImpl : public MetaServerClient {
     MetaStatusCode GetDentry(uint32_t fsId, uint64_t inodeid,
                              const std::string &name, Dentry *out) override;
 
+    MetaStatusCode GetDentryWithLease(uint32_t fsId, uint64_t inodeid,
+                                      const std::string &name,
+                                      const std::string &holder, Dentry *out,
+                                      uint32_t *leaseMs) override;
+
     MetaStatusCode ListDentry(uint32_t fsId, uint64_t inodeid,
                               const std::string &last, uint32_t count,
                               bool onlyDir,
                               std::list<Dentry> *dentryList) override;
 
+    MetaStatusCode ListDentryPlus(uint32_t fsId, uint64_t inodeid,
+                                  const std::string &last, uint32_t count,
+                                  bool streaming,
+                                  std::list<DentryPlus> *entries) override;
+
     MetaStatusCode CreateDentry(const Dentry &dentry) override;
 
     MetaStatusCode DeleteDentry(uint32_t fsId, uint64_t inodeid,
@@ -245,6 +313,11 @@ class MetaServerClientImpl : public MetaServerClient {
         MetaServerClientDone* done,
         DataIndices&& indices = {}) override;
 
+    void BatchUpdateInodeWithOutNlinkAsync(
+        uint32_t fsId,
+        std::vector<InodeUpdate>&& updates,
+        uint32_t batchSize) override;
+
     MetaStatusCode GetOrModifyS3ChunkInfo(
         uint32_t fsId, uint64_t inodeId,
         const google::protobuf::Map<
@@ -265,6 +338,13 @@ class MetaServerClientImpl : public MetaServerClient {
     MetaStatusCode CreateManageInode(const InodeParam &param,
                                      Inode *out) override;
 
+    MetaStatusCode CreateNode(const Dentry &dentry, const InodeParam *param,
+                              const struct timespec &now,
+                              Inode *out) override;
+
+    MetaStatusCode AllocInodeId(uint32_t fsId, uint64_t parentId,
+                                uint32_t count, InodeIdLease *lease) override;
+
     MetaStatusCode DeleteInode(uint32_t fsId, uint64_t inodeid) override;
 
     bool SplitRequestInodes(uint32_t fsId,
@@ -292,6 +372,9 @@ class MetaServerClientImpl : public MetaServerClient {
     void UpdateInodeAsync(const UpdateInodeRequest &request,
                           MetaServerClientDone *done);
 
+    void BatchUpdateInodeAsync(const BatchUpdateInodeRequest &request,
+                               std::vector<MetaServerClientDone *> &&dones);
+
     bool ParseS3MetaStreamBuffer(butil::IOBuf* buffer,
                                  uint64_t* chunkIndex,
                                  S3ChunkInfoList* list);
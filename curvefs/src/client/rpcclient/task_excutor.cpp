@@ -151,9 +151,8 @@ bool TaskExecutor::OnReturn(int retCode) {
         case MetaStatusCode::PARTITION_ALLOC_ID_FAIL:
             // TODO(@lixiaocui @cw123): metaserver and mds heartbeat should
             // report this status
-            needRetry = true;
             // need choose a new coopyset
-            OnPartitionAllocIDFail();
+            needRetry = OnPartitionAllocIDFail();
             break;
 
         case MetaStatusCode::RPC_STREAM_ERROR:
@@ -264,9 +263,10 @@ void TaskExecutor::RefreshLeader() {
     task_->retryDirectly = (oldTarget != task_->target.metaServerID);
 }
 
-void TaskExecutor::OnPartitionAllocIDFail() {
+bool TaskExecutor::OnPartitionAllocIDFail() {
     metaCache_->MarkPartitionUnavailable(task_->target.partitionID);
     task_->target.Reset();
+    return true;
 }
 
 uint64_t TaskExecutor::OverLoadBackOff() {
@@ -339,6 +339,11 @@ bool CreateInodeExcutor::GetTarget() {
     return true;
 }
 
+bool CreateNodeExcutor::OnPartitionAllocIDFail() {
+    metaCache_->MarkPartitionUnavailable(task_->target.partitionID);
+    return false;
+}
+
 bool CreateManagerInodeExcutor::GetTarget() {
     if (!metaCache_->GetTarget(task_->fsID, RECYCLEINODEID, &task_->target)) {
         LOG(ERROR) << "CreateManagerInodeExcutor select target for task fail, "
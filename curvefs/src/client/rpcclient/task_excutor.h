@@ -152,7 +152,7 @@ class TaskExecutor {
     void OnReDirected();
     void OnCopysetNotExist();
     bool OnPartitionNotExist();
-    void OnPartitionAllocIDFail();
+    virtual bool OnPartitionAllocIDFail();
 
     // retry policy
     void RefreshLeader();
@@ -272,6 +272,20 @@ class CreateInodeExcutor : public TaskExecutor {
     bool GetTarget() override;
 };
 
+// The new inode id is allocated in the partition of its parent, so it can't
+// be retried in other partitions if the partition has no free inode id.
+class CreateNodeExcutor : public TaskExecutor {
+ public:
+    explicit CreateNodeExcutor(
+        const ExcutorOpt &opt, const std::shared_ptr<MetaCache> &metaCache,
+        const std::shared_ptr<ChannelManager<MetaserverID>> &channelManager,
+        const std::shared_ptr<TaskContext> &task)
+        : TaskExecutor(opt, metaCache, channelManager, task) {}
+
+ protected:
+    bool OnPartitionAllocIDFail() override;
+};
+
 class CreateManagerInodeExcutor : public TaskExecutor {
  public:
     explicit CreateManagerInodeExcutor(
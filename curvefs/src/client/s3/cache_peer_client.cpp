@@ -0,0 +1,182 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-28
+ */
+
+#include "curvefs/src/client/s3/cache_peer_client.h"
+
+#include <brpc/controller.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "curvefs/src/client/s3/cache_peer_service.h"
+#include "src/client/client_metric.h"
+#include "src/common/timeutility.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::client::LatencyGuard;
+using ::curve::common::TimeUtility;
+
+CachePeerClient::CachePeerClient(const CachePeerOption& option,
+                                 const std::string& self, PeerLister lister)
+    : option_(option),
+      self_(self),
+      lister_(std::move(lister)),
+      running_(false) {}
+
+bool CachePeerClient::Init() {
+    Refresh();
+    if (GetPeerSet() == nullptr) {
+        LOG(ERROR) << "Init cache peer client failed, list peers failed";
+        return false;
+    }
+
+    running_ = true;
+    sleeper_.init();
+    refresher_ = std::thread(&CachePeerClient::RefreshLoop, this);
+    LOG(INFO) << "Cache peer client started, self = " << self_;
+    return true;
+}
+
+void CachePeerClient::Stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    sleeper_.interrupt();
+    refresher_.join();
+}
+
+void CachePeerClient::RefreshLoop() {
+    auto interval = std::chrono::seconds(option_.refreshIntervalSec);
+    while (sleeper_.wait_for(interval)) {
+        Refresh();
+    }
+}
+
+std::shared_ptr<CachePeerClient::PeerSet> CachePeerClient::GetPeerSet() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return peerSet_;
+}
+
+void CachePeerClient::Refresh() {
+    std::vector<std::string> peers;
+    if (!lister_(&peers)) {
+        LOG(WARNING) << "List cache peers failed";
+        return;
+    }
+    std::sort(peers.begin(), peers.end());
+    peers.erase(std::unique(peers.begin(), peers.end()), peers.end());
+
+    auto old = GetPeerSet();
+    if (old != nullptr && old->peers == peers) {
+        return;
+    }
+
+    auto peerSet = std::make_shared<PeerSet>(option_);
+    for (const auto& peer : peers) {
+        peerSet->ring.AddServer(peer);
+        if (peer == self_) {
+            peerSet->channels.push_back(nullptr);
+            continue;
+        }
+
+        // channels of existing peers are reused
+        std::shared_ptr<brpc::Channel> channel;
+        if (old != nullptr) {
+            auto iter = std::lower_bound(old->peers.begin(), old->peers.end(),
+                                         peer);
+            if (iter != old->peers.end() && *iter == peer) {
+                channel = old->channels[iter - old->peers.begin()];
+            }
+        }
+        if (channel == nullptr) {
+            brpc::ChannelOptions options;
+            options.timeout_ms = option_.rpcTimeoutMs;
+            options.max_retry = 0;
+            channel = std::make_shared<brpc::Channel>();
+            if (channel->Init(peer.c_str(), &options) != 0) {
+                LOG(WARNING) << "Init channel to cache peer " << peer
+                             << " failed";
+                channel = nullptr;
+            }
+        }
+        peerSet->channels.push_back(channel);
+    }
+    peerSet->peers = std::move(peers);
+
+    LOG(INFO) << "Cache peers changed, count = " << peerSet->peers.size();
+    std::lock_guard<std::mutex> lk(mtx_);
+    peerSet_ = std::move(peerSet);
+}
+
+bool CachePeerClient::Fetch(const std::string& name, uint64_t objectLength,
+                            char* buf, uint64_t offset, uint64_t length) {
+    auto peerSet = GetPeerSet();
+    uint32_t index = 0;
+    if (peerSet == nullptr || !peerSet->ring.Lookup(name, &index) ||
+        peerSet->channels[index] == nullptr) {
+        return false;
+    }
+
+    LatencyGuard guard(&metric_.fetch.latency);
+    CachePeerService_Stub stub(peerSet->channels[index].get());
+    brpc::Controller cntl;
+    GetBlockRequest request;
+    GetBlockResponse response;
+    request.set_name(name);
+    request.set_offset(offset);
+    request.set_length(length);
+    request.set_objectlength(objectLength);
+    request.set_date(TimeUtility::GetTimeofDayUs());
+    request.set_signature(CachePeerServiceImpl::Sign(option_.authKey, request));
+    stub.GetBlock(&cntl, &request, &response, nullptr);
+
+    if (cntl.Failed()) {
+        peerSet->ring.OnFailure(index);
+        LOG_EVERY_N(WARNING, 100)
+            << "Fetch " << name << " from cache peer "
+            << peerSet->peers[index] << " failed, error = " << cntl.ErrorText();
+        metric_.fetch.eps.count << 1;
+        return false;
+    }
+    peerSet->ring.OnSuccess(index);
+
+    if (response.statuscode() != CACHE_PEER_OK ||
+        cntl.response_attachment().size() != length) {
+        VLOG(6) << "Fetch " << name << " from cache peer "
+                << peerSet->peers[index] << " failed, status = "
+                << CachePeerStatusCode_Name(response.statuscode());
+        metric_.fetch.eps.count << 1;
+        return false;
+    }
+
+    cntl.response_attachment().copy_to(buf, length);
+    metric_.fetch.qps.count << 1;
+    metric_.fetch.bps.count << length;
+    return true;
+}
+
+}  // namespace client
+}  // namespace curvefs
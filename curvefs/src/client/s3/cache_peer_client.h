@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-28
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_S3_CACHE_PEER_CLIENT_H_
+#define CURVEFS_SRC_CLIENT_S3_CACHE_PEER_CLIENT_H_
+
+#include <brpc/channel.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "curvefs/proto/cachepeer.pb.h"
+#include "curvefs/src/client/common/config.h"
+#include "curvefs/src/client/kvclient/consistent_hash_ring.h"
+#include "curvefs/src/client/metric/client_metric.h"
+#include "src/common/interruptible_sleeper.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::common::InterruptibleSleeper;
+using ::curvefs::client::common::CachePeerOption;
+using ::curvefs::client::metric::CachePeerClientMetric;
+
+/**
+ * Fetch s3 objects from the peer which owns them.
+ *
+ * Peers ("host:port") are listed periodically, e.g. from the mountpoints
+ * of the filesystem registered in mds. Every object is owned by one peer
+ * picked by a consistent hash ring, so all clients ask the same peer for
+ * an object and it is downloaded from s3 only once. The ring contains this
+ * client too, the objects owned by itself are read from s3 directly.
+ */
+class CachePeerClient {
+ public:
+    // list the addresses of all peers
+    using PeerLister = std::function<bool(std::vector<std::string>*)>;
+
+    CachePeerClient(const CachePeerOption& option, const std::string& self,
+                    PeerLister lister);
+
+    virtual ~CachePeerClient() { Stop(); }
+
+    bool Init();
+
+    void Stop();
+
+    /**
+     * @brief read [offset, offset + length) of the object from its owner
+     * @param objectLength length of the whole object
+     * @return false if the object is owned by this client or the owner
+     *         failed, then it should be read from s3
+     */
+    virtual bool Fetch(const std::string& name, uint64_t objectLength,
+                       char* buf, uint64_t offset, uint64_t length);
+
+    // update peers from the lister, keep the ring if peers don't change
+    void Refresh();
+
+ private:
+    struct PeerSet {
+        explicit PeerSet(const CachePeerOption& option)
+            : ring(option.virtualNodes, option.peerFailureLimit,
+                   option.peerRetryIntervalMs) {}
+
+        std::vector<std::string> peers;
+        // nullptr for this client or the peers failed to init channel
+        std::vector<std::shared_ptr<brpc::Channel>> channels;
+        ConsistentHashRing ring;
+    };
+
+    std::shared_ptr<PeerSet> GetPeerSet();
+
+    void RefreshLoop();
+
+ private:
+    CachePeerOption option_;
+    std::string self_;
+    PeerLister lister_;
+
+    std::mutex mtx_;
+    std::shared_ptr<PeerSet> peerSet_;
+
+    bool running_;
+    std::thread refresher_;
+    InterruptibleSleeper sleeper_;
+
+    CachePeerClientMetric metric_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_S3_CACHE_PEER_CLIENT_H_
@@ -0,0 +1,244 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-28
+ */
+
+#include "curvefs/src/client/s3/cache_peer_service.h"
+
+#include <brpc/closure_guard.h>
+#include <brpc/controller.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "curvefs/src/common/s3util.h"
+#include "src/client/client_metric.h"
+#include "src/common/authenticator.h"
+#include "src/common/timeutility.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::client::LatencyGuard;
+using ::curve::common::Authenticator;
+using ::curve::common::S3Adapter;
+using ::curve::common::TimeUtility;
+
+namespace {
+
+// requests signed too long ago or with skewed clocks are rejected
+const uint64_t kStaledRequestTimeIntervalUs = 15 * 1000 * 1000u;
+
+}  // namespace
+
+CachePeerServiceImpl::CachePeerServiceImpl(
+    std::shared_ptr<S3Client> s3Client,
+    std::shared_ptr<DiskCacheManagerImpl> diskCache,
+    const CachePeerOption& option, uint64_t fsId, uint64_t blockSize,
+    uint32_t objectPrefix)
+    : s3Client_(std::move(s3Client)),
+      diskCache_(std::move(diskCache)),
+      // capacity 0 means unlimited for LRUCache
+      memoryCache_(std::max<uint32_t>(option.memoryCacheCapacity, 1)),
+      authKey_(option.authKey),
+      fsId_(fsId),
+      blockSize_(blockSize),
+      objectPrefix_(objectPrefix) {}
+
+std::string CachePeerServiceImpl::Sign(const std::string& authKey,
+                                       const GetBlockRequest& request) {
+    std::string str2sign =
+        Authenticator::GetString2Signature(request.date(), request.name());
+    str2sign.append(":")
+        .append(std::to_string(request.offset()))
+        .append(":")
+        .append(std::to_string(request.length()))
+        .append(":")
+        .append(std::to_string(request.objectlength()));
+    return Authenticator::CalcString2Signature(str2sign, authKey);
+}
+
+CachePeerStatusCode CachePeerServiceImpl::CheckRequest(
+    const GetBlockRequest* request) {
+    uint64_t now = TimeUtility::GetTimeofDayUs();
+    uint64_t date = request->date();
+    uint64_t interval = date > now ? date - now : now - date;
+    if (interval >= kStaledRequestTimeIntervalUs ||
+        request->signature() != Sign(authKey_, *request)) {
+        return CACHE_PEER_AUTH_FAILED;
+    }
+
+    // the name is also the path in disk cache, it must be an object of
+    // this filesystem
+    uint64_t offset = request->offset();
+    uint64_t length = request->length();
+    uint64_t objectLength = request->objectlength();
+    if (length == 0 || objectLength > blockSize_ || offset >= objectLength ||
+        length > objectLength - offset ||
+        !curvefs::common::s3util::ValidNameOfFs(fsId_, request->name(),
+                                                objectPrefix_)) {
+        return CACHE_PEER_INVALID_PARAM;
+    }
+    return CACHE_PEER_OK;
+}
+
+void CachePeerServiceImpl::GetBlock(
+    ::google::protobuf::RpcController* controller,
+    const GetBlockRequest* request, GetBlockResponse* response,
+    ::google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    auto* cntl = static_cast<brpc::Controller*>(controller);
+    LatencyGuard guard(&metric_.serve.latency);
+
+    CachePeerStatusCode status = CheckRequest(request);
+    if (status != CACHE_PEER_OK) {
+        LOG(WARNING) << "Reject get block request from "
+                     << butil::endpoint2str(cntl->remote_side()).c_str()
+                     << ": " << request->ShortDebugString()
+                     << ", status = " << CachePeerStatusCode_Name(status);
+        response->set_statuscode(status);
+        metric_.serve.eps.count << 1;
+        return;
+    }
+
+    const auto& name = request->name();
+    uint64_t offset = request->offset();
+    uint64_t length = request->length();
+
+    std::shared_ptr<std::string> data;
+    bool hit = memoryCache_.Get(name, &data);
+    if (!hit && ReadFromDisk(request, &cntl->response_attachment())) {
+        VLOG(9) << "serve " << name << " from disk cache";
+    } else {
+        if (!hit) {
+            data = Load(name, request->objectlength());
+        }
+        if (data == nullptr || data->size() < offset + length) {
+            response->set_statuscode(CACHE_PEER_NOT_FOUND);
+            metric_.serve.eps.count << 1;
+            return;
+        }
+        cntl->response_attachment().append(data->data() + offset, length);
+    }
+
+    response->set_statuscode(CACHE_PEER_OK);
+    metric_.serve.qps.count << 1;
+    metric_.serve.bps.count << length;
+}
+
+bool CachePeerServiceImpl::ReadFromDisk(const GetBlockRequest* request,
+                                        butil::IOBuf* out) {
+    if (diskCache_ == nullptr || !diskCache_->IsCached(request->name())) {
+        return false;
+    }
+
+    std::unique_ptr<char[]> buf(new char[request->length()]);
+    int ret = diskCache_->Read(request->name(), buf.get(), request->offset(),
+                               request->length());
+    if (ret < static_cast<int>(request->length())) {
+        LOG(WARNING) << "Read " << request->name()
+                     << " from disk cache failed, ret = " << ret;
+        return false;
+    }
+    out->append(buf.get(), request->length());
+    return true;
+}
+
+std::shared_ptr<std::string> CachePeerServiceImpl::Load(
+    const std::string& name, uint64_t length) {
+    std::shared_ptr<Loading> loading;
+    {
+        std::lock_guard<bthread::Mutex> lk(loadingMtx_);
+        auto iter = loading_.find(name);
+        if (iter != loading_.end()) {
+            loading = iter->second;
+        } else {
+            // the object may be loaded just now
+            std::shared_ptr<std::string> data;
+            if (memoryCache_.Get(name, &data)) {
+                return data;
+            }
+            loading_.emplace(name, std::make_shared<Loading>());
+        }
+    }
+
+    if (loading != nullptr) {
+        loading->event.wait();
+        return loading->data;
+    }
+
+    auto data = LoadFromS3(name, length);
+    if (data != nullptr) {
+        memoryCache_.Put(name, data);
+        if (diskCache_ != nullptr &&
+            diskCache_->WriteReadDirect(name, data->data(), data->size()) <
+                0) {
+            LOG(WARNING) << "Write " << name << " to disk cache failed";
+        }
+    }
+
+    {
+        std::lock_guard<bthread::Mutex> lk(loadingMtx_);
+        auto iter = loading_.find(name);
+        loading = iter->second;
+        loading_.erase(iter);
+    }
+    loading->data = data;
+    loading->event.signal();
+    return data;
+}
+
+std::shared_ptr<std::string> CachePeerServiceImpl::LoadFromS3(
+    const std::string& name, uint64_t length) {
+    LatencyGuard guard(&metric_.loadS3.latency);
+
+    auto data = std::make_shared<std::string>(length, '\0');
+    // the callback may still be running when the waiter returns
+    auto event = std::make_shared<bthread::CountdownEvent>(1);
+    auto context = std::make_shared<GetObjectAsyncContext>();
+    context->key = name;
+    context->buf = &(*data)[0];
+    context->offset = 0;
+    context->len = length;
+    context->retry = 0;
+    context->cb = [event](const S3Adapter*,
+                          const std::shared_ptr<GetObjectAsyncContext>&) {
+        event->signal();
+    };
+    s3Client_->DownloadAsync(context);
+    event->wait();
+
+    if (context->retCode != 0) {
+        LOG(WARNING) << "Load " << name << " from s3 failed, ret = "
+                     << context->retCode;
+        metric_.loadS3.eps.count << 1;
+        return nullptr;
+    }
+
+    // the last object of a file may be shorter
+    data->resize(std::min<uint64_t>(context->actualLen, length));
+    metric_.loadS3.qps.count << 1;
+    metric_.loadS3.bps.count << data->size();
+    return data;
+}
+
+}  // namespace client
+}  // namespace curvefs
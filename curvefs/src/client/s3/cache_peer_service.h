@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-28
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_S3_CACHE_PEER_SERVICE_H_
+#define CURVEFS_SRC_CLIENT_S3_CACHE_PEER_SERVICE_H_
+
+#include <bthread/countdown_event.h>
+#include <bthread/mutex.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "curvefs/proto/cachepeer.pb.h"
+#include "curvefs/src/client/common/config.h"
+#include "curvefs/src/client/metric/client_metric.h"
+#include "curvefs/src/client/s3/client_s3.h"
+#include "curvefs/src/client/s3/disk_cache_manager_impl.h"
+#include "src/common/lru_cache.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::common::LRUCache;
+using ::curvefs::client::common::CachePeerOption;
+using ::curvefs::client::metric::CachePeerServiceMetric;
+
+/**
+ * Serve s3 objects owned by this client to its peers.
+ *
+ * An object is read from the memory cache or the disk cache, on miss it is
+ * loaded from s3 as a whole and cached, so every object is downloaded
+ * once no matter how many peers read it. Concurrent loads of an object
+ * are merged.
+ *
+ * Only the peers signing requests with the shared key are served, and only
+ * the objects of this filesystem no larger than a block.
+ */
+class CachePeerServiceImpl : public CachePeerService {
+ public:
+    CachePeerServiceImpl(std::shared_ptr<S3Client> s3Client,
+                         std::shared_ptr<DiskCacheManagerImpl> diskCache,
+                         const CachePeerOption& option, uint64_t fsId,
+                         uint64_t blockSize, uint32_t objectPrefix);
+
+    // signature of all fields of the request except the signature itself,
+    // so a captured request can't be replayed with another range
+    static std::string Sign(const std::string& authKey,
+                            const GetBlockRequest& request);
+
+    void GetBlock(::google::protobuf::RpcController* controller,
+                  const GetBlockRequest* request, GetBlockResponse* response,
+                  ::google::protobuf::Closure* done) override;
+
+ private:
+    struct Loading {
+        bthread::CountdownEvent event{1};
+        std::shared_ptr<std::string> data;
+    };
+
+    CachePeerStatusCode CheckRequest(const GetBlockRequest* request);
+
+    bool ReadFromDisk(const GetBlockRequest* request, butil::IOBuf* out);
+
+    std::shared_ptr<std::string> Load(const std::string& name,
+                                      uint64_t length);
+
+    std::shared_ptr<std::string> LoadFromS3(const std::string& name,
+                                            uint64_t length);
+
+ private:
+    std::shared_ptr<S3Client> s3Client_;
+    // nullptr if disk cache is disabled
+    std::shared_ptr<DiskCacheManagerImpl> diskCache_;
+    LRUCache<std::string, std::shared_ptr<std::string>> memoryCache_;
+    const std::string authKey_;
+    const uint64_t fsId_;
+    const uint64_t blockSize_;
+    const uint32_t objectPrefix_;
+
+    bthread::Mutex loadingMtx_;
+    std::unordered_map<std::string, std::shared_ptr<Loading>> loading_;
+
+    CachePeerServiceMetric metric_;
+};
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_S3_CACHE_PEER_SERVICE_H_
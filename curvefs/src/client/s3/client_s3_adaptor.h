@@ -26,6 +26,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "curvefs/proto/common.pb.h"
@@ -36,6 +37,7 @@
 #include "curvefs/src/client/filesystem/error.h"
 #include "curvefs/src/client/inode_cache_manager.h"
 #include "curvefs/src/client/rpcclient/mds_client.h"
+#include "curvefs/src/client/s3/cache_peer_client.h"
 #include "curvefs/src/client/s3/client_s3.h"
 #include "curvefs/src/client/s3/client_s3_cache_manager.h"
 #include "curvefs/src/client/s3/disk_cache_manager_impl.h"
@@ -96,6 +98,10 @@ class S3ClientAdaptor {
                                 uint64_t start) = 0;
     virtual std::shared_ptr<DiskCacheManagerImpl> GetDiskCacheManager() = 0;
     virtual std::shared_ptr<S3Client> GetS3Client() = 0;
+    virtual void SetCachePeerClient(
+        std::shared_ptr<CachePeerClient> cachePeerClient) = 0;
+    // nullptr if cache peer is disabled
+    virtual std::shared_ptr<CachePeerClient> GetCachePeerClient() = 0;
     virtual uint64_t GetBlockSize() = 0;
     virtual uint64_t GetChunkSize() = 0;
     virtual uint32_t GetObjectPrefix() = 0;
@@ -160,6 +166,12 @@ class S3ClientAdaptorImpl : public S3ClientAdaptor {
     }
     uint32_t GetFlushInterval() { return flushIntervalSec_; }
     std::shared_ptr<S3Client> GetS3Client() { return client_; }
+    void SetCachePeerClient(std::shared_ptr<CachePeerClient> cachePeerClient) {
+        cachePeerClient_ = std::move(cachePeerClient);
+    }
+    std::shared_ptr<CachePeerClient> GetCachePeerClient() {
+        return cachePeerClient_;
+    }
     uint32_t GetPrefetchBlocks() {
         return prefetchBlocks_;
     }
@@ -282,6 +294,7 @@ class S3ClientAdaptorImpl : public S3ClientAdaptor {
         taskPool_;
 
     std::shared_ptr<KVClientManager> kvClientManager_ = nullptr;
+    std::shared_ptr<CachePeerClient> cachePeerClient_ = nullptr;
 };
 
 }  // namespace client
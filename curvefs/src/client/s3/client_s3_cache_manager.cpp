@@ -24,6 +24,7 @@
 
 #include <bvar/bvar.h>
 #include <sys/types.h>
+#include <deque>
 #include <utility>
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/cleanup/cleanup.h"
@@ -500,25 +501,31 @@ bool FileCacheManager::ReadKVRequestFromLocalCache(const std::string &name,
     return true;
 }
 
-bool FileCacheManager::ReadKVRequestFromRemoteCache(const std::string &name,
-                                                    char *databuf,
-                                                    uint64_t offset,
-                                                    uint64_t length) {
-    if (!kvClientManager_) {
-        return false;
+void FileCacheManager::ReadKVRequestFromRemoteCache(
+    const std::vector<std::shared_ptr<GetKVCacheTask>> &tasks) {
+    if (!kvClientManager_ || tasks.empty()) {
+        return;
     }
 
-    auto task = std::make_shared<GetKVCacheTask>(name, databuf, offset, length);
+    auto task = std::make_shared<MultiGetKVCacheTask>();
+    task->tasks = tasks;
     CountDownEvent event(1);
-    task->done = [&](const std::shared_ptr<GetKVCacheTask> &task) {
+    task->done = [&](const std::shared_ptr<MultiGetKVCacheTask> &task) {
         (void)task;
         event.Signal();
         return;
     };
-    kvClientManager_->Get(task);
+    kvClientManager_->MultiGet(task);
     event.Wait();
+}
 
-    return task->res;
+bool FileCacheManager::ReadKVRequestFromPeer(const std::string &name,
+                                             uint64_t objectLength,
+                                             char *databuf, uint64_t offset,
+                                             uint64_t length) {
+    auto cachePeerClient = s3ClientAdaptor_->GetCachePeerClient();
+    return cachePeerClient != nullptr &&
+           cachePeerClient->Fetch(name, objectLength, databuf, offset, length);
 }
 
 bool FileCacheManager::ReadKVRequestFromS3(const std::string &name,
@@ -595,47 +602,30 @@ void FileCacheManager::ProcessKVRequest(const S3ReadRequest &req, char *dataBuf,
     uint64_t currentReadLen = 0;
     uint64_t readBufOffset = 0;
     uint64_t objectOffset = req.objectOffset;
+    // tasks refer to the names, deque keeps them in place
+    std::deque<std::string> names;
+    std::vector<std::shared_ptr<GetKVCacheTask>> blocks;
+    // length of the whole objects, they end at the block or file end
+    std::vector<uint64_t> objectLengths;
 
     while (length > 0) {
         currentReadLen =
             length + blockPos > blockSize ? blockSize - blockPos : length;
         assert(blockPos >= objectOffset);
-        std::string name = curvefs::common::s3util::GenObjName(
+        names.emplace_back(curvefs::common::s3util::GenObjName(
             req.chunkId, blockIndex, req.compaction, req.fsId, req.inodeId,
-            objectPrefix);
-        char *currentBuf = dataBuf + req.readOffset + readBufOffset;
-
-        // read from localcache -> remotecache -> s3
-        do {
-            if (ReadKVRequestFromLocalCache(name, currentBuf,
-                                            blockPos - objectOffset,
-                                            currentReadLen)) {
-                VLOG(9) << "read " << name << " from local cache ok";
-                break;
-            }
-
-            if (ReadKVRequestFromRemoteCache(name, currentBuf,
-                                             blockPos - objectOffset,
-                                             currentReadLen)) {
-                VLOG(9) << "read " << name << " from remote cache ok";
-                break;
-            }
-
-            int ret = 0;
-            if (ReadKVRequestFromS3(name, currentBuf, blockPos - objectOffset,
-                                    currentReadLen, &ret)) {
-                VLOG(9) << "read " << name << " from s3 ok";
-                break;
-            }
-
-            LOG(ERROR) << "read " << name << " fail";
-            // make sure variable is set only once
-            std::call_once(cancelFlag, [&]() {
-                isCanceled.store(true);
-                retCode.store(ret);
-            });
-            return;
-        } while (false);
+            objectPrefix));
+        blocks.emplace_back(std::make_shared<GetKVCacheTask>(
+            names.back(), dataBuf + req.readOffset + readBufOffset,
+            blockPos - objectOffset, currentReadLen));
+        uint64_t objectStart =
+            chunkIndex * chunkSize + blockIndex * blockSize + objectOffset;
+        uint64_t objectLength = blockSize - objectOffset;
+        if (fileLen > objectStart) {
+            objectLength = std::min(objectLength, fileLen - objectStart);
+        }
+        objectLengths.push_back(std::max(
+            objectLength, blockPos - objectOffset + currentReadLen));
 
         // update param
         {
@@ -647,6 +637,53 @@ void FileCacheManager::ProcessKVRequest(const S3ReadRequest &req, char *dataBuf,
         }
     }
 
+    // read from localcache -> remotecache -> peer -> s3
+    std::vector<std::shared_ptr<GetKVCacheTask>> misses;
+    std::vector<size_t> missIndexes;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const auto &block = blocks[i];
+        if (ReadKVRequestFromLocalCache(block->key, block->value,
+                                        block->offset, block->length)) {
+            VLOG(9) << "read " << block->key << " from local cache ok";
+            continue;
+        }
+        misses.push_back(block);
+        missIndexes.push_back(i);
+    }
+
+    // blocks missed in local cache are read from remote cache in one batch
+    ReadKVRequestFromRemoteCache(misses);
+
+    for (auto index : missIndexes) {
+        const auto &block = blocks[index];
+        if (block->res) {
+            VLOG(9) << "read " << block->key << " from remote cache ok";
+            continue;
+        }
+
+        if (ReadKVRequestFromPeer(block->key, objectLengths[index],
+                                  block->value, block->offset,
+                                  block->length)) {
+            VLOG(9) << "read " << block->key << " from peer ok";
+            continue;
+        }
+
+        int ret = 0;
+        if (ReadKVRequestFromS3(block->key, block->value, block->offset,
+                                block->length, &ret)) {
+            VLOG(9) << "read " << block->key << " from s3 ok";
+            continue;
+        }
+
+        LOG(ERROR) << "read " << block->key << " fail";
+        // make sure variable is set only once
+        std::call_once(cancelFlag, [&]() {
+            isCanceled.store(true);
+            retCode.store(ret);
+        });
+        return;
+    }
+
     // add data to memory read cache
     if (!curvefs::client::common::FLAGS_enableCto) {
         auto chunkCacheManager = FindOrCreateChunkCacheManager(chunkIndex);
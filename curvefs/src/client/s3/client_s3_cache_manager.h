@@ -437,9 +437,15 @@ class FileCacheManager {
     bool ReadKVRequestFromLocalCache(const std::string &name, char *databuf,
                                      uint64_t offset, uint64_t len);
 
-    // read kv request from remote cache like memcached
-    bool ReadKVRequestFromRemoteCache(const std::string &name, char *databuf,
-                                      uint64_t offset, uint64_t length);
+    // read blocks from remote cache like memcached in one batch,
+    // res of each task tells whether the block is read
+    void ReadKVRequestFromRemoteCache(
+        const std::vector<std::shared_ptr<GetKVCacheTask>> &tasks);
+
+    // read kv request from the peer client which owns the object
+    bool ReadKVRequestFromPeer(const std::string &name, uint64_t objectLength,
+                               char *databuf, uint64_t offset,
+                               uint64_t length);
 
     // read kv request from s3
     bool ReadKVRequestFromS3(const std::string &name, char *databuf,
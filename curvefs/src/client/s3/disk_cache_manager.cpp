@@ -106,6 +106,7 @@ int DiskCacheManager::Init(std::shared_ptr<S3Client> client,
     objectPrefix_ = option.objectPrefix;
     cacheWrite_->Init(client_, posixWrapper_, cacheDir_, objectPrefix_,
         option.diskCacheOpt.asyncLoadPeriodMs, cachedObjName_);
+    cacheWrite_->InitUploadOption(option.diskCacheOpt);
     cacheRead_->Init(posixWrapper_, cacheDir_, objectPrefix_);
     int ret;
     ret = CreateDir();
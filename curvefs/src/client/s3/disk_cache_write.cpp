@@ -26,6 +26,7 @@
 #include <errno.h>
 #include <dirent.h>
 
+#include <algorithm>
 #include <vector>
 #include "curvefs/src/client/s3/disk_cache_write.h"
 #include "curvefs/src/common/s3util.h"
@@ -48,9 +49,34 @@ void DiskCacheWrite::Init(std::shared_ptr<S3Client> client,
     DiskCacheBase::Init(posixWrapper, cacheDir, objectPrefix);
 }
 
+void DiskCacheWrite::InitUploadOption(const DiskCacheOption &option) {
+    UploadConcurrencyOption concurrencyOption;
+    concurrencyOption.minConcurrency = option.uploadMinConcurrency;
+    concurrencyOption.maxConcurrency = option.uploadMaxConcurrency;
+    concurrencyOption.latencyTolerancePercent =
+        option.uploadLatencyTolerancePercent;
+    controller_.reset(new UploadConcurrencyController(concurrencyOption));
+    maxRetryIntervalMs_ = option.uploadMaxRetryIntervalMs;
+    stopTimeoutMs_ = option.uploadStopTimeoutMs;
+
+    ReadWriteThrottleParams params;
+    params.bpsWrite = ThrottleParams(option.avgUploadBytes, 0, 0);
+    uploadThrottle_.UpdateThrottleParams(params);
+
+    LOG(INFO) << "DiskCacheWrite upload option, min concurrency: "
+              << concurrencyOption.minConcurrency
+              << ", max concurrency: " << concurrencyOption.maxConcurrency
+              << ", latency tolerance percent: "
+              << concurrencyOption.latencyTolerancePercent
+              << ", max retry interval ms: " << maxRetryIntervalMs_
+              << ", stop timeout ms: " << stopTimeoutMs_
+              << ", avg upload bytes: " << option.avgUploadBytes;
+}
+
 void DiskCacheWrite::AsyncUploadEnqueue(const std::string objName) {
     std::lock_guard<std::mutex> lock(mtx_);
     waitUpload_.push_back(objName);
+    cond_.notify_all();
 }
 
 int DiskCacheWrite::ReadFile(const std::string name, char **buf,
@@ -135,43 +161,159 @@ int DiskCacheWrite::UploadFile(const std::string &name,
         return -1;
     }
     VLOG(9) << "async upload start, file = " << name;
+    // files waited by fsync are neither limited nor throttled
+    bool urgent = (syncTask != nullptr);
+    if (!urgent) {
+        uploadThrottle_.Add(false, fileSize);
+    }
+    uint32_t retry = 0;
     PutObjectAsyncCallBack cb =
-        [&, buffer, syncTask, name]
-            (const std::shared_ptr<PutObjectAsyncContext> &context) {
-            if (context->retCode == 0) {
-                if (metric_ != nullptr) {
-                    metric_->writeS3.bps.count << context->bufferSize;
-                    metric_->writeS3.qps.count << 1;
-                    metric_->writeS3.latency
-                        << (butil::cpuwide_time_us() - context->startTime);
-                }
-                RemoveFile(context->key);
-                VLOG(9) << " PutObjectAsyncCallBack success, "
-                        << "remove file: " << context->key;
-                posixWrapper_->free(buffer);
-                if (syncTask) {
-                    VLOG(9) << "UploadFile, name = "
-                            << name << " signal start";
-                    syncTask->Signal();
-                    VLOG(9) << "UploadFile, name = "
-                            << name << " signal finish";
-                }
+        [&, buffer, syncTask, name, urgent, retry]
+            (const std::shared_ptr<PutObjectAsyncContext> &context) mutable {
+            if (context->retCode != 0) {
+                // the file is left in the write cache if it's given up
+                auto giveUp = [this, buffer, syncTask]() {
+                    posixWrapper_->free(buffer);
+                    if (syncTask) {
+                        syncTask->SetError();
+                        syncTask->Signal();
+                    }
+                };
+                OnUploadFinish(context, ++retry, urgent, giveUp);
                 return;
             }
-            LOG(WARNING) << "upload object failed: " << context->key;
-            client_->UploadAsync(context);
+            if (metric_ != nullptr) {
+                metric_->writeS3.bps.count << context->bufferSize;
+                metric_->writeS3.qps.count << 1;
+                metric_->writeS3.latency
+                    << (butil::cpuwide_time_us() - context->startTime);
+            }
+            RemoveFile(context->key);
+            VLOG(9) << " PutObjectAsyncCallBack success, "
+                    << "remove file: " << context->key;
+            posixWrapper_->free(buffer);
+            if (syncTask) {
+                VLOG(9) << "UploadFile, name = "
+                        << name << " signal start";
+                syncTask->Signal();
+                VLOG(9) << "UploadFile, name = "
+                        << name << " signal finish";
+            }
+            OnUploadFinish(context, retry, urgent);
         };
     auto context = std::make_shared<PutObjectAsyncContext>();
     context->key = name;
     context->buffer = buffer;
     context->bufferSize = fileSize;
     context->cb = cb;
-    context->startTime = butil::cpuwide_time_us();
-    client_->UploadAsync(context);
+    DoUpload(context);
     VLOG(9) << "async upload end, file = " << name;
     return 0;
 }
 
+void DiskCacheWrite::DoUpload(
+    const std::shared_ptr<PutObjectAsyncContext> &context) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        inflight_++;
+    }
+    if (metric_ != nullptr) {
+        metric_->uploadInflight << 1;
+    }
+    context->startTime = butil::cpuwide_time_us();
+    client_->UploadAsync(context);
+}
+
+void DiskCacheWrite::OnUploadFinish(
+    const std::shared_ptr<PutObjectAsyncContext> &context, uint32_t retry,
+    bool urgent, const std::function<void()> &giveUp) {
+    bool success = (context->retCode == 0);
+    controller_->OnComplete(butil::cpuwide_time_us() - context->startTime,
+                            context->bufferSize, success);
+    if (metric_ != nullptr) {
+        metric_->uploadInflight << -1;
+        metric_->uploadConcurrency.set_value(controller_->Limit());
+        if (!success) {
+            metric_->uploadRetry << 1;
+        }
+    }
+
+    if (success) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        inflight_--;
+        cond_.notify_all();
+        return;
+    }
+
+    uint64_t intervalMs = UploadRetryIntervalMs(retry, maxRetryIntervalMs_);
+    LOG(WARNING) << "upload object failed: " << context->key
+                 << ", retry: " << retry << ", retry after ms: " << intervalMs;
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    inflight_--;
+    if (giveUpRetry_) {
+        LOG(WARNING) << "give up uploading object: " << context->key
+                     << ", it will be uploaded at next mount";
+        cond_.notify_all();
+        lock.unlock();
+        if (giveUp) {
+            giveUp();
+        }
+        return;
+    }
+    if (!isRunning_.load()) {
+        // no upload thread to retry it, retry here
+        lock.unlock();
+        DoUpload(context);
+        return;
+    }
+    retryUpload_.push_back(RetryTask{
+        context, butil::cpuwide_time_us() + intervalMs * 1000, urgent,
+        giveUp});
+    cond_.notify_all();
+}
+
+void DiskCacheWrite::GiveUpRetryLocked(std::unique_lock<std::mutex> *lock) {
+    LOG(WARNING) << "uploads are not done in " << stopTimeoutMs_
+                 << "ms when stopping, give up " << retryUpload_.size()
+                 << " failed uploads, " << waitUpload_.size()
+                 << " files are not uploaded, " << inflight_
+                 << " uploads are inflight";
+    giveUpRetry_ = true;
+    // the files are left in the write cache, and uploaded at next mount
+    waitUpload_.clear();
+    std::list<RetryTask> toGiveUp;
+    toGiveUp.swap(retryUpload_);
+    lock->unlock();
+    for (auto &task : toGiveUp) {
+        if (task.giveUp) {
+            task.giveUp();
+        }
+    }
+    lock->lock();
+    // the inflight uploads are given up by OnUploadFinish if they fail
+    while (inflight_ > 0) {
+        cond_.wait_for(*lock, std::chrono::milliseconds(asyncLoadPeriodMs_));
+    }
+}
+
+bool DiskCacheWrite::PopRetryTask(bool urgentOnly, RetryTask *task) {
+    uint64_t now = butil::cpuwide_time_us();
+    for (auto iter = retryUpload_.begin(); iter != retryUpload_.end();
+         ++iter) {
+        if (iter->retryTimeUs <= now && (!urgentOnly || iter->urgent)) {
+            *task = *iter;
+            retryUpload_.erase(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DiskCacheWrite::UploadIdle() {
+    return waitUpload_.empty() && retryUpload_.empty() && inflight_ == 0;
+}
+
 void DiskCacheWrite::UploadFile(const std::list<std::string> &toUpload,
                                 std::shared_ptr<SynchronizationTask> syncTask) {
     std::list<std::string>::const_iterator iter;
@@ -187,6 +329,16 @@ bool DiskCacheWrite::WriteCacheValid() {
 int DiskCacheWrite::GetUploadFile(const std::string &inode,
                                   std::list<std::string> *toUpload) {
     std::unique_lock<std::mutex> lock(mtx_);
+    if (!inode.empty()) {
+        // failed uploads of the inode are waited by fsync now, retry them first
+        for (auto &task : retryUpload_) {
+            if (curvefs::common::s3util::ValidNameOfInode(
+                    inode, task.context->key, objectPrefix_)) {
+                task.urgent = true;
+                task.retryTimeUs = 0;
+            }
+        }
+    }
     if (waitUpload_.empty()) {
         return 0;
     }
@@ -274,56 +426,102 @@ int DiskCacheWrite::AsyncUploadFunc() {
         return -1;
     }
 
-    std::list<std::string> toUpload;
-    std::shared_ptr<SynchronizationTask> syncTask;
-
     VLOG(3) << "async upload function start.";
-    while (sleeper_.wait_for(std::chrono::milliseconds(asyncLoadPeriodMs_))) {
-        if (!isRunning_) {
-            LOG(INFO) << "async upload thread stop.";
-            return 0;
-        }
-        toUpload.clear();
-        int num = GetUploadFile("", &toUpload);
-        if (num <= 0) {
+    while (true) {
+        std::string toUpload;
+        RetryTask toRetry;
+        bool retry = false;
+        {
             std::unique_lock<std::mutex> lock(mtx_);
-            if (waitUpload_.empty()) {
-                cond_.notify_all();
+            while (isRunning_ &&
+                   !NextUploadLocked(&toUpload, &toRetry, &retry)) {
+                if (UploadIdle()) {
+                    cond_.notify_all();
+                }
+                cond_.wait_for(lock,
+                               std::chrono::milliseconds(asyncLoadPeriodMs_));
+            }
+            if (!isRunning_) {
+                LOG(INFO) << "async upload thread stop.";
+                return 0;
             }
-            continue;
         }
-        VLOG(6) << "async upload file size = " << num;
-        syncTask.reset(new SynchronizationTask(num));
-        UploadFile(toUpload, syncTask);
-        VLOG(6) << "async upload all files";
-    }
 
-    if (syncTask) {
-        syncTask->Wait();
+        // upload without lock, callback may be called in this thread
+        if (retry) {
+            if (!toRetry.urgent) {
+                uploadThrottle_.Add(false, toRetry.context->bufferSize);
+            }
+            DoUpload(toRetry.context);
+        } else {
+            VLOG(6) << "async upload file: " << toUpload;
+            UploadFile(toUpload);
+        }
     }
     return 0;
 }
 
+bool DiskCacheWrite::NextUploadLocked(std::string *toUpload,
+                                      RetryTask *toRetry, bool *retry) {
+    if (giveUpRetry_) {
+        return false;
+    }
+    // retries waited by fsync go first and are not limited,
+    // others are fed as long as the adaptive limit allows
+    *retry = PopRetryTask(true, toRetry);
+    if (*retry) {
+        return true;
+    }
+    if (inflight_ >= controller_->Limit()) {
+        return false;
+    }
+    *retry = PopRetryTask(false, toRetry);
+    if (*retry) {
+        return true;
+    }
+    if (waitUpload_.empty()) {
+        return false;
+    }
+    *toUpload = waitUpload_.front();
+    waitUpload_.pop_front();
+    return true;
+}
+
 int DiskCacheWrite::AsyncUploadRun() {
     if (isRunning_.exchange(true)) {
         LOG(INFO) << "AsyncUpload thread is on running.";
         return -1;
     }
     LOG(INFO) << "AsyncUpload thread is on running.";
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        giveUpRetry_ = false;
+    }
     backEndThread_ = std::thread(&DiskCacheWrite::AsyncUploadFunc, this);
     return 0;
 }
 
 int DiskCacheWrite::AsyncUploadStop() {
     if (isRunning_.load()) {
+        // s3 may be unavailable for long, don't retry forever
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(stopTimeoutMs_);
         std::unique_lock<std::mutex> lock(mtx_);
-        while (!waitUpload_.empty()) {
+        while (!UploadIdle()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                GiveUpRetryLocked(&lock);
+                break;
+            }
             cond_.wait_for(lock, std::chrono::milliseconds(asyncLoadPeriodMs_));
         }
     }
     if (isRunning_.exchange(false)) {
         LOG(INFO) << "stop AsyncUpload thread...";
-        sleeper_.interrupt();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            cond_.notify_all();
+        }
+        uploadThrottle_.Stop();
         backEndThread_.join();
         LOG(INFO) << "stop AsyncUpload thread ok.";
         return -1;
@@ -23,9 +23,11 @@
 #define CURVEFS_SRC_CLIENT_S3_DISK_CACHE_WRITE_H_
 
 #include <sys/stat.h>
+#include <gtest/gtest_prod.h>
 #include <bthread/condition_variable.h>
 #include <bthread/mutex.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <list>
@@ -42,6 +44,7 @@
 #include "curvefs/src/client/s3/disk_cache_read.h"
 #include "curvefs/src/client/common/config.h"
 #include "curvefs/src/client/s3/disk_cache_base.h"
+#include "curvefs/src/client/s3/upload_concurrency_controller.h"
 
 namespace curvefs {
 namespace client {
@@ -50,6 +53,10 @@ using curvefs::common::PosixWrapper;
 using curve::common::InterruptibleSleeper;
 using ::curve::common::SglLRUCache;
 using curve::common::PutObjectAsyncCallBack;
+using curve::common::ReadWriteThrottleParams;
+using curve::common::Throttle;
+using curve::common::ThrottleParams;
+using ::curvefs::client::common::DiskCacheOption;
 
 class DiskCacheWrite : public DiskCacheBase {
  public:
@@ -76,7 +83,11 @@ class DiskCacheWrite : public DiskCacheBase {
     // init isRunning_ should here，
     // otherwise when call AsyncUploadStop in ~DiskCacheWrite will failed:
     // "terminate called after throwing an instance of 'std::system_error'"
-    DiskCacheWrite() : isRunning_(false) {}
+    DiskCacheWrite()
+        : isRunning_(false), inflight_(0), giveUpRetry_(false),
+          maxRetryIntervalMs_(kDefaultMaxRetryIntervalMs),
+          stopTimeoutMs_(kDefaultStopTimeoutMs),
+          controller_(new UploadConcurrencyController()) {}
     virtual ~DiskCacheWrite() {
        AsyncUploadStop();
     }
@@ -85,6 +96,11 @@ class DiskCacheWrite : public DiskCacheBase {
               const std::string cacheDir, uint32_t objectPrefix,
               uint64_t asyncLoadPeriodMs,
               std::shared_ptr<SglLRUCache<std::string>> cachedObjName);
+    /**
+     * @brief init the concurrency, retry and bandwidth policy of
+     *        the background upload, must be called before AsyncUploadRun
+     */
+    virtual void InitUploadOption(const DiskCacheOption &option);
     /**
      * @brief write obj to write cache disk
      * @param[in] client S3Client
@@ -105,7 +121,8 @@ class DiskCacheWrite : public DiskCacheBase {
     virtual int ReadFile(const std::string name, char** buf,
       uint64_t* size);
     /**
-     * @brief upload file in write cache to S3
+     * @brief upload file in write cache to S3, failed upload is retried
+     *        by the background upload thread if it is running
      * @param[in] name file name
      * @param[in] syncTask wait upload finish
      * @return success: 0, fail : < 0
@@ -114,10 +131,15 @@ class DiskCacheWrite : public DiskCacheBase {
     UploadFile(const std::string &name,
                std::shared_ptr<SynchronizationTask> syncTask = nullptr);
 
+    /**
+     * @brief upload all files of the inode and wait for them, these files
+     *        bypass the concurrency limit of the background upload
+     */
     virtual int UploadFileByInode(const std::string &inode);
 
     /**
-     * @brief: start async upload thread
+     * @brief: start async upload thread, which keeps feeding files to s3
+     *         as long as inflight uploads are under the adaptive limit
      */
     virtual int AsyncUploadRun();
     /**
@@ -126,7 +148,9 @@ class DiskCacheWrite : public DiskCacheBase {
      */
     virtual void AsyncUploadEnqueue(const std::string objName);
     /**
-     * @brief: stop async upload thread.
+     * @brief: stop async upload thread after the uploads are done, the
+     *         failed uploads are given up if they are not done in time,
+     *         their files are left to be uploaded at next mount
      */
     virtual int AsyncUploadStop();
 
@@ -140,10 +164,35 @@ class DiskCacheWrite : public DiskCacheBase {
     virtual bool IsCacheClean();
 
  private:
+    FRIEND_TEST(TestDiskCacheWrite, NextUploadUrgentFirst);
+    FRIEND_TEST(TestDiskCacheWrite, RetryBackoffAndStopTimeout);
+
+    struct RetryTask {
+        std::shared_ptr<PutObjectAsyncContext> context;
+        // retry no earlier than this time
+        uint64_t retryTimeUs;
+        // the upload is waited by fsync
+        bool urgent;
+        // release the upload if it's given up
+        std::function<void()> giveUp;
+    };
+
+    static constexpr uint64_t kDefaultMaxRetryIntervalMs = 10000;
+    static constexpr uint64_t kDefaultStopTimeoutMs = 60000;
+
     using DiskCacheBase::Init;
     int AsyncUploadFunc();
     void UploadFile(const std::list<std::string> &toUpload,
                     std::shared_ptr<SynchronizationTask> syncTask = nullptr);
+    void DoUpload(const std::shared_ptr<PutObjectAsyncContext> &context);
+    void OnUploadFinish(const std::shared_ptr<PutObjectAsyncContext> &context,
+                        uint32_t retry, bool urgent,
+                        const std::function<void()> &giveUp = nullptr);
+    void GiveUpRetryLocked(std::unique_lock<std::mutex> *lock);
+    bool NextUploadLocked(std::string *toUpload, RetryTask *toRetry,
+                          bool *retry);
+    bool PopRetryTask(bool urgentOnly, RetryTask *task);
+    bool UploadIdle();
     bool WriteCacheValid();
     int GetUploadFile(const std::string &inode,
                       std::list<std::string> *toUpload);
@@ -152,6 +201,12 @@ class DiskCacheWrite : public DiskCacheBase {
     curve::common::Thread backEndThread_;
     curve::common::Atomic<bool> isRunning_;
     std::list<std::string> waitUpload_;
+    // failed uploads waiting for retry
+    std::list<RetryTask> retryUpload_;
+    // number of uploads sent to s3 and not finished
+    uint32_t inflight_;
+    // stopping timed out, failed uploads are given up instead of retried
+    bool giveUpRetry_;
     std::mutex mtx_;
     std::condition_variable cond_;
     InterruptibleSleeper sleeper_;
@@ -162,6 +217,12 @@ class DiskCacheWrite : public DiskCacheBase {
     std::shared_ptr<DiskCacheMetric> metric_;
 
     std::shared_ptr<SglLRUCache<std::string>> cachedObjName_;
+
+    uint64_t maxRetryIntervalMs_;
+    uint64_t stopTimeoutMs_;
+    std::unique_ptr<UploadConcurrencyController> controller_;
+    // bandwidth of the background upload
+    Throttle uploadThrottle_;
 };
 
 }  // namespace client
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-10
+ */
+
+#include "curvefs/src/client/s3/upload_concurrency_controller.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace curvefs {
+namespace client {
+
+namespace {
+// shrink ratio when the backend is overloaded
+constexpr double kDecreaseRatio = 0.75;
+// growth is stopped if throughput drops below this ratio of the last window
+constexpr double kThroughputDropRatio = 0.95;
+// interval before the first retry of a failed upload is twice this
+constexpr uint64_t kBaseRetryIntervalMs = 100;
+// retry interval stops doubling after so many failures
+constexpr uint32_t kMaxRetryIntervalShift = 16;
+}  // namespace
+
+UploadConcurrencyController::UploadConcurrencyController(
+    const UploadConcurrencyOption &option)
+    : option_(option),
+      minLatencyUs_(0),
+      windowsSinceMinReset_(0),
+      windowSamples_(0),
+      windowErrors_(0),
+      windowLatencyUs_(0),
+      windowBytes_(0),
+      lastThroughput_(0) {
+    option_.minConcurrency = std::max<uint32_t>(option_.minConcurrency, 1);
+    option_.maxConcurrency =
+        std::max(option_.maxConcurrency, option_.minConcurrency);
+    limit_ = option_.minConcurrency;
+}
+
+uint32_t UploadConcurrencyController::Limit() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return limit_;
+}
+
+void UploadConcurrencyController::OnComplete(uint64_t latencyUs,
+                                             uint64_t bytes, bool success) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    windowSamples_++;
+    if (!success) {
+        windowErrors_++;
+    } else {
+        windowLatencyUs_ += latencyUs;
+        windowBytes_ += bytes;
+        if (minLatencyUs_ == 0 || latencyUs < minLatencyUs_) {
+            minLatencyUs_ = std::max<uint64_t>(latencyUs, 1);
+        }
+    }
+
+    if (windowSamples_ >= limit_) {
+        EndWindowLocked();
+    }
+}
+
+void UploadConcurrencyController::EndWindowLocked() {
+    uint32_t succeeded = windowSamples_ - windowErrors_;
+    uint32_t oldLimit = limit_;
+
+    if (windowErrors_ > 0 || succeeded == 0) {
+        limit_ = static_cast<uint32_t>(limit_ * kDecreaseRatio);
+    } else {
+        uint64_t avgLatencyUs = windowLatencyUs_ / succeeded;
+        // Little's law: throughput = inflight / latency
+        double throughput = static_cast<double>(windowBytes_) * limit_ /
+                            std::max<uint64_t>(windowLatencyUs_, 1);
+        if (avgLatencyUs * 100 >
+            minLatencyUs_ * option_.latencyTolerancePercent) {
+            limit_ = static_cast<uint32_t>(limit_ * kDecreaseRatio);
+        } else if (throughput >= lastThroughput_ * kThroughputDropRatio) {
+            limit_++;
+        }
+        lastThroughput_ = throughput;
+
+        if (++windowsSinceMinReset_ >= option_.minLatencyResetWindows) {
+            windowsSinceMinReset_ = 0;
+            minLatencyUs_ = std::max<uint64_t>(avgLatencyUs, 1);
+        }
+    }
+
+    limit_ = std::min(std::max(limit_, option_.minConcurrency),
+                      option_.maxConcurrency);
+    VLOG_IF(6, limit_ != oldLimit)
+        << "upload concurrency limit changed from " << oldLimit << " to "
+        << limit_ << ", samples: " << windowSamples_
+        << ", errors: " << windowErrors_;
+
+    windowSamples_ = 0;
+    windowErrors_ = 0;
+    windowLatencyUs_ = 0;
+    windowBytes_ = 0;
+}
+
+uint64_t UploadRetryIntervalMs(uint32_t retry, uint64_t maxIntervalMs) {
+    return std::min(
+        kBaseRetryIntervalMs << std::min(retry, kMaxRetryIntervalShift),
+        maxIntervalMs);
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-10
+ */
+
+#ifndef CURVEFS_SRC_CLIENT_S3_UPLOAD_CONCURRENCY_CONTROLLER_H_
+#define CURVEFS_SRC_CLIENT_S3_UPLOAD_CONCURRENCY_CONTROLLER_H_
+
+#include <cstdint>
+#include <mutex>
+
+namespace curvefs {
+namespace client {
+
+struct UploadConcurrencyOption {
+    // lower bound of concurrent uploads
+    uint32_t minConcurrency = 4;
+    // upper bound of concurrent uploads
+    uint32_t maxConcurrency = 128;
+    // the limit shrinks if the average latency of a window exceeds
+    // the observed minimum latency by this percentage
+    uint32_t latencyTolerancePercent = 200;
+    // the observed minimum latency is reset after this many windows,
+    // so the controller can follow changes of the s3 backend
+    uint32_t minLatencyResetWindows = 100;
+};
+
+/**
+ * Adaptive limit of inflight s3 uploads.
+ *
+ * Completions are accounted in windows of `limit` samples. At the end of
+ * a window the limit is decreased multiplicatively if requests failed or
+ * the average latency grew beyond tolerance (the backend is queueing),
+ * and increased additively if latency is fine and throughput did not drop.
+ */
+class UploadConcurrencyController {
+ public:
+    explicit UploadConcurrencyController(
+        const UploadConcurrencyOption &option = UploadConcurrencyOption());
+
+    /**
+     * @brief current limit of inflight uploads
+     */
+    uint32_t Limit() const;
+
+    /**
+     * @brief feed the result of one finished upload
+     * @param[in] latencyUs latency of the upload
+     * @param[in] bytes size of the uploaded object
+     * @param[in] success whether the upload succeeded
+     */
+    void OnComplete(uint64_t latencyUs, uint64_t bytes, bool success);
+
+ private:
+    void EndWindowLocked();
+
+ private:
+    UploadConcurrencyOption option_;
+    mutable std::mutex mtx_;
+    uint32_t limit_;
+
+    // minimum latency seen recently, 0 means unknown
+    uint64_t minLatencyUs_;
+    uint32_t windowsSinceMinReset_;
+
+    // statistics of the current window
+    uint32_t windowSamples_;
+    uint32_t windowErrors_;
+    uint64_t windowLatencyUs_;
+    uint64_t windowBytes_;
+
+    // estimated throughput of the last finished window
+    double lastThroughput_;
+};
+
+/**
+ * @brief the interval before retrying a failed upload, which doubles with
+ *        every retry from 200ms, so one broken object or an unavailable s3
+ *        does not occupy the upload slots
+ * @param[in] retry number of failures of the upload, starting from 1
+ * @param[in] maxIntervalMs upper bound of the interval
+ */
+uint64_t UploadRetryIntervalMs(uint32_t retry, uint64_t maxIntervalMs);
+
+}  // namespace client
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_CLIENT_S3_UPLOAD_CONCURRENCY_CONTROLLER_H_
@@ -58,6 +58,7 @@ bvar::LatencyRecorder g_mark_written_latency("extent_cache_mark_written");
 
 std::ostream& operator<<(std::ostream& os, const ExtentCacheOption& opt) {
     os << "prealloc size: " << opt.preAllocSize
+       << ", max prealloc size: " << opt.maxPreAllocSize
        << ", slice size: " << opt.sliceSize
        << ", block size: " << opt.blockSize;
 
@@ -106,6 +107,9 @@ void ExtentCache::DivideForWrite(uint64_t offset,
 
     const auto end = offset + len;
     const char* datap = data;
+    const auto numAlloc = needAlloc->size();
+    bool sequential = false;
+    const auto preAllocSize = PreAllocSize(offset, &sequential);
 
     while (offset < end) {
         const auto length = std::min(
@@ -113,21 +117,49 @@ void ExtentCache::DivideForWrite(uint64_t offset,
 
         auto slice = slices_.find(align_down(offset, option_.sliceSize));
         if (slice != slices_.end()) {
-            slice->second.DivideForWrite(offset, length, datap, allocated,
-                                         needAlloc);
+            slice->second.DivideForWrite(offset, length, datap, preAllocSize,
+                                         allocated, needAlloc);
         } else {
-            DivideForWriteWithinEmptySlice(offset, length, datap, needAlloc);
+            DivideForWriteWithinEmptySlice(offset, length, datap, preAllocSize,
+                                           needAlloc);
         }
 
         datap += length;
         offset += length;
     }
+
+    UpdatePreAllocWindow(end, sequential, needAlloc->size() > numAlloc);
+}
+
+uint64_t ExtentCache::PreAllocSize(uint64_t offset, bool* sequential) {
+    std::lock_guard<std::mutex> lk(seqMtx_);
+    *sequential = (offset != 0 && offset == seqEnd_);
+    if (!*sequential || preAllocWindow_ < option_.preAllocSize) {
+        preAllocWindow_ = option_.preAllocSize;
+    }
+    return preAllocWindow_;
+}
+
+void ExtentCache::UpdatePreAllocWindow(uint64_t end,
+                                       bool sequential,
+                                       bool allocated) {
+    std::lock_guard<std::mutex> lk(seqMtx_);
+    seqEnd_ = end;
+    // grow the window only when the preallocated space is used up, so
+    // sequential writers get larger and contiguous physical ranges, and
+    // each window needs only one extent update
+    if (sequential && allocated) {
+        preAllocWindow_ = std::min(
+            preAllocWindow_ * 2,
+            std::max(option_.preAllocSize, option_.maxPreAllocSize));
+    }
 }
 
 void ExtentCache::DivideForWriteWithinEmptySlice(
     uint64_t offset,
     uint64_t len,
     const char* data,
+    uint64_t preAllocSize,
     std::vector<AllocPart>* needAlloc) {
     AllocPart part;
     part.data = data;
@@ -138,11 +170,11 @@ void ExtentCache::DivideForWriteWithinEmptySlice(
     uint64_t alloclength = 0;
     if (offset == alignedoffset) {
         alloclength =
-            align_up(std::max(len, option_.preAllocSize), option_.blockSize);
+            align_up(std::max(len, preAllocSize), option_.blockSize);
     } else {
         auto alignedend = align_up(offset + len, option_.blockSize);
         alloclength =
-            align_up(std::max(alignedend - alignedoffset, option_.preAllocSize),
+            align_up(std::max(alignedend - alignedoffset, preAllocSize),
                      option_.blockSize);
     }
 
@@ -243,6 +275,10 @@ void ExtentCache::SetOption(const ExtentCacheOption& option) {
     CHECK(is_alignment(option.preAllocSize))
         << "prealloc size must be power of 2, current is "
         << option.preAllocSize;
+    CHECK(option.maxPreAllocSize == 0 ||
+          is_alignment(option.maxPreAllocSize))
+        << "max prealloc size must be power of 2, current is "
+        << option.maxPreAllocSize;
     CHECK(is_alignment(option.sliceSize))
         << "slice size must be power of 2, current is " << option.sliceSize;
     CHECK(is_alignment(option.blockSize))
@@ -27,6 +27,7 @@
 
 #include <cstring>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -49,6 +50,9 @@ struct ExtentCacheOption {
     // preallocation size if offset ~ length is not allocated
     // TODO(wuhanqing): preallocation size should take care of file size
     uint64_t preAllocSize = 64ULL * 1024;
+    // preallocation size of sequential writes doubles on each allocation
+    // until it reaches this size, 0 means not growing
+    uint64_t maxPreAllocSize = 0;
     // a single file's extents are split by offset, and each one called `slice`
     uint64_t sliceSize = 1ULL * 1024 * 1024 * 1024;
     // minimum allocate and read/write unit
@@ -91,8 +95,14 @@ class ExtentCache {
         uint64_t offset,
         uint64_t len,
         const char* data,
+        uint64_t preAllocSize,
         std::vector<AllocPart>* needAlloc);
 
+    // preallocation size for write at |offset|
+    uint64_t PreAllocSize(uint64_t offset, bool* sequential);
+
+    void UpdatePreAllocWindow(uint64_t end, bool sequential, bool allocated);
+
  private:
     mutable curve::common::RWLock lock_;
 
@@ -102,6 +112,14 @@ class ExtentCache {
     // dirty slices
     std::unordered_set<ExtentSlice*> dirties_;
 
+    // protects |seqEnd_| and |preAllocWindow_|, writes may divide
+    // concurrently under read lock of |lock_|
+    std::mutex seqMtx_;
+    // end offset of last write
+    uint64_t seqEnd_ = 0;
+    // current preallocation size of sequential writes
+    uint64_t preAllocWindow_ = 0;
+
  private:
     friend class ExtentSlice;
 
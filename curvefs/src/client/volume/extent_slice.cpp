@@ -88,6 +88,7 @@ VolumeExtentSlice ExtentSlice::ToVolumeExtentSlice() const {
 void ExtentSlice::DivideForWrite(uint64_t offset,
                                  uint64_t len,
                                  const char* data,
+                                 uint64_t preAllocSize,
                                  std::vector<WritePart>* allocated,
                                  std::vector<AllocPart>* needAlloc) const {
     uint64_t curOff = offset;
@@ -233,8 +234,7 @@ void ExtentSlice::DivideForWrite(uint64_t offset,
 
         part.allocInfo.lOffset = alignedoffset;
         part.allocInfo.len =
-            align_up(std::max(alignedend - alignedoffset,
-                              ExtentCache::option_.preAllocSize),
+            align_up(std::max(alignedend - alignedoffset, preAllocSize),
                      ExtentCache::option_.blockSize);
 
         if (upper != extents_.end()) {
@@ -368,7 +368,10 @@ void ExtentSlice::Merge(uint64_t loffset, const PExtent &extent) {
         --it;
     }
 
-    if (!it->second.UnWritten && it->first + it->second.len == loffset &&
+    // merge only written extents, otherwise preallocated space will be read
+    // as written
+    if (!it->second.UnWritten && !extent.UnWritten &&
+        it->first + it->second.len == loffset &&
         it->second.pOffset + it->second.len == extent.pOffset) {
         it->second.len += extent.len;
         inserted = it;
@@ -384,7 +387,8 @@ void ExtentSlice::Merge(uint64_t loffset, const PExtent &extent) {
         return;
     }
 
-    if (!it->second.UnWritten && it != extents_.end() && it->first == endOff &&
+    if (!it->second.UnWritten && !inserted->second.UnWritten &&
+        it->first == endOff &&
         inserted->second.pOffset + inserted->second.len == it->second.pOffset) {
         inserted->second.len += it->second.len;
         extents_.erase(it);
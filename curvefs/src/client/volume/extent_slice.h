@@ -46,6 +46,7 @@ class ExtentSlice {
     void DivideForWrite(uint64_t offset,
                         uint64_t len,
                         const char* data,
+                        uint64_t preAllocSize,
                         std::vector<WritePart>* allocated,
                         std::vector<AllocPart>* needAlloc) const;
 
@@ -528,6 +528,15 @@ void WarmupManagerS3Impl::WarmUpAllObjs(
             context->len = readLen;
             context->cb = cb;
             context->retry = 0;
+            auto cachePeerClient = s3Adaptor_->GetCachePeerClient();
+            if (cachePeerClient != nullptr &&
+                cachePeerClient->Fetch(name, readLen, cacheS3, 0, readLen)) {
+                VLOG(9) << "download from cache peer ok: " << name;
+                context->retCode = 0;
+                context->actualLen = readLen;
+                cb(nullptr, context);
+                continue;
+            }
             s3Adaptor_->GetS3Client()->DownloadAsync(context);
         }
         if (pendingReq.load())
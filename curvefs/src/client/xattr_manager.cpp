@@ -423,6 +423,13 @@ CURVEFS_ERROR XattrManager::GetXattr(const char* name, std::string *value,
         // need recursive computation all files;
         // otherwise only recursive computation all dirs.
         if (!enableSumInDir) {
+            // files created locally must be persisted to be listed
+            ret = inodeManager_->FlushPendingCreates(
+                IsOneLayer(name) ? attr->inodeid() : 0);
+            if (ret != CURVEFS_ERROR::OK) {
+                return ret;
+            }
+
             if (IsOneLayer(name)) {
                 ret = CalOneLayerSumInfo(attr);
             } else {
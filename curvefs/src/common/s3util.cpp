@@ -61,6 +61,27 @@ bool ValidNameOfInode(const std::string &inode, const std::string &objName,
         return false;
     }
 }
+
+bool ValidNameOfFs(uint64_t fsId, const std::string &objName,
+                   uint32_t objectPrefix) {
+    // the name is generated again from its parts, so that a name with
+    // extra path components is rejected too
+    std::string baseName = objName.substr(objName.find_last_of('/') + 1);
+    std::vector<std::string> res;
+    curve::common::SplitString(baseName, "_", &res);
+    if (res.size() != 5) {
+        return false;
+    }
+    uint64_t parts[5];
+    for (size_t i = 0; i < res.size(); i++) {
+        if (!curve::common::StringToUll(res[i], &parts[i])) {
+            return false;
+        }
+    }
+    return parts[0] == fsId &&
+           GenObjName(parts[2], parts[3], parts[4], parts[0], parts[1],
+                      objectPrefix) == objName;
+}
 }  // namespace s3util
 }  // namespace common
 }  // namespace curvefs
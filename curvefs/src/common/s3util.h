@@ -60,6 +60,10 @@ inline std::string GenObjName(uint64_t chunkid, uint64_t index,
 bool ValidNameOfInode(const std::string &inode, const std::string &objName,
                       uint32_t objectPrefix);
 
+// whether objName is the name of an object of the filesystem fsId
+bool ValidNameOfFs(uint64_t fsId, const std::string &objName,
+                   uint32_t objectPrefix);
+
 
 std::string GenPathByObjName(const std::string &objName, uint32_t objectPrefix);
 
@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-12
+ */
+
+#ifndef CURVEFS_SRC_METASERVER_COMMON_STRIPED_LOCK_H_
+#define CURVEFS_SRC_METASERVER_COMMON_STRIPED_LOCK_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "src/common/concurrent/rw_lock.h"
+#include "src/common/uncopyable.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using ::curve::common::RWLock;
+using ::curve::common::Uncopyable;
+
+// Two-level lock for a storage table.
+//
+// Operations on one key (e.g. an inode, or all dentries of a parent) take
+// the table lock in shared mode and the stripe which the key hashed to.
+// Operations on the whole table (e.g. clear) take the table lock in
+// exclusive mode. If the underlying storage can't be written in parallel,
+// keyed writes take the table lock in exclusive mode instead.
+class StripedTableLock : public Uncopyable {
+ public:
+    // stripes are not used if |parallel| is false
+    StripedTableLock(bool parallel, uint32_t stripes)
+        : parallel_(parallel),
+          locks_(parallel ? std::max<uint32_t>(stripes, 1) : 1) {}
+
+    static uint64_t HashKey(uint32_t fsId, uint64_t id) {
+        uint64_t key = id ^ (static_cast<uint64_t>(fsId) << 40);
+        // fibonacci hashing, spread sequential ids over stripes
+        return key * 0x9E3779B97F4A7C15ULL;
+    }
+
+    uint32_t StripeIndex(uint64_t hashKey) const {
+        return static_cast<uint32_t>((hashKey >> 32) % locks_.size());
+    }
+
+    RWLock& TableLock() { return tableLock_; }
+
+    RWLock& StripeLock(uint32_t index) { return locks_[index]; }
+
+    bool Parallel() const { return parallel_; }
+
+ private:
+    bool parallel_;
+    RWLock tableLock_;
+    std::vector<RWLock> locks_;
+};
+
+// Lock one or more keys, stripes are always locked in ascending order
+// so that guards locking several keys never deadlock with each other.
+class KeyLockGuard : public Uncopyable {
+ public:
+    KeyLockGuard(StripedTableLock& lock, uint32_t fsId, uint64_t id,
+                 bool write)
+        : KeyLockGuard(lock,
+                       std::vector<uint64_t>{
+                           StripedTableLock::HashKey(fsId, id)},
+                       write) {}
+
+    KeyLockGuard(StripedTableLock& lock, const std::vector<uint64_t>& hashKeys,
+                 bool write)
+        : lock_(lock) {
+        if (!lock_.Parallel()) {
+            if (write) {
+                lock_.TableLock().WRLock();
+            } else {
+                lock_.TableLock().RDLock();
+            }
+            return;
+        }
+
+        lock_.TableLock().RDLock();
+        for (auto hashKey : hashKeys) {
+            stripes_.push_back(lock_.StripeIndex(hashKey));
+        }
+        std::sort(stripes_.begin(), stripes_.end());
+        stripes_.erase(std::unique(stripes_.begin(), stripes_.end()),
+                       stripes_.end());
+        for (auto index : stripes_) {
+            if (write) {
+                lock_.StripeLock(index).WRLock();
+            } else {
+                lock_.StripeLock(index).RDLock();
+            }
+        }
+    }
+
+    ~KeyLockGuard() {
+        for (auto iter = stripes_.rbegin(); iter != stripes_.rend(); ++iter) {
+            lock_.StripeLock(*iter).Unlock();
+        }
+        lock_.TableLock().Unlock();
+    }
+
+ private:
+    StripedTableLock& lock_;
+    std::vector<uint32_t> stripes_;
+};
+
+// Lock the whole table
+class TableLockGuard : public Uncopyable {
+ public:
+    TableLockGuard(StripedTableLock& lock, bool write) : lock_(lock) {
+        if (write) {
+            lock_.TableLock().WRLock();
+        } else {
+            lock_.TableLock().RDLock();
+        }
+    }
+
+    ~TableLockGuard() { lock_.TableLock().Unlock(); }
+
+ private:
+    StripedTableLock& lock_;
+};
+
+}  // namespace metaserver
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_METASERVER_COMMON_STRIPED_LOCK_H_
@@ -180,10 +180,85 @@ void ApplyQueue::FlushAll() {
     event.Wait();
 }
 
+bool ApplyQueue::PushWithDependency(uint64_t partitionId,
+                                    const uint64_t* inodeId,
+                                    OperatorType optype,
+                                    const std::function<void()>& task) {
+    // readonly tasks are not ordered with writes, same as before
+    if (Schedule(optype) == ThreadPoolType::READ) {
+        return Push(partitionId, optype, task);
+    }
+
+    bool partitionWide = (inodeId == nullptr);
+    auto token = tracker_.Register(partitionId, partitionWide);
+    uint64_t key =
+        partitionWide ? partitionId : InodeKey(partitionId, *inodeId);
+    return Push(key, optype, &ApplyQueue::RunWithDependency, &tracker_,
+                token, task);
+}
+
+void ApplyQueue::RunWithDependency(ApplyDependencyTracker* tracker,
+                                   const ApplyDependencyTracker::Token& token,
+                                   const std::function<void()>& task) {
+    tracker->Wait(token);
+    task();
+    tracker->Done(token);
+}
+
+ApplyDependencyTracker::Token ApplyDependencyTracker::Register(
+    uint64_t partitionId, bool partitionWide) {
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    auto& state = partitions_[partitionId];
+    Token token{partitionId, partitionWide, 0, state.partitionTasksPushed};
+    if (partitionWide) {
+        token.waitInodeTasks = state.inodeTasksPushed;
+        state.partitionTasksPushed++;
+    } else {
+        state.inodeTasksPushed++;
+    }
+    return token;
+}
+
+void ApplyDependencyTracker::Wait(const Token& token) {
+    std::unique_lock<bthread::Mutex> lk(mtx_);
+    // partition tasks finish in order, and inode tasks registered after
+    // a partition task can't finish before it, so counters are enough
+    while (true) {
+        auto& state = partitions_[token.partitionId];
+        if (state.partitionTasksDone >= token.waitPartitionTasks &&
+            state.inodeTasksDone >= token.waitInodeTasks) {
+            return;
+        }
+        cond_.wait(lk);
+    }
+}
+
+void ApplyDependencyTracker::Done(const Token& token) {
+    {
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        auto iter = partitions_.find(token.partitionId);
+        CHECK(iter != partitions_.end());
+        auto& state = iter->second;
+        if (token.partitionWide) {
+            state.partitionTasksDone++;
+        } else {
+            state.inodeTasksDone++;
+        }
+
+        // no pending task, the state can be released
+        if (state.inodeTasksDone == state.inodeTasksPushed &&
+            state.partitionTasksDone == state.partitionTasksPushed) {
+            partitions_.erase(iter);
+        }
+    }
+    cond_.notify_all();
+}
+
 ThreadPoolType ApplyQueue::Schedule(OperatorType optype) {
     switch (optype) {
     case OperatorType::GetDentry:
     case OperatorType::ListDentry:
+    case OperatorType::ListDentryPlus:
     case OperatorType::GetInode:
     case OperatorType::BatchGetInodeAttr:
     case OperatorType::BatchGetXAttr:
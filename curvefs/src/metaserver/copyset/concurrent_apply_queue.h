@@ -28,6 +28,7 @@
 #include <glog/logging.h>
 
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <unordered_map>
 #include <utility>
@@ -59,6 +60,55 @@ struct ApplyOption {
 
 enum class ThreadPoolType {READ, WRITE};
 
+/**
+ * Track dependencies between write tasks of the same partition.
+ *
+ * Inode-local tasks (e.g., update inode) of one partition are hashed by
+ * (partition, inode) and can be applied in parallel. Partition-wide tasks
+ * (e.g., create inode/dentry, rename) must wait all previous tasks of the
+ * partition to finish, and all following tasks wait for them.
+ *
+ * A task only waits for tasks registered before it, and tasks are pushed
+ * to FIFO queues in register order, so waiting never deadlocks.
+ */
+class ApplyDependencyTracker {
+ public:
+    struct Token {
+        uint64_t partitionId;
+        bool partitionWide;
+        // number of finished tasks of each kind before this task can run
+        uint64_t waitInodeTasks;
+        uint64_t waitPartitionTasks;
+    };
+
+    /**
+     * @brief Register a task, must be called in apply order
+     */
+    Token Register(uint64_t partitionId, bool partitionWide);
+
+    /**
+     * @brief Block until all tasks which the token depends on finished
+     */
+    void Wait(const Token& token);
+
+    /**
+     * @brief Mark the task of the token finished
+     */
+    void Done(const Token& token);
+
+ private:
+    struct PartitionState {
+        uint64_t inodeTasksPushed = 0;
+        uint64_t inodeTasksDone = 0;
+        uint64_t partitionTasksPushed = 0;
+        uint64_t partitionTasksDone = 0;
+    };
+
+    bthread::Mutex mtx_;
+    bthread::ConditionVariable cond_;
+    std::unordered_map<uint64_t, PartitionState> partitions_;
+};
+
 /*
 TODO: this moudle is same as curvebs's ConcurrentApplyModule,
       only Schedule function is different.
@@ -108,6 +158,19 @@ class CURVE_CACHELINE_ALIGNMENT ApplyQueue {
         return true;
     }
 
+    /**
+     * PushWithDependency: push apply task of one partition, write tasks
+     *                     are ordered by the dependency tracker
+     * @param[in] partitionId: partition of the task
+     * @param[in] inodeId: inode which the task only touches,
+     *                     nullptr if the task is partition-wide
+     * @param[in] optype: operation type defined in proto
+     * @param[in] task: task
+     */
+    bool PushWithDependency(uint64_t partitionId, const uint64_t* inodeId,
+                            OperatorType optype,
+                            const std::function<void()>& task);
+
     /**
      * Flush: finish all task in write threads
      */
@@ -129,6 +192,15 @@ class CURVE_CACHELINE_ALIGNMENT ApplyQueue {
         return key % concurrent;
     }
 
+    static uint64_t InodeKey(uint64_t partitionId, uint64_t inodeId) {
+        // spread inodes of one partition over all queues
+        return partitionId ^ (inodeId * 0x9E3779B97F4A7C15ULL >> 16);
+    }
+
+    static void RunWithDependency(ApplyDependencyTracker* tracker,
+                                  const ApplyDependencyTracker::Token& token,
+                                  const std::function<void()>& task);
+
  private:
     struct TaskThread {
         std::thread th;
@@ -142,6 +214,7 @@ class CURVE_CACHELINE_ALIGNMENT ApplyQueue {
     int wconcurrentsize_;
     int wqueuedepth_;
     CountDownEvent cond_;
+    ApplyDependencyTracker tracker_;
     CURVE_CACHELINE_ALIGNMENT std::unordered_map<int, TaskThread*> wapplyMap_;
     CURVE_CACHELINE_ALIGNMENT std::unordered_map<int, TaskThread*> rapplyMap_;
 };
@@ -290,9 +290,8 @@ void CopysetNode::on_apply(braft::Iterator& iter) {
                 std::bind(&MetaOperator::OnApply, metaClosure->GetOperator(),
                           iter.index(), doneGuard.release(),
                           TimeUtility::GetTimeofDayUs());
-            applyQueue_->Push(metaClosure->GetOperator()->HashCode(),
-                              metaClosure->GetOperator()->GetOperatorType(),
-                              std::move(task));
+            metaClosure->GetOperator()->PushApplyTask(applyQueue_.get(),
+                                                      std::move(task));
             timer.stop();
             g_concurrent_apply_wait_latency << timer.u_elapsed();
         } else {
@@ -301,12 +300,11 @@ void CopysetNode::on_apply(braft::Iterator& iter) {
             CHECK(metaOperator != nullptr) << "Decode raft log failed";
             butil::Timer timer;
             timer.start();
-            auto hashcode = metaOperator->HashCode();
-            auto type = metaOperator->GetOperatorType();
-            auto task =
-                std::bind(&MetaOperator::OnApplyFromLog, metaOperator.release(),
-                          TimeUtility::GetTimeofDayUs());
-            applyQueue_->Push(hashcode, type, std::move(task));
+            auto* op = metaOperator.release();
+            auto task = std::bind(&MetaOperator::OnApplyFromLog, op,
+                                  TimeUtility::GetTimeofDayUs());
+            // `op` is deleted by the task after applied
+            op->PushApplyTask(applyQueue_.get(), std::move(task));
             timer.stop();
             g_concurrent_apply_from_log_wait_latency << timer.u_elapsed();
         }
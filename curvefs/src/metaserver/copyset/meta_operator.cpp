@@ -123,12 +123,20 @@ void MetaOperator::FastApplyTask() {
     auto task =
         std::bind(&MetaOperator::OnApply, this, node_->GetAppliedIndex(),
                   new MetaOperatorClosure(this), TimeUtility::GetTimeofDayUs());
-    node_->GetApplyQueue()->Push(HashCode(),
-                                 GetOperatorType(), std::move(task));
+    PushApplyTask(node_->GetApplyQueue(), std::move(task));
     timer.stop();
     g_concurrent_fast_apply_wait_latency << timer.u_elapsed();
 }
 
+void MetaOperator::PushApplyTask(ApplyQueue* applyQueue,
+                                 const std::function<void()>& task) const {
+    uint64_t inodeId = 0;
+    bool inodeLocal = GetInodeKey(&inodeId);
+    applyQueue->PushWithDependency(HashCode(),
+                                   inodeLocal ? &inodeId : nullptr,
+                                   GetOperatorType(), task);
+}
+
 #define OPERATOR_CAN_BY_PASS_PROPOSE(TYPE)                                     \
     bool TYPE##Operator::CanBypassPropose() const {                            \
         return true;                                                           \
@@ -137,6 +145,7 @@ void MetaOperator::FastApplyTask() {
 // below operator are readonly, so can enable lease read
 OPERATOR_CAN_BY_PASS_PROPOSE(GetDentry);
 OPERATOR_CAN_BY_PASS_PROPOSE(ListDentry);
+OPERATOR_CAN_BY_PASS_PROPOSE(ListDentryPlus);
 OPERATOR_CAN_BY_PASS_PROPOSE(GetInode);
 OPERATOR_CAN_BY_PASS_PROPOSE(BatchGetInodeAttr);
 OPERATOR_CAN_BY_PASS_PROPOSE(BatchGetXAttr);
@@ -180,6 +189,7 @@ OPERATOR_ON_APPLY(BatchGetInodeAttr);
 OPERATOR_ON_APPLY(BatchGetXAttr);
 OPERATOR_ON_APPLY(CreateInode);
 OPERATOR_ON_APPLY(UpdateInode);
+OPERATOR_ON_APPLY(BatchUpdateInode);
 OPERATOR_ON_APPLY(DeleteInode);
 OPERATOR_ON_APPLY(CreateRootInode);
 OPERATOR_ON_APPLY(CreateManageInode);
@@ -188,6 +198,8 @@ OPERATOR_ON_APPLY(DeletePartition);
 OPERATOR_ON_APPLY(PrepareRenameTx);
 OPERATOR_ON_APPLY(UpdateVolumeExtent);
 OPERATOR_ON_APPLY(UpdateDeallocatableBlockGroup);
+OPERATOR_ON_APPLY(CreateNode);
+OPERATOR_ON_APPLY(AllocInodeId);
 
 #undef OPERATOR_ON_APPLY
 
@@ -291,6 +303,55 @@ void GetVolumeExtentOperator::OnApply(int64_t index,
     }
 }
 
+void ListDentryPlusOperator::OnApply(int64_t index,
+                                     google::protobuf::Closure *done,
+                                     uint64_t startTimeUs) {
+    brpc::ClosureGuard doneGuard(done);
+    const auto *request = static_cast<const ListDentryPlusRequest *>(request_);
+    auto *response = static_cast<ListDentryPlusResponse *>(response_);
+    auto *metaStore = node_->GetMetaStore();
+
+    auto st = metaStore->ListDentryPlus(request, response);
+    node_->GetMetric()->OnOperatorComplete(
+        OperatorType::ListDentryPlus,
+        TimeUtility::GetTimeofDayUs() - startTimeUs, st == MetaStatusCode::OK);
+
+    if (st != MetaStatusCode::OK) {
+        return;
+    }
+
+    response->set_appliedindex(
+        std::max<uint64_t>(index, node_->GetAppliedIndex()));
+    if (!request->streaming()) {
+        return;
+    }
+
+    // in streaming mode, swap the first batch out and send all entries
+    // by streaming
+    DentryPlusList entries;
+    response->mutable_entries()->Swap(&entries);
+
+    auto *cntl = static_cast<brpc::Controller *>(cntl_);
+    auto connection = metaStore->GetStreamServer()->Accept(cntl);
+    if (connection == nullptr) {
+        LOG(ERROR) << "Accept streaming connection failed";
+        response->set_statuscode(MetaStatusCode::RPC_STREAM_ERROR);
+        return;
+    }
+
+    // run done
+    done->Run();
+    doneGuard.release();
+
+    st = metaStore->SendDentryPlusByStream(connection.get(), request,
+                                           &entries);
+    if (st != MetaStatusCode::OK) {
+        LOG(ERROR) << "Send dentries by stream failed, dir inodeid: "
+                   << request->dirinodeid()
+                   << ", error: " << MetaStatusCode_Name(st);
+    }
+}
+
 #define OPERATOR_ON_APPLY_FROM_LOG(TYPE)                                       \
     void TYPE##Operator::OnApplyFromLog(uint64_t startTimeUs) {                \
         std::unique_ptr<TYPE##Operator> selfGuard(this);                       \
@@ -306,6 +367,7 @@ OPERATOR_ON_APPLY_FROM_LOG(CreateDentry);
 OPERATOR_ON_APPLY_FROM_LOG(DeleteDentry);
 OPERATOR_ON_APPLY_FROM_LOG(CreateInode);
 OPERATOR_ON_APPLY_FROM_LOG(UpdateInode);
+OPERATOR_ON_APPLY_FROM_LOG(BatchUpdateInode);
 OPERATOR_ON_APPLY_FROM_LOG(DeleteInode);
 OPERATOR_ON_APPLY_FROM_LOG(CreateRootInode);
 OPERATOR_ON_APPLY_FROM_LOG(CreateManageInode);
@@ -314,6 +376,8 @@ OPERATOR_ON_APPLY_FROM_LOG(DeletePartition);
 OPERATOR_ON_APPLY_FROM_LOG(PrepareRenameTx);
 OPERATOR_ON_APPLY_FROM_LOG(UpdateVolumeExtent);
 OPERATOR_ON_APPLY_FROM_LOG(UpdateDeallocatableBlockGroup);
+OPERATOR_ON_APPLY_FROM_LOG(CreateNode);
+OPERATOR_ON_APPLY_FROM_LOG(AllocInodeId);
 
 #undef OPERATOR_ON_APPLY_FROM_LOG
 
@@ -341,6 +405,7 @@ void GetOrModifyS3ChunkInfoOperator::OnApplyFromLog(uint64_t startTimeUs) {
 // below operator are readonly, so on apply from log do nothing
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(GetDentry);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(ListDentry);
+READONLY_OPERATOR_ON_APPLY_FROM_LOG(ListDentryPlus);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(GetInode);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(BatchGetInodeAttr);
 READONLY_OPERATOR_ON_APPLY_FROM_LOG(BatchGetXAttr);
@@ -356,6 +421,7 @@ READONLY_OPERATOR_ON_APPLY_FROM_LOG(GetVolumeExtent);
 
 OPERATOR_REDIRECT(GetDentry);
 OPERATOR_REDIRECT(ListDentry);
+OPERATOR_REDIRECT(ListDentryPlus);
 OPERATOR_REDIRECT(CreateDentry);
 OPERATOR_REDIRECT(DeleteDentry);
 OPERATOR_REDIRECT(GetInode);
@@ -363,6 +429,7 @@ OPERATOR_REDIRECT(BatchGetInodeAttr);
 OPERATOR_REDIRECT(BatchGetXAttr);
 OPERATOR_REDIRECT(CreateInode);
 OPERATOR_REDIRECT(UpdateInode);
+OPERATOR_REDIRECT(BatchUpdateInode);
 OPERATOR_REDIRECT(GetOrModifyS3ChunkInfo);
 OPERATOR_REDIRECT(DeleteInode);
 OPERATOR_REDIRECT(CreateRootInode);
@@ -373,6 +440,8 @@ OPERATOR_REDIRECT(PrepareRenameTx);
 OPERATOR_REDIRECT(GetVolumeExtent);
 OPERATOR_REDIRECT(UpdateVolumeExtent);
 OPERATOR_REDIRECT(UpdateDeallocatableBlockGroup);
+OPERATOR_REDIRECT(CreateNode);
+OPERATOR_REDIRECT(AllocInodeId);
 
 #undef OPERATOR_REDIRECT
 
@@ -383,6 +452,7 @@ OPERATOR_REDIRECT(UpdateDeallocatableBlockGroup);
 
 OPERATOR_ON_FAILED(GetDentry);
 OPERATOR_ON_FAILED(ListDentry);
+OPERATOR_ON_FAILED(ListDentryPlus);
 OPERATOR_ON_FAILED(CreateDentry);
 OPERATOR_ON_FAILED(DeleteDentry);
 OPERATOR_ON_FAILED(GetInode);
@@ -390,6 +460,7 @@ OPERATOR_ON_FAILED(BatchGetInodeAttr);
 OPERATOR_ON_FAILED(BatchGetXAttr);
 OPERATOR_ON_FAILED(CreateInode);
 OPERATOR_ON_FAILED(UpdateInode);
+OPERATOR_ON_FAILED(BatchUpdateInode);
 OPERATOR_ON_FAILED(GetOrModifyS3ChunkInfo);
 OPERATOR_ON_FAILED(DeleteInode);
 OPERATOR_ON_FAILED(CreateRootInode);
@@ -400,6 +471,8 @@ OPERATOR_ON_FAILED(PrepareRenameTx);
 OPERATOR_ON_FAILED(GetVolumeExtent);
 OPERATOR_ON_FAILED(UpdateVolumeExtent);
 OPERATOR_ON_FAILED(UpdateDeallocatableBlockGroup);
+OPERATOR_ON_FAILED(CreateNode);
+OPERATOR_ON_FAILED(AllocInodeId);
 
 #undef OPERATOR_ON_FAILED
 
@@ -410,6 +483,7 @@ OPERATOR_ON_FAILED(UpdateDeallocatableBlockGroup);
 
 OPERATOR_HASH_CODE(GetDentry);
 OPERATOR_HASH_CODE(ListDentry);
+OPERATOR_HASH_CODE(ListDentryPlus);
 OPERATOR_HASH_CODE(CreateDentry);
 OPERATOR_HASH_CODE(DeleteDentry);
 OPERATOR_HASH_CODE(GetInode);
@@ -417,6 +491,7 @@ OPERATOR_HASH_CODE(BatchGetInodeAttr);
 OPERATOR_HASH_CODE(BatchGetXAttr);
 OPERATOR_HASH_CODE(CreateInode);
 OPERATOR_HASH_CODE(UpdateInode);
+OPERATOR_HASH_CODE(BatchUpdateInode);
 OPERATOR_HASH_CODE(GetOrModifyS3ChunkInfo);
 OPERATOR_HASH_CODE(DeleteInode);
 OPERATOR_HASH_CODE(CreateRootInode);
@@ -426,10 +501,25 @@ OPERATOR_HASH_CODE(DeletePartition);
 OPERATOR_HASH_CODE(GetVolumeExtent);
 OPERATOR_HASH_CODE(UpdateVolumeExtent);
 OPERATOR_HASH_CODE(UpdateDeallocatableBlockGroup);
+OPERATOR_HASH_CODE(CreateNode);
+OPERATOR_HASH_CODE(AllocInodeId);
 
 
 #undef OPERATOR_HASH_CODE
 
+#define OPERATOR_INODE_KEY(TYPE)                                               \
+    bool TYPE##Operator::GetInodeKey(uint64_t *inodeId) const {                \
+        *inodeId = static_cast<const TYPE##Request *>(request_)->inodeid();    \
+        return true;                                                           \
+    }
+
+OPERATOR_INODE_KEY(UpdateInode);
+OPERATOR_INODE_KEY(GetOrModifyS3ChunkInfo);
+OPERATOR_INODE_KEY(DeleteInode);
+OPERATOR_INODE_KEY(UpdateVolumeExtent);
+
+#undef OPERATOR_INODE_KEY
+
 #define PARTITION_OPERATOR_HASH_CODE(TYPE)                                     \
     uint64_t TYPE##Operator::HashCode() const {                                \
         return static_cast<const TYPE##Request *>(request_)                    \
@@ -448,6 +538,7 @@ PARTITION_OPERATOR_HASH_CODE(CreatePartition);
 
 OPERATOR_TYPE(GetDentry);
 OPERATOR_TYPE(ListDentry);
+OPERATOR_TYPE(ListDentryPlus);
 OPERATOR_TYPE(CreateDentry);
 OPERATOR_TYPE(DeleteDentry);
 OPERATOR_TYPE(GetInode);
@@ -455,6 +546,7 @@ OPERATOR_TYPE(BatchGetInodeAttr);
 OPERATOR_TYPE(BatchGetXAttr);
 OPERATOR_TYPE(CreateInode);
 OPERATOR_TYPE(UpdateInode);
+OPERATOR_TYPE(BatchUpdateInode);
 OPERATOR_TYPE(GetOrModifyS3ChunkInfo);
 OPERATOR_TYPE(DeleteInode);
 OPERATOR_TYPE(CreateRootInode);
@@ -465,6 +557,8 @@ OPERATOR_TYPE(DeletePartition);
 OPERATOR_TYPE(GetVolumeExtent);
 OPERATOR_TYPE(UpdateVolumeExtent);
 OPERATOR_TYPE(UpdateDeallocatableBlockGroup);
+OPERATOR_TYPE(CreateNode);
+OPERATOR_TYPE(AllocInodeId);
 
 #undef OPERATOR_TYPE
 
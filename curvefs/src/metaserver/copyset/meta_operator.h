@@ -26,6 +26,8 @@
 #include <brpc/controller.h>
 #include <google/protobuf/message.h>
 
+#include <functional>
+
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/common/rpc_stream.h"
 #include "curvefs/src/metaserver/copyset/operator_type.h"
@@ -83,26 +85,27 @@ class MetaOperator {
     virtual void OnApplyFromLog(uint64_t startTimeUs) = 0;
 
     // Get hash code of current operator which is used to push current operator
-    // task to apply queue, and apply queue will guarantee that operators with
-    // the same hash code are executed serially.
-    // Current, all operators' hash code is request's PARTITION-ID
-    // TODO(wuhanqing): Finer grained hash code
-    // e.g.,
-    // For dentry-related operator hash code is `parent-inode-id`
-    // For inode-related operator hash code is `inode-id`
-    // For partition-related operator hash code is `partition-id`
-    // but above hash policy has BUG
-    // scenario:
-    // two operators: create partition and create inode in this partition
-    // if leader crashed after second operator is executed, the new elected
-    // leader must apply those two operators, BUT those two operators are hashed
-    // by different ID, so they can be executed in parallel, and this can lead
-    // to create inode operator is executed prior to create partition operator
-    // Possible solution:
-    // 1. create a partition if crate inode found partition not exist
-    // 2. create inode wait partition create when found partition not exist
+    // task to apply queue, all operators' hash code is request's PARTITION-ID.
     virtual uint64_t HashCode() const = 0;
 
+    // Whether current operator only touches one inode of the partition,
+    // if so, `inodeId` is set.
+    //
+    // Inode-local write operators are hashed by (partition, inode) and
+    // may be applied in parallel, other write operators (e.g., create dentry,
+    // rename) are ordered against all operators of the same partition,
+    // see `ApplyDependencyTracker`.
+    virtual bool GetInodeKey(uint64_t* inodeId) const {
+        (void)inodeId;
+        return false;
+    }
+
+    /**
+     * @brief Push task of current operator to apply queue
+     */
+    void PushApplyTask(ApplyQueue* applyQueue,
+                       const std::function<void()>& task) const;
+
     virtual OperatorType GetOperatorType() const = 0;
 
  private:
@@ -204,6 +207,27 @@ class ListDentryOperator : public MetaOperator {
     bool CanBypassPropose() const override;
 };
 
+class ListDentryPlusOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+    OperatorType GetOperatorType() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+
+    bool CanBypassPropose() const override;
+};
+
 class CreateDentryOperator : public MetaOperator {
  public:
     using MetaOperator::MetaOperator;
@@ -325,6 +349,27 @@ class CreateInodeOperator : public MetaOperator {
 };
 
 class UpdateInodeOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+    OperatorType GetOperatorType() const override;
+
+    bool GetInodeKey(uint64_t* inodeId) const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+};
+
+class BatchUpdateInodeOperator : public MetaOperator {
  public:
     using MetaOperator::MetaOperator;
 
@@ -356,6 +401,8 @@ class GetOrModifyS3ChunkInfoOperator : public MetaOperator {
 
     OperatorType GetOperatorType() const override;
 
+    bool GetInodeKey(uint64_t* inodeId) const override;
+
  private:
     void Redirect() override;
 
@@ -375,6 +422,8 @@ class DeleteInodeOperator : public MetaOperator {
 
     OperatorType GetOperatorType() const override;
 
+    bool GetInodeKey(uint64_t* inodeId) const override;
+
  private:
     void Redirect() override;
 
@@ -531,6 +580,8 @@ class UpdateVolumeExtentOperator : public MetaOperator {
 
     OperatorType GetOperatorType() const override;
 
+    bool GetInodeKey(uint64_t* inodeId) const override;
+
  private:
     void Redirect() override;
 
@@ -556,6 +607,44 @@ class UpdateDeallocatableBlockGroupOperator : public MetaOperator {
     void OnFailed(MetaStatusCode code) override;
 };
 
+class CreateNodeOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+    OperatorType GetOperatorType() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+};
+
+class AllocInodeIdOperator : public MetaOperator {
+ public:
+    using MetaOperator::MetaOperator;
+
+    void OnApply(int64_t index, google::protobuf::Closure* done,
+                 uint64_t startTimeUs) override;
+
+    void OnApplyFromLog(uint64_t startTimeUs) override;
+
+    uint64_t HashCode() const override;
+
+    OperatorType GetOperatorType() const override;
+
+ private:
+    void Redirect() override;
+
+    void OnFailed(MetaStatusCode code) override;
+};
+
 }  // namespace copyset
 }  // namespace metaserver
 }  // namespace curvefs
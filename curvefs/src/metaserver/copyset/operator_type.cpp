@@ -68,6 +68,14 @@ const char* OperatorTypeName(OperatorType type) {
             return "UpdateVolumeExtent";
         case OperatorType::UpdateDeallocatableBlockGroup:
             return "UpdateDeallocatableBlockGroup";
+        case OperatorType::CreateNode:
+            return "CreateNode";
+        case OperatorType::AllocInodeId:
+            return "AllocInodeId";
+        case OperatorType::ListDentryPlus:
+            return "ListDentryPlus";
+        case OperatorType::BatchUpdateInode:
+            return "BatchUpdateInode";
         // Add new case before `OperatorType::OperatorTypeMax`
         case OperatorType::OperatorTypeMax:
             break;
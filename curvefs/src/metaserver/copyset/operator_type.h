@@ -53,6 +53,10 @@ enum class OperatorType : uint32_t {
     UpdateVolumeExtent = 16,
     CreateManageInode = 17,
     UpdateDeallocatableBlockGroup = 18,
+    CreateNode = 19,
+    AllocInodeId = 20,
+    ListDentryPlus = 21,
+    BatchUpdateInode = 22,
 
     // NOTE:
     //   Add new operator before `OperatorTypeMax`
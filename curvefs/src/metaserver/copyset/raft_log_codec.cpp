@@ -169,6 +169,18 @@ std::unique_ptr<MetaOperator> RaftLogCodec::Decode(CopysetNode* node,
             return ParseFromRaftLog<UpdateDeallocatableBlockGroupOperator,
                                     UpdateDeallocatableBlockGroupRequest>(
                 node, type, meta);
+        case OperatorType::CreateNode:
+            return ParseFromRaftLog<CreateNodeOperator, CreateNodeRequest>(
+                node, type, meta);
+        case OperatorType::AllocInodeId:
+            return ParseFromRaftLog<AllocInodeIdOperator, AllocInodeIdRequest>(
+                node, type, meta);
+        case OperatorType::ListDentryPlus:
+            return ParseFromRaftLog<ListDentryPlusOperator,
+                                    ListDentryPlusRequest>(node, type, meta);
+        case OperatorType::BatchUpdateInode:
+            return ParseFromRaftLog<BatchUpdateInodeOperator,
+                                    BatchUpdateInodeRequest>(node, type, meta);
         // Add new case before `OperatorType::OperatorTypeMax`
         case OperatorType::OperatorTypeMax:
             break;
@@ -32,8 +32,7 @@
 namespace curvefs {
 namespace metaserver {
 
-using ::curve::common::ReadLockGuard;
-using ::curve::common::WriteLockGuard;
+using ::curve::common::LockGuard;
 using ::curve::common::StringStartWith;
 using ::curvefs::metaserver::storage::Status;
 using ::curvefs::metaserver::storage::Key4Dentry;
@@ -165,6 +164,8 @@ DentryStorage::DentryStorage(std::shared_ptr<KVStorage> kvStorage,
                              uint64_t nDentry)
     : kvStorage_(kvStorage),
       table4Dentry_(nameGenerator->GetDentryTableName()),
+      lock_(kvStorage->Type() == KVStorage::STORAGE_TYPE::ROCKSDB_STORAGE,
+            kvStorage->GetStorageOptions().lockStripes),
       nDentry_(nDentry),
       conv_() {}
 
@@ -195,12 +196,17 @@ bool DentryStorage::CompressDentry(DentryVec* vec, BTree* dentrys) {
     }
 
     if (s.ok()) {
-        vector.Confirm(&nDentry_);
+        ConfirmCount(&vector);
         return true;
     }
     return false;
 }
 
+void DentryStorage::ConfirmCount(DentryVector* vector) {
+    LockGuard lg(countLock_);
+    vector->Confirm(&nDentry_);
+}
+
 // NOTE: Find() return the dentry which has the latest txid,
 // and it will clean the old txid's dentry if you specify compress to true
 MetaStatusCode DentryStorage::Find(const Dentry& in,
@@ -243,7 +249,7 @@ MetaStatusCode DentryStorage::Find(const Dentry& in,
 }
 
 MetaStatusCode DentryStorage::Insert(const Dentry& dentry) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, dentry.fsid(), dentry.parentinodeid(), true);
 
     Dentry out;
     DentryVec vec;
@@ -266,16 +272,17 @@ MetaStatusCode DentryStorage::Insert(const Dentry& dentry) {
         LOG(ERROR) << "Insert dentry failed, status = " << s.ToString();
         return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     }
-    vector.Confirm(&nDentry_);
+    ConfirmCount(&vector);
     return MetaStatusCode::OK;
 }
 
 MetaStatusCode DentryStorage::Insert(const DentryVec& vec, bool merge) {
-    WriteLockGuard lg(rwLock_);
+    const Dentry& first = vec.dentrys(0);
+    KeyLockGuard lg(lock_, first.fsid(), first.parentinodeid(), true);
 
     Status s;
     DentryVec oldVec;
-    std::string skey = DentryKey(vec.dentrys(0));
+    std::string skey = DentryKey(first);
     if (merge) {  // for old version dumpfile (v1)
         s = kvStorage_->SGet(table4Dentry_, skey, &oldVec);
         if (s.IsNotFound()) {
@@ -292,12 +299,12 @@ MetaStatusCode DentryStorage::Insert(const DentryVec& vec, bool merge) {
         LOG(ERROR) << "Insert dentry vector failed, status = " << s.ToString();
         return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     }
-    vector.Confirm(&nDentry_);
+    ConfirmCount(&vector);
     return MetaStatusCode::OK;
 }
 
 MetaStatusCode DentryStorage::Delete(const Dentry& dentry) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, dentry.fsid(), dentry.parentinodeid(), true);
 
     Dentry out;
     DentryVec vec;
@@ -319,14 +326,14 @@ MetaStatusCode DentryStorage::Delete(const Dentry& dentry) {
     }
 
     if (s.ok()) {
-        vector.Confirm(&nDentry_);
+        ConfirmCount(&vector);
         return MetaStatusCode::OK;
     }
     return MetaStatusCode::STORAGE_INTERNAL_ERROR;
 }
 
 MetaStatusCode DentryStorage::Get(Dentry* dentry) {
-    ReadLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, dentry->fsid(), dentry->parentinodeid(), false);
 
     Dentry out;
     DentryVec vec;
@@ -347,7 +354,7 @@ MetaStatusCode DentryStorage::List(const Dentry& dentry,
                                    uint32_t limit,
                                    bool onlyDir) {
     // TODO(all): consider store dir dentry and file dentry separately
-    ReadLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, dentry.fsid(), dentry.parentinodeid(), false);
 
     // 1. precheck for dentry vector
     // NOTE: we should gurantee the vector is empty
@@ -405,8 +412,32 @@ MetaStatusCode DentryStorage::List(const Dentry& dentry,
 }
 
 MetaStatusCode DentryStorage::HandleTx(TX_OP_TYPE type, const Dentry& dentry) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, dentry.fsid(), dentry.parentinodeid(), true);
+    return HandleTxLocked(type, dentry);
+}
+
+MetaStatusCode DentryStorage::HandleTx(TX_OP_TYPE type,
+                                       const std::vector<Dentry>& dentrys) {
+    // lock all parents together, stripes are locked in a fixed order,
+    // so transactions on crossed directories don't deadlock
+    std::vector<uint64_t> hashKeys;
+    for (const auto& dentry : dentrys) {
+        hashKeys.push_back(StripedTableLock::HashKey(
+            dentry.fsid(), dentry.parentinodeid()));
+    }
+    KeyLockGuard lg(lock_, hashKeys, true);
+
+    for (const auto& dentry : dentrys) {
+        auto rc = HandleTxLocked(type, dentry);
+        if (rc != MetaStatusCode::OK) {
+            return rc;
+        }
+    }
+    return MetaStatusCode::OK;
+}
 
+MetaStatusCode DentryStorage::HandleTxLocked(TX_OP_TYPE type,
+                                             const Dentry& dentry) {
     Status s;
     Dentry out;
     DentryVec vec;
@@ -427,7 +458,7 @@ MetaStatusCode DentryStorage::HandleTx(TX_OP_TYPE type, const Dentry& dentry) {
             if (!s.ok()) {
                 rc = MetaStatusCode::STORAGE_INTERNAL_ERROR;
             } else {
-                vector.Confirm(&nDentry_);
+                ConfirmCount(&vector);
             }
             break;
 
@@ -456,7 +487,7 @@ MetaStatusCode DentryStorage::HandleTx(TX_OP_TYPE type, const Dentry& dentry) {
             if (!s.ok()) {
                 rc = MetaStatusCode::STORAGE_INTERNAL_ERROR;
             } else {
-                vector.Confirm(&nDentry_);
+                ConfirmCount(&vector);
             }
             break;
 
@@ -468,17 +499,17 @@ MetaStatusCode DentryStorage::HandleTx(TX_OP_TYPE type, const Dentry& dentry) {
 }
 
 std::shared_ptr<Iterator> DentryStorage::GetAll() {
-    ReadLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, false);
     return kvStorage_->SGetAll(table4Dentry_);
 }
 
 size_t DentryStorage::Size() {
-    ReadLockGuard lg(rwLock_);
+    LockGuard lg(countLock_);
     return nDentry_;
 }
 
 bool DentryStorage::Empty() {
-    ReadLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, false);
 
     std::string sprefix = conv_.SerializeToString(Prefix4AllDentry());
     auto iterator = kvStorage_->SSeek(table4Dentry_, sprefix);
@@ -494,12 +525,13 @@ bool DentryStorage::Empty() {
 }
 
 MetaStatusCode DentryStorage::Clear() {
-    WriteLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, true);
     Status s = kvStorage_->SClear(table4Dentry_);
     if (!s.ok()) {
         LOG(ERROR) << "failed to clear dentry table, status = " << s.ToString();
         return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     }
+    LockGuard countLg(countLock_);
     nDentry_ = 0;
     return MetaStatusCode::OK;
 }
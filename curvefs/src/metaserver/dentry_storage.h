@@ -30,15 +30,16 @@
 #include <functional>
 
 #include "absl/container/btree_set.h"
-#include "src/common/concurrent/rw_lock.h"
+#include "src/common/concurrent/concurrent.h"
 #include "curvefs/proto/metaserver.pb.h"
+#include "curvefs/src/metaserver/common/striped_lock.h"
 #include "curvefs/src/metaserver/storage/storage.h"
 #include "curvefs/src/metaserver/storage/converter.h"
 
 namespace curvefs {
 namespace metaserver {
 
-using ::curve::common::RWLock;
+using ::curve::common::Mutex;
 using ::curvefs::metaserver::storage::Iterator;
 using ::curvefs::metaserver::storage::NameGenerator;
 using ::curvefs::metaserver::storage::Converter;
@@ -127,6 +128,10 @@ class DentryStorage {
 
     MetaStatusCode HandleTx(TX_OP_TYPE type, const Dentry& dentry);
 
+    // handle dentrys of one transaction with all of their parents locked
+    MetaStatusCode HandleTx(TX_OP_TYPE type,
+                            const std::vector<Dentry>& dentrys);
+
     std::shared_ptr<Iterator> GetAll();
 
     size_t Size();
@@ -145,10 +150,16 @@ class DentryStorage {
                         DentryVec* vec,
                         bool compress);
 
+    MetaStatusCode HandleTxLocked(TX_OP_TYPE type, const Dentry& dentry);
+
+    void ConfirmCount(DentryVector* vector);
+
  private:
-    RWLock rwLock_;
     std::shared_ptr<KVStorage> kvStorage_;
     std::string table4Dentry_;
+    // dentrys under different parents go in parallel for rocksdb storage
+    StripedTableLock lock_;
+    Mutex countLock_;
     uint64_t nDentry_;
     Converter conv_;
 };
@@ -0,0 +1,234 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-05-04
+ */
+
+#include "curvefs/src/metaserver/dir_lease_manager.h"
+
+#include <brpc/controller.h>
+#include <bthread/bthread.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "src/common/timeutility.h"
+
+namespace curvefs {
+namespace metaserver {
+
+using ::curve::common::TimeUtility;
+
+namespace {
+
+// remove expired leases every |kCleanInterval| grants
+constexpr uint64_t kCleanInterval = 10000;
+
+// run |done| after all holders are notified
+class RevokeTracker {
+ public:
+    RevokeTracker(int count, google::protobuf::Closure* done)
+        : pending_(count), done_(done) {}
+
+    void OnFinish() {
+        if (pending_.fetch_sub(1) == 1) {
+            done_->Run();
+            delete this;
+        }
+    }
+
+ private:
+    std::atomic<int> pending_;
+    google::protobuf::Closure* done_;
+};
+
+// notify a holder of the changes of its directories. A failed notify is
+// retried until the holder acks or its leases expire, otherwise the holder
+// may still serve the stale entries after the change is acked
+class InvalidateDirClosure : public google::protobuf::Closure {
+ public:
+    InvalidateDirClosure(const std::string& holder,
+                         std::shared_ptr<brpc::Channel> channel,
+                         uint64_t expireMs, uint32_t timeoutMs,
+                         RevokeTracker* tracker)
+        : holder_(holder),
+          channel_(std::move(channel)),
+          expireMs_(expireMs),
+          timeoutMs_(timeoutMs),
+          waitMs_(0),
+          tracker_(tracker) {}
+
+    void Notify() {
+        if (channel_ == nullptr) {
+            // the holder can't be reached, wait for its leases to expire
+            Run();
+            return;
+        }
+        cntl.Reset();
+        cntl.set_timeout_ms(timeoutMs_);
+        DirLeaseService_Stub stub(channel_.get());
+        stub.InvalidateDir(&cntl, &request, &response, this);
+    }
+
+    void Run() override {
+        if (channel_ != nullptr && !cntl.Failed()) {
+            Finish();
+            return;
+        }
+        LOG_IF(WARNING, cntl.Failed())
+            << "Notify lease holder " << holder_
+            << " failed, error = " << cntl.ErrorText()
+            << ", request = " << request.ShortDebugString();
+        uint64_t now = TimeUtility::GetTimeofDayMs();
+        if (now >= expireMs_) {
+            Finish();
+            return;
+        }
+
+        waitMs_ = std::min<uint64_t>(expireMs_ - now, timeoutMs_);
+        bthread_t tid;
+        if (bthread_start_background(&tid, nullptr, &Retry, this) != 0) {
+            LOG(ERROR) << "Start bthread to notify lease holder " << holder_
+                       << " failed, retry inline";
+            Retry(this);
+        }
+    }
+
+    brpc::Controller cntl;
+    InvalidateDirRequest request;
+    InvalidateDirResponse response;
+
+ private:
+    static void* Retry(void* arg) {
+        auto* closure = static_cast<InvalidateDirClosure*>(arg);
+        bthread_usleep(closure->waitMs_ * 1000);
+        closure->Notify();
+        return nullptr;
+    }
+
+    void Finish() {
+        tracker_->OnFinish();
+        delete this;
+    }
+
+ private:
+    std::string holder_;
+    std::shared_ptr<brpc::Channel> channel_;
+    // all the leases of the holder to revoke expire at this time
+    uint64_t expireMs_;
+    uint32_t timeoutMs_;
+    uint64_t waitMs_;
+    RevokeTracker* tracker_;
+};
+
+}  // namespace
+
+DirLeaseManager::DirLeaseManager(const DirLeaseOption& option)
+    : option_(option), grantsSinceClean_(0) {}
+
+uint32_t DirLeaseManager::Grant(uint32_t fsId, uint64_t parent,
+                                const std::string& holder) {
+    if (!Enabled() || holder.empty()) {
+        return 0;
+    }
+
+    uint64_t now = TimeUtility::GetTimeofDayMs();
+    std::lock_guard<bthread::Mutex> lk(mtx_);
+    leases_[DirKey(fsId, parent)][holder] = now + option_.leaseMs;
+    if (++grantsSinceClean_ >= kCleanInterval) {
+        RemoveExpiredLocked(now);
+        grantsSinceClean_ = 0;
+    }
+    return option_.leaseMs;
+}
+
+void DirLeaseManager::RemoveExpiredLocked(uint64_t now) {
+    for (auto iter = leases_.begin(); iter != leases_.end();) {
+        auto& holders = iter->second;
+        for (auto it = holders.begin(); it != holders.end();) {
+            it = it->second <= now ? holders.erase(it) : std::next(it);
+        }
+        iter = holders.empty() ? leases_.erase(iter) : std::next(iter);
+    }
+}
+
+std::shared_ptr<brpc::Channel> DirLeaseManager::GetChannel(
+    const std::string& holder) {
+    std::lock_guard<bthread::Mutex> lk(channelMtx_);
+    auto iter = channels_.find(holder);
+    if (iter != channels_.end()) {
+        return iter->second;
+    }
+
+    auto channel = std::make_shared<brpc::Channel>();
+    if (channel->Init(holder.c_str(), nullptr) != 0) {
+        LOG(WARNING) << "Init channel to lease holder " << holder
+                     << " failed";
+        return nullptr;
+    }
+    channels_.emplace(holder, channel);
+    return channel;
+}
+
+void DirLeaseManager::Revoke(uint32_t fsId,
+                             const std::vector<uint64_t>& parents,
+                             google::protobuf::Closure* done) {
+    // holder -> directories to invalidate and the last expire time of
+    // their leases
+    std::unordered_map<std::string, std::pair<std::vector<uint64_t>, uint64_t>>
+        notifies;
+    uint64_t now = TimeUtility::GetTimeofDayMs();
+    {
+        std::lock_guard<bthread::Mutex> lk(mtx_);
+        for (auto parent : parents) {
+            auto iter = leases_.find(DirKey(fsId, parent));
+            if (iter == leases_.end()) {
+                continue;
+            }
+            for (const auto& holder : iter->second) {
+                if (holder.second > now) {
+                    auto& notify = notifies[holder.first];
+                    notify.first.push_back(parent);
+                    notify.second = std::max(notify.second, holder.second);
+                }
+            }
+            leases_.erase(iter);
+        }
+    }
+
+    if (notifies.empty()) {
+        done->Run();
+        return;
+    }
+
+    auto* tracker = new RevokeTracker(notifies.size(), done);
+    for (const auto& notify : notifies) {
+        auto* closure = new InvalidateDirClosure(
+            notify.first, GetChannel(notify.first), notify.second.second,
+            option_.notifyTimeoutMs, tracker);
+        closure->request.set_fsid(fsId);
+        for (auto parent : notify.second.first) {
+            closure->request.add_parentinodeids(parent);
+        }
+        closure->Notify();
+    }
+}
+
+}  // namespace metaserver
+}  // namespace curvefs
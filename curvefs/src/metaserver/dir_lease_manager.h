@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-05-04
+ */
+
+#ifndef CURVEFS_SRC_METASERVER_DIR_LEASE_MANAGER_H_
+#define CURVEFS_SRC_METASERVER_DIR_LEASE_MANAGER_H_
+
+#include <brpc/channel.h>
+#include <bthread/mutex.h>
+#include <google/protobuf/stubs/callback.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "curvefs/proto/metaserver.pb.h"
+
+namespace curvefs {
+namespace metaserver {
+
+struct DirLeaseOption {
+    // lease of a directory in milliseconds, 0 disables leases
+    uint32_t leaseMs = 0;
+    // timeout of notifying a holder when its directory changes, a failed
+    // notify is retried at this interval until the lease expires
+    uint32_t notifyTimeoutMs = 500;
+};
+
+/**
+ * Directory leases granted to clients on lookup.
+ *
+ * A client holding the lease of a directory caches the positive and
+ * negative lookup results of the directory until the lease expires or it's
+ * notified of changes. The leases are kept in memory of the metaserver
+ * which serves the lookup, i.e. the leader of the partition, so they're
+ * lost when the leader changes and clients may see stale entries for at
+ * most one lease.
+ */
+class DirLeaseManager {
+ public:
+    explicit DirLeaseManager(const DirLeaseOption& option);
+
+    bool Enabled() const { return option_.leaseMs > 0; }
+
+    /**
+     * @brief grant the lease of directory |parent| to |holder|
+     * @return lease in milliseconds, 0 if disabled
+     * @note call it before the lookup, so the changes after the lookup
+     *       will be notified
+     */
+    uint32_t Grant(uint32_t fsId, uint64_t parent, const std::string& holder);
+
+    /**
+     * @brief revoke the leases of directories which have been changed
+     * @param done run after all holders are notified, or their leases
+     *             expired if they can't be notified
+     */
+    void Revoke(uint32_t fsId, const std::vector<uint64_t>& parents,
+                google::protobuf::Closure* done);
+
+ private:
+    using DirKey = std::pair<uint32_t, uint64_t>;
+    // holder -> expire time in milliseconds
+    using Holders = std::unordered_map<std::string, uint64_t>;
+
+    std::shared_ptr<brpc::Channel> GetChannel(const std::string& holder);
+
+    void RemoveExpiredLocked(uint64_t now);
+
+ private:
+    DirLeaseOption option_;
+
+    bthread::Mutex mtx_;
+    std::map<DirKey, Holders> leases_;
+    uint64_t grantsSinceClean_;
+
+    bthread::Mutex channelMtx_;
+    std::unordered_map<std::string, std::shared_ptr<brpc::Channel>> channels_;
+};
+
+// revoke leases of the changed directories before responding
+template <typename ResponseT>
+class RevokeDirLeaseClosure : public google::protobuf::Closure {
+ public:
+    RevokeDirLeaseClosure(DirLeaseManager* manager, uint32_t fsId,
+                          std::vector<uint64_t> parents,
+                          const ResponseT* response,
+                          google::protobuf::Closure* done)
+        : manager_(manager),
+          fsId_(fsId),
+          parents_(std::move(parents)),
+          response_(response),
+          done_(done) {}
+
+    void Run() override {
+        std::unique_ptr<RevokeDirLeaseClosure> selfGuard(this);
+        if (response_->statuscode() == MetaStatusCode::OK) {
+            manager_->Revoke(fsId_, parents_, done_);
+        } else {
+            done_->Run();
+        }
+    }
+
+ private:
+    DirLeaseManager* manager_;
+    uint32_t fsId_;
+    std::vector<uint64_t> parents_;
+    const ResponseT* response_;
+    google::protobuf::Closure* done_;
+};
+
+}  // namespace metaserver
+}  // namespace curvefs
+
+#endif  // CURVEFS_SRC_METASERVER_DIR_LEASE_MANAGER_H_
@@ -71,7 +71,7 @@ MetaStatusCode InodeManager::CreateInode(uint64_t inodeId,
     }
 
     newInode->CopyFrom(inode);
-    ++(*type2InodeNum_)[inode.type()];
+    IncreaseInodeNumOfType(inode.type());
     VLOG(9) << "CreateInode success, inode = " << inode.ShortDebugString();
     return MetaStatusCode::OK;
 }
@@ -95,7 +95,7 @@ MetaStatusCode InodeManager::CreateRootInode(const InodeParam &param) {
                    << ", ret = " << MetaStatusCode_Name(ret);
         return ret;
     }
-    ++(*type2InodeNum_)[inode.type()];
+    IncreaseInodeNumOfType(inode.type());
     LOG(INFO) << "CreateRootInode success, inode: " << inode.ShortDebugString();
     return MetaStatusCode::OK;
 }
@@ -131,7 +131,7 @@ MetaStatusCode InodeManager::CreateManageInode(const InodeParam &param,
         return ret;
     }
 
-    ++(*type2InodeNum_)[inode.type()];
+    IncreaseInodeNumOfType(inode.type());
     newInode->CopyFrom(inode);
 
     LOG(INFO) << "CreateManageInode success, inode: "
@@ -275,7 +275,7 @@ MetaStatusCode InodeManager::DeleteInode(uint32_t fsId, uint64_t inodeId) {
 
     if (retGetAttr == MetaStatusCode::OK) {
         // get attr success
-        --(*type2InodeNum_)[attr.type()];
+        DecreaseInodeNumOfType(attr.type());
     }
     VLOG(6) << "DeleteInode success, fsId = " << fsId
             << ", inodeId = " << inodeId;
@@ -357,7 +357,7 @@ MetaStatusCode InodeManager::UpdateInode(const UpdateInodeRequest& request) {
 
     if (s3NeedTrash) {
         trash_->Add(old.fsid(), old.inodeid(), old.dtime());
-        --(*type2InodeNum_)[old.type()];
+        DecreaseInodeNumOfType(old.type());
     }
 
     const S3ChunkInfoMap &map2add = request.s3chunkinfoadd();
@@ -471,7 +471,8 @@ MetaStatusCode InodeManager::PaddingInodeS3ChunkInfo(int32_t fsId,
 }
 
 MetaStatusCode InodeManager::UpdateInodeWhenCreateOrRemoveSubNode(
-    uint32_t fsId, uint64_t inodeId, FsFileType type, bool isCreate) {
+    uint32_t fsId, uint64_t inodeId, FsFileType type, bool isCreate,
+    const absl::optional<struct timespec>& mctime) {
     VLOG(6) << "UpdateInodeWhenCreateOrRemoveSubNode, fsId = " << fsId
             << ", inodeId = " << inodeId
             << ", isCreate = " << isCreate;
@@ -506,6 +507,13 @@ MetaStatusCode InodeManager::UpdateInodeWhenCreateOrRemoveSubNode(
         }
     }
 
+    if (mctime.has_value()) {
+        inode.set_mtime(mctime->tv_sec);
+        inode.set_mtime_ns(mctime->tv_nsec);
+        inode.set_ctime(mctime->tv_sec);
+        inode.set_ctime_ns(mctime->tv_nsec);
+    }
+
     ret = inodeStorage_->Update(inode);
     if (ret != MetaStatusCode::OK) {
         LOG(ERROR) << "UpdateInode fail, " << inode.ShortDebugString()
@@ -604,5 +612,15 @@ MetaStatusCode InodeManager::GetVolumeExtent(
     return MetaStatusCode::OK;
 }
 
+void InodeManager::IncreaseInodeNumOfType(FsFileType type) {
+    std::lock_guard<std::mutex> lk(type2InodeNumMtx_);
+    ++(*type2InodeNum_)[type];
+}
+
+void InodeManager::DecreaseInodeNumOfType(FsFileType type) {
+    std::lock_guard<std::mutex> lk(type2InodeNumMtx_);
+    --(*type2InodeNum_)[type];
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
@@ -30,6 +30,7 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <mutex>
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/metaserver/inode_storage.h"
 #include "curvefs/src/metaserver/trash.h"
@@ -103,8 +104,10 @@ class InodeManager {
                                            S3ChunkInfoMap* m,
                                            uint64_t limit = 0);
 
+    // update nlink of the parent, and its mtime and ctime if |mctime| is set
     MetaStatusCode UpdateInodeWhenCreateOrRemoveSubNode(uint32_t fsId,
-        uint64_t inodeId, FsFileType type, bool isCreate);
+        uint64_t inodeId, FsFileType type, bool isCreate,
+        const absl::optional<struct timespec>& mctime = absl::nullopt);
 
     MetaStatusCode InsertInode(const Inode &inode);
 
@@ -142,10 +145,16 @@ class InodeManager {
         uint64_t inodeId,
         const VolumeExtentSlice &slice);
 
+    // the operators on different inodes of the partition may be applied
+    // concurrently, so the counters of file types are updated under lock
+    void IncreaseInodeNumOfType(FsFileType type);
+    void DecreaseInodeNumOfType(FsFileType type);
+
  private:
     std::shared_ptr<InodeStorage> inodeStorage_;
     std::shared_ptr<Trash> trash_;
     FileType2InodeNumMap* type2InodeNum_;
+    std::mutex type2InodeNumMtx_;
 
     NameLock inodeLock_;
 };
@@ -41,8 +41,6 @@
 namespace curvefs {
 namespace metaserver {
 
-using ::curve::common::ReadLockGuard;
-using ::curve::common::WriteLockGuard;
 using ::curve::common::StringStartWith;
 using ::curvefs::metaserver::storage::Status;
 using ::curvefs::metaserver::storage::KVStorage;
@@ -56,11 +54,46 @@ using ::curvefs::metaserver::storage::Key4InodeAuxInfo;
 using ::curvefs::metaserver::storage::Key4DeallocatableBlockGroup;
 using ::curvefs::metaserver::storage::Prefix4AllDeallocatableBlockGroup;
 
+namespace {
+
+void InodeToAttr(const Inode& inode, InodeAttr* attr) {
+    attr->set_inodeid(inode.inodeid());
+    attr->set_fsid(inode.fsid());
+    attr->set_length(inode.length());
+    attr->set_ctime(inode.ctime());
+    attr->set_ctime_ns(inode.ctime_ns());
+    attr->set_mtime(inode.mtime());
+    attr->set_mtime_ns(inode.mtime_ns());
+    attr->set_atime(inode.atime());
+    attr->set_atime_ns(inode.atime_ns());
+    attr->set_uid(inode.uid());
+    attr->set_gid(inode.gid());
+    attr->set_mode(inode.mode());
+    attr->set_nlink(inode.nlink());
+    attr->set_type(inode.type());
+    *(attr->mutable_parent()) = inode.parent();
+    if (inode.has_symlink()) {
+        attr->set_symlink(inode.symlink());
+    }
+    if (inode.has_rdev()) {
+        attr->set_rdev(inode.rdev());
+    }
+    if (inode.has_dtime()) {
+        attr->set_dtime(inode.dtime());
+    }
+    if (inode.xattr_size() > 0) {
+        *(attr->mutable_xattr()) = inode.xattr();
+    }
+}
+
+}  // namespace
+
 InodeStorage::InodeStorage(std::shared_ptr<KVStorage> kvStorage,
                            std::shared_ptr<NameGenerator> nameGenerator,
                            uint64_t nInode)
     : kvStorage_(std::move(kvStorage)),
       table4Inode_(nameGenerator->GetInodeTableName()),
+      table4InodeAttr_(nameGenerator->GetInodeAttrTableName()),
       table4S3ChunkInfo_(nameGenerator->GetS3ChunkInfoTableName()),
       table4VolumeExtent_(nameGenerator->GetVolumeExtentTableName()),
       table4InodeAuxInfo_(nameGenerator->GetInodeAuxInfoTableName()),
@@ -68,10 +101,12 @@ InodeStorage::InodeStorage(std::shared_ptr<KVStorage> kvStorage,
           nameGenerator->GetDeallocatableInodeTableName()),
       table4DeallocatableBlockGroup_(
           nameGenerator->GetDeallocatableBlockGroupTableName()),
+      lock_(kvStorage_->Type() == KVStorage::STORAGE_TYPE::ROCKSDB_STORAGE,
+            kvStorage_->GetStorageOptions().lockStripes),
       nInode_(nInode), conv_() {}
 
 MetaStatusCode InodeStorage::Insert(const Inode& inode) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, inode.fsid(), inode.inodeid(), true);
     Key4Inode key(inode.fsid(), inode.inodeid());
     std::string skey = conv_.SerializeToString(key);
 
@@ -86,17 +121,51 @@ MetaStatusCode InodeStorage::Insert(const Inode& inode) {
     }
 
     // key not found
-    s = kvStorage_->HSet(table4Inode_, skey, inode);
-    if (s.ok()) {
-        nInode_++;
-        return MetaStatusCode::OK;
+    auto txn = kvStorage_->BeginTransaction();
+    if (nullptr == txn) {
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     }
-    LOG(ERROR) << "Insert inode failed, status = " << s.ToString();
-    return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+
+    MetaStatusCode rc = SetInodeAndAttr(txn, skey, inode);
+    if (rc != MetaStatusCode::OK) {
+        LOG(ERROR) << "Insert inode failed, inode = "
+                   << key.SerializeToString();
+        if (!txn->Rollback().ok()) {
+            LOG(ERROR) << "Rollback transaction failed, inode = "
+                       << key.SerializeToString();
+        }
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    } else if (!txn->Commit().ok()) {
+        LOG(ERROR) << "Commit transaction failed, inode = "
+                   << key.SerializeToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    nInode_++;
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode InodeStorage::SetInodeAndAttr(Transaction txn,
+                                             const std::string& skey,
+                                             const Inode& inode) {
+    Status s = txn->HSet(table4Inode_, skey, inode);
+    if (!s.ok()) {
+        LOG(ERROR) << "Set inode failed, status = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    InodeAttr attr;
+    InodeToAttr(inode, &attr);
+    s = txn->HSet(table4InodeAttr_, skey, attr);
+    if (!s.ok()) {
+        LOG(ERROR) << "Set inode attribute failed, status = " << s.ToString();
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    return MetaStatusCode::OK;
 }
 
 MetaStatusCode InodeStorage::Get(const Key4Inode& key, Inode* inode) {
-    ReadLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, key.fsId, key.inodeId, false);
     std::string skey = conv_.SerializeToString(key);
     Status s = kvStorage_->HGet(table4Inode_, skey, inode);
     if (s.ok()) {
@@ -113,49 +182,32 @@ MetaStatusCode InodeStorage::Get(const Key4Inode& key, Inode* inode) {
 
 MetaStatusCode InodeStorage::GetAttr(const Key4Inode& key,
                                      InodeAttr *attr) {
-    ReadLockGuard lg(rwLock_);
-    Inode inode;
+    KeyLockGuard lg(lock_, key.fsId, key.inodeId, false);
     std::string skey = conv_.SerializeToString(key);
-    Status s = kvStorage_->HGet(table4Inode_, skey, &inode);
+    Status s = kvStorage_->HGet(table4InodeAttr_, skey, attr);
+    if (s.ok()) {
+        return MetaStatusCode::OK;
+    } else if (!s.IsNotFound()) {
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    // the inode may be written by old version which has no attribute table,
+    // get attr from inode
+    Inode inode;
+    s = kvStorage_->HGet(table4Inode_, skey, &inode);
     if (s.IsNotFound()) {
         return MetaStatusCode::NOT_FOUND;
     } else if (!s.ok()) {
         return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     }
 
-    // get attr from inode
-    attr->set_inodeid(inode.inodeid());
-    attr->set_fsid(inode.fsid());
-    attr->set_length(inode.length());
-    attr->set_ctime(inode.ctime());
-    attr->set_ctime_ns(inode.ctime_ns());
-    attr->set_mtime(inode.mtime());
-    attr->set_mtime_ns(inode.mtime_ns());
-    attr->set_atime(inode.atime());
-    attr->set_atime_ns(inode.atime_ns());
-    attr->set_uid(inode.uid());
-    attr->set_gid(inode.gid());
-    attr->set_mode(inode.mode());
-    attr->set_nlink(inode.nlink());
-    attr->set_type(inode.type());
-    *(attr->mutable_parent()) = inode.parent();
-    if (inode.has_symlink()) {
-        attr->set_symlink(inode.symlink());
-    }
-    if (inode.has_rdev()) {
-        attr->set_rdev(inode.rdev());
-    }
-    if (inode.has_dtime()) {
-        attr->set_dtime(inode.dtime());
-    }
-    if (inode.xattr_size() > 0) {
-        *(attr->mutable_xattr()) = inode.xattr();
-    }
+    attr->Clear();
+    InodeToAttr(inode, attr);
     return MetaStatusCode::OK;
 }
 
 MetaStatusCode InodeStorage::GetXAttr(const Key4Inode& key, XAttr *xattr) {
-    ReadLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, key.fsId, key.inodeId, false);
     Inode inode;
     std::string skey = conv_.SerializeToString(key);
     Status s = kvStorage_->HGet(table4Inode_, skey, &inode);
@@ -172,16 +224,35 @@ MetaStatusCode InodeStorage::GetXAttr(const Key4Inode& key, XAttr *xattr) {
 }
 
 MetaStatusCode InodeStorage::Delete(const Key4Inode& key) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, key.fsId, key.inodeId, true);
     std::string skey = conv_.SerializeToString(key);
-    Status s = kvStorage_->HDel(table4Inode_, skey);
+    auto txn = kvStorage_->BeginTransaction();
+    if (nullptr == txn) {
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
+    Status s = txn->HDel(table4Inode_, skey);
+    if (s.ok()) {
+        s = txn->HDel(table4InodeAttr_, skey);
+    }
+    if (!s.ok()) {
+        LOG(ERROR) << "Delete inode failed, status = " << s.ToString();
+        if (!txn->Rollback().ok()) {
+            LOG(ERROR) << "Rollback transaction failed, inode = "
+                       << key.SerializeToString();
+        }
+    } else {
+        s = txn->Commit();
+    }
+
     if (s.ok()) {
         // NOTE: for rocksdb storage, it will never check whether
         // the key exist in delete(), so if the client delete the
         // unexist inode in some anbormal cases, it will cause the
         // nInode less then the real value.
-        if (nInode_ > 0) {
-            nInode_--;
+        size_t n = nInode_.load();
+        while (n > 0 && !nInode_.compare_exchange_weak(n, n - 1)) {
+            // n is reloaded by compare_exchange_weak() on failure
         }
         return MetaStatusCode::OK;
     }
@@ -190,20 +261,12 @@ MetaStatusCode InodeStorage::Delete(const Key4Inode& key) {
 }
 
 MetaStatusCode InodeStorage::Update(const Inode &inode, bool inodeDeallocate) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, inode.fsid(), inode.inodeid(), true);
     Key4Inode key(inode.fsid(), inode.inodeid());
     std::string skey = conv_.SerializeToString(key);
 
-    // only update inodes
-    if (!inodeDeallocate) {
-        Status s = kvStorage_->HSet(table4Inode_, skey, inode);
-        if (s.ok()) {
-            return MetaStatusCode::OK;
-        }
-        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
-    }
-
-    // update inode and update deallocatable inode list
+    // update inode and its attribute, and update deallocatable inode list
+    // if inode needs to deallocate space
     google::protobuf::Empty value;
     auto txn = kvStorage_->BeginTransaction();
     if (nullptr == txn) {
@@ -212,8 +275,10 @@ MetaStatusCode InodeStorage::Update(const Inode &inode, bool inodeDeallocate) {
 
     std::string step = "update inode " + key.SerializeToString();
 
-    Status s = txn->HSet(table4Inode_, skey, inode);
-    if (s.ok()) {
+    Status s;
+    if (SetInodeAndAttr(txn, skey, inode) != MetaStatusCode::OK) {
+        s = Status::InternalError();
+    } else if (inodeDeallocate) {
         s = txn->HSet(table4DeallocatableInode_, skey, value);
         step = "add inode " + key.SerializeToString() +
                " to inode deallocatable list";
@@ -224,8 +289,8 @@ MetaStatusCode InodeStorage::Update(const Inode &inode, bool inodeDeallocate) {
         if (!txn->Rollback().ok()) {
             LOG(ERROR) << "rollback transaction failed, inode="
                        << key.SerializeToString();
-            return  MetaStatusCode::STORAGE_INTERNAL_ERROR;
         }
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
     } else if (!txn->Commit().ok()) {
         LOG(ERROR) << "commit transaction failed, inode="
                    << key.SerializeToString();
@@ -237,13 +302,13 @@ MetaStatusCode InodeStorage::Update(const Inode &inode, bool inodeDeallocate) {
 
 
 std::shared_ptr<Iterator> InodeStorage::GetAllInode() {
-    ReadLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, false);
     std::string sprefix = conv_.SerializeToString(Prefix4AllInode());
     return kvStorage_->HGetAll(table4Inode_);
 }
 
 bool InodeStorage::GetAllInodeId(std::list<uint64_t>* ids) {
-    ReadLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, false);
     auto iterator = GetAllInode();
     if (iterator->Status() != 0) {
         LOG(ERROR) << "failed to get iterator for all inode";
@@ -261,12 +326,11 @@ bool InodeStorage::GetAllInodeId(std::list<uint64_t>* ids) {
 }
 
 size_t InodeStorage::Size() {
-    ReadLockGuard lg(rwLock_);
-    return nInode_;
+    return nInode_.load();
 }
 
 bool InodeStorage::Empty() {
-    ReadLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, false);
     auto iterator = GetAllInode();
     if (iterator->Status() != 0) {
         LOG(ERROR) << "failed to get iterator for all inode";
@@ -280,7 +344,7 @@ bool InodeStorage::Empty() {
 }
 
 MetaStatusCode InodeStorage::Clear() {
-    WriteLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, true);
     Status s = kvStorage_->HClear(table4Inode_);
     if (!s.ok()) {
         LOG(ERROR) << "InodeStorage clear inode table failed";
@@ -288,6 +352,12 @@ MetaStatusCode InodeStorage::Clear() {
     }
     nInode_ = 0;
 
+    s = kvStorage_->HClear(table4InodeAttr_);
+    if (!s.ok()) {
+        LOG(ERROR) << "InodeStorage clear inode attribute table failed";
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+
     s = kvStorage_->SClear(table4S3ChunkInfo_);
     if (!s.ok()) {
         LOG(ERROR) << "InodeStorage clear inode s3chunkinfo table failed";
@@ -455,7 +525,7 @@ MetaStatusCode InodeStorage::ModifyInodeS3ChunkInfoList(
     uint64_t chunkIndex,
     const S3ChunkInfoList* list2add,
     const S3ChunkInfoList* list2del) {
-    WriteLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, fsId, inodeId, true);
     auto txn = kvStorage_->BeginTransaction();
     std::string step;
     if (nullptr == txn) {
@@ -497,12 +567,14 @@ MetaStatusCode InodeStorage::PaddingInodeS3ChunkInfo(int32_t fsId,
                                                      uint64_t inodeId,
                                                      S3ChunkInfoMap* m,
                                                      uint64_t limit) {
-    ReadLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, fsId, inodeId, false);
     if (limit != 0 && GetInodeS3MetaSize(fsId, inodeId) > limit) {
         return MetaStatusCode::INODE_S3_META_TOO_LARGE;
     }
 
-    auto iterator = GetInodeS3ChunkInfoList(fsId, inodeId);
+    Prefix4InodeS3ChunkInfoList prefix(fsId, inodeId);
+    auto iterator = kvStorage_->SSeek(table4S3ChunkInfo_,
+                                      conv_.SerializeToString(prefix));
     if (iterator->Status() != 0) {
         LOG(ERROR) << "Get inode s3chunkinfo failed";
         return MetaStatusCode::STORAGE_INTERNAL_ERROR;
@@ -540,19 +612,19 @@ MetaStatusCode InodeStorage::PaddingInodeS3ChunkInfo(int32_t fsId,
 
 std::shared_ptr<Iterator> InodeStorage::GetInodeS3ChunkInfoList(
     uint32_t fsId, uint64_t inodeId) {
-    ReadLockGuard lg(rwLock_);
+    KeyLockGuard lg(lock_, fsId, inodeId, false);
     Prefix4InodeS3ChunkInfoList prefix(fsId, inodeId);
     std::string sprefix = conv_.SerializeToString(prefix);
     return kvStorage_->SSeek(table4S3ChunkInfo_, sprefix);
 }
 
 std::shared_ptr<Iterator> InodeStorage::GetAllS3ChunkInfoList() {
-    ReadLockGuard lg(rwLock_);
+    TableLockGuard lg(lock_, false);
     return kvStorage_->SGetAll(table4S3ChunkInfo_);
 }
 
 std::shared_ptr<Iterator> InodeStorage::GetAllVolumeExtentList() {
-    ReadLockGuard guard(rwLock_);
+    TableLockGuard lg(lock_, false);
     return kvStorage_->SGetAll(table4VolumeExtent_);
 }
 
@@ -560,7 +632,7 @@ MetaStatusCode InodeStorage::UpdateVolumeExtentSlice(
     uint32_t fsId,
     uint64_t inodeId,
     const VolumeExtentSlice& slice) {
-    WriteLockGuard guard(rwLock_);
+    KeyLockGuard lg(lock_, fsId, inodeId, true);
     auto key = conv_.SerializeToString(
         Key4VolumeExtentSlice{fsId, inodeId, slice.offset()});
 
@@ -573,7 +645,7 @@ MetaStatusCode InodeStorage::UpdateVolumeExtentSlice(
 MetaStatusCode
 InodeStorage::GetAllVolumeExtent(uint32_t fsId, uint64_t inodeId,
                                  VolumeExtentSliceList *extents) {
-    ReadLockGuard guard(rwLock_);
+    KeyLockGuard lg(lock_, fsId, inodeId, false);
     auto key = conv_.SerializeToString(Prefix4InodeVolumeExtent{fsId, inodeId});
     auto iter = kvStorage_->SSeek(table4VolumeExtent_, key);
 
@@ -597,7 +669,7 @@ InodeStorage::GetAllVolumeExtent(uint32_t fsId, uint64_t inodeId,
 
 std::shared_ptr<Iterator> InodeStorage::GetAllVolumeExtent(uint32_t fsId,
                                                            uint64_t inodeId) {
-    ReadLockGuard guard(rwLock_);
+    KeyLockGuard lg(lock_, fsId, inodeId, false);
     auto key = conv_.SerializeToString(Prefix4InodeVolumeExtent{fsId, inodeId});
     return kvStorage_->SSeek(table4VolumeExtent_, key);
 }
@@ -606,7 +678,7 @@ MetaStatusCode InodeStorage::GetVolumeExtentByOffset(uint32_t fsId,
                                                      uint64_t inodeId,
                                                      uint64_t offset,
                                                      VolumeExtentSlice* slice) {
-    ReadLockGuard guard(RWLock);
+    KeyLockGuard lg(lock_, fsId, inodeId, false);
     auto key =
         conv_.SerializeToString(Key4VolumeExtentSlice{fsId, inodeId, offset});
 
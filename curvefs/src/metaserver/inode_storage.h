@@ -23,6 +23,7 @@
 #ifndef CURVEFS_SRC_METASERVER_INODE_STORAGE_H_
 #define CURVEFS_SRC_METASERVER_INODE_STORAGE_H_
 
+#include <atomic>
 #include <list>
 #include <string>
 #include <memory>
@@ -34,8 +35,8 @@
 
 #include "absl/container/btree_set.h"
 #include "absl/container/btree_map.h"
-#include "src/common/concurrent/rw_lock.h"
 #include "curvefs/proto/metaserver.pb.h"
+#include "curvefs/src/metaserver/common/striped_lock.h"
 #include "curvefs/src/metaserver/storage/converter.h"
 #include "curvefs/src/metaserver/storage/utils.h"
 #include "curvefs/src/metaserver/storage/storage.h"
@@ -43,7 +44,6 @@
 namespace curvefs {
 namespace metaserver {
 
-using ::curve::common::RWLock;
 using ::curvefs::metaserver::storage::Iterator;
 using ::curvefs::metaserver::storage::KVStorage;
 using ::curvefs::metaserver::storage::StorageTransaction;
@@ -78,7 +78,9 @@ class InodeStorage {
     MetaStatusCode Get(const Key4Inode& key, Inode* inode);
 
     /**
-     * @brief get inode attribute from storage
+     * @brief get inode attribute from storage, the attribute is read from
+     *        the attribute table which is written along with the inode,
+     *        so the whole inode needn't be parsed
      * @param[in] key: the key of inode want to get
      * @param[out] attr: the inode attribute got
      * @return If inode not exist, return NOT_FOUND; else return OK
@@ -167,6 +169,10 @@ class InodeStorage {
         std::vector<DeallocatableBlockGroup> *deallocatableBlockGroupVec);
 
  private:
+    // write inode and its attribute in one transaction
+    MetaStatusCode SetInodeAndAttr(Transaction txn, const std::string& skey,
+                                   const Inode& inode);
+
     MetaStatusCode UpdateInodeS3MetaSize(Transaction txn, uint32_t fsId,
                                          uint64_t inodeId, uint64_t size4add,
                                          uint64_t size4del);
@@ -194,19 +200,18 @@ class InodeStorage {
                         DeallocatableBlockGroup *out);
 
  private:
-    // FIXME: please remove this lock, because we has locked each inode
-    // in inode manager, this lock only for proetct storage, but now we
-    // use rocksdb storage, it support write in parallel.
-    RWLock rwLock_;
     std::shared_ptr<KVStorage> kvStorage_;
     std::string table4Inode_;
+    std::string table4InodeAttr_;
     std::string table4S3ChunkInfo_;
     std::string table4VolumeExtent_;
     std::string table4InodeAuxInfo_;
     std::string table4DeallocatableBlockGroup_;
     std::string table4DeallocatableInode_;
 
-    size_t nInode_;
+    // operations on different inodes go in parallel for rocksdb storage
+    StripedTableLock lock_;
+    std::atomic<size_t> nInode_;
     Converter conv_;
 };
 
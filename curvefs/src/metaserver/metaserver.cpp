@@ -256,6 +256,7 @@ void Metaserver::Init() {
     InitResourceCollector();
     InitHeartbeat();
     InitInflightThrottle();
+    InitDirLeaseManager();
 
     S3CompactManager::GetInstance().Init(conf_);
 
@@ -469,7 +470,7 @@ void Metaserver::Run() {
     // add internal server
     server_ = absl::make_unique<brpc::Server>();
     metaService_ = absl::make_unique<MetaServerServiceImpl>(
-        copysetNodeManager_, inflightThrottle_.get());
+        copysetNodeManager_, inflightThrottle_.get(), dirLeaseManager_.get());
     copysetService_ =
         absl::make_unique<CopysetServiceImpl>(copysetNodeManager_);
     raftCliService2_ = absl::make_unique<RaftCliService2>(copysetNodeManager_);
@@ -639,6 +640,8 @@ void Metaserver::InitStorage() {
     LOG_IF(FATAL, !conf_->GetUInt64Value(
         "storage.s3_meta_inside_inode.limit_size",
         &options.s3MetaLimitSizeInsideInode));
+    LOG_IF(FATAL, !conf_->GetUInt32Value("storage.lock_stripes",
+                                         &options.lockStripes));
 
     if (options.type == "rocksdb") {
         storage::ParseRocksdbOptions(conf_.get());
@@ -719,6 +722,20 @@ void Metaserver::InitInflightThrottle() {
     inflightThrottle_ = absl::make_unique<InflightThrottle>(maxInflight);
 }
 
+void Metaserver::InitDirLeaseManager() {
+    DirLeaseOption option;
+    LOG_IF(WARNING, !conf_->GetUInt32Value("service.dirLease.leaseMs",
+                                           &option.leaseMs))
+        << "Not found `service.dirLease.leaseMs` in conf, use default value `"
+        << option.leaseMs << '`';
+    LOG_IF(WARNING, !conf_->GetUInt32Value("service.dirLease.notifyTimeoutMs",
+                                           &option.notifyTimeoutMs))
+        << "Not found `service.dirLease.notifyTimeoutMs` in conf, "
+        << "use default value `" << option.notifyTimeoutMs << '`';
+
+    dirLeaseManager_ = absl::make_unique<DirLeaseManager>(option);
+}
+
 struct TakeValueFromConfIfCmdNotSet {
     template <typename T>
     void operator()(const std::shared_ptr<Configuration>& conf,
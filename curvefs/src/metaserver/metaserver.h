@@ -32,6 +32,7 @@
 #include "curvefs/src/metaserver/copyset/copyset_node_manager.h"
 #include "curvefs/src/metaserver/copyset/raft_cli_service2.h"
 #include "curvefs/src/metaserver/copyset/copyset_service.h"
+#include "curvefs/src/metaserver/dir_lease_manager.h"
 #include "curvefs/src/metaserver/heartbeat.h"
 #include "curvefs/src/metaserver/inflight_throttle.h"
 #include "curvefs/src/metaserver/metaserver_service.h"
@@ -88,6 +89,7 @@ class Metaserver {
     void InitCopysetNodeManager();
     void InitLocalFileSystem();
     void InitInflightThrottle();
+    void InitDirLeaseManager();
     void InitHeartbeatOptions();
     void InitResourceCollector();
     void InitHeartbeat();
@@ -147,6 +149,7 @@ class Metaserver {
     RegisterOptions registerOptions_;
 
     std::unique_ptr<InflightThrottle> inflightThrottle_;
+    std::unique_ptr<DirLeaseManager> dirLeaseManager_;
     std::shared_ptr<curve::fs::LocalFileSystem> localFileSystem_;
 };
 }  // namespace metaserver
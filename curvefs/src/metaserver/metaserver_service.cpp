@@ -22,6 +22,8 @@
 
 #include <list>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "curvefs/src/metaserver/metaserver_service.h"
 #include "curvefs/src/metaserver/copyset/meta_operator.h"
@@ -35,6 +37,7 @@ namespace metaserver {
 
 using ::curvefs::metaserver::copyset::GetDentryOperator;
 using ::curvefs::metaserver::copyset::ListDentryOperator;
+using ::curvefs::metaserver::copyset::ListDentryPlusOperator;
 using ::curvefs::metaserver::copyset::CreateDentryOperator;
 using ::curvefs::metaserver::copyset::DeleteDentryOperator;
 using ::curvefs::metaserver::copyset::GetInodeOperator;
@@ -43,7 +46,10 @@ using ::curvefs::metaserver::copyset::BatchGetXAttrOperator;
 using ::curvefs::metaserver::copyset::CreateInodeOperator;
 using ::curvefs::metaserver::copyset::CreateRootInodeOperator;
 using ::curvefs::metaserver::copyset::CreateManageInodeOperator;
+using ::curvefs::metaserver::copyset::CreateNodeOperator;
+using ::curvefs::metaserver::copyset::AllocInodeIdOperator;
 using ::curvefs::metaserver::copyset::UpdateInodeOperator;
+using ::curvefs::metaserver::copyset::BatchUpdateInodeOperator;
 using ::curvefs::metaserver::copyset::GetOrModifyS3ChunkInfoOperator;
 using ::curvefs::metaserver::copyset::DeleteInodeOperator;
 using ::curvefs::metaserver::copyset::UpdateInodeS3VersionOperator;
@@ -98,6 +104,19 @@ struct OperatorHelper {
     InflightThrottle* throttle;
 };
 
+// notify holders of the directory leases after the directories changed
+template <typename ResponseT>
+google::protobuf::Closure* RevokeDirLeaseOnDone(
+    DirLeaseManager* manager, uint32_t fsId, std::vector<uint64_t> parents,
+    const ResponseT* response, google::protobuf::Closure* done) {
+    if (manager == nullptr || !manager->Enabled()) {
+        return done;
+    }
+    return new RevokeDirLeaseClosure<ResponseT>(manager, fsId,
+                                                std::move(parents), response,
+                                                done);
+}
+
 }  // namespace
 
 void MetaServerServiceImpl::GetDentry(
@@ -105,6 +124,12 @@ void MetaServerServiceImpl::GetDentry(
     const ::curvefs::metaserver::GetDentryRequest* request,
     ::curvefs::metaserver::GetDentryResponse* response,
     ::google::protobuf::Closure* done) {
+    // grant before the lookup, changes after it will be notified
+    if (request->has_leaseholder() && dirLeaseManager_ != nullptr) {
+        response->set_leasems(dirLeaseManager_->Grant(
+            request->fsid(), request->parentinodeid(),
+            request->leaseholder()));
+    }
     OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
     helper.operator()<GetDentryOperator>(controller, request, response, done,
                                          request->poolid(),
@@ -123,11 +148,25 @@ void MetaServerServiceImpl::ListDentry(
                                           request->copysetid());
 }
 
+void MetaServerServiceImpl::ListDentryPlus(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::ListDentryPlusRequest* request,
+    ::curvefs::metaserver::ListDentryPlusResponse* response,
+    ::google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<ListDentryPlusOperator>(controller, request, response,
+                                              done, request->poolid(),
+                                              request->copysetid());
+}
+
 void MetaServerServiceImpl::CreateDentry(
     ::google::protobuf::RpcController* controller,
     const ::curvefs::metaserver::CreateDentryRequest* request,
     ::curvefs::metaserver::CreateDentryResponse* response,
     ::google::protobuf::Closure* done) {
+    done = RevokeDirLeaseOnDone(dirLeaseManager_, request->dentry().fsid(),
+                                {request->dentry().parentinodeid()},
+                                response, done);
     OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
     helper.operator()<CreateDentryOperator>(controller, request, response, done,
                                             request->poolid(),
@@ -139,6 +178,8 @@ void MetaServerServiceImpl::DeleteDentry(
     const ::curvefs::metaserver::DeleteDentryRequest* request,
     ::curvefs::metaserver::DeleteDentryResponse* response,
     ::google::protobuf::Closure* done) {
+    done = RevokeDirLeaseOnDone(dirLeaseManager_, request->fsid(),
+                                {request->parentinodeid()}, response, done);
     OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
     helper.operator()<DeleteDentryOperator>(controller, request, response, done,
                                             request->poolid(),
@@ -213,6 +254,31 @@ void MetaServerServiceImpl::CreateManageInode(
                                                request->copysetid());
 }
 
+void MetaServerServiceImpl::CreateNode(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::CreateNodeRequest* request,
+    ::curvefs::metaserver::CreateNodeResponse* response,
+    ::google::protobuf::Closure* done) {
+    done = RevokeDirLeaseOnDone(dirLeaseManager_, request->fsid(),
+                                {request->dentry().parentinodeid()},
+                                response, done);
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<CreateNodeOperator>(controller, request, response, done,
+                                          request->poolid(),
+                                          request->copysetid());
+}
+
+void MetaServerServiceImpl::AllocInodeId(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::AllocInodeIdRequest* request,
+    ::curvefs::metaserver::AllocInodeIdResponse* response,
+    ::google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<AllocInodeIdOperator>(controller, request, response,
+                                            done, request->poolid(),
+                                            request->copysetid());
+}
+
 void MetaServerServiceImpl::UpdateInode(
     ::google::protobuf::RpcController* controller,
     const ::curvefs::metaserver::UpdateInodeRequest* request,
@@ -224,6 +290,17 @@ void MetaServerServiceImpl::UpdateInode(
                                            request->copysetid());
 }
 
+void MetaServerServiceImpl::BatchUpdateInode(
+    ::google::protobuf::RpcController* controller,
+    const ::curvefs::metaserver::BatchUpdateInodeRequest* request,
+    ::curvefs::metaserver::BatchUpdateInodeResponse* response,
+    ::google::protobuf::Closure* done) {
+    OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
+    helper.operator()<BatchUpdateInodeOperator>(controller, request, response,
+                                                done, request->poolid(),
+                                                request->copysetid());
+}
+
 void MetaServerServiceImpl::GetOrModifyS3ChunkInfo(
     ::google::protobuf::RpcController* controller,
     const ::curvefs::metaserver::GetOrModifyS3ChunkInfoRequest* request,
@@ -271,6 +348,14 @@ void MetaServerServiceImpl::PrepareRenameTx(
     google::protobuf::RpcController* controller,
     const PrepareRenameTxRequest* request, PrepareRenameTxResponse* response,
     google::protobuf::Closure* done) {
+    std::vector<uint64_t> parents;
+    for (const auto& dentry : request->dentrys()) {
+        parents.push_back(dentry.parentinodeid());
+    }
+    uint32_t fsId = request->dentrys_size() > 0 ? request->dentrys(0).fsid()
+                                                 : 0;
+    done = RevokeDirLeaseOnDone(dirLeaseManager_, fsId, std::move(parents),
+                                response, done);
     OperatorHelper helper(copysetNodeManager_, inflightThrottle_);
     helper.operator()<PrepareRenameTxOperator>(controller, request, response,
                                                done, request->poolid(),
@@ -28,6 +28,7 @@
 #include <memory>
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/metaserver/copyset/copyset_node_manager.h"
+#include "curvefs/src/metaserver/dir_lease_manager.h"
 #include "curvefs/src/metaserver/inflight_throttle.h"
 
 namespace curvefs {
@@ -38,9 +39,11 @@ using ::curvefs::metaserver::copyset::CopysetNodeManager;
 class MetaServerServiceImpl : public MetaServerService {
  public:
     MetaServerServiceImpl(CopysetNodeManager* copysetNodeManager,
-                          InflightThrottle* inflightThrottle)
+                          InflightThrottle* inflightThrottle,
+                          DirLeaseManager* dirLeaseManager = nullptr)
         : copysetNodeManager_(copysetNodeManager),
-          inflightThrottle_(inflightThrottle) {}
+          inflightThrottle_(inflightThrottle),
+          dirLeaseManager_(dirLeaseManager) {}
 
     void GetDentry(::google::protobuf::RpcController* controller,
                    const ::curvefs::metaserver::GetDentryRequest* request,
@@ -50,6 +53,11 @@ class MetaServerServiceImpl : public MetaServerService {
                     const ::curvefs::metaserver::ListDentryRequest* request,
                     ::curvefs::metaserver::ListDentryResponse* response,
                     ::google::protobuf::Closure* done) override;
+    void ListDentryPlus(
+        ::google::protobuf::RpcController* controller,
+        const ::curvefs::metaserver::ListDentryPlusRequest* request,
+        ::curvefs::metaserver::ListDentryPlusResponse* response,
+        ::google::protobuf::Closure* done) override;
     void CreateDentry(::google::protobuf::RpcController* controller,
                       const ::curvefs::metaserver::CreateDentryRequest* request,
                       ::curvefs::metaserver::CreateDentryResponse* response,
@@ -84,10 +92,23 @@ class MetaServerServiceImpl : public MetaServerService {
             const ::curvefs::metaserver::CreateManageInodeRequest* request,
             ::curvefs::metaserver::CreateManageInodeResponse* response,
             ::google::protobuf::Closure* done) override;
+    void CreateNode(::google::protobuf::RpcController* controller,
+                    const ::curvefs::metaserver::CreateNodeRequest* request,
+                    ::curvefs::metaserver::CreateNodeResponse* response,
+                    ::google::protobuf::Closure* done) override;
+    void AllocInodeId(::google::protobuf::RpcController* controller,
+                      const ::curvefs::metaserver::AllocInodeIdRequest* request,
+                      ::curvefs::metaserver::AllocInodeIdResponse* response,
+                      ::google::protobuf::Closure* done) override;
     void UpdateInode(::google::protobuf::RpcController* controller,
                      const ::curvefs::metaserver::UpdateInodeRequest* request,
                      ::curvefs::metaserver::UpdateInodeResponse* response,
                      ::google::protobuf::Closure* done) override;
+    void BatchUpdateInode(
+        ::google::protobuf::RpcController* controller,
+        const ::curvefs::metaserver::BatchUpdateInodeRequest* request,
+        ::curvefs::metaserver::BatchUpdateInodeResponse* response,
+        ::google::protobuf::Closure* done) override;
     void GetOrModifyS3ChunkInfo(
         ::google::protobuf::RpcController* controller,
         const ::curvefs::metaserver::GetOrModifyS3ChunkInfoRequest* request,
@@ -132,6 +153,8 @@ class MetaServerServiceImpl : public MetaServerService {
  private:
     CopysetNodeManager* copysetNodeManager_;
     InflightThrottle* inflightThrottle_;
+    // nullptr if directory leases are disabled
+    DirLeaseManager* dirLeaseManager_;
 };
 }  // namespace metaserver
 }  // namespace curvefs
@@ -22,10 +22,12 @@
 #include "curvefs/src/metaserver/metastore.h"
 
 #include <braft/storage.h>
+#include <butil/iobuf.h>
 #include <glog/logging.h>
 #include <sys/types.h>
 
 #include <memory>
+#include <string>
 #include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
@@ -62,6 +64,7 @@ using Key4S3ChunkInfoList = ::curvefs::metaserver::storage::Key4S3ChunkInfoList;
 using ::curvefs::metaserver::storage::MemoryStorage;
 using ::curvefs::metaserver::storage::RocksDBStorage;
 using ::curvefs::metaserver::storage::StorageOptions;
+using ::curvefs::metaserver::storage::WriteBatchGuard;
 
 namespace {
 const char *const kMetaDataFilename = "metadata";
@@ -351,15 +354,30 @@ std::shared_ptr<StreamServer> MetaStoreImpl::GetStreamServer() {
         return status;                                                         \
     }
 
+namespace {
+// Commit the write batch of the operation before replying, a failed commit
+// fails the whole operation, otherwise the client would believe a write
+// which is lost
+MetaStatusCode CommitWriteBatch(WriteBatchGuard *batchGuard,
+                                MetaStatusCode rc) {
+    if (!batchGuard->Commit().ok()) {
+        return MetaStatusCode::STORAGE_INTERNAL_ERROR;
+    }
+    return rc;
+}
+}  // namespace
 
 // dentry
 MetaStatusCode MetaStoreImpl::CreateDentry(const CreateDentryRequest *request,
                                            CreateDentryResponse *response) {
     ReadLockGuard readLockGuard(rwLock_);
+    // commit all writes of the operation as one write batch
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
     MetaStatusCode status = partition->CreateDentry(request->dentry());
+    status = CommitWriteBatch(&batchGuard, status);
     response->set_statuscode(status);
     return status;
 }
@@ -396,6 +414,7 @@ MetaStatusCode MetaStoreImpl::DeleteDentry(const DeleteDentryRequest *request,
     std::string name = request->name();
     auto txId = request->txid();
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
@@ -408,6 +427,7 @@ MetaStatusCode MetaStoreImpl::DeleteDentry(const DeleteDentryRequest *request,
     dentry.set_type(request->type());
 
     auto rc = partition->DeleteDentry(dentry);
+    rc = CommitWriteBatch(&batchGuard, rc);
     response->set_statuscode(rc);
     return rc;
 }
@@ -445,10 +465,107 @@ MetaStatusCode MetaStoreImpl::ListDentry(const ListDentryRequest *request,
     return rc;
 }
 
+MetaStatusCode
+MetaStoreImpl::ListDentryPlus(const ListDentryPlusRequest *request,
+                              ListDentryPlusResponse *response) {
+    std::string last = request->has_last() ? request->last() : "";
+    auto rc = ListDentryPlusInternal(request, last,
+                                     response->mutable_entries());
+    if (rc != MetaStatusCode::OK) {
+        response->clear_entries();
+    }
+    response->set_statuscode(rc);
+    return rc;
+}
+
+MetaStatusCode
+MetaStoreImpl::ListDentryPlusInternal(const ListDentryPlusRequest *request,
+                                      const std::string &last,
+                                      DentryPlusList *entries) {
+    uint32_t fsId = request->fsid();
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition =
+        GetPartition(request->partitionid());
+    if (partition == nullptr) {
+        return MetaStatusCode::PARTITION_NOT_FOUND;
+    }
+
+    Dentry dentry;
+    dentry.set_fsid(fsId);
+    dentry.set_parentinodeid(request->dirinodeid());
+    dentry.set_txid(request->txid());
+    dentry.set_name(last);
+
+    std::vector<Dentry> dentrys;
+    auto rc = partition->ListDentry(dentry, &dentrys, request->count(), false);
+    if (rc != MetaStatusCode::OK) {
+        return rc;
+    }
+
+    // attributes of inodes in other partitions are left to the client,
+    // it also happens if the inode is deleted concurrently
+    InodeAttr attr;
+    for (auto &item : dentrys) {
+        auto *entry = entries->Add();
+        if (partition->IsInodeBelongs(fsId, item.inodeid()) &&
+            partition->GetInodeAttr(fsId, item.inodeid(), &attr) ==
+                MetaStatusCode::OK) {
+            entry->mutable_attr()->Swap(&attr);
+        }
+        entry->mutable_dentry()->Swap(&item);
+    }
+    return MetaStatusCode::OK;
+}
+
+MetaStatusCode
+MetaStoreImpl::SendDentryPlusByStream(StreamConnection *connection,
+                                      const ListDentryPlusRequest *request,
+                                      DentryPlusList *entries) {
+    while (true) {
+        for (const auto &entry : *entries) {
+            butil::IOBuf buffer;
+            butil::IOBufAsZeroCopyOutputStream wrapper(&buffer);
+            if (!entry.SerializeToZeroCopyStream(&wrapper)) {
+                LOG(ERROR) << "Serialize dentry failed, dentry: "
+                           << entry.dentry().ShortDebugString();
+                return MetaStatusCode::PARAM_ERROR;
+            }
+
+            if (!connection->Write(buffer)) {
+                LOG(ERROR) << "Stream write failed in server-side";
+                return MetaStatusCode::RPC_STREAM_ERROR;
+            }
+        }
+
+        // the whole directory is listed
+        if (request->count() == 0 ||
+            entries->size() < static_cast<int>(request->count())) {
+            break;
+        }
+
+        std::string last = entries->rbegin()->dentry().name();
+        entries->Clear();
+        auto rc = ListDentryPlusInternal(request, last, entries);
+        if (rc != MetaStatusCode::OK) {
+            LOG(ERROR) << "List dentry failed, dir inodeid: "
+                       << request->dirinodeid() << ", last: " << last
+                       << ", error: " << MetaStatusCode_Name(rc);
+            return rc;
+        }
+    }
+
+    if (!connection->WriteDone()) {  // sending eof buffer
+        LOG(ERROR) << "Stream write done failed in server-side";
+        return MetaStatusCode::RPC_STREAM_ERROR;
+    }
+    return MetaStatusCode::OK;
+}
+
 MetaStatusCode
 MetaStoreImpl::PrepareRenameTx(const PrepareRenameTxRequest *request,
                                PrepareRenameTxResponse *response) {
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     MetaStatusCode rc;
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
@@ -456,6 +573,7 @@ MetaStoreImpl::PrepareRenameTx(const PrepareRenameTxRequest *request,
     std::vector<Dentry> dentrys{request->dentrys().begin(),
                                 request->dentrys().end()};
     rc = partition->HandleRenameTx(dentrys);
+    rc = CommitWriteBatch(&batchGuard, rc);
     response->set_statuscode(rc);
     return rc;
 }
@@ -493,11 +611,13 @@ MetaStatusCode MetaStoreImpl::CreateInode(const CreateInodeRequest *request,
     }
 
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
     MetaStatusCode status =
         partition->CreateInode(param, response->mutable_inode());
+    status = CommitWriteBatch(&batchGuard, status);
     response->set_statuscode(status);
     if (status != MetaStatusCode::OK) {
         response->clear_inode();
@@ -524,10 +644,12 @@ MetaStoreImpl::CreateRootInode(const CreateRootInodeRequest *request,
     }
 
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
     MetaStatusCode status = partition->CreateRootInode(param);
+    status = CommitWriteBatch(&batchGuard, status);
     response->set_statuscode(status);
     if (status != MetaStatusCode::OK) {
         LOG(ERROR) << "CreateRootInode fail, fsId = " << param.fsId
@@ -559,11 +681,13 @@ MetaStoreImpl::CreateManageInode(const CreateManageInodeRequest *request,
     }
 
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
     MetaStatusCode status = partition->CreateManageInode(
         param, request->managetype(), response->mutable_inode());
+    status = CommitWriteBatch(&batchGuard, status);
     response->set_statuscode(status);
     if (status != MetaStatusCode::OK) {
         LOG(ERROR) << "CreateManageInode fail, fsId = " << param.fsId
@@ -586,6 +710,73 @@ MetaStoreImpl::CreateManageInode(const CreateManageInodeRequest *request,
     return MetaStatusCode::OK;
 }
 
+MetaStatusCode MetaStoreImpl::CreateNode(const CreateNodeRequest *request,
+                                         CreateNodeResponse *response) {
+    absl::optional<struct timespec> timestamp;
+    if (request->has_create()) {
+        timestamp = absl::make_optional<struct timespec>(
+            timespec{static_cast<int64_t>(request->create().sec()),
+                     request->create().nsec()});
+    }
+
+    absl::optional<InodeParam> param;
+    if (request->has_newinode()) {
+        const auto &newInode = request->newinode();
+        if (newInode.type() == FsFileType::TYPE_SYM_LINK &&
+            newInode.symlink().empty()) {
+            response->set_statuscode(MetaStatusCode::SYM_LINK_EMPTY);
+            return MetaStatusCode::SYM_LINK_EMPTY;
+        }
+
+        param.emplace();
+        param->fsId = request->fsid();
+        param->length = newInode.length();
+        param->uid = newInode.uid();
+        param->gid = newInode.gid();
+        param->mode = newInode.mode();
+        param->type = newInode.type();
+        param->rdev = newInode.rdev();
+        param->parent = request->dentry().parentinodeid();
+        param->symlink = newInode.symlink();
+        param->timestamp = timestamp;
+    }
+
+    ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
+    std::shared_ptr<Partition> partition;
+    GET_PARTITION_OR_RETURN(partition);
+
+    MetaStatusCode status = partition->CreateNode(
+        request->dentry(), param, timestamp, response->mutable_inode());
+    status = CommitWriteBatch(&batchGuard, status);
+    response->set_statuscode(status);
+    if (status != MetaStatusCode::OK || !param.has_value()) {
+        response->clear_inode();
+    }
+    return status;
+}
+
+MetaStatusCode MetaStoreImpl::AllocInodeId(const AllocInodeIdRequest* request,
+                                           AllocInodeIdResponse* response) {
+    ReadLockGuard readLockGuard(rwLock_);
+    std::shared_ptr<Partition> partition;
+    GET_PARTITION_OR_RETURN(partition);
+
+    uint64_t start = 0;
+    uint32_t count = 0;
+    MetaStatusCode status = partition->AllocInodeId(
+        request->fsid(), request->count(), &start, &count);
+    response->set_statuscode(status);
+    if (status == MetaStatusCode::OK) {
+        PartitionInfo info = partition->GetPartitionInfo();
+        response->set_idstart(start);
+        response->set_idcount(count);
+        response->set_partitionstart(info.start());
+        response->set_partitionend(info.end());
+    }
+    return status;
+}
+
 MetaStatusCode MetaStoreImpl::GetInode(const GetInodeRequest *request,
                                        GetInodeResponse *response) {
     uint32_t fsId = request->fsid();
@@ -669,10 +860,12 @@ MetaStatusCode MetaStoreImpl::DeleteInode(const DeleteInodeRequest *request,
     uint64_t inodeId = request->inodeid();
 
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
     MetaStatusCode status = partition->DeleteInode(fsId, inodeId);
+    status = CommitWriteBatch(&batchGuard, status);
     response->set_statuscode(status);
     return status;
 }
@@ -680,11 +873,34 @@ MetaStatusCode MetaStoreImpl::DeleteInode(const DeleteInodeRequest *request,
 MetaStatusCode MetaStoreImpl::UpdateInode(const UpdateInodeRequest *request,
                                           UpdateInodeResponse *response) {
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     VLOG(9) << "UpdateInode inode " << request->inodeid();
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
     MetaStatusCode status = partition->UpdateInode(*request);
+    status = CommitWriteBatch(&batchGuard, status);
+    response->set_statuscode(status);
+    return status;
+}
+
+MetaStatusCode MetaStoreImpl::BatchUpdateInode(
+    const BatchUpdateInodeRequest *request,
+    BatchUpdateInodeResponse *response) {
+    ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
+    VLOG(9) << "BatchUpdateInode " << request->updates_size() << " inodes";
+    std::shared_ptr<Partition> partition;
+    GET_PARTITION_OR_RETURN(partition);
+
+    // a failed update doesn't affect others, the client retries it alone
+    for (const auto &update : request->updates()) {
+        response->add_statuses(partition->UpdateInode(update));
+    }
+    MetaStatusCode status = CommitWriteBatch(&batchGuard, MetaStatusCode::OK);
+    if (status != MetaStatusCode::OK) {
+        response->clear_statuses();
+    }
     response->set_statuscode(status);
     return status;
 }
@@ -695,6 +911,7 @@ MetaStatusCode MetaStoreImpl::GetOrModifyS3ChunkInfo(
     std::shared_ptr<Iterator> *iterator) {
     MetaStatusCode rc;
     ReadLockGuard readLockGuard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
@@ -709,6 +926,7 @@ MetaStatusCode MetaStoreImpl::GetOrModifyS3ChunkInfo(
             fsId, inodeId, response->mutable_s3chunkinfomap(), 0);
     }
 
+    rc = CommitWriteBatch(&batchGuard, rc);
     response->set_statuscode(rc);
     return rc;
 }
@@ -782,6 +1000,7 @@ MetaStatusCode
 MetaStoreImpl::UpdateVolumeExtent(const UpdateVolumeExtentRequest *request,
                                   UpdateVolumeExtentResponse *response) {
     ReadLockGuard guard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
@@ -789,6 +1008,7 @@ MetaStoreImpl::UpdateVolumeExtent(const UpdateVolumeExtentRequest *request,
 
     auto st = partition->UpdateVolumeExtent(request->fsid(), request->inodeid(),
                                             request->extents());
+    st = CommitWriteBatch(&batchGuard, st);
     response->set_statuscode(st);
     return st;
 }
@@ -797,6 +1017,7 @@ MetaStatusCode MetaStoreImpl::UpdateDeallocatableBlockGroup(
     const UpdateDeallocatableBlockGroupRequest *request,
     UpdateDeallocatableBlockGroupResponse *response) {
     ReadLockGuard guard(rwLock_);
+    WriteBatchGuard batchGuard(kvStorage_);
     std::shared_ptr<Partition> partition;
     GET_PARTITION_OR_RETURN(partition);
 
@@ -804,6 +1025,7 @@ MetaStatusCode MetaStoreImpl::UpdateDeallocatableBlockGroup(
             << request->ShortDebugString();
 
     auto st = partition->UpdateDeallocatableBlockGroup(*request);
+    st = CommitWriteBatch(&batchGuard, st);
     response->set_statuscode(st);
 
     return st;
@@ -44,11 +44,15 @@ namespace copyset {
 class CopysetNode;
 }  // namespace copyset
 
+using DentryPlusList = google::protobuf::RepeatedPtrField<DentryPlus>;
+
 // dentry
 using curvefs::metaserver::GetDentryRequest;
 using curvefs::metaserver::GetDentryResponse;
 using curvefs::metaserver::ListDentryRequest;
 using curvefs::metaserver::ListDentryResponse;
+using curvefs::metaserver::ListDentryPlusRequest;
+using curvefs::metaserver::ListDentryPlusResponse;
 using curvefs::metaserver::CreateDentryRequest;
 using curvefs::metaserver::CreateDentryResponse;
 using curvefs::metaserver::DeleteDentryRequest;
@@ -65,12 +69,18 @@ using curvefs::metaserver::CreateInodeRequest;
 using curvefs::metaserver::CreateInodeResponse;
 using curvefs::metaserver::UpdateInodeRequest;
 using curvefs::metaserver::UpdateInodeResponse;
+using curvefs::metaserver::BatchUpdateInodeRequest;
+using curvefs::metaserver::BatchUpdateInodeResponse;
 using curvefs::metaserver::DeleteInodeRequest;
 using curvefs::metaserver::DeleteInodeResponse;
 using curvefs::metaserver::CreateRootInodeRequest;
 using curvefs::metaserver::CreateRootInodeResponse;
 using curvefs::metaserver::CreateManageInodeRequest;
 using curvefs::metaserver::CreateManageInodeResponse;
+using curvefs::metaserver::CreateNodeRequest;
+using curvefs::metaserver::CreateNodeResponse;
+using curvefs::metaserver::AllocInodeIdRequest;
+using curvefs::metaserver::AllocInodeIdResponse;
 
 // partition
 using curvefs::metaserver::CreatePartitionRequest;
@@ -141,6 +151,16 @@ class MetaStore {
     virtual MetaStatusCode ListDentry(const ListDentryRequest* request,
                                       ListDentryResponse* response) = 0;
 
+    // list dentries with attributes of inodes in the same partition
+    virtual MetaStatusCode ListDentryPlus(const ListDentryPlusRequest* request,
+                                          ListDentryPlusResponse* response) = 0;
+
+    // send |entries| and all the following entries of the directory
+    virtual MetaStatusCode SendDentryPlusByStream(
+        StreamConnection* connection,
+        const ListDentryPlusRequest* request,
+        DentryPlusList* entries) = 0;
+
     virtual MetaStatusCode PrepareRenameTx(
         const PrepareRenameTxRequest* request,
         PrepareRenameTxResponse* response) = 0;
@@ -157,6 +177,14 @@ class MetaStore {
                                 const CreateManageInodeRequest* request,
                                 CreateManageInodeResponse* response) = 0;
 
+    // create inode and dentry, and update the parent in one operation
+    virtual MetaStatusCode CreateNode(const CreateNodeRequest* request,
+                                      CreateNodeResponse* response) = 0;
+
+    // lease a range of inode ids for creating inodes on client
+    virtual MetaStatusCode AllocInodeId(const AllocInodeIdRequest* request,
+                                        AllocInodeIdResponse* response) = 0;
+
     virtual MetaStatusCode GetInode(const GetInodeRequest* request,
                                     GetInodeResponse* response) = 0;
 
@@ -173,6 +201,12 @@ class MetaStore {
     virtual MetaStatusCode UpdateInode(const UpdateInodeRequest* request,
                                        UpdateInodeResponse* response) = 0;
 
+    // apply updates of inodes one by one, the status of each update is
+    // set in |response|
+    virtual MetaStatusCode BatchUpdateInode(
+        const BatchUpdateInodeRequest* request,
+        BatchUpdateInodeResponse* response) = 0;
+
     virtual MetaStatusCode GetOrModifyS3ChunkInfo(
         const GetOrModifyS3ChunkInfoRequest* request,
         GetOrModifyS3ChunkInfoResponse* response,
@@ -234,6 +268,14 @@ class MetaStoreImpl : public MetaStore {
     MetaStatusCode ListDentry(const ListDentryRequest* request,
                               ListDentryResponse* response) override;
 
+    MetaStatusCode ListDentryPlus(const ListDentryPlusRequest* request,
+                                  ListDentryPlusResponse* response) override;
+
+    MetaStatusCode SendDentryPlusByStream(
+        StreamConnection* connection,
+        const ListDentryPlusRequest* request,
+        DentryPlusList* entries) override;
+
     MetaStatusCode PrepareRenameTx(const PrepareRenameTxRequest* request,
                                    PrepareRenameTxResponse* response) override;
 
@@ -248,6 +290,12 @@ class MetaStoreImpl : public MetaStore {
                                 const CreateManageInodeRequest* request,
                                 CreateManageInodeResponse* response) override;
 
+    MetaStatusCode CreateNode(const CreateNodeRequest* request,
+                              CreateNodeResponse* response) override;
+
+    MetaStatusCode AllocInodeId(const AllocInodeIdRequest* request,
+                                AllocInodeIdResponse* response) override;
+
     MetaStatusCode GetInode(const GetInodeRequest* request,
                             GetInodeResponse* response) override;
 
@@ -263,6 +311,10 @@ class MetaStoreImpl : public MetaStore {
     MetaStatusCode UpdateInode(const UpdateInodeRequest* request,
                                UpdateInodeResponse* response) override;
 
+    MetaStatusCode BatchUpdateInode(
+        const BatchUpdateInodeRequest* request,
+        BatchUpdateInodeResponse* response) override;
+
     std::shared_ptr<Partition> GetPartition(uint32_t partitionId);
 
     MetaStatusCode GetOrModifyS3ChunkInfo(
@@ -304,6 +356,11 @@ class MetaStoreImpl : public MetaStore {
     MetaStoreImpl(copyset::CopysetNode* node,
                   const StorageOptions& storageOptions);
 
+    // list at most |request->count()| entries after |last|
+    MetaStatusCode ListDentryPlusInternal(const ListDentryPlusRequest* request,
+                                          const std::string& last,
+                                          DentryPlusList* entries);
+
     void PrepareStreamBuffer(butil::IOBuf* buffer,
                              uint64_t chunkIndex,
                              const std::string& value);
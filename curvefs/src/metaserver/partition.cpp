@@ -253,6 +253,79 @@ MetaStatusCode Partition::CreateManageInode(const InodeParam &param,
     return inodeManager_->CreateManageInode(param, manageType, inode);
 }
 
+MetaStatusCode Partition::CreateNode(
+    const Dentry& dentry, const absl::optional<InodeParam>& param,
+    const absl::optional<struct timespec>& timestamp, Inode* inode) {
+    PRECHECK(dentry.fsid(), dentry.parentinodeid());
+    if (!dentry.has_type()) {
+        LOG(ERROR) << "CreateNode does not have type, "
+                   << dentry.ShortDebugString();
+        return MetaStatusCode::PARAM_ERROR;
+    }
+
+    Dentry newDentry = dentry;
+    if (param.has_value() && dentry.inodeid() != 0) {
+        // inode id is leased by client, it must be allocated already
+        if (!IsInodeBelongs(dentry.fsid(), dentry.inodeid()) ||
+            dentry.inodeid() >= partitionInfo_.nextid()) {
+            LOG(ERROR) << "CreateNode with inode id not allocated, "
+                       << dentry.ShortDebugString();
+            return MetaStatusCode::PARAM_ERROR;
+        }
+    } else if (param.has_value()) {
+        if (GetStatus() == PartitionStatus::READONLY) {
+            return MetaStatusCode::PARTITION_ALLOC_ID_FAIL;
+        }
+
+        uint64_t inodeId = GetNewInodeId();
+        if (inodeId == UINT64_MAX) {
+            return MetaStatusCode::PARTITION_ALLOC_ID_FAIL;
+        }
+        newDentry.set_inodeid(inodeId);
+    }
+
+    // create dentry first, so nothing needs to be undone if it exists
+    MetaStatusCode ret = dentryManager_->CreateDentry(newDentry);
+    if (ret == MetaStatusCode::IDEMPOTENCE_OK) {
+        // the dentry refers to the inode id leased by client already, so
+        // it's a retry of a succeeded request, reply the inode created by it
+        if (param.has_value()) {
+            return inodeManager_->GetInode(newDentry.fsid(),
+                                           newDentry.inodeid(), inode);
+        }
+        return MetaStatusCode::OK;
+    } else if (ret != MetaStatusCode::OK) {
+        return ret;
+    }
+
+    if (param.has_value()) {
+        ret = inodeManager_->CreateInode(newDentry.inodeid(), *param, inode);
+        if (ret != MetaStatusCode::OK) {
+            LOG(ERROR) << "CreateNode create inode fail, ret = "
+                       << MetaStatusCode_Name(ret)
+                       << ", dentry: " << newDentry.ShortDebugString();
+            dentryManager_->DeleteDentry(newDentry);
+            return ret;
+        }
+    }
+
+    ret = inodeManager_->UpdateInodeWhenCreateOrRemoveSubNode(
+        newDentry.fsid(), newDentry.parentinodeid(), newDentry.type(), true,
+        timestamp);
+    if (ret != MetaStatusCode::OK) {
+        LOG(ERROR) << "CreateNode update parent fail, ret = "
+                   << MetaStatusCode_Name(ret)
+                   << ", dentry: " << newDentry.ShortDebugString();
+        if (param.has_value()) {
+            inodeManager_->DeleteInode(newDentry.fsid(), newDentry.inodeid());
+        }
+        dentryManager_->DeleteDentry(newDentry);
+        return ret;
+    }
+
+    return MetaStatusCode::OK;
+}
+
 MetaStatusCode Partition::GetInode(uint32_t fsId, uint64_t inodeId,
                                    Inode* inode) {
     PRECHECK(fsId, inodeId);
@@ -404,6 +477,26 @@ uint64_t Partition::GetNewInodeId() {
     return newInodeId;
 }
 
+MetaStatusCode Partition::AllocInodeId(uint32_t fsId, uint32_t count,
+                                       uint64_t* start, uint32_t* allocated) {
+    PRECHECK_FSID(fsId);
+    if (count == 0) {
+        return MetaStatusCode::PARAM_ERROR;
+    }
+
+    if (GetStatus() == PartitionStatus::READONLY ||
+        partitionInfo_.nextid() > partitionInfo_.end()) {
+        partitionInfo_.set_status(PartitionStatus::READONLY);
+        return MetaStatusCode::PARTITION_ALLOC_ID_FAIL;
+    }
+
+    *start = partitionInfo_.nextid();
+    *allocated = static_cast<uint32_t>(
+        std::min<uint64_t>(count, partitionInfo_.end() - *start + 1));
+    partitionInfo_.set_nextid(*start + *allocated);
+    return MetaStatusCode::OK;
+}
+
 uint32_t Partition::GetInodeNum() {
     return static_cast<uint32_t>(inodeStorage_->Size());
 }
@@ -27,6 +27,7 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "absl/types/optional.h"
 #include "curvefs/proto/common.pb.h"
 #include "curvefs/proto/metaserver.pb.h"
 #include "curvefs/src/common/define.h"
@@ -87,6 +88,17 @@ class Partition {
                                      ManageInodeType manageType,
                                      Inode* inode);
 
+    // create the dentry, and the inode it refers to if |param| is set,
+    // then update nlink and timestamps of the parent.
+    // the new inode uses the inode id of |dentry| if it's not 0, which
+    // must be allocated by AllocInodeId() before, and a retry with the
+    // same inode id returns the inode created before.
+    // writes are undone if any step fails
+    MetaStatusCode CreateNode(const Dentry& dentry,
+                              const absl::optional<InodeParam>& param,
+                              const absl::optional<struct timespec>& timestamp,
+                              Inode* inode);
+
     MetaStatusCode GetInode(uint32_t fsId, uint64_t inodeId, Inode* inode);
 
     MetaStatusCode GetInodeAttr(uint32_t fsId, uint64_t inodeId,
@@ -159,6 +171,11 @@ class Partition {
     // if no available inode id in this partiton ,return UINT64_MAX
     uint64_t GetNewInodeId();
 
+    // allocate at most |count| continuous inode ids in partition range,
+    // the ids are [*start, *start + *allocated)
+    MetaStatusCode AllocInodeId(uint32_t fsId, uint32_t count,
+                                uint64_t* start, uint32_t* allocated);
+
     uint32_t GetInodeNum();
 
     uint32_t GetDentryNum();
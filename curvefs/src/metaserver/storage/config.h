@@ -55,6 +55,10 @@ struct StorageOptions {
     // misc config item
     uint64_t s3MetaLimitSizeInsideInode;
 
+    // number of the per-key locks of the inode table and the dentry table
+    // of each partition, only rocksdb storage is locked per key
+    uint32_t lockStripes = 64;
+
     curve::fs::LocalFileSystem* localFileSystem = nullptr;
 };
 
@@ -54,6 +54,7 @@ static bool CompareType(const std::string& str, KEY_TYPE keyType) {
 
 NameGenerator::NameGenerator(uint32_t partitionId)
     : tableName4Inode_(Format(kTypeInode, partitionId)),
+      tableName4InodeAttr_(Format(kTypeInodeAttr, partitionId)),
       tableName4DeallocatableIndoe_(
           Format(kTypeDeallocatableInode, partitionId)),
       tableName4DeallocatableBlockGroup_(
@@ -67,6 +68,10 @@ std::string NameGenerator::GetInodeTableName() const {
     return tableName4Inode_;
 }
 
+std::string NameGenerator::GetInodeAttrTableName() const {
+    return tableName4InodeAttr_;
+}
+
 std::string NameGenerator::GetDeallocatableInodeTableName() const {
     return tableName4DeallocatableIndoe_;
 }
@@ -97,6 +102,18 @@ size_t NameGenerator::GetFixedLength() {
     return length;
 }
 
+bool NameGenerator::GetTableType(const std::string& tableName,
+                                 KEY_TYPE* type) {
+    size_t pos = tableName.find(kDelimiter);
+    uint32_t n;
+    if (pos == std::string::npos ||
+        !StringToUl(tableName.substr(0, pos), &n)) {
+        return false;
+    }
+    *type = static_cast<KEY_TYPE>(n);
+    return true;
+}
+
 std::string NameGenerator::Format(KEY_TYPE type, uint32_t partitionId) {
     char buf[sizeof(partitionId)];
     std::memcpy(buf, reinterpret_cast<char*>(&partitionId),
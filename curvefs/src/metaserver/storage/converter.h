@@ -46,6 +46,7 @@ enum KEY_TYPE : unsigned char {
     kTypeBlockGroup = 6,
     kTypeDeallocatableBlockGroup = 7,
     kTypeDeallocatableInode = 8,
+    kTypeInodeAttr = 9,
 };
 
 // NOTE: you must generate all table name by NameGenerator class for
@@ -57,6 +58,8 @@ class NameGenerator {
 
     std::string GetInodeTableName() const;
 
+    std::string GetInodeAttrTableName() const;
+
     std::string GetDeallocatableInodeTableName() const;
 
     std::string GetS3ChunkInfoTableName() const;
@@ -73,11 +76,15 @@ class NameGenerator {
 
     static size_t GetFixedLength();
 
+    // Get key type of a table name generated by NameGenerator
+    static bool GetTableType(const std::string& tableName, KEY_TYPE* type);
+
  private:
     std::string Format(KEY_TYPE type, uint32_t partitionId);
 
  private:
     std::string tableName4Inode_;
+    std::string tableName4InodeAttr_;
     std::string tableName4DeallocatableIndoe_;
     std::string tableName4DeallocatableBlockGroup_;
     std::string tableName4S3ChunkInfo_;
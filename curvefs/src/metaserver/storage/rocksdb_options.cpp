@@ -30,6 +30,7 @@
 #include "curvefs/src/metaserver/storage/rocksdb_event_listener.h"
 #include "curvefs/src/metaserver/storage/rocksdb_storage.h"
 #include "rocksdb/filter_policy.h"
+#include "rocksdb/slice_transform.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/table.h"
 #include "src/common/gflags_helper.h"
@@ -113,6 +114,49 @@ std::shared_ptr<rocksdb::WriteBufferManager> rocksdbWriteBufferManager;
 std::shared_ptr<MetricEventListener> metricEventListener;
 
 const char* const kOrderedColumnFamilyName = "ordered_column_family";
+const char* const kInodeColumnFamilyName = "inode_column_family";
+const char* const kDentryColumnFamilyName = "dentry_column_family";
+const char* const kS3ChunkInfoColumnFamilyName = "s3_chunk_info_column_family";
+const char* const kVolumeExtentColumnFamilyName = "volume_extent_column_family";
+
+// Extract `table prefix:type:fsId:inodeId:` from keys, so dentries of one
+// parent, and s3 chunk info lists or extents of one inode share a prefix,
+// and seeking them can be filtered by prefix bloom filter.
+class InodePrefixTransform : public rocksdb::SliceTransform {
+ public:
+    explicit InodePrefixTransform(size_t tablePrefixLength)
+        : tablePrefixLength_(tablePrefixLength) {}
+
+    const char* Name() const override {
+        return "curvefs.InodePrefixTransform";
+    }
+
+    rocksdb::Slice Transform(const rocksdb::Slice& key) const override {
+        return rocksdb::Slice(key.data(), PrefixLength(key));
+    }
+
+    bool InDomain(const rocksdb::Slice& key) const override {
+        return PrefixLength(key) != 0;
+    }
+
+ private:
+    // length of the prefix, 0 if the key doesn't have one
+    size_t PrefixLength(const rocksdb::Slice& key) const {
+        // skip table prefix and the delimiter after it, table prefix
+        // contains binary partition id, so it can't be parsed by delimiter
+        size_t delimiters = 0;
+        for (size_t i = tablePrefixLength_ + 1; i < key.size(); i++) {
+            if (key[i] == ':' && ++delimiters == kPrefixDelimiters) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+ private:
+    static constexpr size_t kPrefixDelimiters = 3;
+    size_t tablePrefixLength_;
+};
 
 void CreateBlockCacheAndWriterBufferManager() {
     static std::once_flag createBlockCache;
@@ -208,10 +252,37 @@ void InitRocksdbOptions(
     unorderedCfOptions.max_write_buffer_number =
         FLAGS_rocksdb_unordered_cf_max_write_buffer_number;
 
+    // inodes are point lookup only
+    rocksdb::ColumnFamilyOptions inodeCfOptions = unorderedCfOptions;
+    inodeCfOptions.memtable_whole_key_filtering = true;
+
+    std::shared_ptr<const rocksdb::SliceTransform> inodePrefixTransform =
+        std::make_shared<InodePrefixTransform>(
+            RocksDBStorage::GetKeyPrefixLength());
+
+    // dentries are looked up by name and listed by parent
+    rocksdb::ColumnFamilyOptions dentryCfOptions = orderedCfOptions;
+    dentryCfOptions.prefix_extractor = inodePrefixTransform;
+    dentryCfOptions.memtable_whole_key_filtering = true;
+
+    // s3 chunk info lists and extents are always seeked by inode
+    rocksdb::ColumnFamilyOptions inodeSeekCfOptions = orderedCfOptions;
+    inodeSeekCfOptions.prefix_extractor = inodePrefixTransform;
+
+    // NOTE: the order must be same as `ColumnFamilyIndex`
     columnFamilies->push_back(rocksdb::ColumnFamilyDescriptor{
         rocksdb::kDefaultColumnFamilyName, unorderedCfOptions});
     columnFamilies->push_back(rocksdb::ColumnFamilyDescriptor{
         kOrderedColumnFamilyName, orderedCfOptions});
+    columnFamilies->push_back(rocksdb::ColumnFamilyDescriptor{
+        kInodeColumnFamilyName, inodeCfOptions});
+    columnFamilies->push_back(rocksdb::ColumnFamilyDescriptor{
+        kDentryColumnFamilyName, dentryCfOptions});
+    columnFamilies->push_back(rocksdb::ColumnFamilyDescriptor{
+        kS3ChunkInfoColumnFamilyName, inodeSeekCfOptions});
+    columnFamilies->push_back(rocksdb::ColumnFamilyDescriptor{
+        kVolumeExtentColumnFamilyName, inodeSeekCfOptions});
+    assert(columnFamilies->size() == kColumnFamilyNum);
 }
 
 void ParseRocksdbOptions(curve::common::Configuration* conf) {
@@ -22,6 +22,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <ostream>
 #include <iostream>
 #include <unordered_map>
@@ -33,6 +34,7 @@
 #include "curvefs/src/metaserver/storage/rocksdb_perf.h"
 #include "curvefs/src/metaserver/storage/rocksdb_storage.h"
 #include "curvefs/src/metaserver/storage/rocksdb_options.h"
+#include "absl/memory/memory.h"
 #include "rocksdb/utilities/checkpoint.h"
 #include "src/fs/local_filesystem.h"
 
@@ -44,6 +46,27 @@ using ::curve::common::TimeUtility;
 
 const std::string RocksDBStorage::kDelimiter_ = ":";  // NOLINT
 
+namespace {
+
+// written to the default column family after the tables are moved to their
+// own column family, it doesn't collide with any internal key which starts
+// with "0:" or "1:"
+const char kColumnFamiliesMigratedKey[] = "column_families_migrated";
+
+// Write batch of the operation which current thread is applying
+struct WriteBatchContext {
+    DB* db = nullptr;
+    // nested level of BeginWriteBatch()
+    int depth = 0;
+    // number of transactions nested in the batch
+    int savePoints = 0;
+    std::unique_ptr<WriteBatchWithIndex> batch;
+};
+
+thread_local WriteBatchContext writeBatchContext;
+
+}  // namespace
+
 Status ToStorageStatus(const ROCKSDB_NAMESPACE::Status& s) {
     if (s.ok()) {
         return Status::OK();
@@ -127,6 +150,90 @@ bool RocksDBStorage::Open() {
     db_ = txnDB_->GetBaseDB();
 
     inited_ = true;
+    if (!MigrateColumnFamilies()) {
+        LOG(ERROR) << "Migrate column families failed";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool RocksDBStorage::MigrateColumnFamilies() {
+    // databases created by old versions store all tables in the ordered and
+    // unordered column families, move them to their own column family.
+    // It's done only once, the marker is copied into checkpoints too
+    std::string marker;
+    auto status = db_->Get(dbReadOptions_, handles_[kUnorderedColumnFamily],
+                           kColumnFamiliesMigratedKey, &marker);
+    if (status.ok()) {
+        return true;
+    } else if (!status.IsNotFound()) {
+        LOG(ERROR) << "Get column families migrated marker failed, status = "
+                   << status.ToString();
+        return false;
+    }
+
+    const size_t kBatchSize = 1024;
+    const size_t prefixLength = GetKeyPrefixLength();
+    const size_t nameOffset = 1 + kDelimiter_.size();
+    const size_t nameLength =
+        prefixLength - nameOffset - kDelimiter_.size() - 1;
+    uint64_t moved = 0;
+
+    for (size_t index : {kUnorderedColumnFamily, kOrderedColumnFamily}) {
+        bool ordered = (index == kOrderedColumnFamily);
+        ROCKSDB_NAMESPACE::WriteBatch batch;
+        std::unique_ptr<rocksdb::Iterator> iter(
+            db_->NewIterator(dbReadOptions_, handles_[index]));
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            auto key = iter->key();
+            if (key.size() < prefixLength) {
+                continue;
+            }
+
+            std::string name(key.data() + nameOffset, nameLength);
+            size_t target = GetColumnFamilyIndex(name, ordered);
+            if (target == index) {
+                continue;
+            }
+
+            batch.Put(handles_[target], key, iter->value());
+            batch.Delete(handles_[index], key);
+            if (static_cast<size_t>(batch.Count()) >= kBatchSize * 2) {
+                auto s = db_->Write(dbWriteOptions_, &batch);
+                if (!s.ok()) {
+                    LOG(ERROR) << "Move keys failed, status = "
+                               << s.ToString();
+                    return false;
+                }
+                moved += batch.Count() / 2;
+                batch.Clear();
+            }
+        }
+
+        if (!iter->status().ok()) {
+            LOG(ERROR) << "Iterate column family failed, status = "
+                       << iter->status().ToString();
+            return false;
+        } else if (batch.Count() > 0) {
+            auto s = db_->Write(dbWriteOptions_, &batch);
+            if (!s.ok()) {
+                LOG(ERROR) << "Move keys failed, status = " << s.ToString();
+                return false;
+            }
+            moved += batch.Count() / 2;
+        }
+    }
+
+    status = db_->Put(dbWriteOptions_, handles_[kUnorderedColumnFamily],
+                      kColumnFamiliesMigratedKey, "");
+    if (!status.ok()) {
+        LOG(ERROR) << "Put column families migrated marker failed, status = "
+                   << status.ToString();
+        return false;
+    }
+    LOG_IF(INFO, moved > 0) << "Moved " << moved
+                            << " keys to their own column family";
     return true;
 }
 
@@ -162,8 +269,94 @@ bool RocksDBStorage::Close() {
     return true;
 }
 
-inline ColumnFamilyHandle* RocksDBStorage::GetColumnFamilyHandle(bool ordered) {
-    return ordered ? handles_[1] : handles_[0];
+size_t RocksDBStorage::GetColumnFamilyIndex(const std::string& name,
+                                            bool ordered) {
+    KEY_TYPE type;
+    if (NameGenerator::GetTableType(name, &type)) {
+        switch (type) {
+            case kTypeInode:
+            case kTypeInodeAttr:
+                return kInodeColumnFamily;
+            case kTypeDentry:
+                return kDentryColumnFamily;
+            case kTypeS3ChunkInfo:
+                return kS3ChunkInfoColumnFamily;
+            case kTypeVolumeExtent:
+                return kVolumeExtentColumnFamily;
+            default:
+                break;
+        }
+    }
+    return ordered ? kOrderedColumnFamily : kUnorderedColumnFamily;
+}
+
+inline ColumnFamilyHandle* RocksDBStorage::GetColumnFamilyHandle(
+    const std::string& name, bool ordered) {
+    return handles_[GetColumnFamilyIndex(name, ordered)];
+}
+
+WriteBatchWithIndex* RocksDBStorage::GetWriteBatch() {
+    auto& ctx = writeBatchContext;
+    if (ctx.depth > 0 && ctx.db == db_) {
+        return ctx.batch.get();
+    }
+    return nullptr;
+}
+
+bool RocksDBStorage::BeginWriteBatch() {
+    auto& ctx = writeBatchContext;
+    if (!inited_ || InTransaction_) {
+        return false;
+    } else if (ctx.depth > 0) {
+        // current thread is applying a batch of another storage
+        if (ctx.db != db_) {
+            return false;
+        }
+        ctx.depth++;
+        return true;
+    }
+
+    ctx.db = db_;
+    ctx.depth = 1;
+    ctx.savePoints = 0;
+    ctx.batch = absl::make_unique<WriteBatchWithIndex>(
+        ROCKSDB_NAMESPACE::BytewiseComparator(), 0, /*overwrite_key*/ true);
+    return true;
+}
+
+Status RocksDBStorage::FlushWriteBatch() {
+    auto* batch = GetWriteBatch();
+    if (nullptr == batch || batch->GetWriteBatch()->Count() == 0) {
+        return Status::OK();
+    }
+
+    ROCKSDB_NAMESPACE::Status s;
+    {
+        RocksDBPerfGuard guard(OP_WRITE_BATCH);
+        s = db_->Write(dbWriteOptions_, batch->GetWriteBatch());
+    }
+    if (!s.ok()) {
+        LOG(ERROR) << "Write batch failed, status = " << s.ToString();
+    }
+    batch->Clear();
+    return ToStorageStatus(s);
+}
+
+Status RocksDBStorage::CommitWriteBatch() {
+    auto& ctx = writeBatchContext;
+    if (GetWriteBatch() == nullptr) {
+        return Status::NotSupported();
+    } else if (--ctx.depth > 0) {
+        return Status::OK();
+    }
+
+    // the outermost one, commit the whole batch
+    ctx.depth = 1;
+    Status s = FlushWriteBatch();
+    ctx.depth = 0;
+    ctx.db = nullptr;
+    ctx.batch.reset();
+    return s;
 }
 
 /* NOTE:
@@ -209,11 +402,18 @@ Status RocksDBStorage::Get(const std::string& name,
     ROCKSDB_NAMESPACE::Status s;
     std::string svalue;
     std::string ikey = ToInternalKey(name, key, ordered);
-    auto handle = GetColumnFamilyHandle(ordered);
+    auto handle = GetColumnFamilyHandle(name, ordered);
+    auto* batch = GetWriteBatch();
     {
         RocksDBPerfGuard guard(OP_GET);
-        s = InTransaction_ ? txn_->Get(dbReadOptions_, handle, ikey, &svalue) :
-                             db_->Get(dbReadOptions_, handle, ikey, &svalue);
+        if (txn_ != nullptr) {
+            s = txn_->Get(dbReadOptions_, handle, ikey, &svalue);
+        } else if (batch != nullptr) {
+            s = batch->GetFromBatchAndDB(db_, dbReadOptions_, handle, ikey,
+                                         &svalue);
+        } else {
+            s = db_->Get(dbReadOptions_, handle, ikey, &svalue);
+        }
     }
     if (s.ok() && !value->ParseFromString(svalue)) {
         return Status::ParsedFailed();
@@ -232,12 +432,18 @@ Status RocksDBStorage::Set(const std::string& name,
         return Status::SerializedFailed();
     }
 
-    auto handle = GetColumnFamilyHandle(ordered);
+    auto handle = GetColumnFamilyHandle(name, ordered);
     std::string ikey = ToInternalKey(name, key, ordered);
+    auto* batch = GetWriteBatch();
     RocksDBPerfGuard guard(OP_PUT);
-    ROCKSDB_NAMESPACE::Status s = InTransaction_ ?
-        txn_->Put(handle, ikey, svalue) :
-        db_->Put(dbWriteOptions_, handle, ikey, svalue);
+    ROCKSDB_NAMESPACE::Status s;
+    if (txn_ != nullptr) {
+        s = txn_->Put(handle, ikey, svalue);
+    } else if (batch != nullptr) {
+        s = batch->Put(handle, ikey, svalue);
+    } else {
+        s = db_->Put(dbWriteOptions_, handle, ikey, svalue);
+    }
     return ToStorageStatus(s);
 }
 
@@ -249,28 +455,51 @@ Status RocksDBStorage::Del(const std::string& name,
     }
 
     std::string ikey = ToInternalKey(name, key, ordered);
-    auto handle = GetColumnFamilyHandle(ordered);
+    auto handle = GetColumnFamilyHandle(name, ordered);
+    auto* batch = GetWriteBatch();
     RocksDBPerfGuard guard(OP_DELETE);
-    ROCKSDB_NAMESPACE::Status s = InTransaction_ ?
-        txn_->Delete(handle, ikey) :
-        db_->Delete(dbWriteOptions_, handle, ikey);
+    ROCKSDB_NAMESPACE::Status s;
+    if (txn_ != nullptr) {
+        s = txn_->Delete(handle, ikey);
+    } else if (batch != nullptr) {
+        s = batch->Delete(handle, ikey);
+    } else {
+        s = db_->Delete(dbWriteOptions_, handle, ikey);
+    }
     return ToStorageStatus(s);
 }
 
-std::shared_ptr<Iterator> RocksDBStorage::Seek(const std::string& name,
-                                               const std::string& prefix) {
+std::shared_ptr<Iterator> RocksDBStorage::NewIterator(
+    const std::string& name, std::string ikey, bool ordered) {
     int status = inited_ ? 0 : -1;
-    std::string ikey = ToInternalKey(name, prefix, true);
+    auto handle = inited_ ? GetColumnFamilyHandle(name, ordered) : nullptr;
+    auto* batch = GetWriteBatch();
+    if (status == 0 && txn_ == nullptr && batch != nullptr) {
+        if (InTransaction_ || writeBatchContext.savePoints > 0) {
+            // iterate with pending writes, the iterator must be released
+            // before the batch is committed
+            return std::make_shared<RocksDBStorageIterator>(
+                this, std::move(ikey), 0, status, handle, batch);
+        }
+
+        // the iterator may outlive current batch, write pending writes
+        // to database before iterating
+        if (!FlushWriteBatch().ok()) {
+            status = -1;
+        }
+    }
     return std::make_shared<RocksDBStorageIterator>(
-        this, ikey, 0, status, true);
+        this, std::move(ikey), 0, status, handle);
+}
+
+std::shared_ptr<Iterator> RocksDBStorage::Seek(const std::string& name,
+                                               const std::string& prefix) {
+    return NewIterator(name, ToInternalKey(name, prefix, true), true);
 }
 
 std::shared_ptr<Iterator> RocksDBStorage::GetAll(const std::string& name,
                                                  bool ordered) {
-    int status = inited_ ? 0 : -1;
-    std::string ikey = ToInternalKey(name, "", ordered);
-    return std::make_shared<RocksDBStorageIterator>(
-        this, std::move(ikey), 0, status, ordered);
+    return NewIterator(name, ToInternalKey(name, "", ordered), ordered);
 }
 
 size_t RocksDBStorage::Size(const std::string& name, bool ordered) {
@@ -299,7 +528,13 @@ Status RocksDBStorage::Clear(const std::string& name, bool ordered) {
     // database's checkpoint in raft snapshot
     // But, currently, many unittest cases depend it
 
-    auto handle = GetColumnFamilyHandle(ordered);
+    // DeleteRange isn't supported by write batch with index
+    Status st = FlushWriteBatch();
+    if (!st.ok()) {
+        return st;
+    }
+
+    auto handle = GetColumnFamilyHandle(name, ordered);
     std::string lower = ToInternalName(name, ordered, true);
     std::string upper = ToInternalName(name, ordered, false);
     RocksDBPerfGuard guard(OP_DELETE_RANGE);
@@ -311,6 +546,14 @@ Status RocksDBStorage::Clear(const std::string& name, bool ordered) {
 }
 
 std::shared_ptr<StorageTransaction> RocksDBStorage::BeginTransaction() {
+    auto* batch = GetWriteBatch();
+    if (batch != nullptr) {
+        // nested in the write batch, rollback to the save point if failed
+        batch->SetSavePoint();
+        writeBatchContext.savePoints++;
+        return std::make_shared<RocksDBStorage>(*this, nullptr);
+    }
+
     RocksDBPerfGuard guard(OP_BEGIN_TRANSACTION);
     ROCKSDB_NAMESPACE::Transaction* txn =
         txnDB_->BeginTransaction(dbWriteOptions_);
@@ -321,8 +564,15 @@ std::shared_ptr<StorageTransaction> RocksDBStorage::BeginTransaction() {
 }
 
 Status RocksDBStorage::Commit() {
-    if (!InTransaction_ || nullptr == txn_) {
+    if (!InTransaction_) {
         return Status::NotSupported();
+    } else if (nullptr == txn_) {
+        auto* batch = GetWriteBatch();
+        if (nullptr == batch) {
+            return Status::NotSupported();
+        }
+        writeBatchContext.savePoints--;
+        return ToStorageStatus(batch->PopSavePoint());
     }
 
     RocksDBPerfGuard guard(OP_COMMIT_TRANSACTION);
@@ -336,8 +586,15 @@ Status RocksDBStorage::Commit() {
 }
 
 Status RocksDBStorage::Rollback()  {
-    if (!InTransaction_ || nullptr == txn_) {
+    if (!InTransaction_) {
         return Status::NotSupported();
+    } else if (nullptr == txn_) {
+        auto* batch = GetWriteBatch();
+        if (nullptr == batch) {
+            return Status::NotSupported();
+        }
+        writeBatchContext.savePoints--;
+        return ToStorageStatus(batch->RollbackToSavePoint());
     }
 
     RocksDBPerfGuard guard(OP_ROLLBACK_TRANSACTION);
@@ -406,9 +663,26 @@ bool DuplicateRocksdbCheckpoint(const std::string& from,
 
     InitRocksdbOptions(&dbOptions, &columnFamilies, /*createIfMissing*/ false);
 
+    // checkpoints of old versions don't have all column families,
+    // and read-only mode requires opening existing ones only
+    std::vector<std::string> existing;
+    auto status = rocksdb::DB::ListColumnFamilies(dbOptions, from, &existing);
+    if (!status.ok()) {
+        LOG(ERROR) << "Failed to list column families of checkpoint, error: "
+                   << status.ToString();
+        return false;
+    }
+    columnFamilies.erase(
+        std::remove_if(columnFamilies.begin(), columnFamilies.end(),
+                       [&existing](const rocksdb::ColumnFamilyDescriptor& cf) {
+                           return std::find(existing.begin(), existing.end(),
+                                            cf.name) == existing.end();
+                       }),
+        columnFamilies.end());
+
     std::vector<rocksdb::ColumnFamilyHandle*> cfHandles;
 
-    auto status = rocksdb::DB::OpenForReadOnly(
+    status = rocksdb::DB::OpenForReadOnly(
         dbOptions, from, columnFamilies, &cfHandles, &db,
         /* error_if_wal_file_exists */ true);
 
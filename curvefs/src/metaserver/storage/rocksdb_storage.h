@@ -38,6 +38,7 @@
 #include "rocksdb/table_properties.h"
 #include "rocksdb/utilities/transaction.h"
 #include "rocksdb/utilities/transaction_db.h"
+#include "rocksdb/utilities/write_batch_with_index.h"
 #include "rocksdb/utilities/table_properties_collectors.h"
 #include "src/common/concurrent/rw_lock.h"
 #include "curvefs/src/metaserver/storage/utils.h"
@@ -63,8 +64,23 @@ using ROCKSDB_NAMESPACE::NewLRUCache;
 using ROCKSDB_NAMESPACE::NewBloomFilterPolicy;
 using ROCKSDB_NAMESPACE::NewFixedPrefixTransform;
 using ROCKSDB_NAMESPACE::NewBlockBasedTableFactory;
+using ROCKSDB_NAMESPACE::WriteBatchWithIndex;
 using STORAGE_TYPE = KVStorage::STORAGE_TYPE;
 
+// Column families of rocksdb storage, tables of inodes, dentries,
+// s3 chunk info lists and volume extents are stored in their own column
+// family, the rest are stored in the ordered or unordered one.
+// NOTE: the order must be same as column family descriptors.
+enum ColumnFamilyIndex : size_t {
+    kUnorderedColumnFamily = 0,
+    kOrderedColumnFamily = 1,
+    kInodeColumnFamily = 2,
+    kDentryColumnFamily = 3,
+    kS3ChunkInfoColumnFamily = 4,
+    kVolumeExtentColumnFamily = 5,
+    kColumnFamilyNum = 6,
+};
+
 // NOTE: The HSize() and SSize() is an expensive operation for rocksdb storage,
 // you should only invoke it in test cases.
 class RocksDBStorage : public KVStorage, public StorageTransaction {
@@ -131,8 +147,28 @@ class RocksDBStorage : public KVStorage, public StorageTransaction {
 
     bool Recover(const std::string& dir) override;
 
+    bool BeginWriteBatch() override;
+
+    Status CommitWriteBatch() override;
+
  private:
-    ColumnFamilyHandle* GetColumnFamilyHandle(bool ordered);
+    static size_t GetColumnFamilyIndex(const std::string& name, bool ordered);
+
+    ColumnFamilyHandle* GetColumnFamilyHandle(const std::string& name,
+                                              bool ordered);
+
+    // write batch of current thread if it belongs to this storage
+    WriteBatchWithIndex* GetWriteBatch();
+
+    // write pending batch of current thread to database
+    Status FlushWriteBatch();
+
+    // move tables of old databases to their own column family, it's done
+    // once for each database.
+    // NOTE: rolling back to an old version after upgrade is unsupported, old
+    // metaservers can't read the tables in the new column families, neither
+    // in the local database nor in the checkpoints sent by new ones
+    bool MigrateColumnFamilies();
 
     static size_t GetKeyPrefixLength();
 
@@ -163,6 +199,10 @@ class RocksDBStorage : public KVStorage, public StorageTransaction {
     std::shared_ptr<Iterator> Seek(const std::string& name,
                                    const std::string& prefix);
 
+    std::shared_ptr<Iterator> NewIterator(const std::string& name,
+                                          std::string ikey,
+                                          bool ordered);
+
     // TODO(@Wine93): We do not support transactions for the
     // below 3 methods, maybe we should return Status::NotSupported
     // when user invoke it in transaction.
@@ -195,7 +235,8 @@ class RocksDBStorage : public KVStorage, public StorageTransaction {
     // open a clean database or recovery from a checkpoint
     bool cleanOpen_ = true;
 
-    // only for transaction
+    // only for transaction, `txn_` is nullptr if the transaction
+    // is nested in a write batch
     bool InTransaction_;
     Transaction* txn_ = nullptr;
 
@@ -274,33 +315,45 @@ inline Status RocksDBStorage::SClear(const std::string& name) {
 
 class RocksDBStorageIterator : public Iterator {
  public:
+    // `batch` is not nullptr if iterating with pending writes of a batch
     RocksDBStorageIterator(RocksDBStorage* storage,
                            std::string prefix,
                            size_t size,
                            int status,
-                           bool ordered)
+                           ColumnFamilyHandle* handle,
+                           WriteBatchWithIndex* batch = nullptr)
         : storage_(storage),
           prefix_(std::move(prefix)),
           size_(size),
           status_(status),
           prefixChecking_(true),
-          ordered_(ordered),
+          handle_(handle),
+          batch_(batch),
           iter_(nullptr) {
         RocksDBPerfGuard guard(OP_GET_SNAPSHOT);
         if (status_ == 0) {
             readOptions_ = storage_->dbReadOptions_;
-            if (storage_->InTransaction_) {
+            if (storage_->txn_ != nullptr) {
                 readOptions_.snapshot = storage_->txn_->GetSnapshot();
             } else {
                 readOptions_.snapshot = storage_->db_->GetSnapshot();
             }
+
+            // stop at the end of prefix, and let rocksdb use prefix bloom
+            // filter if the prefix is compatible with the prefix extractor
+            upperBound_ = PrefixSuccessor(prefix_);
+            if (!upperBound_.empty()) {
+                upperBoundSlice_ = rocksdb::Slice(upperBound_);
+                readOptions_.iterate_upper_bound = &upperBoundSlice_;
+            }
+            readOptions_.auto_prefix_mode = true;
         }
     }
 
     ~RocksDBStorageIterator() {
         RocksDBPerfGuard guard(OP_CLEAR_SNAPSHOT);
         if (status_ == 0) {
-            if (storage_->InTransaction_) {
+            if (storage_->txn_ != nullptr) {
                 storage_->txn_->ClearSnapshot();
             } else {
                 storage_->db_->ReleaseSnapshot(readOptions_.snapshot);
@@ -324,13 +377,16 @@ class RocksDBStorageIterator : public Iterator {
     }
 
     void SeekToFirst() {
-        auto handler = storage_->GetColumnFamilyHandle(ordered_);
         {
             RocksDBPerfGuard guard(OP_GET_ITERATOR);
-            if (storage_->InTransaction_) {
-                iter_.reset(storage_->txn_->GetIterator(readOptions_, handler));
+            if (storage_->txn_ != nullptr) {
+                iter_.reset(storage_->txn_->GetIterator(readOptions_, handle_));
+            } else if (batch_ != nullptr) {
+                iter_.reset(batch_->NewIteratorWithBase(
+                    handle_, storage_->db_->NewIterator(readOptions_, handle_),
+                    &readOptions_));
             } else {
-                iter_.reset(storage_->db_->NewIterator(readOptions_, handler));
+                iter_.reset(storage_->db_->NewIterator(readOptions_, handle_));
             }
         }
 
@@ -371,6 +427,22 @@ class RocksDBStorageIterator : public Iterator {
 
     void DisablePrefixChecking() {
         prefixChecking_ = false;
+        readOptions_.iterate_upper_bound = nullptr;
+    }
+
+ private:
+    // the smallest key which is greater than all keys with the prefix,
+    // empty if there is no such key
+    static std::string PrefixSuccessor(std::string prefix) {
+        while (!prefix.empty()) {
+            auto& last = prefix.back();
+            if (static_cast<unsigned char>(last) != 0xff) {
+                last++;
+                return prefix;
+            }
+            prefix.pop_back();
+        }
+        return prefix;
     }
 
  private:
@@ -379,7 +451,10 @@ class RocksDBStorageIterator : public Iterator {
     uint64_t size_;
     int status_;
     bool prefixChecking_;
-    bool ordered_;
+    ColumnFamilyHandle* handle_;
+    WriteBatchWithIndex* batch_;
+    std::string upperBound_;
+    rocksdb::Slice upperBoundSlice_;
     std::unique_ptr<rocksdb::Iterator> iter_;
     rocksdb::ReadOptions readOptions_;
 };
@@ -23,6 +23,8 @@
 #ifndef CURVEFS_SRC_METASERVER_STORAGE_STORAGE_H_
 #define CURVEFS_SRC_METASERVER_STORAGE_STORAGE_H_
 
+#include <glog/logging.h>
+
 #include <string>
 #include <memory>
 #include <vector>
@@ -112,6 +114,48 @@ class KVStorage : public BaseStorage {
 
     // Recover storage from a given directory
     virtual bool Recover(const std::string& dir) = 0;
+
+    // Group following writes of current thread into one write batch, which
+    // is committed atomically by CommitWriteBatch(), nested calls are merged
+    // into the outermost one. Return false if the storage doesn't support it,
+    // and writes are applied in place as usual.
+    virtual bool BeginWriteBatch() { return false; }
+
+    virtual Status CommitWriteBatch() { return Status::OK(); }
+};
+
+// Commit all writes of current scope as one write batch
+class WriteBatchGuard {
+ public:
+    explicit WriteBatchGuard(const std::shared_ptr<KVStorage>& storage)
+        : storage_(storage),
+          began_(storage_ != nullptr && storage_->BeginWriteBatch()) {}
+
+    // Commit the batch explicitly, the caller must check the result
+    // before replying to the client; a nested guard always succeeds
+    // because its writes are committed by the outermost one
+    Status Commit() {
+        if (!began_) {
+            return Status::OK();
+        }
+        began_ = false;
+        Status s = storage_->CommitWriteBatch();
+        if (!s.ok()) {
+            LOG(ERROR) << "Commit write batch failed, status = "
+                       << s.ToString();
+        }
+        return s;
+    }
+
+    // Fallback for early returns which didn't call Commit()
+    ~WriteBatchGuard() { Commit(); }
+
+    WriteBatchGuard(const WriteBatchGuard&) = delete;
+    WriteBatchGuard& operator=(const WriteBatchGuard&) = delete;
+
+ private:
+    std::shared_ptr<KVStorage> storage_;
+    bool began_;
 };
 
 }  // namespace storage
@@ -28,15 +28,16 @@ namespace metaserver {
 
 using curve::common::ReadLockGuard;
 using curve::common::WriteLockGuard;
+using curve::common::LockGuard;
 
+// all dentrys of the transaction are handled with their parents locked
+// together, see DentryStorage::HandleTx()
 #define FOR_EACH_DENTRY(action) \
 do { \
-    for (const auto& dentry : dentrys_) { \
-        auto rc = storage_->HandleTx( \
-            DentryStorage::TX_OP_TYPE::action, dentry); \
-        if (rc != MetaStatusCode::OK) { \
-            return false; \
-        } \
+    auto rc = storage_->HandleTx( \
+        DentryStorage::TX_OP_TYPE::action, dentrys_); \
+    if (rc != MetaStatusCode::OK) { \
+        return false; \
     } \
 } while (0)
 
@@ -112,6 +113,9 @@ MetaStatusCode TxManager::HandleRenameTx(const std::vector<Dentry>& dentrys) {
         return rc;
     }
 
+    // check-and-replace of the pending TX must be atomic
+    LockGuard lg(txLock_);
+
     // Handle pending TX
     RenameTx pendingTx;
     if (FindPendingTx(&pendingTx)) {
@@ -45,6 +45,9 @@ inline bool IsAllocTypeBig(const AllocateHint& hint) {
 
 constexpr uint64_t kAlignment = 4096;
 
+// minimum number of bits of an allocation group, equals to bits of a word
+constexpr uint32_t kMinBitsPerGroup = 64;
+
 }  // namespace
 
 uint64_t BitmapAllocator::CalcBitmapAreaLength(
@@ -66,16 +69,39 @@ struct BitmapAllocator::AllocOrder {
     const std::vector<Func> funs;
 };
 
+struct BitmapAllocator::AllocGroup {
+    AllocGroup(uint32_t beginIdx,
+               uint32_t endIdx,
+               uint64_t sizePerBit,
+               uint64_t offset,
+               uint64_t length)
+        : beginIdx(beginIdx),
+          endIdx(endIdx),
+          allocIdx(beginIdx),
+          bitmapExtent(sizePerBit, offset, length) {}
+
+    bthread::Mutex mtx;
+
+    // bits in [beginIdx, endIdx) belong to this group
+    const uint32_t beginIdx;
+    const uint32_t endIdx;
+
+    // last bitmap allocate index
+    uint32_t allocIdx;
+
+    // unused extents of bitmap
+    FreeExtents bitmapExtent;
+};
+
 BitmapAllocator::BitmapAllocator(const BitmapAllocatorOption& opt)
     : opt_(opt),
       bitmapAreaLength_(CalcBitmapAreaLength(opt)),
       smallAreaLength_(opt_.length - bitmapAreaLength_),
       bitmapAreaOffset_(opt_.startOffset + smallAreaLength_),
-      mtx_(),
       available_(opt_.length),
-      bitmapAllocIdx_(0),
       bitmap_(bitmapAreaLength_ / opt_.sizePerBit),
-      bitmapExtent_(opt_.sizePerBit, bitmapAreaOffset_, bitmapAreaLength_),
+      bitsPerGroup_(0),
+      smallMtx_(),
       smallExtent_(opt_.startOffset, smallAreaLength_) {
     CHECK(bitmap_.Size() * opt_.sizePerBit + smallExtent_.AvailableSize() ==
           opt_.length)
@@ -84,11 +110,31 @@ BitmapAllocator::BitmapAllocator(const BitmapAllocatorOption& opt)
         << ", smallExtent.avail: " << smallExtent_.AvailableSize()
         << ", opt.length: " << opt.length;
 
+    // groups are aligned to word of bitmap, so that different groups never
+    // modify the same byte of bitmap and can be scanned by word
+    const uint32_t bits = bitmap_.Size();
+    uint32_t groups = std::max<uint32_t>(opt_.allocGroups, 1);
+    groups = std::max<uint32_t>(
+        std::min<uint32_t>(groups, bits / kMinBitsPerGroup), 1);
+    bitsPerGroup_ = std::max<uint32_t>(
+        align_up<uint32_t>((bits + groups - 1) / groups, kMinBitsPerGroup),
+        kMinBitsPerGroup);
+
+    uint32_t beginIdx = 0;
+    do {
+        uint32_t endIdx = std::min(beginIdx + bitsPerGroup_, bits);
+        groups_.emplace_back(new AllocGroup(
+            beginIdx, endIdx, opt_.sizePerBit, ToBitmapOffset(beginIdx),
+            static_cast<uint64_t>(endIdx - beginIdx) * opt_.sizePerBit));
+        beginIdx = endIdx;
+    } while (beginIdx < bits);
+
     VLOG(9) << "offset: " << opt_.startOffset << ", len: " << opt_.length
             << ", size_per_bit: " << opt_.sizePerBit << ", bitmapAreaLength_ "
             << bitmapAreaLength_ << ", bitmapAreaOffset_: " << bitmapAreaOffset_
             << ", smallAreaLength_: " << smallAreaLength_
-            << ", available: " << available_;
+            << ", available: " << available_
+            << ", alloc groups: " << groups_.size();
 }
 
 BitmapAllocator::~BitmapAllocator() {}
@@ -113,8 +159,7 @@ uint64_t BitmapAllocator::Alloc(uint64_t size,
         &BitmapAllocator::AllocFromBitmapExtent,
         &BitmapAllocator::AllocFromBitmap);
 
-    std::lock_guard<bthread::Mutex> lock(mtx_);
-    if (available_ == 0) {
+    if (available_.load(std::memory_order_relaxed) == 0) {
         return 0;
     }
 
@@ -128,8 +173,8 @@ uint64_t BitmapAllocator::Alloc(uint64_t size,
         alloc = AllocInternal(kAllocBig, size, hint, exts);
     }
 
-    CHECK(alloc <= available_) << *this;
-    available_ -= alloc;
+    auto prev = available_.fetch_sub(alloc, std::memory_order_relaxed);
+    CHECK(alloc <= prev) << *this;
 
     return alloc;
 }
@@ -142,9 +187,7 @@ bool BitmapAllocator::DeAlloc(const uint64_t off, const uint64_t len) {
 
     VLOG(9) << "Dealloc off: " << off << ", len: " << len;
 
-    std::lock_guard<bthread::Mutex> lock(mtx_);
-
-    if (len > opt_.length - available_) {
+    if (len > opt_.length - available_.load(std::memory_order_relaxed)) {
         return false;
     }
 
@@ -161,11 +204,14 @@ bool BitmapAllocator::DeAlloc(const uint64_t off, const uint64_t len) {
     }
 
     if (lenInBitmap != 0) {
-        DeAllocToBitmap(offInBitmap, lenInBitmap);
+        ForEachGroup(offInBitmap, lenInBitmap,
+                     [this](AllocGroup* group, uint64_t off, uint64_t len) {
+                         DeAllocToBitmap(group, off, len);
+                     });
     }
 
-    CHECK(available_ + len <= opt_.length) << *this;
-    available_ += len;
+    auto prev = available_.fetch_add(len, std::memory_order_relaxed);
+    CHECK(prev + len <= opt_.length) << *this;
 
     return true;
 }
@@ -207,16 +253,82 @@ uint64_t BitmapAllocator::AllocInternal(const AllocOrder& order,
     return size - need;
 }
 
+size_t BitmapAllocator::GroupIndex(uint64_t offset) const {
+    return std::min<size_t>(ToBitmapIndex(offset) / bitsPerGroup_,
+                            groups_.size() - 1);
+}
+
+size_t BitmapAllocator::HomeGroup(const AllocateHint& hint) const {
+    if (groups_.size() == 1) {
+        return 0;
+    }
+
+    const uint64_t end = opt_.startOffset + opt_.length;
+    if (hint.HasLeftHint() && hint.leftOffset >= bitmapAreaOffset_ &&
+        hint.leftOffset < end) {
+        return GroupIndex(hint.leftOffset);
+    }
+
+    if (hint.HasRightHint() && hint.rightOffset > bitmapAreaOffset_ &&
+        hint.rightOffset <= end) {
+        return GroupIndex(hint.rightOffset - 1);
+    }
+
+    // threads are spread over groups in turn
+    static std::atomic<uint32_t> nextThreadIdx(0);
+    static thread_local uint32_t threadIdx =
+        nextThreadIdx.fetch_add(1, std::memory_order_relaxed);
+    return threadIdx % groups_.size();
+}
+
+void BitmapAllocator::ForEachGroup(
+    const uint64_t off,
+    const uint64_t len,
+    const std::function<void(AllocGroup*, uint64_t, uint64_t)>& fn) {
+    uint64_t cur = off;
+    const uint64_t end = off + len;
+    while (cur < end) {
+        auto* group = groups_[GroupIndex(cur)].get();
+        const uint64_t groupEnd = ToBitmapOffset(group->endIdx);
+        const uint64_t curLen = std::min(end, groupEnd) - cur;
+
+        std::lock_guard<bthread::Mutex> lock(group->mtx);
+        fn(group, cur, curLen);
+        cur += curLen;
+    }
+}
+
 uint64_t BitmapAllocator::AllocFromBitmap(uint64_t size,
-                                          const AllocateHint& /*hint*/,
+                                          const AllocateHint& hint,
                                           std::vector<Extent>* exts) {
     uint64_t need = size;
+    const size_t home = HomeGroup(hint);
+    for (size_t i = 0; i < groups_.size() && need > 0; ++i) {
+        auto* group = groups_[(home + i) % groups_.size()].get();
+        std::lock_guard<bthread::Mutex> lock(group->mtx);
+        need -= AllocFromGroupBitmap(group, need, exts);
+    }
+
+    return size - need;
+}
+
+uint64_t BitmapAllocator::AllocFromGroupBitmap(AllocGroup* group,
+                                               uint64_t size,
+                                               std::vector<Extent>* exts) {
+    if (group->beginIdx == group->endIdx) {
+        return 0;
+    }
+
+    uint64_t need = size;
+    const uint32_t lastIdx = group->endIdx - 1;
 
     while (need > 0) {
-        auto idx = bitmap_.NextClearBit(bitmapAllocIdx_);
+        auto idx = group->allocIdx > lastIdx
+                       ? bitmap_.NO_POS
+                       : bitmap_.NextClearBit(group->allocIdx, lastIdx);
         if (idx == bitmap_.NO_POS) {
-            bitmapAllocIdx_ = 0;
-            idx = bitmap_.NextClearBit(bitmapAllocIdx_);
+            group->allocIdx = group->beginIdx;
+            idx = bitmap_.NextClearBit(group->allocIdx, lastIdx);
             if (idx == bitmap_.NO_POS) {
                 break;
             }
@@ -224,16 +336,16 @@ uint64_t BitmapAllocator::AllocFromBitmap(uint64_t size,
 
         // mark this slot used
         bitmap_.Set(idx);
-        bitmapAllocIdx_ = idx + 1;
+        group->allocIdx = idx + 1;
 
-        uint64_t off = idx * opt_.sizePerBit + bitmapAreaOffset_;
+        uint64_t off = ToBitmapOffset(idx);
 
         if (need >= opt_.sizePerBit) {
             exts->emplace_back(off, opt_.sizePerBit);
             need -= opt_.sizePerBit;
         } else {
             exts->emplace_back(off, need);
-            bitmapExtent_.DeAlloc(off + need, opt_.sizePerBit - need);
+            group->bitmapExtent.DeAlloc(off + need, opt_.sizePerBit - need);
             need = 0;
         }
     }
@@ -244,21 +356,33 @@ uint64_t BitmapAllocator::AllocFromBitmap(uint64_t size,
 uint64_t BitmapAllocator::AllocFromBitmapExtent(uint64_t size,
                                                 const AllocateHint& hint,
                                                 std::vector<Extent>* exts) {
-    return bitmapExtent_.Alloc(size, hint, exts);
+    uint64_t need = size;
+    const size_t home = HomeGroup(hint);
+    for (size_t i = 0; i < groups_.size() && need > 0; ++i) {
+        auto* group = groups_[(home + i) % groups_.size()].get();
+        std::lock_guard<bthread::Mutex> lock(group->mtx);
+        need -= group->bitmapExtent.Alloc(need, hint, exts);
+    }
+
+    return size - need;
 }
 
 uint64_t BitmapAllocator::AllocFromSmallExtent(uint64_t size,
                                                const AllocateHint& hint,
                                                std::vector<Extent>* exts) {
+    std::lock_guard<bthread::Mutex> lock(smallMtx_);
     return smallExtent_.Alloc(size, hint, exts);
 }
 
 void BitmapAllocator::DeAllocToSmallExtent(const uint64_t off,
                                            const uint64_t len) {
+    std::lock_guard<bthread::Mutex> lock(smallMtx_);
     smallExtent_.DeAlloc(off, len);
 }
 
-void BitmapAllocator::DeAllocToBitmap(const uint64_t off, const uint64_t len) {
+void BitmapAllocator::DeAllocToBitmap(AllocGroup* group,
+                                      const uint64_t off,
+                                      const uint64_t len) {
     uint64_t alignedLeftOff = align_up<uint64_t>(off, opt_.sizePerBit);
     uint64_t unalignedLeftLen = alignedLeftOff - off;
 
@@ -276,21 +400,22 @@ void BitmapAllocator::DeAllocToBitmap(const uint64_t off, const uint64_t len) {
         }
 
         if (unalignedLeftLen != 0) {
-            DeAllocToBitmapExtent(off, unalignedLeftLen);
+            DeAllocToBitmapExtent(group, off, unalignedLeftLen);
         }
         if (unalignedRightLen != 0) {
-            DeAllocToBitmapExtent(alignedRightOff, unalignedRightLen);
+            DeAllocToBitmapExtent(group, alignedRightOff, unalignedRightLen);
         }
     } else {
-        DeAllocToBitmapExtent(off, len);
+        DeAllocToBitmapExtent(group, off, len);
     }
 }
 
-void BitmapAllocator::DeAllocToBitmapExtent(const uint64_t off,
+void BitmapAllocator::DeAllocToBitmapExtent(AllocGroup* group,
+                                            const uint64_t off,
                                             const uint64_t len) {
     std::map<uint64_t, uint64_t> blocks;
-    bitmapExtent_.DeAlloc(off, len);
-    auto size = bitmapExtent_.AvailableBlocks(&blocks);
+    group->bitmapExtent.DeAlloc(off, len);
+    auto size = group->bitmapExtent.AvailableBlocks(&blocks);
     (void)size;
 
     for (const auto& e : blocks) {
@@ -305,8 +430,6 @@ void BitmapAllocator::MarkUsedInternal(const uint64_t off, const uint64_t len) {
     assert(off >= opt_.startOffset &&
            off + len <= opt_.startOffset + opt_.length);
 
-    std::lock_guard<bthread::Mutex> lock(mtx_);
-
     uint64_t offInSmallExtent = 0;
     uint64_t lenInSmallExtent = 0;
     uint64_t offInBitmap = 0;
@@ -320,15 +443,19 @@ void BitmapAllocator::MarkUsedInternal(const uint64_t off, const uint64_t len) {
     }
 
     if (lenInBitmap != 0) {
-        MarkUsedForBitmap(offInBitmap, lenInBitmap);
+        ForEachGroup(offInBitmap, lenInBitmap,
+                     [this](AllocGroup* group, uint64_t off, uint64_t len) {
+                         MarkUsedForBitmap(group, off, len);
+                     });
     }
 
-    CHECK(available_ >= len) << *this;
-    available_ -= len;
+    auto prev = available_.fetch_sub(len, std::memory_order_relaxed);
+    CHECK(prev >= len) << *this;
 }
 
 void BitmapAllocator::MarkUsedForSmallExtent(const uint64_t off,
                                              const uint64_t len) {
+    std::lock_guard<bthread::Mutex> lock(smallMtx_);
     smallExtent_.MarkUsed(off, len);
 }
 
@@ -340,7 +467,8 @@ uint64_t BitmapAllocator::ToBitmapOffset(uint32_t index) const {
     return index * opt_.sizePerBit + bitmapAreaOffset_;
 }
 
-void BitmapAllocator::MarkUsedForBitmap(const uint64_t off,
+void BitmapAllocator::MarkUsedForBitmap(AllocGroup* group,
+                                        const uint64_t off,
                                         const uint64_t len) {
     // if it's a aligned block, mark slot used
     // otherwise call bitmapExtent::MarkUsed
@@ -364,37 +492,38 @@ void BitmapAllocator::MarkUsedForBitmap(const uint64_t off,
         if (unalignedLeftLen != 0) {
             auto idx = ToBitmapIndex(off);
             if (bitmap_.Test(idx)) {
-                bitmapExtent_.MarkUsed(off, unalignedLeftLen);
+                group->bitmapExtent.MarkUsed(off, unalignedLeftLen);
             } else {
                 bitmap_.Set(idx);
-                bitmapExtent_.DeAlloc(ToBitmapOffset(idx),
+                group->bitmapExtent.DeAlloc(ToBitmapOffset(idx),
                                       opt_.sizePerBit - unalignedLeftLen);
             }
         }
         if (unalignedRightLen != 0) {
             auto idx = ToBitmapIndex(off + len);
             if (bitmap_.Test(idx)) {
-                bitmapExtent_.MarkUsed(alignedRightOff, unalignedRightLen);
+                group->bitmapExtent.MarkUsed(alignedRightOff,
+                                             unalignedRightLen);
             } else {
                 bitmap_.Set(idx);
-                bitmapExtent_.DeAlloc(off + len,
+                group->bitmapExtent.DeAlloc(off + len,
                                       opt_.sizePerBit - unalignedRightLen);
             }
         }
     } else {
         auto idx = ToBitmapIndex(off);
         if (bitmap_.Test(idx)) {
-            bitmapExtent_.MarkUsed(off, len);
+            group->bitmapExtent.MarkUsed(off, len);
         } else {
             bitmap_.Set(idx);
             const auto startOff = ToBitmapOffset(idx);
 
             if (off != startOff) {
-                bitmapExtent_.DeAlloc(startOff, off - startOff);
+                group->bitmapExtent.DeAlloc(startOff, off - startOff);
             }
 
             if ((off + len) != ToBitmapOffset(idx + 1)) {
-                bitmapExtent_.DeAlloc(off + len,
+                group->bitmapExtent.DeAlloc(off + len,
                                     ToBitmapOffset(idx + 1) - (off + len));
             }
         }
@@ -429,9 +558,11 @@ void BitmapAllocator::Split(const uint64_t off,
 }
 
 std::ostream& operator<<(std::ostream& os, const BitmapAllocator& alloc) {
-    os << "avail: " << alloc.available_
-       << ", [== bitmap ext: " << alloc.bitmapExtent_ << "  ==]"
-       << ", [== small ext: " << alloc.smallExtent_ << " ==]";
+    os << "avail: " << alloc.available_.load(std::memory_order_relaxed);
+    for (const auto& group : alloc.groups_) {
+        os << ", [== bitmap ext: " << group->bitmapExtent << "  ==]";
+    }
+    os << ", [== small ext: " << alloc.smallExtent_ << " ==]";
 
     return os;
 }
@@ -25,7 +25,10 @@
 
 #include <bthread/mutex.h>
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "curvefs/src/volume/allocator.h"
@@ -55,8 +58,7 @@ class BitmapAllocator : public Allocator {
     uint64_t Total() const override { return opt_.length; }
 
     uint64_t AvailableSize() const override {
-        std::lock_guard<bthread::Mutex> lock(mtx_);
-        return available_;
+        return available_.load(std::memory_order_relaxed);
     }
 
     bool MarkUsed(const std::vector<Extent>& extents) override;
@@ -71,6 +73,8 @@ class BitmapAllocator : public Allocator {
  private:
     struct AllocOrder;
 
+    struct AllocGroup;
+
     /**
      * @brief call real allocate functions that stored in AllocOrder one by one,
      * untilsatisfy size or all functions has been called
@@ -90,16 +94,25 @@ class BitmapAllocator : public Allocator {
     uint64_t AllocFromSmallExtent(const uint64_t size,
                                   const AllocateHint& hint,
                                   std::vector<Extent>* exts);
+    uint64_t AllocFromGroupBitmap(AllocGroup* group,
+                                  const uint64_t size,
+                                  std::vector<Extent>* exts);
 
     // deallocate staffs
     void DeAllocToSmallExtent(const uint64_t off, const uint64_t len);
-    void DeAllocToBitmap(const uint64_t off, const uint64_t len);
-    void DeAllocToBitmapExtent(const uint64_t off, const uint64_t len);
+    void DeAllocToBitmap(AllocGroup* group,
+                         const uint64_t off,
+                         const uint64_t len);
+    void DeAllocToBitmapExtent(AllocGroup* group,
+                               const uint64_t off,
+                               const uint64_t len);
 
     // mark space[off,len] is used
     void MarkUsedInternal(const uint64_t off, const uint64_t len);
     void MarkUsedForSmallExtent(const uint64_t off, const uint64_t len);
-    void MarkUsedForBitmap(const uint64_t off, const uint64_t len);
+    void MarkUsedForBitmap(AllocGroup* group,
+                           const uint64_t off,
+                           const uint64_t len);
 
     // split off and len by bitmapAreaOffset
     void Split(const uint64_t off,
@@ -109,6 +122,19 @@ class BitmapAllocator : public Allocator {
                uint64_t* offInBitmap,
                uint64_t* lenInBitmap) const;
 
+    // split space[off,len] of bitmap area by allocation groups, and call
+    // |fn| with each part under lock of its group
+    void ForEachGroup(
+        const uint64_t off,
+        const uint64_t len,
+        const std::function<void(AllocGroup*, uint64_t, uint64_t)>& fn);
+
+    size_t GroupIndex(uint64_t offset) const;
+
+    // the group tried first, which is the group of the hint if any,
+    // otherwise the group of the calling thread
+    size_t HomeGroup(const AllocateHint& hint) const;
+
     uint32_t ToBitmapIndex(uint64_t offset) const;
 
     uint64_t ToBitmapOffset(uint32_t index) const;
@@ -119,20 +145,19 @@ class BitmapAllocator : public Allocator {
     const uint64_t smallAreaLength_;
     const uint64_t bitmapAreaOffset_;
 
-    // protect below fields
-    mutable bthread::Mutex mtx_;
-
     // current available size
-    uint64_t available_;
-
-    // last bitmap allocate index
-    uint64_t bitmapAllocIdx_;
+    std::atomic<uint64_t> available_;
 
     // space bitmap, 1 means used
     curve::common::Bitmap bitmap_;
 
-    // unused extents of bitmap
-    FreeExtents bitmapExtent_;
+    // bitmap is divided into allocation groups, each one has its own lock,
+    // so concurrent allocations from different threads don't contend
+    uint32_t bitsPerGroup_;
+    std::vector<std::unique_ptr<AllocGroup>> groups_;
+
+    // protect |smallExtent_|
+    mutable bthread::Mutex smallMtx_;
 
     // for small size allocate
     FreeExtents smallExtent_;
@@ -36,6 +36,8 @@ struct BitmapAllocatorOption {
     uint64_t length;
     uint64_t sizePerBit;
     double smallAllocProportion;
+    // number of allocation groups which the bitmap is divided into
+    uint32_t allocGroups = 1;
 };
 
 struct BlockGroupManagerOption {
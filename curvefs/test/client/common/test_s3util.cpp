@@ -75,5 +75,21 @@ TEST(ValidNameOfInodeTest1, test) {
                                           "1/16/16777/1_1_1_16777216", 1));
 }
 
+TEST(ValidNameOfFsTest, test) {
+    using curvefs::common::s3util::ValidNameOfFs;
+    ASSERT_TRUE(ValidNameOfFs(1, "1_16777216_2_0_0", 0));
+    ASSERT_FALSE(ValidNameOfFs(2, "1_16777216_2_0_0", 0));
+    ASSERT_FALSE(ValidNameOfFs(1, "1_16777216_2_0", 0));
+    ASSERT_FALSE(ValidNameOfFs(1, "1_16777216_2_0_x", 0));
+    ASSERT_FALSE(ValidNameOfFs(1, "01_16777216_2_0_0", 0));
+
+    ASSERT_TRUE(ValidNameOfFs(1, "1/16/16777/1_16777216_2_0_0", 1));
+    ASSERT_FALSE(ValidNameOfFs(1, "1/16/16777/1_16777216_2_0_0", 0));
+    ASSERT_FALSE(ValidNameOfFs(1, "1/16/16777/../1_16777216_2_0_0", 1));
+    ASSERT_FALSE(ValidNameOfFs(1, "2/16/16777/1_16777216_2_0_0", 1));
+    ASSERT_TRUE(ValidNameOfFs(1, "1/0/16777/1_16777216_2_0_0", 2));
+    ASSERT_FALSE(ValidNameOfFs(1, "../../1_16777216_2_0_0", 2));
+}
+
 }  // namespace common
 }  // namespace curvefs
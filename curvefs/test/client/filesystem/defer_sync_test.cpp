@@ -20,6 +20,8 @@
  * Author: Jingli Chen (Wine93)
  */
 
+#include <vector>
+
 #include "curvefs/src/client/filesystem/defer_sync.h"
 #include "curvefs/test/client/filesystem/helper/helper.h"
 
@@ -27,6 +29,9 @@ namespace curvefs {
 namespace client {
 namespace filesystem {
 
+using ::curvefs::client::rpcclient::InodeUpdate;
+using ::curvefs::metaserver::MetaStatusCode;
+
 class DeferSyncTest : public ::testing::Test {
  protected:
     void SetUp() override {
@@ -68,6 +73,52 @@ TEST_F(DeferSyncTest, Dirty) {
     deferSync->Stop();
 }
 
+TEST_F(DeferSyncTest, Coalesce) {
+    auto builder = DeferSyncBuilder();
+    auto deferSync = builder.SetOption([&](DeferSyncOption* option){
+        option->delay = 3;
+    }).Build();
+    deferSync->Start();
+
+    // inode pushed many times is flushed only once
+    auto inode = MkInode(100, InodeOption().metaClient(metaClient_));
+    EXPECT_CALL_INDOE_SYNC_TIMES(*metaClient_, 100 /* ino */, 1 /* times */);
+    inode->SetLength(100);
+    deferSync->Push(inode);
+    deferSync->Push(inode);
+    deferSync->Push(inode);
+    deferSync->Stop();
+}
+
+TEST_F(DeferSyncTest, Batch) {
+    auto builder = DeferSyncBuilder();
+    auto deferSync = builder.SetOption([&](DeferSyncOption* option){
+        option->delay = 3;
+        option->batchSize = 64;
+    }).Build();
+    deferSync->SetMetaClient(metaClient_);
+    deferSync->Start();
+
+    auto inode1 = MkInode(100, InodeOption().metaClient(metaClient_));
+    auto inode2 = MkInode(200, InodeOption().metaClient(metaClient_));
+    inode1->SetLength(100);
+    inode2->SetLength(200);
+
+    EXPECT_CALL_INDOE_SYNC_TIMES(*metaClient_, _, 0 /* times */);
+    EXPECT_CALL(*metaClient_, BatchUpdateInodeWithOutNlinkAsync_rvr(_, _, 64))
+        .WillOnce(Invoke([&](uint32_t fsId, std::vector<InodeUpdate>& updates,
+                             uint32_t batchSize) {
+            ASSERT_EQ(2, updates.size());
+            for (auto& update : updates) {
+                update.done->SetMetaStatusCode(MetaStatusCode::OK);
+                update.done->Run();
+            }
+        }));
+    deferSync->Push(inode1);
+    deferSync->Push(inode2);
+    deferSync->Stop();
+}
+
 }  // namespace filesystem
 }  // namespace client
 }  // namespace curvefs
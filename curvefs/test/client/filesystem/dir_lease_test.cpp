@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: Curve
+ * Created Date: 2023-05-04
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "curvefs/src/client/filesystem/dir_lease.h"
+#include "src/common/timeutility.h"
+
+namespace curvefs {
+namespace client {
+namespace filesystem {
+
+using ::curve::common::TimeUtility;
+
+class DirLeasesTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        DirLeaseOption option;
+        option.enable = true;
+        option.lruSize = 10;
+        leases_ = std::make_shared<DirLeases>(option);
+    }
+
+    void Put(Ino parent, const std::string& name, Ino ino,
+             uint32_t leaseMs = 10000) {
+        leases_->Put(parent, name, ino, leaseMs,
+                     TimeUtility::GetTimeofDayMs(), leases_->Epoch());
+    }
+
+ protected:
+    std::shared_ptr<DirLeases> leases_;
+};
+
+TEST_F(DirLeasesTest, Disabled) {
+    auto leases = std::make_shared<DirLeases>(DirLeaseOption{});
+    ASSERT_FALSE(leases->Enabled());
+    leases->Put(1, "f1", 100, 10000, TimeUtility::GetTimeofDayMs(),
+                leases->Epoch());
+    Ino ino;
+    ASSERT_FALSE(leases->Get(1, "f1", &ino));
+}
+
+TEST_F(DirLeasesTest, Basic) {
+    Ino ino = 0;
+    ASSERT_FALSE(leases_->Get(1, "f1", &ino));
+
+    // CASE 1: positive entry
+    Put(1, "f1", 100);
+    ASSERT_TRUE(leases_->Get(1, "f1", &ino));
+    ASSERT_EQ(100, ino);
+
+    // CASE 2: negative entry
+    Put(1, "f2", 0);
+    ASSERT_TRUE(leases_->Get(1, "f2", &ino));
+    ASSERT_EQ(0, ino);
+
+    // CASE 3: no lease granted
+    Put(1, "f3", 300, 0);
+    ASSERT_FALSE(leases_->Get(1, "f3", &ino));
+}
+
+TEST_F(DirLeasesTest, Expired) {
+    Put(1, "f1", 100, 100);
+    Ino ino;
+    ASSERT_TRUE(leases_->Get(1, "f1", &ino));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_FALSE(leases_->Get(1, "f1", &ino));
+}
+
+TEST_F(DirLeasesTest, ChangedWhileLookup) {
+    uint64_t epoch = leases_->Epoch();
+    uint64_t startMs = TimeUtility::GetTimeofDayMs();
+    leases_->Invalidate(1);
+    leases_->Put(1, "f1", 100, 10000, startMs, epoch);
+
+    Ino ino;
+    ASSERT_FALSE(leases_->Get(1, "f1", &ino));
+}
+
+TEST_F(DirLeasesTest, Invalidate) {
+    Put(1, "f1", 100);
+    Put(1, "f2", 200);
+    Put(2, "f1", 300);
+
+    // CASE 1: invalidate one entry
+    Ino ino;
+    leases_->Invalidate(1, "f1");
+    ASSERT_FALSE(leases_->Get(1, "f1", &ino));
+    ASSERT_TRUE(leases_->Get(1, "f2", &ino));
+
+    // CASE 2: invalidate the directory
+    leases_->Invalidate(1);
+    ASSERT_FALSE(leases_->Get(1, "f2", &ino));
+    ASSERT_TRUE(leases_->Get(2, "f1", &ino));
+
+    // CASE 3: entries cached under the old lease are invalid
+    Put(1, "f3", 400);
+    ASSERT_TRUE(leases_->Get(1, "f3", &ino));
+    ASSERT_FALSE(leases_->Get(1, "f2", &ino));
+
+    // CASE 4: invalidate all
+    leases_->InvalidateAll();
+    ASSERT_FALSE(leases_->Get(1, "f3", &ino));
+    ASSERT_FALSE(leases_->Get(2, "f1", &ino));
+    Put(2, "f1", 300);
+    ASSERT_TRUE(leases_->Get(2, "f1", &ino));
+    ASSERT_EQ(300, ino);
+}
+
+}  // namespace filesystem
+}  // namespace client
+}  // namespace curvefs
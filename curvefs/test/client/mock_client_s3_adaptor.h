@@ -67,6 +67,9 @@ class MockS3ClientAdaptor : public S3ClientAdaptor {
                  void(InterfaceMetric *interface, int count, uint64_t start));
     MOCK_METHOD0(GetDiskCacheManager, std::shared_ptr<DiskCacheManagerImpl>());
     MOCK_METHOD0(GetS3Client, std::shared_ptr<S3Client>());
+    MOCK_METHOD1(SetCachePeerClient,
+                 void(std::shared_ptr<CachePeerClient> cachePeerClient));
+    MOCK_METHOD0(GetCachePeerClient, std::shared_ptr<CachePeerClient>());
     MOCK_METHOD0(GetBlockSize, uint64_t());
     MOCK_METHOD0(GetChunkSize, uint64_t());
     MOCK_METHOD0(GetObjectPrefix, uint32_t());
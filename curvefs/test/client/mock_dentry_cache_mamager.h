@@ -40,6 +40,10 @@ class MockDentryCacheManager : public DentryCacheManager {
     MOCK_METHOD3(GetDentry, CURVEFS_ERROR(uint64_t parent,
         const std::string &name, Dentry *out));
 
+    MOCK_METHOD5(GetDentryWithLease, CURVEFS_ERROR(uint64_t parent,
+        const std::string &name, const std::string &holder,
+        Dentry *out, uint32_t *leaseMs));
+
     MOCK_METHOD1(CreateDentry, CURVEFS_ERROR(const Dentry &dentry));
 
     MOCK_METHOD3(DeleteDentry, CURVEFS_ERROR(uint64_t parent,
@@ -51,6 +55,11 @@ class MockDentryCacheManager : public DentryCacheManager {
                                            uint32_t limit,
                                            bool onlyDir,
                                            uint32_t nlink));
+
+    MOCK_METHOD4(ListDentryPlus, CURVEFS_ERROR(uint64_t parent,
+                                               std::list<DentryPlus> *entries,
+                                               uint32_t limit,
+                                               bool streaming));
 };
 
 
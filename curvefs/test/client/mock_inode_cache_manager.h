@@ -29,6 +29,7 @@
 #include <set>
 #include <list>
 #include <map>
+#include <string>
 
 #include "curvefs/src/client/inode_cache_manager.h"
 
@@ -40,9 +41,10 @@ class MockInodeCacheManager : public InodeCacheManager {
     MockInodeCacheManager() {}
     ~MockInodeCacheManager() {}
 
-    MOCK_METHOD3(Init, CURVEFS_ERROR(RefreshDataOption option,
+    MOCK_METHOD4(Init, CURVEFS_ERROR(RefreshDataOption option,
                                      std::shared_ptr<OpenFiles> openFiles,
-                                     std::shared_ptr<DeferSync> deferSync));
+                                     std::shared_ptr<DeferSync> deferSync,
+                                     LocalCreateOption localCreateOption));
 
     MOCK_METHOD2(GetInode,
                  CURVEFS_ERROR(uint64_t inodeId,
@@ -67,10 +69,18 @@ class MockInodeCacheManager : public InodeCacheManager {
     MOCK_METHOD2(CreateManageInode, CURVEFS_ERROR(const InodeParam &param,
         std::shared_ptr<InodeWrapper> &out));     // NOLINT
 
+    MOCK_METHOD3(CreateNode, CURVEFS_ERROR(const InodeParam &param,
+        const Dentry &dentry, std::shared_ptr<InodeWrapper> &out));     // NOLINT
+
     MOCK_METHOD1(DeleteInode, CURVEFS_ERROR(uint64_t inodeid));
 
     MOCK_METHOD1(ShipToFlush, void(
         const std::shared_ptr<InodeWrapper> &inodeWrapper));
+
+    MOCK_METHOD3(GetPendingDentry, bool(uint64_t parentId,
+        const std::string &name, Dentry *dentry));
+
+    MOCK_METHOD1(FlushPendingCreates, CURVEFS_ERROR(uint64_t parentId));
 };
 
 }  // namespace client
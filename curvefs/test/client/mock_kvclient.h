@@ -24,7 +24,9 @@
 #define CURVEFS_TEST_CLIENT_MOCK_KVCLIENT_H_
 
 #include <gmock/gmock.h>
+#include <memory>
 #include <string>
+#include <vector>
 #include "curvefs/src/client/kvclient/kvclient.h"
 
 namespace curvefs {
@@ -38,6 +40,9 @@ class MockKVClient : public KVClient {
                            std::string *));
     MOCK_METHOD5(Get, bool(const std::string &, char *, uint64_t, uint64_t,
                            std::string *));
+    MOCK_METHOD2(MultiGet,
+                 bool(const std::vector<std::string> &,
+                      std::vector<std::shared_ptr<std::string>> *));
 };
 
 }  // namespace client
@@ -58,10 +58,20 @@ class MockMetaServerClient : public MetaServerClient {
     MOCK_METHOD4(GetDentry, MetaStatusCode(uint32_t fsId, uint64_t inodeid,
                   const std::string &name, Dentry *out));
 
+    MOCK_METHOD6(GetDentryWithLease,
+                 MetaStatusCode(uint32_t fsId, uint64_t inodeid,
+                                const std::string &name,
+                                const std::string &holder, Dentry *out,
+                                uint32_t *leaseMs));
+
     MOCK_METHOD6(ListDentry, MetaStatusCode(uint32_t fsId, uint64_t inodeid,
             const std::string &last, uint32_t count, bool onlyDir,
             std::list<Dentry> *dentryList));
 
+    MOCK_METHOD6(ListDentryPlus, MetaStatusCode(uint32_t fsId,
+            uint64_t inodeid, const std::string &last, uint32_t count,
+            bool streaming, std::list<DentryPlus> *entries));
+
     MOCK_METHOD1(CreateDentry, MetaStatusCode(const Dentry &dentry));
 
     MOCK_METHOD4(DeleteDentry, MetaStatusCode(
@@ -119,6 +129,15 @@ class MockMetaServerClient : public MetaServerClient {
                       MetaServerClientDone* done,
                       DataIndices));
 
+    void BatchUpdateInodeWithOutNlinkAsync(uint32_t fsId,
+                                           std::vector<InodeUpdate>&& updates,
+                                           uint32_t batchSize) override {
+        return BatchUpdateInodeWithOutNlinkAsync_rvr(fsId, updates, batchSize);
+    }
+
+    MOCK_METHOD3(BatchUpdateInodeWithOutNlinkAsync_rvr,
+                 void(uint32_t, std::vector<InodeUpdate>&, uint32_t));
+
     MOCK_METHOD2(UpdateXattrAsync, void(const Inode &inode,
         MetaServerClientDone *done));
 
@@ -143,6 +162,14 @@ class MockMetaServerClient : public MetaServerClient {
     MOCK_METHOD2(CreateManageInode, MetaStatusCode(
                  const InodeParam &param, Inode *out));
 
+    MOCK_METHOD4(AllocInodeId, MetaStatusCode(uint32_t fsId, uint64_t parentId,
+                                              uint32_t count,
+                                              InodeIdLease *lease));
+
+    MOCK_METHOD4(CreateNode, MetaStatusCode(
+                 const Dentry &dentry, const InodeParam *param,
+                 const struct timespec &now, Inode *out));
+
     MOCK_METHOD2(DeleteInode, MetaStatusCode(uint32_t fsId, uint64_t inodeid));
 
     MOCK_METHOD3(SplitRequestInodes, bool(uint32_t fsId,
@@ -0,0 +1,234 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-28
+ */
+
+#include <brpc/channel.h>
+#include <brpc/server.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "curvefs/src/client/s3/cache_peer_client.h"
+#include "curvefs/src/client/s3/cache_peer_service.h"
+#include "curvefs/test/client/mock_client_s3.h"
+#include "src/common/timeutility.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::common::TimeUtility;
+using ::testing::AtLeast;
+using ::testing::Invoke;
+using ::testing::Mock;
+
+namespace {
+
+const char* kServerAddr = "127.0.0.1:5660";
+const char* kSelfAddr = "127.0.0.1:5661";
+const uint64_t kObjectLength = 4096;
+const uint64_t kBlockSize = 4 * kObjectLength;
+const uint64_t kFsId = 1;
+
+void FakeDownload(std::shared_ptr<GetObjectAsyncContext> context) {
+    for (uint64_t i = 0; i < context->len; i++) {
+        context->buf[i] = context->key[(context->offset + i) %
+                                       context->key.size()];
+    }
+    context->actualLen = context->len;
+    context->retCode = 0;
+    context->cb(nullptr, context);
+}
+
+}  // namespace
+
+class CachePeerTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        s3Client_ = std::make_shared<MockS3Client>();
+        option_.enable = true;
+        option_.rpcTimeoutMs = 1000;
+        option_.authKey = "123456";
+        service_ = absl::make_unique<CachePeerServiceImpl>(
+            s3Client_, nullptr, option_, kFsId, kBlockSize, 0);
+        ASSERT_EQ(0, server_.AddService(service_.get(),
+                                        brpc::SERVER_DOESNT_OWN_SERVICE));
+        ASSERT_EQ(0, server_.Start(kServerAddr, nullptr));
+
+        client_ = NewClient(option_);
+        ASSERT_TRUE(client_->Init());
+    }
+
+    std::shared_ptr<CachePeerClient> NewClient(const CachePeerOption& opt) {
+        return std::make_shared<CachePeerClient>(
+            opt, kSelfAddr, [](std::vector<std::string>* peers) {
+                peers->push_back(kServerAddr);
+                peers->push_back(kSelfAddr);
+                return true;
+            });
+    }
+
+    // objects not owned by the client itself are fetched from the server
+    std::vector<std::string> ObjectNames(uint64_t fsId) {
+        std::vector<std::string> names;
+        for (int i = 0; i < 20; i++) {
+            names.push_back(std::to_string(fsId) + "_16777216_" +
+                            std::to_string(i) + "_0_0");
+        }
+        return names;
+    }
+
+    void TearDown() override {
+        client_->Stop();
+        server_.Stop(0);
+        server_.Join();
+    }
+
+ protected:
+    std::shared_ptr<MockS3Client> s3Client_;
+    std::unique_ptr<CachePeerServiceImpl> service_;
+    brpc::Server server_;
+    CachePeerOption option_;
+    std::shared_ptr<CachePeerClient> client_;
+};
+
+TEST_F(CachePeerTest, FetchFromOwner) {
+    // objects owned by the server are loaded from s3 once, the others
+    // are owned by this client itself
+    EXPECT_CALL(*s3Client_, DownloadAsync(_))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Invoke(FakeDownload));
+    int owned = 0;
+    std::vector<std::string> ownedNames;
+    char buf[kObjectLength];
+    for (int i = 0; i < 20; i++) {
+        std::string name = "1_16777216_" + std::to_string(i) + "_0_0";
+        if (!client_->Fetch(name, kObjectLength, buf, 0, 1)) {
+            continue;
+        }
+        owned++;
+        ownedNames.push_back(name);
+    }
+    ASSERT_GT(owned, 0);
+    ASSERT_LT(owned, 20);
+    Mock::VerifyAndClearExpectations(s3Client_.get());
+
+    EXPECT_CALL(*s3Client_, DownloadAsync(_)).Times(0);
+    for (const auto& name : ownedNames) {
+        for (int j = 0; j < 3; j++) {
+            uint64_t offset = 100 * j;
+            ASSERT_TRUE(client_->Fetch(name, kObjectLength, buf, offset, 200));
+            for (uint64_t k = 0; k < 200; k++) {
+                ASSERT_EQ(name[(offset + k) % name.size()], buf[k]);
+            }
+        }
+    }
+}
+
+TEST_F(CachePeerTest, InvalidRequest) {
+    EXPECT_CALL(*s3Client_, DownloadAsync(_)).Times(0);
+    char buf[kObjectLength];
+    for (int i = 0; i < 20; i++) {
+        std::string name = "1_16777216_" + std::to_string(i) + "_0_0";
+        ASSERT_FALSE(client_->Fetch(name, kObjectLength, buf,
+                                    kObjectLength - 1, 2));
+    }
+}
+
+TEST_F(CachePeerTest, LoadFailed) {
+    EXPECT_CALL(*s3Client_, DownloadAsync(_))
+        .Times(AtLeast(1))
+        .WillRepeatedly(
+            Invoke([](std::shared_ptr<GetObjectAsyncContext> context) {
+                context->retCode = -1;
+                context->cb(nullptr, context);
+            }));
+    char buf[kObjectLength];
+    for (int i = 0; i < 20; i++) {
+        std::string name = "1_16777216_" + std::to_string(i) + "_0_0";
+        ASSERT_FALSE(client_->Fetch(name, kObjectLength, buf, 0, 1));
+    }
+}
+
+TEST_F(CachePeerTest, AuthFailed) {
+    EXPECT_CALL(*s3Client_, DownloadAsync(_)).Times(0);
+    CachePeerOption option = option_;
+    option.authKey = "654321";
+    auto client = NewClient(option);
+    ASSERT_TRUE(client->Init());
+    char buf[kObjectLength];
+    for (const auto& name : ObjectNames(kFsId)) {
+        ASSERT_FALSE(client->Fetch(name, kObjectLength, buf, 0, 1));
+    }
+    client->Stop();
+}
+
+TEST_F(CachePeerTest, TamperedRequest) {
+    EXPECT_CALL(*s3Client_, DownloadAsync(_)).Times(0);
+    brpc::Channel channel;
+    ASSERT_EQ(0, channel.Init(kServerAddr, nullptr));
+    CachePeerService_Stub stub(&channel);
+
+    GetBlockRequest origin;
+    origin.set_name(ObjectNames(kFsId)[0]);
+    origin.set_offset(0);
+    origin.set_length(1);
+    origin.set_objectlength(kObjectLength);
+    origin.set_date(TimeUtility::GetTimeofDayUs());
+    origin.set_signature(CachePeerServiceImpl::Sign(option_.authKey, origin));
+
+    // the signature doesn't match once any field is changed
+    for (int i = 0; i < 3; i++) {
+        GetBlockRequest request = origin;
+        if (i == 0) {
+            request.set_offset(1);
+        } else if (i == 1) {
+            request.set_length(kObjectLength);
+        } else {
+            request.set_objectlength(kObjectLength / 2);
+        }
+        brpc::Controller cntl;
+        GetBlockResponse response;
+        stub.GetBlock(&cntl, &request, &response, nullptr);
+        ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+        ASSERT_EQ(CACHE_PEER_AUTH_FAILED, response.statuscode());
+    }
+}
+
+TEST_F(CachePeerTest, RejectOtherObjects) {
+    EXPECT_CALL(*s3Client_, DownloadAsync(_)).Times(0);
+    char buf[kObjectLength];
+    // objects of other filesystems
+    for (const auto& name : ObjectNames(kFsId + 1)) {
+        ASSERT_FALSE(client_->Fetch(name, kObjectLength, buf, 0, 1));
+    }
+    ASSERT_FALSE(client_->Fetch("../../1_16777216_0_0_0", kObjectLength, buf,
+                                0, 1));
+    // objects larger than a block
+    for (const auto& name : ObjectNames(kFsId)) {
+        ASSERT_FALSE(client_->Fetch(name, kBlockSize + 1, buf, 0, 1));
+    }
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,141 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-26
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "curvefs/src/client/kvclient/consistent_hash_ring.h"
+
+namespace curvefs {
+namespace client {
+
+namespace {
+
+std::map<std::string, uint32_t> LookupAll(const ConsistentHashRing& ring,
+                                          int count) {
+    std::map<std::string, uint32_t> owners;
+    for (int i = 0; i < count; i++) {
+        std::string key = "1_16777216_" + std::to_string(i) + "_0_0";
+        uint32_t server = 0;
+        EXPECT_TRUE(ring.Lookup(key, &server));
+        owners[key] = server;
+    }
+    return owners;
+}
+
+}  // namespace
+
+TEST(ConsistentHashRingTest, EmptyRing) {
+    ConsistentHashRing ring(100, 3, 5000);
+    uint32_t server = 0;
+    ASSERT_FALSE(ring.Lookup("key", &server));
+}
+
+TEST(ConsistentHashRingTest, Balance) {
+    ConsistentHashRing ring(100, 3, 5000);
+    for (int i = 0; i < 4; i++) {
+        ring.AddServer("127.0.0.1:" + std::to_string(11211 + i));
+    }
+
+    std::map<uint32_t, int> counts;
+    for (const auto& owner : LookupAll(ring, 10000)) {
+        counts[owner.second]++;
+    }
+    ASSERT_EQ(4, counts.size());
+    for (const auto& count : counts) {
+        ASSERT_GT(count.second, 1500);
+        ASSERT_LT(count.second, 3500);
+    }
+}
+
+TEST(ConsistentHashRingTest, AddServerMovesFewKeys) {
+    ConsistentHashRing ring3(100, 3, 5000);
+    ConsistentHashRing ring4(100, 3, 5000);
+    for (int i = 0; i < 4; i++) {
+        std::string name = "127.0.0.1:" + std::to_string(11211 + i);
+        if (i < 3) {
+            ring3.AddServer(name);
+        }
+        ring4.AddServer(name);
+    }
+
+    auto before = LookupAll(ring3, 10000);
+    auto after = LookupAll(ring4, 10000);
+    int moved = 0;
+    for (const auto& owner : before) {
+        if (after[owner.first] != owner.second) {
+            // keys only move to the new server
+            ASSERT_EQ(3, after[owner.first]);
+            moved++;
+        }
+    }
+    ASSERT_GT(moved, 1000);
+    ASSERT_LT(moved, 4000);
+}
+
+TEST(ConsistentHashRingTest, EjectAndRetry) {
+    ConsistentHashRing ring(100, 2, 200);
+    ring.AddServer("127.0.0.1:11211");
+    ring.AddServer("127.0.0.1:11212");
+
+    auto owners = LookupAll(ring, 1000);
+    ring.OnFailure(0);
+    ASSERT_TRUE(ring.IsHealthy(0));
+    ring.OnFailure(0);
+    ASSERT_FALSE(ring.IsHealthy(0));
+
+    // keys of the ejected server fall to the other one
+    for (const auto& owner : owners) {
+        uint32_t server = 0;
+        ASSERT_TRUE(ring.Lookup(owner.first, &server));
+        ASSERT_EQ(1, server);
+    }
+
+    // no server is available
+    ring.OnFailure(1);
+    ring.OnFailure(1);
+    uint32_t server = 0;
+    ASSERT_FALSE(ring.Lookup("key", &server));
+
+    // retry after the interval, a success brings the server back
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_TRUE(ring.IsHealthy(0));
+    ring.OnSuccess(0);
+    ring.OnFailure(0);
+    ASSERT_TRUE(ring.IsHealthy(0));
+    ring.OnSuccess(1);
+    ASSERT_EQ(owners, LookupAll(ring, 1000));
+
+    // a failure in retry ejects the server again
+    ring.OnFailure(1);
+    ring.OnFailure(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    ASSERT_TRUE(ring.IsHealthy(1));
+    ring.OnFailure(1);
+    ASSERT_FALSE(ring.IsHealthy(1));
+}
+
+}  // namespace client
+}  // namespace curvefs
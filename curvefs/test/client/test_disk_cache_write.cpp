@@ -22,6 +22,10 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <butil/time.h>
+
+#include <chrono>
+#include <thread>
 
 #include "curvefs/test/client/mock_test_posix_wapper.h"
 #include "curvefs/test/client/mock_client_s3.h"
@@ -228,6 +232,43 @@ TEST_F(TestDiskCacheWrite, UploadFile) {
     ASSERT_EQ(0, ret);
 }
 
+TEST_F(TestDiskCacheWrite, UploadFileRetry) {
+    std::string path = "test";
+    EXPECT_CALL(*wrapper_, stat(NotNull(), NotNull()))
+        .Times(2)
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*wrapper_, open(_, _, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*wrapper_, close(_))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*wrapper_, malloc(_))
+        .WillOnce(Return(&path));
+    EXPECT_CALL(*wrapper_, memset(_, _, _))
+        .WillOnce(Return(&path));
+    EXPECT_CALL(*wrapper_, free(_))
+        .WillRepeatedly(Return());
+    EXPECT_CALL(*wrapper_, read(_, _, _))
+        .WillOnce(Return(239772865546436));
+    EXPECT_CALL(*wrapper_, remove(_))
+        .WillOnce(Return(0));
+    // upload thread is not running, failed upload is retried in place
+    EXPECT_CALL(*client_, UploadAsync(_))
+        .WillOnce(Invoke(
+            [&] (const std::shared_ptr<PutObjectAsyncContext>& context) {
+                context->retCode = -1;
+                context->cb(context);
+    }))
+        .WillOnce(Invoke(
+            [&] (const std::shared_ptr<PutObjectAsyncContext>& context) {
+                context->retCode = 0;
+                context->cb(context);
+    }));
+    auto syncTask = std::make_shared<DiskCacheWrite::SynchronizationTask>(1);
+    ASSERT_EQ(0, diskCacheWrite_->UploadFile("test", syncTask));
+    syncTask->Wait();
+    ASSERT_TRUE(syncTask->Success());
+}
+
 TEST_F(TestDiskCacheWrite, WriteDiskFile) {
     EXPECT_CALL(*wrapper_, open(_, _, _))
         .WillOnce(Return(-1));
@@ -474,6 +515,113 @@ TEST_F(TestDiskCacheWrite, AsyncUploadRun) {
     }
 }
 
+TEST_F(TestDiskCacheWrite, NextUploadUrgentFirst) {
+    DiskCacheOption option = DiskCacheOption();
+    option.uploadMinConcurrency = 1;
+    option.uploadMaxConcurrency = 1;
+    diskCacheWrite_->InitUploadOption(option);
+    auto makeTask = [](const std::string &key, uint64_t retryTimeUs,
+                       bool urgent) {
+        auto context = std::make_shared<PutObjectAsyncContext>();
+        context->key = key;
+        return DiskCacheWrite::RetryTask{context, retryTimeUs, urgent,
+                                         nullptr};
+    };
+    diskCacheWrite_->AsyncUploadEnqueue("waiting");
+    uint64_t later = butil::cpuwide_time_us() + 3600ull * 1000 * 1000;
+    diskCacheWrite_->retryUpload_.push_back(makeTask("retry", 0, false));
+    diskCacheWrite_->retryUpload_.push_back(makeTask("later", later, false));
+    diskCacheWrite_->retryUpload_.push_back(makeTask("urgent", 0, true));
+
+    // the limit is reached, only the retry waited by fsync is sent
+    std::string toUpload;
+    DiskCacheWrite::RetryTask toRetry;
+    bool retry = false;
+    diskCacheWrite_->inflight_ = 1;
+    ASSERT_TRUE(diskCacheWrite_->NextUploadLocked(&toUpload, &toRetry,
+                                                  &retry));
+    ASSERT_TRUE(retry);
+    ASSERT_EQ("urgent", toRetry.context->key);
+    ASSERT_FALSE(diskCacheWrite_->NextUploadLocked(&toUpload, &toRetry,
+                                                   &retry));
+
+    // under the limit, the due retries go before the waiting files, and
+    // the retries not due yet are not sent
+    diskCacheWrite_->inflight_ = 0;
+    ASSERT_TRUE(diskCacheWrite_->NextUploadLocked(&toUpload, &toRetry,
+                                                  &retry));
+    ASSERT_TRUE(retry);
+    ASSERT_EQ("retry", toRetry.context->key);
+    ASSERT_TRUE(diskCacheWrite_->NextUploadLocked(&toUpload, &toRetry,
+                                                  &retry));
+    ASSERT_FALSE(retry);
+    ASSERT_EQ("waiting", toUpload);
+    ASSERT_FALSE(diskCacheWrite_->NextUploadLocked(&toUpload, &toRetry,
+                                                   &retry));
+    ASSERT_EQ(1, diskCacheWrite_->retryUpload_.size());
+    diskCacheWrite_->retryUpload_.clear();
+}
+
+TEST_F(TestDiskCacheWrite, RetryBackoffAndStopTimeout) {
+    DiskCacheOption option = DiskCacheOption();
+    option.uploadMinConcurrency = 4;
+    option.uploadMaxConcurrency = 4;
+    option.uploadLatencyTolerancePercent = 200;
+    option.uploadMaxRetryIntervalMs = 3600 * 1000;
+    option.uploadStopTimeoutMs = 100;
+    diskCacheWrite_->InitUploadOption(option);
+
+    std::string path = "test";
+    EXPECT_CALL(*wrapper_, stat(NotNull(), NotNull()))
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*wrapper_, open(_, _, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*wrapper_, close(_))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*wrapper_, malloc(_))
+        .WillOnce(Return(&path));
+    EXPECT_CALL(*wrapper_, memset(_, _, _))
+        .WillOnce(Return(&path));
+    EXPECT_CALL(*wrapper_, read(_, _, _))
+        .WillOnce(Return(239772865546436));
+    // the upload is given up, and the file is left in the write cache
+    EXPECT_CALL(*wrapper_, free(_))
+        .Times(1);
+    EXPECT_CALL(*wrapper_, remove(_))
+        .Times(0);
+    // s3 is unavailable
+    EXPECT_CALL(*client_, UploadAsync(_))
+        .WillOnce(Invoke(
+            [&] (const std::shared_ptr<PutObjectAsyncContext>& context) {
+                context->retCode = -1;
+                context->cb(context);
+    }));
+    ASSERT_EQ(0, diskCacheWrite_->AsyncUploadRun());
+    uint64_t startUs = butil::cpuwide_time_us();
+    diskCacheWrite_->AsyncUploadEnqueue("test");
+
+    // the failed upload is retried after the first backoff interval
+    uint64_t intervalUs =
+        UploadRetryIntervalMs(1, option.uploadMaxRetryIntervalMs) * 1000;
+    uint64_t retryTimeUs = 0;
+    for (int i = 0; i < 100 && retryTimeUs == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lock(diskCacheWrite_->mtx_);
+        if (!diskCacheWrite_->retryUpload_.empty()) {
+            retryTimeUs = diskCacheWrite_->retryUpload_.front().retryTimeUs;
+        }
+    }
+    ASSERT_GE(retryTimeUs, startUs + intervalUs);
+    ASSERT_LE(retryTimeUs, butil::cpuwide_time_us() + intervalUs);
+
+    // stopping does not wait for the retry forever
+    auto start = std::chrono::steady_clock::now();
+    diskCacheWrite_->AsyncUploadStop();
+    ASSERT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(10));
+    ASSERT_TRUE(diskCacheWrite_->retryUpload_.empty());
+}
+
 TEST_F(TestDiskCacheWrite, UploadFileByInode) {
     std::string inode("100"), obj1("1_16777216_2_0_0");
 
@@ -866,6 +866,12 @@ TEST_F(TestFuseVolumeClient, FuseOpRenameBasic) {
     uint64_t srcTxId = 0;
     uint64_t dstTxId = 2;
 
+    // step0: persist files created locally in both parents only
+    EXPECT_CALL(*inodeManager_, FlushPendingCreates(parent))
+        .WillOnce(Return(CURVEFS_ERROR::OK));
+    EXPECT_CALL(*inodeManager_, FlushPendingCreates(newparent))
+        .WillOnce(Return(CURVEFS_ERROR::OK));
+
     // step1: get txid
     EXPECT_CALL(*metaClient_, GetTxId(fsId, parent, _, _))
         .WillOnce(DoAll(SetArgPointee<2>(srcPartitionId),
@@ -341,5 +341,93 @@ TEST_F(TestInodeWrapper, TestSetXattr) {
     ASSERT_TRUE(inodeWrapper_->IsDirty());
 }
 
+namespace {
+
+std::shared_ptr<InodeWrapper> MkPendingInode(
+    const std::shared_ptr<MockMetaServerClient>& metaClient) {
+    Inode inode;
+    inode.set_inodeid(100);
+    inode.set_fsid(1);
+    inode.set_type(FsFileType::TYPE_S3);
+    auto wrapper = std::make_shared<InodeWrapper>(inode, metaClient);
+
+    Dentry dentry;
+    dentry.set_fsid(1);
+    dentry.set_inodeid(100);
+    dentry.set_parentinodeid(1);
+    dentry.set_name("file");
+    InodeParam param;
+    param.fsId = 1;
+    param.length = 0;
+    param.uid = 0;
+    param.gid = 0;
+    param.mode = 0644;
+    param.type = FsFileType::TYPE_S3;
+    param.rdev = 0;
+    param.parent = 1;
+    wrapper->SetPendingCreate(dentry, param, timespec{0, 0});
+    wrapper->SetLength(1024);
+    return wrapper;
+}
+
+}  // namespace
+
+TEST_F(TestInodeWrapper, TestPersistCreateDentryExist) {
+    // the name is taken by another client before the file is persisted
+    auto wrapper = MkPendingInode(metaClient_);
+    Dentry exist;
+    exist.set_inodeid(200);
+    EXPECT_CALL(*metaClient_, CreateNode(_, _, _, _))
+        .WillOnce(Return(MetaStatusCode::DENTRY_EXIST));
+    EXPECT_CALL(*metaClient_, GetDentry(1, 1, "file", _))
+        .WillOnce(DoAll(SetArgPointee<3>(exist),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, UpdateInodeAttrWithOutNlink(_, _, _, _, _))
+        .Times(0);
+
+    std::vector<rpcclient::InodeUpdate> updates;
+    {
+        auto lk = wrapper->GetUniqueLock();
+        wrapper->AsyncInBatch(&updates, true);
+    }
+    ASSERT_TRUE(updates.empty());
+    ASSERT_FALSE(wrapper->IsCreatePending());
+    ASSERT_TRUE(wrapper->IsCreateFailed());
+
+    // the error is returned to the next fsync or close
+    auto lk = wrapper->GetUniqueLock();
+    ASSERT_EQ(CURVEFS_ERROR::IO_ERROR, wrapper->Sync());
+}
+
+TEST_F(TestInodeWrapper, TestPersistCreateRetry) {
+    auto wrapper = MkPendingInode(metaClient_);
+    auto lk = wrapper->GetUniqueLock();
+
+    // transient error, the create is still pending and retried later
+    std::vector<rpcclient::InodeUpdate> updates;
+    EXPECT_CALL(*metaClient_, CreateNode(_, _, _, _))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR));
+    wrapper->AsyncInBatch(&updates, true);
+    ASSERT_TRUE(updates.empty());
+    ASSERT_TRUE(wrapper->IsCreatePending());
+    ASSERT_FALSE(wrapper->IsCreateFailed());
+
+    // the response of the last attempt was lost, the dentry refers to the
+    // inode already
+    Dentry exist;
+    exist.set_inodeid(100);
+    EXPECT_CALL(*metaClient_, CreateNode(_, _, _, _))
+        .WillOnce(Return(MetaStatusCode::DENTRY_EXIST));
+    EXPECT_CALL(*metaClient_, GetDentry(1, 1, "file", _))
+        .WillOnce(DoAll(SetArgPointee<3>(exist),
+                        Return(MetaStatusCode::OK)));
+    wrapper->AsyncInBatch(&updates, true);
+    ASSERT_FALSE(wrapper->IsCreatePending());
+    ASSERT_FALSE(wrapper->IsCreateFailed());
+    ASSERT_EQ(1, updates.size());
+    updates[0].done->SetMetaStatusCode(MetaStatusCode::OK);
+    updates[0].done->Run();
+}
+
 }  // namespace client
 }  // namespace curvefs
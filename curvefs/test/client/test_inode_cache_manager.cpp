@@ -54,11 +54,13 @@ using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::SetArgPointee;
 using ::testing::SetArgReferee;
+using ::testing::Truly;
 using ::testing::AnyOf;
 
 using rpcclient::MetaServerClientDone;
 using rpcclient::MockMetaServerClient;
 using rpcclient::DataIndices;
+using rpcclient::InodeIdLease;
 
 using ::curvefs::client::common::DeferSyncOption;
 using ::curvefs::client::common::DirCacheOption;
@@ -83,7 +85,8 @@ class TestInodeCacheManager : public ::testing::Test {
         auto deferSync = std::make_shared<DeferSync>(DeferSyncOption());
         auto openFiles = std::make_shared<OpenFiles>(
             OpenFilesOption(), deferSync);
-        iCacheManager_->Init(option, openFiles, deferSync);
+        iCacheManager_->Init(option, openFiles, deferSync,
+                             LocalCreateOption());
     }
 
     virtual void TearDown() {
@@ -257,6 +260,76 @@ TEST_F(TestInodeCacheManager, CreateAndGetInode) {
     */
 }
 
+TEST_F(TestInodeCacheManager, CreateNode) {
+    InodeParam param;
+    param.fsId = fsId_;
+    param.type = FsFileType::TYPE_FILE;
+
+    Dentry dentry;
+    dentry.set_fsid(fsId_);
+    dentry.set_parentinodeid(1);
+    dentry.set_name("file");
+
+    Inode inode;
+    inode.set_inodeid(100);
+    inode.set_fsid(fsId_);
+    inode.set_type(FsFileType::TYPE_FILE);
+
+    // case 1: created in one request with a leased inode id
+    InodeIdLease lease;
+    lease.start = 100;
+    lease.count = 10;
+    lease.partitionStart = 1;
+    lease.partitionEnd = 1000;
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 1, _, _))
+        .WillOnce(DoAll(SetArgPointee<3>(lease), Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_,
+                CreateNode(Truly([](const Dentry &d) {
+                               return d.inodeid() == 100;
+                           }),
+                           &param, _, _))
+        .WillOnce(DoAll(SetArgPointee<3>(inode), Return(MetaStatusCode::OK)));
+    std::shared_ptr<InodeWrapper> inodeWrapper;
+    ASSERT_EQ(CURVEFS_ERROR::OK,
+              iCacheManager_->CreateNode(param, dentry, inodeWrapper));
+    ASSERT_EQ(100, inodeWrapper->GetInodeId());
+
+    // case 2: partition of parent is full, fallback to create inode first
+    EXPECT_CALL(*metaClient_, CreateNode(_, &param, _, _))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ALLOC_ID_FAIL));
+    EXPECT_CALL(*metaClient_, CreateInode(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(inode), Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, CreateNode(_, nullptr, _, nullptr))
+        .WillOnce(Return(MetaStatusCode::OK));
+    ASSERT_EQ(CURVEFS_ERROR::OK,
+              iCacheManager_->CreateNode(param, dentry, inodeWrapper));
+    ASSERT_EQ(100, inodeWrapper->GetInodeId());
+
+    // case 3: fallback failed, the new inode is deleted
+    EXPECT_CALL(*metaClient_, CreateNode(_, &param, _, _))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ALLOC_ID_FAIL));
+    EXPECT_CALL(*metaClient_, CreateInode(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(inode), Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, CreateNode(_, nullptr, _, nullptr))
+        .WillOnce(Return(MetaStatusCode::DENTRY_EXIST));
+    EXPECT_CALL(*metaClient_, DeleteInode(fsId_, 100))
+        .WillOnce(Return(MetaStatusCode::OK));
+    ASSERT_EQ(CURVEFS_ERROR::EXISTS,
+              iCacheManager_->CreateNode(param, dentry, inodeWrapper));
+
+    // case 4: no inode id can be leased, create inode first
+    dentry.set_parentinodeid(2000);
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 2000, _, _))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ALLOC_ID_FAIL));
+    EXPECT_CALL(*metaClient_, CreateInode(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(inode), Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, CreateNode(_, nullptr, _, nullptr))
+        .WillOnce(Return(MetaStatusCode::OK));
+    ASSERT_EQ(CURVEFS_ERROR::OK,
+              iCacheManager_->CreateNode(param, dentry, inodeWrapper));
+    ASSERT_EQ(100, inodeWrapper->GetInodeId());
+}
+
 TEST_F(TestInodeCacheManager, DeleteInode) {
     uint64_t inodeId = 100;
 
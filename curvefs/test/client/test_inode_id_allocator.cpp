@@ -0,0 +1,195 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-20
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+#include "curvefs/src/client/inode_id_allocator.h"
+#include "curvefs/test/client/mock_metaserver_client.h"
+#include "src/common/concurrent/count_down_event.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curvefs::client::rpcclient::MockMetaServerClient;
+using ::curve::common::CountDownEvent;
+using ::curvefs::metaserver::MetaStatusCode;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+namespace {
+
+InodeIdLease MakeLease(uint64_t start, uint32_t count, uint64_t partStart,
+                       uint64_t partEnd) {
+    InodeIdLease lease;
+    lease.start = start;
+    lease.count = count;
+    lease.partitionStart = partStart;
+    lease.partitionEnd = partEnd;
+    return lease;
+}
+
+}  // namespace
+
+class InodeIdAllocatorTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        metaClient_ = std::make_shared<MockMetaServerClient>();
+        allocator_ = std::make_shared<InodeIdAllocator>(metaClient_, 2);
+    }
+
+ protected:
+    uint32_t fsId_ = 1;
+    std::shared_ptr<MockMetaServerClient> metaClient_;
+    std::shared_ptr<InodeIdAllocator> allocator_;
+};
+
+TEST_F(InodeIdAllocatorTest, ReuseLease) {
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 150, 2, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(110, 2, 100, 199)),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(112, 2, 100, 199)),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(114, 2, 100, 199)),
+                        Return(MetaStatusCode::OK)));
+
+    uint64_t inodeId = 0;
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(110, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(111, inodeId);
+    // lease is used up
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(112, inodeId);
+}
+
+TEST_F(InodeIdAllocatorTest, LeasePerPartition) {
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 100, 2, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(120, 2, 100, 199)),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 200, 2, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(220, 2, 200, 299)),
+                        Return(MetaStatusCode::OK)));
+    // the next ranges are leased by the parent which uses up the range
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 199, 2, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(122, 2, 100, 199)),
+                        Return(MetaStatusCode::OK)));
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 250, 2, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(222, 2, 200, 299)),
+                        Return(MetaStatusCode::OK)));
+
+    uint64_t inodeId = 0;
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 100, &inodeId));
+    ASSERT_EQ(120, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 200, &inodeId));
+    ASSERT_EQ(220, inodeId);
+    // parents in the same partition share the lease
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 199, &inodeId));
+    ASSERT_EQ(121, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 250, &inodeId));
+    ASSERT_EQ(221, inodeId);
+}
+
+TEST_F(InodeIdAllocatorTest, LeaseNextRangeAtHalf) {
+    allocator_ = std::make_shared<InodeIdAllocator>(metaClient_, 4);
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 150, 4, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(110, 4, 100, 199)),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(130, 4, 100, 199)),
+                        Return(MetaStatusCode::OK)));
+
+    uint64_t inodeId = 0;
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(110, inodeId);
+    // the next range is leased here
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(111, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(112, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(113, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(130, inodeId);
+}
+
+TEST_F(InodeIdAllocatorTest, NotHoldLockDuringLease) {
+    allocator_ = std::make_shared<InodeIdAllocator>(metaClient_, 4);
+    CountDownEvent leasing(1);
+    CountDownEvent leased(1);
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 150, 4, _))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(110, 4, 100, 199)),
+                        Return(MetaStatusCode::OK)))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(130, 4, 100, 199)),
+                        Invoke([&]() {
+                            leasing.Signal();
+                            leased.Wait();
+                        }),
+                        Return(MetaStatusCode::OK)));
+
+    uint64_t inodeId = 0;
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(110, inodeId);
+    std::thread leaser([&]() {
+        uint64_t id = 0;
+        ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &id));
+        ASSERT_EQ(111, id);
+    });
+
+    // other requests take ids of the current range during the lease
+    leasing.Wait();
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(112, inodeId);
+    ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &inodeId));
+    ASSERT_EQ(113, inodeId);
+
+    // the range is used up, wait for the lease in flight
+    std::thread waiter([&]() {
+        uint64_t id = 0;
+        ASSERT_TRUE(allocator_->Allocate(fsId_, 150, &id));
+        ASSERT_EQ(130, id);
+    });
+    leased.Signal();
+    leaser.join();
+    waiter.join();
+}
+
+TEST_F(InodeIdAllocatorTest, LeaseFail) {
+    EXPECT_CALL(*metaClient_, AllocInodeId(fsId_, 100, 2, _))
+        .WillOnce(Return(MetaStatusCode::PARTITION_ALLOC_ID_FAIL))
+        .WillOnce(Return(MetaStatusCode::RPC_ERROR))
+        .WillOnce(DoAll(SetArgPointee<3>(MakeLease(300, 2, 300, 399)),
+                        Return(MetaStatusCode::OK)));
+
+    uint64_t inodeId = 0;
+    ASSERT_FALSE(allocator_->Allocate(fsId_, 100, &inodeId));
+    ASSERT_FALSE(allocator_->Allocate(fsId_, 100, &inodeId));
+    // lease out of the partition of parent is rejected
+    ASSERT_FALSE(allocator_->Allocate(fsId_, 100, &inodeId));
+}
+
+}  // namespace client
+}  // namespace curvefs
@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-26
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "curvefs/src/client/kvclient/kvclient_manager.h"
+#include "curvefs/test/client/mock_kvclient.h"
+#include "src/common/concurrent/count_down_event.h"
+
+namespace curvefs {
+namespace client {
+
+using ::curve::common::CountDownEvent;
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+
+class KVClientManagerTest : public ::testing::Test {
+ protected:
+    void Init(uint64_t nearCacheCapacityBytes) {
+        client_ = std::make_shared<MockKVClient>();
+        KVClientManagerOpt opt;
+        opt.setThreadPooln = 2;
+        opt.nearCacheCapacityBytes = nearCacheCapacityBytes;
+        manager_ = std::make_shared<KVClientManager>();
+        ASSERT_TRUE(manager_->Init(opt, client_));
+    }
+
+    void MultiGet(const std::vector<std::string> &keys,
+                  std::vector<std::string> *bufs, uint64_t offset,
+                  uint64_t length, std::vector<bool> *res) {
+        auto task = std::make_shared<MultiGetKVCacheTask>();
+        bufs->assign(keys.size(), std::string(length, '\0'));
+        for (size_t i = 0; i < keys.size(); i++) {
+            task->tasks.emplace_back(std::make_shared<GetKVCacheTask>(
+                keys[i], &(*bufs)[i][0], offset, length));
+        }
+        CountDownEvent event(1);
+        task->done = [&](const std::shared_ptr<MultiGetKVCacheTask> &) {
+            event.Signal();
+        };
+        manager_->MultiGet(task);
+        event.Wait();
+
+        res->clear();
+        for (const auto &t : task->tasks) {
+            res->push_back(t->res);
+        }
+    }
+
+ protected:
+    std::shared_ptr<MockKVClient> client_;
+    std::shared_ptr<KVClientManager> manager_;
+};
+
+TEST_F(KVClientManagerTest, MultiGetWithNearCache) {
+    Init(1024);
+    std::vector<std::string> keys{"k1", "k2", "k3"};
+    std::vector<std::shared_ptr<std::string>> values{
+        std::make_shared<std::string>("value1"), nullptr,
+        std::make_shared<std::string>("value3")};
+
+    EXPECT_CALL(*client_, MultiGet(keys, _))
+        .WillOnce(DoAll(SetArgPointee<1>(values), Return(true)));
+
+    std::vector<std::string> bufs;
+    std::vector<bool> res;
+    MultiGet(keys, &bufs, 1, 4, &res);
+    ASSERT_EQ(std::vector<bool>({true, false, true}), res);
+    ASSERT_EQ("alue", bufs[0]);
+    ASSERT_EQ("alue", bufs[2]);
+
+    // found keys are served by near cache, only the missed one is sent
+    EXPECT_CALL(*client_, MultiGet(std::vector<std::string>{"k2"}, _))
+        .WillOnce(Return(true));
+    MultiGet(keys, &bufs, 0, 6, &res);
+    ASSERT_EQ(std::vector<bool>({true, false, true}), res);
+    ASSERT_EQ("value1", bufs[0]);
+    ASSERT_EQ("value3", bufs[2]);
+}
+
+TEST_F(KVClientManagerTest, NearCacheBoundedByBytes) {
+    // each of k1 and k2 takes 8 bytes, k3 takes more than the capacity
+    Init(12);
+    std::vector<std::string> keys{"k1", "k2", "k3"};
+    std::vector<std::shared_ptr<std::string>> values{
+        std::make_shared<std::string>("value1"),
+        std::make_shared<std::string>("value2"),
+        std::make_shared<std::string>("value3-too-large")};
+
+    EXPECT_CALL(*client_, MultiGet(keys, _))
+        .WillOnce(DoAll(SetArgPointee<1>(values), Return(true)));
+
+    std::vector<std::string> bufs;
+    std::vector<bool> res;
+    MultiGet(keys, &bufs, 0, 6, &res);
+    ASSERT_EQ(std::vector<bool>({true, true, true}), res);
+
+    // k1 is evicted by k2, and k3 is never cached
+    EXPECT_CALL(*client_,
+                MultiGet(std::vector<std::string>{"k1", "k3"}, _))
+        .WillOnce(Return(true));
+    MultiGet(keys, &bufs, 0, 6, &res);
+    ASSERT_EQ(std::vector<bool>({false, true, false}), res);
+    ASSERT_EQ("value2", bufs[1]);
+}
+
+TEST_F(KVClientManagerTest, MultiGetNotSupported) {
+    Init(0);
+    std::vector<std::string> keys{"k1", "k2"};
+
+    EXPECT_CALL(*client_, MultiGet(_, _)).WillOnce(Return(false));
+    EXPECT_CALL(*client_, Get("k1", _, 0, 2, _))
+        .WillOnce(Invoke([](const std::string &, char *value, uint64_t,
+                            uint64_t, std::string *) {
+            memcpy(value, "v1", 2);
+            return true;
+        }));
+    EXPECT_CALL(*client_, Get("k2", _, 0, 2, _)).WillOnce(Return(false));
+
+    std::vector<std::string> bufs;
+    std::vector<bool> res;
+    MultiGet(keys, &bufs, 0, 2, &res);
+    ASSERT_EQ(std::vector<bool>({true, false}), res);
+    ASSERT_EQ("v1", bufs[0]);
+}
+
+TEST_F(KVClientManagerTest, SingleGetByRange) {
+    Init(0);
+    std::string key = "k1";
+
+    // without near cache, a single key doesn't need the whole value
+    EXPECT_CALL(*client_, MultiGet(_, _)).Times(0);
+    EXPECT_CALL(*client_, Get(key, _, 0, 2, _)).WillOnce(Return(true));
+
+    char buf[2];
+    auto task = std::make_shared<GetKVCacheTask>(key, buf, 0, 2);
+    CountDownEvent event(1);
+    task->done = [&](const std::shared_ptr<GetKVCacheTask> &) {
+        event.Signal();
+    };
+    manager_->Get(task);
+    event.Wait();
+    ASSERT_TRUE(task->res);
+}
+
+}  // namespace client
+}  // namespace curvefs
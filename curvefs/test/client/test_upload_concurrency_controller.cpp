@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-04-10
+ */
+
+#include <gtest/gtest.h>
+
+#include "curvefs/src/client/s3/upload_concurrency_controller.h"
+
+namespace curvefs {
+namespace client {
+
+namespace {
+
+void FeedWindow(UploadConcurrencyController *controller, uint64_t latencyUs,
+                bool success = true) {
+    uint32_t limit = controller->Limit();
+    for (uint32_t i = 0; i < limit; i++) {
+        controller->OnComplete(latencyUs, 4 * 1024 * 1024, success);
+    }
+}
+
+}  // namespace
+
+TEST(UploadConcurrencyControllerTest, GrowWhenLatencyIsStable) {
+    UploadConcurrencyOption option;
+    option.minConcurrency = 2;
+    option.maxConcurrency = 8;
+    UploadConcurrencyController controller(option);
+    ASSERT_EQ(2, controller.Limit());
+
+    for (int i = 0; i < 20; i++) {
+        FeedWindow(&controller, 1000);
+    }
+    ASSERT_EQ(8, controller.Limit());
+}
+
+TEST(UploadConcurrencyControllerTest, ShrinkWhenLatencyGrows) {
+    UploadConcurrencyOption option;
+    option.minConcurrency = 2;
+    option.maxConcurrency = 64;
+    option.latencyTolerancePercent = 200;
+    UploadConcurrencyController controller(option);
+
+    for (int i = 0; i < 30; i++) {
+        FeedWindow(&controller, 1000);
+    }
+    uint32_t limit = controller.Limit();
+    ASSERT_GT(limit, 2);
+
+    FeedWindow(&controller, 5000);
+    ASSERT_LT(controller.Limit(), limit);
+
+    for (int i = 0; i < 30; i++) {
+        FeedWindow(&controller, 5000);
+    }
+    ASSERT_EQ(2, controller.Limit());
+}
+
+TEST(UploadConcurrencyControllerTest, ShrinkOnError) {
+    UploadConcurrencyOption option;
+    option.minConcurrency = 1;
+    option.maxConcurrency = 16;
+    UploadConcurrencyController controller(option);
+
+    for (int i = 0; i < 20; i++) {
+        FeedWindow(&controller, 1000);
+    }
+    uint32_t limit = controller.Limit();
+    ASSERT_EQ(16, limit);
+
+    FeedWindow(&controller, 1000, false);
+    ASSERT_LT(controller.Limit(), limit);
+}
+
+TEST(UploadConcurrencyControllerTest, InvalidOption) {
+    UploadConcurrencyOption option;
+    option.minConcurrency = 0;
+    option.maxConcurrency = 0;
+    UploadConcurrencyController controller(option);
+    ASSERT_EQ(1, controller.Limit());
+
+    FeedWindow(&controller, 1000, false);
+    ASSERT_EQ(1, controller.Limit());
+}
+
+TEST(UploadConcurrencyControllerTest, AdditiveIncreaseAndDecrease) {
+    UploadConcurrencyOption option;
+    option.minConcurrency = 4;
+    option.maxConcurrency = 16;
+    UploadConcurrencyController controller(option);
+    ASSERT_EQ(4, controller.Limit());
+
+    // grows by one every window
+    FeedWindow(&controller, 1000);
+    ASSERT_EQ(5, controller.Limit());
+    FeedWindow(&controller, 1000);
+    ASSERT_EQ(6, controller.Limit());
+
+    // one failure in a window shrinks it by a quarter
+    controller.OnComplete(1000, 4 * 1024 * 1024, false);
+    for (int i = 1; i < 6; i++) {
+        controller.OnComplete(1000, 4 * 1024 * 1024, true);
+    }
+    ASSERT_EQ(4, controller.Limit());
+
+    // the throughput of the smaller window dropped, so it does not grow
+    // until the throughput is measured again
+    FeedWindow(&controller, 1000);
+    ASSERT_EQ(4, controller.Limit());
+    FeedWindow(&controller, 1000);
+    ASSERT_EQ(5, controller.Limit());
+
+    // never shrinks below the lower bound
+    for (int i = 0; i < 10; i++) {
+        FeedWindow(&controller, 1000, false);
+    }
+    ASSERT_EQ(4, controller.Limit());
+}
+
+TEST(UploadConcurrencyControllerTest, FollowLatencyChange) {
+    UploadConcurrencyOption option;
+    option.minConcurrency = 2;
+    option.maxConcurrency = 32;
+    option.minLatencyResetWindows = 5;
+    UploadConcurrencyController controller(option);
+    for (int i = 0; i < 10; i++) {
+        FeedWindow(&controller, 1000);
+    }
+    uint32_t limit = controller.Limit();
+    ASSERT_EQ(12, limit);
+
+    // s3 becomes slower for good, the limit shrinks at first, and grows
+    // again once the minimum latency is reset to the new latency
+    FeedWindow(&controller, 5000);
+    ASSERT_EQ(9, controller.Limit());
+    for (int i = 0; i < 20; i++) {
+        FeedWindow(&controller, 5000);
+    }
+    ASSERT_GT(controller.Limit(), limit);
+}
+
+TEST(UploadConcurrencyControllerTest, RetryInterval) {
+    const uint64_t maxIntervalMs = 10000;
+    ASSERT_EQ(200, UploadRetryIntervalMs(1, maxIntervalMs));
+    ASSERT_EQ(400, UploadRetryIntervalMs(2, maxIntervalMs));
+    ASSERT_EQ(800, UploadRetryIntervalMs(3, maxIntervalMs));
+    ASSERT_EQ(6400, UploadRetryIntervalMs(6, maxIntervalMs));
+    ASSERT_EQ(maxIntervalMs, UploadRetryIntervalMs(7, maxIntervalMs));
+    ASSERT_EQ(maxIntervalMs, UploadRetryIntervalMs(1000, maxIntervalMs));
+
+    // stops doubling after 16 retries
+    ASSERT_EQ(100ull << 16, UploadRetryIntervalMs(16, UINT64_MAX));
+    ASSERT_EQ(100ull << 16, UploadRetryIntervalMs(1000, UINT64_MAX));
+}
+
+}  // namespace client
+}  // namespace curvefs
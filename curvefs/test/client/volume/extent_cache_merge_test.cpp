@@ -406,5 +406,31 @@ TEST(ExtentCacheMergeTest, MergeCase5_PhysicalOffsetContinuousButNotWritten) {
     ASSERT_TRUE(range[24 * kMiB].UnWritten);
 }
 
+// adding extent                   |----|  (unwritten)
+// existing extents           |----|
+TEST(ExtentCacheMergeTest, MergeCase6_PhysicalOffsetContinuousButNotWritten) {
+    ExtentCache cache;
+
+    PExtent existing;
+    existing.pOffset = 16 * kMiB;
+    existing.len = 4 * kMiB;
+    existing.UnWritten = false;
+    cache.Merge(16 * kMiB, existing);
+
+    PExtent adding;
+    adding.pOffset = 20 * kMiB;
+    adding.len = 4 * kMiB;
+    adding.UnWritten = true;
+    cache.Merge(20 * kMiB, adding);
+
+    auto extents = cache.GetExtentsForTesting();
+    auto& range = extents[0];
+    ASSERT_EQ(2, range.size());
+    ASSERT_FALSE(range[16 * kMiB].UnWritten);
+    ASSERT_EQ(4 * kMiB, range[16 * kMiB].len);
+    ASSERT_TRUE(range[20 * kMiB].UnWritten);
+    ASSERT_EQ(4 * kMiB, range[20 * kMiB].len);
+}
+
 }  // namespace client
 }  // namespace curvefs
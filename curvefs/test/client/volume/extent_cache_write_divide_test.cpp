@@ -934,5 +934,58 @@ TEST_F(ExtentCacheWriteDivideTest, DivideCase19_UnalignedWrite3) {
     ASSERT_EQ(1228, part.length);
 }
 
+TEST_F(ExtentCacheWriteDivideTest, PreAllocWindowGrowsForSequentialWrite) {
+    ExtentCache cache;
+
+    ExtentCacheOption opt;
+    opt.blockSize = 4 * kKiB;
+    opt.preAllocSize = 64 * kKiB;
+    opt.maxPreAllocSize = 256 * kKiB;
+    cache.SetOption(opt);
+
+    std::unique_ptr<char[]> data(new char[64 * kKiB]);
+    uint64_t poffset = 100 * kMiB;
+
+    // write 64KiB at |offset|, return the length of allocated space
+    auto write = [&](uint64_t offset) -> uint64_t {
+        std::vector<WritePart> allocated;
+        std::vector<AllocPart> needAlloc;
+        cache.DivideForWrite(offset, 64 * kKiB, data.get(), &allocated,
+                             &needAlloc);
+        uint64_t total = 0;
+        for (const auto& alloc : needAlloc) {
+            cache.Merge(alloc.allocInfo.lOffset,
+                        PExtent(alloc.allocInfo.len, poffset, true));
+            poffset += alloc.allocInfo.len;
+            total += alloc.allocInfo.len;
+        }
+        cache.MarkWritten(offset, 64 * kKiB);
+        return total;
+    };
+
+    ASSERT_EQ(64 * kKiB, write(0));
+    ASSERT_EQ(64 * kKiB, write(64 * kKiB));
+    ASSERT_EQ(128 * kKiB, write(128 * kKiB));
+    ASSERT_EQ(0, write(192 * kKiB));
+    ASSERT_EQ(256 * kKiB, write(256 * kKiB));
+    ASSERT_EQ(0, write(320 * kKiB));
+    ASSERT_EQ(0, write(384 * kKiB));
+    ASSERT_EQ(0, write(448 * kKiB));
+    // reach the max preallocation size
+    ASSERT_EQ(256 * kKiB, write(512 * kKiB));
+
+    // random write resets the window
+    ASSERT_EQ(64 * kKiB, write(16 * kMiB));
+
+    // physical space is contiguous, so all written extents are merged
+    auto extents = cache.GetExtentsForTesting();
+    auto& range = extents[0];
+    ASSERT_EQ(3, range.size());
+    ASSERT_EQ(576 * kKiB, range[0].len);
+    ASSERT_FALSE(range[0].UnWritten);
+    ASSERT_EQ(192 * kKiB, range[576 * kKiB].len);
+    ASSERT_TRUE(range[576 * kKiB].UnWritten);
+}
+
 }  // namespace client
 }  // namespace curvefs
@@ -220,3 +220,51 @@ TEST(ApplyQueue, ConcurrentTest) {
     concurrentapply.Stop();
 }
 
+TEST(ApplyQueue, PushWithDependencyTest) {
+    ApplyQueue concurrentapply;
+    ApplyOption opt(4, 100, 1, 1);
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    // inode-local tasks of one partition run in parallel
+    std::atomic<uint32_t> running(0);
+    std::atomic<uint32_t> maxRunning(0);
+    auto inodeTask = [&running, &maxRunning]() {
+        uint32_t cur = running.fetch_add(1) + 1;
+        uint32_t max = maxRunning.load();
+        while (cur > max && !maxRunning.compare_exchange_weak(max, cur)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        running.fetch_sub(1);
+    };
+
+    // partition-wide task sees all previous tasks finished,
+    // and following tasks are not started
+    std::atomic<uint32_t> finished(0);
+    uint32_t finishedBeforePartitionTask = 0;
+    auto countTask = [&inodeTask, &finished]() {
+        inodeTask();
+        finished.fetch_add(1);
+    };
+    auto partitionTask = [&finished, &finishedBeforePartitionTask]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        finishedBeforePartitionTask = finished.load();
+    };
+
+    for (uint64_t inodeId = 0; inodeId < 8; inodeId++) {
+        ASSERT_TRUE(concurrentapply.PushWithDependency(
+            1, &inodeId, OperatorType::UpdateInode, countTask));
+    }
+    ASSERT_TRUE(concurrentapply.PushWithDependency(
+        1, nullptr, OperatorType::CreateDentry, partitionTask));
+    for (uint64_t inodeId = 0; inodeId < 8; inodeId++) {
+        ASSERT_TRUE(concurrentapply.PushWithDependency(
+            1, &inodeId, OperatorType::UpdateInode, countTask));
+    }
+
+    concurrentapply.Flush();
+    ASSERT_EQ(8, finishedBeforePartitionTask);
+    ASSERT_EQ(16, finished.load());
+    ASSERT_GT(maxRunning.load(), 1);
+
+    concurrentapply.Stop();
+}
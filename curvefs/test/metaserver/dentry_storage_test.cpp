@@ -25,6 +25,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "curvefs/src/metaserver/storage/storage.h"
 #include "curvefs/src/metaserver/storage/rocksdb_storage.h"
 #include "curvefs/test/metaserver/storage/utils.h"
@@ -533,5 +535,59 @@ TEST_F(DentryStorageTest, HandleTx) {
     ASSERT_EQ(dentry.inodeid(), 1);
 }
 
+TEST_F(DentryStorageTest, HandleTxWithMultipleParents) {
+    DentryStorage storage(kvStorage_, nameGenerator_, 0);
+
+    // rename /A/a -> /B/b
+    InsertDentrys(&storage, std::vector<Dentry>{
+        // { fsId, parentId, name, txId, inodeId, deleteMarkFlag }
+        GenDentry(1, 1, "a", 0, 3, false),
+    });
+    std::vector<Dentry> dentrys{
+        GenDentry(1, 1, "a", 1, 3, true),
+        GenDentry(1, 2, "b", 1, 3, false),
+    };
+    auto rc = storage.HandleTx(TX_OP_TYPE::PREPARE, dentrys);
+    ASSERT_EQ(rc, MetaStatusCode::OK);
+    ASSERT_EQ(storage.Size(), 3);
+
+    rc = storage.HandleTx(TX_OP_TYPE::COMMIT, dentrys);
+    ASSERT_EQ(rc, MetaStatusCode::OK);
+    ASSERT_EQ(storage.Size(), 1);
+
+    Dentry dentry = GenDentry(1, 1, "a", 1, 0, false);
+    ASSERT_EQ(storage.Get(&dentry), MetaStatusCode::NOT_FOUND);
+    dentry = GenDentry(1, 2, "b", 1, 0, false);
+    ASSERT_EQ(storage.Get(&dentry), MetaStatusCode::OK);
+    ASSERT_EQ(dentry.inodeid(), 3);
+}
+
+TEST_F(DentryStorageTest, ConcurrentTxOnCrossedParents) {
+    DentryStorage storage(kvStorage_, nameGenerator_, 0);
+
+    // two kinds of transactions lock the same parents in reversed order
+    auto worker = [&](uint64_t from, uint64_t to, uint64_t base) {
+        for (uint64_t i = 0; i < 100; i++) {
+            std::string name = std::to_string(base + i);
+            std::vector<Dentry> dentrys{
+                GenDentry(1, from, name, 0, base + i, false),
+                GenDentry(1, to, name, 0, base + i, false),
+            };
+            ASSERT_EQ(storage.HandleTx(TX_OP_TYPE::PREPARE, dentrys),
+                      MetaStatusCode::OK);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(worker, 1, 2, 1000);
+    threads.emplace_back(worker, 2, 1, 2000);
+    threads.emplace_back(worker, 3, 4, 3000);
+    threads.emplace_back(worker, 4, 3, 4000);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(storage.Size(), 800);
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
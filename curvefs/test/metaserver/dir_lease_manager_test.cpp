@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-05-04
+ */
+
+#include <brpc/closure_guard.h>
+#include <brpc/server.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "curvefs/src/metaserver/dir_lease_manager.h"
+
+namespace curvefs {
+namespace metaserver {
+
+namespace {
+
+const char* kHolder = "127.0.0.1:6710";
+const char* kDeadHolder = "127.0.0.1:6711";
+
+class WaitClosure : public google::protobuf::Closure {
+ public:
+    void Run() override {
+        std::lock_guard<std::mutex> lk(mtx_);
+        runned_ = true;
+        cond_.notify_one();
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cond_.wait(lk, [this]() { return runned_; });
+    }
+
+ private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    bool runned_ = false;
+};
+
+class FakeDirLeaseService : public DirLeaseService {
+ public:
+    void InvalidateDir(google::protobuf::RpcController* controller,
+                       const InvalidateDirRequest* request,
+                       InvalidateDirResponse* response,
+                       google::protobuf::Closure* done) override {
+        brpc::ClosureGuard doneGuard(done);
+        std::lock_guard<std::mutex> lk(mtx);
+        ++calls;
+        if (fail) {
+            controller->SetFailed("holder never acks");
+            return;
+        }
+        for (auto parent : request->parentinodeids()) {
+            invalidated.emplace(parent);
+        }
+    }
+
+    std::set<uint64_t> Take() {
+        std::lock_guard<std::mutex> lk(mtx);
+        std::set<uint64_t> out;
+        out.swap(invalidated);
+        return out;
+    }
+
+    std::mutex mtx;
+    std::set<uint64_t> invalidated;
+    int calls = 0;
+    bool fail = false;
+};
+
+}  // namespace
+
+class DirLeaseManagerTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        ASSERT_EQ(0, server_.AddService(&service_,
+                                        brpc::SERVER_DOESNT_OWN_SERVICE));
+        ASSERT_EQ(0, server_.Start(kHolder, nullptr));
+    }
+
+    void TearDown() override {
+        server_.Stop(0);
+        server_.Join();
+    }
+
+    void Revoke(DirLeaseManager* manager, std::vector<uint64_t> parents) {
+        WaitClosure done;
+        manager->Revoke(1, parents, &done);
+        done.Wait();
+    }
+
+ protected:
+    FakeDirLeaseService service_;
+    brpc::Server server_;
+};
+
+TEST_F(DirLeaseManagerTest, Disabled) {
+    DirLeaseManager manager(DirLeaseOption{});
+    ASSERT_FALSE(manager.Enabled());
+    ASSERT_EQ(0, manager.Grant(1, 100, kHolder));
+    Revoke(&manager, {100});
+    ASSERT_TRUE(service_.Take().empty());
+}
+
+TEST_F(DirLeaseManagerTest, GrantAndRevoke) {
+    DirLeaseOption option;
+    option.leaseMs = 10000;
+    DirLeaseManager manager(option);
+    ASSERT_EQ(10000, manager.Grant(1, 100, kHolder));
+    ASSERT_EQ(10000, manager.Grant(1, 200, kHolder));
+    ASSERT_EQ(10000, manager.Grant(2, 300, kHolder));
+    ASSERT_EQ(0, manager.Grant(1, 400, ""));
+
+    // holders are notified before the change returns
+    Revoke(&manager, {100, 200, 300, 400});
+    ASSERT_EQ(std::set<uint64_t>({100, 200}), service_.Take());
+
+    // leases are revoked
+    Revoke(&manager, {100, 200});
+    ASSERT_TRUE(service_.Take().empty());
+}
+
+TEST_F(DirLeaseManagerTest, ExpiredLease) {
+    DirLeaseOption option;
+    option.leaseMs = 100;
+    DirLeaseManager manager(option);
+    manager.Grant(1, 100, kHolder);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    Revoke(&manager, {100});
+    ASSERT_TRUE(service_.Take().empty());
+}
+
+TEST_F(DirLeaseManagerTest, HolderDown) {
+    DirLeaseOption option;
+    option.leaseMs = 1000;
+    option.notifyTimeoutMs = 100;
+    DirLeaseManager manager(option);
+    auto start = std::chrono::steady_clock::now();
+    manager.Grant(1, 100, kDeadHolder);
+    manager.Grant(1, 100, kHolder);
+
+    // the change waits for the lease of the holder which is down to expire
+    Revoke(&manager, {100});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_GE(elapsed, std::chrono::milliseconds(option.leaseMs));
+    ASSERT_EQ(std::set<uint64_t>({100}), service_.Take());
+}
+
+TEST_F(DirLeaseManagerTest, HolderNeverAcks) {
+    DirLeaseOption option;
+    option.leaseMs = 1000;
+    option.notifyTimeoutMs = 100;
+    DirLeaseManager manager(option);
+    auto start = std::chrono::steady_clock::now();
+    manager.Grant(1, 100, kHolder);
+    {
+        std::lock_guard<std::mutex> lk(service_.mtx);
+        service_.fail = true;
+    }
+
+    // the notify is retried until the lease expires, and the change is
+    // acked only after that
+    Revoke(&manager, {100});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_GE(elapsed, std::chrono::milliseconds(option.leaseMs));
+    std::lock_guard<std::mutex> lk(service_.mtx);
+    ASSERT_GT(service_.calls, 1);
+    ASSERT_TRUE(service_.invalidated.empty());
+}
+
+}  // namespace metaserver
+}  // namespace curvefs
@@ -25,6 +25,8 @@
 #include <gtest/gtest.h>
 #include <google/protobuf/util/message_differencer.h>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "curvefs/test/metaserver/test_helper.h"
 #include "curvefs/src/metaserver/inode_manager.h"
@@ -518,5 +520,57 @@ TEST_F(InodeManagerTest, testCreateManageInode) {
     ASSERT_TRUE(CompareInode(inode, temp1));
 }
 
+TEST_F(InodeManagerTest, ConcurrentDeleteAndUpdateInode) {
+    // the operators on different inodes of one partition are applied
+    // concurrently, half of the inodes of each type are removed
+    const uint64_t inodeNumPerType = 200;
+    const std::vector<FsFileType> types = {FsFileType::TYPE_FILE,
+                                           FsFileType::TYPE_S3,
+                                           FsFileType::TYPE_DIRECTORY};
+    std::vector<std::vector<Inode>> inodes(types.size());
+    uint64_t ino = 100;
+    for (size_t i = 0; i < types.size(); i++) {
+        param_.type = types[i];
+        for (uint64_t j = 0; j < inodeNumPerType; j++) {
+            Inode inode;
+            ASSERT_EQ(MetaStatusCode::OK,
+                      manager->CreateInode(ino++, param_, &inode));
+            inodes[i].push_back(inode);
+        }
+        ASSERT_EQ(inodeNumPerType, (*filetype2InodeNum_)[types[i]]);
+    }
+
+    // the s3 inodes are moved to trash by unlinking the last link, the
+    // others are deleted
+    auto remove = [&](size_t type, uint64_t begin, uint64_t end) {
+        for (uint64_t j = begin; j < end; j++) {
+            const Inode& inode = inodes[type][j];
+            if (types[type] == FsFileType::TYPE_S3) {
+                UpdateInodeRequest request =
+                    MakeUpdateInodeRequestFromInode(inode);
+                request.set_nlink(0);
+                ASSERT_EQ(MetaStatusCode::OK, manager->UpdateInode(request));
+            } else {
+                ASSERT_EQ(MetaStatusCode::OK,
+                          manager->DeleteInode(inode.fsid(),
+                                               inode.inodeid()));
+            }
+        }
+    };
+    const uint64_t removeNum = inodeNumPerType / 2;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < types.size(); i++) {
+        threads.emplace_back(remove, i, 0, removeNum / 2);
+        threads.emplace_back(remove, i, removeNum / 2, removeNum);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& type : types) {
+        ASSERT_EQ(inodeNumPerType - removeNum, (*filetype2InodeNum_)[type]);
+    }
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
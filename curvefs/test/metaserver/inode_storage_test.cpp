@@ -289,6 +289,57 @@ TEST_F(InodeStorageTest, testGetAttr) {
     ASSERT_EQ(attr.mode(), 777);
 }
 
+TEST_F(InodeStorageTest, testGetAttrAfterUpdateAndDelete) {
+    InodeStorage storage(kvStorage_, nameGenerator_, 0);
+    Inode inode = GenInode(1, 1);
+    inode.mutable_xattr()->insert({"key", "value"});
+    ASSERT_EQ(storage.Insert(inode), MetaStatusCode::OK);
+
+    // attribute is updated along with inode
+    inode.set_length(8192);
+    inode.set_mtime(200);
+    ASSERT_EQ(storage.Update(inode), MetaStatusCode::OK);
+    InodeAttr attr;
+    ASSERT_EQ(storage.GetAttr(Key4Inode(1, 1), &attr), MetaStatusCode::OK);
+    ASSERT_EQ(attr.length(), 8192);
+    ASSERT_EQ(attr.mtime(), 200);
+    ASSERT_EQ(attr.xattr().at("key"), "value");
+
+    inode.set_length(16384);
+    ASSERT_EQ(storage.Update(inode, true), MetaStatusCode::OK);
+    ASSERT_EQ(storage.GetAttr(Key4Inode(1, 1), &attr), MetaStatusCode::OK);
+    ASSERT_EQ(attr.length(), 16384);
+
+    // attribute is deleted along with inode
+    ASSERT_EQ(storage.Delete(Key4Inode(1, 1)), MetaStatusCode::OK);
+    ASSERT_EQ(storage.GetAttr(Key4Inode(1, 1), &attr),
+              MetaStatusCode::NOT_FOUND);
+
+    // attribute is cleared along with inode
+    ASSERT_EQ(storage.Insert(inode), MetaStatusCode::OK);
+    ASSERT_EQ(storage.Clear(), MetaStatusCode::OK);
+    ASSERT_EQ(storage.GetAttr(Key4Inode(1, 1), &attr),
+              MetaStatusCode::NOT_FOUND);
+}
+
+TEST_F(InodeStorageTest, testGetAttrWithoutAttrTable) {
+    InodeStorage storage(kvStorage_, nameGenerator_, 0);
+
+    // inode written without attribute, e.g. by old version
+    Inode inode = GenInode(1, 1);
+    inode.set_mode(777);
+    std::string skey = conv_->SerializeToString(Key4Inode(1, 1));
+    ASSERT_TRUE(
+        kvStorage_->HSet(nameGenerator_->GetInodeTableName(), skey, inode)
+            .ok());
+
+    InodeAttr attr;
+    ASSERT_EQ(storage.GetAttr(Key4Inode(1, 1), &attr), MetaStatusCode::OK);
+    ASSERT_EQ(attr.inodeid(), 1);
+    ASSERT_EQ(attr.mode(), 777);
+    ASSERT_EQ(attr.length(), 4096);
+}
+
 TEST_F(InodeStorageTest, testGetXAttr) {
     InodeStorage storage(kvStorage_, nameGenerator_, 0);
     Inode inode;
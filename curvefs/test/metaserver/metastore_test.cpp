@@ -592,6 +592,32 @@ TEST_F(MetastoreTest, test_inode) {
     ASSERT_EQ(getResponse4.inode().length(), length + 1);
     ASSERT_EQ(getResponse4.inode().nlink(), 100);
 
+    // batch update inodes, a failed update doesn't affect others
+    BatchUpdateInodeRequest batchUpdateRequest;
+    BatchUpdateInodeResponse batchUpdateResponse;
+    batchUpdateRequest.set_poolid(poolId);
+    batchUpdateRequest.set_copysetid(copysetId);
+    batchUpdateRequest.set_partitionid(partitionId);
+    batchUpdateRequest.set_fsid(fsId);
+    auto* update = batchUpdateRequest.add_updates();
+    *update = updateRequest2;
+    update->set_inodeid(createResponse.inode().inodeid() + 100);
+    update = batchUpdateRequest.add_updates();
+    *update = updateRequest2;
+    update->set_length(length + 2);
+    update->clear_nlink();
+    ret = metastore.BatchUpdateInode(&batchUpdateRequest, &batchUpdateResponse);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(batchUpdateResponse.statuses_size(), 2);
+    ASSERT_EQ(batchUpdateResponse.statuses(0), MetaStatusCode::NOT_FOUND);
+    ASSERT_EQ(batchUpdateResponse.statuses(1), MetaStatusCode::OK);
+
+    getResponse4.Clear();
+    ret = metastore.GetInode(&getRequest4, &getResponse4);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(getResponse4.inode().length(), length + 2);
+    ASSERT_EQ(getResponse4.inode().nlink(), 100);
+
     UpdateInodeRequest updateRequest3;
     UpdateInodeResponse updateResponse3;
     updateRequest3.set_poolid(poolId);
@@ -1477,6 +1503,112 @@ TEST_F(MetastoreTest, testBatchGetXAttr) {
     }
 }
 
+TEST_F(MetastoreTest, testListDentryPlus) {
+    MetaStoreImpl metastore(copyset_.get(), options_);
+    ASSERT_TRUE(metastore.InitStorage());
+
+    // create partition1
+    CreatePartitionRequest createPartitionRequest;
+    CreatePartitionResponse createPartitionResponse;
+    PartitionInfo partitionInfo1;
+    partitionInfo1.set_fsid(1);
+    partitionInfo1.set_poolid(2);
+    partitionInfo1.set_copysetid(3);
+    partitionInfo1.set_partitionid(1);
+    partitionInfo1.set_start(100);
+    partitionInfo1.set_end(1000);
+    createPartitionRequest.mutable_partition()->CopyFrom(partitionInfo1);
+    MetaStatusCode ret = metastore.CreatePartition(&createPartitionRequest,
+                                                   &createPartitionResponse);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+
+    uint32_t poolId = 2;
+    uint32_t copysetId = 3;
+    uint32_t partitionId = 1;
+    uint32_t fsId = 1;
+
+    // create parent and two files
+    CreateInodeRequest createInodeRequest;
+    CreateInodeResponse createInodeResponse;
+    createInodeRequest.set_poolid(poolId);
+    createInodeRequest.set_copysetid(copysetId);
+    createInodeRequest.set_partitionid(partitionId);
+    createInodeRequest.set_fsid(fsId);
+    createInodeRequest.set_length(0);
+    createInodeRequest.set_uid(100);
+    createInodeRequest.set_gid(200);
+    createInodeRequest.set_mode(777);
+    createInodeRequest.set_type(FsFileType::TYPE_DIRECTORY);
+    ret = metastore.CreateInode(&createInodeRequest, &createInodeResponse);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    uint64_t parentId = createInodeResponse.inode().inodeid();
+
+    std::vector<uint64_t> inodeIds;
+    createInodeRequest.set_type(FsFileType::TYPE_FILE);
+    for (uint64_t length : {10, 20}) {
+        createInodeRequest.set_length(length);
+        ret = metastore.CreateInode(&createInodeRequest, &createInodeResponse);
+        ASSERT_EQ(ret, MetaStatusCode::OK);
+        inodeIds.push_back(createInodeResponse.inode().inodeid());
+    }
+    // inode of the last dentry is in other partition
+    inodeIds.push_back(2000);
+
+    CreateDentryRequest createRequest;
+    CreateDentryResponse createResponse;
+    createRequest.set_poolid(poolId);
+    createRequest.set_copysetid(copysetId);
+    createRequest.set_partitionid(partitionId);
+    for (size_t i = 0; i < inodeIds.size(); i++) {
+        Dentry dentry;
+        dentry.set_fsid(fsId);
+        dentry.set_inodeid(inodeIds[i]);
+        dentry.set_parentinodeid(parentId);
+        dentry.set_name("file" + std::to_string(i));
+        dentry.set_txid(0);
+        dentry.set_type(FsFileType::TYPE_FILE);
+        createRequest.mutable_dentry()->CopyFrom(dentry);
+        ret = metastore.CreateDentry(&createRequest, &createResponse);
+        ASSERT_EQ(ret, MetaStatusCode::OK);
+    }
+
+    ListDentryPlusRequest listRequest;
+    ListDentryPlusResponse listResponse;
+    listRequest.set_poolid(poolId);
+    listRequest.set_copysetid(copysetId);
+    listRequest.set_partitionid(666);
+    listRequest.set_fsid(fsId);
+    listRequest.set_dirinodeid(parentId);
+    listRequest.set_txid(0);
+
+    // wrong partitionid
+    ret = metastore.ListDentryPlus(&listRequest, &listResponse);
+    ASSERT_EQ(ret, MetaStatusCode::PARTITION_NOT_FOUND);
+    ASSERT_EQ(listResponse.statuscode(), ret);
+
+    listRequest.set_partitionid(partitionId);
+    ret = metastore.ListDentryPlus(&listRequest, &listResponse);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(listResponse.entries_size(), 3);
+    ASSERT_TRUE(listResponse.entries(0).has_attr());
+    ASSERT_EQ(listResponse.entries(0).attr().inodeid(), inodeIds[0]);
+    ASSERT_EQ(listResponse.entries(0).attr().length(), 10);
+    ASSERT_TRUE(listResponse.entries(1).has_attr());
+    ASSERT_EQ(listResponse.entries(1).attr().length(), 20);
+    ASSERT_EQ(listResponse.entries(2).dentry().inodeid(), 2000);
+    ASSERT_FALSE(listResponse.entries(2).has_attr());
+
+    // list by page
+    listRequest.set_last("file0");
+    listRequest.set_count(1);
+    listResponse.Clear();
+    ret = metastore.ListDentryPlus(&listRequest, &listResponse);
+    ASSERT_EQ(ret, MetaStatusCode::OK);
+    ASSERT_EQ(listResponse.entries_size(), 1);
+    ASSERT_EQ(listResponse.entries(0).dentry().name(), "file1");
+    ASSERT_EQ(listResponse.entries(0).attr().inodeid(), inodeIds[1]);
+}
+
 TEST_F(MetastoreTest, GetOrModifyS3ChunkInfo) {
     MetaStoreImpl metastore(copyset_.get(), options_);
     ASSERT_TRUE(metastore.InitStorage());
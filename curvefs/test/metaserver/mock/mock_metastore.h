@@ -67,6 +67,16 @@ class MockMetaStore : public curvefs::metaserver::MetaStore {
     MOCK_METHOD2(CreateManageInode,
                 MetaStatusCode(const CreateManageInodeRequest*,
                                                  CreateManageInodeResponse*));
+    MOCK_METHOD2(CreateNode, MetaStatusCode(const CreateNodeRequest*,
+                                            CreateNodeResponse*));
+    MOCK_METHOD2(ListDentryPlus, MetaStatusCode(const ListDentryPlusRequest*,
+                                                ListDentryPlusResponse*));
+    MOCK_METHOD3(SendDentryPlusByStream,
+                 MetaStatusCode(StreamConnection*,
+                                const ListDentryPlusRequest*,
+                                DentryPlusList*));
+    MOCK_METHOD2(AllocInodeId, MetaStatusCode(const AllocInodeIdRequest*,
+                                              AllocInodeIdResponse*));
     MOCK_METHOD2(GetInode,
                  MetaStatusCode(const GetInodeRequest*, GetInodeResponse*));
     MOCK_METHOD2(BatchGetInodeAttr,
@@ -79,6 +89,9 @@ class MockMetaStore : public curvefs::metaserver::MetaStore {
                                              DeleteInodeResponse*));
     MOCK_METHOD2(UpdateInode, MetaStatusCode(const UpdateInodeRequest*,
                                              UpdateInodeResponse*));
+    MOCK_METHOD2(BatchUpdateInode,
+                 MetaStatusCode(const BatchUpdateInodeRequest*,
+                                BatchUpdateInodeResponse*));
 
     MOCK_METHOD2(PrepareRenameTx, MetaStatusCode(const PrepareRenameTxRequest*,
                                                  PrepareRenameTxResponse*));
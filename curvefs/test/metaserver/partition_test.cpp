@@ -436,5 +436,168 @@ TEST_F(PartitionTest, testGetXAttr) {
     ASSERT_EQ(xattr.xattrinfos().find(XATTRFBYTES)->second, "0");
 }
 
+TEST_F(PartitionTest, testCreateNode) {
+    PartitionInfo partitionInfo1;
+    partitionInfo1.set_fsid(1);
+    partitionInfo1.set_poolid(2);
+    partitionInfo1.set_copysetid(3);
+    partitionInfo1.set_partitionid(4);
+    partitionInfo1.set_start(100);
+    partitionInfo1.set_end(102);
+
+    Partition partition1(partitionInfo1, kvStorage_);
+
+    // create parent inode
+    Inode parent;
+    param_.type = FsFileType::TYPE_DIRECTORY;
+    ASSERT_EQ(partition1.CreateInode(param_, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.inodeid(), 100);
+    ASSERT_EQ(parent.nlink(), 2);
+
+    Dentry dentry;
+    dentry.set_fsid(1);
+    dentry.set_inodeid(0);
+    dentry.set_parentinodeid(100);
+    dentry.set_name("dir");
+    dentry.set_txid(0);
+    dentry.set_type(FsFileType::TYPE_DIRECTORY);
+
+    // 1. create inode, dentry and update parent together
+    struct timespec now{123, 456};
+    param_.parent = 100;
+    param_.timestamp = now;
+    Inode inode;
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, now, &inode),
+              MetaStatusCode::OK);
+    ASSERT_EQ(inode.inodeid(), 101);
+    ASSERT_EQ(inode.mtime(), 123);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+
+    Dentry out = dentry;
+    ASSERT_EQ(partition1.GetDentry(&out), MetaStatusCode::OK);
+    ASSERT_EQ(out.inodeid(), 101);
+
+    ASSERT_EQ(partition1.GetInode(1, 100, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.nlink(), 3);
+    ASSERT_EQ(parent.mtime(), 123);
+    ASSERT_EQ(parent.mtime_ns(), 456);
+    ASSERT_EQ(parent.ctime(), 123);
+    ASSERT_EQ(parent.ctime_ns(), 456);
+
+    // 2. dentry exist, nothing is created except the allocated inode id
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, now, &inode),
+              MetaStatusCode::DENTRY_EXIST);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+    ASSERT_EQ(partition1.GetInode(1, 100, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.nlink(), 3);
+
+    // 3. no free inode id
+    dentry.set_name("file");
+    dentry.set_type(FsFileType::TYPE_FILE);
+    param_.type = FsFileType::TYPE_FILE;
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, now, &inode),
+              MetaStatusCode::PARTITION_ALLOC_ID_FAIL);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+
+    // 4. dentry refers to an inode of other partition
+    dentry.set_inodeid(200);
+    ASSERT_EQ(partition1.CreateNode(dentry, absl::nullopt, now, &inode),
+              MetaStatusCode::OK);
+    ASSERT_EQ(partition1.GetDentryNum(), 2);
+    ASSERT_EQ(partition1.GetInode(1, 100, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.nlink(), 3);
+
+    // retry is idempotent
+    ASSERT_EQ(partition1.CreateNode(dentry, absl::nullopt, now, &inode),
+              MetaStatusCode::OK);
+    ASSERT_EQ(partition1.GetDentryNum(), 2);
+}
+
+TEST_F(PartitionTest, testAllocInodeId) {
+    PartitionInfo partitionInfo1;
+    partitionInfo1.set_fsid(1);
+    partitionInfo1.set_poolid(2);
+    partitionInfo1.set_copysetid(3);
+    partitionInfo1.set_partitionid(4);
+    partitionInfo1.set_start(100);
+    partitionInfo1.set_end(199);
+
+    Partition partition1(partitionInfo1, kvStorage_);
+
+    Inode parent;
+    param_.type = FsFileType::TYPE_DIRECTORY;
+    ASSERT_EQ(partition1.CreateInode(param_, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.inodeid(), 100);
+
+    uint64_t start = 0;
+    uint32_t count = 0;
+    ASSERT_EQ(partition1.AllocInodeId(2, 10, &start, &count),
+              MetaStatusCode::PARTITION_ID_MISSMATCH);
+    ASSERT_EQ(partition1.AllocInodeId(1, 0, &start, &count),
+              MetaStatusCode::PARAM_ERROR);
+    ASSERT_EQ(partition1.AllocInodeId(1, 10, &start, &count),
+              MetaStatusCode::OK);
+    ASSERT_EQ(start, 101);
+    ASSERT_EQ(count, 10);
+
+    // create node with leased inode id
+    Dentry dentry;
+    dentry.set_fsid(1);
+    dentry.set_inodeid(105);
+    dentry.set_parentinodeid(100);
+    dentry.set_name("file");
+    dentry.set_txid(0);
+    dentry.set_type(FsFileType::TYPE_FILE);
+    param_.type = FsFileType::TYPE_FILE;
+    param_.parent = 100;
+    struct timespec now{123, 456};
+    param_.timestamp = now;
+    Inode inode;
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, now, &inode),
+              MetaStatusCode::OK);
+    ASSERT_EQ(inode.inodeid(), 105);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    ASSERT_EQ(partition1.GetInode(1, 100, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.mtime(), 123);
+
+    // retry is idempotent, and returns the inode created before
+    Inode retried;
+    struct timespec later{789, 0};
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, later, &retried),
+              MetaStatusCode::OK);
+    ASSERT_EQ(retried.inodeid(), 105);
+    ASSERT_EQ(retried.type(), FsFileType::TYPE_FILE);
+    ASSERT_EQ(retried.mtime(), 123);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+    ASSERT_EQ(partition1.GetInode(1, 100, &parent), MetaStatusCode::OK);
+    ASSERT_EQ(parent.mtime(), 123);
+
+    // other inode id with the same name still conflicts
+    dentry.set_inodeid(106);
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, now, &inode),
+              MetaStatusCode::DENTRY_EXIST);
+    ASSERT_EQ(partition1.GetInodeNum(), 2);
+    dentry.set_inodeid(105);
+
+    // inode id isn't leased
+    dentry.set_name("file2");
+    dentry.set_inodeid(111);
+    ASSERT_EQ(partition1.CreateNode(dentry, param_, now, &inode),
+              MetaStatusCode::PARAM_ERROR);
+    ASSERT_EQ(partition1.GetDentryNum(), 1);
+
+    // the lease is cut at the end of partition
+    ASSERT_EQ(partition1.AllocInodeId(1, 1000, &start, &count),
+              MetaStatusCode::OK);
+    ASSERT_EQ(start, 111);
+    ASSERT_EQ(count, 89);
+    ASSERT_EQ(partition1.AllocInodeId(1, 10, &start, &count),
+              MetaStatusCode::PARTITION_ALLOC_ID_FAIL);
+    ASSERT_EQ(partition1.GetStatus(), PartitionStatus::READONLY);
+}
+
 }  // namespace metaserver
 }  // namespace curvefs
@@ -29,7 +29,9 @@
 #include <unistd.h>
 
 #include <memory>
+#include <thread>
 
+#include "curvefs/src/metaserver/storage/converter.h"
 #include "curvefs/src/metaserver/storage/storage.h"
 #include "curvefs/src/metaserver/storage/utils.h"
 #include "curvefs/test/metaserver/storage/storage_test.h"
@@ -90,6 +92,35 @@ class RocksDBStorageTest : public testing::Test {
         return true;
     }
 
+    // put a key into the unordered column family like old versions do
+    bool PutLegacyKey(const std::string& name, const std::string& key,
+                      const Dentry& value) {
+        auto storage = std::dynamic_pointer_cast<RocksDBStorage>(kvStorage_);
+        std::string svalue;
+        if (!value.SerializeToString(&svalue)) {
+            return false;
+        }
+        return storage->db_->Put(storage->dbWriteOptions_,
+                                 storage->handles_[kUnorderedColumnFamily],
+                                 storage->ToInternalKey(name, key, false),
+                                 svalue).ok();
+    }
+
+    bool HasMigratedMarker() {
+        auto storage = std::dynamic_pointer_cast<RocksDBStorage>(kvStorage_);
+        std::string value;
+        return storage->db_->Get(storage->dbReadOptions_,
+                                 storage->handles_[kUnorderedColumnFamily],
+                                 "column_families_migrated", &value).ok();
+    }
+
+    bool DeleteMigratedMarker() {
+        auto storage = std::dynamic_pointer_cast<RocksDBStorage>(kvStorage_);
+        return storage->db_->Delete(storage->dbWriteOptions_,
+                                    storage->handles_[kUnorderedColumnFamily],
+                                    "column_families_migrated").ok();
+    }
+
  protected:
     std::string dirname_;
     std::string dbpath_;
@@ -294,6 +325,212 @@ TEST_F(RocksDBStorageTest, TestCheckpointAndRecover) {
     EXPECT_EQ(Value("7"), dummyDentry);
 }
 
+TEST_F(RocksDBStorageTest, TestWriteBatch) {
+    Dentry value;
+    ASSERT_TRUE(kvStorage_->BeginWriteBatch());
+    ASSERT_TRUE(kvStorage_->SSet("partition:1", "key1", Value("1")).ok());
+    ASSERT_TRUE(kvStorage_->HSet("partition:1", "key2", Value("2")).ok());
+
+    // nested transaction rollback only discards its own writes
+    auto txn = kvStorage_->BeginTransaction();
+    ASSERT_NE(txn, nullptr);
+    ASSERT_TRUE(txn->SSet("partition:1", "key3", Value("3")).ok());
+    ASSERT_TRUE(txn->SGet("partition:1", "key1", &value).ok());
+    ASSERT_EQ(value, Value("1"));
+    ASSERT_TRUE(txn->Rollback().ok());
+
+    // pending writes are visible to current thread only
+    ASSERT_TRUE(kvStorage_->SGet("partition:1", "key1", &value).ok());
+    ASSERT_EQ(value, Value("1"));
+    std::thread([this]() {
+        Dentry value;
+        auto s = kvStorage_->SGet("partition:1", "key1", &value);
+        ASSERT_TRUE(s.IsNotFound());
+    }).join();
+
+    // nested batch is merged into the outermost one
+    ASSERT_TRUE(kvStorage_->BeginWriteBatch());
+    ASSERT_TRUE(kvStorage_->SDel("partition:1", "key1").ok());
+    ASSERT_TRUE(kvStorage_->SSet("partition:1", "key4", Value("4")).ok());
+    ASSERT_TRUE(kvStorage_->CommitWriteBatch().ok());
+    std::thread([this]() {
+        Dentry value;
+        auto s = kvStorage_->SGet("partition:1", "key4", &value);
+        ASSERT_TRUE(s.IsNotFound());
+    }).join();
+
+    ASSERT_TRUE(kvStorage_->CommitWriteBatch().ok());
+    std::thread([this]() {
+        Dentry value;
+        ASSERT_TRUE(kvStorage_->SGet("partition:1", "key1", &value)
+                        .IsNotFound());
+        ASSERT_TRUE(kvStorage_->HGet("partition:1", "key2", &value).ok());
+        ASSERT_EQ(value, Value("2"));
+        ASSERT_TRUE(kvStorage_->SGet("partition:1", "key3", &value)
+                        .IsNotFound());
+        ASSERT_TRUE(kvStorage_->SGet("partition:1", "key4", &value).ok());
+        ASSERT_EQ(value, Value("4"));
+    }).join();
+}
+
+TEST_F(RocksDBStorageTest, TestWriteBatchGuard) {
+    auto checkKey = [this](const std::string& key, bool exist) {
+        std::thread([&]() {
+            Dentry value;
+            auto s = kvStorage_->SGet("partition:1", key, &value);
+            ASSERT_EQ(s.ok(), exist);
+        }).join();
+    };
+
+    {
+        WriteBatchGuard guard(kvStorage_);
+        ASSERT_TRUE(kvStorage_->SSet("partition:1", "key1", Value("1")).ok());
+        {
+            // nested guard is merged into the outermost one
+            WriteBatchGuard nested(kvStorage_);
+            ASSERT_TRUE(
+                kvStorage_->SSet("partition:1", "key2", Value("2")).ok());
+            ASSERT_TRUE(nested.Commit().ok());
+        }
+        checkKey("key2", false);
+
+        // writes are visible once Commit() returns
+        ASSERT_TRUE(guard.Commit().ok());
+        checkKey("key1", true);
+        checkKey("key2", true);
+
+        // commit twice is a no-op
+        ASSERT_TRUE(guard.Commit().ok());
+    }
+
+    // the guard commits in its destructor if Commit() isn't called
+    {
+        WriteBatchGuard guard(kvStorage_);
+        ASSERT_TRUE(kvStorage_->SSet("partition:1", "key3", Value("3")).ok());
+    }
+    checkKey("key3", true);
+}
+
+TEST_F(RocksDBStorageTest, TestWriteBatchGuardCommitFail) {
+    class FailCommitStorage : public RocksDBStorage {
+     public:
+        explicit FailCommitStorage(StorageOptions options)
+            : RocksDBStorage(options) {}
+
+        Status CommitWriteBatch() override {
+            commits++;
+            RocksDBStorage::CommitWriteBatch();
+            return Status::InternalError();
+        }
+
+        int commits = 0;
+    };
+
+    StorageOptions options = options_;
+    options.dataDir = dirname_ + "/fail.db";
+    auto storage = std::make_shared<FailCommitStorage>(options);
+    ASSERT_TRUE(storage->Open());
+    {
+        WriteBatchGuard guard(storage);
+        ASSERT_TRUE(storage->SSet("partition:1", "key1", Value("1")).ok());
+        ASSERT_TRUE(guard.Commit().IsInternalError());
+    }
+    // the destructor doesn't commit again
+    ASSERT_EQ(storage->commits, 1);
+    ASSERT_TRUE(storage->Close());
+}
+
+TEST_F(RocksDBStorageTest, TestIteratorInWriteBatch) {
+    ASSERT_TRUE(kvStorage_->BeginWriteBatch());
+    ASSERT_TRUE(kvStorage_->SSet("partition:1", "key1", Value("1")).ok());
+    ASSERT_TRUE(kvStorage_->SSet("partition:1", "key2", Value("2")).ok());
+
+    // iterator inside a nested transaction sees pending writes
+    auto txn = kvStorage_->BeginTransaction();
+    ASSERT_TRUE(txn->SSet("partition:1", "key3", Value("3")).ok());
+    {
+        auto iterator = txn->SSeek("partition:1", "key");
+        size_t size = 0;
+        for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+            size++;
+        }
+        ASSERT_EQ(size, 3);
+    }
+    ASSERT_TRUE(txn->Commit().ok());
+
+    // iterator of the storage flushes pending writes first,
+    // so it's still valid after the batch committed
+    auto iterator = kvStorage_->SSeek("partition:1", "key");
+    ASSERT_TRUE(kvStorage_->CommitWriteBatch().ok());
+    size_t size = 0;
+    for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+        size++;
+    }
+    ASSERT_EQ(size, 3);
+}
+
+TEST_F(RocksDBStorageTest, TestTableColumnFamily) {
+    NameGenerator nameGenerator(1);
+    std::vector<std::string> tables{
+        nameGenerator.GetInodeTableName(),
+        nameGenerator.GetDentryTableName(),
+        nameGenerator.GetS3ChunkInfoTableName(),
+        nameGenerator.GetVolumeExtentTableName(),
+        nameGenerator.GetDeallocatableInodeTableName(),
+    };
+
+    // same keys in different tables don't conflict
+    for (size_t i = 0; i < tables.size(); i++) {
+        for (const auto& key : {"1:1:1:a", "1:1:1:b", "1:1:2:a"}) {
+            auto value = Value(std::to_string(i) + key);
+            ASSERT_TRUE(kvStorage_->SSet(tables[i], key, value).ok());
+        }
+    }
+
+    for (size_t i = 0; i < tables.size(); i++) {
+        Dentry value;
+        ASSERT_TRUE(kvStorage_->SGet(tables[i], "1:1:1:b", &value).ok());
+        ASSERT_EQ(value, Value(std::to_string(i) + "1:1:1:b"));
+
+        // seek by inode prefix
+        auto iterator = kvStorage_->SSeek(tables[i], "1:1:1:");
+        std::vector<std::string> keys;
+        for (iterator->SeekToFirst(); iterator->Valid(); iterator->Next()) {
+            keys.push_back(iterator->Key());
+        }
+        ASSERT_EQ(keys, (std::vector<std::string>{"1:1:1:a", "1:1:1:b"}));
+
+        ASSERT_EQ(kvStorage_->SSize(tables[i]), 3);
+        ASSERT_TRUE(kvStorage_->SClear(tables[i]).ok());
+        ASSERT_EQ(kvStorage_->SSize(tables[i]), 0);
+    }
+}
+
+TEST_F(RocksDBStorageTest, TestMigrateColumnFamiliesOnce) {
+    NameGenerator nameGenerator(1);
+    std::string table = nameGenerator.GetInodeTableName();
+    ASSERT_TRUE(HasMigratedMarker());
+
+    // migrated databases are not scanned again
+    ASSERT_TRUE(PutLegacyKey(table, "1:1", Value("1")));
+    std::vector<std::string> files;
+    ASSERT_TRUE(kvStorage_->Checkpoint(dirname_, &files));
+    ASSERT_TRUE(kvStorage_->Recover(dirname_));
+    Dentry value;
+    ASSERT_TRUE(kvStorage_->SGet(table, "1:1", &value).IsNotFound());
+
+    // databases of old versions are migrated
+    std::string ret;
+    std::string dir = dirname_ + "/old";
+    ASSERT_TRUE(ExecShell("mkdir -p " + dir, &ret));
+    ASSERT_TRUE(DeleteMigratedMarker());
+    ASSERT_TRUE(kvStorage_->Checkpoint(dir, &files));
+    ASSERT_TRUE(kvStorage_->Recover(dir));
+    ASSERT_TRUE(kvStorage_->SGet(table, "1:1", &value).ok());
+    ASSERT_EQ(value, Value("1"));
+    ASSERT_TRUE(HasMigratedMarker());
+}
+
 }  // namespace storage
 }  // namespace metaserver
 }  // namespace curvefs
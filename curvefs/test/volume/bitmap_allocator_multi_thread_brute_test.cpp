@@ -178,7 +178,24 @@ INSTANTIATE_TEST_CASE_P(
         std::make_pair(32, BitmapAllocatorOption{.startOffset = 50 * kGiB,
                                                  .length = 100 * kTiB,
                                                  .sizePerBit = 16 * kMiB,
-                                                 .smallAllocProportion = 1})));
+                                                 .smallAllocProportion = 1}),
+
+        // multiple allocation groups
+        std::make_pair(8, BitmapAllocatorOption{.startOffset = 100 * kGiB,
+                                                .length = 100 * kGiB,
+                                                .sizePerBit = 4 * kMiB,
+                                                .smallAllocProportion = 0,
+                                                .allocGroups = 8}),
+        std::make_pair(8, BitmapAllocatorOption{.startOffset = 100 * kGiB,
+                                                .length = 100 * kGiB,
+                                                .sizePerBit = 4 * kMiB,
+                                                .smallAllocProportion = 0.2,
+                                                .allocGroups = 8}),
+        std::make_pair(32, BitmapAllocatorOption{.startOffset = 50 * kGiB,
+                                                 .length = 100 * kTiB,
+                                                 .sizePerBit = 16 * kMiB,
+                                                 .smallAllocProportion = 0.2,
+                                                 .allocGroups = 64})));
 
 }  // namespace volume
 }  // namespace curvefs
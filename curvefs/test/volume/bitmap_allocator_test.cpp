@@ -306,5 +306,44 @@ TEST_F(BitmapAllocatorTest, TestAllocSmallWithHint) {
     }
 }
 
+TEST_F(BitmapAllocatorTest, TestAllocGroups) {
+    opt_.smallAllocProportion = 0;
+    opt_.allocGroups = 4;
+    allocator_.reset(new BitmapAllocator(opt_));
+
+    // 10GiB / 4MiB = 2560 bits, 640 bits per group
+    const uint64_t groupSize = 640 * opt_.sizePerBit;
+
+    // allocations with hint go to the group of hint
+    for (uint64_t i = 0; i < 4; ++i) {
+        Extents exts;
+        AllocateHint hint;
+        hint.leftOffset = opt_.startOffset + i * groupSize;
+        ASSERT_EQ(opt_.sizePerBit,
+                  allocator_->Alloc(opt_.sizePerBit, hint, &exts));
+        ASSERT_EQ(1, exts.size());
+        ASSERT_EQ(hint.leftOffset, exts[0].offset);
+    }
+
+    // allocations of one thread go to the same group until it's full
+    Extents exts;
+    ASSERT_EQ(2 * opt_.sizePerBit,
+              allocator_->Alloc(2 * opt_.sizePerBit, {}, &exts));
+    ASSERT_EQ(2, exts.size());
+    ASSERT_EQ(exts[0].offset / groupSize, exts[1].offset / groupSize);
+
+    // all space can be allocated across groups
+    uint64_t available = allocator_->AvailableSize();
+    ASSERT_EQ(available, allocator_->Alloc(available, {}, &exts));
+    ASSERT_EQ(0, allocator_->AvailableSize());
+
+    exts.clear();
+    allocator_.reset(new BitmapAllocator(opt_));
+    ASSERT_EQ(opt_.length, allocator_->Alloc(opt_.length, {}, &exts));
+    ASSERT_TRUE(ExtentsContinuous(exts));
+    allocator_->DeAlloc(exts);
+    ASSERT_EQ(opt_.length, allocator_->AvailableSize());
+}
+
 }  // namespace volume
 }  // namespace curvefs
@@ -35,6 +35,7 @@
 #include "src/chunkserver/chunkserver_metrics.h"
 #include "src/chunkserver/op_request.h"
 #include "src/chunkserver/chunk_service_closure.h"
+#include "src/chunkserver/volume_qos.h"
 #include "src/common/fast_align.h"
 
 #include "include/curve_compiler_specific.h"
@@ -50,6 +51,7 @@ ChunkServiceImpl::ChunkServiceImpl(
     : chunkServiceOptions_(chunkServiceOptions),
       copysetNodeManager_(chunkServiceOptions.copysetNodeManager),
       inflightThrottle_(chunkServiceOptions.inflightThrottle),
+      volumeQos_(chunkServiceOptions.volumeQos),
       epochMap_(epochMap),
       blockSize_(copysetNodeManager_->GetCopysetNodeOptions().blockSize) {
     maxChunkSize_ = copysetNodeManager_->GetCopysetNodeOptions().maxChunkSize;
@@ -160,7 +162,7 @@ void ChunkServiceImpl::WriteChunk(RpcController *controller,
                                                   request,
                                                   response,
                                                   doneGuard.release());
-    req->Process();
+    ProcessByVolumeQos(closure, request, response, req);
 }
 
 void ChunkServiceImpl::CreateCloneChunk(RpcController *controller,
@@ -271,7 +273,35 @@ void ChunkServiceImpl::ReadChunk(RpcController *controller,
                                            request,
                                            response,
                                            doneGuard.release());
-    req->Process();
+    ProcessByVolumeQos(closure, request, response, req);
+}
+
+void ChunkServiceImpl::ProcessByVolumeQos(ChunkServiceClosure *closure,
+                                          const ChunkRequest *request,
+                                          ChunkResponse *response,
+                                          std::shared_ptr<ChunkOpRequest> req) {
+    // requests of old clients don't carry the file id, they can't be
+    // accounted to any volume
+    if (nullptr == volumeQos_ || !volumeQos_->Enabled() ||
+        !request->has_fileid()) {
+        req->Process();
+        return;
+    }
+
+    // 在请求返回时通知调度器，需要在提交之前设置
+    closure->SetVolumeQos(volumeQos_);
+    if (volumeQos_->Submit(request->fileid(), request->size(),
+                           [req]() { req->Process(); })) {
+        return;
+    }
+
+    // 该卷排队的请求过多，此时closure还没有被req使用，直接返回
+    closure->SetVolumeQos(nullptr);
+    response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
+    LOG_EVERY_N(WARNING, 100)
+        << "too many requests of volume " << request->fileid()
+        << " queued in chunkserver, op: " << request->optype();
+    closure->Run();
 }
 
 void ChunkServiceImpl::RecoverChunk(RpcController *controller,
@@ -38,6 +38,9 @@ using ::google::protobuf::RpcController;
 using ::google::protobuf::Closure;
 
 class CopysetNodeManager;
+class ChunkOpRequest;
+class ChunkServiceClosure;
+class VolumeQosScheduler;
 
 class ChunkServiceImpl : public ChunkService {
  public:
@@ -107,10 +110,23 @@ class ChunkServiceImpl : public ChunkService {
      */
     bool CheckRequestOffsetAndLength(uint32_t offset, uint32_t len) const;
 
+    /**
+     * 读写请求经过volume qos调度后再处理，卷排队的请求过多时返回overload
+     * @param closure[in]: 该请求的closure，已经交给了req
+     * @param request[in]: 读写请求
+     * @param response[in]: 读写请求的response
+     * @param req[in]: 待处理的op request
+     */
+    void ProcessByVolumeQos(ChunkServiceClosure *closure,
+                            const ChunkRequest *request,
+                            ChunkResponse *response,
+                            std::shared_ptr<ChunkOpRequest> req);
+
  private:
     ChunkServiceOptions chunkServiceOptions_;
     CopysetNodeManager  *copysetNodeManager_;
     std::shared_ptr<InflightThrottle> inflightThrottle_;
+    VolumeQosScheduler  *volumeQos_;
     uint32_t            maxChunkSize_;
 
     std::shared_ptr<EpochMap> epochMap_;
@@ -48,6 +48,9 @@ void ChunkServiceClosure::Run() {
     if (nullptr != inflightThrottle_) {
         inflightThrottle_->Decrement();
     }
+    if (nullptr != volumeQos_) {
+        volumeQos_->OnComplete();
+    }
 }
 
 void ChunkServiceClosure::OnRequest() {
@@ -29,6 +29,7 @@
 #include "proto/chunk.pb.h"
 #include "src/chunkserver/op_request.h"
 #include "src/chunkserver/inflight_throttle.h"
+#include "src/chunkserver/volume_qos.h"
 #include "src/common/timeutility.h"
 
 namespace curve {
@@ -46,7 +47,8 @@ class ChunkServiceClosure : public braft::Closure {
         , request_(request)
         , response_(response)
         , brpcDone_(done)
-        , receivedTimeUs_(common::TimeUtility::GetTimeofDayUs()) {
+        , receivedTimeUs_(common::TimeUtility::GetTimeofDayUs())
+        , volumeQos_(nullptr) {
             // closure创建的什么加1，closure调用的时候减1
             if (nullptr != inflightThrottle_) {
                 inflightThrottle_->Increment();
@@ -64,6 +66,13 @@ class ChunkServiceClosure : public braft::Closure {
      */
     void Run() override;
 
+    /**
+     * 请求经过volume qos调度，返回时通知调度器
+     */
+    void SetVolumeQos(VolumeQosScheduler* volumeQos) {
+        volumeQos_ = volumeQos;
+    }
+
  private:
     /**
      * 统计请求数量和速率
@@ -85,6 +94,8 @@ class ChunkServiceClosure : public braft::Closure {
     google::protobuf::Closure *brpcDone_;
     // 接受到请求的时间
     uint64_t receivedTimeUs_;
+    // 调度该请求的volume qos，为nullptr表示未经过调度
+    VolumeQosScheduler* volumeQos_;
 };
 
 }  // namespace chunkserver
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-19
+ */
+
+#include "src/chunkserver/chunk_tier_manager.h"
+
+#include <glog/logging.h>
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <vector>
+
+#include "src/chunkserver/copyset_node_manager.h"
+
+namespace curve {
+namespace chunkserver {
+
+int ChunkTierManager::Init(const ChunkTierManagerOptions& options) {
+    if (options.enable && (options.copysetNodeManager == nullptr ||
+                           options.scanIntervalSec == 0)) {
+        LOG(ERROR) << "Invalid chunk tier manager options, scan interval: "
+                   << options.scanIntervalSec;
+        return -1;
+    }
+    options_ = options;
+    return 0;
+}
+
+int ChunkTierManager::Run() {
+    if (!options_.enable) {
+        return 0;
+    }
+    if (isStop_.exchange(false)) {
+        migrateThread_ = Thread(&ChunkTierManager::MigrateWorker, this);
+        LOG(INFO) << "Start chunk tier manager thread ok.";
+    }
+    return 0;
+}
+
+int ChunkTierManager::Fini() {
+    if (!isStop_.exchange(true)) {
+        LOG(INFO) << "stop chunk tier manager...";
+        sleeper_.interrupt();
+        migrateThread_.join();
+        LOG(INFO) << "stop chunk tier manager ok.";
+    }
+    return 0;
+}
+
+uint32_t ChunkTierManager::MigrateOnce() {
+    std::vector<CopysetNodeManager::CopysetNodePtr> nodes;
+    options_.copysetNodeManager->GetAllCopysetNodes(&nodes);
+    if (nodes.empty()) {
+        return 0;
+    }
+
+    uint32_t migrated = 0;
+    uint32_t start = nextNode_++ % nodes.size();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const auto& node = nodes[(start + i) % nodes.size()];
+        std::shared_ptr<CSDataStore> dataStore = node->GetDataStore();
+        if (dataStore == nullptr) {
+            continue;
+        }
+        // 配额用完后仍然要衰减其余chunk的热度
+        migrated += dataStore->MigrateChunks(options_.tierOptions,
+            options_.maxMigrations > migrated ?
+            options_.maxMigrations - migrated : 0);
+    }
+    migratedNum_.fetch_add(migrated, std::memory_order_relaxed);
+    return migrated;
+}
+
+void ChunkTierManager::MigrateWorker() {
+    while (sleeper_.wait_for(
+        std::chrono::seconds(options_.scanIntervalSec))) {
+        uint32_t migrated = MigrateOnce();
+        LOG_IF(INFO, migrated > 0) << "Moved " << migrated
+                                   << " chunks between storage tiers.";
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
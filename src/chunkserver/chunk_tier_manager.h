@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-19
+ */
+
+#ifndef SRC_CHUNKSERVER_CHUNK_TIER_MANAGER_H_
+#define SRC_CHUNKSERVER_CHUNK_TIER_MANAGER_H_
+
+#include <cstdint>
+
+#include "src/chunkserver/datastore/chunkserver_datastore.h"
+#include "src/common/concurrent/concurrent.h"
+#include "src/common/interruptible_sleeper.h"
+
+namespace curve {
+namespace chunkserver {
+
+using ::curve::common::Atomic;
+using ::curve::common::InterruptibleSleeper;
+using ::curve::common::Thread;
+
+class CopysetNodeManager;
+
+struct ChunkTierManagerOptions {
+    // 是否开启冷热分层，即是否配置了容量层的chunk数据目录
+    bool enable = false;
+    // 衰减chunk热度并在存储层之间移动chunk的周期
+    uint32_t scanIntervalSec = 60;
+    // 每个周期最多移动的chunk数，所有copyset共享
+    uint32_t maxMigrations = 16;
+    // chunk移动的阈值
+    ChunkTierOptions tierOptions;
+    CopysetNodeManager* copysetNodeManager = nullptr;
+};
+
+/**
+ * 同一个chunkserver上快速层(如NVMe)和容量层(如HDD)之间的chunk分层，
+ * 周期性地把长时间未访问的chunk移动到容量层，把容量层上变热的chunk移回，
+ * 移动由各copyset的datastore完成，对chunk的读写透明
+ */
+class ChunkTierManager {
+ public:
+    ChunkTierManager() : isStop_(true), migratedNum_(0), nextNode_(0) {}
+    virtual ~ChunkTierManager() {}
+
+    int Init(const ChunkTierManagerOptions& options);
+
+    int Run();
+
+    int Fini();
+
+    /**
+     * @brief 扫描所有copyset一次，在存储层之间移动chunk
+     * @return 本次移动的chunk数
+     */
+    uint32_t MigrateOnce();
+
+    uint64_t GetMigratedNum() const {
+        return migratedNum_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    void MigrateWorker();
+
+ private:
+    ChunkTierManagerOptions options_;
+    Atomic<bool> isStop_;
+    Atomic<uint64_t> migratedNum_;
+    InterruptibleSleeper sleeper_;
+    Thread migrateThread_;
+    // 每轮从不同的copyset开始，避免移动的配额总是被前面的copyset用完
+    uint32_t nextNode_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_CHUNK_TIER_MANAGER_H_
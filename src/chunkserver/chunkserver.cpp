@@ -37,6 +37,7 @@
 #include "src/chunkserver/braft_cli_service.h"
 #include "src/chunkserver/braft_cli_service2.h"
 #include "src/chunkserver/chunkserver_helper.h"
+#include "src/chunkserver/datastore/chunkfile_fd_cache.h"
 #include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/uri_parser.h"
 #include "src/chunkserver/raftsnapshot/curve_snapshot_attachment.h"
@@ -294,9 +295,24 @@ int ChunkServer::Run(int argc, char** argv) {
     ScanManagerOptions scanOpts;
     InitScanOptions(&conf, &scanOpts);
     scanOpts.copysetNodeManager = copysetNodeManager_;
+    scanOpts.localFileSystem = fs;
     LOG_IF(FATAL, scanManager_.Init(scanOpts) != 0)
         << "Failed to init scan manager.";
 
+    // 冷热分层初始化
+    ChunkTierManagerOptions tierOptions;
+    InitChunkTierOptions(&conf, &tierOptions);
+    tierOptions.enable = !copysetNodeOptions.capacityDataUri.empty();
+    tierOptions.copysetNodeManager = copysetNodeManager_;
+    LOG_IF(FATAL, chunkTierManager_.Init(tierOptions) != 0)
+        << "Failed to init chunk tier manager.";
+
+    // volume qos初始化
+    VolumeQosOptions volumeQosOptions;
+    InitVolumeQosOptions(&conf, &volumeQosOptions);
+    LOG_IF(FATAL, volumeQos_.Init(volumeQosOptions) != 0)
+        << "Failed to init volume qos scheduler.";
+
     // 心跳模块初始化
     HeartbeatOptions heartbeatOptions;
     InitHeartbeatOptions(&conf, &heartbeatOptions);
@@ -306,11 +322,13 @@ int ChunkServer::Run(int argc, char** argv) {
     heartbeatOptions.chunkserverId = metadata.id();
     heartbeatOptions.chunkserverToken = metadata.token();
     heartbeatOptions.scanManager = &scanManager_;
+    heartbeatOptions.volumeQos = &volumeQos_;
     LOG_IF(FATAL, heartbeat_.Init(heartbeatOptions) != 0)
         << "Failed to init Heartbeat manager.";
 
     // 监控部分模块的metric指标
     metric->MonitorTrash(trash_.get());
+    metric->MonitorVolumeQos(&volumeQos_);
     metric->MonitorChunkFilePool(chunkfilePool.get());
     if (raftLogProtocol == kProtocalCurve && !useChunkFilePoolAsWalPool) {
         metric->MonitorWalFilePool(walFilePool.get());
@@ -344,6 +362,7 @@ int ChunkServer::Run(int argc, char** argv) {
     chunkServiceOptions.copysetNodeManager = copysetNodeManager_;
     chunkServiceOptions.cloneManager = &cloneManager_;
     chunkServiceOptions.inflightThrottle = inflightThrottle;
+    chunkServiceOptions.volumeQos = &volumeQos_;
 
     ChunkServiceImpl chunkService(chunkServiceOptions, epochMap);
     ret = server.AddService(&chunkService,
@@ -430,6 +449,8 @@ int ChunkServer::Run(int argc, char** argv) {
      */
     LOG_IF(FATAL, trash_->Run() != 0)
         << "Failed to start trash.";
+    LOG_IF(FATAL, volumeQos_.Run() != 0)
+        << "Failed to start volume qos scheduler.";
     LOG_IF(FATAL, cloneManager_.Run() != 0)
         << "Failed to start clone manager.";
     LOG_IF(FATAL, heartbeat_.Run() != 0)
@@ -438,6 +459,8 @@ int ChunkServer::Run(int argc, char** argv) {
         << "Failed to start CopysetNodeManager.";
     LOG_IF(FATAL, scanManager_.Run() != 0)
         << "Failed to start scan manager.";
+    LOG_IF(FATAL, chunkTierManager_.Run() != 0)
+        << "Failed to start chunk tier manager.";
     LOG_IF(FATAL, !chunkfilePool->StartCleaning())
         << "Failed to start file pool clean worker.";
 
@@ -449,6 +472,8 @@ int ChunkServer::Run(int argc, char** argv) {
     LOG(INFO) << "ChunkServer is going to quit.";
     LOG_IF(ERROR, scanManager_.Fini() != 0)
         << "Failed to shutdown scan manager.";
+    LOG_IF(ERROR, chunkTierManager_.Fini() != 0)
+        << "Failed to shutdown chunk tier manager.";
 
     if (registerOptions.enableExternalServer) {
         externalServer.Stop(0);
@@ -458,6 +483,9 @@ int ChunkServer::Run(int argc, char** argv) {
     server.Stop(0);
     server.Join();
 
+    LOG_IF(ERROR, volumeQos_.Fini() != 0)
+        << "Failed to shutdown volume qos scheduler.";
+
     LOG_IF(ERROR, heartbeat_.Fini() != 0)
         << "Failed to shutdown heartbeat manager.";
     LOG_IF(ERROR, copysetNodeManager_->Fini() != 0)
@@ -647,6 +675,30 @@ void ChunkServer::InitCopysetNodeOptions(
         LOG_IF(FATAL, !conf->GetUInt32Value("copyset.sync_trigger_seconds",
                 &copysetNodeOptions->syncTriggerSeconds));
     }
+
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.lazy_load_chunk",
+        &copysetNodeOptions->lazyLoadChunk));
+    uint64_t maxOpenChunkFiles = 0;
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.max_open_chunk_files",
+        &maxOpenChunkFiles));
+    if (maxOpenChunkFiles > 0) {
+        copysetNodeOptions->chunkFdCache =
+            std::make_shared<ChunkFdCache>(maxOpenChunkFiles);
+    }
+    LOG_IF(FATAL, !conf->GetStringValue("copyset.capacity_data_uri",
+        &copysetNodeOptions->capacityDataUri));
+}
+
+void ChunkServer::InitChunkTierOptions(
+    common::Configuration *conf, ChunkTierManagerOptions *tierOptions) {
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.tier_scan_interval_s",
+        &tierOptions->scanIntervalSec));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.tier_promote_heat",
+        &tierOptions->tierOptions.promoteHeat));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.tier_demote_idle_rounds",
+        &tierOptions->tierOptions.demoteIdleRounds));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.tier_max_migrations",
+        &tierOptions->maxMigrations));
 }
 
 void ChunkServer::InitCopyerOptions(
@@ -703,6 +755,12 @@ void ChunkServer::InitScanOptions(
         &scanOptions->retry));
     LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_rpc_retry_interval_us",
         &scanOptions->retryIntervalUs));
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_latency_threshold_us",
+        &scanOptions->latencyThresholdUs));
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_max_backoff_ms",
+        &scanOptions->maxBackoffMs));
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.scan_checkpoint_expire_sec",
+        &scanOptions->checkpointExpireSec));
 }
 
 void ChunkServer::InitHeartbeatOptions(
@@ -744,6 +802,23 @@ void ChunkServer::InitRegisterOptions(
         &registerOptions->registerTimeout));
 }
 
+void ChunkServer::InitVolumeQosOptions(
+    common::Configuration *conf, VolumeQosOptions *volumeQosOptions) {
+    LOG_IF(FATAL, !conf->GetBoolValue("chunkserver.volume_qos_enable",
+        &volumeQosOptions->enable));
+    LOG_IF(FATAL, !conf->GetUInt32Value("chunkserver.volume_qos_max_inflight",
+        &volumeQosOptions->maxInflight));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "chunkserver.volume_qos_default_weight",
+        &volumeQosOptions->defaultWeight));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "chunkserver.volume_qos_cost_unit_bytes",
+        &volumeQosOptions->costUnitBytes));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "chunkserver.volume_qos_max_queue_depth",
+        &volumeQosOptions->maxQueueDepth));
+}
+
 void ChunkServer::InitTrashOptions(
     common::Configuration *conf, TrashOptions *trashOptions) {
     LOG_IF(FATAL, !conf->GetStringValue(
@@ -752,6 +827,14 @@ void ChunkServer::InitTrashOptions(
         "trash.expire_afterSec", &trashOptions->expiredAfterSec));
     LOG_IF(FATAL, !conf->GetIntValue(
         "trash.scan_periodSec", &trashOptions->scanPeriodSec));
+    LOG_IF(FATAL, !conf->GetIntValue(
+        "trash.recycle_threads", &trashOptions->recycleThreads));
+    LOG_IF(FATAL, !conf->GetIntValue(
+        "trash.recycle_batch_size", &trashOptions->recycleBatchSize));
+    LOG_IF(FATAL, !conf->GetIntValue(
+        "trash.max_recycle_per_sec", &trashOptions->maxRecyclePerSec));
+    LOG_IF(FATAL, !conf->GetUInt64Value(
+        "trash.pool_low_watermark", &trashOptions->poolLowWaterMark));
 }
 
 void ChunkServer::InitMetricOptions(
@@ -35,6 +35,8 @@
 #include "src/chunkserver/chunkserver_metrics.h"
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
 #include "src/chunkserver/scan_service.h"
+#include "src/chunkserver/volume_qos.h"
+#include "src/chunkserver/chunk_tier_manager.h"
 
 using ::curve::chunkserver::concurrent::ConcurrentApplyOption;
 
@@ -88,6 +90,12 @@ class ChunkServer {
     void InitTrashOptions(common::Configuration *conf,
         TrashOptions *trashOptions);
 
+    void InitVolumeQosOptions(common::Configuration *conf,
+        VolumeQosOptions *volumeQosOptions);
+
+    void InitChunkTierOptions(common::Configuration *conf,
+        ChunkTierManagerOptions *tierOptions);
+
     void InitMetricOptions(common::Configuration *conf,
         ChunkServerMetricOptions *metricOptions);
 
@@ -111,9 +119,15 @@ class ChunkServer {
     // scan copyset manager
     ScanManager scanManager_;
 
+    // chunkTierManager_ 在快速层和容量层之间移动冷热chunk
+    ChunkTierManager chunkTierManager_;
+
     // heartbeat_ 负责向mds定期发送心跳，并下发心跳中任务
     Heartbeat heartbeat_;
 
+    // volumeQos_ 按卷调度读写请求，qos设置由mds通过心跳下发
+    VolumeQosScheduler volumeQos_;
+
     // trash_ 定期回收垃圾站中的物理空间
     std::shared_ptr<Trash> trash_;
 
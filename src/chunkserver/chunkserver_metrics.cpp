@@ -200,12 +200,17 @@ void CSCopysetMetric::MonitorDataStore(CSDataStore *datastore) {
     std::string chunkCountPrefix = Prefix() + "_chunk_count";
     std::string snapshotCountPrefix = Prefix() + "snapshot_count";
     std::string cloneChunkCountPrefix = Prefix() + "_clonechunk_count";
+    std::string capacityChunkCountPrefix =
+        Prefix() + "_capacity_chunk_count";
     chunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         chunkCountPrefix, GetDatastoreChunkCountFunc, datastore);
     snapshotCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         snapshotCountPrefix, GetDatastoreSnapshotCountFunc, datastore);
     cloneChunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         cloneChunkCountPrefix, GetDatastoreCloneChunkCountFunc, datastore);
+    capacityChunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
+        capacityChunkCountPrefix, GetDatastoreCapacityChunkCountFunc,
+        datastore);
 }
 
 void CSCopysetMetric::MonitorCurveSegmentLogStorage(
@@ -217,7 +222,9 @@ void CSCopysetMetric::MonitorCurveSegmentLogStorage(
 
 ChunkServerMetric::ChunkServerMetric()
     : hasInited_(false), leaderCount_(nullptr), chunkLeft_(nullptr),
-      walSegmentLeft_(nullptr), chunkTrashed_(nullptr), chunkCount_(nullptr),
+      walSegmentLeft_(nullptr), chunkTrashed_(nullptr),
+      trashRecycled_(nullptr), trashRecycleRate_(nullptr),
+      volumeQosQueued_(nullptr), chunkCount_(nullptr),
       walSegmentCount_(nullptr), snapshotCount_(nullptr),
       cloneChunkCount_(nullptr) {}
 
@@ -284,6 +291,9 @@ int ChunkServerMetric::Fini() {
     chunkLeft_ = nullptr;
     walSegmentLeft_ = nullptr;
     chunkTrashed_ = nullptr;
+    trashRecycleRate_ = nullptr;
+    trashRecycled_ = nullptr;
+    volumeQosQueued_ = nullptr;
     chunkCount_ = nullptr;
     snapshotCount_ = nullptr;
     cloneChunkCount_ = nullptr;
@@ -399,6 +409,24 @@ void ChunkServerMetric::MonitorTrash(Trash *trash) {
     std::string chunkTrashedPrefix = Prefix() + "_chunk_trashed";
     chunkTrashed_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         chunkTrashedPrefix, GetChunkTrashedFunc, trash);
+
+    std::string trashRecycledPrefix = Prefix() + "_trash_recycled";
+    trashRecycled_ = std::make_shared<bvar::PassiveStatus<uint64_t>>(
+        trashRecycledPrefix, GetTrashRecycledFunc, trash);
+    std::string trashRecycleRatePrefix = Prefix() + "_trash_recycle_rate";
+    trashRecycleRate_ =
+        std::make_shared<bvar::PerSecond<bvar::PassiveStatus<uint64_t>>>(
+            trashRecycleRatePrefix, trashRecycled_.get());
+}
+
+void ChunkServerMetric::MonitorVolumeQos(VolumeQosScheduler *volumeQos) {
+    if (!option_.collectMetric) {
+        return;
+    }
+
+    std::string volumeQosQueuedPrefix = Prefix() + "_volume_qos_queued";
+    volumeQosQueued_ = std::make_shared<bvar::PassiveStatus<uint64_t>>(
+        volumeQosQueuedPrefix, GetVolumeQosQueuedFunc, volumeQos);
 }
 
 void ChunkServerMetric::IncreaseLeaderCount() {
@@ -50,6 +50,7 @@ class FilePool;
 class CSDataStore;
 class CurveSegmentLogStorage;
 class Trash;
+class VolumeQosScheduler;
 
 template <typename Tp>
 using PassiveStatusPtr = std::shared_ptr<bvar::PassiveStatus<Tp>>;
@@ -177,7 +178,7 @@ class CSCopysetMetric {
     CSCopysetMetric()
         : logicPoolId_(0), copysetId_(0), chunkCount_(nullptr),
           walSegmentCount_(nullptr), snapshotCount_(nullptr),
-          cloneChunkCount_(nullptr) {}
+          cloneChunkCount_(nullptr), capacityChunkCount_(nullptr) {}
 
     ~CSCopysetMetric() {}
 
@@ -257,6 +258,13 @@ class CSCopysetMetric {
         return cloneChunkCount_->get_value();
     }
 
+    uint32_t GetCapacityChunkCount() const {
+        if (capacityChunkCount_ == nullptr) {
+            return 0;
+        }
+        return capacityChunkCount_->get_value();
+    }
+
  private:
     inline std::string Prefix() {
         return "copyset_" + std::to_string(logicPoolId_) + "_" +
@@ -276,6 +284,8 @@ class CSCopysetMetric {
     PassiveStatusPtr<uint32_t> snapshotCount_;
     // copyset上的 clone chunk 的数量
     PassiveStatusPtr<uint32_t> cloneChunkCount_;
+    // copyset上移到容量层的 chunk 的数量
+    PassiveStatusPtr<uint32_t> capacityChunkCount_;
     // copyset上的IO类型的metric统计
     CSIOMetric ioMetrics_;
 };
@@ -437,6 +447,12 @@ class ChunkServerMetric : public Uncopyable {
      */
     void MonitorTrash(Trash *trash);
 
+    /**
+     * 监视volume qos，主要监视排队的请求数量
+     * @param volumeQos: volume qos调度器的对象指针
+     */
+    void MonitorVolumeQos(VolumeQosScheduler *volumeQos);
+
     /**
      * 增加 leader count 计数
      */
@@ -514,6 +530,12 @@ class ChunkServerMetric : public Uncopyable {
         return chunkTrashed_->get_value();
     }
 
+    uint64_t GetTrashRecycledCount() const {
+        if (trashRecycled_ == nullptr)
+            return 0;
+        return trashRecycled_->get_value();
+    }
+
  private:
     ChunkServerMetric();
 
@@ -534,6 +556,12 @@ class ChunkServerMetric : public Uncopyable {
     PassiveStatusPtr<uint32_t> walSegmentLeft_;
     // trash 中的 chunk 的数量
     PassiveStatusPtr<uint32_t> chunkTrashed_;
+    // trash 已回收到 filepool 的文件数量及回收速率
+    PassiveStatusPtr<uint64_t> trashRecycled_;
+    std::shared_ptr<bvar::PerSecond<bvar::PassiveStatus<uint64_t>>>
+        trashRecycleRate_;
+    // volume qos 中排队的请求数量
+    PassiveStatusPtr<uint64_t> volumeQosQueued_;
     // chunkserver上的 chunk 的数量
     PassiveStatusPtr<uint32_t> chunkCount_;
     // The total number of WAL segment in chunkserver
@@ -39,8 +39,10 @@ using curve::fs::LocalFileSystem;
 using curve::chunkserver::concurrent::ConcurrentApplyModule;
 
 class FilePool;
+class ChunkFdCache;
 class CopysetNodeManager;
 class CloneManager;
+class VolumeQosScheduler;
 
 /**
  * copyset node的配置选项
@@ -141,6 +143,13 @@ struct CopysetNodeOptions {
     // check syncing interval
     uint32_t checkSyncingIntervalMs = 500u;
 
+    // 启动时只记录chunk id，chunk文件在第一次访问时才打开
+    bool lazyLoadChunk = false;
+    // 所有copyset共享的chunk文件fd缓存，为nullptr表示不限制打开的文件数
+    std::shared_ptr<ChunkFdCache> chunkFdCache;
+    // 容量层(如HDD)上的chunk数据uri，冷chunk移动到这里，为空表示不开启分层
+    std::string capacityDataUri;
+
     CopysetNodeOptions();
 };
 
@@ -151,6 +160,8 @@ struct ChunkServiceOptions {
     CopysetNodeManager *copysetNodeManager;
     CloneManager *cloneManager;
     std::shared_ptr<InflightThrottle> inflightThrottle;
+    // schedules read/write requests among volumes, may be nullptr
+    VolumeQosScheduler *volumeQos = nullptr;
 };
 
 inline CopysetNodeOptions::CopysetNodeOptions()
@@ -37,6 +37,7 @@
 #include <set>
 #include <chrono>
 #include <condition_variable>
+#include <mutex>
 
 #include "src/chunkserver/raftsnapshot/curve_filesystem_adaptor.h"
 #include "src/chunkserver/chunk_closure.h"
@@ -46,6 +47,7 @@
 #include "src/chunkserver/copyset_node_manager.h"
 #include "src/chunkserver/datastore/define.h"
 #include "src/chunkserver/datastore/datastore_file_helper.h"
+#include "src/chunkserver/datastore/filename_operator.h"
 #include "src/common/uri_parser.h"
 #include "src/common/crc32.h"
 #include "src/common/fs_util.h"
@@ -127,6 +129,18 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
 
     chunkDataRpath_ = RAFT_DATA_DIR;
     chunkDataApath_.append("/").append(RAFT_DATA_DIR);
+
+    // 初始化datastore的同时由内核预读wal，raft node初始化时
+    // load segments可以直接从page cache中读取
+    if (FLAGS_raftLogPrefetchOnLoad) {
+        std::string logPath;
+        curve::common::UriParser::ParseUri(options.logUri, &logPath);
+        logPath.append("/").append(groupId).append("/").append(RAFT_LOG_DIR);
+        int count = PrefetchSegments(logPath);
+        LOG_IF(INFO, count > 0) << "Prefetch " << count << " wal segments"
+                                << ", Copyset: " << GroupIdString();
+    }
+
     DataStoreOptions dsOptions;
     dsOptions.baseDir = chunkDataApath_;
     dsOptions.chunkSize = options.maxChunkSize;
@@ -135,6 +149,15 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     dsOptions.locationLimit = options.locationLimit;
     dsOptions.enableOdsyncWhenOpenChunkFile =
         options.enableOdsyncWhenOpenChunkFile;
+    dsOptions.lazyLoadChunk = options.lazyLoadChunk;
+    dsOptions.fdCache = options.chunkFdCache;
+    if (!options.capacityDataUri.empty()) {
+        std::string capacityPath;
+        curve::common::UriParser::ParseUri(options.capacityDataUri,
+                                           &capacityPath);
+        dsOptions.capacityDir = capacityPath + "/" + groupId + "/" +
+                                RAFT_DATA_DIR;
+    }
     dataStore_ = std::make_shared<CSDataStore>(options.localFileSystem,
                                                options.chunkFilePool,
                                                dsOptions);
@@ -318,7 +341,8 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
             ChunkRequest request;
             butil::IOBuf data;
             auto opReq = ChunkOpRequest::Decode(log, &request, &data,
-                                                iter.index(), GetLeaderId());
+                                                iter.index(), GetLeaderId(),
+                                                GetLogStorage());
             auto chunkId = request.chunkid();
             concurrentapply_->Push(chunkId, ChunkOpRequest::Schedule(request.optype()),  // NOLINT
                                    &ChunkOpRequest::OnApplyFromLog, opReq,
@@ -384,6 +408,11 @@ void CopysetNode::save_snapshot_background(::braft::SnapshotWriter *writer,
             if (isSnapshot) {
                 continue;
             }
+            // 在存储层之间移动chunk时的临时文件
+            ChunkID tempId;
+            if (FileNameOperator::IsTierTempFile(fileName, &tempId)) {
+                continue;
+            }
             std::string chunkApath;
             // 通过绝对路径，算出相对于快照目录的路径
             chunkApath.append(chunkDataApath_);
@@ -407,6 +436,11 @@ void CopysetNode::save_snapshot_background(::braft::SnapshotWriter *writer,
 }
 
 int CopysetNode::on_snapshot_load(::braft::SnapshotReader *reader) {
+    // 替换chunk文件并重新init data store期间不能在存储层之间移动chunk
+    std::unique_lock<std::mutex> tierPause;
+    if (dataStore_ != nullptr) {
+        tierPause = dataStore_->PauseTiering();
+    }
     /**
      * 1. 加载快照数据
      */
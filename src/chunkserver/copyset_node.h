@@ -506,7 +506,7 @@ class CopysetNode : public braft::StateMachine,
     // Chunk持久化操作接口
     std::shared_ptr<CSDataStore> dataStore_;
     // The log storage for braft
-    CurveSegmentLogStorage* logStorage_;
+    CurveSegmentLogStorage* logStorage_ = nullptr;
     // 并发模块
     ConcurrentApplyModule *concurrentapply_ = nullptr;
     // 配置版本持久化工具接口
@@ -130,6 +130,9 @@ int CopysetNodeManager::ReloadCopysets() {
         return -1;
     }
 
+    copysetsToLoad_.set_value(items.size());
+    copysetsLoaded_.reset();
+    copysetsLoadFailed_.reset();
     vector<std::string>::iterator it = items.begin();
     for (; it != items.end(); ++it) {
         LOG(INFO) << "Found copyset dir " << *it;
@@ -191,11 +194,13 @@ void CopysetNodeManager::LoadCopyset(const LogicPoolID &logicPoolId,
     if (copysetNode == nullptr) {
         LOG(ERROR) << "Failed to create copyset "
                    << ToGroupIdString(logicPoolId, copysetId);
+        copysetsLoadFailed_ << 1;
         return;
     }
     if (!InsertCopysetNodeIfNotExist(logicPoolId, copysetId, copysetNode)) {
         LOG(ERROR) << "Failed to insert copyset "
                    << ToGroupIdString(logicPoolId, copysetId);
+        copysetsLoadFailed_ << 1;
         return;
     }
     if (needCheckLoadFinished) {
@@ -203,9 +208,13 @@ void CopysetNodeManager::LoadCopyset(const LogicPoolID &logicPoolId,
             GetCopysetNode(logicPoolId, copysetId);
         CheckCopysetUntilLoadFinished(node);
     }
+    uint64_t timeUsed = TimeUtility::GetTimeofDayMs() - beginTime;
+    copysetsLoaded_ << 1;
+    copysetLoadLatency_ << timeUsed;
     LOG(INFO) << "Load copyset " << ToGroupIdString(logicPoolId, copysetId)
-              << " end, time used (ms): "
-              <<  TimeUtility::GetTimeofDayMs() - beginTime;
+              << " end, time used (ms): " << timeUsed
+              << ", progress: " << copysetsLoaded_.get_value()
+              << "/" << copysetsToLoad_.get_value();
 }
 
 bool CopysetNodeManager::CheckCopysetUntilLoadFinished(
@@ -23,6 +23,7 @@
 #ifndef SRC_CHUNKSERVER_COPYSET_NODE_MANAGER_H_
 #define SRC_CHUNKSERVER_COPYSET_NODE_MANAGER_H_
 
+#include <bvar/bvar.h>
 #include <mutex>    //NOLINT
 #include <vector>
 #include <memory>
@@ -185,7 +186,11 @@ class CopysetNodeManager : public curve::common::Uncopyable {
     CopysetNodeManager()
         : copysetLoader_(nullptr)
         , running_(false)
-        , loadFinished_(false) {}
+        , loadFinished_(false)
+        , copysetsToLoad_("chunkserver_copyset_load_total", 0)
+        , copysetsLoaded_("chunkserver_copyset_load_finished")
+        , copysetsLoadFailed_("chunkserver_copyset_load_failed")
+        , copysetLoadLatency_("chunkserver_copyset_load") {}
 
  private:
     /**
@@ -227,6 +232,12 @@ class CopysetNodeManager : public curve::common::Uncopyable {
     Atomic<bool> running_;
     // 表示copyset node manager当前是否已经完成加载
     Atomic<bool> loadFinished_;
+    // 启动时加载copyset的进度
+    bvar::Status<uint32_t> copysetsToLoad_;
+    bvar::Adder<uint32_t> copysetsLoaded_;
+    bvar::Adder<uint32_t> copysetsLoadFailed_;
+    // 单个copyset的加载耗时，单位ms
+    bvar::LatencyRecorder copysetLoadLatency_;
 };
 
 }  // namespace chunkserver
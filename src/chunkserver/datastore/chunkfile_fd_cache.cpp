@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-12
+ */
+
+#include "src/chunkserver/datastore/chunkfile_fd_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::CacheMetrics;
+
+namespace {
+
+const uint64_t kMaxShardNum = 32;
+
+}  // namespace
+
+ChunkFdCache::ChunkFdCache(uint64_t maxOpenFiles) {
+    // every shard can hold one fd at least
+    uint64_t shardNum = std::max<uint64_t>(
+        std::min(kMaxShardNum, maxOpenFiles), 1);
+    auto metrics = std::make_shared<CacheMetrics>("chunkserver_chunkfile_fd");
+    for (uint64_t i = 0; i < shardNum; ++i) {
+        uint64_t capacity = maxOpenFiles / shardNum +
+                            (i < maxOpenFiles % shardNum ? 1 : 0);
+        shards_.emplace_back(new Shard(capacity, metrics));
+    }
+}
+
+ChunkFdCache::Shard* ChunkFdCache::GetShard(const std::string& path) {
+    return shards_[std::hash<std::string>()(path) % shards_.size()].get();
+}
+
+ChunkFdPtr ChunkFdCache::Get(const std::string& path) {
+    ChunkFdPtr fd;
+    if (!GetShard(path)->Get(path, &fd)) {
+        return nullptr;
+    }
+    return fd;
+}
+
+void ChunkFdCache::Put(const std::string& path, ChunkFdPtr fd) {
+    // the evicted fd is closed after the lock of cache is released
+    GetShard(path)->Put(path, fd);
+}
+
+void ChunkFdCache::Remove(const std::string& path) {
+    GetShard(path)->Remove(path);
+}
+
+uint64_t ChunkFdCache::Size() {
+    uint64_t size = 0;
+    for (const auto& shard : shards_) {
+        size += shard->Size();
+    }
+    return size;
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-12
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_CHUNKFILE_FD_CACHE_H_
+#define SRC_CHUNKSERVER_DATASTORE_CHUNKFILE_FD_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/common/lru_cache.h"
+#include "src/fs/local_filesystem.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::fs::LocalFileSystem;
+
+/**
+ * An opened chunk file, the fd is closed when the last reference is released,
+ * so that an fd evicted from the cache is still valid for the requests using it
+ */
+class ChunkFd {
+ public:
+    ChunkFd(std::shared_ptr<LocalFileSystem> lfs, int fd)
+        : lfs_(lfs), fd_(fd) {}
+    ~ChunkFd() {
+        lfs_->Close(fd_);
+    }
+
+    int Fd() const { return fd_; }
+
+ private:
+    std::shared_ptr<LocalFileSystem> lfs_;
+    int fd_;
+};
+using ChunkFdPtr = std::shared_ptr<ChunkFd>;
+
+/**
+ * Bounded LRU cache of the fds of chunk files, shared by all the datastores
+ * of the chunkserver to limit the number of opened chunk files.
+ * The key is the path of the chunk file. It's split into shards by the key,
+ * so that requests of different chunks rarely contend for the same lock,
+ * each shard evicts its own least recently used fds.
+ */
+class ChunkFdCache {
+ public:
+    explicit ChunkFdCache(uint64_t maxOpenFiles);
+
+    ChunkFdPtr Get(const std::string& path);
+
+    void Put(const std::string& path, ChunkFdPtr fd);
+
+    void Remove(const std::string& path);
+
+    uint64_t Size();
+
+ private:
+    using Shard = curve::common::LRUCache<std::string, ChunkFdPtr>;
+
+    Shard* GetShard(const std::string& path);
+
+ private:
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_CHUNKFILE_FD_CACHE_H_
@@ -31,6 +31,9 @@
 namespace curve {
 namespace chunkserver {
 
+// Buffer size to copy the chunk file between the storage tiers
+const uint32_t kTierCopyBufferSize = 1024 * 1024;
+
 ChunkFileMetaPage::ChunkFileMetaPage(const ChunkFileMetaPage& metaPage) {
     version = metaPage.version;
     sn = metaPage.sn;
@@ -137,7 +140,8 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
                          const ChunkOptions& options)
     : cvar_(nullptr),
       chunkrate_(nullptr),
-      fd_(-1),
+      fd_(nullptr),
+      fdCache_(options.fdCache),
       size_(options.chunkSize),
       blockSize_(options.blockSize),
       metaPageSize_(options.metaPageSize),
@@ -148,7 +152,12 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
       chunkFilePool_(chunkFilePool),
       lfs_(lfs),
       metric_(options.metric),
-      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile) {
+      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile),
+      heat_(0),
+      idleRounds_(0),
+      migrationWrites_(nullptr),
+      migrationMetaPageWritten_(false),
+      deleted_(false) {
     CHECK(!baseDir_.empty()) << "Create chunk file failed";
     CHECK(lfs_ != nullptr) << "Create chunk file failed";
     metaPage_.sn = options.sn;
@@ -171,8 +180,10 @@ CSChunkFile::~CSChunkFile() {
         snapshot_ = nullptr;
     }
 
-    if (fd_ >= 0) {
-        lfs_->Close(fd_);
+    // the chunk file may be replaced when installing snapshot,
+    // so the cached fd must not outlive the chunk
+    if (fdCache_ != nullptr) {
+        fdCache_->Remove(path());
     }
 
     if (metric_ != nullptr) {
@@ -180,6 +191,9 @@ CSChunkFile::~CSChunkFile() {
         if (isCloneChunk_) {
             metric_->cloneChunkCount << -1;
         }
+        if (!capacityPath_.empty()) {
+            metric_->capacityChunkCount << -1;
+        }
     }
 }
 
@@ -210,20 +224,30 @@ CSErrorCode CSChunkFile::Open(bool createFile) {
             return CSErrorCode::InternalError;
         }
     }
-    int rc = -1;
-    if (enableOdsyncWhenOpenChunkFile_) {
-        rc = lfs_->Open(chunkFilePath, O_RDWR|O_NOATIME|O_DSYNC);
-    } else {
-        rc = lfs_->Open(chunkFilePath, O_RDWR|O_NOATIME);
+    // The chunk file moved to the capacity tier is a symlink
+    string target;
+    bool onCapacityTier = lfs_->ReadLink(chunkFilePath, &target) == 0 &&
+                          !target.empty();
+    if (onCapacityTier != !capacityPath_.empty() && metric_ != nullptr) {
+        metric_->capacityChunkCount << (onCapacityTier ? 1 : -1);
     }
+    capacityPath_ = onCapacityTier ? target : "";
+    int rc = openFile(realPath());
     if (rc < 0) {
         LOG(ERROR) << "Error occured when opening file."
                    << " filepath = " << chunkFilePath;
         return CSErrorCode::InternalError;
     }
-    fd_ = rc;
+    // always use the newly opened fd, the cached one may refer to the file
+    // replaced by installing snapshot
+    ChunkFdPtr fd = std::make_shared<ChunkFd>(lfs_, rc);
+    if (fdCache_ != nullptr) {
+        fdCache_->Put(chunkFilePath, fd);
+    } else {
+        fd_ = fd;
+    }
     struct stat fileInfo;
-    rc = lfs_->Fstat(fd_, &fileInfo);
+    rc = lfs_->Fstat(fd->Fd(), &fileInfo);
     if (rc < 0) {
         LOG(ERROR) << "Error occured when stating file."
                    << " filepath = " << chunkFilePath;
@@ -288,8 +312,10 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
                                const butil::IOBuf& buf,
                                off_t offset,
                                size_t length,
-                               uint32_t* cost) {
+                               uint32_t* cost,
+                               const DataRemapper& remapper) {
     (void)cost;
+    heat_.fetch_add(1, std::memory_order_relaxed);
     WriteLockGuard writeGuard(rwLock_);
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Write chunk failed, invalid offset or length."
@@ -394,7 +420,13 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
             return errorCode;
         }
     }
-    int rc = writeData(buf, offset, length);
+    int rc = -1;
+    if (remapper) {
+        rc = remapData(remapper, offset, length);
+    }
+    if (rc < 0) {
+        rc = writeData(buf, offset, length);
+    }
     if (rc < 0) {
         LOG(ERROR) << "Write data to chunk file failed."
                    << "ChunkID: " << chunkId_
@@ -495,6 +527,7 @@ CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
 }
 
 CSErrorCode CSChunkFile::Read(char * buf, off_t offset, size_t length) {
+    heat_.fetch_add(1, std::memory_order_relaxed);
     ReadLockGuard readGuard(rwLock_);
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Read chunk failed, invalid offset or length."
@@ -664,13 +697,36 @@ CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
         snapshot_ = nullptr;
     }
 
-    if (fd_ >= 0) {
-        lfs_->Close(fd_);
-        fd_ = -1;
+    fd_ = nullptr;
+    if (fdCache_ != nullptr) {
+        fdCache_->Remove(path());
+    }
+    int ret = 0;
+    if (capacityPath_.empty()) {
+        ret = chunkFilePool_->RecycleFile(path());
+    } else {
+        // The file on the capacity tier is not from the chunk file pool,
+        // the symlink is removed first, an orphan file left by a crash in
+        // between is removed when initializing the datastore
+        ret = lfs_->Delete(path());
+        if (ret == 0) {
+            // a dangling symlink left by a crash would fail loading the chunk
+            ret = syncParentDir(path());
+        }
+        if (ret == 0) {
+            ret = lfs_->Delete(capacityPath_);
+            LOG_IF(WARNING, ret < 0) << "Delete chunk file on capacity tier "
+                                     << capacityPath_ << " failed.";
+            ret = 0;
+            if (metric_ != nullptr) {
+                metric_->capacityChunkCount << -1;
+            }
+            capacityPath_.clear();
+        }
     }
-    int ret = chunkFilePool_->RecycleFile(path());
     if (ret < 0)
         return CSErrorCode::InternalError;
+    deleted_ = true;
 
     LOG(INFO) << "Chunk deleted."
               << "ChunkID: " << chunkId_
@@ -793,7 +849,11 @@ CSErrorCode CSChunkFile::GetHash(off_t offset,
         return CSErrorCode::InternalError;
     }
 
-    int rc = lfs_->Read(fd_, buf, offset, length);
+    ChunkFdPtr fd;
+    int rc = getFd(&fd);
+    if (rc >= 0) {
+        rc = lfs_->Read(fd->Fd(), buf, offset, length);
+    }
     if (rc < 0) {
         LOG(ERROR) << "Read chunk file failed."
                    << "ChunkID: " << chunkId_
@@ -883,6 +943,338 @@ bool CSChunkFile::needCow(SequenceNum sn) {
     return true;
 }
 
+int CSChunkFile::openFile(const string& chunkFilePath) {
+    if (enableOdsyncWhenOpenChunkFile_) {
+        return lfs_->Open(chunkFilePath, O_RDWR|O_NOATIME|O_DSYNC);
+    }
+    return lfs_->Open(chunkFilePath, O_RDWR|O_NOATIME);
+}
+
+int CSChunkFile::reopenFile() {
+    int rc = openFile(realPath());
+    if (rc < 0) {
+        LOG(ERROR) << "Reopen chunk file failed."
+                   << " filepath = " << realPath()
+                   << ", error = " << rc;
+        return rc;
+    }
+    ChunkFdPtr fd = std::make_shared<ChunkFd>(lfs_, rc);
+    if (fdCache_ != nullptr) {
+        fdCache_->Put(path(), fd);
+    } else {
+        fd_ = fd;
+    }
+    return 0;
+}
+
+int CSChunkFile::copyRange(int srcFd, int dstFd, off_t offset,
+                           size_t length) {
+    const size_t bufSize = std::min<size_t>(kTierCopyBufferSize, length);
+    std::unique_ptr<char[]> buf(new char[bufSize]);
+    for (size_t copied = 0; copied < length;) {
+        int len = std::min(bufSize, length - copied);
+        int rc = lfs_->Read(srcFd, buf.get(), offset + copied, len);
+        if (rc >= 0 && rc != len) {
+            rc = -EIO;
+        }
+        if (rc < 0) {
+            return rc;
+        }
+        rc = lfs_->Write(dstFd, buf.get(), offset + copied, len);
+        if (rc < 0) {
+            return rc;
+        }
+        copied += len;
+    }
+    return 0;
+}
+
+void CSChunkFile::startMigration() {
+    migrationWrites_.reset(new Bitmap(size_ / blockSize_));
+    migrationMetaPageWritten_ = false;
+}
+
+int CSChunkFile::copyMigrationWrites(int srcFd, int dstFd) {
+    std::unique_ptr<Bitmap> writes = std::move(migrationWrites_);
+    int rc = 0;
+    if (migrationMetaPageWritten_) {
+        rc = copyRange(srcFd, dstFd, 0, metaPageSize_);
+        migrationMetaPageWritten_ = false;
+    }
+    std::vector<BitRange> clearRanges;
+    std::vector<BitRange> setRanges;
+    writes->Divide(0, writes->Size() - 1, &clearRanges, &setRanges);
+    for (const auto& range : setRanges) {
+        if (rc < 0) {
+            break;
+        }
+        off_t offset = static_cast<off_t>(range.beginIndex) * blockSize_;
+        size_t length = static_cast<size_t>(
+            range.endIndex - range.beginIndex + 1) * blockSize_;
+        rc = copyRange(srcFd, dstFd, offset + metaPageSize_, length);
+    }
+    if (rc == 0) {
+        rc = lfs_->Fsync(dstFd);
+    }
+    return rc;
+}
+
+int CSChunkFile::syncParentDir(const string& path) {
+    string dir = path.substr(0, path.rfind('/'));
+    int fd = lfs_->Open(dir, O_RDONLY|O_DIRECTORY);
+    if (fd < 0) {
+        return fd;
+    }
+    int rc = lfs_->Fsync(fd);
+    lfs_->Close(fd);
+    return rc;
+}
+
+CSErrorCode CSChunkFile::Demote(const std::string& capacityPath) {
+    ChunkFdPtr fd;
+    {
+        WriteLockGuard writeGuard(rwLock_);
+        if (deleted_) {
+            return CSErrorCode::ChunkNotExistError;
+        }
+        if (!capacityPath_.empty()) {
+            return CSErrorCode::Success;
+        }
+        if (getFd(&fd) < 0) {
+            return CSErrorCode::InternalError;
+        }
+        startMigration();
+    }
+
+    // 1. Copy the chunk file to the capacity tier. The chunk is still
+    // accessed while copying, the writes in the meantime are copied again
+    // with the write lock held
+    string tempPath = capacityPath + kTierTempSuffix;
+    int dstFd = lfs_->Open(tempPath, O_RDWR|O_CREAT|O_TRUNC);
+    int rc = dstFd;
+    if (dstFd >= 0) {
+        rc = copyRange(fd->Fd(), dstFd, 0, fileSize());
+    }
+    WriteLockGuard writeGuard(rwLock_);
+    if (rc >= 0) {
+        rc = copyMigrationWrites(fd->Fd(), dstFd);
+    }
+    migrationWrites_.reset();
+    if (dstFd >= 0) {
+        lfs_->Close(dstFd);
+    }
+    if (deleted_) {
+        lfs_->Delete(tempPath);
+        return CSErrorCode::ChunkNotExistError;
+    }
+    bool renamed = false;
+    if (rc == 0) {
+        rc = lfs_->Rename(tempPath, capacityPath);
+        renamed = rc == 0;
+    }
+    // The copy must be found by its name before the chunk file is recycled,
+    // otherwise it's removed as an orphan after a power loss
+    if (rc == 0) {
+        rc = syncParentDir(capacityPath);
+    }
+    if (rc < 0) {
+        LOG(ERROR) << "Copy chunk file to capacity tier failed."
+                   << " ChunkID: " << chunkId_
+                   << ", path: " << capacityPath
+                   << ", error: " << rc;
+        lfs_->Delete(renamed ? capacityPath : tempPath);
+        return CSErrorCode::InternalError;
+    }
+
+    // 2. Replace the chunk file with a symlink to the copy. The chunk file
+    // is recycled before the symlink is renamed to its path. Once the
+    // symlink is created, the chunk file left by a crash is replaced by it
+    // when initializing the datastore
+    string linkPath =
+        baseDir_ + "/" + FileNameOperator::GenerateTierTempName(chunkId_);
+    string target;
+    if (lfs_->ReadLink(linkPath, &target) == 0) {
+        lfs_->Delete(linkPath);
+    }
+    rc = lfs_->Symlink(capacityPath, linkPath);
+    if (rc == 0) {
+        rc = syncParentDir(linkPath);
+        if (rc < 0) {
+            lfs_->Delete(linkPath);
+            syncParentDir(linkPath);
+        }
+    }
+    if (rc < 0) {
+        LOG(ERROR) << "Create symlink failed."
+                   << " ChunkID: " << chunkId_
+                   << ", link path: " << linkPath
+                   << ", error: " << rc;
+        lfs_->Delete(capacityPath);
+        return CSErrorCode::InternalError;
+    }
+    fd.reset();
+    fd_ = nullptr;
+    if (fdCache_ != nullptr) {
+        fdCache_->Remove(path());
+    }
+    rc = chunkFilePool_->RecycleFile(path());
+    if (rc < 0 && lfs_->FileExists(path())) {
+        LOG(ERROR) << "Recycle chunk file failed when demoting."
+                   << " ChunkID: " << chunkId_;
+        // the symlink must not replace the chunk file written afterwards
+        lfs_->Delete(linkPath);
+        syncParentDir(linkPath);
+        lfs_->Delete(capacityPath);
+        reopenFile();
+        return CSErrorCode::InternalError;
+    }
+    // The data is on the capacity tier from now on, even if the symlink is
+    // not in place yet
+    capacityPath_ = capacityPath;
+    if (metric_ != nullptr) {
+        metric_->capacityChunkCount << 1;
+    }
+    rc = lfs_->Rename(linkPath, path());
+    LOG_IF(ERROR, rc < 0) << "Rename symlink failed, it will be renamed "
+                          << "when restarting, link path: " << linkPath;
+    if (reopenFile() < 0) {
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSChunkFile::Promote() {
+    ChunkFdPtr fd;
+    {
+        WriteLockGuard writeGuard(rwLock_);
+        if (deleted_) {
+            return CSErrorCode::ChunkNotExistError;
+        }
+        if (capacityPath_.empty()) {
+            return CSErrorCode::Success;
+        }
+        if (getFd(&fd) < 0) {
+            return CSErrorCode::InternalError;
+        }
+        startMigration();
+    }
+
+    // 1. Copy the chunk file to a file from the chunk file pool, the same
+    // way as demoting. The metapage is copied with the data
+    string tempPath =
+        baseDir_ + "/" + FileNameOperator::GenerateTierTempName(chunkId_);
+    string target;
+    if (lfs_->ReadLink(tempPath, &target) == 0) {
+        // the symlink left by a failed demoting
+        lfs_->Delete(tempPath);
+    } else if (lfs_->FileExists(tempPath)) {
+        chunkFilePool_->RecycleFile(tempPath);
+    }
+    std::unique_ptr<char[]> buf(new char[metaPageSize_]);
+    memset(buf.get(), 0, metaPageSize_);
+    int rc = chunkFilePool_->GetFile(tempPath, buf.get());
+    bool gotFile = rc >= 0;
+    int dstFd = -1;
+    if (gotFile) {
+        dstFd = lfs_->Open(tempPath, O_RDWR);
+        rc = dstFd;
+    }
+    if (dstFd >= 0) {
+        rc = copyRange(fd->Fd(), dstFd, 0, fileSize());
+    }
+    WriteLockGuard writeGuard(rwLock_);
+    if (rc >= 0) {
+        rc = copyMigrationWrites(fd->Fd(), dstFd);
+    }
+    migrationWrites_.reset();
+    if (dstFd >= 0) {
+        lfs_->Close(dstFd);
+    }
+    if (deleted_) {
+        if (gotFile) {
+            chunkFilePool_->RecycleFile(tempPath);
+        }
+        return CSErrorCode::ChunkNotExistError;
+    }
+    if (rc < 0) {
+        LOG(ERROR) << "Copy chunk file from capacity tier failed."
+                   << " ChunkID: " << chunkId_
+                   << ", error: " << rc;
+        if (gotFile) {
+            chunkFilePool_->RecycleFile(tempPath);
+        }
+        return CSErrorCode::InternalError;
+    }
+
+    // 2. Replace the symlink with the copy atomically
+    fd.reset();
+    fd_ = nullptr;
+    if (fdCache_ != nullptr) {
+        fdCache_->Remove(path());
+    }
+    rc = lfs_->Rename(tempPath, path());
+    if (rc < 0) {
+        LOG(ERROR) << "Rename chunk file failed when promoting."
+                   << " ChunkID: " << chunkId_
+                   << ", error: " << rc;
+        chunkFilePool_->RecycleFile(tempPath);
+        reopenFile();
+        return CSErrorCode::InternalError;
+    }
+    // The file on the capacity tier is kept until the rename is durable,
+    // it's removed as an orphan when initializing the datastore otherwise
+    rc = syncParentDir(path());
+    if (rc == 0) {
+        rc = lfs_->Delete(capacityPath_);
+    }
+    LOG_IF(WARNING, rc < 0) << "Delete chunk file on capacity tier "
+                            << capacityPath_ << " failed.";
+    capacityPath_.clear();
+    if (metric_ != nullptr) {
+        metric_->capacityChunkCount << -1;
+    }
+    if (reopenFile() < 0) {
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+uint32_t CSChunkFile::DecayHeat(uint32_t* idleRounds) {
+    uint32_t heat = heat_.load(std::memory_order_relaxed);
+    heat_.fetch_sub(heat - heat / 2, std::memory_order_relaxed);
+    idleRounds_ = heat == 0 ? idleRounds_ + 1 : 0;
+    *idleRounds = idleRounds_;
+    return heat;
+}
+
+int CSChunkFile::getFd(ChunkFdPtr* fd) {
+    if (fdCache_ == nullptr) {
+        if (fd_ == nullptr) {
+            return -EBADF;
+        }
+        *fd = fd_;
+        return 0;
+    }
+
+    string chunkFilePath = path();
+    *fd = fdCache_->Get(chunkFilePath);
+    if (*fd != nullptr) {
+        return 0;
+    }
+    // Concurrent readers may open the file at the same time,
+    // the fd put later replaces the former one in the cache
+    int rc = openFile(realPath());
+    if (rc < 0) {
+        LOG(ERROR) << "Reopen chunk file failed."
+                   << " filepath = " << realPath()
+                   << ", error = " << rc;
+        return rc;
+    }
+    *fd = std::make_shared<ChunkFd>(lfs_, rc);
+    fdCache_->Put(chunkFilePath, *fd);
+    return 0;
+}
+
 CSErrorCode CSChunkFile::updateMetaPage(ChunkFileMetaPage* metaPage) {
     std::unique_ptr<char[]> buf(new char[metaPageSize_]);
     memset(buf.get(), 0, metaPageSize_);
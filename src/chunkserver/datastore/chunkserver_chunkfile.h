@@ -42,6 +42,7 @@
 #include "src/chunkserver/datastore/chunkserver_snapshot.h"
 #include "src/chunkserver/datastore/define.h"
 #include "src/chunkserver/datastore/file_pool.h"
+#include "src/chunkserver/datastore/chunkfile_fd_cache.h"
 #include "src/common/fast_align.h"
 
 namespace curve {
@@ -58,6 +59,13 @@ class FilePool;
 class CSSnapshot;
 struct DataStoreMetric;
 
+/**
+ * Make |length| bytes of data that are already on disk (e.g. the payload of
+ * a wal entry) appear in the file |fd| at |offset| without writing them
+ * again, return 0 on success, otherwise the data is written as usual
+ */
+using DataRemapper = std::function<int(int fd, off_t offset, size_t length)>;
+
 /**
  * Chunkfile Metapage Format
  * version: 1 byte
@@ -114,6 +122,9 @@ struct ChunkOptions {
     bool enableOdsyncWhenOpenChunkFile;
     // datastore internal statistical metric
     std::shared_ptr<DataStoreMetric> metric;
+    // cache of opened chunk files, if it is nullptr, the chunk file is kept
+    // open until it is deleted
+    std::shared_ptr<ChunkFdCache> fdCache;
 
     ChunkOptions() : id(0)
                    , sn(0)
@@ -123,7 +134,8 @@ struct ChunkOptions {
                    , chunkSize(0)
                    , blockSize(0)
                    , metaPageSize(0)
-                   , metric(nullptr) {}
+                   , metric(nullptr)
+                   , fdCache(nullptr) {}
 };
 
 class CSChunkFile {
@@ -165,13 +177,15 @@ class CSChunkFile {
      * @param length: The length of the data requested to be written
      * @param cost: The actual number of IOs generated by this request,
      * used for QOS control
+     * @param remapper: if set, try to remap the data instead of writing buf
      * @return: return error code
      */
     CSErrorCode Write(SequenceNum sn,
                       const butil::IOBuf& buf,
                       off_t offset,
                       size_t length,
-                      uint32_t* cost);
+                      uint32_t* cost,
+                      const DataRemapper& remapper = nullptr);
 
     CSErrorCode Sync();
 
@@ -265,6 +279,37 @@ class CSChunkFile {
         metaPage_ = metaPage;
     }
 
+    /**
+     * Move the chunk file to the capacity tier, a symlink to it is left at
+     * the original path, so the chunk is still found by its name
+     * The data is copied without the lock, the write lock is only held to
+     * copy the writes made in the meantime and to replace the file
+     * @param capacityPath: path of the chunk file on the capacity tier
+     * @return: return error code, ChunkNotExistError if the chunk is
+     *          deleted
+     */
+    CSErrorCode Demote(const std::string& capacityPath);
+    /**
+     * Move the chunk file back from the capacity tier, the lock is held the
+     * same way as Demote()
+     * @return: return error code, ChunkNotExistError if the chunk is
+     *          deleted
+     */
+    CSErrorCode Promote();
+
+    bool IsOnCapacityTier() {
+        ReadLockGuard readGuard(rwLock_);
+        return !capacityPath_.empty();
+    }
+
+    /**
+     * Called periodically by tiering, the heat is the decayed number of
+     * accesses, it is halved each time
+     * @param[out] idleRounds: the number of periods it's not accessed
+     * @return: the heat before decayed
+     */
+    uint32_t DecayHeat(uint32_t* idleRounds);
+
     void SetSyncInfo(std::shared_ptr<std::atomic<uint64_t>> rate,
         std::shared_ptr<std::condition_variable> cond) {
         chunkrate_ = rate;
@@ -322,27 +367,101 @@ class CSChunkFile {
                     FileNameOperator::GenerateChunkFileName(chunkId_);
     }
 
+    // the path of the file actually holding the data
+    inline string realPath() {
+        return capacityPath_.empty() ? path() : capacityPath_;
+    }
+
     inline uint32_t fileSize() const {
         return metaPageSize_ + size_;
     }
 
+    /**
+     * Get the fd of the chunk file, the file is reopened if its fd has been
+     * evicted from the fd cache
+     * @param[out] fd: the opened chunk file, it is valid until released
+     * @return: 0 on success, -errno on failure
+     */
+    int getFd(ChunkFdPtr* fd);
+
+    int openFile(const string& chunkFilePath);
+
+    // open the chunk file again after it's moved between the tiers
+    int reopenFile();
+
+    /**
+     * Copy |length| bytes at |offset| of the chunk file, including the
+     * metapage, to the same position of |dstFd|
+     * @return: 0 on success, -errno on failure
+     */
+    int copyRange(int srcFd, int dstFd, off_t offset, size_t length);
+
+    // start recording the writes before copying the chunk file between the
+    // tiers without the lock, called with the write lock
+    void startMigration();
+
+    /**
+     * Copy the writes made since startMigration() to |dstFd| and sync it,
+     * the recording is stopped, called with the write lock
+     * @return: 0 on success, -errno on failure
+     */
+    int copyMigrationWrites(int srcFd, int dstFd);
+
+    // record the data written while the chunk file is copied between the
+    // tiers, the offset doesn't include the metapage
+    inline void markMigrationWrite(off_t offset, size_t length) {
+        if (migrationWrites_ != nullptr && length > 0) {
+            migrationWrites_->Set(offset / blockSize_,
+                                  (offset + length - 1) / blockSize_);
+        }
+    }
+
+    // fsync the directory of |path|, so that the entry created or renamed
+    // in it survives a power loss
+    int syncParentDir(const string& path);
+
     inline int readMetaPage(char* buf) {
-        return lfs_->Read(fd_, buf, 0, metaPageSize_);
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
+        if (rc < 0) {
+            return rc;
+        }
+        return lfs_->Read(fd->Fd(), buf, 0, metaPageSize_);
     }
 
     inline int writeMetaPage(const char* buf) {
-        return lfs_->Write(fd_, buf, 0, metaPageSize_);
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
+        if (rc < 0) {
+            return rc;
+        }
+        rc = lfs_->Write(fd->Fd(), buf, 0, metaPageSize_);
+        if (rc >= 0 && migrationWrites_ != nullptr) {
+            migrationMetaPageWritten_ = true;
+        }
+        return rc;
     }
 
     inline int readData(char* buf, off_t offset, size_t length) {
-        return lfs_->Read(fd_, buf, offset + metaPageSize_, length);
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
+        if (rc < 0) {
+            return rc;
+        }
+        return lfs_->Read(fd->Fd(), buf, offset + metaPageSize_, length);
     }
 
     inline int writeData(const char* buf, off_t offset, size_t length) {
-        int rc = lfs_->Write(fd_, buf, offset + metaPageSize_, length);
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
         if (rc < 0) {
             return rc;
         }
+        rc = lfs_->Write(fd->Fd(), buf, offset + metaPageSize_, length);
+        if (rc < 0) {
+            return rc;
+        }
+        markMigrationWrite(offset, length);
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         if (isCloneChunk_) {
@@ -358,11 +477,40 @@ class CSChunkFile {
         return rc;
     }
 
+    // clone chunks are not remapped, as their bitmap has to be updated
+    inline int remapData(const DataRemapper& remapper, off_t offset,
+                         size_t length) {
+        if (isCloneChunk_) {
+            return -1;
+        }
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
+        if (rc < 0) {
+            return rc;
+        }
+        rc = remapper(fd->Fd(), offset + metaPageSize_, length);
+        if (rc < 0) {
+            return rc;
+        }
+        markMigrationWrite(offset, length);
+        // the remapped data bypasses O_DSYNC
+        if (enableOdsyncWhenOpenChunkFile_) {
+            return lfs_->Sync(fd->Fd());
+        }
+        return 0;
+    }
+
     inline int writeData(const butil::IOBuf& buf, off_t offset, size_t length) {
-        int rc = lfs_->Write(fd_, buf, offset + metaPageSize_, length);
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
+        if (rc < 0) {
+            return rc;
+        }
+        rc = lfs_->Write(fd->Fd(), buf, offset + metaPageSize_, length);
         if (rc < 0) {
             return rc;
         }
+        markMigrationWrite(offset, length);
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         // page size to alignment
@@ -380,7 +528,12 @@ class CSChunkFile {
     }
 
     inline int SyncData() {
-        return lfs_->Sync(fd_);
+        ChunkFdPtr fd;
+        int rc = getFd(&fd);
+        if (rc < 0) {
+            return rc;
+        }
+        return lfs_->Sync(fd->Fd());
     }
 
     inline bool CheckOffsetAndLength(off_t offset, size_t len) {
@@ -405,8 +558,11 @@ class CSChunkFile {
     std::shared_ptr<std::condition_variable> cvar_;
     // the sum of every chunkfile length
     std::shared_ptr<std::atomic<uint64_t>> chunkrate_;
-    // file descriptor of chunk file
-    int fd_;
+    // file descriptor of chunk file, it is only held here when the fd cache
+    // is disabled, otherwise it is looked up from the fd cache
+    ChunkFdPtr fd_;
+    // cache of opened chunk files shared by all chunks of the chunkserver
+    std::shared_ptr<ChunkFdCache> fdCache_;
     // The logical size of the chunk, not including metapage
     ChunkSizeType size_;
     ChunkSizeType blockSize_;
@@ -434,6 +590,21 @@ class CSChunkFile {
     std::shared_ptr<DataStoreMetric> metric_;
     // enable O_DSYNC When Open ChunkFile
     bool enableOdsyncWhenOpenChunkFile_;
+    // path of the chunk file on the capacity tier, empty if it's on the
+    // fast tier
+    std::string capacityPath_;
+    // decayed number of accesses, see DecayHeat()
+    std::atomic<uint32_t> heat_;
+    // the number of periods the chunk is not accessed, only used by tiering
+    uint32_t idleRounds_;
+    // blocks written while the chunk file is copied between the tiers,
+    // nullptr if it's not being copied
+    std::unique_ptr<Bitmap> migrationWrites_;
+    // whether the metapage is written while the chunk file is copied
+    bool migrationMetaPageWritten_;
+    // set when the chunk is deleted, the chunk file may be moved between the
+    // tiers after the chunk is deleted from the datastore
+    bool deleted_;
 };
 }  // namespace chunkserver
 }  // namespace curve
@@ -22,6 +22,9 @@
 
 #include <gflags/gflags.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <list>
@@ -44,7 +47,10 @@ CSDataStore::CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
       baseDir_(options.baseDir),
       chunkFilePool_(chunkFilePool),
       lfs_(lfs),
-      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile) {
+      enableOdsyncWhenOpenChunkFile_(options.enableOdsyncWhenOpenChunkFile),
+      lazyLoadChunk_(options.lazyLoadChunk),
+      fdCache_(options.fdCache),
+      capacityDir_(options.capacityDir) {
     CHECK(!baseDir_.empty()) << "Create datastore failed";
     CHECK(lfs_ != nullptr) << "Create datastore failed";
     CHECK(chunkFilePool_ != nullptr) << "Create datastore failed";
@@ -63,19 +69,65 @@ bool CSDataStore::Initialize() {
         }
     }
 
+    // The symlinks to the chunk files on the capacity tier are resolved
+    // relative to the datastore directory, so the target must be absolute
+    if (!capacityDir_.empty() && capacityDir_[0] != '/') {
+        char cwd[PATH_MAX];
+        if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+            LOG(ERROR) << "Get current directory failed, errno: " << errno;
+            return false;
+        }
+        capacityDir_ = string(cwd) + "/" + capacityDir_;
+    }
+    if (!capacityDir_.empty() && !lfs_->DirExists(capacityDir_.c_str())) {
+        int rc = lfs_->Mkdir(capacityDir_.c_str());
+        if (rc < 0) {
+            LOG(ERROR) << "Create " << capacityDir_ << " failed.";
+            return false;
+        }
+    }
+
     vector<string> files;
     int rc = lfs_->List(baseDir_, &files);
     if (rc < 0) {
         LOG(ERROR) << "List " << baseDir_ << " failed.";
         return false;
     }
+    recoverTierTempFiles(&files);
+    if (!capacityDir_.empty()) {
+        removeOrphanCapacityFiles();
+    }
 
     // If loaded before, reload here
     metaCache_.Clear();
     metric_ = std::make_shared<DataStoreMetric>();
+    std::lock_guard<std::mutex> lk(loadMtx_);
+    unloadedChunks_.clear();
     for (size_t i = 0; i < files.size(); ++i) {
+        ChunkID tempId;
+        if (FileNameOperator::IsTierTempFile(files[i], &tempId)) {
+            continue;
+        }
         FileNameOperator::FileInfo info =
             FileNameOperator::ParseFileName(files[i]);
+        if (lazyLoadChunk_) {
+            // Only record the chunks here, they are opened on first access
+            if (info.type == FileNameOperator::FileType::CHUNK) {
+                unloadedChunks_.emplace(info.id, kInvalidSeq);
+            } else if (info.type == FileNameOperator::FileType::SNAPSHOT) {
+                string chunkFilePath = baseDir_ + "/" +
+                            FileNameOperator::GenerateChunkFileName(info.id);
+                if (!lfs_->FileExists(chunkFilePath)) {
+                    LOG(WARNING) << "Can't find snapshot "
+                                 << files[i] << "' chunk.";
+                    continue;
+                }
+                unloadedChunks_[info.id] = info.sn;
+            } else {
+                LOG(WARNING) << "Unknown file: " << files[i];
+            }
+            continue;
+        }
         if (info.type == FileNameOperator::FileType::CHUNK) {
             // If the chunk file has not been loaded yet, load it to metaCache
             CSErrorCode errorCode = loadChunkFile(info.id);
@@ -110,12 +162,18 @@ bool CSDataStore::Initialize() {
             LOG(WARNING) << "Unknown file: " << files[i];
         }
     }
+    LOG_IF(INFO, lazyLoadChunk_) << unloadedChunks_.size()
+                                 << " chunks will be loaded on first access.";
     LOG(INFO) << "Initialize data store success.";
     return true;
 }
 
 CSErrorCode CSDataStore::DeleteChunk(ChunkID id, SequenceNum sn) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile != nullptr) {
         CSErrorCode errorCode = chunkFile->Delete(sn);
         if (errorCode != CSErrorCode::Success) {
@@ -130,7 +188,11 @@ CSErrorCode CSDataStore::DeleteChunk(ChunkID id, SequenceNum sn) {
 
 CSErrorCode CSDataStore::DeleteSnapshotChunkOrCorrectSn(
     ChunkID id, SequenceNum correctedSn) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile != nullptr) {
         CSErrorCode errorCode = chunkFile->DeleteSnapshotOrCorrectSn(correctedSn);  // NOLINT
         if (errorCode != CSErrorCode::Success) {
@@ -149,7 +211,11 @@ CSErrorCode CSDataStore::ReadChunk(ChunkID id,
                                    off_t offset,
                                    size_t length) {
     (void)sn;
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile == nullptr) {
         return CSErrorCode::ChunkNotExistError;
     }
@@ -166,7 +232,11 @@ CSErrorCode CSDataStore::ReadChunk(ChunkID id,
 CSErrorCode CSDataStore::ReadChunkMetaPage(ChunkID id, SequenceNum sn,
                                            char * buf) {
     (void)sn;
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile == nullptr) {
         return CSErrorCode::ChunkNotExistError;
     }
@@ -185,7 +255,11 @@ CSErrorCode CSDataStore::ReadSnapshotChunk(ChunkID id,
                                            char * buf,
                                            off_t offset,
                                            size_t length) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile == nullptr) {
         return CSErrorCode::ChunkNotExistError;
     }
@@ -235,6 +309,18 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
                             size_t length,
                             uint32_t* cost,
                             const std::string & cloneSourceLocation)  {
+    return WriteChunkByRemap(id, sn, buf, offset, length, cost, nullptr,
+                             cloneSourceLocation);
+}
+
+CSErrorCode CSDataStore::WriteChunkByRemap(ChunkID id,
+                            SequenceNum sn,
+                            const butil::IOBuf& buf,
+                            off_t offset,
+                            size_t length,
+                            uint32_t* cost,
+                            const DataRemapper& remapper,
+                            const std::string & cloneSourceLocation)  {
     // The requested sequence number is not allowed to be 0, when snapsn=0,
     // it will be used as the basis for judging that the snapshot does not exist
     if (sn == kInvalidSeq) {
@@ -242,7 +328,11 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
                    << "ChunkID = " << id;
         return CSErrorCode::InvalidArgError;
     }
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     // If the chunk file does not exist, create the chunk file first
     if (chunkFile == nullptr) {
         ChunkOptions options;
@@ -255,6 +345,7 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
         options.metaPageSize = metaPageSize_;
         options.metric = metric_;
         options.enableOdsyncWhenOpenChunkFile = enableOdsyncWhenOpenChunkFile_;
+        options.fdCache = fdCache_;
         CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
         if (errorCode != CSErrorCode::Success) {
             return errorCode;
@@ -265,7 +356,8 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
                                              buf,
                                              offset,
                                              length,
-                                             cost);
+                                             cost,
+                                             remapper);
     if (errorCode != CSErrorCode::Success) {
         LOG(WARNING) << "Write chunk file failed."
                      << "ChunkID = " << id;
@@ -275,7 +367,11 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
 }
 
 CSErrorCode CSDataStore::SyncChunk(ChunkID id) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile == nullptr) {
         LOG(WARNING) << "Sync chunk not exist, ChunkID = " << id;
         return CSErrorCode::Success;
@@ -306,7 +402,11 @@ CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
                    << ", location = " << location;
         return CSErrorCode::InvalidArgError;
     }
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     // If the chunk file does not exist, create the chunk file first
     if (chunkFile == nullptr) {
         ChunkOptions options;
@@ -319,6 +419,7 @@ CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
         options.blockSize = blockSize_;
         options.metaPageSize = metaPageSize_;
         options.metric = metric_;
+        options.fdCache = fdCache_;
         CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
         if (errorCode != CSErrorCode::Success) {
             return errorCode;
@@ -352,7 +453,11 @@ CSErrorCode CSDataStore::PasteChunk(ChunkID id,
                                     const char * buf,
                                     off_t offset,
                                     size_t length) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     // Paste Chunk requires Chunk must exist
     if (chunkFile == nullptr) {
         LOG(WARNING) << "Paste Chunk failed, Chunk not exists."
@@ -370,7 +475,11 @@ CSErrorCode CSDataStore::PasteChunk(ChunkID id,
 
 CSErrorCode CSDataStore::GetChunkInfo(ChunkID id,
                                       CSChunkInfo* chunkInfo) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile == nullptr) {
         LOG(INFO) << "Get ChunkInfo failed, Chunk not exists."
                   << "ChunkID = " << id;
@@ -384,7 +493,11 @@ CSErrorCode CSDataStore::GetChunkHash(ChunkID id,
                                       off_t offset,
                                       size_t length,
                                       std::string* hash) {
-    auto chunkFile = metaCache_.Get(id);
+    CSChunkFilePtr chunkFile;
+    CSErrorCode loadErr = GetChunkFile(id, &chunkFile);
+    if (loadErr != CSErrorCode::Success) {
+        return loadErr;
+    }
     if (chunkFile == nullptr) {
         LOG(INFO) << "Get ChunkHash failed, Chunk not exists."
                   << "ChunkID = " << id;
@@ -396,11 +509,121 @@ CSErrorCode CSDataStore::GetChunkHash(ChunkID id,
 DataStoreStatus CSDataStore::GetStatus() {
     DataStoreStatus status;
     status.chunkFileCount = metric_->chunkFileCount.get_value();
+    if (lazyLoadChunk_) {
+        // the clone chunks not loaded yet are not counted
+        std::lock_guard<std::mutex> lk(loadMtx_);
+        status.chunkFileCount += unloadedChunks_.size();
+    }
     status.cloneChunkCount = metric_->cloneChunkCount.get_value();
     status.snapshotCount = metric_->snapshotCount.get_value();
+    status.capacityChunkCount = metric_->capacityChunkCount.get_value();
     return status;
 }
 
+uint32_t CSDataStore::MigrateChunks(const ChunkTierOptions& options,
+                                    uint32_t maxMigrations) {
+    std::unique_lock<std::mutex> lk(tierMtx_, std::try_to_lock);
+    if (capacityDir_.empty() || !lk.owns_lock()) {
+        return 0;
+    }
+    uint32_t migrated = 0;
+    ChunkMap chunkMap = metaCache_.GetMap();
+    for (auto& item : chunkMap) {
+        // the heat of all chunks is decayed, even if no more chunks can be
+        // moved this time
+        uint32_t idleRounds = 0;
+        uint32_t heat = item.second->DecayHeat(&idleRounds);
+        if (migrated >= maxMigrations) {
+            continue;
+        }
+        // the chunk may have been deleted after the map was copied
+        if (metaCache_.Get(item.first) != item.second) {
+            continue;
+        }
+        CSErrorCode errorCode;
+        bool onCapacityTier = item.second->IsOnCapacityTier();
+        if (onCapacityTier && heat >= options.promoteHeat) {
+            errorCode = item.second->Promote();
+        } else if (!onCapacityTier &&
+                   idleRounds >= options.demoteIdleRounds) {
+            errorCode = item.second->Demote(capacityDir_ + "/" +
+                FileNameOperator::GenerateChunkFileName(item.first));
+        } else {
+            continue;
+        }
+        if (errorCode == CSErrorCode::ChunkNotExistError) {
+            continue;
+        }
+        if (errorCode != CSErrorCode::Success) {
+            LOG(WARNING) << "Move chunk between tiers failed."
+                         << " ChunkID = " << item.first
+                         << ", to capacity tier: " << !onCapacityTier;
+            continue;
+        }
+        ++migrated;
+    }
+    return migrated;
+}
+
+void CSDataStore::recoverTierTempFiles(vector<string>* files) {
+    size_t count = files->size();
+    for (size_t i = 0; i < count; ++i) {
+        ChunkID id;
+        if (!FileNameOperator::IsTierTempFile((*files)[i], &id)) {
+            continue;
+        }
+        string tempPath = baseDir_ + "/" + (*files)[i];
+        string chunkName = FileNameOperator::GenerateChunkFileName(id);
+        string chunkPath = baseDir_ + "/" + chunkName;
+        string target;
+        string chunkTarget;
+        if (lfs_->ReadLink(tempPath, &target) != 0) {
+            // Copied from the capacity tier but not renamed into place,
+            // the chunk is still on the capacity tier
+            chunkFilePool_->RecycleFile(tempPath);
+        } else if (!lfs_->FileExists(target) ||
+                   lfs_->ReadLink(chunkPath, &chunkTarget) == 0) {
+            // The copy is lost or the chunk file is already replaced, the
+            // orphan copy is removed with the capacity tier files
+            lfs_->Delete(tempPath);
+        } else {
+            // The copy on the capacity tier is complete and durable once the
+            // symlink is created, and the chunk file is no longer written,
+            // so it replaces the chunk file even if that's not recycled yet
+            bool listed = lfs_->FileExists(chunkPath);
+            if (listed && chunkFilePool_->RecycleFile(chunkPath) < 0) {
+                LOG(ERROR) << "Recycle " << chunkPath << " failed, the chunk"
+                           << " is kept on the fast tier.";
+                lfs_->Delete(tempPath);
+            } else if (lfs_->Rename(tempPath, chunkPath) == 0 && !listed) {
+                files->push_back(chunkName);
+            }
+        }
+        LOG(INFO) << "Recovered " << tempPath
+                  << " left by moving chunk between tiers.";
+    }
+}
+
+void CSDataStore::removeOrphanCapacityFiles() {
+    vector<string> files;
+    if (lfs_->List(capacityDir_, &files) < 0) {
+        LOG(WARNING) << "List " << capacityDir_ << " failed.";
+        return;
+    }
+    for (const auto& name : files) {
+        string capacityPath = capacityDir_ + "/" + name;
+        string target;
+        if (FileNameOperator::ParseFileName(name).type ==
+                FileNameOperator::FileType::CHUNK &&
+            lfs_->ReadLink(baseDir_ + "/" + name, &target) == 0 &&
+            target == capacityPath) {
+            continue;
+        }
+        LOG(INFO) << "Remove orphan file on capacity tier: " << capacityPath;
+        lfs_->Delete(capacityPath);
+    }
+}
+
 CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
     // If the chunk file has not been loaded yet, load it into metaCache
     if (metaCache_.Get(id) == nullptr) {
@@ -412,6 +635,7 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
         options.blockSize = blockSize_;
         options.metaPageSize = metaPageSize_;
         options.metric = metric_;
+        options.fdCache = fdCache_;
         CSChunkFilePtr chunkFilePtr =
             std::make_shared<CSChunkFile>(lfs_,
                                           chunkFilePool_,
@@ -424,9 +648,77 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSDataStore::GetChunkFile(ChunkID id,
+                                      CSChunkFilePtr* chunkFile) {
+    *chunkFile = metaCache_.Get(id);
+    if (*chunkFile != nullptr || !lazyLoadChunk_) {
+        return CSErrorCode::Success;
+    }
+
+    std::lock_guard<std::mutex> lk(loadMtx_);
+    auto iter = unloadedChunks_.find(id);
+    if (iter != unloadedChunks_.end()) {
+        CSErrorCode errorCode = loadUnloadedChunkLocked(id, iter->second);
+        if (errorCode != CSErrorCode::Success) {
+            return errorCode;
+        }
+        unloadedChunks_.erase(iter);
+    }
+    // It may have been loaded by others while waiting for the lock
+    *chunkFile = metaCache_.Get(id);
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSDataStore::loadUnloadedChunkLocked(ChunkID id,
+                                                 SequenceNum snapSn) {
+    CSErrorCode errorCode = loadChunkFile(id);
+    if (errorCode != CSErrorCode::Success) {
+        LOG(ERROR) << "Load chunk file failed, ChunkID = " << id;
+        return errorCode;
+    }
+    if (snapSn != kInvalidSeq) {
+        errorCode = metaCache_.Get(id)->LoadSnapshot(snapSn);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Load snapshot failed, ChunkID = " << id
+                       << ", snapshot sn = " << snapSn;
+            // Load it again with the snapshot next time
+            metaCache_.Remove(id);
+            return errorCode;
+        }
+    }
+    return CSErrorCode::Success;
+}
+
 ChunkMap CSDataStore::GetChunkMap() {
     return metaCache_.GetMap();
 }
 
+std::vector<ChunkID> CSDataStore::GetChunkIds() {
+    std::vector<ChunkID> ids;
+    {
+        // the chunks are moved from unloadedChunks_ to metaCache_ under
+        // loadMtx_, so none of them is missed
+        std::lock_guard<std::mutex> lk(loadMtx_);
+        ids.reserve(unloadedChunks_.size());
+        for (const auto& item : unloadedChunks_) {
+            ids.push_back(item.first);
+        }
+        for (const auto& item : metaCache_.GetMap()) {
+            ids.push_back(item.first);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+CSChunkFilePtr CSDataStore::LoadChunk(ChunkID id) {
+    CSChunkFilePtr chunkFile = nullptr;
+    if (GetChunkFile(id, &chunkFile) != CSErrorCode::Success) {
+        return nullptr;
+    }
+    return chunkFile;
+}
+
 }  // namespace chunkserver
 }  // namespace curve
@@ -30,6 +30,7 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <condition_variable>
 
 #include "include/curve_compiler_specific.h"
@@ -55,6 +56,11 @@ inline void TrivialDeleter(void* /*ptr*/) {}
  * chunkSize: The size of the chunk file or snapshot file in the DataStore
  * blockSize: the size of the smallest read-write unit
  * metaPageSize: meta page size for chunk
+ * lazyLoadChunk: open the chunk files on first access instead of when
+ *                initializing
+ * fdCache: cache of opened chunk files, keep all of them open if nullptr
+ * capacityDir: directory on the capacity tier (e.g. HDD) the cold chunks
+ *              are moved to, tiering is disabled if it is empty
  */
 struct DataStoreOptions {
     std::string                         baseDir;
@@ -63,6 +69,21 @@ struct DataStoreOptions {
     PageSizeType                        metaPageSize;
     uint32_t                            locationLimit;
     bool                                enableOdsyncWhenOpenChunkFile;
+    bool                                lazyLoadChunk = false;
+    std::shared_ptr<ChunkFdCache>       fdCache;
+    std::string                         capacityDir;
+};
+
+/**
+ * Options of moving chunks between the storage tiers
+ * promoteHeat: chunks on the capacity tier whose heat reaches it are moved
+ *              back to the fast tier
+ * demoteIdleRounds: chunks not accessed for so many periods are moved to
+ *                   the capacity tier
+ */
+struct ChunkTierOptions {
+    uint32_t promoteHeat = 64;
+    uint32_t demoteIdleRounds = 60;
 };
 
 /**
@@ -70,14 +91,17 @@ struct DataStoreOptions {
  * chunkFileCount: the number of chunks in the DataStore
  * snapshotCount: the number of snapshots in the DataStore
  * cloneChunkCount: the number of clone chunks
+ * capacityChunkCount: the number of chunks on the capacity tier
  */
 struct DataStoreStatus {
     uint32_t chunkFileCount;
     uint32_t snapshotCount;
     uint32_t cloneChunkCount;
+    uint32_t capacityChunkCount;
     DataStoreStatus() : chunkFileCount(0)
                     , snapshotCount(0)
-                    , cloneChunkCount(0) {}
+                    , cloneChunkCount(0)
+                    , capacityChunkCount(0) {}
 };
 
 /**
@@ -85,11 +109,13 @@ struct DataStoreStatus {
  * chunkFileCount: the number of chunks in the DataStore
  * snapshotCount: the number of snapshots in the DataStore
  * cloneChunkCount: the number of clone chunks
+ * capacityChunkCount: the number of chunks on the capacity tier
  */
 struct DataStoreMetric {
     bvar::Adder<uint32_t> chunkFileCount;
     bvar::Adder<uint32_t> snapshotCount;
     bvar::Adder<uint32_t> cloneChunkCount;
+    bvar::Adder<uint32_t> capacityChunkCount;
 };
 using DataStoreMetricPtr = std::shared_ptr<DataStoreMetric>;
 
@@ -254,6 +280,21 @@ class CSDataStore {
                                 uint32_t* cost,
                                 const std::string & cloneSourceLocation = "");
 
+    /**
+     * Write data, but try to remap the data with remapper instead of
+     * writing buf, e.g. from the wal segment holding the same data,
+     * see WriteChunk for the other params
+     * @param remapper: remaps the data into the chunk file
+     * @return: return error code
+     */
+    virtual CSErrorCode WriteChunkByRemap(ChunkID id,
+                                SequenceNum sn,
+                                const butil::IOBuf& buf,
+                                off_t offset,
+                                size_t length,
+                                uint32_t* cost,
+                                const DataRemapper& remapper,
+                                const std::string & cloneSourceLocation = "");
 
     virtual CSErrorCode SyncChunk(ChunkID id);
 
@@ -326,8 +367,47 @@ class CSDataStore {
      */
     virtual DataStoreStatus GetStatus();
 
+    /**
+     * Get the chunks loaded in metacache, the chunks not loaded yet with
+     * lazy loading enabled are not included, and they are not loaded here
+     * @return: the loaded chunks
+     */
     virtual ChunkMap GetChunkMap();
 
+    /**
+     * Get the ids of all the chunks, including the ones not loaded yet with
+     * lazy loading enabled, the chunks are not loaded here
+     * @return: the chunk ids in ascending order
+     */
+    virtual std::vector<ChunkID> GetChunkIds();
+
+    /**
+     * Get the chunk, it is loaded here if not loaded yet with lazy loading
+     * enabled
+     * @param id: the chunk id
+     * @return: nullptr if the chunk doesn't exist or failed to load
+     */
+    virtual CSChunkFilePtr LoadChunk(ChunkID id);
+
+    /**
+     * Called periodically to decay the heat of the chunks, move the cold
+     * chunks to the capacity tier and the hot ones back to the fast tier,
+     * the chunks not loaded yet are not moved
+     * @param options: thresholds to move the chunks
+     * @param maxMigrations: max number of chunks moved this time
+     * @return: the number of chunks moved
+     */
+    virtual uint32_t MigrateChunks(const ChunkTierOptions& options,
+                                   uint32_t maxMigrations);
+
+    /**
+     * Moving chunks between the tiers is paused while the returned lock is
+     * held, e.g. when the chunk files are replaced by installing snapshot
+     */
+    std::unique_lock<std::mutex> PauseTiering() {
+        return std::unique_lock<std::mutex>(tierMtx_);
+    }
+
     void SetCacheCondPtr(std::shared_ptr<std::condition_variable> cond) {
         metaCache_.SetCondPtr(cond);
     }
@@ -338,8 +418,25 @@ class CSDataStore {
 
  private:
     CSErrorCode loadChunkFile(ChunkID id);
+    /**
+     * Get the chunk file from metaCache, the chunk file found when
+     * initializing is loaded here if lazy loading is enabled
+     * @param id: the chunk id
+     * @param[out] chunkFile: nullptr if the chunk doesn't exist
+     * @return: return error code
+     */
+    CSErrorCode GetChunkFile(ChunkID id, CSChunkFilePtr* chunkFile);
+    CSErrorCode loadUnloadedChunkLocked(ChunkID id, SequenceNum snapSn);
     CSErrorCode CreateChunkFile(const ChunkOptions & ops,
                                 CSChunkFilePtr* chunkFile);
+    /**
+     * Finish or roll back moving the chunks interrupted by a crash, the
+     * chunks renamed into place are appended to |files|
+     * @param files: the files in the datastore directory
+     */
+    void recoverTierTempFiles(vector<string>* files);
+    // remove the files on the capacity tier not linked by any chunk
+    void removeOrphanCapacityFiles();
 
  private:
     // The size of each chunk
@@ -362,6 +459,19 @@ class CSDataStore {
     DataStoreMetricPtr metric_;
     // enable O_DSYNC When Open ChunkFile
     bool enableOdsyncWhenOpenChunkFile_;
+    // load chunk files on first access
+    bool lazyLoadChunk_;
+    // cache of opened chunk files shared by all datastores
+    std::shared_ptr<ChunkFdCache> fdCache_;
+    // protect unloadedChunks_, and serialize the loading of them
+    std::mutex loadMtx_;
+    // chunks found when initializing but not loaded yet,
+    // chunkid -> sn of its snapshot, kInvalidSeq if no snapshot
+    std::unordered_map<ChunkID, SequenceNum> unloadedChunks_;
+    // directory of the chunks on the capacity tier, empty if disabled
+    std::string capacityDir_;
+    // serialize moving chunks between the tiers and reloading the datastore
+    std::mutex tierMtx_;
 };
 
 }  // namespace chunkserver
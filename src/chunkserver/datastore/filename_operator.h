@@ -23,6 +23,7 @@
 #ifndef SRC_CHUNKSERVER_DATASTORE_FILENAME_OPERATOR_H_
 #define SRC_CHUNKSERVER_DATASTORE_FILENAME_OPERATOR_H_
 
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,8 @@ namespace chunkserver {
 using std::string;
 using std::vector;
 
+const char kTierTempSuffix[] = "_tier";
+
 class FileNameOperator {
  public:
     enum class FileType {
@@ -61,6 +64,28 @@ class FileNameOperator {
                 + "_snap_" + std::to_string(sn);
     }
 
+    // The temporary file used when moving a chunk between the storage tiers,
+    // it is parsed as UNKNOWN
+    static inline string GenerateTierTempName(ChunkID id) {
+        return GenerateChunkFileName(id) + kTierTempSuffix;
+    }
+
+    static inline bool IsTierTempFile(const string& fileName, ChunkID* id) {
+        const size_t suffixLen = strlen(kTierTempSuffix);
+        if (fileName.size() <= suffixLen ||
+            fileName.compare(fileName.size() - suffixLen, suffixLen,
+                             kTierTempSuffix) != 0) {
+            return false;
+        }
+        FileInfo info =
+            ParseFileName(fileName.substr(0, fileName.size() - suffixLen));
+        if (info.type != FileType::CHUNK) {
+            return false;
+        }
+        *id = info.id;
+        return true;
+    }
+
     static inline FileInfo ParseFileName(const string& fileName) {
         vector<string> elements;
         ::curve::common::SplitString(fileName, "_", &elements);
@@ -29,6 +29,7 @@
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include "src/fs/fs_common.h"
 #include "src/common/timeutility.h"
@@ -410,6 +411,30 @@ int Heartbeat::SendHeartbeat(const HeartbeatRequest& request,
     return 0;
 }
 
+void Heartbeat::UpdateVolumeQos(const HeartbeatResponse& response) {
+    if (options_.volumeQos == nullptr || !options_.volumeQos->Enabled()) {
+        return;
+    }
+    // the settings are not filled if mds rejects the heartbeat
+    switch (response.statuscode()) {
+    case curve::mds::heartbeat::hbOK:
+    case curve::mds::heartbeat::hbRequestNoCopyset:
+    case curve::mds::heartbeat::hbAnalyseCopysetError:
+        break;
+    default:
+        return;
+    }
+
+    std::unordered_map<uint64_t, VolumeQosParams> params;
+    for (const auto& qos : response.volumeqos()) {
+        VolumeQosParams& volume = params[qos.fileid()];
+        volume.reservation = qos.reservation();
+        volume.limit = qos.limit();
+        volume.weight = qos.weight();
+    }
+    options_.volumeQos->UpdateVolumeQos(params);
+}
+
 int Heartbeat::ExecTask(const HeartbeatResponse& response) {
     int count = response.needupdatecopysets_size();
     for (int i = 0; i < count; i ++) {
@@ -596,6 +621,8 @@ void Heartbeat::HeartbeatWorker() {
             continue;
         }
 
+        UpdateVolumeQos(resp);
+
         LOG(INFO) << "executing heartbeat info";
         ret = ExecTask(resp);
         if (ret != 0) {
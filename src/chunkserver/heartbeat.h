@@ -39,6 +39,7 @@
 #include "src/common/wait_interval.h"
 #include "src/common/concurrent/concurrent.h"
 #include "src/chunkserver/scan_manager.h"
+#include "src/chunkserver/volume_qos.h"
 #include "proto/heartbeat.pb.h"
 #include "proto/scan.pb.h"
 
@@ -69,6 +70,8 @@ struct HeartbeatOptions {
     uint32_t                timeout;
     CopysetNodeManager*     copysetNodeManager;
     ScanManager*            scanManager;
+    // updated by the volume qos settings in the response, may be nullptr
+    VolumeQosScheduler*     volumeQos = nullptr;
 
     std::shared_ptr<LocalFileSystem> fs;
     std::shared_ptr<FilePool> chunkFilePool;
@@ -140,6 +143,11 @@ class Heartbeat {
      */
     int ExecTask(const HeartbeatResponse& response);
 
+    /*
+     * 更新心跳回应中各卷的qos设置
+     */
+    void UpdateVolumeQos(const HeartbeatResponse& response);
+
     /*
      * 输出心跳请求信息
      */
@@ -32,6 +32,7 @@
 #include <string>
 
 #include "src/chunkserver/copyset_node.h"
+#include "src/chunkserver/raftlog/curve_segment_log_storage.h"
 #include "src/chunkserver/chunk_closure.h"
 #include "src/chunkserver/clone_manager.h"
 #include "src/chunkserver/clone_task.h"
@@ -134,11 +135,9 @@ int ChunkOpRequest::Encode(const ChunkRequest *request,
     return 0;
 }
 
-std::shared_ptr<ChunkOpRequest> ChunkOpRequest::Decode(butil::IOBuf log,
-                                                       ChunkRequest *request,
-                                                       butil::IOBuf *data,
-                                                       uint64_t index,
-                                                       PeerId leaderId) {
+std::shared_ptr<ChunkOpRequest> ChunkOpRequest::Decode(
+    butil::IOBuf log, ChunkRequest *request, butil::IOBuf *data,
+    uint64_t index, PeerId leaderId, CurveSegmentLogStorage *logStorage) {
     uint32_t metaSize = 0;
     log.cutn(&metaSize, sizeof(uint32_t));
     metaSize = butil::NetToHost32(metaSize);
@@ -158,7 +157,7 @@ std::shared_ptr<ChunkOpRequest> ChunkOpRequest::Decode(butil::IOBuf log,
         case CHUNK_OP_TYPE::CHUNK_OP_RECOVER:
             return std::make_shared<ReadChunkRequest>();
         case CHUNK_OP_TYPE::CHUNK_OP_WRITE:
-            return std::make_shared<WriteChunkRequest>();
+            return std::make_shared<WriteChunkRequest>(index, logStorage);
         case CHUNK_OP_TYPE::CHUNK_OP_DELETE:
             return std::make_shared<DeleteChunkRequest>();
         case CHUNK_OP_TYPE::CHUNK_OP_READ_SNAP:
@@ -429,22 +428,10 @@ void ReadChunkRequest::ReadChunk() {
 void WriteChunkRequest::OnApply(uint64_t index,
                                 ::google::protobuf::Closure *done) {
     brpc::ClosureGuard doneGuard(done);
-    uint32_t cost;
-
-    std::string  cloneSourceLocation;
-    if (existCloneInfo(request_)) {
-        auto func = ::curve::common::LocationOperator::GenerateCurveLocation;
-        cloneSourceLocation =  func(request_->clonefilesource(),
-                            request_->clonefileoffset());
-    }
 
-    auto ret = datastore_->WriteChunk(request_->chunkid(),
-                                      request_->sn(),
-                                      cntl_->request_attachment(),
-                                      request_->offset(),
-                                      request_->size(),
-                                      &cost,
-                                      cloneSourceLocation);
+    auto ret = WriteChunk(datastore_, *request_,
+                          cntl_->request_attachment(), index,
+                          node_->GetLogStorage());
 
     if (CSErrorCode::Success == ret) {
         response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
@@ -484,21 +471,7 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                                        const ChunkRequest &request,
                                        const butil::IOBuf &data) {
     // NOTE: 处理过程中优先使用参数传入的datastore/request
-    uint32_t cost;
-    std::string  cloneSourceLocation;
-    if (existCloneInfo(&request)) {
-        auto func = ::curve::common::LocationOperator::GenerateCurveLocation;
-        cloneSourceLocation =  func(request.clonefilesource(),
-                            request.clonefileoffset());
-    }
-
-    auto ret = datastore->WriteChunk(request.chunkid(),
-                                     request.sn(),
-                                     data,
-                                     request.offset(),
-                                     request.size(),
-                                     &cost,
-                                     cloneSourceLocation);
+    auto ret = WriteChunk(datastore, request, data, index_, logStorage_);
      if (CSErrorCode::Success == ret) {
          return;
      } else if (CSErrorCode::BackwardRequestError == ret) {
@@ -518,6 +491,44 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
     }
 }
 
+CSErrorCode WriteChunkRequest::WriteChunk(
+    std::shared_ptr<CSDataStore> datastore, const ChunkRequest &request,
+    const butil::IOBuf &data, uint64_t index,
+    CurveSegmentLogStorage *logStorage) {
+    uint32_t cost;
+    std::string  cloneSourceLocation;
+    if (existCloneInfo(&request)) {
+        auto func = ::curve::common::LocationOperator::GenerateCurveLocation;
+        cloneSourceLocation =  func(request.clonefilesource(),
+                            request.clonefileoffset());
+    }
+
+    // 只有大块写的数据在wal中是对齐的，clone chunk需要更新bitmap，不做remap
+    if (logStorage == nullptr || index == 0 ||
+        FLAGS_walLargeEntryThreshold == 0 ||
+        request.size() < FLAGS_walLargeEntryThreshold ||
+        !cloneSourceLocation.empty()) {
+        return datastore->WriteChunk(request.chunkid(),
+                                     request.sn(),
+                                     data,
+                                     request.offset(),
+                                     request.size(),
+                                     &cost,
+                                     cloneSourceLocation);
+    }
+    // 写请求的数据位于log entry的末尾
+    auto remapper = [logStorage, index](int fd, off_t offset, size_t length) {
+        return logStorage->RemapEntryDataTail(index, length, fd, offset);
+    };
+    return datastore->WriteChunkByRemap(request.chunkid(),
+                                        request.sn(),
+                                        data,
+                                        request.offset(),
+                                        request.size(),
+                                        &cost,
+                                        remapper);
+}
+
 void ReadSnapshotRequest::OnApply(uint64_t index,
                                   ::google::protobuf::Closure *done) {
     brpc::ClosureGuard doneGuard(done);
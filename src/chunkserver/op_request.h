@@ -48,6 +48,7 @@ class CloneManager;
 class CloneCore;
 class CloneTask;
 class ScanManager;
+class CurveSegmentLogStorage;
 
 
 inline bool existCloneInfo(const ChunkRequest *request) {
@@ -149,13 +150,14 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
      * @param log:op log entry
      * @param request: 出参，存放反序列上下文
      * @param data:出参，op操作的数据
+     * @param logStorage: log entry所在的log storage，写请求的数据可以直接
+     *                    从其中remap到chunk文件，为nullptr时正常写
      * @return nullptr,失败，否则返回相应的ChunkOpRequest
      */
-    static std::shared_ptr<ChunkOpRequest> Decode(butil::IOBuf log,
-                                                  ChunkRequest *request,
-                                                  butil::IOBuf *data,
-                                                  uint64_t index,
-                                                  PeerId leaderId);
+    static std::shared_ptr<ChunkOpRequest> Decode(
+        butil::IOBuf log, ChunkRequest *request, butil::IOBuf *data,
+        uint64_t index, PeerId leaderId,
+        CurveSegmentLogStorage *logStorage = nullptr);
 
     static ApplyTaskType Schedule(CHUNK_OP_TYPE opType);
 
@@ -249,7 +251,9 @@ class ReadChunkRequest : public ChunkOpRequest {
 class WriteChunkRequest : public ChunkOpRequest {
  public:
     WriteChunkRequest() :
-        ChunkOpRequest() {}
+        ChunkOpRequest(), index_(0), logStorage_(nullptr) {}
+    WriteChunkRequest(uint64_t index, CurveSegmentLogStorage *logStorage) :
+        ChunkOpRequest(), index_(index), logStorage_(logStorage) {}
     WriteChunkRequest(std::shared_ptr<CopysetNode> nodePtr,
                       RpcController *cntl,
                       const ChunkRequest *request,
@@ -259,13 +263,30 @@ class WriteChunkRequest : public ChunkOpRequest {
                        cntl,
                        request,
                        response,
-                       done) {}
+                       done),
+        index_(0), logStorage_(nullptr) {}
     virtual ~WriteChunkRequest() = default;
 
     void OnApply(uint64_t index, ::google::protobuf::Closure *done);
     void OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                         const ChunkRequest &request,
                         const butil::IOBuf &data) override;
+
+ private:
+    /**
+     * 写chunk，大块写的数据已经以对齐的方式落在wal中时，直接将其remap到
+     * chunk文件中，避免数据写两次，remap失败时datastore会退回到正常写
+     * @return datastore的返回值
+     */
+    static CSErrorCode WriteChunk(std::shared_ptr<CSDataStore> datastore,
+                                  const ChunkRequest &request,
+                                  const butil::IOBuf &data,
+                                  uint64_t index,
+                                  CurveSegmentLogStorage *logStorage);
+
+    // index of the log entry, only set when decoded from log
+    uint64_t index_;
+    CurveSegmentLogStorage *logStorage_;
 };
 
 class ReadSnapshotRequest : public ChunkOpRequest {
@@ -88,6 +88,16 @@ uint32_t GetDatastoreCloneChunkCountFunc(void* arg) {
     return cloneChunkCount;
 }
 
+uint32_t GetDatastoreCapacityChunkCountFunc(void* arg) {
+    CSDataStore* dataStore = reinterpret_cast<CSDataStore*>(arg);
+    uint32_t capacityChunkCount = 0;
+    if (dataStore != nullptr) {
+        DataStoreStatus status = dataStore->GetStatus();
+        capacityChunkCount = status.capacityChunkCount;
+    }
+    return capacityChunkCount;
+}
+
 uint32_t GetChunkTrashedFunc(void* arg) {
     Trash* trash = reinterpret_cast<Trash*>(arg);
     uint32_t chunkTrashed = 0;
@@ -97,6 +107,24 @@ uint32_t GetChunkTrashedFunc(void* arg) {
     return chunkTrashed;
 }
 
+uint64_t GetTrashRecycledFunc(void* arg) {
+    Trash* trash = reinterpret_cast<Trash*>(arg);
+    uint64_t recycled = 0;
+    if (trash != nullptr) {
+        recycled = trash->GetRecycledNum();
+    }
+    return recycled;
+}
+
+uint64_t GetVolumeQosQueuedFunc(void* arg) {
+    VolumeQosScheduler* volumeQos = reinterpret_cast<VolumeQosScheduler*>(arg);
+    uint64_t queued = 0;
+    if (volumeQos != nullptr) {
+        queued = volumeQos->GetQueuedNum();
+    }
+    return queued;
+}
+
 uint32_t GetTotalChunkCountFunc(void* arg) {
     uint32_t chunkCount = 0;
     ChunkServerMetric* csMetric = reinterpret_cast<ChunkServerMetric*>(arg);
@@ -24,6 +24,7 @@
 #define SRC_CHUNKSERVER_PASSIVE_GETFN_H_
 
 #include "src/chunkserver/trash.h"
+#include "src/chunkserver/volume_qos.h"
 #include "src/chunkserver/copyset_node_manager.h"
 #include "src/chunkserver/datastore/file_pool.h"
 #include "src/chunkserver/raftlog/curve_segment_log_storage.h"
@@ -51,6 +52,11 @@ namespace chunkserver {
      * @param arg: datastore的对象指针
      */
     uint32_t GetDatastoreCloneChunkCountFunc(void* arg);
+    /**
+     * 获取datastore中移到容量层的chunk的数量
+     * @param arg: datastore的对象指针
+     */
+    uint32_t GetDatastoreCapacityChunkCountFunc(void* arg);
     /**
      * 获取chunkserver上chunk文件的数量
      * @param arg: nullptr
@@ -87,6 +93,16 @@ namespace chunkserver {
      * @param arg: trash的对象指针
      */
     uint32_t GetChunkTrashedFunc(void* arg);
+    /**
+     * 获取trash已回收到filepool的文件总数
+     * @param arg: trash的对象指针
+     */
+    uint64_t GetTrashRecycledFunc(void* arg);
+    /**
+     * 获取volume qos中排队的请求数量
+     * @param arg: volume qos调度器的对象指针
+     */
+    uint64_t GetVolumeQosQueuedFunc(void* arg);
 
 }  // namespace chunkserver
 }  // namespace curve
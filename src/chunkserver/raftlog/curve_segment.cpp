@@ -39,6 +39,14 @@
 //          Xiong,Kai(xiongkai@baidu.com)
 
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <string.h>
+#include <linux/fs.h>
+#include <bthread/bthread.h>
 #include <butil/fd_utility.h>
 #include <butil/raw_pack.h>
 #include <braft/local_storage.pb.h>
@@ -52,6 +60,97 @@ namespace chunkserver {
 DEFINE_bool(raftSyncSegments, true, "call fsync when a segment is closed");
 DEFINE_bool(enableWalDirectWrite, true, "enable wal direct write or not");
 DEFINE_uint32(walAlignSize, 4096, "wal align size to write");
+DEFINE_bool(raftLogMmapClosedSegment, true,
+            "read the entries of closed segments through mmap");
+DEFINE_uint32(walLargeEntryThreshold, 0,
+              "pad the entries not smaller than this in front instead of at"
+              " the tail, so that the end of their data is aligned and can be"
+              " remapped into the chunk file, 0 means disabled. NOTE: the"
+              " segments written with it can't be read by older versions");
+
+// the padding in front of the data is kept in the low 16 bits of meta_field
+const uint32_t kMaxDataOffset = 0xFFFF;
+
+struct SegmentMapping {
+    char* addr;
+    size_t size;
+    // held by the segment and the readers copying entries out of it,
+    // protected by g_mappings_mutex
+    int64_t refs;
+};
+
+namespace {
+
+// set once the filesystem turns out not to support FICLONERANGE
+butil::atomic<bool> g_remap_unsupported(false);
+
+braft::raft_mutex_t g_mappings_mutex;
+
+// an I/O error of the mapped pages is raised as SIGBUS instead of EIO, the
+// reader copying from the mapping jumps back through this and fails the read
+thread_local sigjmp_buf* tls_mapping_jmp = nullptr;
+struct sigaction g_old_sigbus_action;
+pthread_once_t g_sigbus_once = PTHREAD_ONCE_INIT;
+
+void HandleSigbus(int sig, siginfo_t* info, void* context) {
+    if (tls_mapping_jmp != nullptr) {
+        siglongjmp(*tls_mapping_jmp, 1);
+    }
+    // not raised by copying from a mapped segment, restore the previous
+    // action and let the faulting instruction raise it again
+    sigaction(SIGBUS, &g_old_sigbus_action, nullptr);
+}
+
+void InstallSigbusHandler() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_sigaction = HandleSigbus;
+    action.sa_flags = SA_SIGINFO;
+    CHECK_EQ(0, sigaction(SIGBUS, &action, &g_old_sigbus_action))
+        << "Fail to install SIGBUS handler, " << berror();
+}
+
+// copy |len| bytes at |src| of a mapped segment to |dst|,
+// return -1 if the pages can't be read
+int CopyFromMapping(char* dst, const char* src, size_t len) {
+    sigjmp_buf jmp;
+    if (sigsetjmp(jmp, 1) != 0) {
+        tls_mapping_jmp = nullptr;
+        return -1;
+    }
+    tls_mapping_jmp = &jmp;
+    memcpy(dst, src, len);
+    tls_mapping_jmp = nullptr;
+    return 0;
+}
+
+SegmentMapping* MapSegment(int fd, size_t size) {
+    pthread_once(&g_sigbus_once, InstallSigbusHandler);
+    void* addr = ::mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+    return new SegmentMapping{static_cast<char*>(addr), size, 1};
+}
+
+void RefSegmentMapping(SegmentMapping* mapping) {
+    BAIDU_SCOPED_LOCK(g_mappings_mutex);
+    ++mapping->refs;
+}
+
+void UnrefSegmentMapping(SegmentMapping* mapping) {
+    {
+        BAIDU_SCOPED_LOCK(g_mappings_mutex);
+        if (--mapping->refs > 0) {
+            return;
+        }
+    }
+    ::munmap(mapping->addr, mapping->size);
+    delete mapping;
+}
+
+}  // namespace
 
 int CurveSegment::create() {
     if (!_is_open) {
@@ -104,12 +203,15 @@ struct CurveSegment::EntryHeader {
     uint32_t data_len;
     uint32_t data_real_len;
     uint32_t data_checksum;
+    // the zero padding between the header and the data
+    uint32_t data_offset;
 };
 
 std::ostream& operator<<(std::ostream& os,
                          const CurveSegment::EntryHeader& h) {
     os << "{term=" << h.term << ", type=" << h.type << ", data_len="
        << h.data_len << ", data_real_len=" << h.data_real_len
+       << ", data_offset=" << h.data_offset
        << ", checksum_type=" << h.checksum_type << ", data_checksum="
        << h.data_checksum << '}';
     return os;
@@ -173,7 +275,8 @@ int CurveSegment::load(braft::ConfigurationManager* configuration_manager) {
             // Header will be parsed again but it's fine as configuration
             // changing is rare
             if (_load_entry(entry_off, NULL, &data,
-                            header_size + header.data_real_len) != 0) {
+                            header_size + header.data_offset +
+                            header.data_real_len) != 0) {
                 break;
             }
             scoped_refptr<braft::LogEntry> entry = new braft::LogEntry();
@@ -315,6 +418,42 @@ int CurveSegment::_load_entry(off_t offset, EntryHeader* head,
 
     char header_buf[kEntryHeaderSize];
     const char *p = (const char *)buf.fetch(header_buf, kEntryHeaderSize);
+    EntryHeader tmp;
+    if (_parse_header(p, offset, &tmp) != 0) {
+        return -1;
+    }
+    if (head != NULL) {
+        *head = tmp;
+    }
+    if (data != NULL) {
+        const size_t data_end = kEntryHeaderSize + tmp.data_offset
+                                                 + tmp.data_real_len;
+        if (buf.length() < data_end) {
+            const size_t to_read = data_end - buf.length();
+            const ssize_t n = braft::file_pread(&buf, _fd,
+                                    offset + buf.length(), to_read);
+            if (n != (ssize_t)to_read) {
+                return n < 0 ? -1 : 1;
+            }
+        } else if (buf.length() > data_end) {
+            buf.pop_back(buf.length() - data_end);
+        }
+        CHECK_EQ(buf.length(), data_end);
+        buf.pop_front(kEntryHeaderSize + tmp.data_offset);
+        if (!verify_checksum(tmp.checksum_type, buf, tmp.data_checksum)) {
+            LOG(ERROR) << "Found corrupted data at offset="
+                       << offset + kEntryHeaderSize + tmp.data_offset
+                       << " header=" << tmp
+                       << " path: " << _path;
+            return -1;
+        }
+        data->swap(buf);
+    }
+    return 0;
+}
+
+int CurveSegment::_parse_header(const char* p, off_t offset,
+                                EntryHeader* head) const {
     int64_t term = 0;
     uint32_t meta_field;
     uint32_t data_len = 0;
@@ -335,41 +474,126 @@ int CurveSegment::_load_entry(off_t offset, EntryHeader* head,
     tmp.data_len = data_len;
     tmp.data_real_len = data_real_len;
     tmp.data_checksum = data_checksum;
+    tmp.data_offset = meta_field & kMaxDataOffset;
     if (!verify_checksum(tmp.checksum_type,
                         p, kEntryHeaderSize - 4, header_checksum)) {
         LOG(ERROR) << "Found corrupted header at offset=" << offset
                    << ", header=" << tmp << ", path: " << _path;
         return -1;
     }
-    if (head != NULL) {
-        *head = tmp;
+    if (static_cast<uint64_t>(tmp.data_offset) + tmp.data_real_len
+            > tmp.data_len) {
+        LOG(ERROR) << "Found invalid header at offset=" << offset
+                   << ", header=" << tmp << ", path: " << _path;
+        return -1;
     }
-    if (data != NULL) {
-        if (buf.length() < kEntryHeaderSize + data_real_len) {
-            const size_t to_read = kEntryHeaderSize + data_real_len
-                                                    - buf.length();
-            const ssize_t n = braft::file_pread(&buf, _fd,
-                                    offset + buf.length(), to_read);
-            if (n != (ssize_t)to_read) {
-                return n < 0 ? -1 : 1;
-            }
-        } else if (buf.length() > kEntryHeaderSize + data_real_len) {
-            buf.pop_back(buf.length() - kEntryHeaderSize - data_real_len);
+    *head = tmp;
+    return 0;
+}
+
+int CurveSegment::_load_entry_mapped(SegmentMapping* mapping, off_t offset,
+                                     EntryHeader* head, butil::IOBuf* data,
+                                     size_t length) const {
+    if (length < kEntryHeaderSize || offset + length > mapping->size) {
+        LOG(ERROR) << "Entry at offset=" << offset << " length=" << length
+                   << " is out of the mapped size " << mapping->size
+                   << ", path: " << _path;
+        return -1;
+    }
+    const char* p = mapping->addr + offset;
+    char header_buf[kEntryHeaderSize];
+    if (CopyFromMapping(header_buf, p, kEntryHeaderSize) != 0) {
+        LOG(ERROR) << "Fail to read the mapped header at offset=" << offset
+                   << ", path: " << _path;
+        return -1;
+    }
+    EntryHeader tmp;
+    if (_parse_header(header_buf, offset, &tmp) != 0) {
+        return -1;
+    }
+    if (kEntryHeaderSize + tmp.data_offset + tmp.data_real_len > length) {
+        LOG(ERROR) << "Found corrupted header at offset=" << offset
+                   << ", header=" << tmp << ", length=" << length
+                   << ", path: " << _path;
+        return -1;
+    }
+    // the data is copied out rather than referring to the mapped pages, as
+    // the file is rewritten once the segment is truncated or recycled while
+    // the entries may still be in use, e.g. by the replicator
+    butil::IOBuf buf;
+    if (tmp.data_real_len > 0) {
+        char* copy = static_cast<char*>(malloc(tmp.data_real_len));
+        if (copy == nullptr) {
+            return -1;
         }
-        CHECK_EQ(buf.length(), kEntryHeaderSize + data_real_len);
-        buf.pop_front(kEntryHeaderSize);
-        if (!verify_checksum(tmp.checksum_type, buf, tmp.data_checksum)) {
-            LOG(ERROR) << "Found corrupted data at offset="
-                       << offset + kEntryHeaderSize
-                       << " header=" << tmp
-                       << " path: " << _path;
+        const char* data_addr = p + kEntryHeaderSize + tmp.data_offset;
+        if (CopyFromMapping(copy, data_addr, tmp.data_real_len) != 0) {
+            LOG(ERROR) << "Fail to read the mapped data at offset="
+                       << offset + kEntryHeaderSize + tmp.data_offset
+                       << ", header=" << tmp << ", path: " << _path;
+            free(copy);
+            return -1;
+        }
+        if (buf.append_user_data(copy, tmp.data_real_len, free) != 0) {
+            free(copy);
             return -1;
         }
-        data->swap(buf);
     }
+    if (!verify_checksum(tmp.checksum_type, buf, tmp.data_checksum)) {
+        LOG(ERROR) << "Found corrupted data at offset="
+                   << offset + kEntryHeaderSize + tmp.data_offset
+                   << " header=" << tmp
+                   << " path: " << _path;
+        return -1;
+    }
+    *head = tmp;
+    data->swap(buf);
     return 0;
 }
 
+SegmentMapping* CurveSegment::_acquire_mapping() const {
+    if (!FLAGS_raftLogMmapClosedSegment) {
+        return nullptr;
+    }
+    BAIDU_SCOPED_LOCK(_mutex);
+    if (_is_open || _meta.bytes <= 0) {
+        return nullptr;
+    }
+    if (_mapping == nullptr) {
+        _mapping = MapSegment(_fd, _meta.bytes);
+        if (_mapping == nullptr) {
+            PLOG_EVERY_N(WARNING, 100) << "Fail to mmap segment, path: "
+                                       << _path << " first_index: "
+                                       << _first_index;
+            return nullptr;
+        }
+    }
+    RefSegmentMapping(_mapping);
+    return _mapping;
+}
+
+void CurveSegment::_unmap(bool wait_readers) {
+    SegmentMapping* mapping = nullptr;
+    {
+        BAIDU_SCOPED_LOCK(_mutex);
+        std::swap(mapping, _mapping);
+    }
+    if (mapping == nullptr) {
+        return;
+    }
+    // the readers only hold the mapping while copying one entry out of it
+    while (wait_readers) {
+        {
+            BAIDU_SCOPED_LOCK(g_mappings_mutex);
+            if (mapping->refs <= 1) {
+                break;
+            }
+        }
+        bthread_usleep(100);
+    }
+    UnrefSegmentMapping(mapping);
+}
+
 int CurveSegment::append(const braft::LogEntry* entry) {
     if (BAIDU_UNLIKELY(!entry || !_is_open)) {
         return EINVAL;
@@ -411,7 +635,22 @@ int CurveSegment::append(const braft::LogEntry* entry) {
         zero_bytes_num = (to_write / FLAGS_walAlignSize + 1) *
                                         FLAGS_walAlignSize - to_write;
     }
-    data.resize(data.length() + zero_bytes_num);
+    // the padding of large entries is put in front of the data, so that the
+    // data ends on an aligned boundary and its aligned tail, which is the
+    // payload of the write request, can be remapped into the chunk file
+    // instead of being written again, see remap_data_tail()
+    uint32_t data_offset = 0;
+    if (FLAGS_walLargeEntryThreshold > 0 &&
+        real_length >= FLAGS_walLargeEntryThreshold &&
+        zero_bytes_num <= kMaxDataOffset) {
+        data_offset = zero_bytes_num;
+        butil::IOBuf padded;
+        padded.resize(data_offset);
+        padded.append(data);
+        data.swap(padded);
+    } else {
+        data.resize(data.length() + zero_bytes_num);
+    }
     to_write = kEntryHeaderSize + data.length();
     CHECK_LE(data.length(), 1ul << 56ul);
     char* write_buf = nullptr;
@@ -424,7 +663,8 @@ int CurveSegment::append(const braft::LogEntry* entry) {
         write_buf = new char[kEntryHeaderSize];
     }
 
-    const uint32_t meta_field = (entry->type << 24) | (_checksum_type << 16);
+    const uint32_t meta_field = (entry->type << 24) | (_checksum_type << 16)
+                                | data_offset;
     butil::RawPacker packer(write_buf);
     packer.pack64(entry->id.term)
           .pack32(meta_field)
@@ -434,7 +674,7 @@ int CurveSegment::append(const braft::LogEntry* entry) {
     packer.pack32(get_checksum(
                   _checksum_type, write_buf, kEntryHeaderSize - 4));
     if (FLAGS_enableWalDirectWrite) {
-        data.copy_to(write_buf + kEntryHeaderSize, real_length);
+        data.copy_to(write_buf + kEntryHeaderSize, data_offset + real_length);
         int ret = ::pwrite(_direct_fd, write_buf, to_write, _meta.bytes);
         free(write_buf);
         if (ret != static_cast<int>(to_write)) {
@@ -507,8 +747,18 @@ braft::LogEntry* CurveSegment::get(const int64_t index) const {
         braft::ConfigurationPBMeta configuration_meta;
         EntryHeader header;
         butil::IOBuf data;
-        if (_load_entry(meta.offset, &header, &data,
-                        meta.length) != 0) {
+        // closed segments are read through mmap to avoid a pread for every
+        // entry when followers are catching up
+        SegmentMapping* mapping = _acquire_mapping();
+        int rc = 0;
+        if (mapping != nullptr) {
+            rc = _load_entry_mapped(mapping, meta.offset, &header, &data,
+                                    meta.length);
+            UnrefSegmentMapping(mapping);
+        } else {
+            rc = _load_entry(meta.offset, &header, &data, meta.length);
+        }
+        if (rc != 0) {
             ok = false;
             break;
         }
@@ -589,6 +839,57 @@ int64_t CurveSegment::get_term(const int64_t index) const {
     return meta.term;
 }
 
+int CurveSegment::remap_data_tail(const int64_t index, size_t length,
+                                  int fd, off_t offset) const {
+#ifdef FICLONERANGE
+    if (g_remap_unsupported.load(butil::memory_order_relaxed) ||
+        length == 0 || length % FLAGS_walAlignSize != 0 ||
+        offset % FLAGS_walAlignSize != 0) {
+        return -1;
+    }
+    LogMeta meta;
+    if (_get_meta(index, &meta) != 0) {
+        return -1;
+    }
+    char header_buf[kEntryHeaderSize];
+    if (::pread(_fd, header_buf, kEntryHeaderSize, meta.offset)
+            != static_cast<ssize_t>(kEntryHeaderSize)) {
+        return -1;
+    }
+    EntryHeader header;
+    if (_parse_header(header_buf, meta.offset, &header) != 0 ||
+        header.data_real_len < length) {
+        return -1;
+    }
+    const off_t data_end = meta.offset + kEntryHeaderSize
+                           + header.data_offset + header.data_real_len;
+    if (data_end % FLAGS_walAlignSize != 0) {
+        // written without FLAGS_walLargeEntryThreshold
+        return -1;
+    }
+    struct file_clone_range range;
+    range.src_fd = _fd;
+    range.src_offset = data_end - length;
+    range.src_length = length;
+    range.dest_offset = offset;
+    if (::ioctl(fd, FICLONERANGE, &range) != 0) {
+        if (errno == EOPNOTSUPP || errno == EXDEV || errno == ENOTTY) {
+            LOG(WARNING) << "Remapping wal data into chunk files is not "
+                         << "supported by the filesystem, path: " << _path
+                         << ", error: " << berror();
+            g_remap_unsupported.store(true, butil::memory_order_relaxed);
+        } else {
+            PLOG_EVERY_N(WARNING, 100) << "Fail to remap entry " << index
+                                       << " of " << _path;
+        }
+        return -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
 int CurveSegment::close(bool will_sync) {
     CHECK(_is_open);
 
@@ -642,6 +943,8 @@ int CurveSegment::sync(bool will_sync) {
 }
 
 int CurveSegment::unlink() {
+    // the file will be reused by other segments
+    _unmap(true);
     std::string path(_path);
     if (_is_open) {
         butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN,
@@ -691,6 +994,8 @@ int CurveSegment::truncate(const int64_t last_index_kept) {
             return ret;
         }
         _is_open = true;
+        // the truncated part will be overwritten by new entries
+        _unmap(true);
     }
 
     _meta.bytes = truncate_size;
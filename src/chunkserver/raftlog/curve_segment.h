@@ -60,6 +60,11 @@ namespace curve {
 namespace chunkserver {
 
 DECLARE_bool(enableWalDirectWrite);
+DECLARE_bool(raftLogMmapClosedSegment);
+DECLARE_uint32(walAlignSize);
+DECLARE_uint32(walLargeEntryThreshold);
+
+struct SegmentMapping;
 
 struct CurveSegmentMeta {
     CurveSegmentMeta() : bytes(0) {}
@@ -72,7 +77,7 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
     CurveSegment(const std::string& path, const int64_t first_index,
                  int checksum_type, std::shared_ptr<FilePool> walFilePool)
         : _path(path), _meta(CurveSegmentMeta()),
-        _fd(-1), _direct_fd(-1), _is_open(true),
+        _fd(-1), _direct_fd(-1), _mapping(nullptr), _is_open(true),
         _first_index(first_index), _last_index(first_index - 1),
         _checksum_type(checksum_type),
         _walFilePool(walFilePool),
@@ -82,13 +87,16 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
                  const int64_t last_index, int checksum_type,
                  std::shared_ptr<FilePool> walFilePool)
         : _path(path), _meta(CurveSegmentMeta()),
-        _fd(-1), _direct_fd(-1), _is_open(false),
+        _fd(-1), _direct_fd(-1), _mapping(nullptr), _is_open(false),
         _first_index(first_index), _last_index(last_index),
         _checksum_type(checksum_type),
         _walFilePool(walFilePool),
         _meta_page_size(walFilePool->GetFilePoolOpt().metaPageSize) {
     }
     ~CurveSegment() {
+        // a reader may still be copying from the mapping,
+        // it's unmapped after the reader is done
+        _unmap(false);
         if (_fd >= 0) {
             ::close(_fd);
             _fd = -1;
@@ -146,6 +154,14 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
     }
 
     std::string file_name() override;
+
+    // the data of the entries not smaller than FLAGS_walLargeEntryThreshold
+    // ends on a FLAGS_walAlignSize boundary, so its aligned tail can be
+    // cloned into the chunk file with FICLONERANGE, which requires the
+    // filesystem to support reflink (e.g. xfs with reflink=1)
+    int remap_data_tail(const int64_t index, size_t length,
+                        int fd, off_t offset) const override;
+
  private:
     struct LogMeta {
         off_t offset;
@@ -156,6 +172,25 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
     int _load_entry(off_t offset, EntryHeader *head, butil::IOBuf *body,
                     size_t size_hint) const;
 
+    // parse and verify the entry header at |offset|
+    int _parse_header(const char* p, off_t offset, EntryHeader* head) const;
+
+    // load the entry of |length| bytes at |offset| from the mapped segment,
+    // fail if the mapped pages can't be read
+    int _load_entry_mapped(SegmentMapping* mapping, off_t offset,
+                           EntryHeader* head, butil::IOBuf* body,
+                           size_t length) const;
+
+    // map the closed segment if it's not mapped yet, return nullptr if the
+    // segment is open or can't be mapped, the returned mapping should be
+    // released by UnrefSegmentMapping()
+    SegmentMapping* _acquire_mapping() const;
+
+    // release the mapping of the segment before it's truncated or unlinked,
+    // if |wait_readers| is true, wait until the readers copying entries out
+    // of it are done, as the file will be rewritten
+    void _unmap(bool wait_readers);
+
     int _get_meta(int64_t index, LogMeta* meta) const;
 
     int _load_meta();
@@ -167,6 +202,8 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
     mutable braft::raft_mutex_t _mutex;
     int _fd;
     int _direct_fd;
+    // mapping of the closed segment, protected by _mutex
+    mutable SegmentMapping* _mapping;
     bool _is_open;
     const int64_t _first_index;
     butil::atomic<int64_t> _last_index;
@@ -38,6 +38,8 @@
 //          Zhangyi Chen(chenzhangyi01@baidu.com)
 //          Xiong,Kai(xiongkai@baidu.com)
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <braft/protobuf_file.h>
 #include <braft/local_storage.pb.h>
 #include "src/chunkserver/raftlog/curve_segment_log_storage.h"
@@ -47,6 +49,15 @@
 namespace curve {
 namespace chunkserver {
 
+DEFINE_bool(raftLogPrefetchOnLoad, true,
+            "prefetch raft log segments while initializing the datastore "
+            "when loading copyset");
+// disabled by default, as it's in addition to the memory log of braft and
+// the budget is per copyset
+DEFINE_uint64(raftLogEntryCacheBytes, 0,
+              "max bytes of the recently appended or read log entries "
+              "cached by each copyset, 0 means disabled");
+
 LogStorageOptions StoreOptForCurveSegmentLogStorage(
     LogStorageOptions options) {
     static LogStorageOptions options_;
@@ -63,6 +74,39 @@ void RegisterCurveSegmentLogStorageOrDie() {
                                     "curve", &logStorage);
 }
 
+int PrefetchSegments(const std::string& path) {
+    butil::DirReaderPosix dir_reader(path.c_str());
+    if (!dir_reader.IsValid()) {
+        return 0;
+    }
+
+    int count = 0;
+    while (dir_reader.Next()) {
+        const char* name = dir_reader.name();
+        size_t len = strlen(name);
+        if (strstr(name, "log_") == nullptr ||
+            0 == strcmp(name, BRAFT_SEGMENT_META_FILE) ||
+            (len >= strlen(".tmp") &&
+             0 == strcmp(name + len - strlen(".tmp"), ".tmp"))) {
+            continue;
+        }
+        std::string segment_path(path);
+        segment_path.append("/").append(name);
+        int fd = ::open(segment_path.c_str(), O_RDONLY | O_NOATIME);
+        if (fd < 0) {
+            PLOG(WARNING) << "Fail to open " << segment_path;
+            continue;
+        }
+        // readahead is done in background, the page cache is kept after
+        // the fd is closed
+        if (::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0) {
+            ++count;
+        }
+        ::close(fd);
+    }
+    return count;
+}
+
 int CurveSegmentLogStorage::init(
                     braft::ConfigurationManager* configuration_manager) {
     butil::FilePath dir_path(_path);
@@ -356,11 +400,91 @@ int64_t CurveSegmentLogStorage::last_log_index() {
 }
 
 braft::LogEntry* CurveSegmentLogStorage::get_entry(const int64_t index) {
+    braft::LogEntry* entry = get_cached_entry(index);
+    if (entry != NULL) {
+        return entry;
+    }
+    scoped_refptr<Segment> ptr;
+    if (get_segment(index, &ptr) != 0) {
+        return NULL;
+    }
+    entry = ptr->get(index);
+    if (entry != NULL) {
+        cache_entry(entry);
+    }
+    return entry;
+}
+
+int CurveSegmentLogStorage::RemapEntryDataTail(int64_t index, size_t length,
+                                               int fd, off_t offset) {
+    // the leader may apply the entry before it's written to the local log
+    if (index > last_log_index()) {
+        return -1;
+    }
     scoped_refptr<Segment> ptr;
     if (get_segment(index, &ptr) != 0) {
+        return -1;
+    }
+    return ptr->remap_data_tail(index, length, fd, offset);
+}
+
+braft::LogEntry* CurveSegmentLogStorage::get_cached_entry(int64_t index) {
+    if (FLAGS_raftLogEntryCacheBytes == 0) {
         return NULL;
     }
-    return ptr->get(index);
+    BAIDU_SCOPED_LOCK(_cache_mutex);
+    auto it = _cache_index.find(index);
+    if (it == _cache_index.end()) {
+        return NULL;
+    }
+    _cache_lru.splice(_cache_lru.begin(), _cache_lru, it->second);
+    braft::LogEntry* entry = *it->second;
+    entry->AddRef();
+    return entry;
+}
+
+void CurveSegmentLogStorage::cache_entry(braft::LogEntry* entry) {
+    if (FLAGS_raftLogEntryCacheBytes == 0) {
+        return;
+    }
+    entry->AddRef();
+    BAIDU_SCOPED_LOCK(_cache_mutex);
+    auto it = _cache_index.find(entry->id.index);
+    if (it != _cache_index.end()) {
+        braft::LogEntry* old = *it->second;
+        _cache_bytes -= old->data.size() + sizeof(braft::LogEntry);
+        old->Release();
+        _cache_lru.erase(it->second);
+    }
+    _cache_lru.push_front(entry);
+    _cache_index[entry->id.index] = _cache_lru.begin();
+    _cache_bytes += entry->data.size() + sizeof(braft::LogEntry);
+    while (_cache_bytes > FLAGS_raftLogEntryCacheBytes &&
+           !_cache_lru.empty()) {
+        braft::LogEntry* victim = _cache_lru.back();
+        _cache_lru.pop_back();
+        _cache_index.erase(victim->id.index);
+        _cache_bytes -= victim->data.size() + sizeof(braft::LogEntry);
+        victim->Release();
+    }
+}
+
+void CurveSegmentLogStorage::evict_cached_entries(int64_t first_index_kept,
+                                                  int64_t last_index_kept) {
+    BAIDU_SCOPED_LOCK(_cache_mutex);
+    for (auto it = _cache_lru.begin(); it != _cache_lru.end();) {
+        braft::LogEntry* entry = *it;
+        if (first_index_kept <= last_index_kept &&
+            entry->id.index >= first_index_kept &&
+            entry->id.index <= last_index_kept) {
+            ++it;
+            continue;
+        }
+        _cache_index.erase(entry->id.index);
+        _cache_bytes -= entry->data.size() + sizeof(braft::LogEntry);
+        entry->Release();
+        it = _cache_lru.erase(it);
+    }
 }
 
 int CurveSegmentLogStorage::get_segment(int64_t index,
@@ -417,6 +541,7 @@ int CurveSegmentLogStorage::append_entry(const braft::LogEntry* entry) {
         return EINVAL;
     }
     _last_log_index.fetch_add(1, butil::memory_order_release);
+    cache_entry(const_cast<braft::LogEntry*>(entry));
 
     return segment->sync(_enable_sync);
 }
@@ -448,6 +573,7 @@ int CurveSegmentLogStorage::append_entries(
             return i;
         }
         _last_log_index.fetch_add(1, butil::memory_order_release);
+        cache_entry(entry);
         last_segment = segment;
     }
     last_segment->sync(_enable_sync);
@@ -474,6 +600,8 @@ int CurveSegmentLogStorage::truncate_prefix(const int64_t first_index_kept) {
     }
     std::vector<scoped_refptr<Segment> > popped;
     pop_segments(first_index_kept, &popped);
+    // release the entries referring to the segments to unlink
+    evict_cached_entries(first_index_kept, INT64_MAX);
     for (size_t i = 0; i < popped.size(); ++i) {
         popped[i]->unlink();
         popped[i] = NULL;
@@ -572,6 +700,7 @@ void CurveSegmentLogStorage::pop_segments_from_back(
 }
 
 int CurveSegmentLogStorage::truncate_suffix(const int64_t last_index_kept) {
+    evict_cached_entries(1, last_index_kept);
     // segment files
     std::vector<scoped_refptr<Segment> > popped;
     scoped_refptr<Segment> last_segment;
@@ -638,6 +767,7 @@ int CurveSegmentLogStorage::reset(const int64_t next_log_index) {
     _first_log_index.store(next_log_index, butil::memory_order_relaxed);
     _last_log_index.store(next_log_index - 1, butil::memory_order_relaxed);
     lck.unlock();
+    evict_cached_entries(1, 0);
     // NOTE: see the comments in truncate_prefix
     if (save_meta(next_log_index) != 0) {
         PLOG(ERROR) << "Fail to save meta, path: " << _path;
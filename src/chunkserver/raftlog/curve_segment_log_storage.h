@@ -47,7 +47,10 @@
 #include <braft/log_entry.h>
 #include <braft/storage.h>
 #include <braft/util.h>
+#include <gflags/gflags.h>
+#include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <functional>
@@ -60,6 +63,9 @@
 namespace curve {
 namespace chunkserver {
 
+DECLARE_bool(raftLogPrefetchOnLoad);
+DECLARE_uint64(raftLogEntryCacheBytes);
+
 class CurveSegmentLogStorage;
 
 struct LogStorageOptions {
@@ -84,6 +90,11 @@ LogStorageOptions StoreOptForCurveSegmentLogStorage(LogStorageOptions options);
 
 void RegisterCurveSegmentLogStorageOrDie();
 
+// Ask the kernel to read the segments under |path| asynchronously, so that
+// load_segments() can find them in page cache when the log storage is inited
+// later, return the number of segments prefetched
+int PrefetchSegments(const std::string& path);
+
 // LogStorage use segmented append-only file, all data in disk, all index
 // in memory. append one log entry, only cause one disk write, every disk
 // write will call fsync().
@@ -101,13 +112,15 @@ class CurveSegmentLogStorage : public braft::LogStorage {
         std::shared_ptr<FilePool> walFilePool = nullptr)
         : _path(path), _first_log_index(1), _last_log_index(0),
           _walFilePool(walFilePool), _checksum_type(0),
-          _enable_sync(enable_sync) {}
+          _enable_sync(enable_sync), _cache_bytes(0) {}
 
     CurveSegmentLogStorage()
         : _first_log_index(1), _last_log_index(0), _walFilePool(nullptr),
-          _checksum_type(0), _enable_sync(true) {}
+          _checksum_type(0), _enable_sync(true), _cache_bytes(0) {}
 
-    virtual ~CurveSegmentLogStorage() {}
+    virtual ~CurveSegmentLogStorage() {
+        evict_cached_entries(1, 0);
+    }
 
     // init logstorage, check consistency and integrity
     virtual int init(braft::ConfigurationManager *configuration_manager);
@@ -152,6 +165,12 @@ class CurveSegmentLogStorage : public braft::LogStorage {
 
     LogStorageStatus GetStatus();
 
+    // share the disk blocks holding the last |length| bytes of the entry at
+    // |index| with |fd| at |offset| instead of writing them again, return 0
+    // on success, see CurveSegment::remap_data_tail()
+    int RemapEntryDataTail(int64_t index, size_t length, int fd,
+                           off_t offset);
+
  private:
     scoped_refptr<Segment> open_segment(size_t to_write);
     int save_meta(const int64_t log_index);
@@ -165,6 +184,13 @@ class CurveSegmentLogStorage : public braft::LogStorage {
                                 std::vector<scoped_refptr<Segment>> *popped,
                                 scoped_refptr<Segment> *last_segment);
 
+    // get the entry from the recent entry cache, NULL if not cached
+    braft::LogEntry *get_cached_entry(int64_t index);
+    void cache_entry(braft::LogEntry *entry);
+    // drop the cached entries out of [first_index_kept, last_index_kept],
+    // drop all of them if first_index_kept > last_index_kept
+    void evict_cached_entries(int64_t first_index_kept,
+                              int64_t last_index_kept);
 
     std::string _path;
     butil::atomic<int64_t> _first_log_index;
@@ -175,6 +201,14 @@ class CurveSegmentLogStorage : public braft::LogStorage {
     std::shared_ptr<FilePool> _walFilePool;
     int _checksum_type;
     bool _enable_sync;
+
+    // recently appended or read entries, so that the followers catching up
+    // don't read the same entries from disk again, most recently used first
+    braft::raft_mutex_t _cache_mutex;
+    std::list<braft::LogEntry *> _cache_lru;
+    std::unordered_map<int64_t, std::list<braft::LogEntry *>::iterator>
+        _cache_index;
+    size_t _cache_bytes;
 };
 
 }  // namespace chunkserver
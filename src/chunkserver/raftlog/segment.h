@@ -71,6 +71,15 @@ class Segment : public butil::RefCountedThreadSafe<Segment> {
     virtual int64_t last_index() const = 0;
 
     virtual std::string file_name() = 0;
+
+    // share the disk blocks holding the last |length| bytes of the entry at
+    // |index| with the file |fd| at |offset| instead of copying them,
+    // return 0 on success, -1 if it's not supported or possible
+    virtual int remap_data_tail(const int64_t /* index */,
+                                size_t /* length */, int /* fd */,
+                                off_t /* offset */) const {
+        return -1;
+    }
 };
 
 }  // namespace chunkserver
@@ -43,6 +43,7 @@
 #include <brpc/closure_guard.h>
 #include <brpc/controller.h>
 #include <braft/util.h>
+#include <string.h>
 #include <stack>
 #include "src/chunkserver/raftsnapshot/curve_file_service.h"
 
@@ -148,14 +149,58 @@ void CurveFileService::get_file(::google::protobuf::RpcController* controller,
             is_eof = true;
             read_count = buf.size();
         }
+    } else if (butil::StringPiece(request->filename()).ends_with(
+                                            RAFT_SNAP_BLOCK_HASH_SUFFIX)) {
+        // 2. 如果是read文件的block hash，count为block大小
+        const std::string& name = request->filename();
+        std::string filename = name.substr(
+                        0, name.size() - strlen(RAFT_SNAP_BLOCK_HASH_SUFFIX));
+        CurveSnapshotFileReader *curveReader =
+                    dynamic_cast<CurveSnapshotFileReader*>(reader.get());
+        if (curveReader == nullptr) {
+            LOG(ERROR) << "reader cannot be dynamic_cast"
+                          " to CurveSnapshotFileReader";
+            cntl->SetFailed(ENXIO, "Fail to case reader=%" PRId64,
+                            request->reader_id());
+            return;
+        }
+        const int rc = curveReader->read_block_hash(&buf, filename,
+                                                    request->offset(),
+                                                    request->count(),
+                                                    &read_count, &is_eof);
+        if (rc != 0) {
+            cntl->SetFailed(rc, "Fail to read block hash from path=%s "
+                            "filename=%s : %s", reader->path().c_str(),
+                            filename.c_str(), berror(rc));
+            return;
+        }
     } else {
-        // 2. 否则其它文件下载继续走raft原先的文件下载流程
-        const int rc = reader->read_file(
-                                &buf, request->filename(),
+        // 3. 否则其它文件下载继续走raft原先的文件下载流程，
+        // 如果是curve的reader，只传输文件中已分配的数据
+        CurveSnapshotFileReader *curveReader =
+                    dynamic_cast<CurveSnapshotFileReader*>(reader.get());
+        int rc = 0;
+        if (curveReader != nullptr) {
+            braft::FileSegData seg_data;
+            rc = curveReader->read_file_segments(
+                                &seg_data, request->filename(),
                                 request->offset(), request->count(),
                                 request->read_partly(),
                                 &read_count,
                                 &is_eof);
+            if (rc == 0) {
+                response->set_eof(is_eof);
+                response->set_read_size(read_count);
+                cntl->response_attachment().swap(seg_data.data());
+                return;
+            }
+        } else {
+            rc = reader->read_file(&buf, request->filename(),
+                                   request->offset(), request->count(),
+                                   request->read_partly(),
+                                   &read_count,
+                                   &is_eof);
+        }
         if (rc != 0) {
             cntl->SetFailed(rc, "Fail to read from path=%s filename=%s : %s",
                             reader->path().c_str(),
@@ -78,8 +78,9 @@ braft::FileAdaptor* CurveFilesystemAdaptor::open(const std::string& path,
     if (!NeedFilter(path) &&
         (oflag & O_CREAT) &&
         false == lfs_->FileExists(path)) {
-        // 从chunkfile pool中取出chunk返回
-        int rc = chunkFilePool_->GetFile(path, tempMetaPageContent);
+        // 从chunkfile pool中取出chunk返回，下载快照时会跳过远端文件中的空洞，
+        // 所以需要取清零过的chunk
+        int rc = chunkFilePool_->GetFile(path, tempMetaPageContent, true);
         // 如果从FilePool中取失败，返回错误。
         if (rc != 0) {
             LOG(ERROR) << "get chunk from chunkfile pool failed!";
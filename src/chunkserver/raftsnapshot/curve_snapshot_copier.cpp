@@ -41,9 +41,36 @@
 
 #include "src/chunkserver/raftsnapshot/curve_snapshot_copier.h"
 
+#include <brpc/controller.h>
+#include <butil/strings/string_number_conversions.h>
+#include <algorithm>
+#include <deque>
+
+#include "src/chunkserver/raftsnapshot/curve_snapshot_file_reader.h"
+
+namespace braft {
+    DECLARE_int32(raft_max_byte_count_per_rpc);
+}
+
 namespace curve {
 namespace chunkserver {
 
+DEFINE_uint32(raftSnapshotDeltaBlockSize, 64 * 1024,
+              "block size to compare with local chunk file when installing "
+              "snapshot, only blocks with different sha256 are downloaded, "
+              "it should be in [4KB, raft_max_byte_count_per_rpc], "
+              "otherwise (e.g. 0) always download the whole file");
+DEFINE_uint32(raftSnapshotCopyConcurrency, 4,
+              "max number of files downloaded concurrently when installing "
+              "snapshot");
+
+namespace {
+
+const int kDeltaCopyTimeoutMs = 10000;
+const int kDeltaCopyRetryIntervalUs = 100 * 1000;
+
+}  // namespace
+
 CurveSnapshotCopier::CurveSnapshotCopier(CurveSnapshotStorage* storage,
                                          bool filter_before_copy_remote,
                                          braft::FileSystemAdaptor* fs,
@@ -56,7 +83,7 @@ CurveSnapshotCopier::CurveSnapshotCopier(CurveSnapshotStorage* storage,
     , _writer(NULL)
     , _storage(storage)
     , _reader(NULL)
-    , _cur_session(NULL)
+    , _reader_id(-1)
 {}
 
 CurveSnapshotCopier::~CurveSnapshotCopier() {
@@ -82,9 +109,7 @@ void CurveSnapshotCopier::copy() {
         }
         std::vector<std::string> files;
         _remote_snapshot.list_files(&files);
-        for (size_t i = 0; i < files.size() && ok(); ++i) {
-            copy_file(files[i]);
-        }
+        copy_files(files);
 
         // 下载snapshot attachment文件
         load_attach_meta_table();
@@ -126,11 +151,11 @@ void CurveSnapshotCopier::load_meta_table() {
     scoped_refptr<braft::RemoteFileCopier::Session> session
             = _copier.start_to_copy_to_iobuf(BRAFT_SNAPSHOT_META_FILE,
                                             &meta_buf, NULL);
-    _cur_session = session.get();
+    _cur_sessions.insert(session.get());
     lck.unlock();
     session->join();
     lck.lock();
-    _cur_session = NULL;
+    _cur_sessions.erase(session.get());
     lck.unlock();
     if (!session->status().ok()) {
         LOG(WARNING) << "Fail to copy meta file : " << session->status();
@@ -156,11 +181,11 @@ void CurveSnapshotCopier::load_attach_meta_table() {
     scoped_refptr<braft::RemoteFileCopier::Session> session
         = _copier.start_to_copy_to_iobuf(BRAFT_SNAPSHOT_ATTACH_META_FILE,
                                          &meta_buf, NULL);
-    _cur_session = session.get();
+    _cur_sessions.insert(session.get());
     lck.unlock();
     session->join();
     lck.lock();
-    _cur_session = NULL;
+    _cur_sessions.erase(session.get());
     lck.unlock();
     if (!session->status().ok()) {
         LOG(WARNING) << "Fail to copy attach meta file : " << session->status();
@@ -305,11 +330,42 @@ void CurveSnapshotCopier::filter() {
     }
 }
 
+void CurveSnapshotCopier::copy_files(const std::vector<std::string>& files) {
+    // 同时最多有raftSnapshotCopyConcurrency个文件在下载(包括增量下载)，
+    // 总的下载带宽仍然受_throttle限制
+    size_t concurrency = std::max(1u, FLAGS_raftSnapshotCopyConcurrency);
+    std::deque<CopyingFile> copying;
+    for (size_t i = 0; i < files.size() && ok(); ++i) {
+        CopyingFile file;
+        if (!start_copy_file(files[i], false, &file)) {
+            continue;
+        }
+        copying.push_back(file);
+        while (copying.size() >= concurrency) {
+            finish_copy_file(&copying.front());
+            copying.pop_front();
+        }
+    }
+    // 出错时finish_copy_file会取消还未完成的下载
+    while (!copying.empty()) {
+        finish_copy_file(&copying.front());
+        copying.pop_front();
+    }
+}
+
 void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
+    CopyingFile file;
+    if (start_copy_file(filename, attch, &file)) {
+        finish_copy_file(&file);
+    }
+}
+
+bool CurveSnapshotCopier::start_copy_file(const std::string& filename,
+                                          bool attch, CopyingFile* file) {
     if (_writer->get_file_meta(filename, NULL) == 0) {
         LOG(INFO) << "Skipped downloading " << filename
                   << " path: " << _writer->get_path();
-        return;
+        return false;
     }
     std::string rfilename = get_rfilename(filename);
     std::string file_path = _writer->get_path() + '/' + rfilename;
@@ -333,46 +389,107 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
                       "Fail to create directory");
         }
     }
-    braft::LocalFileMeta meta;
-    _remote_snapshot.get_file_meta(filename, &meta);
+    file->filename = filename;
+    file->file_path = file_path;
+    file->attach = attch;
+    if (!attch && can_copy_file_delta(filename)) {
+        // 增量下载在bthread中进行，和其他文件的下载并发
+        file->delta = std::make_shared<DeltaCopy>();
+        file->delta->copier = this;
+        file->delta->filename = filename;
+        file->delta->file_path = file_path;
+        if (bthread_start_background(&file->delta->tid, NULL,
+                                     run_copy_file_delta,
+                                     file->delta.get()) != 0) {
+            LOG(WARNING) << "Fail to start bthread, copy " << filename
+                         << " incrementally in place";
+            file->delta->tid = INVALID_BTHREAD;
+            run_copy_file_delta(file->delta.get());
+        }
+        return true;
+    }
+    return start_copy_session(file);
+}
+
+bool CurveSnapshotCopier::start_copy_session(CopyingFile* file) {
     std::unique_lock<braft::raft_mutex_t> lck(_mutex);
     if (_cancelled) {
         set_error(ECANCELED, "%s", berror(ECANCELED));
-        return;
+        return false;
     }
     scoped_refptr<braft::RemoteFileCopier::Session> session
-        = _copier.start_to_copy_to_file(filename, file_path, NULL);
+        = _copier.start_to_copy_to_file(file->filename, file->file_path,
+                                        NULL);
     if (session == NULL) {
-        LOG(WARNING) << "Fail to copy " << filename
+        LOG(WARNING) << "Fail to copy " << file->filename
                      << " path: " << _writer->get_path();
-        set_error(-1, "Fail to copy %s", filename.c_str());
-        return;
+        set_error(-1, "Fail to copy %s", file->filename.c_str());
+        return false;
     }
-    _cur_session = session.get();
-    lck.unlock();
-    session->join();
-    lck.lock();
-    _cur_session = NULL;
-    lck.unlock();
-    if (!session->status().ok()) {
-        // 如果是文件不存在，那么删除刚开始open的文件
-        if (session->status().error_code() == ENOENT) {
-            bool rc = _fs->delete_file(file_path, false);
-            if (!rc) {
-                LOG(ERROR) << "Fail to delete file" << file_path
-                           << " : " << ::berror(errno);
-                set_error(errno,
-                          "Fail to create delete file " + file_path);
-            }
+    _cur_sessions.insert(session.get());
+    file->session = session;
+    return true;
+}
+
+void* CurveSnapshotCopier::run_copy_file_delta(void* arg) {
+    DeltaCopy* delta = static_cast<DeltaCopy*>(arg);
+    delta->rc = delta->copier->copy_file_delta(delta->filename,
+                                               delta->file_path);
+    return NULL;
+}
+
+void CurveSnapshotCopier::finish_copy_file(CopyingFile* file) {
+    if (file->delta != nullptr) {
+        if (file->delta->tid != INVALID_BTHREAD) {
+            bthread_join(file->delta->tid, NULL);
+        }
+        int rc = file->delta->rc;
+        file->delta.reset();
+        if (rc == ECANCELED) {
+            set_error(ECANCELED, "%s", berror(ECANCELED));
+            return;
+        } else if (rc != 0 && (!ok() || !start_copy_session(file))) {
+            // 增量下载失败时在当前的并发额度内完整下载
             return;
         }
+    }
+    scoped_refptr<braft::RemoteFileCopier::Session> session = file->session;
+    if (session != NULL) {
+        if (!ok()) {
+            session->cancel();
+        }
+        session->join();
+        std::unique_lock<braft::raft_mutex_t> lck(_mutex);
+        _cur_sessions.erase(session.get());
+        lck.unlock();
+        if (!ok()) {
+            return;
+        }
+        if (!session->status().ok()) {
+            // 如果是文件不存在，那么删除刚开始open的文件
+            if (session->status().error_code() == ENOENT) {
+                bool rc = _fs->delete_file(file->file_path, false);
+                if (!rc) {
+                    LOG(ERROR) << "Fail to delete file" << file->file_path
+                               << " : " << ::berror(errno);
+                    set_error(errno,
+                              "Fail to create delete file " + file->file_path);
+                }
+                return;
+            }
 
-        set_error(session->status().error_code(),
-                  session->status().error_cstr());
+            set_error(session->status().error_code(),
+                      session->status().error_cstr());
+            return;
+        }
+    }
+    if (!ok()) {
         return;
     }
+    braft::LocalFileMeta meta;
+    _remote_snapshot.get_file_meta(file->filename, &meta);
     // 如果是attach file，那么不需要持久化file meta信息
-    if (!attch && _writer->add_file(filename, &meta) != 0) {
+    if (!file->attach && _writer->add_file(file->filename, &meta) != 0) {
         set_error(EIO, "Fail to add file to writer");
         return;
     }
@@ -382,6 +499,249 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
     }
 }
 
+bool CurveSnapshotCopier::can_copy_file_delta(const std::string& filename) {
+    // 只有快照目录之外的chunk文件在本地可能存在旧版本，
+    // 其路径与快照中记录的相对路径一致
+    return is_valid_hash_block_size(FLAGS_raftSnapshotDeltaBlockSize) &&
+           _reader_id >= 0 && get_rfilename(filename) != filename &&
+           _fs->path_exists(_writer->get_path() + '/' + filename);
+}
+
+int CurveSnapshotCopier::copy_file_delta(const std::string& filename,
+                                         const std::string& file_path) {
+    if (!can_copy_file_delta(filename)) {
+        return -1;
+    }
+
+    std::string local_path = _writer->get_path() + '/' + filename;
+    uint64_t file_size = 0;
+    std::vector<std::string> remote_hashes;
+    int rc = get_remote_block_hash(filename, &file_size, &remote_hashes);
+    if (rc == ECANCELED) {
+        return ECANCELED;
+    } else if (rc != 0) {
+        LOG(INFO) << "Fail to get block hash of " << filename
+                  << ", download the whole file, error: " << berror(rc);
+        return -1;
+    }
+
+    butil::File::Error e;
+    braft::FileAdaptor* local = _fs->open(local_path, O_RDONLY | O_CLOEXEC,
+                                          NULL, &e);
+    if (local == NULL) {
+        LOG(WARNING) << "Fail to open local file " << local_path
+                     << " : " << butil::File::ErrorToString(e);
+        return -1;
+    }
+    braft::FileAdaptor* dest = _fs->open(file_path,
+                                O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC,
+                                NULL, &e);
+    if (dest == NULL) {
+        LOG(WARNING) << "Fail to open file " << file_path
+                     << " : " << butil::File::ErrorToString(e);
+        local->close();
+        delete local;
+        return -1;
+    }
+
+    rc = copy_blocks_delta(filename, local, dest, file_size, remote_hashes);
+    local->close();
+    delete local;
+    if (!dest->close() && rc == 0) {
+        LOG(WARNING) << "Fail to close file " << file_path;
+        rc = EIO;
+    }
+    delete dest;
+
+    if (rc == ECANCELED) {
+        return ECANCELED;
+    } else if (rc != 0) {
+        LOG(WARNING) << "Fail to copy " << filename << " incrementally"
+                     << ", download the whole file, error: " << berror(rc);
+        return -1;
+    }
+    return 0;
+}
+
+int CurveSnapshotCopier::copy_blocks_delta(const std::string& filename,
+                            braft::FileAdaptor* local,
+                            braft::FileAdaptor* dest,
+                            uint64_t file_size,
+                            const std::vector<std::string>& remote_hashes) {
+    const uint64_t block_size = FLAGS_raftSnapshotDeltaBlockSize;
+    uint64_t reused = 0;
+    for (size_t i = 0; i < remote_hashes.size(); ++i) {
+        if (is_cancelled()) {
+            return ECANCELED;
+        }
+        off_t offset = i * block_size;
+        size_t count = std::min(block_size, file_size - offset);
+        butil::IOPortal data;
+        if (local->read(&data, offset, count) == (ssize_t)count &&
+            block_hash(data) == remote_hashes[i]) {
+            if (dest->write(data, offset) != (ssize_t)count) {
+                return EIO;
+            }
+            reused += count;
+            continue;
+        }
+        int rc = copy_remote_range(filename, offset, count, dest);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    LOG(INFO) << "Copied " << filename << " incrementally, size: "
+              << file_size << ", reused from local: " << reused;
+    return 0;
+}
+
+int CurveSnapshotCopier::get_remote_block_hash(const std::string& filename,
+                                        uint64_t* file_size,
+                                        std::vector<std::string>* hashes) {
+    const uint64_t block_size = FLAGS_raftSnapshotDeltaBlockSize;
+    uint64_t offset = 0;
+    while (true) {
+        braft::GetFileRequest request;
+        request.set_filename(filename + RAFT_SNAP_BLOCK_HASH_SUFFIX);
+        request.set_offset(offset);
+        request.set_count(block_size);
+        request.set_read_partly(true);
+        braft::GetFileResponse response;
+        butil::IOBuf buf;
+        int rc = get_remote_file(&request, &response, &buf);
+        if (rc != 0) {
+            return rc;
+        }
+
+        butil::IOBuf data;
+        braft::FileSegData seg(buf);
+        uint64_t seg_offset = 0;
+        butil::IOBuf seg_data;
+        while (seg.next(&seg_offset, &seg_data) != 0) {
+            data.append(seg_data);
+            seg_data.clear();
+        }
+        // 除最后一次外，每次返回的都是完整的block
+        uint64_t read_size = response.read_size();
+        size_t num = (read_size + block_size - 1) / block_size;
+        if ((!response.eof() &&
+             (read_size == 0 || read_size % block_size != 0)) ||
+            data.size() != num * kBlockHashSize) {
+            return EINVAL;
+        }
+        for (size_t i = 0; i < num; ++i) {
+            std::string hash(kBlockHashSize, '\0');
+            data.cutn(&hash[0], kBlockHashSize);
+            hashes->push_back(hash);
+        }
+        offset += read_size;
+        if (response.eof()) {
+            break;
+        }
+    }
+    *file_size = offset;
+    return 0;
+}
+
+int CurveSnapshotCopier::copy_remote_range(const std::string& filename,
+                                           off_t offset, size_t count,
+                                           braft::FileAdaptor* dest) {
+    off_t end = offset + count;
+    while (offset < end) {
+        size_t max_count = std::min<size_t>(end - offset,
+                                braft::FLAGS_raft_max_byte_count_per_rpc);
+        if (_throttle) {
+            max_count = _throttle->throttled_by_throughput(max_count);
+            if (max_count == 0) {
+                bthread_usleep(kDeltaCopyRetryIntervalUs);
+                continue;
+            }
+        }
+        braft::GetFileRequest request;
+        request.set_filename(filename);
+        request.set_offset(offset);
+        request.set_count(max_count);
+        request.set_read_partly(true);
+        braft::GetFileResponse response;
+        butil::IOBuf buf;
+        int rc = get_remote_file(&request, &response, &buf);
+        if (rc != 0) {
+            return rc;
+        }
+
+        braft::FileSegData seg(buf);
+        uint64_t seg_offset = 0;
+        butil::IOBuf seg_data;
+        while (seg.next(&seg_offset, &seg_data) != 0) {
+            ssize_t len = seg_data.size();
+            if (dest->write(seg_data, seg_offset) != len) {
+                return EIO;
+            }
+            seg_data.clear();
+        }
+        offset += response.read_size();
+        if (response.eof()) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int CurveSnapshotCopier::get_remote_file(braft::GetFileRequest* request,
+                                         braft::GetFileResponse* response,
+                                         butil::IOBuf* attachment) {
+    request->set_reader_id(_reader_id);
+    braft::FileService_Stub stub(&_channel);
+    while (true) {
+        if (is_cancelled()) {
+            return ECANCELED;
+        }
+        brpc::Controller cntl;
+        cntl.set_timeout_ms(kDeltaCopyTimeoutMs);
+        stub.get_file(&cntl, request, response, NULL);
+        if (!cntl.Failed()) {
+            attachment->swap(cntl.response_attachment());
+            return 0;
+        }
+        // 远端被限流时重试
+        if (cntl.ErrorCode() != EAGAIN) {
+            return cntl.ErrorCode();
+        }
+        bthread_usleep(kDeltaCopyRetryIntervalUs);
+    }
+}
+
+void CurveSnapshotCopier::init_delta_channel(const std::string& uri) {
+    // uri的格式为: remote://ip:port/reader_id
+    const char kPrefix[] = "remote://";
+    butil::StringPiece uri_str(uri);
+    if (!uri_str.starts_with(kPrefix)) {
+        return;
+    }
+    uri_str.remove_prefix(strlen(kPrefix));
+    size_t slash_pos = uri_str.find('/');
+    if (slash_pos == butil::StringPiece::npos) {
+        return;
+    }
+    butil::StringPiece ip_and_port = uri_str.substr(0, slash_pos);
+    uri_str.remove_prefix(slash_pos + 1);
+    int64_t reader_id = -1;
+    if (!butil::StringToInt64(uri_str, &reader_id)) {
+        return;
+    }
+    if (_channel.Init(ip_and_port.as_string().c_str(), NULL) != 0) {
+        LOG(WARNING) << "Fail to init channel to " << ip_and_port
+                     << ", disable incremental copy";
+        return;
+    }
+    _reader_id = reader_id;
+}
+
+bool CurveSnapshotCopier::is_cancelled() {
+    BAIDU_SCOPED_LOCK(_mutex);
+    return _cancelled;
+}
+
 std::string CurveSnapshotCopier::get_rfilename(const std::string& filename) {
     std::string rfilename;
     auto pos = filename.rfind("../");
@@ -411,13 +771,17 @@ void CurveSnapshotCopier::cancel() {
         return;
     }
     _cancelled = true;
-    if (_cur_session) {
-        _cur_session->cancel();
+    for (auto session : _cur_sessions) {
+        session->cancel();
     }
 }
 
 int CurveSnapshotCopier::init(const std::string& uri) {
-    return _copier.init(uri, _fs, _throttle);
+    int ret = _copier.init(uri, _fs, _throttle);
+    if (ret == 0 && FLAGS_raftSnapshotDeltaBlockSize > 0) {
+        init_delta_channel(uri);
+    }
+    return ret;
 }
 
 }  // namespace chunkserver
@@ -42,7 +42,12 @@
 #ifndef SRC_CHUNKSERVER_RAFTSNAPSHOT_CURVE_SNAPSHOT_COPIER_H_
 #define SRC_CHUNKSERVER_RAFTSNAPSHOT_CURVE_SNAPSHOT_COPIER_H_
 
+#include <braft/file_service.pb.h>
 #include <braft/storage.h>
+#include <brpc/channel.h>
+#include <gflags/gflags.h>
+#include <memory>
+#include <set>
 #include <vector>
 #include <string>
 #include "src/chunkserver/raftsnapshot/curve_snapshot.h"
@@ -51,9 +56,13 @@
 namespace curve {
 namespace chunkserver {
 
+DECLARE_uint32(raftSnapshotDeltaBlockSize);
+DECLARE_uint32(raftSnapshotCopyConcurrency);
+
 class CurveSnapshotStorage;
 
 class CurveSnapshotCopier : public braft::SnapshotCopier {
+friend class CurveSnapshotCopierTest;
  public:
     CurveSnapshotCopier(CurveSnapshotStorage* storage,
                         bool filter_before_copy_remote,
@@ -74,7 +83,62 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     int filter_before_copy(CurveSnapshotWriter* writer,
                            braft::SnapshotReader* last_snapshot);
     void filter();
+    // 在bthread中进行的增量下载
+    struct DeltaCopy {
+        CurveSnapshotCopier* copier = nullptr;
+        std::string filename;
+        std::string file_path;
+        bthread_t tid = INVALID_BTHREAD;
+        // copy_file_delta的返回值
+        int rc = -1;
+    };
+    // 正在下载的文件
+    struct CopyingFile {
+        std::string filename;
+        std::string file_path;
+        bool attach = false;
+        // 增量下载时不为空，增量下载失败后再完整下载
+        std::shared_ptr<DeltaCopy> delta;
+        scoped_refptr<braft::RemoteFileCopier::Session> session;
+    };
+
+    // 并发下载快照中的文件
+    void copy_files(const std::vector<std::string>& files);
     void copy_file(const std::string& filename, bool attach = false);
+    // 开始下载文件，返回true表示需要调用finish_copy_file等待下载完成
+    bool start_copy_file(const std::string& filename, bool attach,
+                         CopyingFile* file);
+    // 开始完整下载文件
+    bool start_copy_session(CopyingFile* file);
+    static void* run_copy_file_delta(void* arg);
+    // 等待文件下载完成并将文件加入writer
+    void finish_copy_file(CopyingFile* file);
+    // 本地是否有旧版本的文件可以用于增量下载
+    bool can_copy_file_delta(const std::string& filename);
+    /**
+     * 增量下载文件：本地已有旧版本的chunk文件时，与远端按block比较sha256，
+     * 只下载hash不一致的block，其余block从本地文件拷贝
+     * @return: 0表示成功，ECANCELED表示已被取消，-1表示需要退回完整下载
+     */
+    int copy_file_delta(const std::string& filename,
+                        const std::string& file_path);
+    int copy_blocks_delta(const std::string& filename,
+                          braft::FileAdaptor* local,
+                          braft::FileAdaptor* dest,
+                          uint64_t file_size,
+                          const std::vector<std::string>& remote_hashes);
+    // 分批获取远端文件各block的hash
+    int get_remote_block_hash(const std::string& filename,
+                              uint64_t* file_size,
+                              std::vector<std::string>* hashes);
+    // 下载远端文件[offset, offset + count)的数据并写入dest
+    int copy_remote_range(const std::string& filename, off_t offset,
+                          size_t count, braft::FileAdaptor* dest);
+    int get_remote_file(braft::GetFileRequest* request,
+                        braft::GetFileResponse* response,
+                        butil::IOBuf* attachment);
+    void init_delta_channel(const std::string& uri);
+    bool is_cancelled();
     // 这里的filename是相对于快照目录的路径，为了先把文件下载到临时目录，需要把前面的..去掉
     std::string get_rfilename(const std::string& filename);
 
@@ -87,9 +151,12 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     CurveSnapshotWriter* _writer;
     CurveSnapshotStorage* _storage;
     braft::SnapshotReader* _reader;
-    braft::RemoteFileCopier::Session* _cur_session;
+    std::set<braft::RemoteFileCopier::Session*> _cur_sessions;
     CurveSnapshot _remote_snapshot;
     braft::RemoteFileCopier _copier;
+    // 用于增量下载，直接向远端的CurveFileService请求文件的部分数据
+    brpc::Channel _channel;
+    int64_t _reader_id;
 };
 }  // namespace chunkserver
 }  // namespace curve
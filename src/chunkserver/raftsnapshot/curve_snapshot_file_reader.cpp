@@ -41,9 +41,23 @@
 
 #include "src/chunkserver/raftsnapshot/curve_snapshot_file_reader.h"
 
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace braft {
+    DECLARE_int32(raft_max_byte_count_per_rpc);
+}
+
 namespace curve {
 namespace chunkserver {
 
+DEFINE_bool(raftSnapshotSkipHoles, true,
+            "only transfer allocated extents of files when installing "
+            "snapshot");
+
 CurveSnapshotAttachMetaTable::CurveSnapshotAttachMetaTable() {}
 
 CurveSnapshotAttachMetaTable::~CurveSnapshotAttachMetaTable() {}
@@ -173,5 +187,187 @@ int CurveSnapshotFileReader::read_file(butil::IOBuf* out,
                                     offset, new_max_count, read_count, is_eof);
 }
 
+int CurveSnapshotFileReader::read_file_segments(braft::FileSegData* out,
+                                               const std::string &filename,
+                                               off_t offset,
+                                               size_t max_count,
+                                               bool read_partly,
+                                               size_t* read_count,
+                                               bool* is_eof) const {
+    off_t end = offset + max_count;
+    off_t file_size = -1;
+    std::vector<std::pair<off_t, size_t>> extents;
+    if (!FLAGS_raftSnapshotSkipHoles ||
+        get_data_extents(filename, offset, end, &extents, &file_size) != 0) {
+        butil::IOBuf buf;
+        int ret = read_file(&buf, filename, offset, max_count, read_partly,
+                            read_count, is_eof);
+        if (ret == 0 && buf.size() != 0) {
+            out->append(buf, offset);
+        }
+        return ret;
+    }
+
+    // 空洞部分不需要读取，也不受限流影响
+    *read_count = 0;
+    *is_eof = false;
+    for (const auto& extent : extents) {
+        butil::IOBuf buf;
+        size_t count = 0;
+        bool eof = false;
+        int ret = read_file(&buf, filename, extent.first, extent.second,
+                            read_partly, &count, &eof);
+        if (ret == EAGAIN && read_partly && extent.first > offset) {
+            // 被限流时先返回已经读取的部分
+            *read_count = extent.first - offset;
+            return 0;
+        } else if (ret != 0) {
+            return ret;
+        }
+        if (buf.size() != 0) {
+            out->append(buf, extent.first);
+        }
+        if (count < extent.second) {
+            *read_count = extent.first + count - offset;
+            *is_eof = eof;
+            return 0;
+        }
+    }
+    *read_count = std::min(end, file_size) - offset;
+    *is_eof = end >= file_size;
+    return 0;
+}
+
+int CurveSnapshotFileReader::get_data_extents(const std::string& filename,
+                            off_t offset, off_t end,
+                            std::vector<std::pair<off_t, size_t>>* extents,
+                            off_t* file_size) const {
+    if (_meta_table.get_file_meta(filename, NULL) != 0) {
+        return -1;
+    }
+    std::string file_path = path() + "/" + filename;
+    int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    end = std::min(end, st.st_size);
+    off_t pos = offset;
+    while (pos < end) {
+        off_t data = ::lseek(fd, pos, SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO) {
+                // 后面全部是空洞
+                break;
+            }
+            ::close(fd);
+            return -1;
+        }
+        if (data >= end) {
+            break;
+        }
+        off_t hole = ::lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) {
+            ::close(fd);
+            return -1;
+        }
+        hole = std::min(hole, end);
+        extents->emplace_back(data, hole - data);
+        pos = hole;
+    }
+    ::close(fd);
+    *file_size = st.st_size;
+    return 0;
+}
+
+int CurveSnapshotFileReader::read_block_hash(butil::IOBuf* out,
+                                            const std::string& filename,
+                                            off_t offset,
+                                            size_t block_size,
+                                            size_t* read_count,
+                                            bool* is_eof) const {
+    if (!is_valid_hash_block_size(block_size) || offset % block_size != 0) {
+        return EINVAL;
+    }
+    braft::LocalFileMeta file_meta;
+    if (_meta_table.get_file_meta(filename, &file_meta) != 0) {
+        return EPERM;
+    }
+    // 一次最多返回一个rpc大小的hash
+    const size_t max_num =
+        braft::FLAGS_raft_max_byte_count_per_rpc / kBlockHashSize;
+    const bool throttled = _snapshot_throttle &&
+                braft::FLAGS_raft_enable_throttle_when_install_snapshot;
+    *read_count = 0;
+    *is_eof = false;
+    for (size_t i = 0; i < max_num && !*is_eof; ++i) {
+        // 计算hash需要读取整个block，和读文件一样受限流影响
+        int64_t start = butil::cpuwide_time_us();
+        size_t max_count = block_size;
+        if (throttled) {
+            max_count = _snapshot_throttle->throttled_by_throughput(
+                                                            block_size);
+            if (max_count < block_size) {
+                if (max_count > 0) {
+                    _snapshot_throttle->return_unused_throughput(
+                        max_count, 0, butil::cpuwide_time_us() - start);
+                }
+                break;
+            }
+        }
+        butil::IOBuf data;
+        size_t count = 0;
+        int ret = LocalDirReader::read_file_with_meta(&data, filename,
+                                                      &file_meta,
+                                                      offset + *read_count,
+                                                      block_size, &count,
+                                                      is_eof);
+        if (throttled && (ret != 0 || count < block_size)) {
+            _snapshot_throttle->return_unused_throughput(
+                block_size, ret == 0 ? count : 0,
+                butil::cpuwide_time_us() - start);
+        }
+        if (ret != 0) {
+            return ret;
+        }
+        if (count == 0) {
+            *is_eof = true;
+            break;
+        }
+        out->append(block_hash(data));
+        *read_count += count;
+    }
+    if (*read_count == 0 && !*is_eof) {
+        LOG(INFO) << "Read block hash throttled, path: " << path();
+        return EAGAIN;
+    }
+    return 0;
+}
+
+bool is_valid_hash_block_size(size_t block_size) {
+    return block_size >= kMinHashBlockSize &&
+           block_size <= (size_t)braft::FLAGS_raft_max_byte_count_per_rpc;
+}
+
+std::string block_hash(const butil::IOBuf& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    EVP_MD_CTX* ctx = EVP_MD_CTX_create();
+    CHECK(ctx != nullptr) << "Fail to create digest context";
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+    for (size_t i = 0; i < data.backing_block_num(); ++i) {
+        butil::StringPiece block = data.backing_block(i);
+        EVP_DigestUpdate(ctx, block.data(), block.size());
+    }
+    EVP_DigestFinal_ex(ctx, digest, &digest_size);
+    EVP_MD_CTX_destroy(ctx);
+    CHECK_EQ(kBlockHashSize, digest_size);
+    return std::string(reinterpret_cast<char*>(digest), digest_size);
+}
+
 }  // namespace chunkserver
 }  // namespace curve
@@ -44,6 +44,8 @@
 
 #include <braft/file_reader.h>
 #include <braft/snapshot.h>
+#include <braft/util.h>
+#include <gflags/gflags.h>
 #include <utility>
 #include <vector>
 #include <string>
@@ -82,6 +84,19 @@ class CurveSnapshotAttachMetaTable {
     Map    _file_map;
 };
 
+DECLARE_bool(raftSnapshotSkipHoles);
+
+// block hash(sha256)的长度
+const size_t kBlockHashSize = 32;
+// 计算hash的block最小为4KB，避免hash比数据本身还大
+const size_t kMinHashBlockSize = 4096;
+
+// 计算hash的block需要一次读出，不能超过一个rpc读取的大小
+bool is_valid_hash_block_size(size_t block_size);
+
+// 计算一个block数据的sha256
+std::string block_hash(const butil::IOBuf& data);
+
 class CurveSnapshotFileReader : public braft::LocalDirReader {
  public:
     CurveSnapshotFileReader(braft::FileSystemAdaptor* fs,
@@ -109,11 +124,52 @@ class CurveSnapshotFileReader : public braft::LocalDirReader {
                   size_t* read_count,
                   bool* is_eof) const override;
 
+    /**
+     * 读取文件[offset, offset + max_count)内已分配的数据，跳过其中的空洞
+     * @param[out]: out为按偏移组织的数据段，空洞部分不包含在内
+     * @param[out]: read_count为读取覆盖的范围长度，包括跳过的空洞
+     * 其余参数同read_file
+     * @return: 成功返回0，否则返回错误码
+     */
+    int read_file_segments(braft::FileSegData* out,
+                           const std::string &filename,
+                           off_t offset,
+                           size_t max_count,
+                           bool read_partly,
+                           size_t* read_count,
+                           bool* is_eof) const;
+
+    /**
+     * 从offset开始按block_size分块计算文件的sha256，和读文件一样受快照限流
+     * 影响，被限流时只返回已经计算的部分
+     * @param[out]: out为依次排列的各block的hash
+     * @param: filename为快照中的文件名
+     * @param: offset为起始位置，需要按block_size对齐
+     * @param: block_size为分块大小
+     * @param[out]: read_count为计算覆盖的文件长度
+     * @param[out]: is_eof表示是否已计算到文件末尾
+     * @return: 成功返回0，参数非法返回EINVAL，被限流返回EAGAIN，
+     *          否则返回其他错误码
+     */
+    virtual int read_block_hash(butil::IOBuf* out,
+                                const std::string& filename,
+                                off_t offset,
+                                size_t block_size,
+                                size_t* read_count,
+                                bool* is_eof) const;
+
     braft::LocalSnapshotMetaTable get_meta_table() {
         return _meta_table;
     }
 
  private:
+    // 通过SEEK_DATA/SEEK_HOLE获取[offset, end)内的数据区间，
+    // 无法获取时返回-1
+    int get_data_extents(const std::string& filename, off_t offset,
+                         off_t end,
+                         std::vector<std::pair<off_t, size_t>>* extents,
+                         off_t* file_size) const;
+
     braft::LocalSnapshotMetaTable _meta_table;
     CurveSnapshotAttachMetaTable _attach_meta_table;
     scoped_refptr<braft::SnapshotThrottle> _snapshot_throttle;
@@ -37,6 +37,8 @@ const char RAFT_LOG_DIR[]  = "log";
 #define BRAFT_SNAPSHOT_META_FILE        "__raft_snapshot_meta"
 #define BRAFT_SNAPSHOT_ATTACH_META_FILE "__raft_snapshot_attach_meta"
 #define BRAFT_PROTOBUF_FILE_TEMP ".tmp"
+// 文件名加上该后缀表示读取文件按block计算的sha256，用于增量下载快照
+const char RAFT_SNAP_BLOCK_HASH_SUFFIX[] = "@block_sha256";
 
 }  // namespace chunkserver
 }  // namespace curve
@@ -20,14 +20,28 @@
  * Author: huyao
  */
 
+#include <fcntl.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "src/chunkserver/scan_manager.h"
 #include "src/chunkserver/op_request.h"
+#include "src/chunkserver/chunkserver_metrics.h"
+#include "src/common/string_util.h"
 
 namespace curve {
 namespace chunkserver {
 
 using ::google::protobuf::util::MessageDifferencer;
 
+namespace {
+// saved in copyset dir, the last chunk scanned by the unfinished scan job
+const char kScanCheckpointFile[] = "scan_checkpoint";
+// the first wait when foreground io becomes slow
+const uint64_t kMinBackoffMs = 10;
+}  // namespace
+
 int ScanManager::Init(const ScanManagerOptions &options) {
     toStop_.store(false, std::memory_order_release);
     scanSize_ = options.scanSize;
@@ -35,6 +49,11 @@ int ScanManager::Init(const ScanManagerOptions &options) {
     timeoutMs_ = options.timeoutMs;
     retry_ = options.retry;
     retryIntervalUs_ = options.retryIntervalUs;
+    latencyThresholdUs_ = options.latencyThresholdUs;
+    maxBackoffMs_ = options.maxBackoffMs;
+    backoffMs_ = 0;
+    lfs_ = options.localFileSystem;
+    checkpointExpireSec_ = options.checkpointExpireSec;
     jobWaitInterval_.Init(options.intervalSec * 1000);
     // reuse timeout 1000ms as send scan task interval
     scanTaskWaitInterval_.Init(options.timeoutMs);
@@ -53,6 +72,7 @@ int ScanManager::Fini() {
     LOG(INFO) << "Stopping scan manager.";
     jobWaitInterval_.StopWait();
     toStop_.store(true, std::memory_order_release);
+    backoffSleeper_.interrupt();
     scanThread_.join();
     waitScanSet_.clear();
     jobs_.clear();
@@ -121,6 +141,18 @@ void ScanManager::StartScanJob(ScanKey key) {
     job->type = ScanType::Init;
     job->isFinished = true;
     job->dataStore = nodePtr->GetDataStore();
+    job->startSec = ::curve::common::TimeUtility::GetTimeofDaySec();
+    std::string copysetDir = nodePtr->GetCopysetDir();
+    if (nullptr != lfs_ && !copysetDir.empty()) {
+        job->checkpointPath = copysetDir + "/" + kScanCheckpointFile;
+        job->resumeChunkId = ResumeScanCheckpoint(job->checkpointPath,
+                                                  nodePtr->GetLastScan(),
+                                                  &job->startSec);
+        LOG_IF(INFO, job->resumeChunkId > 0)
+            << "Resume scan job(" << key.first << ", " << key.second
+            << ") after chunk " << job->resumeChunkId
+            << ", started at " << job->startSec;
+    }
     nodePtr->SetScan(true);
     nodePtr->GetFailedScanMap().clear();
     jobMapLock_.WRLock();
@@ -143,6 +175,9 @@ int ScanManager::CancelScanJob(LogicPoolID poolId, CopysetID id) {
     // cancel scan job started
     auto job = GetJob(key);
     if (nullptr != job) {
+        // the next scan may be started on another leader, or long after,
+        // so it can't resume from here
+        RemoveScanCheckpoint(job->checkpointPath);
         auto nodePtr = copysetNodeManager_->GetCopysetNode(poolId, id);
         nodePtr->SetScan(false);
         nodePtr->GetFailedScanMap().clear();
@@ -156,7 +191,7 @@ bool ScanManager::GenScanJob(std::shared_ptr<ScanJob> job) {
     bool done = false;
     switch (job->type) {
         case ScanType::Init:
-            job->chunkMap = job->dataStore->GetChunkMap();
+            job->chunkIds = job->dataStore->GetChunkIds();
             job->type = ScanType::NewMap;
             break;
         case ScanType::NewMap:
@@ -209,24 +244,41 @@ void ScanManager::GenScanJobs(ScanKey key) {
 // send scan request to braft
 int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
     // check chunkmap
-    if (job->chunkMap.empty()) {
-        LOG(WARNING) << "GenScanJob failed, job's chunkmap is empty"
+    if (job->chunkIds.empty()) {
+        LOG(WARNING) << "GenScanJob failed, job's chunk list is empty"
                      << " logicalpoolId = " << job->poolId
                      << " copysetId = " << job->id;
         return 0;
     }
 
-    // iterate chunkmap
+    // iterate the chunks in order of chunk id, so that the job can resume
+    // from the checkpoint after restart
     auto nodePtr = copysetNodeManager_->GetCopysetNode(job->poolId, job->id);
     std::vector<Peer> peers;
     nodePtr->ListPeers(&peers);
     auto replicaNum = peers.size();
-    auto iter = job->chunkMap.begin();
-    while (iter != job->chunkMap.end()) {
-        // check chunk version
-        auto csChunkFile = iter->second;
-        if (csChunkFile->GetChunkFileMetaPage().version !=
-            FORMAT_VERSION_V2) {
+    std::vector<ChunkID> chunkIds;
+    chunkIds.reserve(job->chunkIds.size());
+    for (auto chunkId : job->chunkIds) {
+        if (chunkId > job->resumeChunkId) {
+            chunkIds.push_back(chunkId);
+        }
+    }
+    std::sort(chunkIds.begin(), chunkIds.end());
+    auto iter = chunkIds.begin();
+    while (iter != chunkIds.end()) {
+        // load the chunk if not loaded yet, it may have been deleted since
+        // the chunks were listed
+        auto csChunkFile = job->dataStore->LoadChunk(*iter);
+        if (csChunkFile == nullptr) {
+            LOG(WARNING) << "Skip scanning chunk " << *iter
+                         << " which doesn't exist or failed to load,"
+                         << " logicalpoolId = " << job->poolId
+                         << " copysetId = " << job->id;
+            iter++;
+        } else if (csChunkFile->GetChunkFileMetaPage().version !=
+                   FORMAT_VERSION_V2) {
+            // the chunks of old format are not scanned
             iter++;
         } else {
             // split scan chunk request
@@ -239,13 +291,14 @@ int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
                     CancelScanJob(job->poolId, job->id);
                     return -1;
                 }
+                BackoffIfForegroundBusy();
 
                 // Init job
                 job->taskLock.WRLock();
                 job->task.localMap.Clear();
                 job->task.followerMap.clear();
                 job->task.waitingNum = replicaNum;
-                job->task.chunkId = iter->first;
+                job->task.chunkId = *iter;
                 job->task.offset = currentOffset;
                 if (scanChunkMetaPage) {
                     job->task.len = chunkMetaPageSize_;
@@ -261,7 +314,7 @@ int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
                 request->set_optype(CHUNK_OP_TYPE::CHUNK_OP_SCAN);
                 request->set_logicpoolid(job->poolId);
                 request->set_copysetid(job->id);
-                request->set_chunkid(iter->first);
+                request->set_chunkid(*iter);
                 request->set_offset(currentOffset);
                 request->set_sendscanmaptimeoutms(timeoutMs_);
                 request->set_sendscanmapretrytimes(retry_);
@@ -289,6 +342,10 @@ int ScanManager::ScanJobProcess(const std::shared_ptr<ScanJob> job) {
                 }
                 scanChunkMetaPage = false;
             }
+            if (!job->checkpointPath.empty()) {
+                SaveScanCheckpoint(job->checkpointPath, job->startSec,
+                                   *iter);
+            }
             iter++;
         }
     }
@@ -416,6 +473,7 @@ void ScanManager::ScanJobFinish(std::shared_ptr<ScanJob> job) {
         uint64_t now = ::curve::common::TimeUtility::GetTimeofDaySec();
         nodePtr->SetLastScan(now);
         nodePtr->SetScan(false);
+        RemoveScanCheckpoint(job->checkpointPath);
         WriteLockGuard writeGuard(jobMapLock_);
         jobs_.erase(key);
         LOG(INFO) << "Scan job (" << key.first << ", "
@@ -439,5 +497,127 @@ void ScanManager::SetScanJobType(ScanKey key, ScanType type) {
     }
 }
 
+void ScanManager::BackoffIfForegroundBusy() {
+    if (0 == latencyThresholdUs_) {
+        return;
+    }
+    int64_t latencyUs = 0;
+    for (auto type : {CSIOMetricType::READ_CHUNK,
+                      CSIOMetricType::WRITE_CHUNK}) {
+        auto ioMetric = ChunkServerMetric::GetInstance()->GetIOMetric(type);
+        if (nullptr != ioMetric) {
+            latencyUs = std::max(latencyUs,
+                                 ioMetric->latencyRecorder_.latency(1));
+        }
+    }
+    if (static_cast<uint64_t>(latencyUs) > latencyThresholdUs_) {
+        backoffMs_ = std::min(std::max(backoffMs_ * 2, kMinBackoffMs),
+                              maxBackoffMs_);
+    } else {
+        backoffMs_ = backoffMs_ / 2 < kMinBackoffMs ? 0 : backoffMs_ / 2;
+    }
+    if (backoffMs_ > 0) {
+        VLOG(3) << "Foreground io latency " << latencyUs
+                << "us, scan backs off " << backoffMs_ << "ms";
+        backoffSleeper_.wait_for(std::chrono::milliseconds(backoffMs_));
+    }
+}
+
+int ScanManager::SaveScanCheckpoint(const std::string &path,
+                                    uint64_t startSec, ChunkID chunkId) {
+    if (nullptr == lfs_) {
+        return -1;
+    }
+    // write a temp file and rename, so that a crash leaves either the old
+    // checkpoint or the new one
+    std::string tmpPath = path + ".tmp";
+    int fd = lfs_->Open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC);
+    if (fd < 0) {
+        LOG(ERROR) << "Failed to open scan checkpoint " << tmpPath;
+        return -1;
+    }
+    std::string content = std::to_string(startSec) + " " +
+                          std::to_string(chunkId);
+    int ret = lfs_->Write(fd, content.c_str(), 0, content.size());
+    lfs_->Close(fd);
+    if (ret != static_cast<int>(content.size())) {
+        LOG(ERROR) << "Failed to write scan checkpoint " << tmpPath;
+        return -1;
+    }
+    if (0 != lfs_->Rename(tmpPath, path)) {
+        LOG(ERROR) << "Failed to rename scan checkpoint " << tmpPath
+                   << " to " << path;
+        return -1;
+    }
+    return 0;
+}
+
+int ScanManager::LoadScanCheckpoint(const std::string &path,
+                                    uint64_t *startSec, ChunkID *chunkId) {
+    *startSec = 0;
+    *chunkId = 0;
+    if (nullptr == lfs_) {
+        return -1;
+    }
+    if (!lfs_->FileExists(path)) {
+        return 0;
+    }
+    int fd = lfs_->Open(path, O_RDONLY);
+    if (fd < 0) {
+        LOG(ERROR) << "Failed to open scan checkpoint " << path;
+        return -1;
+    }
+    char buf[64] = {0};
+    int ret = lfs_->Read(fd, buf, 0, sizeof(buf) - 1);
+    lfs_->Close(fd);
+    std::string content(buf, ret > 0 ? ret : 0);
+    auto pos = content.find(' ');
+    uint64_t start = 0;
+    uint64_t lastChunkId = 0;
+    if (pos == std::string::npos ||
+        !::curve::common::StringToUll(content.substr(0, pos), &start) ||
+        !::curve::common::StringToUll(content.substr(pos + 1),
+                                      &lastChunkId)) {
+        LOG(ERROR) << "Invalid scan checkpoint " << path;
+        return -1;
+    }
+    *startSec = start;
+    *chunkId = lastChunkId;
+    return 0;
+}
+
+ChunkID ScanManager::ResumeScanCheckpoint(const std::string &path,
+                                          uint64_t lastScanSec,
+                                          uint64_t *startSec) {
+    uint64_t checkpointSec = 0;
+    ChunkID chunkId = 0;
+    int ret = LoadScanCheckpoint(path, &checkpointSec, &chunkId);
+    if (ret == 0 && chunkId == 0) {
+        return 0;
+    }
+    // the checkpoint left by a scan which has been finished since or started
+    // too long ago is stale, resuming from it skips the chunks which may
+    // have been changed
+    if (ret != 0 || checkpointSec <= lastScanSec ||
+        checkpointSec + checkpointExpireSec_ <= *startSec) {
+        LOG(INFO) << "Remove stale scan checkpoint " << path
+                  << ", started at " << checkpointSec
+                  << ", last scan finished at " << lastScanSec;
+        RemoveScanCheckpoint(path);
+        return 0;
+    }
+    *startSec = checkpointSec;
+    return chunkId;
+}
+
+void ScanManager::RemoveScanCheckpoint(const std::string &path) {
+    if (nullptr == lfs_ || path.empty() || !lfs_->FileExists(path)) {
+        return;
+    }
+    if (0 != lfs_->Delete(path)) {
+        LOG(WARNING) << "Failed to delete scan checkpoint " << path;
+    }
+}
+
 }  // namespace chunkserver
 }  // namespace curve
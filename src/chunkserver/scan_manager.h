@@ -29,10 +29,13 @@
 #include <utility>
 #include <set>
 #include <map>
+#include <string>
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/concurrent/concurrent.h"
+#include "src/common/interruptible_sleeper.h"
 #include "src/common/wait_interval.h"
+#include "src/fs/local_filesystem.h"
 #include "proto/scan.pb.h"
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 #include "src/chunkserver/copyset_node_manager.h"
@@ -42,6 +45,8 @@
 using curve::common::Thread;
 using curve::common::RWLock;
 using curve::common::WaitInterval;
+using curve::common::InterruptibleSleeper;
+using curve::fs::LocalFileSystem;
 
 namespace curve {
 namespace chunkserver {
@@ -63,6 +68,15 @@ struct ScanManagerOptions {
     uint32_t retry;
     uint64_t retryIntervalUs;
     CopysetNodeManager* copysetNodeManager;
+    // back off when the foreground read/write latency in the last second
+    // exceeds it, 0 means scanning at full speed
+    uint64_t latencyThresholdUs = 0;
+    // max wait before sending a scan task when backing off
+    uint64_t maxBackoffMs = 0;
+    // use for saving scan progress in copyset dir, nullptr means disabled
+    std::shared_ptr<LocalFileSystem> localFileSystem;
+    // the saved scan progress expires after it, and the scan starts over
+    uint64_t checkpointExpireSec = 86400;
 };
 
 /**
@@ -93,9 +107,18 @@ struct ScanJob {
     ScanTask task;
     bool isFinished;
     RWLock taskLock;
-    ChunkMap chunkMap;
+    // all the chunks to scan, including the ones not loaded yet with lazy
+    // loading enabled, each chunk is loaded when its scan starts
+    std::vector<ChunkID> chunkIds;
     std::shared_ptr<CSDataStore> dataStore;
-    ScanJob() : type(ScanType::Init) {}
+    // file saving the last scanned chunk, empty if not checkpointed
+    std::string checkpointPath;
+    // chunks not greater than it were scanned before restart
+    ChunkID resumeChunkId;
+    // start time of the scan, it's the start time of the job scanned the
+    // chunks before restart if resumed from the checkpoint
+    uint64_t startSec;
+    ScanJob() : type(ScanType::Init), resumeChunkId(0), startSec(0) {}
 };
 
 class ScanManager {
@@ -185,6 +208,44 @@ class ScanManager {
      */
     void SetScanJobType(ScanKey key, ScanType type);
 
+    /**
+     * @brief save the last scanned chunk of the job
+     * @param[in] path: the checkpoint file path
+     * @param[in] startSec: the start time of the scan
+     * @param[in] chunkId: the last scanned chunk
+     * @return 0:successful, non-zero failed
+     */
+    int SaveScanCheckpoint(const std::string &path, uint64_t startSec,
+                           ChunkID chunkId);
+
+    /**
+     * @brief load the last scanned chunk saved before restart
+     * @param[in] path: the checkpoint file path
+     * @param[out] startSec: the start time of the scan, 0 if no checkpoint
+     * @param[out] chunkId: the last scanned chunk, 0 if no checkpoint
+     * @return 0:successful, non-zero failed
+     */
+    int LoadScanCheckpoint(const std::string &path, uint64_t *startSec,
+                           ChunkID *chunkId);
+
+    /**
+     * @brief get the chunk to resume the scan after, the stale checkpoint is
+     *        removed and the scan starts over
+     * @param[in] path: the checkpoint file path
+     * @param[in] lastScanSec: the time the last scan of the copyset finished
+     * @param[in,out] startSec: the start time of the scan, replaced by the
+     *                one of the checkpoint if resumed
+     * @return the last scanned chunk, 0 if not resumed
+     */
+    ChunkID ResumeScanCheckpoint(const std::string &path,
+                                 uint64_t lastScanSec, uint64_t *startSec);
+
+    /**
+     * @brief remove the checkpoint, so that the next scan starts over
+     * @param[in] path: the checkpoint file path
+     */
+    void RemoveScanCheckpoint(const std::string &path);
+
     // for test
     int GetWaitJobNum() {
         return waitScanSet_.size();
@@ -234,6 +295,13 @@ class ScanManager {
      */
     std::shared_ptr<ScanJob> GetJob(ScanKey key);
 
+    /**
+     * @brief wait before sending a scan task if the foreground io is slow,
+     *        the wait doubles while the latency stays above the threshold
+     *        and halves once it falls below
+     */
+    void BackoffIfForegroundBusy();
+
     // scan process thread
     Thread scanThread_;
     std::atomic<bool> toStop_;
@@ -250,6 +318,13 @@ class ScanManager {
     uint64_t timeoutMs_;
     uint32_t retry_;
     uint64_t retryIntervalUs_;
+    uint64_t latencyThresholdUs_;
+    uint64_t maxBackoffMs_;
+    // current wait before sending a scan task
+    uint64_t backoffMs_;
+    InterruptibleSleeper backoffSleeper_;
+    std::shared_ptr<LocalFileSystem> lfs_;
+    uint64_t checkpointExpireSec_;
 };
 }  // namespace chunkserver
 }  // namespace curve
@@ -22,6 +22,7 @@
 
 #include <time.h>
 #include <glog/logging.h>
+#include <algorithm>
 #include <vector>
 #include "src/chunkserver/trash.h"
 #include "src/common/string_util.h"
@@ -38,8 +39,15 @@ using ::curve::chunkserver::RAFT_LOG_DIR;
 
 namespace curve {
 namespace chunkserver {
+
+namespace {
+// chunkfilepool低于水位时扫描trash的间隔
+const int kLowWaterMarkScanPeriodSec = 1;
+}  // namespace
+
 int Trash::Init(TrashOptions options) {
     isStop_ = true;
+    useRecyclePool_ = false;
 
     if (curve::common::UriParser::ParseUri(options.trashPath, &trashPath_)
             .empty()) {
@@ -58,7 +66,16 @@ int Trash::Init(TrashOptions options) {
     localFileSystem_ = options.localFileSystem;
     chunkFilePool_ = options.chunkFilePool;
     walPool_ = options.walPool;
+    recycleThreads_ = options.recycleThreads;
+    recycleBatchSize_ = std::max(options.recycleBatchSize, 1);
+    poolLowWaterMark_ = options.poolLowWaterMark;
+    if (options.maxRecyclePerSec > 0) {
+        ReadWriteThrottleParams params;
+        params.iopsTotal = ThrottleParams(options.maxRecyclePerSec, 0, 0);
+        recycleThrottle_.UpdateThrottleParams(params);
+    }
     chunkNum_.store(0);
+    recycledNum_.store(0);
 
      // 读取trash目录下的所有目录
     std::vector<std::string> files;
@@ -81,6 +98,15 @@ int Trash::Init(TrashOptions options) {
 
 int Trash::Run() {
     if (isStop_.exchange(false)) {
+        if (recycleThreads_ > 1) {
+            if (recyclePool_.Start(recycleThreads_) != 0) {
+                LOG(ERROR) << "Failed to start trash recycle pool, "
+                           << "threads: " << recycleThreads_;
+                isStop_ = true;
+                return -1;
+            }
+            useRecyclePool_ = true;
+        }
         recycleThread_ =
             Thread(&Trash::DeleteEligibleFileInTrashInterval, this);
         LOG(INFO) << "Start trash thread ok.";
@@ -95,6 +121,10 @@ int Trash::Fini() {
         LOG(INFO) << "stop Trash...";
         sleeper_.interrupt();
         recycleThread_.join();
+        if (useRecyclePool_) {
+            useRecyclePool_ = false;
+            recyclePool_.Stop();
+        }
     }
     LOG(INFO) << "stop trash ok.";
     return 0;
@@ -137,10 +167,19 @@ int Trash::RecycleCopySet(const std::string &dirPath) {
 }
 
 void Trash::DeleteEligibleFileInTrashInterval() {
-     while (sleeper_.wait_for(std::chrono::seconds(scanPeriodSec_))) {
+    while (true) {
+        // chunkfilepool低于水位时尽快回收trash中的chunk，
+        // 避免新写入退化为创建文件
+        int periodSec = scanPeriodSec_;
+        if (chunkNum_.load() > 0 && IsPoolBelowWaterMark()) {
+            periodSec = std::min(scanPeriodSec_, kLowWaterMarkScanPeriodSec);
+        }
+        if (!sleeper_.wait_for(std::chrono::seconds(periodSec))) {
+            break;
+        }
         // 扫描回收站
-         DeleteEligibleFileInTrash();
-     }
+        DeleteEligibleFileInTrash();
+    }
 }
 
 void Trash::DeleteEligibleFileInTrash() {
@@ -226,55 +265,130 @@ bool Trash::IsChunkOrSnapShotFile(const std::string &chunkName) {
 
 bool Trash::RecycleChunksAndWALInDir(
     const std::string &copysetPath, const std::string &filename) {
-    bool isDir = localFileSystem_->DirExists(copysetPath);
+    std::vector<std::string> chunks;
+    std::vector<std::string> wals;
+    // list 失败不应该中断其他文件的recycle
+    bool ret = CollectFilesInDir(copysetPath, filename, &chunks, &wals);
+    if (!RecycleFiles(chunks, wals)) {
+        ret = false;
+    }
+    return ret;
+}
+
+bool Trash::CollectFilesInDir(const std::string &path,
+                              const std::string &filename,
+                              std::vector<std::string> *chunks,
+                              std::vector<std::string> *wals) {
+    bool isDir = localFileSystem_->DirExists(path);
     // 是文件看是否需要回收
     if (!isDir) {
         if (IsChunkOrSnapShotFile(filename)) {
-            return RecycleChunkfile(copysetPath, filename);
+            chunks->push_back(path);
         } else if (IsWALFile(filename)) {
-            return RecycleWAL(copysetPath, filename);
-        } else {
-            return true;
+            wals->push_back(path);
         }
+        return true;
     }
 
     // 是目录，继续list
     std::vector<std::string> files;
-    if (0 != localFileSystem_->List(copysetPath, &files)) {
-        LOG(ERROR) << "Trash failed to list files in " << copysetPath;
+    if (0 != localFileSystem_->List(path, &files)) {
+        LOG(ERROR) << "Trash failed to list files in " << path;
         return false;
     }
 
     // 遍历子文件
     bool ret = true;
     for (auto &file : files) {
-        std::string filePath = copysetPath + "/" + file;
-        // recycle 失败不应该中断其他文件的recycle
-        if (!RecycleChunksAndWALInDir(filePath, file)) {
+        std::string filePath = path + "/" + file;
+        if (!CollectFilesInDir(filePath, file, chunks, wals)) {
             ret = false;
         }
     }
     return ret;
 }
 
+bool Trash::RecycleFiles(const std::vector<std::string> &chunks,
+                         const std::vector<std::string> &wals) {
+    size_t batchSize = recycleBatchSize_;
+    int batchNum = (chunks.size() + batchSize - 1) / batchSize +
+                   (wals.size() + batchSize - 1) / batchSize;
+    std::atomic<uint32_t> failed(0);
+    CountDownEvent done(batchNum);
+    for (const std::vector<std::string> *files : {&chunks, &wals}) {
+        bool isWal = (files == &wals);
+        for (size_t begin = 0; begin < files->size(); begin += batchSize) {
+            size_t end = std::min(begin + batchSize, files->size());
+            if (useRecyclePool_) {
+                recyclePool_.Enqueue(&Trash::RecycleBatch, this, files,
+                                     begin, end, isWal, &failed, &done);
+            } else {
+                RecycleBatch(files, begin, end, isWal, &failed, &done);
+            }
+        }
+    }
+    done.Wait();
+    return failed.load() == 0;
+}
+
+void Trash::RecycleBatch(const std::vector<std::string> *files,
+                         size_t begin, size_t end, bool isWal,
+                         std::atomic<uint32_t> *failed,
+                         CountDownEvent *done) {
+    for (size_t i = begin; i < end; ++i) {
+        // 停止时放弃剩余的文件，下次启动后再回收
+        if (useRecyclePool_ && isStop_.load()) {
+            failed->fetch_add(end - i);
+            break;
+        }
+        if (!IsPoolBelowWaterMark()) {
+            recycleThrottle_.Add(false, 1);
+        }
+        const std::string &path = (*files)[i];
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        bool ret = isWal ? RecycleWAL(path, name)
+                         : RecycleChunkfile(path, name);
+        if (!ret) {
+            failed->fetch_add(1);
+        }
+    }
+    done->Signal();
+}
+
+bool Trash::IsPoolBelowWaterMark() {
+    return poolLowWaterMark_ > 0 && chunkFilePool_ != nullptr &&
+           chunkFilePool_->Size() < poolLowWaterMark_;
+}
+
 bool Trash::RecycleChunkfile(
     const std::string &filepath, const std::string &filename) {
     (void)filename;
-    LockGuard lg(mtx_);
-    if (0 != chunkFilePool_->RecycleFile(filepath)) {
+    // 移到容量层的chunk是指向容量层文件的符号链接，
+    // 容量层的文件不属于chunkfilepool，和链接一起删除
+    std::string target;
+    if (0 == localFileSystem_->ReadLink(filepath, &target) &&
+        !target.empty()) {
+        int ret = localFileSystem_->Delete(target);
+        if ((ret < 0 && ret != -ENOENT) ||
+            0 != localFileSystem_->Delete(filepath)) {
+            LOG(ERROR) << "Trash failed delete chunk " << filepath
+                       << " on capacity tier " << target;
+            return false;
+        }
+    } else if (0 != chunkFilePool_->RecycleFile(filepath)) {
         LOG(ERROR) << "Trash  failed recycle chunk " << filepath
                     << " to FilePool";
         return false;
     }
 
     chunkNum_.fetch_sub(1);
+    recycledNum_.fetch_add(1);
     return true;
 }
 
 bool Trash::RecycleWAL(
     const std::string &filepath, const std::string &filename) {
     (void)filename;
-    LockGuard lg(mtx_);
     if (walPool_ != nullptr && 0 != walPool_->RecycleFile(filepath)) {
         LOG(ERROR) << "Trash  failed recycle WAL " << filepath
                     << " to WALPool";
@@ -282,6 +396,7 @@ bool Trash::RecycleWAL(
     }
 
     chunkNum_.fetch_sub(1);
+    recycledNum_.fetch_add(1);
     return true;
 }
 
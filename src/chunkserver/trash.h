@@ -23,18 +23,26 @@
 #ifndef SRC_CHUNKSERVER_TRASH_H_
 #define SRC_CHUNKSERVER_TRASH_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 #include "src/fs/local_filesystem.h"
 #include "src/chunkserver/datastore/file_pool.h"
 #include "src/common/concurrent/concurrent.h"
+#include "src/common/concurrent/count_down_event.h"
+#include "src/common/concurrent/task_thread_pool.h"
 #include "src/common/interruptible_sleeper.h"
+#include "src/common/throttle.h"
 
 using ::curve::common::Thread;
 using ::curve::common::Atomic;
 using ::curve::common::Mutex;
 using ::curve::common::LockGuard;
 using ::curve::common::InterruptibleSleeper;
+using ::curve::common::CountDownEvent;
+using ::curve::common::TaskThreadPool;
+using ::curve::common::Throttle;
 
 namespace curve {
 namespace chunkserver {
@@ -45,6 +53,15 @@ struct TrashOptions{
     int expiredAfterSec;
     // 扫描trash目录的时间间隔
     int scanPeriodSec;
+    // 并发回收文件的线程数，不大于1时在扫描线程中顺序回收
+    int recycleThreads = 1;
+    // 每个回收任务批量归还给FilePool的文件数
+    int recycleBatchSize = 64;
+    // 每秒最多回收的文件数，0表示不限速
+    int maxRecyclePerSec = 0;
+    // chunkfilepool中的文件数低于该水位时，不限速回收并缩短扫描间隔，
+    // 0表示不启用
+    uint64_t poolLowWaterMark = 0;
 
     std::shared_ptr<LocalFileSystem> localFileSystem;
     std::shared_ptr<FilePool> chunkFilePool;
@@ -73,6 +90,13 @@ class Trash {
     */
     uint32_t GetChunkNum() {return chunkNum_.load();}
 
+    /*
+    * @brief 获取已回收到FilePool的文件总数
+    *
+    * @return 文件个数
+    */
+    uint64_t GetRecycledNum() {return recycledNum_.load();}
+
  private:
     /*
     * @brief DeleteEligibleFileInTrashInterval 每隔一段时间进行trash物理空间回收
@@ -116,6 +140,50 @@ class Trash {
     bool RecycleChunksAndWALInDir(
         const std::string &copysetDir, const std::string &filename);
 
+    /*
+    * @brief 收集目录下待回收的chunk/snapshot文件和wal文件
+    *
+    * @param[in] path 文件或目录路径
+    * @param[in] filename 文件名
+    * @param[out] chunks chunk和snapshot文件路径
+    * @param[out] wals wal文件路径
+    *
+    * @return false-有目录list失败
+    */
+    bool CollectFilesInDir(const std::string &path,
+                           const std::string &filename,
+                           std::vector<std::string> *chunks,
+                           std::vector<std::string> *wals);
+
+    /*
+    * @brief 将文件分批归还给FilePool，chunk先于wal归还，
+    *        启动了回收线程池时各批次并发执行，返回前等待所有批次完成
+    *
+    * @param[in] chunks chunk和snapshot文件路径
+    * @param[in] wals wal文件路径
+    *
+    * @return true-全部回收成功
+    */
+    bool RecycleFiles(const std::vector<std::string> &chunks,
+                      const std::vector<std::string> &wals);
+
+    /*
+    * @brief 回收files中[begin, end)的文件
+    *
+    * @param[in] files 文件路径
+    * @param[in] isWal 是否为wal文件
+    * @param[out] failed 回收失败的文件数
+    * @param[out] done 批次完成时通知
+    */
+    void RecycleBatch(const std::vector<std::string> *files,
+                      size_t begin, size_t end, bool isWal,
+                      std::atomic<uint32_t> *failed, CountDownEvent *done);
+
+    /*
+    * @brief chunkfilepool中的文件数是否低于水位
+    */
+    bool IsPoolBelowWaterMark();
+
     /*
     * @brief Recycle Chunkfile
     *
@@ -166,6 +234,15 @@ class Trash {
     // 回收站中chunk的个数
     Atomic<uint32_t> chunkNum_;
 
+    // 已回收到FilePool的文件总数
+    Atomic<uint64_t> recycledNum_;
+
+    // 每个回收任务的文件数
+    int recycleBatchSize_;
+
+    // chunkfilepool的低水位
+    uint64_t poolLowWaterMark_;
+
     Mutex mtx_;
 
     // 本地文件系统
@@ -183,6 +260,14 @@ class Trash {
     // 后台清理回收站的线程
     Thread recycleThread_;
 
+    // 并发回收文件的线程池，recycleThreads大于1时在Run中启动
+    int recycleThreads_;
+    TaskThreadPool<> recyclePool_;
+    bool useRecyclePool_;
+
+    // 回收限速，chunkfilepool低于水位时不生效
+    Throttle recycleThrottle_;
+
     // false-开始后台任务，true-停止后台任务
     Atomic<bool> isStop_;
 
@@ -0,0 +1,307 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-12
+ */
+
+#include "src/chunkserver/volume_qos.h"
+
+#include <bthread/bthread.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace curve {
+namespace chunkserver {
+
+namespace {
+
+const double kUsPerSec = 1000000.0;
+const double kInfinity = std::numeric_limits<double>::infinity();
+
+double NowUs() {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void* RunTask(void* arg) {
+    std::unique_ptr<std::function<void()>> task(
+        static_cast<std::function<void()>*>(arg));
+    (*task)();
+    return nullptr;
+}
+
+}  // namespace
+
+VolumeQosScheduler::VolumeQosScheduler()
+    : inflight_(0), running_(false), queuedNum_(0) {}
+
+VolumeQosScheduler::~VolumeQosScheduler() {
+    Fini();
+}
+
+int VolumeQosScheduler::Init(const VolumeQosOptions& options) {
+    if (options.enable && (options.maxInflight == 0 ||
+                           options.defaultWeight == 0 ||
+                           options.costUnitBytes == 0)) {
+        LOG(ERROR) << "Invalid volume qos options, maxInflight: "
+                   << options.maxInflight << ", defaultWeight: "
+                   << options.defaultWeight << ", costUnitBytes: "
+                   << options.costUnitBytes;
+        return -1;
+    }
+    options_ = options;
+    return 0;
+}
+
+int VolumeQosScheduler::Run() {
+    if (!options_.enable) {
+        return 0;
+    }
+    LockGuard lk(mutex_);
+    if (running_) {
+        return 0;
+    }
+    running_ = true;
+    dispatcher_ = Thread(&VolumeQosScheduler::DispatchWorker, this);
+    LOG(INFO) << "Volume qos scheduler started, max inflight: "
+              << options_.maxInflight;
+    return 0;
+}
+
+int VolumeQosScheduler::Fini() {
+    std::vector<std::function<void()>> tasks;
+    {
+        LockGuard lk(mutex_);
+        if (!running_) {
+            return 0;
+        }
+        running_ = false;
+        cond_.notify_all();
+    }
+    dispatcher_.join();
+    {
+        // the queued requests hold the rpc closures, process them anyway
+        LockGuard lk(mutex_);
+        for (auto& volume : volumes_) {
+            for (auto& request : volume.second.queue) {
+                tasks.emplace_back(std::move(request.task));
+            }
+            volume.second.queue.clear();
+        }
+        backlogged_.clear();
+        inflight_ += tasks.size();
+        queuedNum_.store(0, std::memory_order_relaxed);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+    LOG(INFO) << "Volume qos scheduler stopped.";
+    return 0;
+}
+
+bool VolumeQosScheduler::Submit(uint64_t fileId, uint32_t length,
+                                std::function<void()> task) {
+    if (!options_.enable) {
+        task();
+        return true;
+    }
+
+    const double cost = std::max(
+        1.0, static_cast<double>(length) / options_.costUnitBytes);
+    UniqueLock lk(mutex_);
+    auto it = volumes_.find(fileId);
+    if (it == volumes_.end()) {
+        it = volumes_.emplace(fileId, VolumeState()).first;
+        auto params = params_.find(fileId);
+        if (params != params_.end()) {
+            it->second.params = params->second;
+        }
+    }
+    VolumeState* state = &it->second;
+    if (state->queue.size() >= options_.maxQueueDepth) {
+        return false;
+    }
+
+    const double now = NowUs();
+    QueuedRequest request;
+    TagRequest(state, now, cost, &request);
+    // nothing to arbitrate, process it in place
+    if (!running_ || (backlogged_.empty() &&
+        inflight_ < options_.maxInflight && request.limitTag <= now)) {
+        ++inflight_;
+        lk.unlock();
+        task();
+        return true;
+    }
+
+    request.task = std::move(task);
+    state->queue.emplace_back(std::move(request));
+    backlogged_.insert(fileId);
+    queuedNum_.fetch_add(1, std::memory_order_relaxed);
+    cond_.notify_one();
+    return true;
+}
+
+void VolumeQosScheduler::OnComplete() {
+    if (!options_.enable) {
+        return;
+    }
+    LockGuard lk(mutex_);
+    if (inflight_ > 0) {
+        --inflight_;
+    }
+    cond_.notify_one();
+}
+
+void VolumeQosScheduler::UpdateVolumeQos(
+    const std::unordered_map<uint64_t, VolumeQosParams>& params) {
+    LockGuard lk(mutex_);
+    params_ = params;
+    const double now = NowUs();
+    for (auto it = volumes_.begin(); it != volumes_.end();) {
+        VolumeState& state = it->second;
+        // the idle volumes which owe nothing are forgotten
+        if (state.queue.empty() && state.lastReservationTag <= now &&
+            state.lastLimitTag <= now && state.lastProportionTag <= now) {
+            it = volumes_.erase(it);
+            continue;
+        }
+        auto found = params_.find(it->first);
+        state.params =
+            found != params_.end() ? found->second : VolumeQosParams();
+        ++it;
+    }
+}
+
+void VolumeQosScheduler::TagRequest(VolumeState* state, double now,
+                                    double cost, QueuedRequest* request) {
+    const VolumeQosParams& params = state->params;
+    const uint32_t weight =
+        params.weight > 0 ? params.weight : options_.defaultWeight;
+    request->cost = cost;
+    if (params.reservation > 0) {
+        request->reservationTag = std::max(
+            state->lastReservationTag + cost * kUsPerSec / params.reservation,
+            now);
+        state->lastReservationTag = request->reservationTag;
+    } else {
+        request->reservationTag = kInfinity;
+    }
+    if (params.limit > 0) {
+        request->limitTag = std::max(
+            state->lastLimitTag + cost * kUsPerSec / params.limit, now);
+    } else {
+        request->limitTag = now;
+    }
+    state->lastLimitTag = request->limitTag;
+    request->proportionTag = std::max(
+        state->lastProportionTag + cost * kUsPerSec / weight, now);
+    state->lastProportionTag = request->proportionTag;
+}
+
+bool VolumeQosScheduler::PickRequest(double now, QueuedRequest* request,
+                                     double* wakeUpUs) {
+    // 1. the volumes below their reservation, earliest reservation first
+    auto picked = backlogged_.end();
+    double best = kInfinity;
+    for (auto it = backlogged_.begin(); it != backlogged_.end(); ++it) {
+        const QueuedRequest& head = volumes_[*it].queue.front();
+        if (head.reservationTag <= now && head.reservationTag < best) {
+            best = head.reservationTag;
+            picked = it;
+        }
+    }
+    const bool byReservation = picked != backlogged_.end();
+
+    // 2. share the rest by weight among the volumes below their limit
+    if (!byReservation) {
+        *wakeUpUs = kInfinity;
+        for (auto it = backlogged_.begin(); it != backlogged_.end(); ++it) {
+            const QueuedRequest& head = volumes_[*it].queue.front();
+            if (head.limitTag > now) {
+                *wakeUpUs = std::min(*wakeUpUs, std::min(head.limitTag,
+                                     head.reservationTag));
+                continue;
+            }
+            if (head.proportionTag < best) {
+                best = head.proportionTag;
+                picked = it;
+            }
+        }
+        if (picked == backlogged_.end()) {
+            return false;
+        }
+    }
+
+    VolumeState& state = volumes_[*picked];
+    *request = std::move(state.queue.front());
+    state.queue.pop_front();
+    if (!byReservation && state.params.reservation > 0) {
+        // served from the spare capacity, don't charge the reservation
+        const double charged =
+            request->cost * kUsPerSec / state.params.reservation;
+        for (auto& queued : state.queue) {
+            queued.reservationTag -= charged;
+        }
+        state.lastReservationTag -= charged;
+    }
+    if (state.queue.empty()) {
+        backlogged_.erase(picked);
+    }
+    queuedNum_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void VolumeQosScheduler::DispatchWorker() {
+    UniqueLock lk(mutex_);
+    while (running_) {
+        if (backlogged_.empty() || inflight_ >= options_.maxInflight) {
+            cond_.wait(lk);
+            continue;
+        }
+        const double now = NowUs();
+        QueuedRequest request;
+        double wakeUpUs = kInfinity;
+        if (!PickRequest(now, &request, &wakeUpUs)) {
+            // all the backlogged volumes are over their limits
+            cond_.wait_for(lk, std::chrono::microseconds(
+                static_cast<int64_t>(wakeUpUs - now) + 1));
+            continue;
+        }
+        ++inflight_;
+        lk.unlock();
+        // process it in a bthread, so the dispatcher isn't blocked by
+        // the request, e.g. a read waiting for the disk
+        auto* task = new std::function<void()>(std::move(request.task));
+        bthread_t tid;
+        if (bthread_start_background(&tid, nullptr, RunTask, task) != 0) {
+            LOG(WARNING) << "Start bthread failed, process request in place";
+            RunTask(task);
+        }
+        lk.lock();
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
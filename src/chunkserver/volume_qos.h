@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-12
+ */
+
+#ifndef SRC_CHUNKSERVER_VOLUME_QOS_H_
+#define SRC_CHUNKSERVER_VOLUME_QOS_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <set>
+#include <unordered_map>
+
+#include "src/common/concurrent/concurrent.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::Atomic;
+using curve::common::ConditionVariable;
+using curve::common::LockGuard;
+using curve::common::Mutex;
+using curve::common::Thread;
+using curve::common::UniqueLock;
+
+/**
+ * qos settings of a volume pushed from mds by heartbeat
+ */
+struct VolumeQosParams {
+    // ios per second guaranteed to the volume, 0 means no reservation
+    uint64_t reservation = 0;
+    // ios per second the volume can't exceed, 0 means unlimited
+    uint64_t limit = 0;
+    // share of the spare capacity, 0 means the default weight
+    uint32_t weight = 0;
+};
+
+struct VolumeQosOptions {
+    // if disabled, requests are processed as soon as they arrive
+    bool enable = false;
+    // max requests dispatched by the scheduler but not responded yet
+    uint32_t maxInflight = 128;
+    // weight of the volumes without settings from mds
+    uint32_t defaultWeight = 100;
+    // a request costs one io for each unit of its length
+    uint32_t costUnitBytes = 65536;
+    // requests are rejected when a volume has too many queued
+    uint32_t maxQueueDepth = 1024;
+};
+
+/**
+ * Weighted fair queueing of the read/write requests among volumes,
+ * following mClock: the volumes below their reservation are served first
+ * in the order of reservation tags, the spare capacity is shared by weight
+ * among the volumes below their limit. The capacity is represented by the
+ * number of requests in flight, a queued request is dispatched when an
+ * earlier one is responded, and processed in a bthread.
+ */
+class VolumeQosScheduler {
+ public:
+    VolumeQosScheduler();
+    virtual ~VolumeQosScheduler();
+
+    int Init(const VolumeQosOptions& options);
+
+    int Run();
+
+    /**
+     * @brief stop dispatching, the queued requests are processed at once
+     */
+    int Fini();
+
+    /**
+     * @brief process the request of the volume now or later
+     * @param fileId: id of the volume the request belongs to
+     * @param length: length of the request, to calculate its cost
+     * @param task: process the request, OnComplete() should be called
+     *              after it's responded
+     * @return false if the volume has too many requests queued
+     */
+    bool Submit(uint64_t fileId, uint32_t length, std::function<void()> task);
+
+    /**
+     * @brief called when a submitted request is responded
+     */
+    void OnComplete();
+
+    /**
+     * @brief replace the settings of all volumes, the volumes not in
+     *        |params| are reset to the default weight
+     */
+    void UpdateVolumeQos(
+        const std::unordered_map<uint64_t, VolumeQosParams>& params);
+
+    bool Enabled() const {
+        return options_.enable;
+    }
+
+    uint64_t GetQueuedNum() const {
+        return queuedNum_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    struct QueuedRequest {
+        double reservationTag;
+        double limitTag;
+        double proportionTag;
+        double cost;
+        std::function<void()> task;
+    };
+
+    struct VolumeState {
+        VolumeQosParams params;
+        double lastReservationTag = 0;
+        double lastLimitTag = 0;
+        double lastProportionTag = 0;
+        std::deque<QueuedRequest> queue;
+    };
+
+    // tag the request of |cost| arrived at |now| by the volume's settings
+    void TagRequest(VolumeState* state, double now, double cost,
+                    QueuedRequest* request);
+
+    // pick the next request to dispatch, return false if none is eligible
+    // now, |wakeUpUs| is set to when the earliest limited one is eligible
+    bool PickRequest(double now, QueuedRequest* request, double* wakeUpUs);
+
+    void DispatchWorker();
+
+    VolumeQosOptions options_;
+    Mutex mutex_;
+    ConditionVariable cond_;
+    // protected by mutex_
+    std::unordered_map<uint64_t, VolumeQosParams> params_;
+    std::unordered_map<uint64_t, VolumeState> volumes_;
+    // volumes with queued requests
+    std::set<uint64_t> backlogged_;
+    uint32_t inflight_;
+    bool running_;
+
+    Atomic<uint64_t> queuedNum_;
+    Thread dispatcher_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_VOLUME_QOS_H_
@@ -494,7 +494,7 @@ void WriteChunkClosure::OnSuccess() {
 }
 
 void ReadChunkClosure::SendRetryRequest() {
-    client_->ReadChunk(reqCtx_->idinfo_, reqCtx_->seq_,
+    client_->ReadChunk(reqCtx_->idinfo_, reqCtx_->fileId_, reqCtx_->seq_,
                        reqCtx_->offset_,
                        reqCtx_->rawlength_,
                        reqCtx_->sourceInfo_,
@@ -82,6 +82,7 @@ class CopysetClient {
     /**
      * 读Chunk
      * @param idinfo为chunk相关的id信息
+     * @param fileId: file id
      * @param sn:文件版本号
      * @param offset:读的偏移
      * @param length:读的长度
@@ -89,6 +90,7 @@ class CopysetClient {
      * @param done:上一层异步回调的closure
      */
     int ReadChunk(const ChunkIDInfo& idinfo,
+                  uint64_t fileId,
                   uint64_t sn,
                   off_t offset,
                   size_t length,
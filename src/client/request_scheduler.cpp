@@ -165,8 +165,8 @@ void RequestScheduler::ProcessOne(RequestContext* ctx) {
     switch (ctx->optype_) {
         case OpType::READ:
             ctx->done_->GetInflightRPCToken();
-            client_.ReadChunk(ctx->idinfo_, ctx->seq_, ctx->offset_,
-                              ctx->rawlength_, ctx->sourceInfo_,
+            client_.ReadChunk(ctx->idinfo_, ctx->fileId_, ctx->seq_,
+                              ctx->offset_, ctx->rawlength_, ctx->sourceInfo_,
                               guard.release());
             break;
         case OpType::WRITE:
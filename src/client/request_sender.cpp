@@ -74,6 +74,7 @@ int RequestSender::Init(const IOSenderOption& ioSenderOpt) {
 }
 
 int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
+                             uint64_t fileId,
                              uint64_t sn,
                              off_t offset,
                              size_t length,
@@ -94,6 +95,8 @@ int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
     request.set_chunkid(idinfo.cid_);
     request.set_offset(offset);
     request.set_size(length);
+    // chunkserver schedules requests among volumes by file id
+    request.set_fileid(fileId);
 
     if (sourceInfo.IsValid()) {
         request.set_clonefilesource(sourceInfo.cloneFileSource);
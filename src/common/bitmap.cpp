@@ -168,54 +168,66 @@ bool Bitmap::Test(uint32_t index) const {
 }
 
 uint32_t Bitmap::NextSetBit(uint32_t index) const {
-    for (; index < bits_; ++index) {
-        if (Test(index))
-            break;
-    }
-    if (index >= bits_)
-        index = NO_POS;
-    return index;
+    return NextBit(index, bits_ - 1, true);
 }
 
 uint32_t Bitmap::NextSetBit(uint32_t startIndex, uint32_t endIndex) const {
-    uint32_t index = startIndex;
-    // bitmap中最后一个bit的index值
-    uint32_t lastIndex = bits_ - 1;
-    // endIndex值不能超过lastIndex
-    if (endIndex > lastIndex)
-        endIndex = lastIndex;
-    for (; index <= endIndex; ++index) {
-        if (Test(index))
-            break;
-    }
-    if (index > endIndex)
-        index = NO_POS;
-    return index;
+    return NextBit(startIndex, endIndex, true);
 }
 
 uint32_t Bitmap::NextClearBit(uint32_t index) const {
-    for (; index < bits_; ++index) {
-        if (!Test(index))
-            break;
-    }
-    if (index >= bits_)
-        index = NO_POS;
-    return index;
+    return NextBit(index, bits_ - 1, false);
 }
 
 uint32_t Bitmap::NextClearBit(uint32_t startIndex, uint32_t endIndex) const {
-    uint32_t index = startIndex;
-    uint32_t lastIndex = bits_ - 1;
-    // endIndex值不能超过lastIndex
-    if (endIndex > lastIndex)
-        endIndex = lastIndex;
-    for (; index <= endIndex; ++index) {
-        if (!Test(index))
+    return NextBit(startIndex, endIndex, false);
+}
+
+uint32_t Bitmap::NextBit(uint32_t startIndex,
+                         uint32_t endIndex,
+                         bool set) const {
+    if (bits_ == 0) {
+        return NO_POS;
+    }
+    // endIndex值不能超过最后一个bit的index值
+    if (endIndex > bits_ - 1) {
+        endIndex = bits_ - 1;
+    }
+
+    uint64_t index = startIndex;
+    const uint64_t end = static_cast<uint64_t>(endIndex) + 1;
+
+    // test bit by bit until reaching the boundary of unit
+    for (; index < end && index % BITMAP_UNIT_SIZE != 0; ++index) {
+        if (Test(index) == set) {
+            return index;
+        }
+    }
+
+    // skip words and units in which no bit is wanted
+    const uint64_t skipWord = set ? 0 : ~0ULL;
+    constexpr uint64_t kBitsPerWord = sizeof(uint64_t) * BITMAP_UNIT_SIZE;
+    for (; index + kBitsPerWord <= end; index += kBitsPerWord) {
+        uint64_t word;
+        memcpy(&word, bitmap_ + indexOfUnit(index), sizeof(word));
+        if (word != skipWord) {
             break;
+        }
+    }
+
+    const char skipUnit = static_cast<char>(skipWord);
+    for (; index + BITMAP_UNIT_SIZE <= end; index += BITMAP_UNIT_SIZE) {
+        if (bitmap_[indexOfUnit(index)] != skipUnit) {
+            break;
+        }
+    }
+
+    for (; index < end; ++index) {
+        if (Test(index) == set) {
+            return index;
+        }
     }
-    if (index > endIndex)
-        index = NO_POS;
-    return index;
+    return NO_POS;
 }
 
 void Bitmap::Divide(uint32_t startIndex,
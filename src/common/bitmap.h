@@ -192,6 +192,10 @@ class Bitmap {
         // 同 index / BITMAP_UNIT_SIZE
         return index >> ALIGN_FACTOR;
     }
+    // 获取[startIndex, endIndex]之间首个状态为set的位置，
+    // 按字（64位）跳过不满足条件的区域，不存在返回NO_POS
+    uint32_t NextBit(uint32_t startIndex, uint32_t endIndex, bool set) const;
+
     // 逻辑计算掩码值
     char mask(uint32_t index) const {
         int indexInUnit =  index % BITMAP_UNIT_SIZE;
@@ -25,6 +25,7 @@
 #include <sys/utsname.h>
 #include <linux/version.h>
 #include <dirent.h>
+#include <limits.h>
 
 #include "src/common/string_util.h"
 #include "src/fs/ext4_filesystem_impl.h"
@@ -416,5 +417,31 @@ int Ext4FileSystemImpl::Fsync(int fd) {
     return 0;
 }
 
+int Ext4FileSystemImpl::Symlink(const string& target,
+                                const string& linkPath) {
+    int rc = posixWrapper_->symlink(target.c_str(), linkPath.c_str());
+    if (rc < 0) {
+        LOG(WARNING) << "symlink failed: " << strerror(errno)
+                     << ", target = " << target
+                     << ", link path = " << linkPath;
+        return -errno;
+    }
+    return 0;
+}
+
+int Ext4FileSystemImpl::ReadLink(const string& linkPath, string* target) {
+    char buf[PATH_MAX];
+    ssize_t len = posixWrapper_->readlink(linkPath.c_str(), buf, sizeof(buf));
+    if (len < 0) {
+        // 不是符号链接属于正常情况，不打印日志
+        return -errno;
+    }
+    if (static_cast<size_t>(len) >= sizeof(buf)) {
+        return -ENAMETOOLONG;
+    }
+    target->assign(buf, len);
+    return 0;
+}
+
 }  // namespace fs
 }  // namespace curve
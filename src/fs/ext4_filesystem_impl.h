@@ -61,6 +61,8 @@ class Ext4FileSystemImpl : public LocalFileSystem {
                   int length) override;
     int Fstat(int fd, struct stat* info) override;
     int Fsync(int fd) override;
+    int Symlink(const string& target, const string& linkPath) override;
+    int ReadLink(const string& linkPath, string* target) override;
 
  private:
     explicit Ext4FileSystemImpl(std::shared_ptr<PosixWrapper>);
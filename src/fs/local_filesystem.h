@@ -215,6 +215,22 @@ class LocalFileSystem {
      */
     virtual int Fsync(int fd) = 0;
 
+    /**
+     * 创建指向target的符号链接
+     * @param target：链接指向的路径
+     * @param linkPath：符号链接的路径，已存在时返回错误
+     * @return 成功返回0
+     */
+    virtual int Symlink(const string& target, const string& linkPath) = 0;
+
+    /**
+     * 读取符号链接指向的路径
+     * @param linkPath：符号链接的路径
+     * @param target[out]：链接指向的路径
+     * @return 成功返回0，linkPath不是符号链接时返回-EINVAL
+     */
+    virtual int ReadLink(const string& linkPath, string* target) = 0;
+
  private:
     virtual int DoRename(const string& /* oldPath */,
                          const string& /* newPath */,
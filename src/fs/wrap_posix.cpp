@@ -129,5 +129,14 @@ int PosixWrapper::uname(struct utsname *buf) {
     return ::uname(buf);
 }
 
+int PosixWrapper::symlink(const char *target, const char *linkpath) {
+    return ::symlink(target, linkpath);
+}
+
+ssize_t PosixWrapper::readlink(const char *pathname, char *buf,
+                               size_t bufsiz) {
+    return ::readlink(pathname, buf, bufsiz);
+}
+
 }  // namespace fs
 }  // namespace curve
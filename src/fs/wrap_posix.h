@@ -66,6 +66,8 @@ class PosixWrapper {
     virtual int fsync(int fd);
     virtual int statfs(const char *path, struct statfs *buf);
     virtual int uname(struct utsname *buf);
+    virtual int symlink(const char *target, const char *linkpath);
+    virtual ssize_t readlink(const char *pathname, char *buf, size_t bufsiz);
 };
 
 }  // namespace fs
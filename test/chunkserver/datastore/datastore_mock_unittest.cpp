@@ -54,6 +54,7 @@ using ::testing::ReturnArg;
 using ::testing::ElementsAre;
 using ::testing::SetArgPointee;
 using ::testing::SetArrayArgument;
+using ::testing::Sequence;
 
 using std::shared_ptr;
 using std::make_shared;
@@ -81,6 +82,12 @@ const char chunk2snap1Path[]
 const char temp1[] = "chunk_1_tmp";
 const char temp1Path[]
     = "/home/chunkserver/copyset/data/chunk_1_tmp";
+const char chunk1TierPath[]
+    = "/home/chunkserver/copyset/data/chunk_1_tier";
+const char capacityDir[] = "/home/chunkserver/capacity/data";
+const char capacity1Path[] = "/home/chunkserver/capacity/data/chunk_1";
+const char capacity1TempPath[]
+    = "/home/chunkserver/capacity/data/chunk_1_tier";
 const char location[] = "/file1/0@curve";
 const int UT_ERRNO = 1234;
 
@@ -252,6 +259,68 @@ class CSDataStore_test
                           Return(metapagesize_)));
         }
 
+        /**
+         * 构造开启分层的初始环境，chunk和FakeEnv()相同
+         * onCapacityTier为true时chunk1的文件是指向容量层的symlink
+         */
+        void FakeTierEnv(bool onCapacityTier) {
+            DataStoreOptions options;
+            options.baseDir = baseDir;
+            options.chunkSize = chunksize_;
+            options.blockSize = blocksize_;
+            options.metaPageSize = metapagesize_;
+            options.locationLimit = kLocationLimit;
+            options.enableOdsyncWhenOpenChunkFile = true;
+            options.capacityDir = capacityDir;
+            dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+            // the expectations on the same files are added by the cases
+            EXPECT_CALL(*lfs_, FileExists(_))
+                .WillRepeatedly(Return(false));
+            EXPECT_CALL(*lfs_, ReadLink(_, _))
+                .WillRepeatedly(Return(-ENOENT));
+            EXPECT_CALL(*lfs_, Symlink(_, _))
+                .WillRepeatedly(Return(0));
+            EXPECT_CALL(*lfs_, Rename(_, _, _))
+                .WillRepeatedly(Return(0));
+            EXPECT_CALL(*lfs_, Delete(_))
+                .WillRepeatedly(Return(0));
+            EXPECT_CALL(*lfs_, Fsync(_))
+                .WillRepeatedly(Return(0));
+            EXPECT_CALL(*fpool_, GetFileImpl(_, _))
+                .WillRepeatedly(Return(0));
+            FakeEnv();
+            EXPECT_CALL(*lfs_, DirExists(capacityDir))
+                .WillRepeatedly(Return(true));
+            vector<string> capacityFiles;
+            if (onCapacityTier) {
+                capacityFiles.push_back(chunk1);
+                EXPECT_CALL(*lfs_, ReadLink(chunk1Path, NotNull()))
+                    .WillRepeatedly(DoAll(
+                        SetArgPointee<1>(string(capacity1Path)), Return(0)));
+                EXPECT_CALL(*lfs_, Open(capacity1Path, _))
+                    .WillRepeatedly(Return(1));
+                EXPECT_CALL(*lfs_, FileExists(capacity1Path))
+                    .WillRepeatedly(Return(true));
+            }
+            EXPECT_CALL(*lfs_, List(capacityDir, NotNull()))
+                .WillRepeatedly(DoAll(SetArgPointee<1>(capacityFiles),
+                                Return(0)));
+            // the directories are opened to be synced
+            EXPECT_CALL(*lfs_, Open(capacityDir, O_RDONLY|O_DIRECTORY))
+                .WillRepeatedly(Return(5));
+            EXPECT_CALL(*lfs_, Open(baseDir, O_RDONLY|O_DIRECTORY))
+                .WillRepeatedly(Return(6));
+        }
+
+        // chunk1被拷贝时读写的数据
+        void FakeTierCopy() {
+            EXPECT_CALL(*lfs_, Read(_, NotNull(), _, _))
+                .WillRepeatedly(ReturnArg<3>());
+            EXPECT_CALL(*lfs_,
+                        Write(_, Matcher<const char*>(NotNull()), _, _))
+                .WillRepeatedly(ReturnArg<3>());
+        }
+
  protected:
     int fdMock;
     std::shared_ptr<MockLocalFileSystem> lfs_;
@@ -4267,6 +4336,508 @@ TEST_P(CSDataStore_test, GetStatusTest) {
         .Times(1);
 }
 
+/*
+ * 延迟加载chunk测试
+ * case:开启延迟加载，并且最多缓存1个chunk文件的fd
+ * 预期结果:初始化时不打开chunk文件，第一次访问时加载，fd被淘汰后重新打开
+ */
+TEST_P(CSDataStore_test, LazyLoadTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = chunksize_;
+    options.blockSize = blocksize_;
+    options.metaPageSize = metapagesize_;
+    options.locationLimit = kLocationLimit;
+    options.enableOdsyncWhenOpenChunkFile = true;
+    options.lazyLoadChunk = true;
+    options.fdCache = std::make_shared<ChunkFdCache>(1);
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    FakeEnv();
+    EXPECT_CALL(*lfs_, Open(chunk1Path, _))
+        .Times(2)
+        .WillRepeatedly(Return(1));
+    EXPECT_TRUE(dataStore->Initialize());
+
+    // chunks are counted before loaded, snapshots are not
+    DataStoreStatus status = dataStore->GetStatus();
+    ASSERT_EQ(2, status.chunkFileCount);
+    ASSERT_EQ(0, status.snapshotCount);
+    // the chunks not loaded yet are not listed, nor loaded by listing
+    ASSERT_EQ(0, dataStore->GetChunkMap().size());
+    // but their ids are, e.g. for scanning all the chunks
+    ASSERT_EQ(std::vector<ChunkID>({1, 2}), dataStore->GetChunkIds());
+
+    // chunk1 is loaded with its snapshot on first access
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), metapagesize_, blocksize_))
+        .Times(2);
+    std::unique_ptr<char[]> buf(new char[blocksize_]);
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(1, 2, buf.get(), 0, blocksize_));
+    status = dataStore->GetStatus();
+    ASSERT_EQ(2, status.chunkFileCount);
+    ASSERT_EQ(1, status.snapshotCount);
+    ASSERT_EQ(1, dataStore->GetChunkMap().size());
+
+    // the fd of chunk1 is evicted by chunk2, and reopened by next read,
+    // which evicts the fd of chunk2 in turn
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), metapagesize_, blocksize_))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(2);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(2, 2, buf.get(), 0, blocksize_));
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunk(1, 2, buf.get(), 0, blocksize_));
+    ASSERT_EQ(1, options.fdCache->Size());
+    ASSERT_EQ(2, dataStore->GetChunkMap().size());
+    ASSERT_EQ(std::vector<ChunkID>({1, 2}), dataStore->GetChunkIds());
+    ASSERT_NE(nullptr, dataStore->LoadChunk(2));
+    ASSERT_EQ(nullptr, dataStore->LoadChunk(3));
+
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+}
+
+/*
+ * chunk文件fd缓存分片测试
+ * case:缓存按chunk文件路径分片，每个分片各自淘汰
+ * 预期结果:缓存的fd总数不超过上限，最近放入的fd不会被淘汰
+ */
+TEST_P(CSDataStore_test, ChunkFdCacheShardTest) {
+    const uint64_t maxOpenFiles = 64;
+    const int fileNum = 1000;
+    ChunkFdCache cache(maxOpenFiles);
+    auto chunkPath = [](int i) {
+        return std::string(baseDir) + "/chunk_" + std::to_string(i);
+    };
+    // the fds are closed when evicted, removed or the cache is destroyed
+    EXPECT_CALL(*lfs_, Close(_))
+        .Times(fileNum - 1);
+    EXPECT_CALL(*lfs_, Close(fileNum - 1))
+        .Times(1);
+    for (int i = 0; i < fileNum; ++i) {
+        std::string path = chunkPath(i);
+        cache.Put(path, std::make_shared<ChunkFd>(lfs_, i));
+        ASSERT_LE(cache.Size(), maxOpenFiles);
+        ChunkFdPtr fd = cache.Get(path);
+        ASSERT_NE(nullptr, fd);
+        ASSERT_EQ(i, fd->Fd());
+    }
+    ASSERT_EQ(maxOpenFiles, cache.Size());
+
+    std::string path = chunkPath(fileNum - 1);
+    cache.Remove(path);
+    ASSERT_EQ(nullptr, cache.Get(path));
+    ASSERT_EQ(maxOpenFiles - 1, cache.Size());
+}
+
+/*
+ * 移动chunk到容量层测试
+ * case:各步骤都成功
+ * 预期结果:拷贝持久化之后才创建symlink，symlink持久化之后才回收chunk文件
+ */
+TEST_P(CSDataStore_test, DemoteTest) {
+    FakeTierEnv(false);
+    EXPECT_TRUE(dataStore->Initialize());
+    FakeTierCopy();
+    CSChunkFilePtr chunk = dataStore->GetChunkMap()[1];
+    ASSERT_NE(nullptr, chunk);
+
+    Sequence s;
+    EXPECT_CALL(*lfs_, Open(capacity1TempPath, O_RDWR|O_CREAT|O_TRUNC))
+        .WillOnce(Return(4));
+    EXPECT_CALL(*lfs_, Fsync(4))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Rename(capacity1TempPath, capacity1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Fsync(5))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Symlink(capacity1Path, chunk1TierPath))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Fsync(6))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*fpool_, RecycleFile(chunk1Path))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Rename(chunk1TierPath, chunk1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Open(capacity1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(7));
+    EXPECT_CALL(*lfs_, Delete(_))
+        .Times(0);
+    ASSERT_EQ(CSErrorCode::Success, chunk->Demote(capacity1Path));
+    ASSERT_TRUE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(1, dataStore->GetStatus().capacityChunkCount);
+    // 已经在容量层上的chunk不再移动
+    ASSERT_EQ(CSErrorCode::Success, chunk->Demote(capacity1Path));
+}
+
+/*
+ * 移动chunk到容量层测试
+ * case:拷贝chunk文件的各步骤失败
+ * 预期结果:删除容量层上的拷贝，chunk仍在快速层
+ */
+TEST_P(CSDataStore_test, DemoteCopyErrorTest) {
+    FakeTierEnv(false);
+    EXPECT_TRUE(dataStore->Initialize());
+    FakeTierCopy();
+    CSChunkFilePtr chunk = dataStore->GetChunkMap()[1];
+    ASSERT_NE(nullptr, chunk);
+    EXPECT_CALL(*lfs_, Open(capacity1TempPath, O_RDWR|O_CREAT|O_TRUNC))
+        .WillRepeatedly(Return(4));
+    EXPECT_CALL(*lfs_, Symlink(_, _))
+        .Times(0);
+    EXPECT_CALL(*fpool_, RecycleFile(_))
+        .Times(0);
+
+    // case1: 创建拷贝失败
+    EXPECT_CALL(*lfs_, Open(capacity1TempPath, O_RDWR|O_CREAT|O_TRUNC))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1TempPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+
+    // case2: 写拷贝失败
+    EXPECT_CALL(*lfs_, Write(4, Matcher<const char*>(NotNull()), _, _))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1TempPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+
+    // case3: sync拷贝失败
+    EXPECT_CALL(*lfs_, Fsync(4))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1TempPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+
+    // case4: rename拷贝失败
+    EXPECT_CALL(*lfs_, Rename(capacity1TempPath, capacity1Path, _))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1TempPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+
+    // case5: sync容量层目录失败，rename之后的拷贝被删除
+    EXPECT_CALL(*lfs_, Rename(capacity1TempPath, capacity1Path, _))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Fsync(5))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(0, dataStore->GetStatus().capacityChunkCount);
+}
+
+/*
+ * 移动chunk到容量层测试
+ * case:替换chunk文件的各步骤失败
+ * 预期结果:删除symlink和容量层上的拷贝，chunk仍在快速层
+ */
+TEST_P(CSDataStore_test, DemoteLinkErrorTest) {
+    FakeTierEnv(false);
+    EXPECT_TRUE(dataStore->Initialize());
+    FakeTierCopy();
+    CSChunkFilePtr chunk = dataStore->GetChunkMap()[1];
+    ASSERT_NE(nullptr, chunk);
+    EXPECT_CALL(*lfs_, Open(capacity1TempPath, O_RDWR|O_CREAT|O_TRUNC))
+        .WillRepeatedly(Return(4));
+    EXPECT_CALL(*lfs_, Rename(capacity1TempPath, capacity1Path, _))
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*lfs_, Rename(chunk1TierPath, _, _))
+        .Times(0);
+
+    // case1: 创建symlink失败
+    EXPECT_CALL(*lfs_, Symlink(capacity1Path, chunk1TierPath))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*fpool_, RecycleFile(_))
+        .Times(0);
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+
+    // case2: sync快速层目录失败，symlink删除之后再删除拷贝
+    Sequence s;
+    EXPECT_CALL(*lfs_, Symlink(capacity1Path, chunk1TierPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Fsync(6))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(chunk1TierPath))
+        .InSequence(s)
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .InSequence(s)
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+
+    // case3: 回收chunk文件失败，chunk文件重新打开
+    EXPECT_CALL(*lfs_, Symlink(capacity1Path, chunk1TierPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*fpool_, RecycleFile(chunk1Path))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(chunk1TierPath))
+        .InSequence(s)
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .InSequence(s)
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Open(chunk1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(1))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Demote(capacity1Path));
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(0, dataStore->GetStatus().capacityChunkCount);
+}
+
+/*
+ * 移动chunk到快速层测试
+ * case:各步骤都成功
+ * 预期结果:替换symlink持久化之后才删除容量层上的文件
+ */
+TEST_P(CSDataStore_test, PromoteTest) {
+    FakeTierEnv(true);
+    EXPECT_TRUE(dataStore->Initialize());
+    FakeTierCopy();
+    CSChunkFilePtr chunk = dataStore->GetChunkMap()[1];
+    ASSERT_NE(nullptr, chunk);
+    ASSERT_TRUE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(1, dataStore->GetStatus().capacityChunkCount);
+
+    Sequence s;
+    EXPECT_CALL(*fpool_, GetFileImpl(chunk1TierPath, NotNull()))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Open(chunk1TierPath, O_RDWR))
+        .InSequence(s)
+        .WillOnce(Return(4));
+    EXPECT_CALL(*lfs_, Fsync(4))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Rename(chunk1TierPath, chunk1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Fsync(6))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Open(chunk1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(1));
+    EXPECT_CALL(*fpool_, RecycleFile(_))
+        .Times(0);
+    ASSERT_EQ(CSErrorCode::Success, chunk->Promote());
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(0, dataStore->GetStatus().capacityChunkCount);
+    // 已经在快速层上的chunk不再移动
+    ASSERT_EQ(CSErrorCode::Success, chunk->Promote());
+}
+
+/*
+ * 移动chunk到快速层测试
+ * case:各步骤失败
+ * 预期结果:拷贝回收到chunk file pool，chunk仍在容量层；
+ *          替换之后sync失败时保留容量层上的文件
+ */
+TEST_P(CSDataStore_test, PromoteErrorTest) {
+    FakeTierEnv(true);
+    EXPECT_TRUE(dataStore->Initialize());
+    FakeTierCopy();
+    CSChunkFilePtr chunk = dataStore->GetChunkMap()[1];
+    ASSERT_NE(nullptr, chunk);
+    EXPECT_CALL(*lfs_, Open(chunk1TierPath, O_RDWR))
+        .WillRepeatedly(Return(4));
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .Times(0);
+
+    // case1: 从chunk file pool获取文件失败
+    EXPECT_CALL(*fpool_, GetFileImpl(chunk1TierPath, NotNull()))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*fpool_, RecycleFile(_))
+        .Times(0);
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Promote());
+    ASSERT_TRUE(chunk->IsOnCapacityTier());
+
+    // case2: 读容量层上的文件失败
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), _, _))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*fpool_, RecycleFile(chunk1TierPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Promote());
+    ASSERT_TRUE(chunk->IsOnCapacityTier());
+
+    // case3: sync拷贝失败
+    EXPECT_CALL(*lfs_, Fsync(4))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*fpool_, RecycleFile(chunk1TierPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Promote());
+    ASSERT_TRUE(chunk->IsOnCapacityTier());
+
+    // case4: 替换symlink失败，重新打开容量层上的文件
+    EXPECT_CALL(*lfs_, Rename(chunk1TierPath, chunk1Path, _))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*fpool_, RecycleFile(chunk1TierPath))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Open(capacity1Path, _))
+        .WillOnce(Return(1))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::InternalError, chunk->Promote());
+    ASSERT_TRUE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(1, dataStore->GetStatus().capacityChunkCount);
+
+    // case5: sync快速层目录失败，容量层上的文件在重启时作为孤儿文件删除
+    EXPECT_CALL(*lfs_, Rename(chunk1TierPath, chunk1Path, _))
+        .WillOnce(Return(0))
+        .RetiresOnSaturation();
+    EXPECT_CALL(*lfs_, Fsync(6))
+        .WillOnce(Return(-UT_ERRNO))
+        .RetiresOnSaturation();
+    ASSERT_EQ(CSErrorCode::Success, chunk->Promote());
+    ASSERT_FALSE(chunk->IsOnCapacityTier());
+    ASSERT_EQ(0, dataStore->GetStatus().capacityChunkCount);
+}
+
+/*
+ * 移动已删除的chunk测试
+ * case:chunk在MigrateChunks拷贝chunk map之后被删除
+ * 预期结果:返回ChunkNotExistError，不创建拷贝
+ */
+TEST_P(CSDataStore_test, MoveDeletedChunkTest) {
+    FakeTierEnv(true);
+    EXPECT_TRUE(dataStore->Initialize());
+    CSChunkFilePtr chunk1 = dataStore->GetChunkMap()[1];
+    CSChunkFilePtr chunk2 = dataStore->GetChunkMap()[2];
+    EXPECT_CALL(*lfs_, Delete(chunk1Path))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .WillOnce(Return(0));
+    ASSERT_EQ(CSErrorCode::Success, dataStore->DeleteChunk(1, 2));
+    ASSERT_EQ(CSErrorCode::Success, dataStore->DeleteChunk(2, 2));
+
+    EXPECT_CALL(*fpool_, GetFileImpl(_, _))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Open(capacity1TempPath, _))
+        .Times(0);
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError, chunk1->Promote());
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError,
+              chunk2->Demote(capacityDir + string("/chunk_2")));
+}
+
+/*
+ * 初始化时恢复移动chunk的临时文件测试
+ * case:chunk1的symlink已经创建，chunk文件还未回收；
+ *      chunk2从容量层拷贝的文件还未替换symlink；
+ *      chunk3的symlink指向的拷贝不存在；
+ *      容量层上存在未被引用的文件
+ * 预期结果:chunk1的symlink替换chunk文件，chunk2的拷贝被回收，
+ *          chunk3的symlink和容量层上的孤儿文件被删除
+ */
+TEST_P(CSDataStore_test, RecoverTierTempFilesTest) {
+    FakeTierEnv(true);
+    const string chunk2TierPath = string(chunk2Path) + "_tier";
+    const string chunk3TierPath = string(baseDir) + "/chunk_3_tier";
+    const string capacity3Path = string(capacityDir) + "/chunk_3";
+    const string capacity4Path = string(capacityDir) + "/chunk_4";
+    vector<string> fileNames;
+    fileNames.push_back(chunk1);
+    fileNames.push_back("chunk_1_tier");
+    fileNames.push_back(chunk1snap1);
+    fileNames.push_back(chunk2);
+    fileNames.push_back("chunk_2_tier");
+    fileNames.push_back("chunk_3_tier");
+    EXPECT_CALL(*lfs_, List(baseDir, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(fileNames), Return(0)));
+    vector<string> capacityFiles;
+    capacityFiles.push_back(chunk1);
+    capacityFiles.push_back("chunk_1_tier");
+    capacityFiles.push_back("chunk_4");
+    EXPECT_CALL(*lfs_, List(capacityDir, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(capacityFiles), Return(0)));
+
+    // chunk1在symlink替换之后是容量层上的chunk
+    EXPECT_CALL(*lfs_, ReadLink(chunk1Path, NotNull()))
+        .WillOnce(Return(-ENOENT))
+        .WillRepeatedly(DoAll(
+            SetArgPointee<1>(string(capacity1Path)), Return(0)));
+    EXPECT_CALL(*lfs_, ReadLink(chunk1TierPath, NotNull()))
+        .WillOnce(DoAll(
+            SetArgPointee<1>(string(capacity1Path)), Return(0)));
+    EXPECT_CALL(*lfs_, ReadLink(chunk3TierPath, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(capacity3Path), Return(0)));
+
+    Sequence s;
+    EXPECT_CALL(*fpool_, RecycleFile(chunk1Path))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Rename(chunk1TierPath, chunk1Path, _))
+        .InSequence(s)
+        .WillOnce(Return(0));
+    EXPECT_CALL(*fpool_, RecycleFile(chunk2TierPath))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Delete(chunk3TierPath))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Delete(capacity1TempPath))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Delete(capacity4Path))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Delete(capacity1Path))
+        .Times(0);
+    EXPECT_TRUE(dataStore->Initialize());
+
+    DataStoreStatus status = dataStore->GetStatus();
+    ASSERT_EQ(2, status.chunkFileCount);
+    ASSERT_EQ(1, status.capacityChunkCount);
+    ASSERT_TRUE(dataStore->GetChunkMap()[1]->IsOnCapacityTier());
+    ASSERT_FALSE(dataStore->GetChunkMap()[2]->IsOnCapacityTier());
+}
+
 INSTANTIATE_TEST_CASE_P(
     CSDataStoreTest,
     CSDataStore_test,
@@ -68,6 +68,8 @@ class MockDataStore : public CSDataStore {
     MOCK_METHOD2(GetChunkInfo, CSErrorCode(ChunkID, CSChunkInfo*));
     MOCK_METHOD0(GetStatus, DataStoreStatus());
     MOCK_METHOD0(GetChunkMap, ChunkMap());
+    MOCK_METHOD0(GetChunkIds, std::vector<ChunkID>());
+    MOCK_METHOD1(LoadChunk, CSChunkFilePtr(ChunkID));
 };
 
 }  // namespace chunkserver
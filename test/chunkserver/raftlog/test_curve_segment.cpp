@@ -27,9 +27,14 @@
 // Date: 2015/10/08 17:00:05
 
 #include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <gtest/gtest.h>
 #include <braft/log.h>
 #include <memory>
+#include <string>
 #include "src/chunkserver/raftlog/curve_segment.h"
 #include "src/chunkserver/raftlog/define.h"
 #include "test/fs/mock_local_filesystem.h"
@@ -40,9 +45,47 @@ namespace curve {
 namespace chunkserver {
 
 using curve::fs::MockLocalFileSystem;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::_;
 
+namespace {
+
+// whether the filesystem of dir supports FICLONERANGE
+bool support_reflink(const std::string& dir) {
+#ifdef FICLONERANGE
+    std::string src_path = dir + "/reflink_src";
+    std::string dst_path = dir + "/reflink_dst";
+    int src = ::open(src_path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+    int dst = ::open(dst_path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+    bool supported = false;
+    if (src >= 0 && dst >= 0) {
+        std::string data(kPageSize, 'r');
+        struct file_clone_range range;
+        range.src_fd = src;
+        range.src_offset = 0;
+        range.src_length = kPageSize;
+        range.dest_offset = 0;
+        supported = ::pwrite(src, data.data(), data.size(), 0) ==
+                        static_cast<ssize_t>(data.size()) &&
+                    ::ioctl(dst, FICLONERANGE, &range) == 0;
+    }
+    if (src >= 0) {
+        ::close(src);
+    }
+    if (dst >= 0) {
+        ::close(dst);
+    }
+    ::unlink(src_path.c_str());
+    ::unlink(dst_path.c_str());
+    return supported;
+#else
+    return false;
+#endif
+}
+
+}  // namespace
+
 class CurveSegmentTest : public testing::Test {
  protected:
     CurveSegmentTest() {
@@ -234,5 +277,169 @@ TEST_F(CurveSegmentTest, closed_segment) {
     delete configuration_manager;
 }
 
+TEST_F(CurveSegmentTest, front_padded_entries) {
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFileImpl(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Return(0));
+    // pad all the entries in front of their data
+    FLAGS_walLargeEntryThreshold = 1;
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1L);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+    append_entries_curve_segment(seg1);
+    read_entries_curve_segment(seg1);
+    FLAGS_walLargeEntryThreshold = 0;
+    // entries of both layouts can be read in the same segment
+    append_entries_curve_segment(seg1, "HELLO, WORLD: %d", 10, 20);
+    read_entries_curve_segment(seg1, "HELLO, WORLD: %d", 10, 20);
+    ASSERT_EQ(0, seg1->close());
+
+    // the data ends on an aligned boundary, but the length to remap must
+    // be aligned too
+    std::string closed_path = std::string(kRaftLogDataDir) + "/"
+                              + seg1->file_name();
+    int fd = ::open(closed_path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(-1, seg1->remap_data_tail(1, 4, fd, 0));
+    ASSERT_EQ(-1, seg1->remap_data_tail(21, FLAGS_walAlignSize, fd, 0));
+    ::close(fd);
+
+    // load closed segment, read through mmap and pread
+    braft::ConfigurationManager configuration_manager;
+    scoped_refptr<CurveSegment> seg2 =
+                        new CurveSegment(kRaftLogDataDir, 1, 20, 0, file_pool);
+    ASSERT_EQ(0, seg2->load(&configuration_manager));
+    read_entries_curve_segment(seg2);
+    read_entries_curve_segment(seg2, "HELLO, WORLD: %d", 10, 20);
+    FLAGS_raftLogMmapClosedSegment = false;
+    scoped_refptr<CurveSegment> seg3 =
+                        new CurveSegment(kRaftLogDataDir, 1, 20, 0, file_pool);
+    ASSERT_EQ(0, seg3->load(&configuration_manager));
+    read_entries_curve_segment(seg3);
+    read_entries_curve_segment(seg3, "HELLO, WORLD: %d", 10, 20);
+    FLAGS_raftLogMmapClosedSegment = true;
+    ASSERT_EQ(0, seg1->unlink());
+}
+
+TEST_F(CurveSegmentTest, mapped_segment_rewritten) {
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFileImpl(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Return(0));
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1L);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+    append_entries_curve_segment(seg1);
+    ASSERT_EQ(0, seg1->close());
+
+    braft::ConfigurationManager configuration_manager;
+    scoped_refptr<CurveSegment> seg2 =
+                        new CurveSegment(kRaftLogDataDir, 1, 10, 0, file_pool);
+    ASSERT_EQ(0, seg2->load(&configuration_manager));
+    braft::LogEntry* entry = seg2->get(1);
+    ASSERT_NE(nullptr, entry);
+
+    // the entries read through mmap don't change when the file is rewritten
+    std::string closed_path = std::string(kRaftLogDataDir) + "/"
+                              + seg1->file_name();
+    int fd = ::open(closed_path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    struct stat st;
+    ASSERT_EQ(0, ::fstat(fd, &st));
+    std::string zeros(st.st_size - kPageSize, 0);
+    ASSERT_EQ(zeros.size(),
+              ::pwrite(fd, zeros.data(), zeros.size(), kPageSize));
+    ASSERT_EQ("hello, world: 1", entry->data.to_string());
+    entry->Release();
+    ASSERT_EQ(nullptr, seg2->get(2));
+
+    // reading the pages beyond the end of the file raises SIGBUS,
+    // the read fails instead of crashing
+    ASSERT_EQ(0, ::ftruncate(fd, 0));
+    ::close(fd);
+    ASSERT_EQ(nullptr, seg2->get(3));
+    ASSERT_EQ(0, seg1->unlink());
+}
+
+TEST_F(CurveSegmentTest, remap_front_padded_entries) {
+    if (!support_reflink(kRaftLogDataDir)) {
+        GTEST_SKIP() << "FICLONERANGE is not supported by the filesystem";
+    }
+    // the recycled segment is overwritten before being reused
+    auto recycle = [](const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd < 0) {
+            return -1;
+        }
+        std::string zeros(kSegmentSize, '\0');
+        ssize_t ret = ::pwrite(fd, zeros.data(), zeros.size(), 0);
+        ::fsync(fd);
+        ::close(fd);
+        ::unlink(path.c_str());
+        return ret == static_cast<ssize_t>(zeros.size()) ? 0 : -1;
+    };
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFileImpl(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Invoke(recycle));
+    FLAGS_walLargeEntryThreshold = FLAGS_walAlignSize;
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0, file_pool);
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1L);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+
+    // the payloads of the entries are aligned, and cloned into the chunk
+    const int entry_num = 3;
+    std::string chunk_path = std::string(kRaftLogDataDir) + "/chunk_1";
+    int chunk_fd = ::open(chunk_path.c_str(), O_RDWR|O_CREAT, 0644);
+    ASSERT_GE(chunk_fd, 0);
+    ASSERT_EQ(0, ::ftruncate(chunk_fd, entry_num * FLAGS_walAlignSize));
+    std::string expected;
+    for (int i = 0; i < entry_num; i++) {
+        std::string payload(FLAGS_walAlignSize, static_cast<char>('a' + i));
+        braft::LogEntry* entry = new braft::LogEntry();
+        entry->AddRef();
+        entry->type = braft::ENTRY_TYPE_DATA;
+        entry->id.term = 1;
+        entry->id.index = i + 1;
+        entry->data.append(payload);
+        ASSERT_EQ(0, seg1->append(entry));
+        entry->Release();
+        ASSERT_EQ(0, seg1->remap_data_tail(i + 1, FLAGS_walAlignSize,
+                                           chunk_fd, i * FLAGS_walAlignSize));
+        expected.append(payload);
+    }
+    ASSERT_EQ(0, ::fsync(chunk_fd));
+    std::string content(expected.size(), '\0');
+    ASSERT_EQ(static_cast<ssize_t>(expected.size()),
+              ::pread(chunk_fd, &content[0], content.size(), 0));
+    ASSERT_EQ(expected, content);
+    ASSERT_EQ(0, seg1->close());
+    FLAGS_walLargeEntryThreshold = 0;
+
+    // recycling the segment leaves the cloned data in the chunk intact
+    ASSERT_EQ(0, seg1->unlink());
+    content.assign(expected.size(), '\0');
+    ASSERT_EQ(static_cast<ssize_t>(expected.size()),
+              ::pread(chunk_fd, &content[0], content.size(), 0));
+    ASSERT_EQ(expected, content);
+    ::close(chunk_fd);
+}
+
 }  // namespace chunkserver
 }  // namespace curve
@@ -112,6 +112,7 @@ class CurveSegmentLogStorageTest : public testing::Test {
             snprintf(data_buf, sizeof(data_buf),
                         "hello, world: %" PRId64, index);
             ASSERT_EQ(data_buf, entry->data.to_string());
+            entry->Release();
         }
     }
 
@@ -551,6 +552,60 @@ TEST_F(CurveSegmentLogStorageTest, basic_test_without_direct) {
     ASSERT_EQ(countWalSegmentFile(), storage->GetStatus().walSegmentFileCount);
 }
 
+TEST_F(CurveSegmentLogStorageTest, prefetch_segments) {
+    // directory not exist
+    ASSERT_EQ(0, PrefetchSegments(std::string(kRaftLogDataDir) + "/none"));
+
+    auto storage = std::make_shared<CurveSegmentLogStorage>(kRaftLogDataDir,
+            true, file_pool);
+    ASSERT_EQ(0, storage->init(new braft::ConfigurationManager()));
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1L);
+    ASSERT_EQ(0,  prepare_segment(path));
+    append_entries(storage, 300, 5);
+    ::system((std::string("touch ") + kRaftLogDataDir + "/log_1.tmp").c_str());
+
+    // log meta and temporary files are skipped
+    ASSERT_EQ(countWalSegmentFile(), PrefetchSegments(kRaftLogDataDir));
+}
+
+TEST_F(CurveSegmentLogStorageTest, entry_cache) {
+    uint64_t cacheBytes = FLAGS_raftLogEntryCacheBytes;
+    FLAGS_raftLogEntryCacheBytes = 4 * 1024 * 1024;
+    auto storage = std::make_shared<CurveSegmentLogStorage>(kRaftLogDataDir,
+            true, file_pool);
+    ASSERT_EQ(0, storage->init(new braft::ConfigurationManager()));
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1L);
+    ASSERT_EQ(0,  prepare_segment(path));
+    append_entries(storage, 100, 5);
+
+    // recent entries are served from the cache
+    braft::LogEntry* entry1 = storage->get_entry(500);
+    braft::LogEntry* entry2 = storage->get_entry(500);
+    ASSERT_EQ(entry1, entry2);
+    entry1->Release();
+    entry2->Release();
+    read_entries(storage, 0, 500);
+
+    // truncated entries are evicted
+    ASSERT_EQ(0, storage->truncate_suffix(400));
+    ASSERT_EQ(nullptr, storage->get_entry(500));
+    read_entries(storage, 0, 400);
+
+    // cache disabled
+    FLAGS_raftLogEntryCacheBytes = 0;
+    ASSERT_EQ(0, storage->reset(1));
+    ASSERT_EQ(0,  prepare_segment(path));
+    append_entries(storage, 10, 5);
+    entry1 = storage->get_entry(50);
+    entry2 = storage->get_entry(50);
+    ASSERT_NE(entry1, entry2);
+    ASSERT_EQ(entry1->data.to_string(), entry2->data.to_string());
+    entry1->Release();
+    entry2->Release();
+    FLAGS_raftLogEntryCacheBytes = cacheBytes;
+}
 
 }  // namespace chunkserver
 }  // namespace curve
@@ -24,11 +24,20 @@
 #include <glog/logging.h>
 #include <brpc/controller.h>
 #include <brpc/server.h>
+#include <butil/sys_byteorder.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
 #include "src/chunkserver/raftsnapshot/curve_file_service.h"
 #include "src/chunkserver/raftsnapshot/curve_filesystem_adaptor.h"
 #include "test/chunkserver/raftsnapshot/mock_file_reader.h"
 #include "test/chunkserver/raftsnapshot/mock_snapshot_attachment.h"
 
+namespace braft {
+    DECLARE_int32(raft_max_byte_count_per_rpc);
+}
+
 namespace curve {
 namespace chunkserver {
 
@@ -116,6 +125,196 @@ TEST_F(CurveFileServiceTest, success_attach_file) {
     kCurveFileService.set_snapshot_attachment(NULL);
 }
 
+TEST_F(CurveFileServiceTest, success_block_hash_file) {
+    // 准备一个3个半block大小的文件
+    const std::string dir = "./curve_file_service_test_dir";
+    const size_t blockSize = 4096;
+    std::string content(blockSize * 3 + 100, 'a');
+    content[blockSize + 1] = 'b';
+    ASSERT_EQ(0, system(("mkdir -p " + dir).c_str()));
+    int fd = ::open((dir + "/chunk_1").c_str(), O_CREAT | O_TRUNC | O_RDWR,
+                    0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(content.size(),
+              (size_t)::write(fd, content.data(), content.size()));
+    ::close(fd);
+
+    scoped_refptr<CurveSnapshotFileReader> reader(
+        new CurveSnapshotFileReader(new braft::PosixFileSystemAdaptor(),
+                                    dir, nullptr));
+    braft::LocalSnapshotMetaTable metaTable;
+    braft::LocalFileMeta fileMeta;
+    metaTable.add_file("chunk_1", fileMeta);
+    reader->set_meta_table(metaTable);
+    int64_t reader_id;
+    ASSERT_EQ(0, kCurveFileService.add_reader(reader, &reader_id));
+
+    brpc::Channel channel;
+    brpc::Controller cntl;
+    ASSERT_EQ(channel.Init(serverAddr, nullptr), 0);
+    braft::FileService_Stub stub(&channel);
+    braft::GetFileRequest request;
+    request.set_reader_id(reader_id);
+    request.set_filename(std::string("chunk_1") + RAFT_SNAP_BLOCK_HASH_SUFFIX);
+    request.set_count(blockSize);
+    request.set_offset(blockSize);
+    braft::GetFileResponse response;
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+    ASSERT_TRUE(response.eof());
+    ASSERT_EQ(content.size() - blockSize, response.read_size());
+
+    braft::FileSegData seg(cntl.response_attachment());
+    uint64_t offset = 0;
+    butil::IOBuf data;
+    ASSERT_EQ(3 * kBlockHashSize, seg.next(&offset, &data));
+    for (size_t i = 1; i < 4; ++i) {
+        std::string hash(kBlockHashSize, '\0');
+        data.cutn(&hash[0], kBlockHashSize);
+        butil::IOBuf block;
+        block.append(content.substr(i * blockSize, blockSize));
+        ASSERT_EQ(block_hash(block), hash);
+    }
+
+    // block大小非法
+    const size_t maxBlockSize = braft::FLAGS_raft_max_byte_count_per_rpc;
+    for (size_t count : {blockSize - 1, maxBlockSize + 1}) {
+        cntl.Reset();
+        request.set_count(count);
+        request.set_offset(0);
+        stub.get_file(&cntl, &request, &response, nullptr);
+        ASSERT_TRUE(cntl.Failed());
+        ASSERT_EQ(EINVAL, cntl.ErrorCode());
+    }
+
+    // 起始位置没有按block对齐
+    cntl.Reset();
+    request.set_count(blockSize);
+    request.set_offset(100);
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_TRUE(cntl.Failed());
+    ASSERT_EQ(EINVAL, cntl.ErrorCode());
+
+    // 不在快照中的文件
+    cntl.Reset();
+    request.set_filename(std::string("chunk_2") + RAFT_SNAP_BLOCK_HASH_SUFFIX);
+    request.set_offset(0);
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_TRUE(cntl.Failed());
+    ASSERT_EQ(EPERM, cntl.ErrorCode());
+
+    kCurveFileService.remove_reader(reader_id);
+    ASSERT_EQ(0, system(("rm -rf " + dir).c_str()));
+}
+
+TEST_F(CurveFileServiceTest, block_hash_file_throttled) {
+    const std::string dir = "./curve_file_service_test_dir";
+    const size_t blockSize = 4096;
+    std::string content(blockSize * 4, 'a');
+    ASSERT_EQ(0, system(("mkdir -p " + dir).c_str()));
+    int fd = ::open((dir + "/chunk_1").c_str(), O_CREAT | O_TRUNC | O_RDWR,
+                    0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(content.size(),
+              (size_t)::write(fd, content.data(), content.size()));
+    ::close(fd);
+
+    // 限流只允许读取1个block
+    scoped_refptr<CurveSnapshotFileReader> reader(
+        new CurveSnapshotFileReader(new braft::PosixFileSystemAdaptor(), dir,
+            new braft::ThroughputSnapshotThrottle(blockSize, 1)));
+    braft::LocalSnapshotMetaTable metaTable;
+    braft::LocalFileMeta fileMeta;
+    metaTable.add_file("chunk_1", fileMeta);
+    reader->set_meta_table(metaTable);
+    int64_t reader_id;
+    ASSERT_EQ(0, kCurveFileService.add_reader(reader, &reader_id));
+
+    brpc::Channel channel;
+    brpc::Controller cntl;
+    ASSERT_EQ(channel.Init(serverAddr, nullptr), 0);
+    braft::FileService_Stub stub(&channel);
+    braft::GetFileRequest request;
+    request.set_reader_id(reader_id);
+    request.set_filename(std::string("chunk_1") + RAFT_SNAP_BLOCK_HASH_SUFFIX);
+    request.set_count(blockSize);
+    request.set_offset(0);
+    braft::GetFileResponse response;
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+    ASSERT_FALSE(response.eof());
+    ASSERT_EQ(blockSize, response.read_size());
+
+    // 限流额度用完后返回EAGAIN
+    cntl.Reset();
+    request.set_offset(blockSize);
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_TRUE(cntl.Failed());
+    ASSERT_EQ(EAGAIN, cntl.ErrorCode());
+
+    kCurveFileService.remove_reader(reader_id);
+    ASSERT_EQ(0, system(("rm -rf " + dir).c_str()));
+}
+
+TEST_F(CurveFileServiceTest, success_sparse_file) {
+    // 准备一个2MB的文件，只有两个4KB的数据区间
+    const std::string dir = "./curve_file_service_test_dir";
+    const size_t fileSize = 2 * 1024 * 1024;
+    const off_t dataOffset = 1024 * 1024;
+    std::string data(4096, 'a');
+    ASSERT_EQ(0, system(("mkdir -p " + dir).c_str()));
+    int fd = ::open((dir + "/chunk_1").c_str(), O_CREAT | O_TRUNC | O_RDWR,
+                    0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(data.size(), (size_t)::pwrite(fd, data.data(), data.size(), 0));
+    ASSERT_EQ(data.size(),
+              (size_t)::pwrite(fd, data.data(), data.size(), dataOffset));
+    ASSERT_EQ(0, ::ftruncate(fd, fileSize));
+    ::close(fd);
+
+    scoped_refptr<CurveSnapshotFileReader> reader(
+        new CurveSnapshotFileReader(new braft::PosixFileSystemAdaptor(),
+                                    dir, nullptr));
+    braft::LocalSnapshotMetaTable metaTable;
+    braft::LocalFileMeta fileMeta;
+    metaTable.add_file("chunk_1", fileMeta);
+    reader->set_meta_table(metaTable);
+    int64_t reader_id;
+    ASSERT_EQ(0, kCurveFileService.add_reader(reader, &reader_id));
+
+    brpc::Channel channel;
+    brpc::Controller cntl;
+    ASSERT_EQ(channel.Init(serverAddr, nullptr), 0);
+    braft::FileService_Stub stub(&channel);
+    braft::GetFileRequest request;
+    request.set_reader_id(reader_id);
+    request.set_filename("chunk_1");
+    request.set_count(fileSize);
+    request.set_offset(0);
+    braft::GetFileResponse response;
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+    ASSERT_TRUE(response.eof());
+    ASSERT_EQ(fileSize, response.read_size());
+
+    // 空洞不会被传输
+    braft::FileSegData seg(cntl.response_attachment());
+    uint64_t offset = 0;
+    butil::IOBuf segData;
+    size_t total = 0;
+    while (seg.next(&offset, &segData) != 0) {
+        ASSERT_TRUE(offset < data.size() ||
+                    (offset >= dataOffset &&
+                     offset < dataOffset + data.size()));
+        total += segData.size();
+        segData.clear();
+    }
+    ASSERT_EQ(2 * data.size(), total);
+
+    kCurveFileService.remove_reader(reader_id);
+    ASSERT_EQ(0, system(("rm -rf " + dir).c_str()));
+}
+
 TEST_F(CurveFileServiceTest, error_reader_not_found) {
     brpc::Channel channel;
     brpc::Controller cntl;
@@ -0,0 +1,374 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-05
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <brpc/server.h>
+#include <bthread/bthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "src/chunkserver/raftsnapshot/curve_file_service.h"
+#include "src/chunkserver/raftsnapshot/curve_snapshot_copier.h"
+#include "src/chunkserver/raftsnapshot/curve_snapshot_file_reader.h"
+#include "src/chunkserver/raftsnapshot/curve_snapshot_writer.h"
+
+namespace braft {
+    DECLARE_int32(raft_max_byte_count_per_rpc);
+}
+
+namespace curve {
+namespace chunkserver {
+
+const char copierServerAddr[] = "127.0.0.1:9502";
+const char kTestDir[] = "./curve_snapshot_copier_test_dir";
+// 快照中记录的chunk文件路径是相对于快照目录的
+const char kChunkFile[] = "../../data/chunk_1";
+const size_t kBlockSize = 4096;
+
+// 记录同时计算block hash的请求数，用于检查增量下载是否并发
+class CountingFileReader : public CurveSnapshotFileReader {
+ public:
+    CountingFileReader(braft::FileSystemAdaptor* fs, const std::string& path)
+        : CurveSnapshotFileReader(fs, path, nullptr) {}
+
+    int read_block_hash(butil::IOBuf* out, const std::string& filename,
+                        off_t offset, size_t block_size, size_t* read_count,
+                        bool* is_eof) const override {
+        int inflight = ++inflight_;
+        int maxInflight = maxInflight_.load();
+        while (inflight > maxInflight &&
+               !maxInflight_.compare_exchange_weak(maxInflight, inflight)) {
+        }
+        bthread_usleep(delayUs_);
+        int ret = CurveSnapshotFileReader::read_block_hash(
+            out, filename, offset, block_size, read_count, is_eof);
+        --inflight_;
+        return ret;
+    }
+
+    void SetDelay(uint64_t delayUs) { delayUs_ = delayUs; }
+    int MaxInflight() const { return maxInflight_.load(); }
+
+ private:
+    uint64_t delayUs_ = 0;
+    mutable std::atomic<int> inflight_{0};
+    mutable std::atomic<int> maxInflight_{0};
+};
+
+class CurveSnapshotCopierTest : public testing::Test {
+ protected:
+    static void SetUpTestCase() {
+        ASSERT_EQ(0, server_.AddService(&kCurveFileService,
+                                        brpc::SERVER_DOESNT_OWN_SERVICE));
+        ASSERT_EQ(0, server_.Start(copierServerAddr, nullptr));
+    }
+    static void TearDownTestCase() {
+        server_.Stop(0);
+        server_.Join();
+    }
+
+    void SetUp() {
+        oldBlockSize_ = FLAGS_raftSnapshotDeltaBlockSize;
+        oldConcurrency_ = FLAGS_raftSnapshotCopyConcurrency;
+        oldMaxBytePerRpc_ = braft::FLAGS_raft_max_byte_count_per_rpc;
+        FLAGS_raftSnapshotDeltaBlockSize = kBlockSize;
+
+        // 远端的快照目录为remote/snapshot/s1，本地下载到
+        // local/snapshot/temp，chunk文件都在data目录下
+        const std::string dir = kTestDir;
+        remoteSnapDir_ = dir + "/remote/snapshot/s1";
+        localSnapDir_ = dir + "/local/snapshot/temp";
+        remoteChunk_ = dir + "/remote/data/chunk_1";
+        localChunk_ = dir + "/local/data/chunk_1";
+        destChunk_ = localSnapDir_ + "/data/chunk_1";
+        ASSERT_EQ(0, system(("mkdir -p " + remoteSnapDir_ + " " +
+                             dir + "/remote/data " + dir + "/local/data")
+                            .c_str()));
+
+        fs_ = new braft::PosixFileSystemAdaptor();
+        reader_ = new CountingFileReader(fs_.get(), remoteSnapDir_);
+        braft::LocalSnapshotMetaTable metaTable;
+        braft::LocalFileMeta fileMeta;
+        metaTable.add_file(kChunkFile, fileMeta);
+        reader_->set_meta_table(metaTable);
+        ASSERT_EQ(0, kCurveFileService.add_reader(reader_, &readerId_));
+
+        writer_ = new CurveSnapshotWriter(localSnapDir_, fs_.get());
+        ASSERT_EQ(0, writer_->init());
+        // 下载的chunk文件放在快照目录的data目录下
+        ASSERT_EQ(0, system(("mkdir -p " + localSnapDir_ + "/data").c_str()));
+        copier_ = new CurveSnapshotCopier(nullptr, false, fs_.get(),
+                                          nullptr);
+        ASSERT_EQ(0, copier_->init("remote://" +
+                                   std::string(copierServerAddr) + "/" +
+                                   std::to_string(readerId_)));
+        copier_->_writer = writer_;
+    }
+
+    void TearDown() {
+        copier_->_writer = nullptr;
+        delete copier_;
+        delete writer_;
+        kCurveFileService.remove_reader(readerId_);
+        reader_ = nullptr;
+        FLAGS_raftSnapshotDeltaBlockSize = oldBlockSize_;
+        FLAGS_raftSnapshotCopyConcurrency = oldConcurrency_;
+        braft::FLAGS_raft_max_byte_count_per_rpc = oldMaxBytePerRpc_;
+        ASSERT_EQ(0, system((std::string("rm -rf ") + kTestDir).c_str()));
+    }
+
+    int CopyFileDelta(const std::string& filename,
+                      const std::string& filePath) {
+        return copier_->copy_file_delta(filename, filePath);
+    }
+
+    int CopyBlocksDelta(braft::FileAdaptor* local, braft::FileAdaptor* dest,
+                        uint64_t fileSize,
+                        const std::vector<std::string>& remoteHashes) {
+        return copier_->copy_blocks_delta(kChunkFile, local, dest, fileSize,
+                                          remoteHashes);
+    }
+
+    int GetRemoteBlockHash(uint64_t* fileSize,
+                           std::vector<std::string>* hashes) {
+        return copier_->get_remote_block_hash(kChunkFile, fileSize, hashes);
+    }
+
+    int CopyRemoteRange(off_t offset, size_t count,
+                        braft::FileAdaptor* dest) {
+        return copier_->copy_remote_range(kChunkFile, offset, count, dest);
+    }
+
+    void CopyFiles(const std::vector<std::string>& files) {
+        copier_->load_meta_table();
+        ASSERT_TRUE(copier_->ok());
+        copier_->copy_files(files);
+    }
+
+    bool CopierOk() {
+        return copier_->ok();
+    }
+
+    braft::FileAdaptor* OpenFile(const std::string& path, int flags) {
+        butil::File::Error e;
+        return fs_->open(path, flags | O_CLOEXEC, nullptr, &e);
+    }
+
+    void CloseFile(braft::FileAdaptor* file) {
+        ASSERT_TRUE(file->close());
+        delete file;
+    }
+
+    static void WriteFile(const std::string& path,
+                          const std::string& content) {
+        int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(content.size(),
+                  (size_t)::write(fd, content.data(), content.size()));
+        ::close(fd);
+    }
+
+    static std::string ReadFile(const std::string& path) {
+        std::string content;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return content;
+        }
+        char buf[4096];
+        ssize_t n = 0;
+        while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+            content.append(buf, n);
+        }
+        ::close(fd);
+        return content;
+    }
+
+    // 每个block的内容不同，便于检查数据是否拷贝到正确的位置
+    static std::string MakeContent(size_t size, char base) {
+        std::string content(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            content[i] = base + (i / kBlockSize) % 16;
+        }
+        return content;
+    }
+
+    static brpc::Server server_;
+    uint32_t oldBlockSize_;
+    uint32_t oldConcurrency_;
+    int32_t oldMaxBytePerRpc_;
+    std::string remoteSnapDir_;
+    std::string localSnapDir_;
+    std::string remoteChunk_;
+    std::string localChunk_;
+    std::string destChunk_;
+    scoped_refptr<braft::FileSystemAdaptor> fs_;
+    scoped_refptr<CountingFileReader> reader_;
+    int64_t readerId_;
+    CurveSnapshotWriter* writer_;
+    CurveSnapshotCopier* copier_;
+};
+
+brpc::Server CurveSnapshotCopierTest::server_;
+
+TEST_F(CurveSnapshotCopierTest, copy_remote_range) {
+    // 每次rpc只读一个block，需要多次rpc才能读完
+    braft::FLAGS_raft_max_byte_count_per_rpc = kBlockSize;
+    std::string remote = MakeContent(kBlockSize * 3 + 100, 'a');
+    WriteFile(remoteChunk_, remote);
+
+    braft::FileAdaptor* dest = OpenFile(destChunk_, O_CREAT | O_RDWR);
+    ASSERT_NE(nullptr, dest);
+    ASSERT_EQ(0, CopyRemoteRange(kBlockSize, kBlockSize * 2 + 100, dest));
+    CloseFile(dest);
+
+    // 只写入了指定的范围
+    std::string copied = ReadFile(destChunk_);
+    ASSERT_EQ(remote.size(), copied.size());
+    ASSERT_EQ(std::string(kBlockSize, '\0'), copied.substr(0, kBlockSize));
+    ASSERT_EQ(remote.substr(kBlockSize), copied.substr(kBlockSize));
+}
+
+TEST_F(CurveSnapshotCopierTest, get_remote_block_hash) {
+    // 一次rpc最多返回128个hash，需要分两次获取
+    braft::FLAGS_raft_max_byte_count_per_rpc = kBlockSize;
+    const size_t blockNum = 200;
+    std::string remote = MakeContent(kBlockSize * blockNum + 100, 'a');
+    WriteFile(remoteChunk_, remote);
+
+    uint64_t fileSize = 0;
+    std::vector<std::string> hashes;
+    ASSERT_EQ(0, GetRemoteBlockHash(&fileSize, &hashes));
+    ASSERT_EQ(remote.size(), fileSize);
+    ASSERT_EQ(blockNum + 1, hashes.size());
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        butil::IOBuf block;
+        block.append(remote.substr(i * kBlockSize, kBlockSize));
+        ASSERT_EQ(block_hash(block), hashes[i]);
+    }
+}
+
+TEST_F(CurveSnapshotCopierTest, copy_blocks_delta) {
+    // 远端修改了第二个block，并且比本地多了一个半block
+    std::string local = MakeContent(kBlockSize * 2, 'a');
+    std::string remote = MakeContent(kBlockSize * 3 + 100, 'a');
+    remote.replace(kBlockSize, 10, "0123456789");
+    WriteFile(localChunk_, local);
+    WriteFile(remoteChunk_, remote);
+
+    uint64_t fileSize = 0;
+    std::vector<std::string> hashes;
+    ASSERT_EQ(0, GetRemoteBlockHash(&fileSize, &hashes));
+    ASSERT_EQ(4, hashes.size());
+
+    // 获取hash之后再修改远端的第一个block，
+    // 如果第一个block从本地拷贝，就不会读到修改后的数据
+    std::string modified = remote;
+    modified.replace(0, 10, "abcdefghij");
+    WriteFile(remoteChunk_, modified);
+
+    braft::FileAdaptor* localFile = OpenFile(localChunk_, O_RDONLY);
+    ASSERT_NE(nullptr, localFile);
+    braft::FileAdaptor* dest = OpenFile(destChunk_, O_CREAT | O_RDWR);
+    ASSERT_NE(nullptr, dest);
+    ASSERT_EQ(0, CopyBlocksDelta(localFile, dest, fileSize, hashes));
+    CloseFile(localFile);
+    CloseFile(dest);
+
+    ASSERT_EQ(remote, ReadFile(destChunk_));
+}
+
+TEST_F(CurveSnapshotCopierTest, copy_file_delta) {
+    std::string local = MakeContent(kBlockSize * 4, 'a');
+    std::string remote = local;
+    remote.replace(kBlockSize * 2, 10, "0123456789");
+    remote.resize(kBlockSize * 3 + 100);
+    WriteFile(remoteChunk_, remote);
+
+    // 本地没有旧版本的文件，需要完整下载
+    ASSERT_EQ(-1, CopyFileDelta(kChunkFile, destChunk_));
+    ASSERT_TRUE(CopierOk());
+
+    WriteFile(localChunk_, local);
+    ASSERT_EQ(0, CopyFileDelta(kChunkFile, destChunk_));
+    ASSERT_TRUE(CopierOk());
+    ASSERT_EQ(remote, ReadFile(destChunk_));
+
+    // 远端快照中没有这个文件
+    WriteFile(std::string(kTestDir) + "/local/data/chunk_2", local);
+    ASSERT_EQ(-1, CopyFileDelta("../../data/chunk_2",
+                                localSnapDir_ + "/data/chunk_2"));
+    ASSERT_TRUE(CopierOk());
+
+    // block大小非法时不做增量下载
+    FLAGS_raftSnapshotDeltaBlockSize = kBlockSize - 1;
+    ASSERT_EQ(-1, CopyFileDelta(kChunkFile, destChunk_));
+    FLAGS_raftSnapshotDeltaBlockSize = 0;
+    ASSERT_EQ(-1, CopyFileDelta(kChunkFile, destChunk_));
+    ASSERT_TRUE(CopierOk());
+}
+
+TEST_F(CurveSnapshotCopierTest, copy_files_concurrently) {
+    FLAGS_raftSnapshotCopyConcurrency = 4;
+    reader_->SetDelay(100 * 1000);
+
+    // chunk_1到chunk_4在本地有旧版本，增量下载，chunk_5完整下载
+    const int fileNum = 5;
+    std::vector<std::string> files;
+    std::vector<std::string> contents;
+    braft::LocalSnapshotMetaTable metaTable;
+    braft::SnapshotMeta meta;
+    meta.set_last_included_index(100);
+    meta.set_last_included_term(1);
+    metaTable.set_meta(meta);
+    const std::string dir = kTestDir;
+    for (int i = 1; i <= fileNum; ++i) {
+        std::string name = "chunk_" + std::to_string(i);
+        std::string local = MakeContent(kBlockSize * 4, 'a' + i);
+        std::string remote = local;
+        remote.replace(kBlockSize * (i % 4), 10, "0123456789");
+        WriteFile(dir + "/remote/data/" + name, remote);
+        if (i < fileNum) {
+            WriteFile(dir + "/local/data/" + name, local);
+        }
+        files.push_back("../../data/" + name);
+        contents.push_back(remote);
+        braft::LocalFileMeta fileMeta;
+        metaTable.add_file(files.back(), fileMeta);
+    }
+    reader_->set_meta_table(metaTable);
+
+    CopyFiles(files);
+    ASSERT_TRUE(CopierOk());
+    for (int i = 0; i < fileNum; ++i) {
+        ASSERT_EQ(contents[i], ReadFile(localSnapDir_ + "/data/chunk_" +
+                                        std::to_string(i + 1)));
+        ASSERT_EQ(0, writer_->get_file_meta(files[i], nullptr));
+    }
+    // 增量下载之间是并发的
+    ASSERT_LE(2, reader_->MaxInflight());
+    ASSERT_GE(4, reader_->MaxInflight());
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -47,6 +47,7 @@ using ::testing::ReturnPointee;
 using ::testing::SetArgPointee;
 using ::testing::Mock;
 using ::testing::Invoke;
+using ::testing::InSequence;
 using curve::fs::LocalFsFactory;
 using ::curve::fs::FileSystemType;
 using ::google::protobuf::util::MessageDifferencer;
@@ -71,7 +72,7 @@ class ScanManagerTest : public ::testing::Test {
                             CreateFs(FileSystemType::EXT4, "");
         ChunkOptions options;
         options.baseDir = "/";
-        csChunkFile_ = new CSChunkFile(lfs, nullptr, options);
+        csChunkFile_ = std::make_shared<CSChunkFile>(lfs, nullptr, options);
         ChunkFileMetaPage metaPage;
         metaPage.version = 2;
         csChunkFile_->SetChunkFileMetaPage(metaPage);
@@ -86,7 +87,7 @@ class ScanManagerTest : public ::testing::Test {
     ScanManagerOptions  defaultOptions_;
     ChunkFileMetaPage metaPage;
     MockCopysetNodeManager *copysetNodeManager_;
-    CSChunkFile *csChunkFile_;
+    CSChunkFilePtr csChunkFile_;
     std::shared_ptr<MockCopysetNode> copysetNode_;
     std::shared_ptr<MockDataStore> dataStore_;
     ScanManager *scanManager_;
@@ -107,9 +108,6 @@ TEST_F(ScanManagerTest, EnqueueTest) {
 TEST_F(ScanManagerTest, ScanJobTest) {
     scanManager_->Enqueue(1, 10000);
     ASSERT_EQ(1, scanManager_->GetWaitJobNum());
-    ChunkMap chunkMap;
-    chunkMap.emplace(1, csChunkFile_);
-
     std::vector<ScanMap> failedMap;
     std::vector<Peer> peers;
     peers.push_back(Peer());
@@ -125,8 +123,10 @@ TEST_F(ScanManagerTest, ScanJobTest) {
                 .Times(1).WillOnce(ReturnRef(failedMap));
     EXPECT_CALL(*copysetNode_, SetScan(_)).Times(2);
     EXPECT_CALL(*copysetNode_, SetLastScan(_)).Times(1);
-    EXPECT_CALL(*dataStore_, GetChunkMap())
-                .Times(1).WillOnce(Return(chunkMap));
+    EXPECT_CALL(*dataStore_, GetChunkIds())
+                .Times(1).WillOnce(Return(std::vector<ChunkID>{1}));
+    EXPECT_CALL(*dataStore_, LoadChunk(1))
+                .Times(1).WillOnce(Return(csChunkFile_));
     EXPECT_CALL(*copysetNode_, ListPeers(_)).Times(1)
                 .WillOnce(SetArgPointee<0>(peers));
     EXPECT_CALL(*copysetNode_, IsLeaderTerm())
@@ -141,30 +141,75 @@ TEST_F(ScanManagerTest, ScanJobTest) {
     scanManager_->Fini();
 }
 
+TEST_F(ScanManagerTest, ScanUnloadedChunksTest) {
+    // with lazy loading enabled, the chunks not loaded yet are listed too,
+    // and each chunk is loaded when its scan starts
+    scanManager_->Enqueue(1, 10000);
+    ASSERT_EQ(1, scanManager_->GetWaitJobNum());
+    std::shared_ptr<LocalFileSystem> lfs = LocalFsFactory::
+                                           CreateFs(FileSystemType::EXT4, "");
+    ChunkOptions chunkOptions;
+    chunkOptions.baseDir = "/";
+    auto unloadedChunk = std::make_shared<CSChunkFile>(lfs, nullptr,
+                                                       chunkOptions);
+    ChunkFileMetaPage v2MetaPage;
+    v2MetaPage.version = 2;
+    unloadedChunk->SetChunkFileMetaPage(v2MetaPage);
+
+    std::vector<ScanMap> failedMap;
+    std::vector<Peer> peers(3);
+    dataStore_ = std::make_shared<MockDataStore>();
+    copysetNode_ = std::make_shared<MockCopysetNode>();
+    EXPECT_CALL(*copysetNodeManager_, GetCopysetNode(_, _))
+                .WillRepeatedly(Return(copysetNode_));
+    EXPECT_CALL(*copysetNode_, GetDataStore())
+                .WillRepeatedly(Return(dataStore_));
+    EXPECT_CALL(*copysetNode_, GetFailedScanMap())
+                .WillRepeatedly(ReturnRef(failedMap));
+    EXPECT_CALL(*copysetNode_, SetScan(_)).Times(2);
+    EXPECT_CALL(*copysetNode_, SetLastScan(_)).Times(1);
+    EXPECT_CALL(*copysetNode_, ListPeers(_)).Times(1)
+                .WillOnce(SetArgPointee<0>(peers));
+    EXPECT_CALL(*copysetNode_, IsLeaderTerm())
+                .WillRepeatedly(Return(true));
+    EXPECT_CALL(*dataStore_, GetChunkIds())
+                .Times(1).WillOnce(Return(std::vector<ChunkID>{1, 2, 3}));
+    {
+        InSequence seq;
+        EXPECT_CALL(*dataStore_, LoadChunk(1))
+                    .Times(1).WillOnce(Return(csChunkFile_));
+        EXPECT_CALL(*copysetNode_, Propose(_)).Times(5)
+                    .WillRepeatedly(Invoke([](const braft::Task& task){
+                    task.done->Run();
+                }));
+        // chunk 2 is loaded after chunk 1 is scanned
+        EXPECT_CALL(*dataStore_, LoadChunk(2))
+                    .Times(1).WillOnce(Return(unloadedChunk));
+        EXPECT_CALL(*copysetNode_, Propose(_)).Times(5)
+                    .WillRepeatedly(Invoke([](const braft::Task& task){
+                    task.done->Run();
+                }));
+        // chunk 3 is deleted after listed, and skipped
+        EXPECT_CALL(*dataStore_, LoadChunk(3))
+                    .Times(1).WillOnce(Return(nullptr));
+    }
+
+    ASSERT_EQ(0, scanManager_->Run());
+    std::this_thread::sleep_for(std::chrono::seconds(3));
+    scanManager_->Fini();
+}
+
 TEST_F(ScanManagerTest, CompareMapSuccessTest) {
     // make key
     ScanKey key(1, 10000);
 
-    // make chunkmap
-    std::shared_ptr<LocalFileSystem> lfs = LocalFsFactory::
-                                           CreateFs(FileSystemType::EXT4, "");
-    ChunkOptions options;
-    options.baseDir = "/";
-    CSChunkFile *v1Chunk = new CSChunkFile(lfs, nullptr, options);
-    ChunkFileMetaPage metaPage1;
-    metaPage1.version = 1;
-    v1Chunk->SetChunkFileMetaPage(metaPage1);
-    ChunkMap chunkMap;
-    chunkMap.emplace(1, csChunkFile_);
-    chunkMap.emplace(2, v1Chunk);
-
     // make scan job
     std::shared_ptr<ScanJob> job = std::make_shared<ScanJob>();
 
     job->poolId = 1;
     job->id = 10000;
     job->type = ScanType::NewMap;
-    job->chunkMap = chunkMap;
+    job->chunkIds = {1};
     job->task.chunkId = 1;
     job->task.offset = 12582912;
     job->task.len = 4194304;
@@ -211,16 +256,12 @@ TEST_F(ScanManagerTest, CompareMapFailTest) {
     // make key
     ScanKey key(1, 10000);
 
-    // make chunkmap
-    ChunkMap chunkMap;
-    chunkMap.emplace(1, csChunkFile_);
-
     // make scan job
     std::shared_ptr<ScanJob> job = std::make_shared<ScanJob>();
     job->poolId = 1;
     job->id = 10000;
     job->type = ScanType::NewMap;
-    job->chunkMap = chunkMap;
+    job->chunkIds = {1};
     job->task.chunkId = 1;
     job->task.offset = 12582912;
     job->task.len = 4194304;
@@ -313,16 +354,12 @@ TEST_F(ScanManagerTest, MismatchedCRCTest) {
     // make key
     ScanKey key(1, 10000);
 
-    // make chunkmap
-    ChunkMap chunkMap;
-    chunkMap.emplace(1, csChunkFile_);
-
     // make scan job
     std::shared_ptr<ScanJob> job = std::make_shared<ScanJob>();
     job->poolId = 1;
     job->id = 10000;
     job->type = ScanType::NewMap;
-    job->chunkMap = chunkMap;
+    job->chunkIds = {1};
     job->task.chunkId = 1;
     job->task.offset = 12582912;
     job->task.len = 4194304;
@@ -415,9 +452,6 @@ TEST_F(ScanManagerTest, CancelScanJobTest) {
 TEST_F(ScanManagerTest, CancelScanJobAfterTransferLeaderTest) {
     scanManager_->Enqueue(1, 10000);
     ASSERT_EQ(1, scanManager_->GetWaitJobNum());
-    ChunkMap chunkMap;
-    chunkMap.emplace(1, csChunkFile_);
-
     std::vector<ScanMap> failedMap;
     std::vector<Peer> peers;
     peers.push_back(Peer());
@@ -432,8 +466,10 @@ TEST_F(ScanManagerTest, CancelScanJobAfterTransferLeaderTest) {
     EXPECT_CALL(*copysetNode_, GetFailedScanMap())
                 .Times(2).WillRepeatedly(ReturnRef(failedMap));
     EXPECT_CALL(*copysetNode_, SetScan(_)).Times(2);
-    EXPECT_CALL(*dataStore_, GetChunkMap())
-                .Times(1).WillOnce(Return(chunkMap));
+    EXPECT_CALL(*dataStore_, GetChunkIds())
+                .Times(1).WillOnce(Return(std::vector<ChunkID>{1}));
+    EXPECT_CALL(*dataStore_, LoadChunk(1))
+                .Times(1).WillOnce(Return(csChunkFile_));
     EXPECT_CALL(*copysetNode_, ListPeers(_)).Times(1)
                 .WillOnce(SetArgPointee<0>(peers));
     EXPECT_CALL(*copysetNode_, IsLeaderTerm())
@@ -449,5 +485,117 @@ TEST_F(ScanManagerTest, CancelScanJobAfterTransferLeaderTest) {
     scanManager_->Fini();
 }
 
+TEST_F(ScanManagerTest, ScanCheckpointTest) {
+    std::string dir = "./scan_checkpoint_test";
+    std::string path = dir + "/scan_checkpoint";
+    ::system(("rm -rf " + dir + " && mkdir -p " + dir).c_str());
+
+    uint64_t startSec = 1;
+    ChunkID chunkId = 1;
+    // no local filesystem
+    ASSERT_NE(0, scanManager_->SaveScanCheckpoint(path, 1000, 100));
+    ASSERT_NE(0, scanManager_->LoadScanCheckpoint(path, &startSec, &chunkId));
+    ASSERT_EQ(0, startSec);
+    ASSERT_EQ(0, chunkId);
+
+    ScanManager scanManager;
+    ScanManagerOptions scanOptions = defaultOptions_;
+    scanOptions.localFileSystem =
+        LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
+    scanOptions.checkpointExpireSec = 100;
+    EXPECT_CALL(*copysetNodeManager_, GetCopysetNodeOptions())
+                .Times(1).WillOnce(ReturnRef(options));
+    ASSERT_EQ(0, scanManager.Init(scanOptions));
+
+    // no checkpoint
+    startSec = 1;
+    chunkId = 1;
+    ASSERT_EQ(0, scanManager.LoadScanCheckpoint(path, &startSec, &chunkId));
+    ASSERT_EQ(0, startSec);
+    ASSERT_EQ(0, chunkId);
+
+    ASSERT_EQ(0, scanManager.SaveScanCheckpoint(path, 1000, 100));
+    ASSERT_EQ(0, scanManager.LoadScanCheckpoint(path, &startSec, &chunkId));
+    ASSERT_EQ(1000, startSec);
+    ASSERT_EQ(100, chunkId);
+    ASSERT_EQ(0, scanManager.SaveScanCheckpoint(path, 1000, 25));
+    ASSERT_EQ(0, scanManager.LoadScanCheckpoint(path, &startSec, &chunkId));
+    ASSERT_EQ(1000, startSec);
+    ASSERT_EQ(25, chunkId);
+
+    // invalid checkpoint, e.g. saved without the start time
+    ::system(("echo 25 > " + path).c_str());
+    ASSERT_NE(0, scanManager.LoadScanCheckpoint(path, &startSec, &chunkId));
+    ASSERT_EQ(0, startSec);
+    ASSERT_EQ(0, chunkId);
+
+    ::system(("rm -rf " + dir).c_str());
+}
+
+TEST_F(ScanManagerTest, StaleScanCheckpointTest) {
+    std::string dir = "./scan_checkpoint_test";
+    std::string path = dir + "/scan_checkpoint";
+    ::system(("rm -rf " + dir + " && mkdir -p " + dir).c_str());
+    auto lfs = LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
+
+    ScanManager scanManager;
+    ScanManagerOptions scanOptions = defaultOptions_;
+    scanOptions.localFileSystem = lfs;
+    scanOptions.checkpointExpireSec = 100;
+    EXPECT_CALL(*copysetNodeManager_, GetCopysetNodeOptions())
+                .Times(1).WillOnce(ReturnRef(options));
+    ASSERT_EQ(0, scanManager.Init(scanOptions));
+
+    // no checkpoint, start over
+    uint64_t startSec = 1050;
+    ASSERT_EQ(0, scanManager.ResumeScanCheckpoint(path, 0, &startSec));
+    ASSERT_EQ(1050, startSec);
+
+    // resume the scan started before restart
+    ASSERT_EQ(0, scanManager.SaveScanCheckpoint(path, 1000, 25));
+    ASSERT_EQ(25, scanManager.ResumeScanCheckpoint(path, 0, &startSec));
+    ASSERT_EQ(1000, startSec);
+
+    // a scan finished after the checkpoint was saved
+    startSec = 1050;
+    ASSERT_EQ(0, scanManager.ResumeScanCheckpoint(path, 1020, &startSec));
+    ASSERT_EQ(1050, startSec);
+    ASSERT_FALSE(lfs->FileExists(path));
+
+    // the checkpoint expires
+    ASSERT_EQ(0, scanManager.SaveScanCheckpoint(path, 1000, 25));
+    startSec = 1100;
+    ASSERT_EQ(0, scanManager.ResumeScanCheckpoint(path, 0, &startSec));
+    ASSERT_EQ(1100, startSec);
+    ASSERT_FALSE(lfs->FileExists(path));
+
+    // invalid checkpoint
+    ::system(("echo 25 > " + path).c_str());
+    ASSERT_EQ(0, scanManager.ResumeScanCheckpoint(path, 0, &startSec));
+    ASSERT_FALSE(lfs->FileExists(path));
+
+    // the checkpoint is removed when the job is cancelled, e.g. on leader
+    // change, the next scan may start on another leader
+    ASSERT_EQ(0, scanManager.SaveScanCheckpoint(path, 1000, 25));
+    ScanKey key(1, 10000);
+    auto job = std::make_shared<ScanJob>();
+    job->poolId = 1;
+    job->id = 10000;
+    job->checkpointPath = path;
+    scanManager.SetJob(key, job);
+    std::vector<ScanMap> failedMap;
+    copysetNode_ = std::make_shared<MockCopysetNode>();
+    EXPECT_CALL(*copysetNodeManager_, GetCopysetNode(_, _))
+                .Times(1).WillOnce(Return(copysetNode_));
+    EXPECT_CALL(*copysetNode_, SetScan(false)).Times(1);
+    EXPECT_CALL(*copysetNode_, GetFailedScanMap())
+                .Times(1).WillOnce(ReturnRef(failedMap));
+    scanManager.CancelScanJob(1, 10000);
+    ASSERT_EQ(0, scanManager.GetJobNum());
+    ASSERT_FALSE(lfs->FileExists(path));
+
+    ::system(("rm -rf " + dir).c_str());
+}
+
 }  // namespace chunkserver
 }  // namespace curve
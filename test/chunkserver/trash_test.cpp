@@ -66,7 +66,6 @@ class TrashTest : public ::testing::Test {
         EXPECT_CALL(*lfs, List("./runlog/trash_test0/trash", _))
             .WillOnce(Return(0));
         trash->Init(ops);
-        ASSERT_EQ(0, trash->GetChunkNum());
     }
 
  public:
@@ -760,5 +759,135 @@ TEST_F(TrashTest, test_chunk_num_statistic) {
     ASSERT_EQ(7, trash->GetChunkNum());
 }
 
+TEST_F(TrashTest, recycle_in_batches_concurrently) {
+    std::string trashPath = "./runlog/trash_test0/trash";
+    std::string copysetDir = trashPath + "/4294967493.55555";
+    ops.recycleThreads = 4;
+    ops.recycleBatchSize = 3;
+    ops.scanPeriodSec = 3600;
+    // 限速只有1个文件每秒，低于水位时不受限速影响
+    ops.maxRecyclePerSec = 1;
+    ops.poolLowWaterMark = 100;
+    trash = std::make_shared<Trash>();
+    EXPECT_CALL(*lfs, List(trashPath, _)).WillOnce(Return(0));
+    ASSERT_EQ(0, trash->Init(ops));
+    ASSERT_EQ(0, trash->Run());
+
+    std::vector<std::string> copysets{"4294967493.55555"};
+    std::vector<std::string> dirs{"data", "log"};
+    std::vector<std::string> chunks;
+    for (int i = 1; i <= 10; i++) {
+        chunks.push_back("chunk_" + std::to_string(i));
+    }
+    std::vector<std::string> logfiles{"curve_log_10086_10087"};
+    EXPECT_CALL(*lfs, DirExists(_)).WillRepeatedly(Return(false));
+    EXPECT_CALL(*lfs, DirExists(trashPath)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(copysetDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(copysetDir + "/data")).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(copysetDir + "/log")).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, List(trashPath, _))
+        .WillOnce(DoAll(SetArgPointee<1>(copysets), Return(0)));
+    EXPECT_CALL(*lfs, List(copysetDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(dirs), Return(0)));
+    EXPECT_CALL(*lfs, List(copysetDir + "/data", _))
+        .WillOnce(DoAll(SetArgPointee<1>(chunks), Return(0)));
+    EXPECT_CALL(*lfs, List(copysetDir + "/log", _))
+        .WillOnce(DoAll(SetArgPointee<1>(logfiles), Return(0)));
+    SetCopysetNeedDelete(copysetDir, true);
+
+    EXPECT_CALL(*pool, Size()).WillRepeatedly(Return(10));
+    EXPECT_CALL(*pool, RecycleFile(_)).Times(10).WillRepeatedly(Return(0));
+    EXPECT_CALL(*walPool, RecycleFile(copysetDir + "/log/" + logfiles[0]))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs, Delete(copysetDir)).WillOnce(Return(0));
+
+    trash->DeleteEligibleFileInTrash();
+    ASSERT_EQ(11, trash->GetRecycledNum());
+    ASSERT_EQ(0, trash->Fini());
+}
+
+TEST_F(TrashTest, recycle_chunk_on_capacity_tier) {
+    std::string trashPath = "./runlog/trash_test0/trash";
+    std::string copysetDir = trashPath + "/4294967493.55555";
+    std::string dataDir = copysetDir + "/data";
+    std::string capacityDir = "/capacity/4294967493.55555/data";
+    trash = std::make_shared<Trash>();
+    EXPECT_CALL(*lfs, List(trashPath, _)).WillOnce(Return(0));
+    ASSERT_EQ(0, trash->Init(ops));
+
+    // chunk_1和chunk_3是容量层上的chunk，chunk_3在容量层上的文件已经不存在
+    std::vector<std::string> copysets{"4294967493.55555"};
+    std::vector<std::string> dirs{"data"};
+    std::vector<std::string> chunks{"chunk_1", "chunk_2", "chunk_3"};
+    EXPECT_CALL(*lfs, DirExists(_)).WillRepeatedly(Return(false));
+    EXPECT_CALL(*lfs, DirExists(trashPath)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(copysetDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(dataDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, List(trashPath, _))
+        .WillOnce(DoAll(SetArgPointee<1>(copysets), Return(0)));
+    EXPECT_CALL(*lfs, List(copysetDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(dirs), Return(0)));
+    EXPECT_CALL(*lfs, List(dataDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(chunks), Return(0)));
+    SetCopysetNeedDelete(copysetDir, true);
+
+    EXPECT_CALL(*lfs, ReadLink(dataDir + "/chunk_1", _))
+        .WillOnce(DoAll(SetArgPointee<1>(capacityDir + "/chunk_1"),
+                        Return(0)));
+    EXPECT_CALL(*lfs, ReadLink(dataDir + "/chunk_2", _))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(*lfs, ReadLink(dataDir + "/chunk_3", _))
+        .WillOnce(DoAll(SetArgPointee<1>(capacityDir + "/chunk_3"),
+                        Return(0)));
+    // 容量层上的文件不回收到chunkfilepool
+    EXPECT_CALL(*pool, RecycleFile(dataDir + "/chunk_2"))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs, Delete(capacityDir + "/chunk_1")).WillOnce(Return(0));
+    EXPECT_CALL(*lfs, Delete(dataDir + "/chunk_1")).WillOnce(Return(0));
+    EXPECT_CALL(*lfs, Delete(capacityDir + "/chunk_3"))
+        .WillOnce(Return(-ENOENT));
+    EXPECT_CALL(*lfs, Delete(dataDir + "/chunk_3")).WillOnce(Return(0));
+    EXPECT_CALL(*lfs, Delete(copysetDir)).WillOnce(Return(0));
+
+    trash->DeleteEligibleFileInTrash();
+    ASSERT_EQ(3, trash->GetRecycledNum());
+}
+
+TEST_F(TrashTest, recycle_chunk_on_capacity_tier_fail) {
+    std::string trashPath = "./runlog/trash_test0/trash";
+    std::string copysetDir = trashPath + "/4294967493.55555";
+    std::string dataDir = copysetDir + "/data";
+    std::string capacityPath = "/capacity/4294967493.55555/data/chunk_1";
+    trash = std::make_shared<Trash>();
+    EXPECT_CALL(*lfs, List(trashPath, _)).WillOnce(Return(0));
+    ASSERT_EQ(0, trash->Init(ops));
+
+    std::vector<std::string> copysets{"4294967493.55555"};
+    std::vector<std::string> dirs{"data"};
+    std::vector<std::string> chunks{"chunk_1"};
+    EXPECT_CALL(*lfs, DirExists(_)).WillRepeatedly(Return(false));
+    EXPECT_CALL(*lfs, DirExists(trashPath)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(copysetDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, DirExists(dataDir)).WillOnce(Return(true));
+    EXPECT_CALL(*lfs, List(trashPath, _))
+        .WillOnce(DoAll(SetArgPointee<1>(copysets), Return(0)));
+    EXPECT_CALL(*lfs, List(copysetDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(dirs), Return(0)));
+    EXPECT_CALL(*lfs, List(dataDir, _))
+        .WillOnce(DoAll(SetArgPointee<1>(chunks), Return(0)));
+    SetCopysetNeedDelete(copysetDir, true);
+
+    // 容量层上的文件删除失败时保留链接，copyset目录也不删除
+    EXPECT_CALL(*lfs, ReadLink(dataDir + "/chunk_1", _))
+        .WillOnce(DoAll(SetArgPointee<1>(capacityPath), Return(0)));
+    EXPECT_CALL(*lfs, Delete(capacityPath)).WillOnce(Return(-EIO));
+    EXPECT_CALL(*lfs, Delete(dataDir + "/chunk_1")).Times(0);
+    EXPECT_CALL(*lfs, Delete(copysetDir)).Times(0);
+    EXPECT_CALL(*pool, RecycleFile(_)).Times(0);
+
+    trash->DeleteEligibleFileInTrash();
+    ASSERT_EQ(0, trash->GetRecycledNum());
+}
+
 }  // namespace chunkserver
 }  // namespace curve
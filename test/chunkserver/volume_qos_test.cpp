@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-12
+ */
+
+#include <bthread/bthread.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <unordered_map>
+
+#include "src/chunkserver/volume_qos.h"
+
+namespace curve {
+namespace chunkserver {
+
+TEST(VolumeQosSchedulerTest, disabled) {
+    VolumeQosScheduler scheduler;
+    VolumeQosOptions options;
+    ASSERT_EQ(0, scheduler.Init(options));
+    ASSERT_EQ(0, scheduler.Run());
+    int processed = 0;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(scheduler.Submit(1, 4096, [&]() { ++processed; }));
+    }
+    ASSERT_EQ(10, processed);
+    ASSERT_EQ(0, scheduler.GetQueuedNum());
+    ASSERT_EQ(0, scheduler.Fini());
+}
+
+TEST(VolumeQosSchedulerTest, invalid_options) {
+    VolumeQosScheduler scheduler;
+    VolumeQosOptions options;
+    options.enable = true;
+    options.maxInflight = 0;
+    ASSERT_EQ(-1, scheduler.Init(options));
+}
+
+TEST(VolumeQosSchedulerTest, share_by_weight_and_limit) {
+    VolumeQosScheduler scheduler;
+    VolumeQosOptions options;
+    options.enable = true;
+    options.maxInflight = 1;
+    options.maxQueueDepth = 500;
+    ASSERT_EQ(0, scheduler.Init(options));
+    ASSERT_EQ(0, scheduler.Run());
+
+    std::unordered_map<uint64_t, VolumeQosParams> params;
+    params[1].weight = 300;
+    params[2].weight = 100;
+    params[3].limit = 10;
+    scheduler.UpdateVolumeQos(params);
+
+    // the only slot is taken, the requests below are queued
+    ASSERT_TRUE(scheduler.Submit(4, 4096, []() {}));
+    std::atomic<int> processed[3];
+    for (auto& num : processed) {
+        num = 0;
+    }
+    for (int i = 0; i < 500; ++i) {
+        for (uint64_t volume = 1; volume <= 3; ++volume) {
+            ASSERT_TRUE(scheduler.Submit(volume, 4096, [&, volume]() {
+                ++processed[volume - 1];
+            }));
+        }
+    }
+    ASSERT_EQ(1500, scheduler.GetQueuedNum());
+    // the queue of a volume is full
+    ASSERT_FALSE(scheduler.Submit(1, 4096, []() {}));
+
+    // respond 200 requests one by one
+    for (int i = 0; i < 200; ++i) {
+        scheduler.OnComplete();
+        while (processed[0] + processed[1] + processed[2] < i + 1) {
+            ::usleep(100);
+        }
+    }
+    ASSERT_EQ(200, processed[0] + processed[1] + processed[2]);
+    // volume 1 gets 3 times the share of volume 2
+    ASSERT_NEAR(processed[0], 3 * processed[1], 10);
+    // volume 3 is limited to 10 iops
+    ASSERT_LE(processed[2], 10);
+
+    // the queued requests are processed when stopped
+    ASSERT_EQ(0, scheduler.Fini());
+    ASSERT_EQ(500, processed[0]);
+    ASSERT_EQ(500, processed[1]);
+    ASSERT_EQ(500, processed[2]);
+    ASSERT_EQ(0, scheduler.GetQueuedNum());
+}
+
+TEST(VolumeQosSchedulerTest, reservation_first) {
+    VolumeQosScheduler scheduler;
+    VolumeQosOptions options;
+    options.enable = true;
+    options.maxInflight = 1;
+    ASSERT_EQ(0, scheduler.Init(options));
+    ASSERT_EQ(0, scheduler.Run());
+
+    std::unordered_map<uint64_t, VolumeQosParams> params;
+    params[1].weight = 1000;
+    params[2].weight = 1;
+    params[2].reservation = 1000000;
+    scheduler.UpdateVolumeQos(params);
+
+    ASSERT_TRUE(scheduler.Submit(3, 4096, []() {}));
+    std::atomic<int> processed[2];
+    processed[0] = 0;
+    processed[1] = 0;
+    for (int i = 0; i < 100; ++i) {
+        for (uint64_t volume = 1; volume <= 2; ++volume) {
+            ASSERT_TRUE(scheduler.Submit(volume, 4096, [&, volume]() {
+                ++processed[volume - 1];
+            }));
+        }
+    }
+    for (int i = 0; i < 100; ++i) {
+        scheduler.OnComplete();
+        while (processed[0] + processed[1] < i + 1) {
+            ::usleep(100);
+        }
+    }
+    // volume 2 is served within its reservation despite its tiny weight
+    ASSERT_GE(processed[1], 40);
+    ASSERT_EQ(0, scheduler.Fini());
+}
+
+TEST(VolumeQosSchedulerTest, dispatch_in_bthread) {
+    VolumeQosScheduler scheduler;
+    VolumeQosOptions options;
+    options.enable = true;
+    options.maxInflight = 1;
+    ASSERT_EQ(0, scheduler.Init(options));
+    ASSERT_EQ(0, scheduler.Run());
+
+    ASSERT_TRUE(scheduler.Submit(1, 4096, []() {}));
+    std::atomic<bool> started(false);
+    std::atomic<bool> release(false);
+    std::atomic<bool> inBthread(false);
+    std::atomic<int> processed(0);
+    ASSERT_TRUE(scheduler.Submit(1, 4096, [&]() {
+        inBthread = bthread_self() != 0;
+        started = true;
+        while (!release) {
+            ::usleep(100);
+        }
+        ++processed;
+    }));
+    scheduler.OnComplete();
+    while (!started) {
+        ::usleep(100);
+    }
+    ASSERT_TRUE(inBthread);
+
+    // the dispatched request blocks, the next one is dispatched anyway
+    ASSERT_TRUE(scheduler.Submit(2, 4096, [&]() { ++processed; }));
+    ASSERT_EQ(1, scheduler.GetQueuedNum());
+    scheduler.OnComplete();
+    while (processed < 1) {
+        ::usleep(100);
+    }
+    release = true;
+    while (processed < 2) {
+        ::usleep(100);
+    }
+    ASSERT_EQ(0, scheduler.Fini());
+}
+
+}  // namespace chunkserver
+}  // namespace curve
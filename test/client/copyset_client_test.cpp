@@ -339,7 +339,7 @@ TEST_F(CopysetClientTest, normal_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(1)
             .WillOnce(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -371,7 +371,7 @@ TEST_F(CopysetClientTest, normal_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(1)
             .WillOnce(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -404,7 +404,7 @@ TEST_F(CopysetClientTest, normal_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(1)
             .WillOnce(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -1084,6 +1084,7 @@ TEST_F(CopysetClientTest, read_failed_test) {
     LogicPoolID logicPoolId = 1;
     CopysetID copysetId = 100001;
     ChunkID chunkId = 1;
+    uint64_t fileId = 1;
     uint64_t sn = 1;
     size_t len = 8;
     char buff1[8 + 1];
@@ -1132,7 +1133,7 @@ TEST_F(CopysetClientTest, read_failed_test) {
                                   Return(0)));
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(50)
             .WillRepeatedly(Invoke(ReadChunkFunc));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_NE(0, reqDone->GetErrorCode());
@@ -1178,7 +1179,7 @@ TEST_F(CopysetClientTest, read_failed_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(50)
             .WillRepeatedly(DoAll(SetArgPointee<2>(response),
                                   Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD,
@@ -1223,6 +1224,7 @@ TEST_F(CopysetClientTest, read_error_test) {
     LogicPoolID logicPoolId = 1;
     CopysetID copysetId = 100001;
     ChunkID chunkId = 1;
+    uint64_t fileId = 1;
     uint64_t sn = 1;
     size_t len = 8;
     char buff1[8 + 1];
@@ -1267,7 +1269,7 @@ TEST_F(CopysetClientTest, read_error_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(1)
             .WillOnce(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_INVALID_REQUEST,
@@ -1298,7 +1300,7 @@ TEST_F(CopysetClientTest, read_error_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(1)
             .WillOnce(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(0, reqDone->GetErrorCode());
@@ -1330,7 +1332,7 @@ TEST_F(CopysetClientTest, read_error_test) {
                                   Return(0)));
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(3)
             .WillRepeatedly(Invoke(ReadChunkFunc));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_NE(0, reqDone->GetErrorCode());
@@ -1370,7 +1372,7 @@ TEST_F(CopysetClientTest, read_error_test) {
                                   Return(0)));
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(3)
             .WillRepeatedly(Invoke(ReadChunkFunc));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_NE(0, reqDone->GetErrorCode());
@@ -1415,7 +1417,7 @@ TEST_F(CopysetClientTest, read_error_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<2>(response),
                                   Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD,
@@ -1451,7 +1453,7 @@ TEST_F(CopysetClientTest, read_error_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<2>(response),
                                   Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_FAILURE_UNKNOWN,
@@ -1489,7 +1491,7 @@ TEST_F(CopysetClientTest, read_error_test) {
                             Invoke(ReadChunkFunc)))
             .WillOnce(DoAll(SetArgPointee<2>(response2),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -1531,7 +1533,7 @@ TEST_F(CopysetClientTest, read_error_test) {
                             Invoke(ReadChunkFunc)))
             .WillOnce(DoAll(SetArgPointee<2>(response2),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -1573,7 +1575,7 @@ TEST_F(CopysetClientTest, read_error_test) {
                             Invoke(ReadChunkFunc)))
             .WillOnce(DoAll(SetArgPointee<2>(response2),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -1607,7 +1609,7 @@ TEST_F(CopysetClientTest, read_error_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_REDIRECTED,
@@ -1639,7 +1641,7 @@ TEST_F(CopysetClientTest, read_error_test) {
         EXPECT_CALL(mockChunkService, ReadChunk(_, _, _, _)).Times(3)
             .WillRepeatedly(DoAll(SetArgPointee<2>(response),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_COPYSET_NOTEXIST,
@@ -1682,7 +1684,7 @@ TEST_F(CopysetClientTest, read_error_test) {
                             Invoke(ReadChunkFunc)))
             .WillOnce(DoAll(SetArgPointee<2>(response2),
                             Invoke(ReadChunkFunc)));
-        copysetClient.ReadChunk(reqCtx->idinfo_, sn,
+        copysetClient.ReadChunk(reqCtx->idinfo_, fileId, sn,
                                 offset, len, {}, reqDone);
         cond.Wait();
         ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
@@ -132,6 +132,7 @@ TEST_F(RequestSenderTest, TestWriteChunkSourceInfo) {
         event.Wait();
         ASSERT_FALSE(chunkRequest.has_clonefilesource());
         ASSERT_FALSE(chunkRequest.has_clonefileoffset());
+        ASSERT_EQ(1, chunkRequest.fileid());
     }
 
     {
@@ -177,7 +178,8 @@ TEST_F(RequestSenderTest, TestReadChunkSourceInfo) {
         FakeChunkClosure closure(&event);
 
         sourceInfo.cloneFileSource.clear();
-        requestSender.ReadChunk(ChunkIDInfo(), 0, 0, 0, sourceInfo, &closure);
+        requestSender.ReadChunk(ChunkIDInfo(), 1, 0, 0, 0, sourceInfo,
+                                &closure);
 
         event.Wait();
         ASSERT_FALSE(chunkRequest.has_clonefilesource());
@@ -198,7 +200,8 @@ TEST_F(RequestSenderTest, TestReadChunkSourceInfo) {
         sourceInfo.cloneFileOffset = 0;
         sourceInfo.valid = true;
 
-        requestSender.ReadChunk(ChunkIDInfo(), 0, 0, 0, sourceInfo, &closure);
+        requestSender.ReadChunk(ChunkIDInfo(), 1, 0, 0, 0, sourceInfo,
+                                &closure);
 
         event.Wait();
         ASSERT_TRUE(chunkRequest.has_clonefilesource());
@@ -543,6 +543,28 @@ TEST_F(Ext4LocalFileSystemTest, FsyncTest) {
     ASSERT_EQ(lfs->Fsync(666), -errno);
 }
 
+TEST_F(Ext4LocalFileSystemTest, SymlinkRealTest) {
+    std::shared_ptr<PosixWrapper> pw = std::make_shared<PosixWrapper>();
+    lfs->SetPosixWrapper(pw);
+    int fd = lfs->Open("symlink_target", O_CREAT|O_RDWR);
+    ASSERT_LT(0, fd);
+    ASSERT_EQ(0, lfs->Close(fd));
+    ASSERT_EQ(0, lfs->Symlink("symlink_target", "symlink_link"));
+    // link already exists
+    ASSERT_EQ(-EEXIST, lfs->Symlink("symlink_target", "symlink_link"));
+    ASSERT_TRUE(lfs->FileExists("symlink_link"));
+
+    std::string target;
+    ASSERT_EQ(0, lfs->ReadLink("symlink_link", &target));
+    ASSERT_EQ("symlink_target", target);
+    // not a symlink
+    ASSERT_EQ(-EINVAL, lfs->ReadLink("symlink_target", &target));
+    ASSERT_EQ(-ENOENT, lfs->ReadLink("symlink_none", &target));
+
+    ASSERT_EQ(0, lfs->Delete("symlink_link"));
+    ASSERT_EQ(0, lfs->Delete("symlink_target"));
+}
+
 TEST_F(Ext4LocalFileSystemTest, ReadRealTest) {
     std::shared_ptr<PosixWrapper> pw = std::make_shared<PosixWrapper>();
     lfs->SetPosixWrapper(pw);
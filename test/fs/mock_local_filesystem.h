@@ -53,6 +53,8 @@ class MockLocalFileSystem : public LocalFileSystem {
     MOCK_METHOD4(Fallocate, int(int, int, uint64_t, int));
     MOCK_METHOD2(Fstat, int(int, struct stat*));
     MOCK_METHOD1(Fsync, int(int));
+    MOCK_METHOD2(Symlink, int(const string&, const string&));
+    MOCK_METHOD2(ReadLink, int(const string&, string*));
 };
 
 }  // namespace fs
@@ -51,6 +51,8 @@ class MockPosixWrapper : public PosixWrapper {
     MOCK_METHOD1(fsync, int(int));
     MOCK_METHOD2(statfs, int(const char*, struct statfs*));
     MOCK_METHOD1(uname, int(struct utsname *));
+    MOCK_METHOD2(symlink, int(const char*, const char*));
+    MOCK_METHOD3(readlink, ssize_t(const char*, char*, size_t));
 };
 
 }  // namespace fs
@@ -0,0 +1,418 @@
+/*
+ *  Copyright (c) 2023 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ * Created Date: 2023-06-26
+ */
+
+#include <limits.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "test/integration/chunkserver/datastore/datastore_integration_base.h"
+
+namespace curve {
+namespace chunkserver {
+
+const string baseDir = "./data_int_tier";    // NOLINT
+const string poolDir = "./chunkfilepool_int_tier";  // NOLINT
+const string poolMetaPath = "./chunkfilepool_int_tier.meta";  // NOLINT
+const string capacityDir = "./capacity_int_tier";  // NOLINT
+
+/**
+ * 快速层和容量层之间移动chunk的测试
+ * 每个移动步骤之间的crash通过构造对应的文件后重启datastore来模拟
+ */
+class TierTestSuit : public DatastoreIntegrationBase {
+ public:
+    TierTestSuit() {}
+    ~TierTestSuit() {}
+
+    void SetUp() override {
+        DatastoreIntegrationBase::SetUp();
+        tierOptions_.promoteHeat = 4;
+        tierOptions_.demoteIdleRounds = 2;
+        RestartDataStore();
+    }
+
+    void TearDown() override {
+        DatastoreIntegrationBase::TearDown();
+        lfs_->Delete(capacityDir);
+    }
+
+    // 重新创建datastore，相当于chunkserver重启
+    void RestartDataStore() {
+        DataStoreOptions options;
+        options.baseDir = baseDir;
+        options.chunkSize = CHUNK_SIZE;
+        options.metaPageSize = PAGE_SIZE;
+        options.blockSize = BLOCK_SIZE;
+        options.capacityDir = capacityDir;
+        dataStore_ = std::make_shared<CSDataStore>(lfs_, filePool_, options);
+        ASSERT_TRUE(dataStore_->Initialize());
+    }
+
+    string ChunkPath(ChunkID id) {
+        return baseDir + "/" + FileNameOperator::GenerateChunkFileName(id);
+    }
+
+    // 和datastore一样使用绝对路径，symlink的目标才能正确解析
+    string CapacityPath(ChunkID id) {
+        char cwd[PATH_MAX];
+        if (getcwd(cwd, sizeof(cwd)) == nullptr) {
+            return "";
+        }
+        return string(cwd) + "/" + capacityDir + "/" +
+               FileNameOperator::GenerateChunkFileName(id);
+    }
+
+    string TierTempPath(ChunkID id) {
+        return baseDir + "/" + FileNameOperator::GenerateTierTempName(id);
+    }
+
+    bool IsLinkToCapacity(const string& path, ChunkID id) {
+        string target;
+        return lfs_->ReadLink(path, &target) == 0 &&
+               target == CapacityPath(id) && lfs_->FileExists(target);
+    }
+
+    void WriteChunk(ChunkID id, char ch, off_t offset = 0) {
+        char buf[PAGE_SIZE];
+        memset(buf, ch, sizeof(buf));
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore_->WriteChunk(id, 1, buf, offset, PAGE_SIZE,
+                                         nullptr));
+    }
+
+    void CheckChunk(ChunkID id, char ch, off_t offset = 0) {
+        char buf[PAGE_SIZE];
+        char expect[PAGE_SIZE];
+        memset(expect, ch, sizeof(expect));
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore_->ReadChunk(id, 1, buf, offset, PAGE_SIZE));
+        ASSERT_EQ(0, memcmp(expect, buf, PAGE_SIZE));
+    }
+
+    CSChunkFilePtr GetChunkFile(ChunkID id) {
+        ChunkMap chunks = dataStore_->GetChunkMap();
+        auto iter = chunks.find(id);
+        return iter == chunks.end() ? nullptr : iter->second;
+    }
+
+    // 把chunk移动到容量层，chunk需要空闲demoteIdleRounds个周期
+    void DemoteChunk(ChunkID id) {
+        CSChunkFilePtr chunk = GetChunkFile(id);
+        ASSERT_NE(nullptr, chunk);
+        ASSERT_EQ(CSErrorCode::Success, chunk->Demote(CapacityPath(id)));
+        ASSERT_TRUE(IsLinkToCapacity(ChunkPath(id), id));
+    }
+
+    void CopyFile(const string& src, const string& dst) {
+        std::ifstream in(src, std::ios::binary);
+        std::ofstream out(dst, std::ios::binary | std::ios::trunc);
+        out << in.rdbuf();
+        ASSERT_TRUE(out.good());
+    }
+
+ protected:
+    ChunkTierOptions tierOptions_;
+};
+
+/**
+ * 长时间未访问的chunk移动到容量层，变热之后移回快速层
+ */
+TEST_F(TierTestSuit, DemoteAndPromote) {
+    WriteChunk(1, 'a');
+    WriteChunk(2, 'b');
+    size_t poolSize = filePool_->Size();
+
+    // 第一个周期两个chunk都被访问过
+    ASSERT_EQ(0, dataStore_->MigrateChunks(tierOptions_, 10));
+    // chunk2一直被访问，chunk1空闲两个周期后被移到容量层
+    CheckChunk(2, 'b');
+    ASSERT_EQ(0, dataStore_->MigrateChunks(tierOptions_, 10));
+    CheckChunk(2, 'b');
+    ASSERT_EQ(1, dataStore_->MigrateChunks(tierOptions_, 10));
+    ASSERT_TRUE(IsLinkToCapacity(ChunkPath(1), 1));
+    ASSERT_FALSE(lfs_->FileExists(TierTempPath(1)));
+    string target;
+    ASSERT_NE(0, lfs_->ReadLink(ChunkPath(2), &target));
+    ASSERT_EQ(poolSize + 1, filePool_->Size());
+    ASSERT_EQ(1, dataStore_->GetStatus().capacityChunkCount);
+
+    // 容量层上的chunk可以正常读写
+    CheckChunk(1, 'a');
+    WriteChunk(1, 'c', PAGE_SIZE);
+    CheckChunk(1, 'c', PAGE_SIZE);
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->GetChunkInfo(1, &info));
+    ASSERT_EQ(1, info.curSn);
+
+    // 访问次数达到promoteHeat之后移回快速层
+    CheckChunk(1, 'a');
+    CheckChunk(1, 'a');
+    ASSERT_EQ(1, dataStore_->MigrateChunks(tierOptions_, 10));
+    ASSERT_NE(0, lfs_->ReadLink(ChunkPath(1), &target));
+    ASSERT_TRUE(lfs_->FileExists(ChunkPath(1)));
+    ASSERT_FALSE(lfs_->FileExists(CapacityPath(1)));
+    ASSERT_FALSE(lfs_->FileExists(TierTempPath(1)));
+    ASSERT_EQ(poolSize, filePool_->Size());
+    ASSERT_EQ(0, dataStore_->GetStatus().capacityChunkCount);
+    CheckChunk(1, 'a');
+    CheckChunk(1, 'c', PAGE_SIZE);
+}
+
+/**
+ * 每个周期移动的chunk数不超过maxMigrations，所有chunk的热度都会衰减
+ */
+TEST_F(TierTestSuit, MaxMigrations) {
+    WriteChunk(1, 'a');
+    WriteChunk(2, 'b');
+    WriteChunk(3, 'c');
+    ASSERT_EQ(0, dataStore_->MigrateChunks(tierOptions_, 1));
+    ASSERT_EQ(0, dataStore_->MigrateChunks(tierOptions_, 1));
+    ASSERT_EQ(1, dataStore_->MigrateChunks(tierOptions_, 1));
+    ASSERT_EQ(1, dataStore_->GetStatus().capacityChunkCount);
+    ASSERT_EQ(2, dataStore_->MigrateChunks(tierOptions_, 2));
+    ASSERT_EQ(3, dataStore_->GetStatus().capacityChunkCount);
+    for (ChunkID id = 1; id <= 3; ++id) {
+        ASSERT_TRUE(IsLinkToCapacity(ChunkPath(id), id));
+        CheckChunk(id, 'a' + id - 1);
+    }
+
+    // 暂停分层时不移动chunk
+    {
+        auto pause = dataStore_->PauseTiering();
+        for (int i = 0; i < 4; ++i) {
+            CheckChunk(1, 'a');
+        }
+        uint32_t migrated = 1;
+        std::thread scanner([&]() {
+            migrated = dataStore_->MigrateChunks(tierOptions_, 10);
+        });
+        scanner.join();
+        ASSERT_EQ(0, migrated);
+    }
+    ASSERT_EQ(1, dataStore_->MigrateChunks(tierOptions_, 10));
+    ASSERT_EQ(2, dataStore_->GetStatus().capacityChunkCount);
+}
+
+/**
+ * 重启后容量层上的chunk仍然可以读写和删除
+ */
+TEST_F(TierTestSuit, RestartAndDelete) {
+    WriteChunk(1, 'a');
+    DemoteChunk(1);
+    RestartDataStore();
+    ASSERT_EQ(1, dataStore_->GetStatus().capacityChunkCount);
+    CheckChunk(1, 'a');
+    WriteChunk(1, 'b');
+    CheckChunk(1, 'b');
+
+    size_t poolSize = filePool_->Size();
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->DeleteChunk(1, 1));
+    string target;
+    ASSERT_NE(0, lfs_->ReadLink(ChunkPath(1), &target));
+    ASSERT_FALSE(lfs_->FileExists(ChunkPath(1)));
+    ASSERT_FALSE(lfs_->FileExists(CapacityPath(1)));
+    ASSERT_EQ(poolSize, filePool_->Size());
+    ASSERT_EQ(0, dataStore_->GetStatus().capacityChunkCount);
+}
+
+/**
+ * chunk被删除之后不再移动，即使MigrateChunks拿到的是删除之前的chunk
+ */
+TEST_F(TierTestSuit, DeletedChunkNotMoved) {
+    WriteChunk(1, 'a');
+    CSChunkFilePtr chunk = GetChunkFile(1);
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->DeleteChunk(1, 1));
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError,
+              chunk->Demote(CapacityPath(1)));
+    ASSERT_FALSE(lfs_->FileExists(CapacityPath(1)));
+    ASSERT_FALSE(lfs_->FileExists(ChunkPath(1)));
+
+    WriteChunk(2, 'b');
+    DemoteChunk(2);
+    chunk = GetChunkFile(2);
+    ASSERT_EQ(CSErrorCode::Success, dataStore_->DeleteChunk(2, 1));
+    size_t poolSize = filePool_->Size();
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError, chunk->Promote());
+    ASSERT_FALSE(lfs_->FileExists(ChunkPath(2)));
+    ASSERT_FALSE(lfs_->FileExists(TierTempPath(2)));
+    ASSERT_EQ(poolSize, filePool_->Size());
+}
+
+/**
+ * 移动chunk时不持有锁拷贝数据，期间的写入在替换文件前再拷贝一次
+ */
+TEST_F(TierTestSuit, WriteWhileMoving) {
+    const int kBlocks = 64;
+    for (int i = 0; i < kBlocks; ++i) {
+        WriteChunk(1, 0, i * PAGE_SIZE);
+    }
+    CSChunkFilePtr chunk = GetChunkFile(1);
+    std::atomic<bool> stop(false);
+    std::vector<char> expect(kBlocks, 0);
+    std::thread writer([&]() {
+        char value = 0;
+        while (!stop.load()) {
+            ++value;
+            for (int i = 0; i < kBlocks; ++i) {
+                WriteChunk(1, value, i * PAGE_SIZE);
+                expect[i] = value;
+            }
+        }
+    });
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(CSErrorCode::Success, chunk->Demote(CapacityPath(1)));
+        ASSERT_TRUE(IsLinkToCapacity(ChunkPath(1), 1));
+        ASSERT_EQ(CSErrorCode::Success, chunk->Promote());
+        ASSERT_FALSE(lfs_->FileExists(CapacityPath(1)));
+    }
+    ASSERT_EQ(CSErrorCode::Success, chunk->Demote(CapacityPath(1)));
+    stop.store(true);
+    writer.join();
+    for (int i = 0; i < kBlocks; ++i) {
+        CheckChunk(1, expect[i], i * PAGE_SIZE);
+    }
+    // 重启后读到的是容量层上的数据
+    RestartDataStore();
+    for (int i = 0; i < kBlocks; ++i) {
+        CheckChunk(1, expect[i], i * PAGE_SIZE);
+    }
+}
+
+/**
+ * Demote在拷贝到容量层的临时文件之后crash
+ * 预期：临时文件作为孤儿文件被删除，chunk仍在快速层
+ */
+TEST_F(TierTestSuit, DemoteCrashAfterCopy) {
+    WriteChunk(1, 'a');
+    CopyFile(ChunkPath(1), CapacityPath(1) + kTierTempSuffix);
+    RestartDataStore();
+    ASSERT_FALSE(lfs_->FileExists(CapacityPath(1) + kTierTempSuffix));
+    ASSERT_TRUE(lfs_->FileExists(ChunkPath(1)));
+    CheckChunk(1, 'a');
+    ASSERT_EQ(0, dataStore_->GetStatus().capacityChunkCount);
+}
+
+/**
+ * Demote在拷贝重命名之后、创建symlink之前crash
+ * 预期：容量层的文件作为孤儿文件被删除，chunk仍在快速层
+ */
+TEST_F(TierTestSuit, DemoteCrashBeforeSymlink) {
+    WriteChunk(1, 'a');
+    CopyFile(ChunkPath(1), CapacityPath(1));
+    RestartDataStore();
+    ASSERT_FALSE(lfs_->FileExists(CapacityPath(1)));
+    string target;
+    ASSERT_NE(0, lfs_->ReadLink(ChunkPath(1), &target));
+    CheckChunk(1, 'a');
+}
+
+/**
+ * Demote在创建symlink之后、回收chunk文件之前crash
+ * 预期：symlink替换chunk文件，chunk文件被回收到chunk file pool
+ */
+TEST_F(TierTestSuit, DemoteCrashBeforeRecycle) {
+    WriteChunk(1, 'a');
+    dataStore_ = nullptr;
+    CopyFile(ChunkPath(1), CapacityPath(1));
+    ASSERT_EQ(0, lfs_->Symlink(CapacityPath(1), TierTempPath(1)));
+    size_t poolSize = filePool_->Size();
+    RestartDataStore();
+    ASSERT_TRUE(IsLinkToCapacity(ChunkPath(1), 1));
+    ASSERT_FALSE(lfs_->FileExists(TierTempPath(1)));
+    ASSERT_EQ(poolSize + 1, filePool_->Size());
+    ASSERT_EQ(1, dataStore_->GetStatus().capacityChunkCount);
+    CheckChunk(1, 'a');
+}
+
+/**
+ * Demote在回收chunk文件之后、symlink重命名之前crash
+ * 预期：symlink重命名为chunk文件
+ */
+TEST_F(TierTestSuit, DemoteCrashBeforeRenameLink) {
+    WriteChunk(1, 'a');
+    dataStore_ = nullptr;
+    CopyFile(ChunkPath(1), CapacityPath(1));
+    ASSERT_EQ(0, lfs_->Symlink(CapacityPath(1), TierTempPath(1)));
+    ASSERT_EQ(0, filePool_->RecycleFile(ChunkPath(1)));
+    RestartDataStore();
+    ASSERT_TRUE(IsLinkToCapacity(ChunkPath(1), 1));
+    ASSERT_FALSE(lfs_->FileExists(TierTempPath(1)));
+    CheckChunk(1, 'a');
+}
+
+/**
+ * symlink指向的容量层文件不存在
+ * 预期：删除symlink，chunk仍在快速层
+ */
+TEST_F(TierTestSuit, DemoteCopyLost) {
+    WriteChunk(1, 'a');
+    dataStore_ = nullptr;
+    ASSERT_EQ(0, lfs_->Symlink(CapacityPath(1), TierTempPath(1)));
+    RestartDataStore();
+    string target;
+    ASSERT_NE(0, lfs_->ReadLink(TierTempPath(1), &target));
+    ASSERT_NE(0, lfs_->ReadLink(ChunkPath(1), &target));
+    CheckChunk(1, 'a');
+}
+
+/**
+ * Promote在拷贝到chunk file pool的文件之后、替换symlink之前crash
+ * 预期：临时文件被回收，chunk仍在容量层
+ */
+TEST_F(TierTestSuit, PromoteCrashBeforeRename) {
+    WriteChunk(1, 'a');
+    DemoteChunk(1);
+    size_t poolSize = filePool_->Size();
+    char metaPage[PAGE_SIZE] = {0};
+    ASSERT_EQ(0, filePool_->GetFile(TierTempPath(1), metaPage));
+    RestartDataStore();
+    ASSERT_FALSE(lfs_->FileExists(TierTempPath(1)));
+    ASSERT_EQ(poolSize, filePool_->Size());
+    ASSERT_TRUE(IsLinkToCapacity(ChunkPath(1), 1));
+    CheckChunk(1, 'a');
+}
+
+/**
+ * Promote在替换symlink之后、删除容量层文件之前crash
+ * 预期：容量层文件作为孤儿文件被删除
+ */
+TEST_F(TierTestSuit, PromoteCrashBeforeDeleteCopy) {
+    WriteChunk(1, 'a');
+    DemoteChunk(1);
+    dataStore_ = nullptr;
+    char metaPage[PAGE_SIZE] = {0};
+    ASSERT_EQ(0, filePool_->GetFile(TierTempPath(1), metaPage));
+    CopyFile(CapacityPath(1), TierTempPath(1));
+    ASSERT_EQ(0, lfs_->Rename(TierTempPath(1), ChunkPath(1)));
+    RestartDataStore();
+    ASSERT_FALSE(lfs_->FileExists(CapacityPath(1)));
+    string target;
+    ASSERT_NE(0, lfs_->ReadLink(ChunkPath(1), &target));
+    ASSERT_EQ(0, dataStore_->GetStatus().capacityChunkCount);
+    CheckChunk(1, 'a');
+}
+
+}  // namespace chunkserver
+}  // namespace curve